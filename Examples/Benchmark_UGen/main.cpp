@@ -0,0 +1,717 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../UGen/UGen.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+	#include <x86intrin.h>
+	#define BENCHMARK_HAS_TSC 1
+#elif defined(_MSC_VER)
+	#include <intrin.h>
+	#define BENCHMARK_HAS_TSC 1
+#endif
+
+/**
+ A headless benchmark suite for the UGen engine.
+ 
+ This needs no audio device: each benchmark renders through a HeadlessHost which drives 
+ UGen::prepareAndProcessBlock() with a simulated clock. The micro benchmarks time single UGen
+ kernels, the macro benchmarks time a whole patch and search for the maximum number of voices 
+ which fit in the real-time budget. Each result is the median of several runs after a warm up 
+ and the random generator is reseeded for each run so the results are reproducible.
+ 
+ Build by compiling this file with the UGen++ sources (or linking a UGen++ library), e.g.,
+ with UGEN_CONVOLUTION defined to include the PartConvolve benchmarks.
+ 
+ Usage: benchmark [--quick] [--block size] [--budget load] [--csv results.csv] 
+				  [--baseline previous.csv] [--threshold percent] [--filter name]
+ 
+ With --baseline the results are compared with a previous --csv file and the exit code is
+ 1 if any benchmark is slower by more than the threshold (default 10%).
+ */
+
+#define SAMPLERATE		44100.0
+#define MAXRESULTS		64
+
+struct BenchmarkSettings
+{
+	int blockSize;
+	double seconds;
+	double warmUpSeconds;
+	int numRuns;
+	double budget;
+	const char* csvPath;
+	const char* baselinePath;
+	double threshold;
+	const char* filter;
+};
+
+struct BenchmarkResult
+{
+	char name[64];
+	double nsPerSample;
+	double cyclesPerSample;
+	double load;
+	int maxVoices;
+};
+
+static BenchmarkSettings settings;
+static BenchmarkResult results[MAXRESULTS];
+static int numResults = 0;
+
+typedef UGen (*GraphFunction)(const int size);
+
+static inline double readCycleCounter()
+{
+#ifdef BENCHMARK_HAS_TSC
+	return (double)__rdtsc();
+#else
+	return 0.0;
+#endif
+}
+
+static int compareDoubles(const void* a, const void* b)
+{
+	const double da = *(const double*)a;
+	const double db = *(const double*)b;
+	return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+static double median(double* values, const int numValues)
+{
+	qsort(values, numValues, sizeof(double), compareDoubles);
+	return values[numValues / 2];
+}
+
+/** Render a graph several times and fill in the median timings. */
+static void measure(GraphFunction function, const int size, BenchmarkResult& result)
+{
+	double ns[16], cycles[16], load[16];
+	const int numRuns = settings.numRuns < 16 ? settings.numRuns : 16;
+	
+	for(int run = 0; run < numRuns; run++)
+	{
+#ifndef UGEN_NOEXTGPL
+		Ran088::defaultGenerator().setSeed(0x5EED + run);
+		Ran088::setInstanceSeed(0x5EED + run);
+#endif
+		HeadlessHost host(0, 1, SAMPLERATE, settings.blockSize, 64, false);
+		host.setOutput(function(size));
+		
+		host.processSeconds(settings.warmUpSeconds);
+		host.resetStatistics();
+		
+		const double startCycles = readCycleCounter();
+		host.processSeconds(settings.seconds);
+		const double endCycles = readCycleCounter();
+		
+		const double numSamples = settings.seconds * SAMPLERATE;
+		ns[run] = host.getNanosecondsPerSample();
+		cycles[run] = (endCycles - startCycles) / numSamples;
+		load[run] = host.getLoad();
+	}
+	
+	result.nsPerSample = median(ns, numRuns);
+	result.cyclesPerSample = median(cycles, numRuns);
+	result.load = median(load, numRuns);
+}
+
+static bool shouldRun(const char* name)
+{
+	return settings.filter == 0 || strstr(name, settings.filter) != 0;
+}
+
+static BenchmarkResult* addResult(const char* name)
+{
+	if(numResults >= MAXRESULTS) 
+		return 0;
+	
+	BenchmarkResult& result = results[numResults++];
+	memset(&result, 0, sizeof(BenchmarkResult));
+	snprintf(result.name, sizeof(result.name), "%s", name);
+	result.maxVoices = -1;
+	return &result;
+}
+
+static void printResult(BenchmarkResult const& result)
+{
+	printf("%-28s %12.2f", result.name, result.nsPerSample);
+	
+#ifdef BENCHMARK_HAS_TSC
+	printf(" %14.1f", result.cyclesPerSample);
+#else
+	printf(" %14s", "n/a");
+#endif
+	
+	printf(" %9.2f%%", result.load * 100.0);
+	
+	if(result.maxVoices >= 0)
+		printf(" %10d", result.maxVoices);
+	
+	printf("\n");
+	fflush(stdout);
+}
+
+static void runMicro(const char* name, GraphFunction function, const int size = 1)
+{
+	if(!shouldRun(name)) return;
+	
+	BenchmarkResult* result = addResult(name);
+	if(result == 0) return;
+	
+	measure(function, size, *result);
+	printResult(*result);
+}
+
+// -- micro benchmark kernels --------------------------------------------------
+
+static UGen noise(const int)		{ return WhiteNoise::AR(0.1f); }
+static UGen sinOsc(const int)		{ return SinOsc::AR(440, 0, 0.1f); }
+static UGen sinOscFM(const int)		{ return SinOsc::AR(SinOsc::AR(3, 0, 50, 440), 0, 0.1f); }
+static UGen lfSaw(const int)		{ return LFSaw::AR(440, 0, 0.1f); }
+static UGen lpf(const int)			{ return LPF::AR(WhiteNoise::AR(), 1000); }
+static UGen lpfModulated(const int)	{ return LPF::AR(WhiteNoise::AR(), SinOsc::AR(1, 0, 500, 1000)); }
+static UGen hpf(const int)			{ return HPF::AR(WhiteNoise::AR(), 1000); }
+static UGen bLowPass(const int)		{ return BLowPass::AR(WhiteNoise::AR(), SinOsc::AR(1, 0, 500, 1000), 0.5); }
+static UGen sos(const int)			{ return SOS::AR(WhiteNoise::AR(), 0.2, 0.4, 0.2, 0.5, -0.3); }
+static UGen bankValues(const int size, const float start, const float step)
+{
+	UGenArray values;
+	
+	for(int i = 0; i < size; i++)
+		values.add(UGen(start + i * step));
+	
+	return UGen(values);
+}
+
+// multichannel filters use SOSBankBaseUGenInternal
+static UGen sosBank(const int size)		{ return Mix::AR(SOS::AR(WhiteNoise::AR(0.01f), 0.2, 0.4, 0.2, bankValues(size, 0.5f, 0.001f), -0.3)); }
+static UGen bPeakEQBank(const int size)	{ return Mix::AR(BPeakEQ::AR(WhiteNoise::AR(0.01f), bankValues(size, 100.f, 50.f), 1, 6)); }
+static UGen bLowPass4Bank(const int size)	{ return Mix::AR(BLowPass4::AR(WhiteNoise::AR(0.01f), bankValues(size, 100.f, 50.f), 0.5)); }
+static UGen lpfBank(const int size)		{ return Mix::AR(LPF::AR(WhiteNoise::AR(0.01f), SinOsc::AR(bankValues(size, 0.5f, 0.01f), 0, 500, 1000))); }
+
+// many sources panned separately and summed, or into one HOA bus
+static UGen panBSources(const int size)
+{
+	UGenArray panners;
+	
+	for(int i = 0; i < size; i++)
+		panners.add(PanB::AR(SinOsc::AR(440 + i, 0, 0.01f), i * 0.1f, 0.2f));
+	
+	return Mix::AR(Mix::AR(panners));
+}
+
+static UGen hoaSources(const int size, const int order)
+{
+	UGenArray inputs;
+	
+	for(int i = 0; i < size; i++)
+		inputs.add(SinOsc::AR(440 + i, 0, 0.01f));
+	
+	return HOAEncode::AR(UGen(inputs), bankValues(size, 0.f, 0.1f), 0.2f, order);
+}
+
+static UGen hoaEncode1(const int size)	{ return Mix::AR(hoaSources(size, 1)); }
+static UGen hoaEncode3(const int size)	{ return Mix::AR(hoaSources(size, 3)); }
+static UGen hoaEncode5(const int size)	{ return Mix::AR(hoaSources(size, 5)); }
+static UGen hoaRotate5(const int size)	{ return Mix::AR(HOARotate::AR(hoaSources(size, 5), SinOsc::AR(0.1, 0, 3), 0.3f, SinOsc::AR(0.07))); }
+
+// speakers evenly spread over the sphere (a Fibonacci spiral)
+static void speakerLayout(const int size, FloatArray& azimuths, FloatArray& elevations)
+{
+	for(int i = 0; i < size; i++)
+	{
+		azimuths.add(i * 2.39996323f);
+		elevations.add(ugen::asin(1.f - (2.f * i + 1.f) / size));
+	}
+}
+
+static UGen decodeB(const int size)
+{
+	FloatArray azimuths, elevations;
+	speakerLayout(size, azimuths, elevations);
+	return Mix::AR(DecodeB::AR(PanB::AR(SinOsc::AR(440, 0, 0.1f), SinOsc::AR(0.1, 0, 3)), azimuths, elevations));
+}
+
+static UGen hoaDecode5(const int size)
+{
+	FloatArray azimuths, elevations;
+	speakerLayout(size, azimuths, elevations);
+	return Mix::AR(HOADecode::AR(HOAEncode::AR(SinOsc::AR(440, 0, 0.1f), SinOsc::AR(0.1, 0, 3), 0, 5), azimuths, elevations));
+}
+
+static UGen fdnReverb(const int size)			{ return Mix::AR(FDNReverb::AR(WhiteNoise::AR(0.1f), 2.0, 0.3, 1.0, size)); }
+static UGen allpassChain(const int size)		{ return RecircBaseChain<AllpassN>::AR(WhiteNoise::AR(0.1f), size, 0.1f, 0.05f, 2.0f); }
+
+static UGen neuralNetworkMap(const int size)
+{
+	// size is the number of nodes on each of the two hidden layers
+	int structure[] = { 8, size, size, 2 };
+	NeuralNetwork network(IntArray::withArray(4, structure), 0.25f, 0.01f);
+	
+	UGenArray inputs;
+	for(int i = 0; i < 8; i++)
+		inputs <<= SinOsc::AR(100 + 37 * i);
+	
+	return Mix::AR(NeuralNetworkMap::AR(UGen(inputs), network));
+}
+
+static UGen delayN(const int)		{ return DelayN::AR(WhiteNoise::AR(), 0.5, 0.25); }
+static UGen delayL(const int)		{ return DelayL::AR(WhiteNoise::AR(), 0.5, SinOsc::AR(0.5, 0, 0.1, 0.2)); }
+static UGen combL(const int)		{ return CombL::AR(WhiteNoise::AR(0.1f), 0.1, 0.037, 2.0); }
+
+static UGen delayTaps(const int size)
+{
+	// constant (fractional) tap times reading one line
+	UGenArray delayTimes;
+	for(int i = 0; i < size; i++)
+		delayTimes <<= UGen(0.0123f * (i + 1));
+	
+	return Mix::AR(DelayL::AR(WhiteNoise::AR(), 0.5, UGen(delayTimes)));
+}
+
+static UGen mix(const int size)
+{
+	UGenArray oscillators;
+	
+	for(int i = 0; i < size; i++)
+		oscillators.add(SinOsc::AR(100 + i * 37, 0, 0.01f));
+	
+	return Mix::AR(oscillators);
+}
+
+class BenchmarkSpawnEvent : public SpawnEventBase<>
+{
+public:
+	UGen spawnEvent(SpawnUGenInternal& /*spawn*/, const int eventCount)
+	{
+		return SinOsc::AR(200 + (eventCount % 32) * 25, 0, Linen::AR(0.01f, 0.05f, 0.01f, 0.05f, UGen::DeleteWhenDone));
+	}
+};
+
+static UGen spawn(const int)		{ return Spawn<BenchmarkSpawnEvent>::AR(1, 0.005); }
+
+/** A few seconds of a harmonic signal at a different rate to SAMPLERATE for the resampling benchmarks. */
+static Buffer resampleSource(const int numChannels = 1)
+{
+	static Buffer source;
+	
+	if(source.getNumChannels() != numChannels)
+	{
+		source = Buffer::newClear(48000 * 4, numChannels, false);
+		
+		for(int channel = 0; channel < numChannels; channel++)
+		{
+			float* samples = source.getData(channel);
+			
+			for(int i = 0; i < source.size(); i++)
+				samples[i] = 0.2f * (float)(sin(i * 0.05) + sin(i * 0.37 + channel) + sin(i * 1.9));
+		}
+	}
+	
+	return source;
+}
+
+static UGen playBuf(const int)		{ return PlayBuf::AR(resampleSource(), SinOsc::AR(0.2, 0, 0.5, 1.25), 0, 0, 1); }
+static UGen varRate(const int)		{ return VarRate::AR(resampleSource(), SinOsc::AR(0.2, 0, 0.5, 1.25), 1, 48000); }
+
+#ifdef UGEN_CONVOLUTION
+static UGen partConvolve(const int size)
+{
+	Buffer impulse = Buffer::newClear(size, 1, false);
+	float* samples = impulse.getData(0);
+	
+	for(int i = 0; i < size; i++)
+		samples[i] = (float)(i & 7) / (8.f * (i + 1));
+	
+	return PartConvolve::AR(WhiteNoise::AR(0.1f), impulse);
+}
+#endif
+
+static void runFFT(const int fftSize)
+{
+	char name[64];
+	snprintf(name, sizeof(name), "FFTEngine %d", fftSize);
+	
+	if(!shouldRun(name)) return;
+	
+	BenchmarkResult* result = addResult(name);
+	if(result == 0) return;
+	
+	const int numIterations = (int)(settings.seconds * SAMPLERATE / fftSize) + 1;
+	double ns[16];
+	const int numRuns = settings.numRuns < 16 ? settings.numRuns : 16;
+	
+	FFTEngine::benchmark(FFTEngine::DefaultBackend, fftSize, numIterations); // warm up
+	
+	for(int run = 0; run < numRuns; run++)
+		ns[run] = FFTEngine::benchmark(FFTEngine::DefaultBackend, fftSize, numIterations) * 1000.0 / fftSize;
+	
+	// an FFT/IFFT pair per fftSize samples
+	result->nsPerSample = median(ns, numRuns);
+	result->load = result->nsPerSample * 1.0e-9 * SAMPLERATE;
+	result->cyclesPerSample = 0.0;
+	
+#ifdef BENCHMARK_HAS_TSC
+	// estimate cycles from the counter rate
+	const double startCycles = readCycleCounter();
+	const double startTime = UGenThread::getMillisecondCounterHiRes();
+	UGenThread::sleep(50);
+	const double cyclesPerNs = (readCycleCounter() - startCycles) / ((UGenThread::getMillisecondCounterHiRes() - startTime) * 1.0e6);
+	result->cyclesPerSample = result->nsPerSample * cyclesPerNs;
+#endif
+	
+	printResult(*result);
+}
+
+/** Time the conversion of a Buffer from 48kHz to SAMPLERATE, quality -1 uses Buffer::resample(). */
+static void runResample(const char* name, const int quality)
+{
+	if(!shouldRun(name)) return;
+	
+	BenchmarkResult* result = addResult(name);
+	if(result == 0) return;
+	
+	Buffer source = resampleSource(2);
+	const int newSize = (int)(source.size() * (SAMPLERATE / 48000.0));
+	double ns[16], cycles[16];
+	const int numRuns = settings.numRuns < 16 ? settings.numRuns : 16;
+	
+	for(int run = 0; run < numRuns; run++)
+	{
+		const double startTime = UGenThread::getMillisecondCounterHiRes();
+		const double startCycles = readCycleCounter();
+		
+		Buffer converted = quality < 0 ? source.resample(newSize) 
+									   : Resampler::process(source, 48000.0, SAMPLERATE, (Resampler::Quality)quality);
+		
+		const double endCycles = readCycleCounter();
+		const double numSamples = (double)converted.size() * converted.getNumChannels();
+		ns[run] = (UGenThread::getMillisecondCounterHiRes() - startTime) * 1.0e6 / numSamples;
+		cycles[run] = (endCycles - startCycles) / numSamples;
+	}
+	
+	// per output sample per channel, the load is for converting in real time
+	result->nsPerSample = median(ns, numRuns);
+	result->cyclesPerSample = median(cycles, numRuns);
+	result->load = result->nsPerSample * 1.0e-9 * SAMPLERATE;
+	
+	printResult(*result);
+}
+
+#ifndef UGEN_NOEXTGPL
+/** Time filling blocks with random floats from -1 to +1, one Ran088 call per sample or using a Ran088Block. */
+static void runRandom(const char* name, const bool useBlock)
+{
+	if(!shouldRun(name)) return;
+	
+	BenchmarkResult* result = addResult(name);
+	if(result == 0) return;
+	
+	const int numBlocks = (int)(settings.seconds * SAMPLERATE / settings.blockSize) + 1;
+	float* const block = new float[settings.blockSize];
+	double ns[16], cycles[16];
+	const int numRuns = settings.numRuns < 16 ? settings.numRuns : 16;
+	static volatile float sink; // so the blocks aren't optimised away
+	
+	for(int run = 0; run < numRuns; run++)
+	{
+		Ran088 random(0x5EED + run);
+		Ran088Block randomBlock(0x5EED + run);
+		
+		const double startTime = UGenThread::getMillisecondCounterHiRes();
+		const double startCycles = readCycleCounter();
+		
+		for(int i = 0; i < numBlocks; i++)
+		{
+			if(useBlock)
+			{
+				randomBlock.nextBiFloat(block, settings.blockSize);
+			}
+			else
+			{
+				unsigned int s1, s2, s3;
+				random.get(s1, s2, s3);
+				
+				for(int j = 0; j < settings.blockSize; j++)
+					block[j] = Ran088::nextBiFloat(s1, s2, s3);
+				
+				random.set(s1, s2, s3);
+			}
+			
+			sink = block[i % settings.blockSize];
+		}
+		
+		const double endCycles = readCycleCounter();
+		const double numSamples = (double)numBlocks * settings.blockSize;
+		ns[run] = (UGenThread::getMillisecondCounterHiRes() - startTime) * 1.0e6 / numSamples;
+		cycles[run] = (endCycles - startCycles) / numSamples;
+	}
+	
+	delete [] block;
+	(void)sink;
+	
+	// per sample, the load is for one noise source in real time
+	result->nsPerSample = median(ns, numRuns);
+	result->cyclesPerSample = median(cycles, numRuns);
+	result->load = result->nsPerSample * 1.0e-9 * SAMPLERATE;
+	
+	printResult(*result);
+}
+#endif
+
+// -- macro benchmarks ---------------------------------------------------------
+
+static UGen voice(const int index)
+{
+	const float freq = 55.f * powf(2.f, (float)(index % 36) / 12.f);
+	UGen oscillators = LFSaw::AR(U(freq, freq * 1.005f, freq * 0.995f), 0, 0.3f);
+	UGen cutoff = SinOsc::AR(0.2f + (index % 7) * 0.05f, 0, 600, 1200);
+	UGen filtered = BLowPass::AR(Mix::AR(oscillators), cutoff, 0.5);
+	UGen amplitude = SinOsc::AR(2.f + (index % 5) * 0.3f, 0, 0.5f, 0.5f);
+	return filtered * amplitude * 0.05f;
+}
+
+static UGen synthPatch(const int numVoices)
+{
+	UGenArray voices;
+	
+	for(int i = 0; i < numVoices; i++)
+		voices.add(voice(i));
+	
+	UGen dry = Mix::AR(voices);
+	UGen wet = CombL::AR(dry, 0.1, 0.037, 1.5) + CombL::AR(dry, 0.1, 0.041, 1.5);
+	return LeakDC::AR(dry + wet * 0.3f);
+}
+
+static UGen noisePatch(const int numVoices)
+{
+	UGenArray voices;
+	
+	for(int i = 0; i < numVoices; i++)
+		voices.add(HPF::AR(LPF::AR(WhiteNoise::AR(0.01f), 2000 + i * 10), 200) * SinOsc::AR(0.5f + i * 0.01f));
+	
+	return Mix::AR(voices);
+}
+
+/** Find the largest number of voices whose average load is within the budget. */
+static int findMaxVoices(GraphFunction function)
+{
+	BenchmarkResult probe;
+	int low = 0;
+	int high = 1;
+	
+	while(high <= 4096)
+	{
+		measure(function, high, probe);
+		
+		if(probe.load > settings.budget)
+			break;
+		
+		low = high;
+		high *= 2;
+	}
+	
+	if(high > 4096) 
+		return low;
+	
+	while(high - low > 1 && (high - low) * 32 > low)
+	{
+		const int middle = (low + high) / 2;
+		measure(function, middle, probe);
+		
+		if(probe.load > settings.budget)
+			high = middle;
+		else
+			low = middle;
+	}
+	
+	return low;
+}
+
+static void runMacro(const char* name, GraphFunction function, const int numVoices)
+{
+	if(!shouldRun(name)) return;
+	
+	BenchmarkResult* result = addResult(name);
+	if(result == 0) return;
+	
+	measure(function, numVoices, *result);
+	result->nsPerSample /= numVoices;
+	result->cyclesPerSample /= numVoices;
+	result->maxVoices = findMaxVoices(function);
+	printResult(*result);
+}
+
+// -- results ------------------------------------------------------------------
+
+static void writeCSV(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	
+	if(file == 0)
+	{
+		printf("could not write %s\n", path);
+		return;
+	}
+	
+	fprintf(file, "name,ns_per_sample,cycles_per_sample,load,max_voices\n");
+	
+	for(int i = 0; i < numResults; i++)
+	{
+		fprintf(file, "%s,%.4f,%.4f,%.6f,%d\n", 
+				results[i].name, results[i].nsPerSample, results[i].cyclesPerSample, 
+				results[i].load, results[i].maxVoices);
+	}
+	
+	fclose(file);
+}
+
+/** Compare the ns/sample with a previous CSV file, returns the number of regressions. */
+static int compareWithBaseline(const char* path)
+{
+	FILE* file = fopen(path, "r");
+	
+	if(file == 0)
+	{
+		printf("could not read %s\n", path);
+		return 0;
+	}
+	
+	int numRegressions = 0;
+	char line[256];
+	
+	printf("\n%-28s %12s %12s %9s\n", "compared with baseline", "baseline", "now", "change");
+	
+	while(fgets(line, sizeof(line), file) != 0)
+	{
+		char* comma = strchr(line, ',');
+		if(comma == 0) continue;
+		
+		*comma = 0;
+		const double baseline = atof(comma + 1);
+		if(baseline <= 0.0) continue;
+		
+		for(int i = 0; i < numResults; i++)
+		{
+			if(strcmp(results[i].name, line) == 0)
+			{
+				const double change = (results[i].nsPerSample - baseline) / baseline * 100.0;
+				const bool isRegression = change > settings.threshold;
+				
+				printf("%-28s %12.2f %12.2f %+8.1f%%%s\n", line, baseline, results[i].nsPerSample, change, 
+					   isRegression ? "  REGRESSION" : "");
+				
+				if(isRegression) 
+					numRegressions++;
+			}
+		}
+	}
+	
+	fclose(file);
+	return numRegressions;
+}
+
+int main (int argc, char * const argv[]) 
+{
+	settings.blockSize = 256;
+	settings.seconds = 2.0;
+	settings.warmUpSeconds = 0.25;
+	settings.numRuns = 5;
+	settings.budget = 0.5;
+	settings.csvPath = 0;
+	settings.baselinePath = 0;
+	settings.threshold = 10.0;
+	settings.filter = 0;
+	
+	for(int i = 1; i < argc; i++)
+	{
+		const bool hasValue = i + 1 < argc;
+		
+		if(strcmp(argv[i], "--quick") == 0)							{ settings.seconds = 0.25; settings.numRuns = 3;	}
+		else if(strcmp(argv[i], "--block") == 0 && hasValue)		settings.blockSize = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--budget") == 0 && hasValue)		settings.budget = atof(argv[++i]);
+		else if(strcmp(argv[i], "--csv") == 0 && hasValue)			settings.csvPath = argv[++i];
+		else if(strcmp(argv[i], "--baseline") == 0 && hasValue)		settings.baselinePath = argv[++i];
+		else if(strcmp(argv[i], "--threshold") == 0 && hasValue)	settings.threshold = atof(argv[++i]);
+		else if(strcmp(argv[i], "--filter") == 0 && hasValue)		settings.filter = argv[++i];
+		else
+		{
+			printf("usage: %s [--quick] [--block size] [--budget load] [--csv file] [--baseline file] [--threshold percent] [--filter name]\n", argv[0]);
+			return 2;
+		}
+	}
+	
+	if(settings.blockSize < 1) settings.blockSize = 256;
+	
+	UGen::initialise();
+	UGen::prepareToPlay(SAMPLERATE, settings.blockSize, 64);
+	
+	printf("UGen++ benchmark: %.0fHz, block size %d, %d runs of %.2fs, budget %.0f%%\n", 
+		   SAMPLERATE, settings.blockSize, settings.numRuns, settings.seconds, settings.budget * 100.0);
+	printf("%-28s %12s %14s %10s %10s\n", "benchmark", "ns/sample", "cycles/sample", "load", "max voices");
+	
+	runMicro("WhiteNoise", noise);
+	runMicro("SinOsc", sinOsc);
+	runMicro("SinOsc FM", sinOscFM);
+	runMicro("LFSaw", lfSaw);
+	runMicro("LPF", lpf);
+	runMicro("LPF modulated", lpfModulated);
+	runMicro("HPF", hpf);
+	runMicro("BLowPass modulated", bLowPass);
+	runMicro("SOS", sos);
+	runMicro("SOS 64 channels", sosBank, 64);
+	runMicro("BPeakEQ 64 channels", bPeakEQBank, 64);
+	runMicro("BLowPass4 64 channels", bLowPass4Bank, 64);
+	runMicro("LPF modulated 64 channels", lpfBank, 64);
+	runMicro("PanB 256 sources", panBSources, 256);
+	runMicro("HOAEncode 256 sources order 1", hoaEncode1, 256);
+	runMicro("HOAEncode 256 sources order 3", hoaEncode3, 256);
+	runMicro("HOAEncode 256 sources order 5", hoaEncode5, 256);
+	runMicro("HOARotate order 5", hoaRotate5, 1);
+	runMicro("DecodeB 32 speakers", decodeB, 32);
+	runMicro("HOADecode order 5 32 speakers", hoaDecode5, 32);
+	runMicro("HOADecode order 5 64 speakers", hoaDecode5, 64);
+	runMicro("AllpassN chain 16", allpassChain, 16);
+	runMicro("FDNReverb 16 lines", fdnReverb, 16);
+	runMicro("FDNReverb 64 lines", fdnReverb, 64);
+	runMicro("NeuralNetworkMap 8-32-32-2", neuralNetworkMap, 32);
+	runMicro("DelayN", delayN);
+	runMicro("DelayL modulated", delayL);
+	runMicro("CombL", combL);
+	runMicro("DelayL 16 taps", delayTaps, 16);
+	runMicro("Mix 16", mix, 16);
+	runMicro("Mix 128", mix, 128);
+	runMicro("Spawn", spawn);
+#ifdef UGEN_CONVOLUTION
+	runMicro("PartConvolve 4096", partConvolve, 4096);
+	runMicro("PartConvolve 65536", partConvolve, 65536);
+#endif
+	runFFT(512);
+	runFFT(4096);
+	runMicro("PlayBuf", playBuf);
+	runMicro("VarRate", varRate);
+	runResample("resample linear", -1);
+	runResample("Resampler Low", Resampler::Low);
+	runResample("Resampler Medium", Resampler::Medium);
+	runResample("Resampler High", Resampler::High);
+#ifndef UGEN_NOEXTGPL
+	runRandom("Ran088 scalar", false);
+	runRandom("Ran088Block", true);
+#endif
+	
+	runMacro("patch synth (per voice)", synthPatch, 16);
+	runMacro("patch noise (per voice)", noisePatch, 16);
+	
+	int numRegressions = 0;
+	
+	if(settings.csvPath != 0)
+		writeCSV(settings.csvPath);
+	
+	if(settings.baselinePath != 0)
+		numRegressions = compareWithBaseline(settings.baselinePath);
+	
+	UGen::shutdown();
+	
+	return numRegressions > 0 ? 1 : 0;
+}
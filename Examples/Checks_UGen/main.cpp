@@ -0,0 +1,1439 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../../UGen/UGen.h"
+
+/**
+ Headless correctness checks for the UGen engine.
+
+ Like the benchmark this needs no audio device. Each check prints its name and either "ok"
+ or what went wrong and the exit code is 1 if any check fails, so this can run as a test
+ after each build (e.g., "ctest" with the CMake build).
+
+ Usage: checks [--filter name]
+ */
+
+#define SAMPLERATE		44100.0
+
+static const char* filter = 0;
+static int numChecks = 0;
+static int numFailures = 0;
+
+static bool shouldRun(const char* name)
+{
+	return filter == 0 || strstr(name, filter) != 0;
+}
+
+static void report(const char* name, const char* failure)
+{
+	numChecks++;
+	
+	if(failure == 0)
+	{
+		printf("%-48s ok\n", name);
+	}
+	else
+	{
+		numFailures++;
+		printf("%-48s FAILED: %s\n", name, failure);
+	}
+	
+	fflush(stdout);
+}
+
+// a fixed sequence so the inputs are the same for every instruction set and every run
+static unsigned int checkSeed = 1;
+
+static float nextFloat(const float low, const float high)
+{
+	checkSeed = checkSeed * 1664525U + 1013904223U;
+	return low + (high - low) * (float)(checkSeed >> 8) / (float)(1U << 24);
+}
+
+static void fill(float* samples, const unsigned int numSamples, const float low, const float high)
+{
+	for(unsigned int i = 0; i < numSamples; i++)
+		samples[i] = nextFloat(low, high);
+}
+
+static bool sameBits(const float* a, const float* b, const unsigned int numSamples)
+{
+	return memcmp(a, b, numSamples * sizeof(float)) == 0;
+}
+
+// -- SIMD kernels -------------------------------------------------------------
+
+#ifdef UGEN_SIMD
+
+#define MAXKERNELSIZE	1031	// not a multiple of any vector width so the scalar tails run too
+#define NUMLANES		8		// a multiple of every vector width for biquadLanes
+
+/** Compare every kernel for one instruction set with the scalar kernels.
+ Apart from the dot product (which sums in a different order) the results must be bit identical. */
+static const char* compareKernels(SIMD::Kernels const& scalar, SIMD::Kernels const& simd)
+{
+	static float left[MAXKERNELSIZE], right[MAXKERNELSIZE], third[MAXKERNELSIZE];
+	static float expected[MAXKERNELSIZE], actual[MAXKERNELSIZE];
+	static float expected2[MAXKERNELSIZE], actual2[MAXKERNELSIZE];
+	static const unsigned int sizes[] = { 0, 1, 3, 4, 7, 8, 9, 15, 17, 31, 33, 64, 65, 255, 1031 };
+	static const int numSizes = sizeof(sizes) / sizeof(sizes[0]);
+	
+	fill(left, MAXKERNELSIZE, -1.f, 1.f);
+	fill(right, MAXKERNELSIZE, 0.25f, 2.f);	// no zeros for divide
+	fill(third, MAXKERNELSIZE, -1.f, 1.f);
+	
+	for(int s = 0; s < numSizes; s++)
+	{
+		const unsigned int n = sizes[s];
+
+#define CHECK_UNARY(NAME, INPUT)												\
+		scalar.NAME(INPUT, expected, n);										\
+		simd.NAME(INPUT, actual, n);											\
+		if(!sameBits(expected, actual, n)) return #NAME;
+
+#define CHECK_BINARY(NAME)														\
+		scalar.NAME(left, right, expected, n);									\
+		simd.NAME(left, right, actual, n);										\
+		if(!sameBits(expected, actual, n)) return #NAME;
+		
+		scalar.splat(0.5f, expected, n);
+		simd.splat(0.5f, actual, n);
+		if(!sameBits(expected, actual, n)) return "splat";
+		
+		scalar.clear(expected, n);
+		simd.clear(actual, n);
+		if(!sameBits(expected, actual, n)) return "clear";
+		
+		CHECK_UNARY(copy, left);
+		CHECK_UNARY(neg, left);
+		CHECK_UNARY(abs, left);
+		CHECK_UNARY(reciprocal, right);
+		CHECK_UNARY(squared, left);
+		CHECK_UNARY(cubed, left);
+		CHECK_UNARY(sqrt, right);
+		
+		CHECK_BINARY(add);
+		CHECK_BINARY(subtract);
+		CHECK_BINARY(multiply);
+		CHECK_BINARY(divide);
+
+#undef CHECK_UNARY
+#undef CHECK_BINARY
+
+		memcpy(expected, third, n * sizeof(float));
+		memcpy(actual, third, n * sizeof(float));
+		scalar.accumulate(left, expected, n);
+		simd.accumulate(left, actual, n);
+		if(!sameBits(expected, actual, n)) return "accumulate";
+		
+		const float* mixInputs[3] = { left, right, third };
+		
+		for(int shouldAccumulate = 0; shouldAccumulate < 2; shouldAccumulate++)
+		{
+			memcpy(expected, third, n * sizeof(float));
+			memcpy(actual, third, n * sizeof(float));
+			scalar.mix(mixInputs, 3, expected, n, shouldAccumulate);
+			simd.mix(mixInputs, 3, actual, n, shouldAccumulate);
+			if(!sameBits(expected, actual, n)) return "mix";
+		}
+		
+		memcpy(expected, third, n * sizeof(float));
+		memcpy(actual, third, n * sizeof(float));
+		memset(expected2, 0, n * sizeof(float));
+		memset(actual2, 0, n * sizeof(float));
+		
+		for(int i = 0; i < 4; i++)
+		{
+			scalar.accumulateCompensated(left, expected, expected2, n);
+			simd.accumulateCompensated(left, actual, actual2, n);
+		}
+		
+		if(!sameBits(expected, actual, n) || !sameBits(expected2, actual2, n)) return "accumulateCompensated";
+		
+		scalar.multiplyAdd(left, right, third, expected, n);
+		simd.multiplyAdd(left, right, third, actual, n);
+		if(!sameBits(expected, actual, n)) return "multiplyAdd";
+		
+		memcpy(expected, third, n * sizeof(float));
+		memcpy(actual, third, n * sizeof(float));
+		memcpy(expected2, right, n * sizeof(float));
+		memcpy(actual2, right, n * sizeof(float));
+		scalar.complexMultiplyAccumulate(left, right, third, left, expected, expected2, n);
+		simd.complexMultiplyAccumulate(left, right, third, left, actual, actual2, n);
+		if(!sameBits(expected, actual, n) || !sameBits(expected2, actual2, n)) return "complexMultiplyAccumulate";
+		
+		const float expectedDot = scalar.dotProduct(left, right, n);
+		const float actualDot = simd.dotProduct(left, right, n);
+		if(fabs(expectedDot - actualDot) > 1.0e-5f * (1.f + (float)n)) return "dotProduct";
+		
+		unsigned int expectedState[12], actualState[12];
+		unsigned int expectedValues[MAXKERNELSIZE], actualValues[MAXKERNELSIZE];
+		
+		for(int i = 0; i < 12; i++)
+			expectedState[i] = actualState[i] = 0x12345678U * (i + 1) + 0x1000U;
+		
+		scalar.ran088(expectedState, expectedValues, n);
+		simd.ran088(actualState, actualValues, n);
+		if(memcmp(expectedValues, actualValues, n * sizeof(unsigned int)) != 0 ||
+		   memcmp(expectedState, actualState, sizeof(expectedState)) != 0) return "ran088";
+		
+		scalar.ran088Float(expectedState, 0x3F800000U, 1.f, expected, n);
+		simd.ran088Float(actualState, 0x3F800000U, 1.f, actual, n);
+		if(!sameBits(expected, actual, n) || memcmp(expectedState, actualState, sizeof(expectedState)) != 0) return "ran088Float";
+	}
+	
+	// biquadLanes with fixed, per frame and ramped coefficients
+	const unsigned int numFrames = 37;
+	float expectedCoeffs[NUMLANES * 5 * numFrames], actualCoeffs[NUMLANES * 5 * numFrames];
+	float slopes[NUMLANES * 5];
+	float expectedState[NUMLANES * 2], actualState[NUMLANES * 2];
+	
+	for(int mode = 0; mode < 3; mode++)
+	{
+		for(unsigned int i = 0; i < NUMLANES * 5 * numFrames; i++)
+			expectedCoeffs[i] = actualCoeffs[i] = nextFloat(-0.25f, 0.25f);
+		
+		fill(slopes, NUMLANES * 5, -0.001f, 0.001f);
+		fill(expectedState, NUMLANES * 2, -0.1f, 0.1f);
+		memcpy(actualState, expectedState, sizeof(expectedState));
+		memcpy(expected, left, NUMLANES * numFrames * sizeof(float));
+		memcpy(actual, left, NUMLANES * numFrames * sizeof(float));
+		
+		const float* modeSlopes = mode == 2 ? slopes : 0;
+		const unsigned int stride = mode == 1 ? NUMLANES * 5 : 0;
+		scalar.biquadLanes(expected, numFrames, NUMLANES, expectedCoeffs, modeSlopes, stride, expectedState);
+		simd.biquadLanes(actual, numFrames, NUMLANES, actualCoeffs, modeSlopes, stride, actualState);
+		
+		if(!sameBits(expected, actual, NUMLANES * numFrames) ||
+		   !sameBits(expectedState, actualState, NUMLANES * 2) ||
+		   !sameBits(expectedCoeffs, actualCoeffs, NUMLANES * 5 * numFrames)) return "biquadLanes";
+	}
+	
+	// matrixMix with 3 inputs to 2 outputs, with and without ramps
+	const unsigned int numSamples = 203;
+	float gains[6], mixSlopes[6];
+	fill(gains, 6, -1.f, 1.f);
+	fill(mixSlopes, 6, -0.001f, 0.001f);
+	const float* matrixInputs[3] = { left, right, third };
+	
+	for(int mode = 0; mode < 4; mode++)
+	{
+		const int shouldAccumulate = mode & 1;
+		const float* modeSlopes = (mode & 2) ? mixSlopes : 0;
+		float* expectedOutputs[2] = { expected, expected2 };
+		float* actualOutputs[2] = { actual, actual2 };
+		
+		memcpy(expected, third, numSamples * sizeof(float));
+		memcpy(actual, third, numSamples * sizeof(float));
+		memcpy(expected2, left, numSamples * sizeof(float));
+		memcpy(actual2, left, numSamples * sizeof(float));
+		scalar.matrixMix(matrixInputs, 3, expectedOutputs, 2, gains, modeSlopes, numSamples, shouldAccumulate);
+		simd.matrixMix(matrixInputs, 3, actualOutputs, 2, gains, modeSlopes, numSamples, shouldAccumulate);
+		
+		if(!sameBits(expected, actual, numSamples) || !sameBits(expected2, actual2, numSamples)) return "matrixMix";
+	}
+	
+	return 0;
+}
+
+static void checkSIMDKernels()
+{
+	const SIMD::Kernels* scalar = SIMD::getKernels(SIMD::Scalar);
+	
+	for(int i = SIMD::Scalar + 1; i < SIMD::NumInstructionSets; i++)
+	{
+		const SIMD::InstructionSet instructionSet = (SIMD::InstructionSet)i;
+		char name[64];
+		snprintf(name, sizeof(name), "SIMD %s kernels match scalar", SIMD::getInstructionSetName(instructionSet));
+		
+		if(!shouldRun(name) || !SIMD::isSupported(instructionSet))
+			continue;
+		
+		report(name, compareKernels(*scalar, *SIMD::getKernels(instructionSet)));
+	}
+}
+
+/** Render the same graph with each instruction set, the outputs must be identical. */
+static void checkSIMDRender()
+{
+	const char* name = "SIMD graph output matches scalar";
+	if(!shouldRun(name)) return;
+	
+	const int blockSize = 67;
+	const double seconds = 0.05;
+	const SIMD::InstructionSet original = SIMD::getInstructionSet();
+	Buffer expected;
+	const char* failure = 0;
+	
+	for(int i = SIMD::Scalar; i < SIMD::NumInstructionSets && failure == 0; i++)
+	{
+		if(!SIMD::setInstructionSet((SIMD::InstructionSet)i))
+			continue;
+		
+		HeadlessHost host(0, 1, SAMPLERATE, blockSize, 64, false);
+		UGen sources = LFSaw::AR(U(110, 220, 330, 440), 0, U(0.1f, 0.2f, 0.3f, 0.4f));
+		host.setOutput(Mix::AR((sources * LFPulse::AR(3, 0, 0.5f) + 0.25f) * sources.squared()));
+		Buffer rendered = host.render(seconds);
+		
+		if(i == SIMD::Scalar)
+			expected = rendered;
+		else if(rendered.size() != expected.size() || 
+				!sameBits(expected.getDataReadOnly(0), rendered.getDataReadOnly(0), expected.size()))
+			failure = SIMD::getInstructionSetName((SIMD::InstructionSet)i);
+	}
+	
+	SIMD::setInstructionSet(original);
+	report(name, failure);
+}
+
+#endif // UGEN_SIMD
+
+// -- render drivers ------------------------------------------------------------
+
+#define NUMVOICES	8
+
+static UGen voices()
+{
+	UGenArray array;
+	
+	for(int i = 0; i < NUMVOICES; i++)
+		array.add(SinOsc::AR(200.f + i * 50.f, 0, 0.1f) * LFSaw::AR(1.f + i, 0, 0.5f, 0.5f) + LFPulse::AR(2.f + i, 0, 0.5f, 0.01f));
+	
+	return UGen(array);
+}
+
+/** Render a mix of voices with and without a UGenOutputArena. The output and the values of 
+ the voices must be the same and the arena must only plan once for a graph which doesn't change. */
+static void checkOutputArena()
+{
+	const char* name = "UGenOutputArena output and values";
+	if(!shouldRun(name)) return;
+	
+	const int blockSize = 64;
+	const int numBlocks = 50;
+	float expected[blockSize * numBlocks], actual[blockSize * numBlocks];
+	float expectedValues[NUMVOICES], actualValues[NUMVOICES];
+	const char* failure = 0;
+	
+	UGen::prepareToPlay(SAMPLERATE, blockSize, 64);
+	
+	for(int useArena = 0; useArena < 2; useArena++)
+	{
+		UGenOutputArena arena;
+		UGen graph = Mix::AR(voices());
+		float* output = useArena ? actual : expected;
+		
+		for(int block = 0; block < numBlocks; block++)
+		{
+			const int blockID = UGen::getNextBlockID(blockSize);
+			graph.setOutput(output + block * blockSize, blockSize, 0);
+			
+			if(useArena)
+				arena.prepareAndProcessBlock(graph, blockSize, blockID, -1);
+			else
+				graph.prepareAndProcessBlock(blockSize, blockID, -1);
+		}
+		
+		if(useArena && arena.getNumShared() == 0)
+			failure = "no UGenInternal objects shared the arena";
+		else if(useArena && arena.getNumPlans() != 1)
+			failure = "the graph was planned more than once";
+		
+		// the voices are read through the Mix so their reference counts don't change
+		UGenInternal* mix = graph.getInternalUGen(0);
+		float* values = useArena ? actualValues : expectedValues;
+		
+		for(int i = 0; i < NUMVOICES; i++)
+			values[i] = mix->getInput(0).getValue(i);
+		
+		mix->decrementRefCount();
+	}
+	
+	UGen::prepareToPlay(SAMPLERATE, 256, 64);
+	
+	if(failure == 0 && !sameBits(expected, actual, blockSize * numBlocks))
+		failure = "the output differs";
+	else if(failure == 0 && !sameBits(expectedValues, actualValues, NUMVOICES))
+		failure = "getValue() differs";
+	
+	report(name, failure);
+}
+
+/** Render a mix of voices with and without a ParallelRenderer (using a worker thread even 
+ with one CPU). The output must be the same, the voices must be split between tasks and the 
+ schedule must only be made once for a graph which doesn't change. */
+static void checkParallelRenderer()
+{
+	const char* name = "ParallelRenderer output and schedule";
+	if(!shouldRun(name)) return;
+	
+	const int blockSize = 64;
+	const int numBlocks = 50;
+	float expected[blockSize * numBlocks], actual[blockSize * numBlocks];
+	const char* failure = 0;
+	
+	UGen::prepareToPlay(SAMPLERATE, blockSize, 64);
+	
+	for(int useRenderer = 0; useRenderer < 2; useRenderer++)
+	{
+		ParallelRenderer renderer(2);
+		UGen graph = Mix::AR(voices());
+		float* output = useRenderer ? actual : expected;
+		
+		for(int block = 0; block < numBlocks; block++)
+		{
+			const int blockID = UGen::getNextBlockID(blockSize);
+			graph.setOutput(output + block * blockSize, blockSize, 0);
+			
+			// built and deleted away from the graph so the schedule should be kept
+			UGen unrelated = SinOsc::AR(100.f + block) * 0.5f;
+			(void)unrelated;
+			
+			if(useRenderer)
+				renderer.prepareAndProcessBlock(graph, blockSize, blockID, -1);
+			else
+				graph.prepareAndProcessBlock(blockSize, blockID, -1);
+		}
+		
+		if(useRenderer && renderer.getNumTasks() < NUMVOICES / 2)
+			failure = "the voices were not split between tasks";
+		else if(useRenderer && renderer.getNumSchedules() != 1)
+			failure = "the schedule was made more than once";
+	}
+	
+	UGen::prepareToPlay(SAMPLERATE, 256, 64);
+	
+	if(failure == 0 && !sameBits(expected, actual, blockSize * numBlocks))
+		failure = "the output differs";
+	
+	report(name, failure);
+}
+
+/** Two readers of a ParameterControl rendered in parallel get the same scheduled ramp. */
+static void checkParameterControlReaders()
+{
+	const char* name = "ParameterControl shared by parallel readers";
+	if(!shouldRun(name)) return;
+	
+	const int blockSize = 64;
+	const char* failure = 0;
+	ParameterControl control(0.f, 0.f, 1.f);
+	UGen graph = UGen(control.kr(0.0), control.kr(0.0));
+	ParallelRenderer renderer(2);
+	
+	control.scheduleValue(1.f, UGen::getCurrentBlockID() + blockSize + 10, 100);
+	
+	float left[blockSize], right[blockSize];
+	graph.setOutput(left, blockSize, 0);
+	graph.setOutput(right, blockSize, 1);
+	
+	for(int block = 0; block < 4 && failure == 0; block++)
+	{
+		renderer.prepareAndProcessBlock(graph, blockSize, UGen::getNextBlockID(blockSize), -1);
+		
+		if(!sameBits(left, right, blockSize))
+			failure = "the readers differ";
+	}
+	
+	if(failure == 0 && left[blockSize - 1] != 1.f)
+		failure = "the ramp didn't finish";
+	
+	report(name, failure);
+}
+
+/** A stereo graph whose channels share a Pan2 (one unit for the OfflineRenderer) or are
+ independent filters (two units), built the same way each time so copies render the same. */
+static UGen offlineGraph(const bool shared)
+{
+	if(shared)
+		return Pan2::AR(SinOsc::AR(220.f, 0.f, 0.2f), SinOsc::AR(0.5f)) + LFPulse::AR(UGen(40.f, 60.f), 0.f, 0.5f, 0.1f);
+	else
+		return LPF::AR(LFSaw::AR(UGen(110.f, 165.f), 0.f, 0.3f), SinOsc::AR(UGen(0.3f, 0.7f), 0.f, 400.f, 1200.f));
+}
+
+/** Jobs rendered by an OfflineRenderer (with a worker thread even with one CPU) must be the 
+ same as rendering each graph with Buffer::synthInPlace() in blocks of the same size, including 
+ a job which doesn't end on a block boundary and one starting at an offset. */
+static void checkOfflineRenderer()
+{
+	const char* name = "OfflineRenderer matches synthInPlace";
+	if(!shouldRun(name)) return;
+	
+	const int blockSize = UGen::getEstimatedBlockSize(); // the block size synthInPlace() uses
+	const int numJobs = 3;
+	const int sizes[numJobs] = { blockSize * 40, blockSize * 40 + 100, blockSize * 40 };
+	const int offsets[numJobs] = { 0, 0, 100 };
+	const char* failure = 0;
+	
+	OfflineRenderer renderer(2, blockSize);
+	Buffer expected[numJobs], actual[numJobs];
+	
+	for(int job = 0; job < numJobs; job++)
+	{
+		expected[job] = Buffer::withSize(sizes[job], 2, true);
+		actual[job] = Buffer::withSize(sizes[job], 2, true);
+		
+		expected[job].synthInPlace(offlineGraph(job != 1), offsets[job], sizes[job] - offsets[job], false);
+		renderer.addSynth(actual[job], offlineGraph(job != 1), offsets[job], sizes[job] - offsets[job]);
+	}
+	
+	if(renderer.render() == false)
+		failure = "render() was cancelled";
+	else if(renderer.getNumJobsFinished() != numJobs)
+		failure = "not all the jobs finished";
+	
+	for(int job = 0; job < numJobs && failure == 0; job++)
+	{
+		for(int channel = 0; channel < 2 && failure == 0; channel++)
+		{
+			if(!sameBits(expected[job].getDataReadOnly(channel), actual[job].getDataReadOnly(channel), sizes[job]))
+				failure = "the output differs";
+		}
+	}
+	
+	report(name, failure);
+}
+
+// -- mix -----------------------------------------------------------------------
+
+#define NUMMIXCHANNELS		19		// two full groups of MixUGenInternal::MaxGroupSize and part of another
+#define MAXMIXBLOCKSIZE		1000	// larger than the estimated block size and not a multiple of it
+
+/** The channels to mix, built the same way each time so separate copies render the same samples. */
+static UGen mixChannels(const int offset)
+{
+	UGen channels;
+	
+	for(int i = 0; i < NUMMIXCHANNELS; i++)
+		channels = (channels, SinOsc::AR(100.f + 37.f * (i + offset), 0.f, 0.1f + 0.01f * i));
+	
+	return channels;
+}
+
+/** An array of stereo items to mix with MixArrayUGenInternal. */
+static UGenArray mixArray()
+{
+	UGenArray array;
+	
+	for(int i = 0; i < NUMMIXCHANNELS; i++)
+		array.add(UGen(SinOsc::AR(100.f + 37.f * i, 0.f, 0.1f), LFSaw::AR(50.f + 11.f * i, 0.f, 0.05f)));
+	
+	return array;
+}
+
+/** Sum the sources one after the other (as Mix did before it summed in groups) optionally with 
+ Kahan summation, starting with a copy of the first source as Mix or with zero as MixArray. */
+static void mixInOrder(const float** sources, const int numSources, const int numSamples, 
+					   const bool compensate, const bool startWithFirst, float* sum)
+{
+	static float compensation[MAXMIXBLOCKSIZE];
+	int source = 0;
+	
+	if(startWithFirst)
+		memcpy(sum, sources[source++], numSamples * sizeof(float));
+	else
+		memset(sum, 0, numSamples * sizeof(float));
+	
+	memset(compensation, 0, numSamples * sizeof(float));
+	
+	for(/* leave source alone */; source < numSources; source++)
+	{
+		for(int i = 0; i < numSamples; i++)
+		{
+			if(compensate)
+			{
+				const float y = sources[source][i] - compensation[i];
+				const float t = sum[i] + y;
+				compensation[i] = (t - sum[i]) - y;
+				sum[i] = t;
+			}
+			else
+			{
+				sum[i] += sources[source][i];
+			}
+		}
+	}
+}
+
+/** Mix (with and without a UGenOutputArena) and MixArray sum in groups but must give the same 
+ output as adding their inputs one at a time, which is rendered from a separate copy of the inputs. 
+ With the arena the first input must have been rendered straight into the Mix output. */
+static void checkMixGroups()
+{
+	static const char* names[] = { "Mix groups match summing in order", 
+								   "Mix in place input matches summing in order", 
+								   "MixArray groups match summing in order" };
+	
+	const int blockSize = 256;
+	const int numBlocks = 10;
+	
+	for(int index = 0; index < 3; index++)
+	{
+		if(!shouldRun(names[index])) continue;
+		
+		const bool isArray = index == 2;
+		const char* failure = 0;
+		UGenOutputArena arena;
+		UGen graph = isArray ? Mix::AR(mixArray()) : Mix::AR(mixChannels(0));
+		UGenArray copy = isArray ? mixArray() : UGenArray(mixChannels(0));
+		bool isInPlace = false;
+		
+		for(int block = 0; block < numBlocks && failure == 0; block++)
+		{
+			const unsigned int blockID = UGen::getNextBlockID(blockSize);
+			bool shouldDelete = false;
+			float expected[blockSize];
+			const float* sources[NUMMIXCHANNELS];
+			
+			if(index == 1)
+				arena.prepareAndProcessBlock(graph, blockSize, blockID, -1);
+			else
+				graph.prepareAndProcessBlock(blockSize, blockID, -1);
+			
+			for(int i = 0; i < copy.size(); i++)
+				copy[i].prepareForBlock(blockSize, blockID, -1);
+			
+			for(int channel = 0; channel < graph.getNumChannels() && failure == 0; channel++)
+			{
+				for(int i = 0; i < NUMMIXCHANNELS; i++)
+					sources[i] = isArray ? copy[i].processBlock(shouldDelete, blockID, channel)
+										 : copy[0].processBlock(shouldDelete, blockID, i);
+				
+				mixInOrder(sources, NUMMIXCHANNELS, blockSize, false, isArray == false, expected);
+				
+				if(!sameBits(graph.processBlock(shouldDelete, blockID, channel), expected, blockSize))
+					failure = "the output differs";
+			}
+			
+			if((index == 1) && (block == numBlocks - 1))
+			{
+				// the input is read through the Mix so the reference counts the arena planned with don't change
+				UGenInternal* mix = graph.getInternalUGen(0);
+				UGen input = mix->getInput(0);
+				isInPlace = input.processBlock(shouldDelete, blockID, 0) == mix->getSampleData();
+				mix->decrementRefCount();
+			}
+		}
+		
+		if(failure == 0 && (index == 1) && (isInPlace == false))
+			failure = "the first input wasn't rendered in place";
+		
+		report(names[index], failure);
+	}
+}
+
+/** Compensated Mix and MixArray match Kahan summation in order with a block larger than the 
+ estimated block size (which the compensation is allocated for). */
+static void checkMixCompensated()
+{
+	const char* name = "Mix compensation with a large block";
+	if(!shouldRun(name)) return;
+	
+	const int numBlocks = 4;
+	const char* failure = 0;
+	UGen mix = Mix::AR(mixChannels(0), true, true);
+	UGen mixArrayGraph = Mix::AR(mixArray(), true, true, 0, true);
+	UGen channels = mixChannels(0);
+	UGenArray array = mixArray();
+	
+	for(int block = 0; block < numBlocks && failure == 0; block++)
+	{
+		const unsigned int blockID = UGen::getNextBlockID(MAXMIXBLOCKSIZE);
+		bool shouldDelete = false;
+		static float expected[MAXMIXBLOCKSIZE];
+		const float* sources[NUMMIXCHANNELS];
+		
+		const float* mixSamples = mix.prepareAndProcessBlock(MAXMIXBLOCKSIZE, blockID, 0);
+		mixArrayGraph.prepareAndProcessBlock(MAXMIXBLOCKSIZE, blockID, -1);
+		channels.prepareForBlock(MAXMIXBLOCKSIZE, blockID, -1);
+		
+		for(int i = 0; i < NUMMIXCHANNELS; i++)
+		{
+			array[i].prepareForBlock(MAXMIXBLOCKSIZE, blockID, -1);
+			sources[i] = channels.processBlock(shouldDelete, blockID, i);
+		}
+		
+		mixInOrder(sources, NUMMIXCHANNELS, MAXMIXBLOCKSIZE, true, true, expected);
+		
+		if(!sameBits(mixSamples, expected, MAXMIXBLOCKSIZE))
+			failure = "the Mix output differs";
+		
+		for(int channel = 0; channel < mixArrayGraph.getNumChannels() && failure == 0; channel++)
+		{
+			for(int i = 0; i < NUMMIXCHANNELS; i++)
+				sources[i] = array[i].processBlock(shouldDelete, blockID, channel);
+			
+			mixInOrder(sources, NUMMIXCHANNELS, MAXMIXBLOCKSIZE, true, false, expected);
+			
+			if(!sameBits(mixArrayGraph.processBlock(shouldDelete, blockID, channel), expected, MAXMIXBLOCKSIZE))
+				failure = "the MixArray output differs";
+		}
+	}
+	
+	report(name, failure);
+}
+
+// -- delays --------------------------------------------------------------------
+
+/** The taps of a multi-tap delay match separate single delays (which are written and read
+ sample by sample when the delay doesn't fit beside the block) including taps longer than 
+ the Buffer size less the block size, fractional taps and a modulated tap. */
+static void checkDelayTaps()
+{
+	static const char* names[] = { "DelayN taps match single delays", "DelayL taps match single delays" };
+	
+	const int blockSize = 256;
+	const int numBlocks = 20;
+	const int numTaps = 4;
+	const float maximumDelayTime = 0.01f; // a 512 sample Buffer
+	
+	for(int interpolate = 0; interpolate < 2; interpolate++)
+	{
+		if(!shouldRun(names[interpolate])) continue;
+		
+		const char* failure = 0;
+		UGen input = SinOsc::AR(331.f) + SinOsc::AR(1017.f, 0.f, 0.5f);
+		UGen delayTimes[numTaps] = { 
+			UGen(100.f / SAMPLERATE), 
+			UGen(400.f / SAMPLERATE), 
+			UGen(450.5f / SAMPLERATE), 
+			SinOsc::AR(3.f, 0.f, 150.f / SAMPLERATE, 300.f / SAMPLERATE) 
+		};
+		
+		// the taps are not concatenated with the single delays as that would copy the multi-tap owner
+		UGen taps;
+		UGen singles[numTaps];
+		
+		if(interpolate)
+		{
+			taps = DelayL::AR(input, maximumDelayTime, UGen(delayTimes[0], delayTimes[1], delayTimes[2], delayTimes[3]));
+			
+			for(int tap = 0; tap < numTaps; tap++)
+				singles[tap] = DelayL::AR(input, maximumDelayTime, delayTimes[tap]);
+		}
+		else
+		{
+			taps = DelayN::AR(input, maximumDelayTime, UGen(delayTimes[0], delayTimes[1], delayTimes[2], delayTimes[3]));
+			
+			for(int tap = 0; tap < numTaps; tap++)
+				singles[tap] = DelayN::AR(input, maximumDelayTime, delayTimes[tap]);
+		}
+		
+		for(int block = 0; block < numBlocks && failure == 0; block++)
+		{
+			const unsigned int blockID = UGen::getNextBlockID(blockSize);
+			bool shouldDelete = false;
+			
+			taps.prepareForBlock(blockSize, blockID, -1);
+			
+			for(int tap = 0; tap < numTaps; tap++)
+				singles[tap].prepareForBlock(blockSize, blockID, -1);
+			
+			for(int tap = 0; tap < numTaps && failure == 0; tap++)
+			{
+				const float* tapSamples = taps.processBlock(shouldDelete, blockID, tap);
+				const float* singleSamples = singles[tap].processBlock(shouldDelete, blockID, 0);
+				
+				if(!sameBits(tapSamples, singleSamples, blockSize))
+					failure = "a tap differs";
+			}
+		}
+		
+		report(names[interpolate], failure);
+	}
+}
+
+// -- filters -------------------------------------------------------------------
+
+#define NUMBANKCHANNELS		6	// enough for a bank, and not a multiple of the vector width so a tile is padded
+
+/** The value for one channel of a filter parameter, or all of them (channel < 0) for the bank. */
+static UGen bankValues(const float first, const float step, const int channel)
+{
+	if(channel >= 0)
+		return UGen(first + step * channel);
+	
+	UGen values;
+	
+	for(int i = 0; i < NUMBANKCHANNELS; i++)
+		values = (values, UGen(first + step * i));
+	
+	return values;
+}
+
+typedef UGen (*BankFilterFunction)(UGen const& input, const int channel);
+
+static UGen sosBankFilter(UGen const& input, const int channel)			{ return SOS::AR(input, 0.2f, 0.4f, 0.2f, bankValues(0.5f, 0.05f, channel), -0.3f); }
+static UGen bPeakEQBankFilter(UGen const& input, const int channel)		{ return BPeakEQ::AR(input, bankValues(200.f, 150.f, channel), 1.f, 6.f); }
+static UGen bLowPass4BankFilter(UGen const& input, const int channel)	{ return BLowPass4::AR(input, bankValues(300.f, 200.f, channel), 0.5f); }
+static UGen lpfBankFilter(UGen const& input, const int channel)			{ return LPF::AR(input, SinOsc::AR(bankValues(2.f, 0.5f, channel), 0.f, 500.f, 1000.f)); }
+static UGen hpfBankFilter(UGen const& input, const int channel)			{ return HPF::AR(input, bankValues(500.f, 100.f, channel)); }
+
+/** Each filter applied to a multichannel input (which uses a SOSBank when UGEN_SIMD is defined)
+ matches the same filter applied to each channel on its own (which always uses the original 
+ per-channel filter). SOS and BEQ with constant coefficients should be the same, LPF/HPF are 
+ calculated in the general biquad form in the bank so they round differently. */
+static void checkSOSBank()
+{
+	static const struct { const char* name; BankFilterFunction function; float tolerance; } filters[] = {
+		{ "SOS bank matches per-channel SOS",			sosBankFilter,			1.0e-6f },
+		{ "BPeakEQ bank matches per-channel BPeakEQ",	bPeakEQBankFilter,		1.0e-6f },
+		{ "BLowPass4 bank matches per-channel BLowPass4",	bLowPass4BankFilter,	1.0e-6f },
+		{ "LPF bank matches per-channel LPF",			lpfBankFilter,			1.0e-6f },
+		{ "HPF bank matches per-channel HPF",			hpfBankFilter,			1.0e-4f },
+	};
+	
+	const int blockSize = 256;
+	const int numBlocks = 20;
+	
+	for(int index = 0; index < numElementsInArray(filters); index++)
+	{
+		if(!shouldRun(filters[index].name)) continue;
+		
+		const char* failure = 0;
+		UGen channels[NUMBANKCHANNELS];
+		UGen input;
+		
+		for(int channel = 0; channel < NUMBANKCHANNELS; channel++)
+		{
+			channels[channel] = SinOsc::AR(97.f + 61.f * channel) + SinOsc::AR(3001.f - 203.f * channel, 0.f, 0.25f);
+			input = (input, channels[channel]);
+		}
+		
+		UGen bank = filters[index].function(input, -1);
+		UGen singles[NUMBANKCHANNELS];
+		float maximumDifference = 0.f;
+		
+		for(int channel = 0; channel < NUMBANKCHANNELS; channel++)
+			singles[channel] = filters[index].function(channels[channel], channel);
+		
+		for(int block = 0; block < numBlocks; block++)
+		{
+			const unsigned int blockID = UGen::getNextBlockID(blockSize);
+			bool shouldDelete = false;
+			
+			bank.prepareForBlock(blockSize, blockID, -1);
+			
+			for(int channel = 0; channel < NUMBANKCHANNELS; channel++)
+				singles[channel].prepareForBlock(blockSize, blockID, -1);
+			
+			for(int channel = 0; channel < NUMBANKCHANNELS; channel++)
+			{
+				const float* bankSamples = bank.processBlock(shouldDelete, blockID, channel);
+				const float* singleSamples = singles[channel].processBlock(shouldDelete, blockID, 0);
+				
+				for(int i = 0; i < blockSize; i++)
+					maximumDifference = ugen::max(maximumDifference, fabsf(bankSamples[i] - singleSamples[i]));
+			}
+		}
+		
+		if(bank.getNumChannels() != NUMBANKCHANNELS)
+			failure = "the wrong number of channels";
+		else if(!(maximumDifference <= filters[index].tolerance))
+			failure = "a channel differs by more than the tolerance";
+		
+		report(filters[index].name, failure);
+	}
+}
+
+// -- neural networks -----------------------------------------------------------
+
+#define NUMNEURALLAYERS		4	// including the input layer
+
+static const int neuralStructure[NUMNEURALLAYERS] = { 5, 9, 7, 3 };
+
+/** The per-node layers a NeuralNetwork used before it stored each layer as a weight matrix, 
+ with the same weights and thresholds as the network. */
+class NeuralNodeReference
+{
+public:
+	NeuralNodeReference(NeuralNetwork const& network) throw()
+	:	learnRate(network.getLearnRate()),
+		actFuncOffset(network.getActFuncOffset())
+	{
+		for(int layer = 0; layer < NUMNEURALLAYERS - 1; layer++)
+		{
+			for(int node = 0; node < neuralStructure[layer + 1]; node++)
+			{
+				NumericalArray<float> weights;
+				float threshold;
+				network.get(layer, node, &weights, threshold);
+				
+				nodes[layer][node] = NeuralNode(neuralStructure[layer]);
+				nodes[layer][node].set(weights, threshold);
+			}
+		}
+	}
+	
+	/** Each node's propogate() in turn as NeuralLayer used to, keeping each layer's input for backProp(). */
+	NumericalArray<float> propogate(NumericalArray<float> const& inputVector) throw()
+	{
+		NumericalArray<float> vector = inputVector;
+		
+		for(int layer = 0; layer < NUMNEURALLAYERS - 1; layer++)
+		{
+			inputs[layer] = vector.copy();
+			vector = NumericalArray<float>::newClear(neuralStructure[layer + 1]);
+			
+			for(int node = 0; node < neuralStructure[layer + 1]; node++)
+				vector[node] = nodes[layer][node].propogate(inputs[layer]);
+		}
+		
+		return vector;
+	}
+	
+	/** The online step NeuralNetwork::backProp() used to take with each node's backProp(). */
+	void backProp(NumericalArray<float> const& inputVector, NumericalArray<float> const& targetVector) throw()
+	{
+		NumericalArray<float> outputVector = propogate(inputVector);
+		NumericalArray<float> errorVector = NumericalArray<float>::newClear(outputVector.size());
+		
+		for(int i = 0; i < outputVector.size(); i++)
+			errorVector[i] = targetVector[i] - outputVector[i];
+		
+		for(int layer = NUMNEURALLAYERS - 2; layer >= 0; layer--)
+		{
+			NumericalArray<float> adjustVector = NumericalArray<float>::newClear(neuralStructure[layer]);
+			
+			for(int node = 0; node < neuralStructure[layer + 1]; node++)
+				nodes[layer][node].backProp(inputs[layer], errorVector[node], actFuncOffset, learnRate, adjustVector);
+			
+			errorVector = adjustVector;
+		}
+	}
+	
+	/** The largest difference between these weights and thresholds and the network's. */
+	float findDifference(NeuralNetwork const& network) const throw()
+	{
+		float difference = 0.f;
+		
+		for(int layer = 0; layer < NUMNEURALLAYERS - 1; layer++)
+		{
+			for(int node = 0; node < neuralStructure[layer + 1]; node++)
+			{
+				NumericalArray<float> weights, expectedWeights;
+				float threshold, expectedThreshold;
+				network.get(layer, node, &weights, threshold);
+				nodes[layer][node].get(&expectedWeights, expectedThreshold);
+				
+				difference = ugen::max(difference, fabsf(threshold - expectedThreshold));
+				
+				for(int i = 0; i < weights.size(); i++)
+					difference = ugen::max(difference, fabsf(weights[i] - expectedWeights[i]));
+			}
+		}
+		
+		return difference;
+	}
+	
+private:
+	enum { MaxNodes = 16 };
+	const float learnRate, actFuncOffset;
+	NeuralNode nodes[NUMNEURALLAYERS - 1][MaxNodes];
+	NumericalArray<float> inputs[NUMNEURALLAYERS - 1];
+};
+
+static NumericalArray<float> neuralVector(const int size) throw()
+{
+	NumericalArray<float> vector = NumericalArray<float>::newClear(size);
+	fill(vector.getArray(), size, 0.f, 1.f);
+	return vector;
+}
+
+/** NeuralNetwork::propogate() and propogateBlock() (which use the weight matrices) match the 
+ per-node propogation to the rounding of the dot products and activation function. */
+static void checkNeuralNetworkPropogate()
+{
+	const char* name = "NeuralNetwork matches per-node propogation";
+	if(!shouldRun(name)) return;
+	
+	const int numVectors = 37;
+	const int numInputs = neuralStructure[0];
+	const int numOutputs = neuralStructure[NUMNEURALLAYERS - 1];
+	const float tolerance = 1.0e-6f;
+	const char* failure = 0;
+	
+	std::srand(1);
+	NeuralNetwork network(IntArray::withArray(NUMNEURALLAYERS, neuralStructure), 0.25f, 0.1f);
+	network.randomise(2.f);
+	NeuralNodeReference reference(network);
+	NeuralNetworkWorkspace workspace(network.getStructure(), numVectors);
+	float difference = 0.f, blockDifference = 0.f;
+	NumericalArray<float> expected[numVectors];
+	
+	for(int vector = 0; vector < numVectors; vector++)
+	{
+		NumericalArray<float> input = neuralVector(numInputs);
+		float output[numOutputs];
+		
+		expected[vector] = reference.propogate(input);
+		network.propogate(input.getArray(), output);
+		
+		for(int i = 0; i < numInputs; i++)
+			workspace.getLayerSamples(0)[i][vector] = input[i];
+		
+		for(int i = 0; i < numOutputs; i++)
+			difference = ugen::max(difference, fabsf(output[i] - expected[vector][i]));
+	}
+	
+	network.getInternal()->propogateBlock(workspace, numVectors);
+	
+	for(int vector = 0; vector < numVectors; vector++)
+	{
+		for(int i = 0; i < numOutputs; i++)
+			blockDifference = ugen::max(blockDifference, fabsf(workspace.getLayerSamples(NUMNEURALLAYERS - 1)[i][vector] - expected[vector][i]));
+	}
+	
+	if(!(difference <= tolerance))
+		failure = "propogate() differs by more than the tolerance";
+	else if(!(blockDifference <= tolerance))
+		failure = "propogateBlock() differs by more than the tolerance";
+	
+	report(name, failure);
+}
+
+/** Training with a batch size of one on one thread takes the same online step as the per-node
+ back propogation, the weights and thresholds match to the rounding of the propogation. */
+static void checkNeuralNetworkTrain()
+{
+	const char* name = "NeuralNetwork batch of one matches per-node training";
+	if(!shouldRun(name)) return;
+	
+	const int numPatterns = 12;
+	const int numIterations = 50;
+	const float tolerance = 1.0e-5f;
+	const char* failure = 0;
+	
+	std::srand(2);
+	NeuralNetwork network(IntArray::withArray(NUMNEURALLAYERS, neuralStructure), 0.25f, 0.1f);
+	NeuralNodeReference reference(network);
+	NeuralPatternArray patterns;
+	
+	for(int i = 0; i < numPatterns; i++)
+		patterns.add(NeuralPattern(neuralVector(neuralStructure[0]), neuralVector(neuralStructure[NUMNEURALLAYERS - 1])));
+	
+	network.train(patterns, numIterations, 1, 1);
+	
+	for(int iteration = 0; iteration < numIterations; iteration++)
+		for(int i = 0; i < numPatterns; i++)
+			reference.backProp(patterns[i].getInputVector(), patterns[i].getOutputVector());
+	
+	if(!(reference.findDifference(network) <= tolerance))
+		failure = "the weights differ by more than the tolerance";
+	
+	report(name, failure);
+}
+
+// -- voices --------------------------------------------------------------------
+
+class CheckVoicerEvent : public VoicerEventBase<>
+{
+public:
+	UGen spawnEvent(VoicerBaseUGenInternal& /*spawn*/, const int /*eventCount*/, const int /*midiChannel*/, const int /*midiNote*/, const int velocity)
+	{
+		return UGen(velocity / 128.f);
+	}
+};
+
+static bool waitForReadyVoices(VoicePool& pool, const int numVoices)
+{
+	for(int i = 0; i < 200 && pool.getNumReady() < numVoices; i++)
+		UGenThread::sleep(10);
+	
+	return pool.getNumReady() >= numVoices;
+}
+
+/** A Keyed VoicePool keeps a voice ready for each note whatever its velocity, the voice 
+ is scaled for the velocity of the note it is taken for and a note which isn't ready is 
+ built rather than being silent. */
+static void checkKeyedVoicePool()
+{
+	const char* name = "VoicePool keyed notes and velocities";
+	if(!shouldRun(name)) return;
+	
+	const int blockSize = 64;
+	const char* failure = 0;
+	UGen voicer = VoicerBase<CheckVoicerEvent>::AR(1);
+	voicer.setVoicePoolSize(4);
+	VoicePool& pool = *voicer.getVoicePool();
+	
+	const int notes[] = { 60, 60, 62 };
+	const int velocities[] = { 100, 50, 30 };
+	float expected = 0.f;
+	
+	pool.prepareNote(1, 60, 100);
+	
+	for(int i = 0; i < 3 && failure == 0; i++)
+	{
+		// the note just played is rebuilt straight away
+		if(i < 2 && !waitForReadyVoices(pool, 1))
+			failure = "the voice wasn't rebuilt";
+		
+		voicer.sendMidiNote(1, notes[i], velocities[i]);
+		expected += velocities[i] / 128.f;
+		
+		float* output = voicer.prepareAndProcessBlock(blockSize, UGen::getNextBlockID(blockSize), 0);
+		
+		if(failure == 0 && output[blockSize - 1] != expected)
+			failure = "the output doesn't match the velocities";
+	}
+	
+	if(failure == 0 && (pool.getNumHits() != 2 || pool.getNumMisses() != 1))
+		failure = "expected two hits and one miss";
+	
+	report(name, failure);
+}
+
+// -- patching ------------------------------------------------------------------
+
+/** Changing the source of a Plug takes effect on the next block, switching back to a 
+ previous source reuses it and a crossfade which releases the previous sources leaves only 
+ the new source playing. */
+static void checkPlugSources()
+{
+	const char* name = "Plug source changes";
+	if(!shouldRun(name)) return;
+	
+	const int blockSize = 64;
+	const char* failure = 0;
+	UGen first = UGen(1.f);
+	UGen plug = Plug::AR(first, false);
+	
+	const int numChanges = 4;
+	UGen sources[numChanges] = { UGen(2.f), first, UGen(4.f), UGen(2.f) };
+	const bool releases[numChanges] = { false, false, true, false };
+	const float fadeTimes[numChanges] = { 0.f, 0.f, 0.01f, 0.f };
+	const float expected[numChanges] = { 2.f, 1.f, 4.f, 2.f };
+	
+	float* output = plug.prepareAndProcessBlock(blockSize, UGen::getNextBlockID(blockSize), 0);
+	
+	if(output[blockSize - 1] != 1.f)
+		failure = "the initial source isn't playing";
+	
+	for(int i = 0; i < numChanges && failure == 0; i++)
+	{
+		plug.setSource(sources[i], releases[i], fadeTimes[i]);
+		
+		// long enough for the crossfade to end
+		for(int block = 0; block < 20; block++)
+			output = plug.prepareAndProcessBlock(blockSize, UGen::getNextBlockID(blockSize), 0);
+		
+		if(output[blockSize - 1] != expected[i])
+			failure = "the output doesn't match the last source";
+	}
+	
+	report(name, failure);
+}
+
+// -- buffers -------------------------------------------------------------------
+
+/** A copy() of a Buffer a RecordBuf writes to mustn't share its data, otherwise the 
+ RecordBuf would take a private copy on the audio thread in its next block. */
+static void checkWriterBufferCopy()
+{
+	const char* name = "Buffer copy of a RecordBuf's Buffer";
+	if(!shouldRun(name)) return;
+	
+	const char* failure = 0;
+	Buffer buffer = Buffer::withSize(4096, 1, true);
+	
+	HeadlessHost host(0, 1, SAMPLERATE, 64, 64, false);
+	host.setOutput(RecordBuf::AR(LFSaw::AR(440, 0, 0.5f), buffer, 1, 0, 1));
+	host.processBlocks(2);
+	
+	const float* recorded = buffer.getDataReadOnly(0);
+	Buffer copy = buffer.copy();
+	
+	if(buffer.isShared() || copy.getDataReadOnly(0) == recorded)
+		failure = "the copy shares the data";
+	
+	host.processBlocks(2);
+	
+	if(failure == 0 && buffer.getDataReadOnly(0) != recorded)
+		failure = "the RecordBuf took a private copy";
+	
+	report(name, failure);
+}
+
+// -- telemetry -----------------------------------------------------------------
+
+/** Dropping the last reference to a DataRecorder hands it to the TelemetryService thread
+ which must write the lines still in its ring and then delete it and its channel. */
+static void checkTelemetryRetire()
+{
+	const char* name = "DataRecorder retired on the telemetry thread";
+	if(!shouldRun(name)) return;
+	
+	const char* failure = 0;
+	const char* path = "Checks_UGen_recorder.txt";
+	TelemetryService& service = TelemetryService::getInstance();
+	const int numChannels = service.getNumChannels();
+	int numTriggers = 0;
+	
+	{
+		// the recorder passes its input through so this is the trigger too
+		HeadlessHost host(0, 1, SAMPLERATE, 64, 64, false);
+		host.setOutput(DataRecorder::AR(Impulse::AR(500), Impulse::AR(500), path));
+		Buffer output = host.render(0.05);
+		const float* samples = output.getDataReadOnly(0);
+		float lastSample = 0.f;
+		
+		for(int i = 0; i < output.size(); i++)
+		{
+			if(samples[i] > 0.f && lastSample <= 0.f) numTriggers++;
+			lastSample = samples[i];
+		}
+	}
+	
+	for(int i = 0; i < 200 && service.getNumChannels() != numChannels; i++)
+		UGenThread::sleep(10);
+	
+	int numLines = 0;
+	FILE* file = fopen(path, "r");
+	
+	if(file != 0)
+	{
+		int c;
+		while((c = fgetc(file)) != EOF)
+			if(c == '\n') numLines++;
+		
+		fclose(file);
+	}
+	
+	if(service.getNumChannels() != numChannels)
+		failure = "the channel wasn't deleted";
+	else if(numTriggers == 0)
+		failure = "no triggers";
+	else if(numLines != numTriggers)
+		failure = "lines were lost";
+	
+	remove(path);
+	report(name, failure);
+}
+
+// -- FFT -----------------------------------------------------------------------
+
+/** Engines made by createShared() use one cached plan but their own work buffers and 
+ transform exactly as the engine they were made from. */
+static void checkFFTSharedPlans()
+{
+	const char* name = "FFTEngine shared plans";
+	if(!shouldRun(name)) return;
+	
+	const int fftSize = 1024;
+	const char* failure = 0;
+	FFTEngine::clearPlanCache();
+	
+	FFTEngine original(fftSize);
+	FFTEngine first = original.createShared();
+	FFTEngine second = original.createShared();
+	
+	Buffer input = Buffer::newClear(fftSize, 1, false);
+	fill(input.getData(0), fftSize, -1.f, 1.f);
+	Buffer expected = Buffer::newClear(fftSize, 1, false);
+	Buffer actual = Buffer::newClear(fftSize, 1, false);
+	
+	original.fft(expected, input, true);
+	
+	if(FFTEngine::getNumCachedPlans() != 1)
+		failure = "the plan wasn't shared";
+	else if(first.getInternal() == second.getInternal())
+		failure = "the engines share work buffers";
+	
+	for(int i = 0; i < 2 && failure == 0; i++)
+	{
+		(i == 0 ? first : second).fft(actual, input, true);
+		
+		if(!sameBits(expected.getDataReadOnly(0), actual.getDataReadOnly(0), fftSize))
+			failure = "the spectrum differs";
+	}
+	
+	report(name, failure);
+}
+
+// -- convolution ---------------------------------------------------------------
+
+#ifdef UGEN_CONVOLUTION
+
+/** Convolve an impulse train (so the responses overlap across the FFT hops) and compare 
+ with direct convolution. PartConvolve has a latency of half its FFT size. */
+static void checkConvolution()
+{
+	static const char* names[] = { "PartConvolve matches direct convolution", "ZeroLatencyConvolve matches direct convolution" };
+	static const int latencies[] = { 512, 0 };
+	
+	const int impulseSize = 3000;
+	const double duration = 0.2;
+	Buffer impulse = Buffer::newClear(impulseSize, 1, false);
+	fill(impulse.getData(0), impulseSize, -1.f, 1.f);
+	
+	HeadlessHost inputHost(0, 1, SAMPLERATE, 256, 64, false);
+	inputHost.setOutput(Impulse::AR(100));
+	Buffer input = inputHost.render(duration);
+	
+	const int numSamples = input.size();
+	const float* inputSamples = input.getDataReadOnly(0);
+	const float* impulseSamples = impulse.getDataReadOnly(0);
+	float* expected = new float[numSamples];
+	float peak = 0.f;
+	
+	for(int i = 0; i < numSamples; i++)
+	{
+		double sum = 0.0;
+		
+		for(int k = 0; k < impulseSize && k <= i; k++)
+			sum += impulseSamples[k] * inputSamples[i - k];
+		
+		expected[i] = (float)sum;
+		peak = ugen::max(peak, (float)fabs(sum));
+	}
+	
+	for(int c = 0; c < 2; c++)
+	{
+		if(!shouldRun(names[c])) continue;
+		
+		const char* failure = 0;
+		HeadlessHost host(0, 1, SAMPLERATE, 256, 64, false);
+		
+		if(c == 0)
+			host.setOutput(PartConvolve::AR(Impulse::AR(100), impulse, 0, 0, 1024));
+		else
+			host.setOutput(ZeroLatencyConvolve::AR(Impulse::AR(100), impulse));
+		
+		Buffer output = host.render(duration);
+		const float* outputSamples = output.getDataReadOnly(0);
+		
+		for(int i = 0; i + latencies[c] < output.size() && failure == 0; i++)
+			if(fabs(outputSamples[i + latencies[c]] - expected[i]) > peak * 1.0e-4f)
+				failure = "the output differs";
+		
+		report(names[c], failure);
+	}
+	
+	delete [] expected;
+}
+
+#endif // UGEN_CONVOLUTION
+
+// -- audio files ---------------------------------------------------------------
+
+/** Write each file type at each sample rate and bit depth and read it back. */
+static void checkAudioFileRoundTrip()
+{
+	static const MappedAudioFile::FileType types[] = { MappedAudioFile::WAV, MappedAudioFile::AIFF, MappedAudioFile::CAF };
+	static const char* extensions[] = { "wav", "aif", "caf" };
+	static const double sampleRates[] = { 44100.0, 48000.0 };
+	static const int bitDepths[] = { 16, 24, 32 };
+	
+	const int numChannels = 2;
+	const int numFrames = 1000;
+	float left[numFrames], right[numFrames];
+	fill(left, numFrames, -1.f, 1.f);
+	fill(right, numFrames, -1.f, 1.f);
+	const float* channels[numChannels] = { left, right };
+	
+	for(int t = 0; t < 3; t++)
+	{
+		for(int r = 0; r < 2; r++)
+		{
+			char name[64];
+			snprintf(name, sizeof(name), "%s round trip at %.0fHz", extensions[t], sampleRates[r]);
+			
+			if(!shouldRun(name))
+				continue;
+			
+			const char* failure = 0;
+			char path[64];
+			snprintf(path, sizeof(path), "Checks_UGen_round_trip.%s", extensions[t]);
+			
+			for(int b = 0; b < 3 && failure == 0; b++)
+			{
+				const int bitDepth = bitDepths[b];
+				
+				if(!MappedAudioFile::write(path, channels, numChannels, numFrames, sampleRates[r], bitDepth, true, types[t]))
+				{
+					failure = "write failed";
+					break;
+				}
+				
+				double sampleRate = 0.0;
+				int bits = 0;
+				Buffer buffer(path, &bits, &sampleRate);
+				
+				// the integer formats are within one step, float is exact
+				const float tolerance = bitDepth == 32 ? 0.f : 1.f / (float)(1 << (bitDepth - 2));
+				
+				if(buffer.getNumChannels() != numChannels || buffer.size() != numFrames)
+					failure = "wrong number of channels or frames";
+				else if(sampleRate != sampleRates[r])
+					failure = "wrong sample rate";
+				else if(bits != bitDepth)
+					failure = "wrong bit depth";
+				
+				for(int channel = 0; channel < numChannels && failure == 0; channel++)
+				{
+					const float* samples = buffer.getDataReadOnly(channel);
+					
+					for(int i = 0; i < numFrames && failure == 0; i++)
+						if(fabs(samples[i] - channels[channel][i]) > tolerance)
+							failure = bitDepth == 16 ? "16-bit samples differ" : bitDepth == 24 ? "24-bit samples differ" : "float samples differ";
+				}
+			}
+			
+			remove(path);
+			report(name, failure);
+		}
+	}
+}
+
+int main (int argc, char * const argv[])
+{
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else
+		{
+			printf("usage: %s [--filter name]\n", argv[0]);
+			return 2;
+		}
+	}
+	
+	UGen::initialise();
+	UGen::prepareToPlay(SAMPLERATE, 256, 64);
+
+#ifdef UGEN_SIMD
+	checkSIMDKernels();
+	checkSIMDRender();
+#endif
+	
+	checkOutputArena();
+	checkParallelRenderer();
+	checkParameterControlReaders();
+	checkOfflineRenderer();
+	checkMixGroups();
+	checkMixCompensated();
+	checkDelayTaps();
+	checkSOSBank();
+	checkNeuralNetworkPropogate();
+	checkNeuralNetworkTrain();
+	checkKeyedVoicePool();
+	checkPlugSources();
+	checkWriterBufferCopy();
+	checkTelemetryRetire();
+	checkFFTSharedPlans();
+	
+#ifdef UGEN_CONVOLUTION
+	checkConvolution();
+#endif
+	
+	checkAudioFileRoundTrip();
+
+	printf("%d checks, %d failed\n", numChecks, numFailures);
+	
+	UGen::shutdown();
+	return numFailures == 0 ? 0 : 1;
+}
@@ -92,6 +92,16 @@ BEGIN_UGEN_NAMESPACE
 #include "core/ugen_Bits.h"
 #include "core/ugen_Value.h"
 #include "core/ugen_Arrays.h"
+#include "core/ugen_Atomics.h"
+#include "core/ugen_AtomicSlot.h"
+#include "core/ugen_Threads.h"
+#include "core/ugen_DeferredDeleter.h"
+#include "core/ugen_ParallelRenderer.h"
+#include "core/ugen_UGenOutputArena.h"
+#include "core/ugen_HeadlessHost.h"
+#include "core/ugen_OfflineRenderer.h"
+#include "core/ugen_ParameterQueue.h"
+#include "core/ugen_ExternalControlSource.h"
 #include "basics/ugen_ScalarUGens.h"
 #include "basics/ugen_UnaryOpUGens.h"
 #include "basics/ugen_BinaryOpUGens.h"
@@ -103,6 +113,7 @@ BEGIN_UGEN_NAMESPACE
 #include "basics/ugen_Pause.h"
 #include "basics/ugen_MulAdd.h"
 #include "basics/ugen_Thru.h"
+#include "basics/ugen_Fuse.h"
 #include "basics/ugen_Chain.h"
 #include "basics/ugen_WrapFold.h"
 #include "envelopes/ugen_Lines.h"
@@ -110,6 +121,10 @@ BEGIN_UGEN_NAMESPACE
 #include "envelopes/ugen_EnvGen.h"
 #include "buffers/ugen_Buffer.h"
 #include "buffers/ugen_PlayBuf.h"
+#include "buffers/ugen_MappedAudioFile.h"
+#include "buffers/ugen_DiskStream.h"
+#include "buffers/ugen_Resampler.h"
+#include "buffers/ugen_Telemetry.h"
 #include "oscillators/wavetable/ugen_TableOsc.h"
 #include "oscillators/simple/ugen_LFSaw.h"
 #include "oscillators/simple/ugen_LFPulse.h"
@@ -119,10 +134,12 @@ BEGIN_UGEN_NAMESPACE
 #include "filters/control/ugen_Lag.h"
 #include "filters/control/ugen_Decay.h"
 #include "filters/ugen_SOS.h"
+#include "filters/ugen_SOSBank.h"
 #include "filters/ugen_LeakDC.h"
 #include "filters/simple/ugen_LPF.h"
 #include "filters/simple/ugen_HPF.h"
 #include "filters/ugen_BEQ.h"
+#include "spawn/ugen_VoicePool.h"
 #include "spawn/ugen_Spawn.h"
 #include "spawn/ugen_TSpawn.h"
 #include "spawn/ugen_VoicerBase.h"
@@ -147,6 +164,10 @@ BEGIN_UGEN_NAMESPACE
 #include "convolution/ugen_HRTF.h"
 #endif
 
+#ifdef UGEN_SIMD
+#include "vec/ugen_simd_Utilities.h"
+#endif
+
 #ifndef UGEN_ANDROID
 // just not yet.. 
 	#include "core/ugen_TextFile.h" // std lib
@@ -155,6 +176,7 @@ BEGIN_UGEN_NAMESPACE
 	#include "envelopes/ugen_ASR.h"
 	#include "filters/dynamics/ugen_Normaliser.h"
 	#include "delays/ugen_BlockDelay.h"
+	#include "delays/ugen_FDNReverb.h"
 	#include "gui/ugen_Scope.h"
 	#include "fft/ugen_FFTMagnitude.h"
 	#include "fft/ugen_FFTMagnitudeSelection.h"
@@ -163,6 +185,7 @@ BEGIN_UGEN_NAMESPACE
 	#include "buffers/ugen_XFadePlayBuf.h"
 	#include "analysis/ugen_DataRecorder.h"
 	#include "pan/ugen_Ambisonic.h"
+	#include "pan/ugen_HOA.h"
 #endif
 
 #ifdef UGEN_JUCE
@@ -181,7 +204,7 @@ BEGIN_UGEN_NAMESPACE
 	#include "juce/io/ugen_JuceMIDIInputBroadcaster.h"
 	#include "juce/io/ugen_JuceIOHost.h"
 	#ifdef UGEN_CONVOLUTION
-		#if !defined(WIN32) && !defined(UGEN_ANDROID)
+		#if defined(__APPLE__) && !defined(UGEN_ANDROID)
 		END_UGEN_NAMESPACE
 			#include <Accelerate/Accelerate.h>
 		BEGIN_UGEN_NAMESPACE
@@ -212,6 +235,18 @@ BEGIN_UGEN_NAMESPACE
 		#include "convolution/ugen_Convolution.h"
 		#include "convolution/ugen_SimpleConvolution.h"
 	#endif
+#else
+	// standalone builds (e.g., the CMake build on Linux)
+	#ifdef UGEN_CONVOLUTION
+		#if defined(__APPLE__) && !defined(UGEN_ANDROID)
+		END_UGEN_NAMESPACE
+			#include <Accelerate/Accelerate.h>
+		BEGIN_UGEN_NAMESPACE
+		#endif
+		#include "convolution/ugen_Convolution.h"
+		#include "convolution/ugen_Correlation.h"
+		#include "convolution/ugen_SimpleConvolution.h"
+	#endif // UGEN_CONVOLUTION
 #endif
 
 #ifdef UGEN_IPHONE
@@ -49,10 +49,24 @@ DataRecorderUGenInternal::DataRecorderUGenInternal(UGen const& input,
 :	ProxyOwnerUGenInternal(NumInputs, input.getNumChannels()-1),
 	fileWriter(file),
 	lastTrig(0.f),
-	timeStamp(_timeStamp)
+	timeStamp(_timeStamp),
+	recordFrame(Buffer::newClear(input.getNumChannels()))
 {
 	inputs[Input] = input;
 	inputs[Trig] = trig;
+	
+	initTelemetry(1, recordFrame.size(), 64);
+}
+
+DataRecorderUGenInternal::~DataRecorderUGenInternal()
+{
+	releaseTelemetry();
+}
+
+void DataRecorderUGenInternal::deleteUnreferenced() throw()
+{
+	// don't lose the last lines of the file, they're written on the service thread
+	retireTelemetry(this, true);
 }
 
 void DataRecorderUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
@@ -66,21 +80,15 @@ void DataRecorderUGenInternal::processBlock(bool& shouldDelete, const unsigned i
 		
 		if(thisTrig > 0.f && lastTrig <= 0.f)
 		{
-			if(timeStamp == true)
-			{
-				fileWriter.writeValue(blockID+i);
-				fileWriter.write(" ");
-			}
-				
-			for(int channel = 0; channel < inputs[Input].getNumChannels(); channel++)
+			float * const recordSamples = recordFrame.getData(0);
+			
+			for(int channel = 0; channel < recordFrame.size(); channel++)
 			{
 				float *values = inputs[Input].processBlock(shouldDelete, blockID, channel);
-				float value = values[i];
-				fileWriter.writeValue(value);
-				fileWriter.write(" ");
+				recordSamples[channel] = values[i];
 			}
 			
-			fileWriter.write("\n");
+			postTelemetry(recordFrame, recordFrame.size(), (double)(blockID+i));
 		}
 		
 		lastTrig = thisTrig;
@@ -94,6 +102,27 @@ void DataRecorderUGenInternal::processBlock(bool& shouldDelete, const unsigned i
 	}
 }
 
+void DataRecorderUGenInternal::handleTelemetry(Buffer const& frame, const double value1, const int value2) throw()
+{
+	if(timeStamp == true)
+	{
+		fileWriter.writeValue((unsigned int)value1);
+		fileWriter.write(" ");
+	}
+	
+	const float * const values = frame.getData(0);
+	
+	for(int channel = 0; channel < frame.size(); channel++)
+	{
+		fileWriter.writeValue(values[channel]);
+		fileWriter.write(" ");
+	}
+	
+	fileWriter.write("\n");
+	
+	sendBuffer(frame, value1, value2);
+}
+
 DataRecorder::DataRecorder(UGen const& input, UGen const& trig, Text const& file, const bool timeStamp) throw()
 {
 	DataRecorderUGenInternal *internal = new DataRecorderUGenInternal(input, trig.mix(), file, timeStamp);
@@ -40,13 +40,18 @@
 
 #include "../core/ugen_UGen.h"
 #include "../core/ugen_TextFile.h"
+#include "../buffers/ugen_Telemetry.h"
 
 /** @ingroup UGenInternals */
-class DataRecorderUGenInternal : public ProxyOwnerUGenInternal
+class DataRecorderUGenInternal :	public ProxyOwnerUGenInternal,
+									public TelemetrySender
 {
 public:
 	DataRecorderUGenInternal(UGen const& input, UGen const& trig, Text const& file, const bool timeStamp = false) throw();
+	~DataRecorderUGenInternal();
+	void deleteUnreferenced() throw();
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	void handleTelemetry(Buffer const& frame, const double value1, const int value2) throw();
 	
 	enum Inputs { Input, Trig, NumInputs };
 	
@@ -54,9 +59,12 @@ protected:
 	TextFileWriter fileWriter;
 	float lastTrig;
 	const bool timeStamp;
+	Buffer recordFrame;
 };
 
-/** Record the state of an input UGen at a given trigger into a text file. */
+/** Record the state of an input UGen at a given trigger into a text file. 
+ The values are written to the file on the TelemetryService thread, they are also sent 
+ as a single channel Buffer to any BufferReceiver objects (with the time stamp as value1). */
 UGenSublcassDeclaration(DataRecorder,
 								 (input, trig, file, timeStamp), 
 								 (UGen const& input, UGen const& trig, Text const& file, const bool timeStamp = false),
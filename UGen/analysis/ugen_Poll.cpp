@@ -42,11 +42,24 @@ BEGIN_UGEN_NAMESPACE
 #include "ugen_Poll.h"
 
 PollUGenInternal::PollUGenInternal(UGen const& input, UGen const& trig) throw()
-:	UGenInternal(NumInputs)
+:	UGenInternal(NumInputs),
+	pollFrame(Buffer::newClear(input.getNumChannels()))
 {
 	inputs[Input] = input;
 	inputs[Trig] = trig;
 	lastTrig = 0.f;
+	
+	initTelemetry(1, pollFrame.size(), 32);
+}
+
+PollUGenInternal::~PollUGenInternal()
+{
+	releaseTelemetry();
+}
+
+void PollUGenInternal::deleteUnreferenced() throw()
+{
+	retireTelemetry(this);
 }
 
 UGenInternal* PollUGenInternal::getChannel(const int channel) throw()
@@ -70,9 +83,8 @@ void PollUGenInternal::processBlock(bool& shouldDelete, const unsigned int block
 		
 		if(thisTrig > 0.f && lastTrig <= 0.f)
 		{
-			const int numChannels = inputs[Input].getNumChannels();
-			Buffer poll = Buffer::newClear(numChannels);
-			float * const pollSamples = poll.getData(0);
+			const int numChannels = pollFrame.size();
+			float * const pollSamples = pollFrame.getData(0);
 			
 			for(int channel = 0; channel < numChannels; channel++)
 			{
@@ -80,7 +92,7 @@ void PollUGenInternal::processBlock(bool& shouldDelete, const unsigned int block
 				pollSamples[channel] = inputSamples[sample];
 			}
 			
-			sendBuffer(poll);
+			postTelemetry(pollFrame, numChannels);
 		}
 		
 		*outputSamples++ = 0.f;
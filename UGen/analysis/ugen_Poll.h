@@ -39,14 +39,17 @@
 #define _UGEN_Poll_H_
 
 #include "../core/ugen_UGen.h"
+#include "../buffers/ugen_Telemetry.h"
 
 
 /** @ingroup UGenInternals */
 class PollUGenInternal :	public UGenInternal, 
-							public BufferSender
+							public TelemetrySender
 {
 public:
 	PollUGenInternal(UGen const& input, UGen const& trig) throw();
+	~PollUGenInternal();
+	void deleteUnreferenced() throw();
 	UGenInternal* getChannel(const int channel) throw();
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
 	
@@ -54,12 +57,15 @@ public:
 	
 protected:
 	float lastTrig;
+	Buffer pollFrame;
 };
 
 /** Grabs the values of one or more channels at a partiuclar instant.
  These values are then sent as a single channel Buffer to registered BufferReceiver
  objects. The polling occurs in response to a trigger in the @c trig input. (A 
- trigger is where a signal goes from zero or less to greater than zero.) */
+ trigger is where a signal goes from zero or less to greater than zero.) 
+ The audio thread only copies the values, the receivers are called on the 
+ TelemetryService thread. */
 UGenSublcassDeclarationNoDefault
 (
  Poll,
@@ -40,6 +40,7 @@
 #include "../core/ugen_StandardHeader.h"
 #include "../basics/ugen_BinaryOpUGens.cpp"
 #include "../basics/ugen_Chain.cpp"
+#include "../basics/ugen_Fuse.cpp"
 #include "../basics/ugen_MappingUGens.cpp"
 #include "../basics/ugen_MixUGen.cpp"
 #include "../basics/ugen_MulAdd.cpp"
@@ -51,14 +52,25 @@
 #include "../basics/ugen_UnaryOpUGens.cpp"
 #include "../basics/ugen_WrapFold.cpp"
 #include "../buffers/ugen_Buffer.cpp"
+#include "../buffers/ugen_DiskStream.cpp"
+#include "../buffers/ugen_MappedAudioFile.cpp"
 #include "../buffers/ugen_PlayBuf.cpp"
+#include "../buffers/ugen_Resampler.cpp"
+#include "../buffers/ugen_Telemetry.cpp"
 #include "../core/ugen_Arrays.cpp"
 #include "../core/ugen_Bits.cpp"
+#include "../core/ugen_DeferredDeleter.cpp"
 #include "../core/ugen_Deleter.cpp"
 #include "../core/ugen_ExternalControlSource.cpp"
+#include "../core/ugen_HeadlessHost.cpp"
+#include "../core/ugen_OfflineRenderer.cpp"
+#include "../core/ugen_ParallelRenderer.cpp"
+#include "../core/ugen_ParameterQueue.cpp"
+#include "../core/ugen_UGenOutputArena.cpp"
 #include "../core/ugen_Random.cpp"
 #include "../core/ugen_SmartPointer.cpp"
 #include "../core/ugen_Text.cpp"
+#include "../core/ugen_Threads.cpp"
 #include "../core/ugen_UGen.cpp"
 #include "../core/ugen_UGenArray.cpp"
 #include "../core/ugen_UGenInternal.cpp"
@@ -74,6 +86,7 @@
 #include "../filters/ugen_BEQ.cpp"
 #include "../filters/control/ugen_Decay.cpp"
 #include "../filters/ugen_SOS.cpp"
+#include "../filters/ugen_SOSBank.cpp"
 #include "../filters/ugen_LeakDC.cpp"
 #include "../filters/simple/ugen_LPF.cpp"
 #include "../filters/simple/ugen_HPF.cpp"
@@ -84,6 +97,7 @@
 #include "../oscillators/simple/ugen_Triggers.cpp"
 #include "../spawn/ugen_Spawn.cpp"
 #include "../spawn/ugen_TSpawn.cpp"
+#include "../spawn/ugen_VoicePool.cpp"
 #include "../spawn/ugen_VoicerBase.cpp"
 #include "../spawn/ugen_Textures.cpp"
 #include "../analysis/ugen_Amplitude.cpp"
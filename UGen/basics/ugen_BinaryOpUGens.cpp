@@ -73,7 +73,7 @@ BinaryOpValueInternal::BinaryOpValueInternal(Value const& leftOperand, Value con
 }
 
 // using vector ops these might be defined elsewhere...
-#if defined(UGEN_VFP) || defined(UGEN_NEON) || defined(UGEN_VDSP)
+#if defined(UGEN_VFP) || defined(UGEN_NEON) || defined(UGEN_VDSP) || defined(UGEN_SIMD)
 BinaryOpSymbolUGenDefinitionNoProcessBlock(Add,				+,	+);
 BinaryOpSymbolUGenDefinitionNoProcessBlock(Subtract,		-,	-);
 BinaryOpSymbolUGenDefinitionNoProcessBlock(Multiply,		*,	*);
@@ -139,6 +139,18 @@ UGenInternal* BinaryDivideUGenInternal::getKr() throw()
 	return new BinaryDivideUGenInternalK(inputs[LeftOperand].kr(), inputs[RightOperand].kr()); 
 } 
 
+void BinaryDivideUGenInternal::processSamples(const float* leftOperandSamples, const float* rightOperandSamples, 
+											  float* outputSamples, const int numSamples) throw()
+{
+	for(int i = 0; i < numSamples; ++i)
+		outputSamples[i] = leftOperandSamples[i] / rightOperandSamples[i];
+}
+
+BinaryOpUGenInternal::Kernel BinaryDivideUGenInternal::getKernel() const throw()
+{
+	return processSamples;
+}
+
 BinaryDivideUGenInternalK::BinaryDivideUGenInternalK(UGen const& leftOperand, UGen const& rightOperand) throw() 
 :	BinaryDivideUGenInternal(leftOperand, rightOperand), 
 	value(0.f) 
@@ -171,7 +183,7 @@ BinaryDivideUGen::BinaryDivideUGen(UGen const& leftOperand, UGen const& rightOpe
 	}
 } 
 
-#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP)
+#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP) && !defined(UGEN_SIMD)
 void BinaryDivideUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw() 
 { 
 	int numSamplesToProcess = uGenOutput.getBlockSize(); 
@@ -191,6 +191,9 @@
 			UGenInternal* getKr() throw();																				\
 			void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();				\
 			float getValue(const int channel) const throw();															\
+			Kernel getKernel() const throw();																			\
+			static void processSamples(const float* leftOperandSamples, const float* rightOperandSamples,				\
+									   float* outputSamples, const int numSamples) throw();								\
 		};																												\
 		/** Control rate internal for Binary##OPNAME##UGen @ingroup UGenInternals */									\
 		class Binary##OPNAME##UGenInternalK : public Binary##OPNAME##UGenInternal										\
@@ -199,6 +202,7 @@
 			Binary##OPNAME##UGenInternalK(UGen const& leftOperand, UGen const& rightOperand) throw();					\
 			UGenInternal* getKr() throw() { incrementRefCount(); return this; }											\
 			void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();				\
+			Kernel getKernel() const throw() { return 0; }																\
 		private:																										\
 			float value;																								\
 		};																												\
@@ -373,6 +377,21 @@
 		return inputs[LeftOperand].getValue(channel) OPSYMBOL inputs[RightOperand].getValue(channel);					\
 	}																													\
 																														\
+	void Binary##OPNAME##UGenInternal::processSamples(const float* leftOperandSamples,									\
+													 const float* rightOperandSamples,									\
+													 float* outputSamples,												\
+													 const int numSamples) throw()										\
+	{																													\
+		for(int i = 0; i < numSamples; ++i) {																			\
+			outputSamples[i] = leftOperandSamples[i] OPSYMBOL_INTERNAL rightOperandSamples[i];							\
+		}																												\
+	}																													\
+																														\
+	BinaryOpUGenInternal::Kernel Binary##OPNAME##UGenInternal::getKernel() const throw()								\
+	{																													\
+		return processSamples;																							\
+	}																													\
+																														\
 	void Binary##OPNAME##UGenInternalK::processBlock(bool& shouldDelete,												\
 													 const unsigned int blockID,										\
 													 const int channel) throw()											\
@@ -523,6 +542,21 @@
 		return OPFUNCTION_INTERNAL(inputs[LeftOperand].getValue(channel), inputs[RightOperand].getValue(channel));		\
 	}																													\
 																														\
+	void Binary##OPNAME##UGenInternal::processSamples(const float* leftOperandSamples,									\
+													 const float* rightOperandSamples,									\
+													 float* outputSamples,												\
+													 const int numSamples) throw()										\
+	{																													\
+		for(int i = 0; i < numSamples; ++i) {																			\
+			outputSamples[i] = OPFUNCTION_INTERNAL(leftOperandSamples[i], rightOperandSamples[i]);						\
+		}																												\
+	}																													\
+																														\
+	BinaryOpUGenInternal::Kernel Binary##OPNAME##UGenInternal::getKernel() const throw()								\
+	{																													\
+		return processSamples;																							\
+	}																													\
+																														\
 	void Binary##OPNAME##UGenInternalK::processBlock(bool& shouldDelete,												\
 													 const unsigned int blockID,										\
 													 const int channel) throw()											\
@@ -679,6 +713,14 @@ public:
 	
 	enum Inputs { LeftOperand, RightOperand, NumInputs };
 	
+	/** A function which applies the operation to a block of samples. */
+	typedef void (*Kernel)(const float* leftOperandSamples, const float* rightOperandSamples, float* outputSamples, const int numSamples);
+	
+	/** Returns the Kernel for this operation or 0 if it can't be applied sample-by-sample
+	 (e.g., control rate versions). This is used by Fuse to combine trees of operations. */
+	virtual Kernel getKernel() const throw() { return 0; }
+	int getNumFusibleOperands() const throw() { return (isControlRateOnly() == false && getKernel() != 0) ? 2 : 0; }
+	
 protected:
 };
 
@@ -746,6 +788,9 @@ public:
 	UGenInternal* getChannel(const int channel) throw(); 
 	UGenInternal* getKr() throw(); 
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw(); 
+	Kernel getKernel() const throw();
+	static void processSamples(const float* leftOperandSamples, const float* rightOperandSamples, 
+							   float* outputSamples, const int numSamples) throw();
 }; 
 
 /** Control rate internal for BinaryDivideUGen */
@@ -755,6 +800,7 @@ public:
 	BinaryDivideUGenInternalK(UGen const& leftOperand, UGen const& rightOperand) throw(); 
 	UGenInternal* getKr() throw() { incrementRefCount(); return this; } 
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw(); 
+	Kernel getKernel() const throw() { return 0; }
 	float getValue(const int channel) const throw() 
 	{ 
 		return inputs[LeftOperand].getValue(channel) / inputs[RightOperand].getValue(channel);
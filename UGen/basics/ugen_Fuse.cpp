@@ -0,0 +1,266 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+
+#include "../core/ugen_StandardHeader.h"
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_Fuse.h"
+
+/** Walks a tree of operators and lays out its instructions and leaves.
+ This is run twice, once without any storage to count the instructions and leaves 
+ and once to fill in the arrays allocated using those counts. */
+class FuseCompiler
+{
+public:
+	FuseCompiler(const int channel, 
+				 const int numChannels, 
+				 UGen* leaves = 0, 
+				 FuseUGenInternal::Instruction* instructions = 0) throw()
+	:	numLeaves(0),
+		numInstructions(0),
+		numRegisters(0),
+		channel_(channel),
+		numChannels_(numChannels),
+		leaves_(leaves),
+		instructions_(instructions)
+	{
+	}
+	
+	/** Returns the operand code for a UGen, this will be a register if the UGen is an
+	 operator we can fuse, otherwise it becomes a leaf. */
+	int compileOperand(UGen const& operand, const int depth) throw()
+	{
+		// only descend if the channels line up, otherwise a UGen with fewer channels
+		// would be evaluated with a different channel index than in the original graph
+		if(operand.getNumChannels() == numChannels_)
+		{
+			UGenInternal* internal = operand.getInternalUGen(channel_);
+			const bool fusible = internal->getNumFusibleOperands() > 0;
+			const int code = fusible ? compileOperator(internal, depth) : 0;
+			internal->decrementRefCount();
+			
+			if(fusible) return code;
+		}
+		
+		if(leaves_) leaves_[numLeaves] = operand;
+		return numLeaves++;
+	}
+	
+	/** Compiles the operands (if any are operators their results are placed in registers
+	 above this depth) then the operator itself whose result is placed in the register at this depth. */
+	int compileOperator(UGenInternal* internal, const int depth) throw()
+	{
+		const int numOperands = internal->getNumFusibleOperands();
+		int operands[2] = { 0, 0 };
+		
+		for(int i = 0; i < numOperands; i++)
+			operands[i] = compileOperand(internal->getInput(i), depth + i);
+		
+		if(instructions_)
+		{
+			FuseUGenInternal::Instruction& instruction = instructions_[numInstructions];
+			
+			if(numOperands == 1)
+			{
+				instruction.unaryKernel = static_cast<UnaryOpUGenInternal*> (internal)->getKernel();
+				instruction.binaryKernel = 0;
+			}
+			else
+			{
+				instruction.unaryKernel = 0;
+				instruction.binaryKernel = static_cast<BinaryOpUGenInternal*> (internal)->getKernel();
+			}
+			
+			instruction.operands[0] = operands[0];
+			instruction.operands[1] = operands[1];
+			instruction.output = depth;
+		}
+		
+		numInstructions++;
+		if(depth >= numRegisters) numRegisters = depth + 1;
+		
+		return -1 - depth;
+	}
+	
+	int numLeaves;
+	int numInstructions;
+	int numRegisters;
+	
+private:
+	const int channel_;
+	const int numChannels_;
+	UGen* leaves_;
+	FuseUGenInternal::Instruction* instructions_;
+};
+
+
+FuseUGenInternal::FuseUGenInternal(UGen const* leaves, 
+								   const int numLeaves, 
+								   Instruction const* instructionsToCopy, 
+								   const int numInstructionsToCopy, 
+								   const int numRegistersToUse) throw()
+:	UGenInternal(numLeaves),
+	instructions(new Instruction[numInstructionsToCopy]),
+	numInstructions(numInstructionsToCopy),
+	numRegisters(numRegistersToUse),
+	registers(new float[numRegistersToUse * ChunkSize]),
+	leafSamples(new const float*[numLeaves])
+{
+	ugen_assert(numLeaves > 0);
+	ugen_assert(numInstructionsToCopy > 0);
+	ugen_assert(numRegistersToUse > 0);
+	
+	for(int i = 0; i < numLeaves; i++)
+		inputs[i] = leaves[i];
+	
+	memcpy(instructions, instructionsToCopy, numInstructions * sizeof(Instruction));
+}
+
+FuseUGenInternal::~FuseUGenInternal()
+{
+	delete [] instructions;
+	delete [] registers;
+	delete [] leafSamples;
+}
+
+UGenInternal* FuseUGenInternal::getChannel(const int channel) throw()
+{
+	UGen* leaves = new UGen[numInputs_];
+	
+	for(unsigned int i = 0; i < numInputs_; i++)
+		leaves[i] = inputs[i].getChannel(channel);
+	
+	UGenInternal* internal = new FuseUGenInternal(leaves, numInputs_, instructions, numInstructions, numRegisters);
+	delete [] leaves;
+	
+	return internal;
+}
+
+FuseUGenInternal* FuseUGenInternal::create(UGen const& input, const int channel) throw()
+{
+	UGenInternal* root = input.getInternalUGen(channel);
+	FuseUGenInternal* internal = 0;
+	
+	if(root->getNumFusibleOperands() > 0)
+	{
+		FuseCompiler counter(channel, input.getNumChannels());
+		counter.compileOperator(root, 0);
+		
+		if(counter.numInstructions > 1)
+		{
+			UGen* leaves = new UGen[counter.numLeaves];
+			Instruction* instructions = new Instruction[counter.numInstructions];
+			
+			FuseCompiler compiler(channel, input.getNumChannels(), leaves, instructions);
+			compiler.compileOperator(root, 0);
+			ugen_assert(compiler.numInstructions == counter.numInstructions);
+			
+			// the root is always last and can write directly to the output
+			instructions[compiler.numInstructions - 1].output = -1;
+			
+			internal = new FuseUGenInternal(leaves, compiler.numLeaves, 
+											instructions, compiler.numInstructions, 
+											compiler.numRegisters);
+			delete [] leaves;
+			delete [] instructions;
+		}
+	}
+	
+	root->decrementRefCount();
+	return internal;
+}
+
+void FuseUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw()
+{
+	const int blockSize = uGenOutput.getBlockSize();
+	float* const outputSamples = uGenOutput.getSampleData();
+	
+	for(unsigned int i = 0; i < numInputs_; i++)
+		leafSamples[i] = inputs[i].processBlock(shouldDelete, blockID, channel);
+	
+	for(int offset = 0; offset < blockSize; offset += ChunkSize)
+	{
+		const int numSamples = (blockSize - offset) < ChunkSize ? (blockSize - offset) : ChunkSize;
+		
+		for(int i = 0; i < numInstructions; i++)
+		{
+			Instruction const& instruction = instructions[i];
+			
+			const int leftCode = instruction.operands[0];
+			const float* leftSamples = leftCode >= 0 ? leafSamples[leftCode] + offset 
+													 : registers + (-1 - leftCode) * ChunkSize;
+			float* resultSamples = instruction.output < 0 ? outputSamples + offset
+														  : registers + instruction.output * ChunkSize;
+			
+			if(instruction.unaryKernel)
+			{
+				instruction.unaryKernel(leftSamples, resultSamples, numSamples);
+			}
+			else
+			{
+				const int rightCode = instruction.operands[1];
+				const float* rightSamples = rightCode >= 0 ? leafSamples[rightCode] + offset 
+														   : registers + (-1 - rightCode) * ChunkSize;
+				instruction.binaryKernel(leftSamples, rightSamples, resultSamples, numSamples);
+			}
+		}
+	}
+}
+
+Fuse::Fuse(Fuse_InputsWithTypesOnly) throw()
+{
+	initInternal(input.getNumChannels());
+	for(unsigned int i = 0; i < numInternalUGens; i++)
+	{
+		FuseUGenInternal* internal = FuseUGenInternal::create(input, i);
+		
+		if(internal)
+		{
+			internalUGens[i] = internal;
+			internalUGens[i]->initValue(input.getValue(i));
+		}
+		else
+		{
+			// nothing worth fusing, just share the original
+			internalUGens[i] = input.getInternalUGen(i);
+		}
+	}
+}
+
+END_UGEN_NAMESPACE
@@ -0,0 +1,135 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+
+#ifndef _UGEN_ugen_Fuse_H_
+#define _UGEN_ugen_Fuse_H_
+
+#include "../core/ugen_UGen.h"
+#include "ugen_UnaryOpUGens.h"
+#include "ugen_BinaryOpUGens.h"
+
+#define Fuse_InputsWithTypesAndDefaults	UGen const& input
+#define Fuse_InputsWithTypesOnly		UGen const& input
+#define Fuse_InputsNoTypes				input
+
+/** A UGenInternal which evaluates a tree of unary and binary operators as a single 
+ UGenInternal. The tree is compiled into a list of instructions (in postfix order) which 
+ are evaluated in short chunks so the intermediate results stay in a small scratch area 
+ rather than each operator writing a full block to its own output buffer.
+ @see Fuse
+ @ingroup UGenInternals */
+class FuseUGenInternal : public UGenInternal
+{
+public:
+	/** The number of samples evaluated by each pass through the instructions. */
+	enum Constants { ChunkSize = 64 };
+	
+	/** A single operation in the compiled expression.
+	 Operands are leaf (input) indices if positive or registers if negative (encoded 
+	 as -1-register), the output is a register or -1 for the output block. */
+	struct Instruction
+	{
+		UnaryOpUGenInternal::Kernel unaryKernel;
+		BinaryOpUGenInternal::Kernel binaryKernel;
+		int operands[2];
+		int output;
+	};
+	
+	FuseUGenInternal(UGen const* leaves, 
+					 const int numLeaves, 
+					 Instruction const* instructions, 
+					 const int numInstructions, 
+					 const int numRegisters) throw();
+	~FuseUGenInternal();
+	
+	UGenInternal* getChannel(const int channel) throw();
+	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	
+	/** Compiles the operator tree of one channel of a UGen into a FuseUGenInternal.
+	 Returns 0 if there are fewer than two operators to fuse (in which case the
+	 original internal might as well be used). */
+	static FuseUGenInternal* create(UGen const& input, const int channel) throw();
+	
+private:
+	Instruction* instructions;
+	const int numInstructions;
+	const int numRegisters;
+	float* registers;
+	const float** leafSamples;
+};
+
+#define Fuse_Docs	@param input	A UGen expression made of unary and binary operators (e.g., +, *, sin(), squared()) \
+									to evaluate in a single pass. Operators which are not part of the tree (or are \
+									control rate) are treated as ordinary inputs. (Multichannel in and multichannel out.)
+
+/** Evaluates a tree of arithmetic operators in a single UGenInternal.
+ Normally each operator in an expression such as:
+ @code
+	UGen out = (SinOsc::AR(100) * 0.5f + SinOsc::AR(200) * 0.25f).squared() * 0.1f;
+ @endcode
+ ..has its own output block which is written to and then read back by the next operator. 
+ Wrapping the expression in Fuse replaces the operators with a single UGenInternal 
+ which applies each operation to a short chunk of samples in turn. The oscillators and other
+ non-operator UGen instances are processed as normal.
+ @code
+	UGen out = Fuse::AR((SinOsc::AR(100) * 0.5f + SinOsc::AR(200) * 0.25f).squared() * 0.1f);
+ @endcode
+ Operators which are used elsewhere in the graph will be calculated again inside the Fuse
+ so it is best to Fuse expressions whose operators are not shared.
+
+ Fusion is not applied automatically when a graph is built, an expression is only fused
+ if it is wrapped in Fuse. This is because a UGen graph has no separate build step: each
+ operator creates its internal as soon as it is written and the graph may be shared,
+ modified or rendered by any driver so there is no point at which the whole tree can be
+ safely rewritten behind the user's back.
+
+ Other limits:
+ - only audio rate UnaryOpUGenInternal and BinaryOpUGenInternal nodes are fused, control
+   rate operators and all other UGen instances become ordinary inputs;
+ - an operand with a different number of channels to the expression is also treated as
+   an ordinary input;
+ - each operation is still applied by its own per-operator kernel over a chunk of
+   ChunkSize samples, the expression is not compiled into a single per-sample loop, so the
+   saving is in memory traffic and virtual calls rather than arithmetic;
+ - the output is bit-identical to the unfused expression.
+ @ingroup AllUGens MathsUGens */
+UGenSublcassDeclaration(Fuse, (Fuse_InputsNoTypes), (Fuse_InputsWithTypesAndDefaults), COMMON_UGEN_DOCS Fuse_Docs);
+
+
+
+#endif // _UGEN_ugen_Fuse_H_
@@ -41,10 +41,33 @@ BEGIN_UGEN_NAMESPACE
 
 #include "ugen_MixUGen.h"
 
+#ifdef UGEN_SIMD
+	#include "../vec/ugen_simd_Utilities.h"
+#endif
 
-MixUGenInternal::MixUGenInternal(UGen const& array, bool shouldAllowAutoDelete) throw()
+/** sumSamples[i] += inputSamples[i] using Kahan summation. */
+static void mixAccumulateCompensated(const float *inputSamples, float *sumSamples, float *compensationSamples, const int numSamples) throw()
+{
+#if defined(UGEN_SIMD)
+	SIMD::accumulateCompensated(inputSamples, sumSamples, compensationSamples, numSamples);
+#else
+	for(int i = 0; i < numSamples; ++i)
+	{
+		const float sum = sumSamples[i];
+		const float y = inputSamples[i] - compensationSamples[i];
+		const float t = sum + y;
+		compensationSamples[i] = (t - sum) - y;
+		sumSamples[i] = t;
+	}
+#endif
+}
+
+MixUGenInternal::MixUGenInternal(UGen const& array, bool shouldAllowAutoDelete, bool shouldCompensate) throw()
 :	UGenInternal(1),
-	shouldAllowAutoDelete_(shouldAllowAutoDelete)
+	shouldAllowAutoDelete_(shouldAllowAutoDelete),
+	shouldCompensate_(shouldCompensate),
+	compensationSize(shouldCompensate ? ugen::max(1, UGen::getEstimatedBlockSize()) : 0),
+	compensation(shouldCompensate ? new float[compensationSize] : 0)
 {	
 	inputs[0] = array;
 	
@@ -57,15 +80,64 @@ MixUGenInternal::MixUGenInternal(UGen const& array, bool shouldAllowAutoDelete)
 	initValue(value);
 }
 
+MixUGenInternal::~MixUGenInternal()
+{
+	delete [] compensation;
+}
+
 void MixUGenInternal::prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw()
 {
 	(void)channel;
 	inputs[0].prepareForBlock(actualBlockSize, blockID, -1);
 }
 
-#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP)
+void MixUGenInternal::processBlockCompensated(bool& shouldDelete, const unsigned int blockID) throw()
+{
+	bool shouldDeleteLocal = false;
+	bool& shouldDeleteToPass = shouldAllowAutoDelete_ ? shouldDelete : shouldDeleteLocal;	
+	const int numSamplesToProcess = uGenOutput.getBlockSize();
+	float* const outputSamples = uGenOutput.getSampleData();
+	const float* const firstSamples = inputs->processBlock(shouldDeleteToPass, blockID, 0);
+	
+	if(firstSamples != outputSamples) // otherwise it was rendered in place
+		memcpy(outputSamples, firstSamples, numSamplesToProcess * sizeof(float));
+	
+	const int numChannels = inputs->getNumChannels();
+	
+	// the inputs have already been processed for this block after the first chunk
+	for(int offset = 0; offset < numSamplesToProcess; offset += compensationSize)
+	{
+		const int numSamplesThisTime = ugen::min(compensationSize, numSamplesToProcess - offset);
+		memset(compensation, 0, numSamplesThisTime * sizeof(float));
+		
+		for(int channel = 1; channel < numChannels; channel++)
+		{
+			shouldDeleteLocal = false;
+			const float* const channelSamples = inputs->processBlock(shouldDeleteToPass, blockID, channel);
+			mixAccumulateCompensated(channelSamples + offset, outputSamples + offset, compensation, numSamplesThisTime);
+		}
+	}
+}
+
+void MixUGenInternal::addDependencies(UGenDependencies& dependencies, const int /*channel*/) throw()
+{
+	const int numChannels = inputs->getNumChannels();
+	
+	for(int channel = 0; channel < numChannels; channel++)
+	{
+		dependencies.add(*inputs, channel, shouldAllowAutoDelete_);
+	}
+}
+
+#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP) && !defined(UGEN_SIMD)
 void MixUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
 {
+	if(shouldCompensate_)
+	{
+		processBlockCompensated(shouldDelete, blockID);
+		return;
+	}
+	
 	int channel = 0;
 	
 	bool shouldDeleteLocal = false;
@@ -75,9 +147,13 @@ void MixUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockI
 	const float* channelSamples = inputs->processBlock(shouldDeleteToPass, blockID, channel);
 	
 	float* outputSamples = outputSamplesBase;
-	while(numSamplesToProcess--)
+	
+	if(channelSamples != outputSamples) // otherwise it was rendered in place
 	{
-		*outputSamples++ = *channelSamples++;
+		while(numSamplesToProcess--)
+		{
+			*outputSamples++ = *channelSamples++;
+		}
 	}
 	
 	channel++;
@@ -103,14 +179,23 @@ void MixUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockI
 MixArrayUGenInternal::MixArrayUGenInternal(UGenArray const& array, 
 										   bool shouldAllowAutoDelete, 
 										   bool shouldWrapChannels,
-										   const int numChannels) throw()
+										   const int numChannels,
+										   bool shouldCompensate) throw()
 :	ProxyOwnerUGenInternal(0, (numChannels > 0) ? (numChannels-1) : (array.findMaxNumChannels() - 1)),
 	array_(array),
 	shouldAllowAutoDelete_(shouldAllowAutoDelete),
-	shouldWrapChannels_(shouldWrapChannels)
+	shouldWrapChannels_(shouldWrapChannels),
+	shouldCompensate_(shouldCompensate),
+	compensationSize(shouldCompensate ? ugen::max(1, UGen::getEstimatedBlockSize()) : 0),
+	compensation(shouldCompensate ? new float[compensationSize] : 0)
 {	
 }
 
+MixArrayUGenInternal::~MixArrayUGenInternal()
+{
+	delete [] compensation;
+}
+
 void MixArrayUGenInternal::prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw()
 {
 	(void)channel;
@@ -123,6 +208,41 @@ void MixArrayUGenInternal::prepareForBlock(const int actualBlockSize, const unsi
 	}
 }
 
+void MixArrayUGenInternal::processBlockCompensated(bool& shouldDelete, const unsigned int blockID) throw()
+{
+	bool shouldDeleteLocal;
+	bool& shouldDeleteToPass = shouldAllowAutoDelete_ ? shouldDelete : shouldDeleteLocal;	
+	const int numOutputChannels = getNumChannels();
+	const int arraySize = array_.size();
+	const int numSamplesToProcess = uGenOutput.getBlockSize();
+	
+	for(int channel = 0; channel < numOutputChannels; channel++)
+	{
+		float* const outputSamples = proxies[channel]->getSampleData();
+		memset(outputSamples, 0, numSamplesToProcess * sizeof(float));
+		
+		for(int offset = 0; offset < numSamplesToProcess; offset += compensationSize)
+		{
+			const int numSamplesThisTime = ugen::min(compensationSize, numSamplesToProcess - offset);
+			memset(compensation, 0, numSamplesThisTime * sizeof(float));
+			
+			for(int arrayIndex = 0; arrayIndex < arraySize; arrayIndex++)
+			{
+				UGen& ugen = array_[arrayIndex];
+				
+				if(ugen.isNull(channel)) continue;
+				
+				if(shouldWrapChannels_ || (channel < ugen.getNumChannels()))
+				{
+					shouldDeleteLocal = false;
+					const float* const channelSamples = ugen.processBlock(shouldDeleteToPass, blockID, channel);
+					mixAccumulateCompensated(channelSamples + offset, outputSamples + offset, compensation, numSamplesThisTime);
+				}
+			}
+		}
+	}
+}
+
 void MixArrayUGenInternal::releaseInternal() throw()
 {
 	UGenInternal::releaseInternal();
@@ -143,6 +263,25 @@ void MixArrayUGenInternal::stealInternal() throw()
 	}
 }
 
+void MixArrayUGenInternal::addDependencies(UGenDependencies& dependencies, const int /*channel*/) throw()
+{
+	const int numOutputChannels = getNumChannels();
+	const int arraySize = array_.size();
+	
+	for(int channel = 0; channel < numOutputChannels; channel++)
+	{
+		for(int arrayIndex = 0; arrayIndex < arraySize; arrayIndex++)
+		{
+			const UGen& ugen = array_[arrayIndex];
+			
+			if(ugen.isNull(channel)) continue;
+			
+			if(shouldWrapChannels_ || (channel < ugen.getNumChannels()))
+				dependencies.add(ugen, channel, shouldAllowAutoDelete_);
+		}
+	}
+}
+
 float MixArrayUGenInternal::getValue(const int channel) const throw()
 {
 	float value = 0.f;
@@ -160,9 +299,15 @@ float MixArrayUGenInternal::getValue(const int channel) const throw()
 	return value;
 }
 
-#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP)
+#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP) && !defined(UGEN_SIMD)
 void MixArrayUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
 {	    
+	if(shouldCompensate_)
+	{
+		processBlockCompensated(shouldDelete, blockID);
+		return;
+	}
+	
 	bool shouldDeleteLocal;
 	bool& shouldDeleteToPass = shouldAllowAutoDelete_ ? shouldDelete : shouldDeleteLocal;	
 	const int numOutputChannels = getNumChannels();
@@ -200,10 +345,10 @@ void MixArrayUGenInternal::processBlock(bool& shouldDelete, const unsigned int b
 
 
 
-Mix::Mix(UGen const& array, bool shouldAllowAutoDelete) throw()
+Mix::Mix(UGen const& array, bool shouldAllowAutoDelete, bool shouldCompensate) throw()
 {
 	initInternal(1);
-	internalUGens[0] = new MixUGenInternal(array, shouldAllowAutoDelete);
+	internalUGens[0] = new MixUGenInternal(array, shouldAllowAutoDelete, shouldCompensate);
 	
 	float value = 0.f;
 	for(int i = 0; i < array.getNumChannels(); i++)
@@ -214,9 +359,9 @@ Mix::Mix(UGen const& array, bool shouldAllowAutoDelete) throw()
 	internalUGens[0]->initValue(value);
 }
 
-Mix::Mix(UGenArray const& array, bool shouldAllowAutoDelete, bool shouldWrapChannels, const int numChannels) throw()
+Mix::Mix(UGenArray const& array, bool shouldAllowAutoDelete, bool shouldWrapChannels, const int numChannels, bool shouldCompensate) throw()
 {
-	constructMixArrayWithProxies(new MixArrayUGenInternal(array, shouldAllowAutoDelete, shouldWrapChannels, numChannels));
+	constructMixArrayWithProxies(new MixArrayUGenInternal(array, shouldAllowAutoDelete, shouldWrapChannels, numChannels, shouldCompensate));
 }
 
 void Mix::constructMixArrayWithProxies(MixArrayUGenInternal* internal)
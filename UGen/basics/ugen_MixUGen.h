@@ -54,17 +54,33 @@ public:
 	 @param shouldAllowAutoDelete	If true this behaves like most other UGenInternal objects
 									i.e., it may be deleted by a DoneAction (e.g., an envelope
 									ending). If false this protects UGen instances further down the chain
-									(and itself) from being deleted by DoneActions. */
-	MixUGenInternal(UGen const& array, bool shouldAllowAutoDelete = true) throw();
+									(and itself) from being deleted by DoneActions. 
+	 @param shouldCompensate		If true the channels are summed using Kahan summation. */
+	MixUGenInternal(UGen const& array, bool shouldAllowAutoDelete = true, bool shouldCompensate = false) throw();
+	~MixUGenInternal();
 		
 	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
 	
 	/** Render a block of audio. */
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
 	
+	/** Adds all channels of the input. */
+	void addDependencies(UGenDependencies& dependencies, const int channel) throw();
+	
+	/** The first channel of the input may be rendered directly into the output block. */
+	inline bool acceptsInPlaceInput() const throw()		{ return true; }
+	
+	/** The maximum number of input channels summed in one pass over the output. */
+	static const int MaxGroupSize = 8;
+	
+protected:
+	void processBlockCompensated(bool& shouldDelete, const unsigned int blockID) throw();
 	
 private:
 	bool shouldAllowAutoDelete_;
+	bool shouldCompensate_;
+	int compensationSize;	// allocated for the estimated block size, larger blocks are compensated in chunks
+	float* compensation;
 };
 
 /** A UGenInternal which mixes a UGenArray down to a multichannel UGen. 
@@ -90,22 +106,34 @@ public:
 	 @param shouldAllowAutoDelete	If true this behaves like most other UGenInternal objects
 									i.e., it may be deleted by a DoneAction (e.g., an envelope
 									ending). If false this protects UGen instances further down the chain
-									(and itself) from being deleted by DoneActions. */
+									(and itself) from being deleted by DoneActions. 
+	 @param shouldWrapChannels		@see Mix
+	 @param numChannels				@see Mix
+	 @param shouldCompensate		If true the channels are summed using Kahan summation. */
 	MixArrayUGenInternal(UGenArray const& array, 
 						 bool shouldAllowAutoDelete = true, 
 						 bool shouldWrapChannels = true,
-						 const int numChannels = 0) throw();
+						 const int numChannels = 0,
+						 bool shouldCompensate = false) throw();
+	~MixArrayUGenInternal();
 		
 	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	void addDependencies(UGenDependencies& dependencies, const int channel) throw(); // has non-standard inputs 
 	void releaseInternal() throw(); // has non-standard inputs 
 	void stealInternal() throw(); // has non-standard inputs 
 	float getValue(const int channel) const throw();
 	
+protected:
+	void processBlockCompensated(bool& shouldDelete, const unsigned int blockID) throw();
+	
 private:
 	UGenArray array_;
 	bool shouldAllowAutoDelete_;
 	bool shouldWrapChannels_;
+	bool shouldCompensate_;
+	int compensationSize;	// allocated for the estimated block size, larger blocks are compensated in chunks
+	float* compensation;
 };
 
 
@@ -142,15 +170,18 @@ public:
 	 @param shouldAllowAutoDelete	If true this behaves like most other UGen classes
 									i.e., it may be deleted by a DoneAction (e.g., an envelope
 									ending). If false this protects UGen instances further down the chain
-									(and itself) from being deleted by DoneActions. */
-	Mix (UGen const& array, bool shouldAllowAutoDelete = true) throw(); 
+									(and itself) from being deleted by DoneActions. 
+	 @param shouldCompensate		If true the channels are summed using Kahan (compensated) summation
+									which keeps the rounding error low for very wide mixes. This is 
+									slower and the channels are summed one at a time. */
+	Mix (UGen const& array, bool shouldAllowAutoDelete = true, bool shouldCompensate = false) throw(); 
 	
 	
-	/// Audio rate @see Mix (UGen const& array, bool shouldAllowAutoDelete)
-	static inline UGen AR (UGen const& array, bool shouldAllowAutoDelete = true) throw()		{ return Mix (array, shouldAllowAutoDelete);			} 
+	/// Audio rate @see Mix (UGen const& array, bool shouldAllowAutoDelete, bool shouldCompensate)
+	static inline UGen AR (UGen const& array, bool shouldAllowAutoDelete = true, bool shouldCompensate = false) throw()		{ return Mix (array, shouldAllowAutoDelete, shouldCompensate);			} 
 	
-	/// Control rate @see Mix (UGen const& array, bool shouldAllowAutoDelete)
-	static inline UGen KR (UGen const& array, bool shouldAllowAutoDelete = true) throw()		{ return UGen(Mix (array, shouldAllowAutoDelete)).kr(); } 
+	/// Control rate @see Mix (UGen const& array, bool shouldAllowAutoDelete, bool shouldCompensate)
+	static inline UGen KR (UGen const& array, bool shouldAllowAutoDelete = true, bool shouldCompensate = false) throw()		{ return UGen(Mix (array, shouldAllowAutoDelete, shouldCompensate)).kr(); } 
 		
 		
 	/** %Mix a UGenArray to a multichannel UGen using a reference to a UGenArray.
@@ -170,23 +201,28 @@ public:
 	 @param numChannels				Overrides the number of channels generated if greater than 0.
 									The number of channels is normally based on the maximum
 									number of channels found in the UGenArray. This is useful if you want to start
-									with an empty UGenArray and dynamically add/remove UGens. */
+									with an empty UGenArray and dynamically add/remove UGens. 
+	 @param shouldCompensate		If true the channels are summed using Kahan (compensated) summation
+									which keeps the rounding error low for very wide mixes. */
 	Mix (UGenArray const& array, 
 		 bool shouldAllowAutoDelete = true, 
 		 bool shouldWrapChannels = true, 
-		 const int numChannels = 0) throw(); 
+		 const int numChannels = 0,
+		 bool shouldCompensate = false) throw(); 
 	
-	/// Audio rate @see Mix (UGenArray const& array, bool shouldAllowAutoDelete, bool shouldWrapChannels, const int numChannels)
+	/// Audio rate @see Mix (UGenArray const& array, bool shouldAllowAutoDelete, bool shouldWrapChannels, const int numChannels, bool shouldCompensate)
 	static inline UGen AR (UGenArray const& array, 
 						   bool shouldAllowAutoDelete = true, 
 						   bool shouldWrapChannels = true,
-						   const int numChannels = 0) throw()	{ return Mix (array, shouldAllowAutoDelete, shouldWrapChannels, numChannels);			} 
+						   const int numChannels = 0,
+						   bool shouldCompensate = false) throw()	{ return Mix (array, shouldAllowAutoDelete, shouldWrapChannels, numChannels, shouldCompensate);			} 
 	
-	/// Control rate @see Mix (UGenArray const& array, bool shouldAllowAutoDelete, bool shouldWrapChannels, const int numChannels)
+	/// Control rate @see Mix (UGenArray const& array, bool shouldAllowAutoDelete, bool shouldWrapChannels, const int numChannels, bool shouldCompensate)
 	static inline UGen KR (UGenArray const& array, 
 						   bool shouldAllowAutoDelete = true, 
 						   bool shouldWrapChannels = true,
-						   const int numChannels = 0) throw()	{ return UGen(Mix (array, shouldAllowAutoDelete, shouldWrapChannels, numChannels)).kr(); } 
+						   const int numChannels = 0,
+						   bool shouldCompensate = false) throw()	{ return UGen(Mix (array, shouldAllowAutoDelete, shouldWrapChannels, numChannels, shouldCompensate)).kr(); } 
 			
 private:
 	void constructMixArrayWithProxies(MixArrayUGenInternal* internal);
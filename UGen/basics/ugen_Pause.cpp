@@ -69,6 +69,12 @@ UGenInternal* PauseUGenInternal::getChannel(const int channel) throw()
 	return internal;
 }
 
+void PauseUGenInternal::addDependencies(UGenDependencies& dependencies, const int channel) throw()
+{
+	// the input is only processed when the level is non-zero so it isn't scheduled separately
+	dependencies.add(inputs[Level], channel);
+}
+
 void PauseUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw()
 {
 	int numSamplesToProcess = uGenOutput.getBlockSize();
@@ -57,6 +57,7 @@ public:
 	UGenInternal* getChannel(const int channel) throw();									// necessary if there are input ugens which may have more than one channel
 	//UGenInternal* getKr() throw();														// necessary if there is an actual control rate version (see below)
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	void addDependencies(UGenDependencies& dependencies, const int channel) throw();
 	
 	enum Inputs { Input, Level, NumInputs };
 	
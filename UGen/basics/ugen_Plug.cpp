@@ -42,20 +42,56 @@
 BEGIN_UGEN_NAMESPACE
 
 #include "ugen_Plug.h"
+#include "../core/ugen_Atomics.h"
 
+PlugUGenInternal::SourceRequest::SourceRequest(UGen const& source_, const bool releasePreviousSources_, const float fadeTime_) throw()
+:	source(source_),
+	replacement(source_),
+	releasePreviousSources(releasePreviousSources_),
+	fadeTime(fadeTime_),
+	next(0)
+{
+}
 
 PlugUGenInternal::PlugUGenInternal(UGen const& source, bool shouldAllowAutoDelete) throw()
 :	ProxyOwnerUGenInternal(0, source.getNumChannels() - 1),
+	requests(0),
+	spent(0),
+	releasingRequest(0),
+	setSourceLock(0),
+	numPendingRequests(0),
+	numSourcesInUse(0),
 	currentSourceIndex(-1),
 	fadeSourceIndex(-1),
 	shouldAllowAutoDelete_(shouldAllowAutoDelete)
 {	
-	setSource(source, true);
+	SourceRequest initial(source, true, 0.f);
+	applySource(&initial);
+	numSourcesInUse = sources.size();
+}
+
+PlugUGenInternal::~PlugUGenInternal()
+{
+	SourceRequest* request = static_cast<SourceRequest*> (Atomics::exchangePointer(reinterpret_cast<void* volatile&> (requests), 0));
+	
+	while(request != 0)
+	{
+		SourceRequest* next = request->next;
+		delete request;
+		request = next;
+	}
+	
+	delete releasingRequest;
+	reclaimRequests();
 }
 
 void PlugUGenInternal::prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw()
 {
 	(void)channel;
+	
+	if(requests != 0) 
+		applyRequests();
+	
 	const int size = sources.size();
 	for(int i = 0; i < size; i++)
 	{
@@ -95,7 +131,7 @@ void PlugUGenInternal::processBlock(bool& shouldDelete, const unsigned int block
 		{
 			if(fadeSourceIndex != -1)
 			{
-                if(releasePreviousSourcesAfterFade && this->fadeSourceFadeLevel == 1.f)
+                if(releasingRequest != 0 && this->fadeSourceFadeLevel == 1.f)
                 {
                     senderUserData = sources[fadeSourceIndex].userData;
                     sendReleasing((double)fadeTime);
@@ -132,18 +168,20 @@ void PlugUGenInternal::processBlock(bool& shouldDelete, const unsigned int block
 				
 				if(fadeSourceFadeLevel <= 0.f)
 				{
-					if(releasePreviousSourcesAfterFade)
+					if(releasingRequest != 0)
 					{
                         setIsDone();
                         senderUserData = sources[fadeSourceIndex].userData;
                         sendDoneInternal();
                         reset();
                         
-						sources.clear();
-						UGenArray localTemp = sources;
-						sources = tempSource;
+						// the released sources are deleted along with the request by setSource()
+						releasingRequest->faded = sources;
+						sources = releasingRequest->replacement;
 						currentSourceIndex = 0;
-						tempSource = localTemp;
+						numSourcesInUse = sources.size();
+						retireRequest(releasingRequest);
+						releasingRequest = 0;
 					}
                     
 					fadeSourceIndex = -1;
@@ -182,12 +220,116 @@ void PlugUGenInternal::processBlock(bool& shouldDelete, const unsigned int block
 bool PlugUGenInternal::setSource(UGen const& source, const bool releasePreviousSources, const float fadeTime)
 {
 	ugen_assert(fadeTime >= 0.f);
+	
+	while(Atomics::compareAndSwap(setSourceLock, 0, 1) == false)
+		Atomics::pause();
+	
+	reclaimRequests();
+	
+	SourceRequest* request = new SourceRequest(source, releasePreviousSources, fadeTime);
+	
+	if((releasePreviousSources == false) || (fadeTime > 0.f))
+	{
+		// the audio thread updates the number of sources before the pending count so reading 
+		// them in this order can only overestimate, each pending request adds at most one source
+		const int numPending = numPendingRequests;
+		Atomics::memoryBarrier();
+		const int numSources = numSourcesInUse;
+		
+		request->grown.reserve(numSources + numPending + 1);
+	}
+	
+	Atomics::increment(numPendingRequests);
+	
+	SourceRequest* head;
+	
+	do 
+	{
+		head = requests;
+		request->next = head;
+	}
+	while(Atomics::compareAndSwapPointer(reinterpret_cast<void* volatile&> (requests), head, request) == false);
+	
+	Atomics::memoryBarrier();
+	setSourceLock = 0;
+	
+	return true;
+}
+
+void PlugUGenInternal::applyRequests() throw()
+{
+	SourceRequest* request = static_cast<SourceRequest*> (Atomics::exchangePointer(reinterpret_cast<void* volatile&> (requests), 0));
+	
+	// the requests were pushed in reverse order
+	SourceRequest* ordered = 0;
+	
+	while(request != 0)
+	{
+		SourceRequest* next = request->next;
+		request->next = ordered;
+		ordered = request;
+		request = next;
+	}
+	
+	while(ordered != 0)
+	{
+		SourceRequest* next = ordered->next;
+		
+		if(applySource(ordered) == false)
+			retireRequest(ordered); // otherwise it is kept until its crossfade ends
+		
+		numSourcesInUse = sources.size();
+		Atomics::memoryBarrier();
+		Atomics::decrement(numPendingRequests);
+		
+		ordered = next;
+	}
+}
+
+void PlugUGenInternal::retireRequest(SourceRequest* request) throw()
+{
+	SourceRequest* head;
+	
+	do 
+	{
+		head = spent;
+		request->next = head;
+	}
+	while(Atomics::compareAndSwapPointer(reinterpret_cast<void* volatile&> (spent), head, request) == false);
+}
+
+void PlugUGenInternal::reclaimRequests() throw()
+{
+	SourceRequest* request = static_cast<SourceRequest*> (Atomics::exchangePointer(reinterpret_cast<void* volatile&> (spent), 0));
+	
+	while(request != 0)
+	{
+		SourceRequest* next = request->next;
+		delete request;
+		request = next;
+	}
+}
+
+bool PlugUGenInternal::applySource(SourceRequest* request) throw()
+{
+	UGen const& source = request->source;
+	const bool releasePreviousSources = request->releasePreviousSources;
+	const float fadeTime = request->fadeTime;
+	
     this->fadeTime = fadeTime;
 	
+	if(releasingRequest != 0)
+	{
+		// a new change cancels a release waiting for the end of a crossfade
+		retireRequest(releasingRequest);
+		releasingRequest = 0;
+	}
+	
 	if(releasePreviousSources == true && fadeTime <= 0.f)
 	{
 		fadeSourceIndex = -1;
-		sources = UGenArray(source);
+		request->retired = sources;
+		sources = request->replacement;
 		currentSourceIndex = 0;
 	}
 	else
@@ -206,18 +348,28 @@ bool PlugUGenInternal::setSource(UGen const& source, const bool releasePreviousS
 		
 		if(indexOfExistingSource == -1)
 		{
-			sources.add(source);
-			currentSourceIndex++;
+			// setSource() reserved enough space so this doesn't allocate
+			UGenArray& grown = request->grown;
+			
+			for(int i = 0; i < sources.size(); i++)
+				grown.add(sources[i]);
+			
+			grown.add(source);
+			request->retired = sources;
+			sources = grown;
+			currentSourceIndex = sources.size() - 1;
 		}
 		else
 			currentSourceIndex = indexOfExistingSource;
 		
-		releasePreviousSourcesAfterFade = releasePreviousSources;
-		if(releasePreviousSourcesAfterFade == true && fadeTime > 0.f)
-			tempSource = UGenArray(source);
+		if(releasePreviousSources == true && fadeTime > 0.f)
+		{
+			releasingRequest = request;
+			return true;
+		}
 	}
 	
-	return true;
+	return false;
 }
 
 UGen& PlugUGenInternal::getSource()
@@ -49,6 +49,7 @@ class PlugUGenInternal : public ProxyOwnerUGenInternal,
 {
 public:
 	PlugUGenInternal(UGen const& source, bool shouldAllowAutoDelete = true) throw();
+	~PlugUGenInternal();
 	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
 	
@@ -58,8 +59,18 @@ public:
 	/**
 	 Change the source of the Plug.
 	 
-	 Be careful when calling this from a separate thread from the audio processing thread
-	 and use locks appropriately. Previous sources are retained by default so that their
+	 This is safe to call from any thread without locking the audio thread. The change is 
+	 queued and picked up at the start of the next block (in prepareForBlock()). Any array
+	 the audio thread needs is allocated here (for the new source on its own, or with space
+	 for the previous sources too) so applying the change doesn't allocate. Any sources (and 
+	 arrays) released by the change, including those released at the end of a crossfade, are 
+	 kept until the next call to setSource() (or until the Plug is deleted) so they are 
+	 destroyed on the calling thread rather than the audio thread. Since the sources are then 
+	 referenced from two threads SmartPointer::setAtomicRefCounts() should be enabled (the 
+	 JuceIOHost does this). Calls from different threads are serialised with a spin lock which
+	 the audio thread never takes.
+	 
+	 Previous sources are retained by default so that their
 	 processing still continues should the Plug be switched back to  a previous source
 	 in the future. This means (for example) a soundfile playing back will not start where
 	 it had reach just before the source was switched but will start where it would have 
@@ -72,15 +83,44 @@ public:
 	 */
 	bool setSource(UGen const& source, const bool releasePreviousSources = false, const float fadeTime = 0.f);
 		
+	/** Get the current source.
+	 A change made by setSource() isn't returned until it has been applied at the start 
+	 of the next block. */
 	UGen& getSource();
 	
 protected:
+	/** A source change waiting to be applied on the audio thread. */
+	class SourceRequest
+	{
+	public:
+		SourceRequest(UGen const& source, const bool releasePreviousSources, const float fadeTime) throw();
+		
+		UGen source;
+		UGenArray replacement;			// built on the calling thread so applying doesn't allocate
+		UGenArray grown;				// reserved on the calling thread for the previous sources and this one
+		UGenArray retired;				// the sources array replaced, deleted along with the request
+		UGenArray faded;				// the sources released at the end of the crossfade
+		const bool releasePreviousSources;
+		const float fadeTime;
+		SourceRequest* next;
+	};
+	
+	bool applySource(SourceRequest* request) throw();
+	void applyRequests() throw();
+	void retireRequest(SourceRequest* request) throw();
+	void reclaimRequests() throw();
+	
+	SourceRequest* volatile requests;	// pushed by setSource() on any thread
+	SourceRequest* volatile spent;		// applied requests waiting to be deleted by setSource()
+	SourceRequest* releasingRequest;	// the request whose crossfade releases the previous sources when it ends
+	volatile int setSourceLock;			// serialises setSource() calls, never taken by the audio thread
+	volatile int numPendingRequests;	// requests not yet applied
+	volatile int numSourcesInUse;		// the size of sources, published by the audio thread
+
 	UGenArray sources;
 	int currentSourceIndex;
 	int fadeSourceIndex;
 	float currentSourceFadeLevel, fadeSourceFadeLevel, fadeTime, deltaFade;
-	bool releasePreviousSourcesAfterFade;
-	UGenArray tempSource;
 	bool shouldAllowAutoDelete_;
 };
 
@@ -96,7 +96,7 @@ ScalarUGenInternal::ScalarUGenInternal(const float value) throw()
 }
 
 
-#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP)
+#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP) && !defined(UGEN_SIMD)
 void ScalarUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
 {		
 	int numSamplesToProcess = uGenOutput.getBlockSize();
@@ -119,7 +119,7 @@ FloatPtrUGenInternal::FloatPtrUGenInternal(float const *valuePtr) throw()
 {
 }
 
-#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP)
+#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP) && !defined(UGEN_SIMD)
 void FloatPtrUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
 {
 	PtrUGenProcessBlock();
@@ -132,7 +132,7 @@ DoublePtrUGenInternal::DoublePtrUGenInternal(double const *valuePtr) throw()
 {	
 }
 
-#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP)
+#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP) && !defined(UGEN_SIMD)
 void DoublePtrUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
 {
 	PtrUGenProcessBlock();
@@ -146,7 +146,7 @@ IntPtrUGenInternal::IntPtrUGenInternal(int const *valuePtr) throw()
 {
 }
 
-#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP)
+#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP) && !defined(UGEN_SIMD)
 void IntPtrUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
 {
 	PtrUGenProcessBlock();
@@ -160,7 +160,7 @@ BoolPtrUGenInternal::BoolPtrUGenInternal(bool const *valuePtr) throw()
 {
 }
 
-#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP)
+#if !defined(UGEN_VFP) && !defined(UGEN_NEON) && !defined(UGEN_VDSP) && !defined(UGEN_SIMD)
 void BoolPtrUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
 {
 	int numSamplesToProcess = uGenOutput.getBlockSize();
@@ -124,6 +124,8 @@
 			UGenInternal* getKr() throw();																						\
 			void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();						\
 			float getValue(const int channel) const throw();																	\
+			Kernel getKernel() const throw();																					\
+			static void processSamples(const float* operandSamples, float* outputSamples, const int numSamples) throw();		\
 		};																														\
 		/** Control rate internal for Unary##OPNAME##UGen. @ingroup UGenInternals */											\
 		class Unary##OPNAME##UGenInternalK : public Unary##OPNAME##UGenInternal													\
@@ -132,6 +134,7 @@
 			Unary##OPNAME##UGenInternalK(UGen const& operand) throw();															\
 			UGenInternal* getKr() throw() {  incrementRefCount(); return this; }												\
 			void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();						\
+			Kernel getKernel() const throw() { return 0; }																		\
 		private:																												\
 			float value;																										\
 		};																														\
@@ -203,6 +206,20 @@
 			return OPFUNCTION_INTERNAL(inputs[Operand].getValue(channel));														\
 		}																														\
 																																\
+		void Unary##OPNAME##UGenInternal::processSamples(const float* operandSamples,											\
+														  float* outputSamples,													\
+														  const int numSamples) throw()											\
+		{																														\
+			for(int i = 0; i < numSamples; ++i) {																				\
+				outputSamples[i] = OPFUNCTION_INTERNAL(operandSamples[i]);														\
+			}																													\
+		}																														\
+																																\
+		UnaryOpUGenInternal::Kernel Unary##OPNAME##UGenInternal::getKernel() const throw()										\
+		{																														\
+			return processSamples;																								\
+		}																														\
+																																\
 		Unary##OPNAME##UGenInternalK::Unary##OPNAME##UGenInternalK(UGen const& operand) throw()									\
 		:	Unary##OPNAME##UGenInternal(operand), value(0.f)																	\
 		{																														\
@@ -311,6 +328,14 @@ public:
 	
 	enum Inputs { Operand, NumInputs };
 	
+	/** A function which applies the operation to a block of samples. */
+	typedef void (*Kernel)(const float* operandSamples, float* outputSamples, const int numSamples);
+	
+	/** Returns the Kernel for this operation or 0 if it can't be applied sample-by-sample
+	 (e.g., control rate versions). This is used by Fuse to combine trees of operations. */
+	virtual Kernel getKernel() const throw() { return 0; }
+	int getNumFusibleOperands() const throw() { return (isControlRateOnly() == false && getKernel() != 0) ? 1 : 0; }
+	
 protected:
 };
 
@@ -44,6 +44,9 @@ BEGIN_UGEN_NAMESPACE
 #include "../core/ugen_Random.h"
 #include "../core/ugen_Value.h"
 #include "../basics/ugen_UnaryOpUGens.h"
+#include "ugen_Resampler.h"
+#include "ugen_MappedAudioFile.h"
+#include "../core/ugen_Atomics.h"
 #if defined(UGEN_IPHONE) || defined(DOXYGEN)
 	#include "../iphone/ugen_NSUtilities.h"
 #endif
@@ -57,23 +60,41 @@ static inline void reportDataPtr(const float* ptr, const int size) throw()
 }
 #endif
 
+BufferDataInternal::BufferDataInternal(const unsigned int size, const bool zeroData) throw()
+:	data(size > 0 ? new float[size] : 0),
+	size_(size)
+{
+	makeRefCountAtomic();
+	
+	if(zeroData && (size_ > 0))
+		memset(data, 0, size_ * sizeof(float));
+}
+
+BufferDataInternal::~BufferDataInternal() throw()
+{
+	delete [] data;
+	data = 0;
+	size_ = 0;
+}
+
 BufferChannelInternal::BufferChannelInternal(const unsigned int size, bool zeroData) throw()
 :	data(0),
 	size_(size),
 	allocatedSize(size),
 	currentWriteBlockID((unsigned int)-1), //FIMXE
-	circularHead(-1), previousCircularHead(-1)
+	circularHead(-1), previousCircularHead(-1),
+	dataOwner(0),
+	numWriters(0)
 {
 //	ugen_assert(size > 0);
 	
+	makeRefCountAtomic();
+	
 	if(size_ > 0)
 	{
-		data = new float[size_];
-		
-		if(zeroData)
-		{	
-			memset(data, 0, size_ * sizeof(float));
-		}
+		BufferDataInternal* storage = new BufferDataInternal(size_, zeroData);
+		dataOwner = storage;
+		data = storage->getData();
 	}
 	
 #ifdef BUFFERTESTMEMORY
@@ -89,16 +110,22 @@ BufferChannelInternal::BufferChannelInternal(const unsigned int size,
 	size_(size),
 	allocatedSize(0),
 	currentWriteBlockID((unsigned int)-1), // FIXME
-	circularHead(-1), previousCircularHead(-1)
+	circularHead(-1), previousCircularHead(-1),
+	dataOwner(0),
+	numWriters(0)
 {
 	ugen_assert(size > 0);
 	ugen_assert(sourceDataSize > 0);
 	ugen_assert(sourceData != 0);
 	
+	makeRefCountAtomic();
+	
 	if(copyTheData)
 	{
+		BufferDataInternal* storage = new BufferDataInternal(size_);
+		dataOwner = storage;
 		allocatedSize = size_;
-		data = new float[allocatedSize];
+		data = storage->getData();
 		
 		if(size > sourceDataSize)
 		{
@@ -125,11 +152,18 @@ BufferChannelInternal::BufferChannelInternal(const unsigned int size, const doub
 :	size_(size),
 	allocatedSize(size),
 	currentWriteBlockID((unsigned int)-1), //FIXME
-	circularHead(-1), previousCircularHead(-1)
+	circularHead(-1), previousCircularHead(-1),
+	dataOwner(0),
+	numWriters(0)
 {
 	ugen_assert(size >= 2);
 	
-	data = new float[size_];
+	makeRefCountAtomic();
+	
+	BufferDataInternal* storage = new BufferDataInternal(size_);
+	dataOwner = storage;
+	data = storage->getData();
+	
 	double inc = (end - start) / (size_ - 1);
 	double currentValue = start;
 	float *outputSamples = data;
@@ -146,11 +180,35 @@ BufferChannelInternal::BufferChannelInternal(const unsigned int size, const doub
 #endif	
 }
 
+BufferChannelInternal::BufferChannelInternal(const unsigned int size, float* sourceData, SmartPointer* dataOwnerToUse) throw()
+:	data(sourceData),
+	size_(size),
+	allocatedSize(0),
+	currentWriteBlockID((unsigned int)-1), // FIXME
+	circularHead(-1), previousCircularHead(-1),
+	dataOwner(dataOwnerToUse),
+	numWriters(0)
+{
+	ugen_assert(sourceData != 0);
+	
+	makeRefCountAtomic();
+	
+	if(dataOwner != 0)
+		dataOwner->incrementRefCount();
+	
+#ifdef BUFFERTESTMEMORY
+	reportDataPtr(data, size_);
+#endif	
+}
+
 BufferChannelInternal::~BufferChannelInternal() throw()
 {
-	if(allocatedSize > 0)
-		delete [] data;
+	// allocated data is owned by a BufferDataInternal, other data is either owned by 
+	// something else (e.g., a MappedAudioFile) or by the caller who passed it in
+	if(dataOwner != 0)
+		dataOwner->decrementRefCount();
 	
+	dataOwner = 0;
 	data = 0;
 	size_= 0;
 	allocatedSize = 0;
@@ -159,6 +217,33 @@ BufferChannelInternal::~BufferChannelInternal() throw()
 	previousCircularHead = -1;
 }
 
+void BufferChannelInternal::makeUnique() throw()
+{
+	ugen_assert(dataOwner != 0);
+	
+	BufferDataInternal* storage = new BufferDataInternal(size_);
+	
+	if(size_ > 0)
+		memcpy(storage->getData(), data, size_ * sizeof(float));
+	
+	dataOwner->decrementRefCount();
+	dataOwner = storage;
+	data = storage->getData();
+	allocatedSize = size_;
+}
+
+void BufferChannelInternal::addWriter() throw()
+{
+	Atomics::increment(numWriters);
+	getDataForWriting();
+}
+
+void BufferChannelInternal::removeWriter() throw()
+{
+	ugen_assert(numWriters > 0);
+	Atomics::decrement(numWriters);
+}
+
 Buffer::Buffer() throw()
 :	numChannels_(0),
 	size_(0),
@@ -430,6 +515,85 @@ Buffer::Buffer(BufferChannelInternal *internalToUse) throw()
 	channels[0] = internalToUse;
 }
 
+Buffer::Buffer(MappedAudioFile* mappedFile) throw()
+:	numChannels_(0),
+	size_(0),
+	channels(0)
+{
+	initFromMappedFile(mappedFile);
+}
+
+Buffer Buffer::mapFile(Text const& audioFilePath, double* sampleRate, int* bits) throw()
+{
+	Buffer buffer;
+	const double fileSampleRate = buffer.initFromMappedFile(audioFilePath.getArray(), bits);
+	
+	if(sampleRate) 
+		*sampleRate = fileSampleRate;
+	
+	return buffer;
+}
+
+double Buffer::initFromMappedFile(const char* audioFilePath, int *bits) throw()
+{
+	// copy-on-write so a Buffer referring to the mapping directly may still be written
+	MappedAudioFile* mappedFile = new MappedAudioFile(audioFilePath, true);
+	const double fileSampleRate = initFromMappedFile(mappedFile, bits);
+	mappedFile->decrementRefCount();
+	
+	if(fileSampleRate == 0.0)
+		printf("Buffer: error: Could not open file: %s (only uncompressed WAV, AIFF and CAF are supported)\n", audioFilePath);
+	
+	return fileSampleRate;
+}
+
+double Buffer::initFromMappedFile(MappedAudioFile* mappedFile, int *bits) throw()
+{
+	ugen_assert(channels == 0);
+	
+	if((mappedFile == 0) || !mappedFile->isValid() || (mappedFile->getNumFrames() <= 0) || (mappedFile->getNumFrames() > INT_MAX))
+		return 0.0;
+	
+	if(bits) 
+		*bits = mappedFile->getBitsPerSample();
+	
+	float* mappedSamples = mappedFile->isCopyOnWrite() ? mappedFile->getMonoFloatData() : 0;
+	
+	numChannels_ = mappedFile->getNumChannels();
+	size_ = (int)mappedFile->getNumFrames();
+	channels = new BufferChannelInternal*[numChannels_];
+	
+	if(mappedSamples != 0)
+	{
+		channels[0] = new BufferChannelInternal(size_, mappedSamples, mappedFile);
+	}
+	else
+	{
+		float** destinations = new float*[numChannels_];
+		
+		for(int channel = 0; channel < numChannels_; channel++)
+			channels[channel] = new BufferChannelInternal(size_, false);
+		
+		// ask for the next region to be paged in while this one is converted
+		const int regionFrames = 65536;
+		mappedFile->prefetch(0, regionFrames);
+		
+		for(int startFrame = 0; startFrame < size_; startFrame += regionFrames)
+		{
+			mappedFile->prefetch(startFrame + regionFrames, regionFrames);
+			
+			for(int channel = 0; channel < numChannels_; channel++)
+				destinations[channel] = channels[channel]->data + startFrame;
+			
+			mappedFile->read(destinations, startFrame, regionFrames);
+		}
+		
+		delete [] destinations;
+	}
+	
+	return mappedFile->getSampleRate();
+}
+
 #if defined(UGEN_JUCE)
 #include "../juce/ugen_JuceUtility.h"
 Buffer::Buffer(AudioSampleBuffer& audioSampleBuffer, const bool copyTheData) throw()
@@ -1588,6 +1752,86 @@ bool Buffer::initFromAudioFileAiff32(const char* audioFilePath,
 	return true;
 }
 
+#else // neither Juce or CoreAudio so use the native codec in MappedAudioFile
+
+Buffer::Buffer(const char *audioFilePath, int *bits, double* sampleRate, MetaData* metaData) throw()
+:	numChannels_(0),
+	size_(0),
+	channels(0)
+{
+	ugen_assert(metaData == 0); // meta data is not supported by the native codec
+	(void)metaData;
+	
+	if(!sampleRate)
+	{
+		double fileSampleRate = initFromMappedFile(audioFilePath, bits);
+		double currentSampleRate = UGen::getSampleRate();
+		
+		if((fileSampleRate != 0.0) && (fileSampleRate != currentSampleRate))
+			operator= (changeSampleRate(fileSampleRate, currentSampleRate));
+	}
+	else
+	{
+		*sampleRate = initFromMappedFile(audioFilePath, bits);
+	}
+}
+
+Buffer::Buffer(Text const& audioFilePath, int *bits, double* sampleRate, MetaData* metaData) throw()
+:	numChannels_(0),
+	size_(0),
+	channels(0)
+{
+	ugen_assert(metaData == 0); // meta data is not supported by the native codec
+	(void)metaData;
+	
+	if(!sampleRate)
+	{
+		double fileSampleRate = initFromMappedFile(audioFilePath.getArray(), bits);
+		double currentSampleRate = UGen::getSampleRate();
+		
+		if((fileSampleRate != 0.0) && (fileSampleRate != currentSampleRate))
+			operator= (changeSampleRate(fileSampleRate, currentSampleRate));
+	}
+	else
+	{
+		*sampleRate = initFromMappedFile(audioFilePath.getArray(), bits);
+	}
+}
+
+bool Buffer::write(Text const& audioFilePath, 
+				   bool overwriteExisitingFile, 
+				   int bitDepth,
+				   MetaData const& metaData) throw()
+{
+	ugen_assert(bitDepth >= 8);
+	
+	if(metaData.getNumCuePoints() > 0)
+		printf("Buffer: warning: meta data is not supported by the native codec\n");
+	
+	const Text pathChecked = MappedAudioFile::getFileType(audioFilePath.getArray()) == MappedAudioFile::UnknownType 
+						   ? audioFilePath + ".wav" 
+						   : audioFilePath;
+	
+	const float** channelData = new const float*[numChannels_ > 0 ? numChannels_ : 1];
+	
+	for(int channel = 0; channel < numChannels_; channel++)
+		channelData[channel] = getDataUnchecked(channel);
+	
+	const bool result = MappedAudioFile::write(pathChecked.getArray(), 
+											   channelData, 
+											   numChannels_, 
+											   size_, 
+											   UGen::getSampleRate(), 
+											   bitDepth, 
+											   overwriteExisitingFile);
+	delete [] channelData;
+	
+	if(!result)
+		printf("Buffer: error: writing file %s\n", pathChecked.getArray());
+	
+	return result;
+}
+
 #endif
 
 
@@ -1620,6 +1864,55 @@ void Buffer::decrementInternals() throw()
 	}
 }
 
+void Buffer::swapWith(Buffer& other) throw()
+{
+	const int tempNumChannels = numChannels_;
+	const int tempSize = size_;
+	BufferChannelInternal** tempChannels = channels;
+	
+	numChannels_ = other.numChannels_;
+	size_ = other.size_;
+	channels = other.channels;
+	
+	other.numChannels_ = tempNumChannels;
+	other.size_ = tempSize;
+	other.channels = tempChannels;
+}
+
+void Buffer::makeUnique() throw()
+{
+	for(int channel = 0; channel < numChannels_; channel++)
+	{
+		channels[channel]->getDataForWriting();
+	}
+}
+
+void Buffer::addWriter() throw()
+{
+	for(int channel = 0; channel < numChannels_; channel++)
+	{
+		channels[channel]->addWriter();
+	}
+}
+
+void Buffer::removeWriter() throw()
+{
+	for(int channel = 0; channel < numChannels_; channel++)
+	{
+		channels[channel]->removeWriter();
+	}
+}
+
+bool Buffer::isShared() const throw()
+{
+	for(int channel = 0; channel < numChannels_; channel++)
+	{
+		if(channels[channel]->isShared()) return true;
+	}
+	
+	return false;
+}
+
 Buffer Buffer::interleave() throw()
 {
 	if(size_ < 1 || numChannels_ < 1) return Buffer();
@@ -1711,13 +2004,28 @@ Buffer::Buffer(Buffer const& copy) throw()
 
 Buffer Buffer::copy() const throw()
 {
-	Buffer newBuffer = Buffer::withSize(size_, numChannels_, false);
+	if(size_ <= 0 || numChannels_ <= 0) 
+		return Buffer::withSize(size_, numChannels_, false);
+	
+	Buffer newBuffer;
+	newBuffer.numChannels_ = numChannels_;
+	newBuffer.size_ = size_;
+	newBuffer.channels = new BufferChannelInternal*[numChannels_];
 	
-	if(size_ > 0 && numChannels_ > 0) 
+	for(int channel = 0; channel < numChannels_; channel++) 
 	{
-		for(int channel = 0; channel < numChannels_; channel++) 
+		BufferChannelInternal* internal = channels[channel];
+		
+		if((internal->dataOwner != 0) && (internal->size_ == (unsigned int)size_) && (internal->numWriters == 0))
+		{
+			// share the data until one of them is written to
+			newBuffer.channels[channel] = new BufferChannelInternal(size_, internal->data, internal->dataOwner);
+		}
+		else
 		{
-			memcpy(newBuffer.getData(channel), getData(channel), size_ * sizeof(float));
+			// we only refer to this data so it might change or go away, or a UGen writes to 
+			// it on the audio thread which mustn't be left to take a private copy
+			newBuffer.channels[channel] = new BufferChannelInternal(size_, internal->size_, internal->data, true);
 		}
 	}
 	
@@ -1743,12 +2051,13 @@ void Buffer::referTo(const int channel, float* data, const int sourceSize) throw
 	
 	BufferChannelInternal* internal = channels[channel];
 	
-	if(internal->allocatedSize > 0)
+	if(internal->dataOwner != 0)
 	{
-		delete [] internal->data;
-		internal->allocatedSize = 0;
+		internal->dataOwner->decrementRefCount();
+		internal->dataOwner = 0;
 	}
 	
+	internal->allocatedSize = 0;
 	internal->data = data;
 	
 	if(sourceSize > 0)
@@ -2469,7 +2778,7 @@ Buffer Buffer::changeSampleRate(const double oldSampleRate, const double newSamp
 	}
 	else
 	{
-		return resample(size_ * (newSampleRate / oldSampleRate));
+		return Resampler::process(*this, oldSampleRate, newSampleRate);
 	}
 }
 
@@ -3171,4 +3480,27 @@ void BufferReceiver::removeBufferSender(BufferSender* const sender) throw()
 	senders.removeItem(sender);
 }
 
+AtomicBufferReceiver::AtomicBufferReceiver() throw()
+:	numSwapsAcquired(0)
+{
+}
+
+void AtomicBufferReceiver::handleBuffer(Buffer const& buffer, const double /*value1*/, const int /*value2*/)
+{
+	slot.publish(new Buffer(buffer));
+}
+
+bool AtomicBufferReceiver::acquireBuffer(Buffer& buffer) throw()
+{
+	Buffer* published = slot.acquire();
+	
+	if((published == 0) || (slot.getNumSwaps() == numSwapsAcquired))
+		return false;
+	
+	// the slot keeps the Buffer being replaced until it's retired by the next publish()
+	numSwapsAcquired = slot.getNumSwaps();
+	buffer.swapWith(*published);
+	return true;
+}
+
 END_UGEN_NAMESPACE
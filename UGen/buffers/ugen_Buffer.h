@@ -44,6 +44,7 @@
 #include "../envelopes/ugen_EnvCurve.h"
 #include "../core/ugen_Arrays.h"
 #include "../core/ugen_Text.h"
+#include "../core/ugen_AtomicSlot.h"
 
 class CuePointInternal : public SmartPointer
 {
@@ -266,12 +267,39 @@ public:
 };
 
 
+/** Sample memory for one channel of a Buffer.
+ 
+ This may be shared by several BufferChannelInternal objects, Buffer::copy() shares it
+ rather than copying the samples. It is copied on write: a channel which is about to be 
+ written to while its data is shared takes a private copy first. The reference count is
+ always atomic so buffers may be built, copied and released on different threads. */
+class BufferDataInternal : public SmartPointer
+{
+public:
+	BufferDataInternal(const unsigned int size, const bool zeroData = false) throw();
+	~BufferDataInternal() throw();
+	
+	inline float* getData() throw()				{ return data;	}
+	inline unsigned int size() const throw()	{ return size_;	}
+	
+private:
+	float* data;
+	unsigned int size_;
+	
+	BufferDataInternal (const BufferDataInternal&);
+    const BufferDataInternal& operator= (const BufferDataInternal&);
+};
+
 class BufferChannelInternal : public SmartPointer
 {
 public:
 	BufferChannelInternal(const unsigned int size, bool zeroData = false) throw();
 	BufferChannelInternal(const unsigned int size, const unsigned int sourceDataSize, float* sourceData, const bool copyTheData) throw();
 	BufferChannelInternal(const unsigned int size, const double start, const double end) throw();
+	
+	/** Refer to data owned by another object, this keeps a reference to the owner
+	 (e.g., a MappedAudioFile) until this is deleted. */
+	BufferChannelInternal(const unsigned int size, float* sourceData, SmartPointer* dataOwner) throw();
 	~BufferChannelInternal() throw();
 	
 	inline float getSampleUnchecked(const int index) const throw() { return data[index]; }
@@ -300,6 +328,25 @@ public:
 //	}
 	
 	
+	/** Get the data to write to, taking a private copy first if it is shared with a copy of this channel. */
+	inline float* getDataForWriting() throw()
+	{
+		if((dataOwner != 0) && (dataOwner->getRefCount() > 1))
+			makeUnique();
+		
+		return data;
+	}
+	
+	/** Returns true if the data is shared with another channel (and will be copied when written to). */
+	inline bool isShared() const throw() { return (dataOwner != 0) && (dataOwner->getRefCount() > 1); }
+	
+	/** Register a UGen which writes to this channel on the audio thread.
+	 This takes a private copy now if the data is shared and, until the matching removeWriter(), 
+	 Buffer::copy() copies the data straight away rather than sharing it. So the writer never 
+	 has to take a private copy (allocating and copying) on the audio thread. */
+	void addWriter() throw();
+	void removeWriter() throw();
+	
 	friend class Buffer;
 	friend class PartBuffer;
 	friend class ComplexBuffer;
@@ -307,12 +354,16 @@ public:
 	friend class TapOutUGenInternal;
 	
 private:
+	void makeUnique() throw();
+	
 	float* data;
 	unsigned int size_;
 	unsigned int allocatedSize;
 	unsigned int currentWriteBlockID;
 	int circularHead; // -1 means it is not a crcular buffer
 	int previousCircularHead;
+	SmartPointer* dataOwner;
+	volatile int numWriters;
 	
 	BufferChannelInternal (const BufferChannelInternal&);
     const BufferChannelInternal& operator= (const BufferChannelInternal&);
@@ -342,6 +393,7 @@ class Value;
 class ValueArray;
 class UGen;
 class BufferReceiver;
+class MappedAudioFile;
 
 /**
  Buffer stores one or more arrays of floats.
@@ -560,7 +612,8 @@ public:
 	 @param graph		The audio graph to process to synthesise the audio Buffer.	
 	 @param offset		The start sample within the Buffer.
 	 @param numSamples	The number of samples to process, 0 means all remaining samples. 
-	 @param allAtOnce	If true the processing is done all in one go, if false it may yield the current thread.  */	
+	 @param allAtOnce	If true the processing is done all in one go, if false it may yield the current thread.
+	 @see OfflineRenderer */	
 	void synthInPlace(UGen const& graph, 
 					  const int offset = 0, 
 					  const int numSamples = 0, 
@@ -589,8 +642,25 @@ public:
 	/** Constuct a single-channel Buffer from another BufferChannelInternal. */
 	Buffer(BufferChannelInternal *internalToUse) throw();
 	
+	/** Constuct a Buffer from a memory mapped audio file.
+	 If the file is mono 32-bit float in the native byte order and was mapped copy-on-write 
+	 the Buffer refers to the mapped pages directly. So this is immediate whatever the size of 
+	 the file, pages are read on demand and are shared with other processes until they are 
+	 written. Otherwise the samples are converted from the mapping into new memory (a region at
+	 a time, prefetching the next region while converting). The Buffer keeps its own reference
+	 to the file. */
+	Buffer(MappedAudioFile* mappedFile) throw();
+	
+	/** Map an audio file and construct a Buffer from it (see Buffer(MappedAudioFile*)).
+	 The data is not converted to the current sample rate.
+	 @param audioFilePath	The path to an uncompressed WAV, AIFF or CAF file.
+	 @param sampleRate		If not 0 this is set to the sample rate of the file.
+	 @param bits			If not 0 this is set to the bit depth of the file. */
+	static Buffer mapFile(Text const& audioFilePath, double* sampleRate = 0, int* bits = 0) throw();
+	
 	/** Constuct a Buffer from an audio file on disk. 
-	 Formats available are dependent on platform. */
+	 Formats available are dependent on platform (uncompressed WAV, AIFF and CAF
+	 where neither Juce or CoreAudio are used, see MappedAudioFile). */
 	Buffer(const char *audioFilePath, int *bits = 0, double* sampleRate = 0, MetaData* metaData = 0) throw();
 	
 	/** Constuct a Buffer from an audio file on disk returning the sampleRate to the caller. 
@@ -648,6 +718,10 @@ protected:
 
 public:
 #endif
+protected:
+	double initFromMappedFile(MappedAudioFile* mappedFile, int *bits = 0) throw();
+	double initFromMappedFile(const char* audioFilePath, int *bits = 0) throw();
+public:
 	/** Constuct a Buffer from two other buffers by combining the channels. 
 	 Here the result will be the size of the largest input Buffer. The
 	 number of channels will be the sum of the channels in the two input
@@ -660,9 +734,15 @@ public:
 	 pointer(s) and increments the reference count(s). */
 	Buffer(Buffer const& copy) throw();
 	
-	/** Make a deep copy of this Buffer. 
-	 This always makes a deep copy of the raw data to which the Buffer refers.
-	 This also applies to data which refers to another source. */
+	/** Make a copy of this Buffer which doesn't share its data with this one.
+	 The samples aren't copied straight away, the copy shares them until either 
+	 Buffer writes to them at which point the one being written takes a private copy 
+	 (see getData()). So copying is cheap even for long sound files and a copy may be
+	 played on another thread while this one is changed. Data which this Buffer only
+	 refers to (e.g., from referTo() or from an array passed in without copying it)
+	 is always copied straight away, as are channels a UGen writes to (e.g., the Buffer
+	 of a RecordBuf or TapIn, see addWriter()) so the writer never has to take its 
+	 private copy on the audio thread. */
 	Buffer copy() const throw();
 	
 	/** Assignment. */
@@ -700,6 +780,11 @@ public:
 	/** @internal */
 	void decrementInternals() throw();	
 	
+	/** Exchange the contents of this Buffer with another. 
+	 This doesn't allocate or change any reference counts so can be used on the audio thread
+	 (e.g., to swap in a Buffer which was published from another thread). */
+	void swapWith(Buffer& other) throw();
+	
 	/// @} <!-- end Construction and destruction ------------------------------------------------------ -->
 
 	
@@ -777,8 +862,10 @@ public:
 	
 	/** Return a pointer to the floating point data for a particular channel of this Buffer.
 	 Channel indices are wrapped when the number of channels in the Buffer is exceed (so
-	 channel index 2 in a 2-channel buffer would return data for channel 0). */
-	inline float* getData(const int channel = 0) throw()								{ ugen_assert(channel >= 0); return channels[channel % numChannels_]->data; }
+	 channel index 2 in a 2-channel buffer would return data for channel 0). 
+	 As the data may be written to this takes a private copy of the channel first if its
+	 data is shared with a copy() of this Buffer, use getDataReadOnly() to avoid this. */
+	inline float* getData(const int channel = 0) throw()								{ ugen_assert(channel >= 0); return channels[channel % numChannels_]->getDataForWriting(); }
 	
 	/** Return a pointer to the floating point data for a particular channel of this Buffer.
 	 Channel indices are wrapped when the number of channels in the Buffer is exceed (so
@@ -786,13 +873,35 @@ public:
 	inline const float* getData(const int channel = 0) const throw()					{ ugen_assert(channel >= 0); return channels[channel % numChannels_]->data; }
 	
 	/** Return a pointer to the floating point data for a particular channel of this Buffer.
-	 Channel indices MUST be in range. */	
-	inline float* getDataUnchecked(const int channel = 0) throw()						{ ugen_assert(channel >= 0); return channels[channel]->data; }
+	 Channel indices MUST be in range. This takes a private copy of shared data like getData(). */	
+	inline float* getDataUnchecked(const int channel = 0) throw()						{ ugen_assert(channel >= 0); return channels[channel]->getDataForWriting(); }
 	
 	/** Return a pointer to the floating point data for a particular channel of this Buffer.
 	 Channel indices MUST be in range. */	
 	inline const float* getDataUnchecked(const int channel = 0) const throw()			{ ugen_assert(channel >= 0); return channels[channel]->data; }
 	
+	/** Return a pointer to the floating point data for a particular channel of this Buffer to read from.
+	 Unlike the non-const getData() this never copies shared data so it's the one to use for 
+	 reading from a Buffer member on the audio thread. Channel indices are wrapped. */	
+	inline const float* getDataReadOnly(const int channel = 0) const throw()			{ ugen_assert(channel >= 0); return channels[channel % numChannels_]->data; }
+	
+	/** Make sure none of the channels share their data with a copy() of this Buffer.
+	 Writing to shared data takes a private copy first, calling this beforehand
+	 means this allocation doesn't happen later (e.g., on the audio thread). */
+	void makeUnique() throw();
+	
+	/** Returns true if any of the channels share their data with a copy() of this Buffer. */
+	bool isShared() const throw();
+	
+	/** Register a UGen which writes to all the channels of this Buffer on the audio thread.
+	 This calls makeUnique() and, until the matching removeWriter(), copy() copies the data 
+	 straight away rather than sharing it. UGens which write to their Buffer (e.g., RecordBuf 
+	 and TapIn) call this when they are constructed and removeWriter() when they are deleted. */
+	void addWriter() throw();
+	
+	/** Unregister a writer added with addWriter(). */
+	void removeWriter() throw();
+	
 	/** Return the number of channels in this Buffer. */
 	inline int getNumChannels() const throw()											{ return numChannels_; }
 	
@@ -820,7 +929,7 @@ public:
 	inline void setSample(const int channel, const int sampleIndex, const float value) const throw()	
 	{ 
 		if(sampleIndex >= 0 && sampleIndex < size_) 
-			channels[channel]->data[sampleIndex] = value;
+			channels[channel]->getDataForWriting()[sampleIndex] = value;
 	}
 	
 	inline float getSample(const int channel, const int sampleIndex) const throw()	
@@ -851,7 +960,7 @@ public:
 	{ 
 		ugen_assert(sampleIndex >= 0 && sampleIndex < size_);
 		
-		channels[0]->data[sampleIndex] = value;
+		channels[0]->getDataForWriting()[sampleIndex] = value;
 	}
 	
 	inline void setSampleUnchecked(const int channel, const int sampleIndex, const float value) const throw()	
@@ -859,7 +968,7 @@ public:
 		ugen_assert(channel >= 0 && channel < numChannels_);
 		ugen_assert(sampleIndex >= 0 && sampleIndex < size_);
 		
-		channels[channel]->data[sampleIndex] = value;
+		channels[channel]->getDataForWriting()[sampleIndex] = value;
 	}
 	
 	inline float getSampleUnchecked(const int channel, const int sampleIndex) const throw()	
@@ -1089,7 +1198,17 @@ public:
 					EnvCurve const& fadeInShape  = EnvCurve::Linear, 
 					EnvCurve const& fadeOutShape = EnvCurve::Linear) const throw();
 	
+	/** Resample to a new size using linear interpolation.
+	 The first and last samples are aligned with those of the original (e.g., for 
+	 wavetables and windows), use changeSampleRate() to resample audio. */
 	Buffer resample(const int newSize) const throw();
+	
+	/** Resample audio from one sample rate to another.
+	 This uses band-limited polyphase interpolation (at Resampler::Medium quality), 
+	 audio files loaded at a different sample rate to the host are converted with this.
+	 @param oldSampleRate	The sample rate of this Buffer.
+	 @param newSampleRate	The new sample rate, 0 uses the current UGen::getSampleRate().
+	 @see Resampler */
 	Buffer changeSampleRate(const double oldSampleRate, const double newSampleRate = 0.0) const throw();
 	
 	Buffer reverse() const throw();
@@ -1132,7 +1251,8 @@ public:
 	 @param graph	The audio graph to process the audio with input at the top.
 	 @param offset		The start sample within the Buffer.
 	 @param numSamples	The number of samples to process, 0 means all remaining samples. 
-	 @param allAtOnce	If true the processing is done all in one go, if false it may yield the current thread.  */
+	 @param allAtOnce	If true the processing is done all in one go, if false it may yield the current thread.
+	 @see OfflineRenderer */
 	void processInPlace(UGen const& input, 
 						UGen const& graph, 
 						const int offset = 0, 
@@ -1374,6 +1494,46 @@ protected:
 	BufferSenderArray senders;
 };
 
+/** A BufferReceiver which hands the Buffers it receives to the audio thread without locks.
+ 
+ UGenInternal classes which play from a Buffer (e.g., PlayBuf and TableOsc) use this so 
+ a loader thread can build a new Buffer and publish it to them while they are playing:
+ 
+ @code
+	BufferSender loader;
+	UGen player = PlayBuf::AR(Buffer::mapFile("first.wav"), 1, 0, 0, 1);
+	player.addBufferSender(&loader);
+	
+	// later on the loader thread
+	loader.sendBuffer(Buffer::mapFile("second.wav"));
+ @endcode
+ 
+ handleBuffer() only takes a reference to the Buffer (the sample data isn't copied) and 
+ the UGenInternal swaps it in at the start of its next block. The Buffer it replaces is 
+ released by the publishing thread the next time it sends a Buffer (or when the UGenInternal
+ is deleted) so the audio thread doesn't free the sample memory. Buffers must be sent to 
+ the same receiver from only one thread at a time.
+ 
+ @see AtomicSlot, Buffer::copy() */
+class AtomicBufferReceiver : public BufferReceiver
+{
+public:
+	AtomicBufferReceiver() throw();
+	
+	/** Publish a Buffer to be swapped in by acquireBuffer(). */
+	void handleBuffer(Buffer const& buffer, const double value1, const int value2);
+	
+protected:
+	/** Swap the contents of @c buffer with the Buffer most recently published, if there is a new one.
+	 This is for the audio thread, it doesn't block or allocate.
+	 @return true if a new Buffer was swapped in. */
+	bool acquireBuffer(Buffer& buffer) throw();
+	
+private:
+	AtomicSlot<Buffer> slot;
+	int numSwapsAcquired;
+};
+
 
 #endif // _UGEN_ugen_Buffer_H_
 	
\ No newline at end of file
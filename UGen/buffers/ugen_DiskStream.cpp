@@ -0,0 +1,712 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#include "../core/ugen_StandardHeader.h"
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_DiskStream.h"
+#include "../core/ugen_Atomics.h"
+#include "../core/ugen_Bits.h"
+
+//============================= MappedAudioFileSource ==========================
+
+MappedAudioFileSource* MappedAudioFileSource::open(const char* path) throw()
+{
+	MappedAudioFile* file = new MappedAudioFile(path);
+	
+	if(file->isValid() == false || file->getNumChannels() <= 0)
+	{
+		file->decrementRefCount();
+		return 0;
+	}
+	
+	return new MappedAudioFileSource(file);
+}
+
+MappedAudioFileSource::MappedAudioFileSource(MappedAudioFile* fileToUse) throw()
+:	file(fileToUse)
+{
+}
+
+MappedAudioFileSource::~MappedAudioFileSource()
+{
+	file->decrementRefCount();
+}
+
+int MappedAudioFileSource::read(float* const* destinations, const long startFrame, const int numFrames) throw()
+{
+	return file->read(destinations, startFrame, numFrames);
+}
+
+void MappedAudioFileSource::prefetch(const long startFrame, const int numFrames) throw()
+{
+	file->prefetch(startFrame, numFrames);
+}
+
+//================================= DiskStream =================================
+
+DiskStream::DiskStream(DiskStreamSource* sourceToUse, 
+					   const int bufferFrames, 
+					   const bool shouldLoop, 
+					   const long loopStartFrameToUse, 
+					   const long startFrame) throw()
+:	source(sourceToUse),
+	streamer(0),
+	next(0),
+	numChannels(sourceToUse->getNumChannels()),
+	numFrames(sourceToUse->getNumFrames()),
+	sampleRate(sourceToUse->getSampleRate()),
+	capacity(Bits::nextPowerOf2(ugen::max(1024, bufferFrames))),
+	mask(capacity - 1),
+	loop(shouldLoop),
+	loopStartFrame((loopStartFrameToUse >= 0 && loopStartFrameToUse < numFrames) ? loopStartFrameToUse : 0),
+	ring(BufferSpec(capacity, numChannels, true)),
+	ringChannels(new float*[numChannels]),
+	channelPointers(new float*[numChannels]),
+	writeTotal(0),
+	readTotal(0),
+	ended(0),
+	released(0),
+	seekRequest(0),
+	seekAcknowledged(0),
+	seekFrame(0),
+	seekAcknowledgedFrame(0),
+	discardTotal(0),
+	readerSeek(0),
+	filePosition(ugen::max(0L, startFrame)),
+	readFrame(ugen::max(0L, startFrame)),
+	phase(0.0),
+	refillThreshold(capacity / 2),
+	consumptionRate(sampleRate),
+	lastServiceTime(UGenThread::getMillisecondCounterHiRes()),
+	lastServiceReadTotal(0),
+	numUnderruns(0),
+	numUnderrunFrames(0)
+{
+	for(int channel = 0; channel < numChannels; channel++)
+		ringChannels[channel] = ring.getData(channel);
+	
+	// nobody else can see the stream yet so prime the ring on this thread
+	fill(capacity);
+}
+
+DiskStream::~DiskStream()
+{
+	delete source;
+	delete [] ringChannels;
+	delete [] channelPointers;
+}
+
+bool DiskStream::synchronise() throw()
+{
+	const int acknowledged = seekAcknowledged;
+	
+	if(acknowledged != seekRequest) 
+		return false; // the I/O thread hasn't seen the latest seek yet
+	
+	if(acknowledged != readerSeek)
+	{
+		// frames before discardTotal were from the old position
+		Atomics::memoryBarrier();
+		readFrame = seekAcknowledgedFrame;
+		readTotal = discardTotal;
+		phase = 0.0;
+		readerSeek = acknowledged;
+	}
+	
+	return true;
+}
+
+void DiskStream::clear(float* const* outputs, const int offset, const int numFramesToClear) throw()
+{
+	if(numFramesToClear <= 0) return;
+	
+	for(int channel = 0; channel < numChannels; channel++)
+		memset(outputs[channel] + offset, 0, numFramesToClear * sizeof(float));
+}
+
+void DiskStream::underrun(const int numFramesMissed) throw()
+{
+	numUnderruns++;
+	numUnderrunFrames += numFramesMissed;
+	
+	if(streamer != 0)
+	{
+		Atomics::increment(streamer->totalUnderruns);
+		streamer->wake();
+	}
+}
+
+void DiskStream::advance(const unsigned int numFramesToAdvance) throw()
+{
+	if(numFramesToAdvance == 0) return;
+	
+	long frame = readFrame + numFramesToAdvance;
+	
+	if(loop && numFrames > 0)
+	{
+		while(frame >= numFrames)
+			frame = loopStartFrame + (frame - numFrames);
+	}
+	
+	readFrame = frame;
+	
+	// finish reading the frames before handing them back to the I/O thread
+	Atomics::memoryBarrier();
+	readTotal = readTotal + numFramesToAdvance;
+	
+	if((streamer != 0) && ((int)(writeTotal - readTotal) < refillThreshold) && !ended)
+		streamer->wake();
+}
+
+int DiskStream::read(float* const* outputs, const int numFramesToRead) throw()
+{
+	if(synchronise() == false)
+	{
+		clear(outputs, 0, numFramesToRead);
+		return 0;
+	}
+	
+	const unsigned int available = writeTotal - readTotal;
+	Atomics::memoryBarrier(); // read the frames only after reading the count
+	
+	const int numFramesRead = (int)ugen::min(available, (unsigned int)numFramesToRead);
+	const int start = readTotal & mask;
+	const int numFramesFirst = ugen::min(numFramesRead, capacity - start);
+	const int numFramesSecond = numFramesRead - numFramesFirst;
+	
+	for(int channel = 0; channel < numChannels; channel++)
+	{
+		const float * const ringSamples = ringChannels[channel];
+		memcpy(outputs[channel], ringSamples + start, numFramesFirst * sizeof(float));
+		memcpy(outputs[channel] + numFramesFirst, ringSamples, numFramesSecond * sizeof(float));
+	}
+	
+	if(numFramesRead < numFramesToRead)
+	{
+		clear(outputs, numFramesRead, numFramesToRead - numFramesRead);
+		
+		if(!ended) 
+			underrun(numFramesToRead - numFramesRead);
+	}
+	
+	advance(numFramesRead);
+	
+	return numFramesRead;
+}
+
+int DiskStream::read(float* const* outputs, const int numFramesToRead, const float* rates, const double rateScale) throw()
+{
+	if(rateScale == 1.0 && phase == 0.0)
+	{
+		int i = 0;
+		while(i < numFramesToRead && rates[i] == 1.f)
+			i++;
+		
+		if(i == numFramesToRead)
+			return read(outputs, numFramesToRead);
+	}
+	
+	if(synchronise() == false)
+	{
+		clear(outputs, 0, numFramesToRead);
+		return 0;
+	}
+	
+	unsigned int available = writeTotal - readTotal;
+	Atomics::memoryBarrier(); // read the frames only after reading the count
+	
+	unsigned int position = readTotal;
+	int i;
+	
+	for(i = 0; i < numFramesToRead; i++)
+	{
+		if(available < 2) 
+			break; // two frames are needed to interpolate
+		
+		const int index0 = position & mask;
+		const int index1 = (position + 1) & mask;
+		const float fraction = (float)phase;
+		
+		for(int channel = 0; channel < numChannels; channel++)
+		{
+			const float * const ringSamples = ringChannels[channel];
+			const float value0 = ringSamples[index0];
+			outputs[channel][i] = value0 + (ringSamples[index1] - value0) * fraction;
+		}
+		
+		const double increment = rates[i] * rateScale;
+		
+		if(increment > 0.0)
+		{
+			phase += increment;
+			
+			const unsigned int wholeFrames = ugen::min((unsigned int)phase, available);
+			phase -= wholeFrames;
+			position += wholeFrames;
+			available -= wholeFrames;
+		}
+	}
+	
+	if(i < numFramesToRead)
+	{
+		clear(outputs, i, numFramesToRead - i);
+		
+		if(!ended)
+		{
+			underrun(numFramesToRead - i);
+		}
+		else
+		{
+			// the last frame of the source has nothing to interpolate to
+			position += available;
+			phase = 0.0;
+		}
+	}
+	
+	advance(position - readTotal);
+	
+	return i;
+}
+
+void DiskStream::setPosition(const long frame) throw()
+{
+	seekFrame = frame;
+	Atomics::memoryBarrier();
+	Atomics::increment(seekRequest);
+	
+	if(streamer != 0)
+		streamer->wake();
+}
+
+bool DiskStream::isFinished() const throw()
+{
+	const int acknowledged = seekAcknowledged;
+	
+	return ended && 
+		   (acknowledged == seekRequest) && 
+		   (acknowledged == readerSeek) && 
+		   (writeTotal == readTotal);
+}
+
+void DiskStream::release() throw()
+{
+	if(streamer == 0)
+	{
+		delete this; // never added to a streamer
+		return;
+	}
+	
+	DiskStreamer* const streamerToWake = streamer;
+	Atomics::memoryBarrier();
+	released = 1;
+	streamerToWake->wake();
+}
+
+int DiskStream::fill(const int maxFrames) throw()
+{
+	int numFramesFilled = 0;
+	
+	while((numFramesFilled < maxFrames) && !ended)
+	{
+		const int space = capacity - (int)(writeTotal - readTotal);
+		
+		if(space <= 0) 
+			break;
+		
+		if((numFrames > 0) && (filePosition >= numFrames))
+		{
+			if(loop)
+			{
+				filePosition = loopStartFrame;
+			}
+			else
+			{
+				Atomics::memoryBarrier();
+				ended = 1;
+				break;
+			}
+		}
+		
+		const int start = writeTotal & mask;
+		const int numFramesThisTime = ugen::min(ugen::min(maxFrames - numFramesFilled, space), capacity - start);
+		
+		for(int channel = 0; channel < numChannels; channel++)
+			channelPointers[channel] = ringChannels[channel] + start;
+		
+		const int numFramesRead = source->read(channelPointers, filePosition, numFramesThisTime);
+		
+		if(numFramesRead > 0)
+		{
+			filePosition += numFramesRead;
+			numFramesFilled += numFramesRead;
+			
+			// publish the frames only after they have been written
+			Atomics::memoryBarrier();
+			writeTotal = writeTotal + numFramesRead;
+		}
+		
+		if(numFramesRead < numFramesThisTime)
+		{
+			if(loop && (numFrames > 0) && !(numFramesRead <= 0 && filePosition == loopStartFrame))
+			{
+				filePosition = loopStartFrame;
+			}
+			else
+			{
+				// the end of the source (or a read error)
+				Atomics::memoryBarrier();
+				ended = 1;
+			}
+		}
+	}
+	
+	return numFramesFilled;
+}
+
+int DiskStream::service(const double now, const double readAheadTime, const bool urgentOnly) throw()
+{
+	const int request = seekRequest;
+	
+	if(request != seekAcknowledged)
+	{
+		Atomics::memoryBarrier();
+		
+		long frame = ugen::max(0L, (long)seekFrame);
+		
+		if(numFrames > 0 && frame >= numFrames)
+			frame = loop ? loopStartFrame : numFrames;
+		
+		filePosition = frame;
+		ended = 0;
+		seekAcknowledgedFrame = frame;
+		discardTotal = writeTotal;
+		
+		Atomics::memoryBarrier();
+		seekAcknowledged = request;
+	}
+	
+	// the read-ahead follows the reader's consumption (e.g., its playback rate)
+	const double elapsed = now - lastServiceTime;
+	
+	if(elapsed >= 50.0)
+	{
+		const unsigned int total = readTotal;
+		const double instantRate = (double)(total - lastServiceReadTotal) * 1000.0 / elapsed;
+		consumptionRate = consumptionRate * 0.7 + instantRate * 0.3;
+		lastServiceTime = now;
+		lastServiceReadTotal = total;
+	}
+	
+	const int readAheadFrames = (int)ugen::min(consumptionRate * readAheadTime, (double)capacity);
+	refillThreshold = ugen::clip(readAheadFrames, capacity / 4, capacity * 3 / 4);
+	
+	const int available = (int)(writeTotal - readTotal);
+	
+	if(ended || (available >= capacity) || (urgentOnly && (available >= refillThreshold)))
+		return 0;
+	
+	const int chunkSize = ugen::max(1024, capacity / 4);
+	const int numFramesFilled = fill(chunkSize);
+	
+	if(numFramesFilled > 0)
+		source->prefetch(filePosition, chunkSize);
+	
+	return numFramesFilled;
+}
+
+//================================ DiskStreamer ================================
+
+DiskStreamer* volatile DiskStreamer::instance = 0;
+
+DiskStreamer::DiskStreamer() throw()
+:	incoming(0),
+	streams(0),
+	wakePending(0),
+	readAheadTime(0.5),
+	numStreams(0),
+	totalUnderruns(0),
+	totalFramesRead(0.0)
+{
+}
+
+DiskStreamer::~DiskStreamer()
+{
+	stopThread();
+	adoptNewStreams();
+	
+	while(streams != 0)
+	{
+		DiskStream* const stream = streams;
+		streams = stream->next;
+		delete stream;
+	}
+}
+
+DiskStreamer& DiskStreamer::getInstance() throw()
+{
+	DiskStreamer* streamer = instance;
+	
+	if(streamer == 0)
+	{
+		DiskStreamer* newStreamer = new DiskStreamer();
+		
+		if(Atomics::compareAndSwapPointer(reinterpret_cast<void* volatile&> (instance), 0, newStreamer))
+		{
+			if(newStreamer->startThread() == false)
+				printf("DiskStreamer: error: could not start the I/O thread\n");
+			else
+				newStreamer->setRealtimePriority();
+			
+			streamer = newStreamer;
+		}
+		else
+		{
+			// another thread created it first
+			delete newStreamer;
+			streamer = instance;
+		}
+	}
+	
+	return *streamer;
+}
+
+void DiskStreamer::shutdown() throw()
+{
+	DiskStreamer* streamer = (DiskStreamer*)Atomics::exchangePointer(reinterpret_cast<void* volatile&> (instance), 0);
+	delete streamer;
+}
+
+void DiskStreamer::add(DiskStream* stream) throw()
+{
+	if(stream == 0) return;
+	
+	stream->streamer = this;
+	
+	DiskStream* head;
+	
+	do
+	{
+		head = incoming;
+		stream->next = head;
+	}
+	while(Atomics::compareAndSwapPointer(reinterpret_cast<void* volatile&> (incoming), head, stream) == false);
+	
+	Atomics::increment(numStreams);
+	wake();
+}
+
+void DiskStreamer::wake() throw()
+{
+	if(Atomics::compareAndSwap(wakePending, 0, 1))
+		wakeSemaphore.signal();
+}
+
+void DiskStreamer::signalThreadShouldExit() throw()
+{
+	UGenThread::signalThreadShouldExit();
+	wakeSemaphore.signal();
+}
+
+void DiskStreamer::adoptNewStreams() throw()
+{
+	DiskStream* stream = (DiskStream*)Atomics::exchangePointer(reinterpret_cast<void* volatile&> (incoming), 0);
+	
+	while(stream != 0)
+	{
+		DiskStream* const nextStream = stream->next;
+		stream->next = streams;
+		streams = stream;
+		stream = nextStream;
+	}
+}
+
+int DiskStreamer::serviceStreams(const bool urgentOnly) throw()
+{
+	const double now = getMillisecondCounterHiRes();
+	int numFramesFilled = 0;
+	DiskStream* previous = 0;
+	DiskStream* stream = streams;
+	
+	while(stream != 0)
+	{
+		DiskStream* const nextStream = stream->next;
+		
+		if(stream->released)
+		{
+			if(previous == 0)
+				streams = nextStream;
+			else
+				previous->next = nextStream;
+			
+			Atomics::memoryBarrier();
+			delete stream;
+			Atomics::decrement(numStreams);
+		}
+		else
+		{
+			numFramesFilled += stream->service(now, readAheadTime, urgentOnly);
+			previous = stream;
+		}
+		
+		stream = nextStream;
+	}
+	
+	totalFramesRead += numFramesFilled;
+	
+	return numFramesFilled;
+}
+
+void DiskStreamer::run()
+{
+	while(threadShouldExit() == false)
+	{
+		wakePending = 0;
+		Atomics::memoryBarrier();
+		
+		adoptNewStreams();
+		
+		// streams running low first, then top up the rest
+		int numFramesFilled = serviceStreams(true);
+		numFramesFilled += serviceStreams(false);
+		
+		if(numFramesFilled == 0)
+			wakeSemaphore.wait();
+	}
+}
+
+//============================== DiskInUGenInternal ============================
+
+DiskInUGenInternal::DiskInUGenInternal(DiskStreamSource* source,
+									   UGen const& rate,
+									   const bool loopFlag, 
+									   const double startTime, 
+									   const int bufferFrames,
+									   const UGen::DoneAction doneAction) throw()
+:	ProxyOwnerUGenInternal(NumInputs, source->getNumChannels() - 1),
+	stream(0),
+	outputPointers(new float*[source->getNumChannels()]),
+	loopFlag_(loopFlag),
+	rateScale(source->getSampleRate() > 0.0 ? source->getSampleRate() * UGen::getReciprocalSampleRate() : 1.0),
+	doneAction_(doneAction),
+	shouldDeleteValue(doneAction_ == UGen::DeleteWhenDone)
+{
+	ugen_assert(source->getNumChannels() > 0);
+	ugen_assert(bufferFrames > 0);
+	
+	inputs[Rate] = rate;
+	
+	const long startFrame = (long)(ugen::max(0.0, startTime) * source->getSampleRate());
+	stream = new DiskStream(source, bufferFrames, loopFlag, startFrame, startFrame);
+	DiskStreamer::getInstance().add(stream);
+}
+
+DiskInUGenInternal::~DiskInUGenInternal() throw()
+{
+	stream->release();
+	delete [] outputPointers;
+}
+
+void DiskInUGenInternal::prepareForBlock(const int /*actualBlockSize*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
+{
+	senderUserData = userData;
+	if(isDone()) sendDoneInternal();
+}
+
+void DiskInUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
+{
+	const int blockSize = uGenOutput.getBlockSize();
+	const float* rateSamples = inputs[Rate].processBlock(shouldDelete, blockID, 0);
+	
+	for(int channel = 0; channel < getNumChannels(); channel++)
+		outputPointers[channel] = proxies[channel]->getSampleData();
+	
+	stream->read(outputPointers, blockSize, rateSamples, rateScale);
+	
+	if(!loopFlag_ && stream->isFinished())
+	{
+		shouldDelete = shouldDelete ? true : shouldDeleteValue;
+		setIsDone();
+	}
+}
+
+double DiskInUGenInternal::getDuration() const throw()
+{
+	return stream->getSampleRate() > 0.0 ? stream->getNumFrames() / stream->getSampleRate() : 0.0;
+}
+
+double DiskInUGenInternal::getPosition() const throw()
+{
+	return stream->getSampleRate() > 0.0 ? stream->getPosition() / stream->getSampleRate() : 0.0;
+}
+
+bool DiskInUGenInternal::setPosition(const double newPosition) throw()
+{
+	stream->setPosition((long)(ugen::max(0.0, newPosition) * stream->getSampleRate()));
+	return true;
+}
+
+#if !defined(UGEN_JUCE) && !defined(UGEN_IPHONE)
+
+DiskIn::DiskIn(Text const& path, 
+			   const bool loopFlag, 
+			   const double startTime, 
+			   const int numFrames,
+			   const UGen::DoneAction doneAction,
+			   UGen const& rate) throw()
+{
+	DiskStreamSource* source = MappedAudioFileSource::open(path.getArray());
+	
+	if(source == 0)
+	{
+		printf("DiskIn: error: Could not open file: %s (only uncompressed WAV, AIFF and CAF are supported)\n", path.getArray());
+		return;
+	}
+	
+	initInternal(source->getNumChannels());
+	generateFromProxyOwner(new DiskInUGenInternal(source, 
+												  rate.mix(), 
+												  loopFlag, 
+												  startTime, 
+												  numFrames, 
+												  doneAction));
+}
+
+#endif
+
+END_UGEN_NAMESPACE
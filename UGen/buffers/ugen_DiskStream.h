@@ -0,0 +1,400 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#ifndef _UGEN_ugen_DiskStream_H_
+#define _UGEN_ugen_DiskStream_H_
+
+
+#include "../core/ugen_UGen.h"
+#include "../core/ugen_Threads.h"
+#include "ugen_Buffer.h"
+#include "ugen_MappedAudioFile.h"
+
+/** A source of audio frames for a DiskStream.
+ 
+ read() is only ever called from one thread at a time (the DiskStreamer's I/O thread 
+ once the stream is running) so implementations needn't be thread safe. 
+ 
+ @see DiskStream, MappedAudioFileSource */
+class DiskStreamSource
+{
+public:
+	DiskStreamSource() throw() {}
+	virtual ~DiskStreamSource() {}
+	
+	virtual int getNumChannels() const throw() = 0;
+	virtual long getNumFrames() const throw() = 0;
+	virtual double getSampleRate() const throw() = 0;
+	
+	/** Read frames into separate channel arrays.
+	 @return The number of frames read, fewer than numFrames only at the end of the source. */
+	virtual int read(float* const* destinations, const long startFrame, const int numFrames) throw() = 0;
+	
+	/** A hint that the frames after a read will be needed soon. */
+	virtual void prefetch(const long startFrame, const int numFrames) throw() { (void)startFrame; (void)numFrames; }
+	
+	/** Whether reads come from a memory mapping rather than file reads. */
+	virtual bool isMemoryMapped() const throw() { return false; }
+	
+private:
+	DiskStreamSource (const DiskStreamSource&);
+    const DiskStreamSource& operator= (const DiskStreamSource&);
+};
+
+/** A DiskStreamSource reading a memory mapped WAV or AIFF file. 
+ @see MappedAudioFile */
+class MappedAudioFileSource : public DiskStreamSource
+{
+public:
+	/** Open and map a file, returns 0 if the file isn't an uncompressed WAV or AIFF. */
+	static MappedAudioFileSource* open(const char* path) throw();
+	~MappedAudioFileSource();
+	
+	int getNumChannels() const throw()		{ return file->getNumChannels();	}
+	long getNumFrames() const throw()		{ return file->getNumFrames();		}
+	double getSampleRate() const throw()	{ return file->getSampleRate();		}
+	bool isMemoryMapped() const throw()		{ return true;						}
+	
+	int read(float* const* destinations, const long startFrame, const int numFrames) throw();
+	void prefetch(const long startFrame, const int numFrames) throw();
+	
+private:
+	MappedAudioFileSource(MappedAudioFile* file) throw();
+	MappedAudioFile* file;
+};
+
+class DiskStreamer;
+
+/** A ring buffer streaming frames from a DiskStreamSource.
+ 
+ A DiskStream has one reader (normally a UGen on the audio thread) and is filled by the 
+ DiskStreamer's I/O thread. The ring is lock-free with a single producer and single consumer: 
+ the reader and the I/O thread each only advance their own frame count. Seeking is requested 
+ from the reader side and acknowledged by the I/O thread which then tells the reader which 
+ frames to discard, so neither side ever waits for the other.
+ 
+ The reader owns the DiskStream until it calls release(), after that the I/O thread deletes
+ it (and the source) so no file operations or deallocation happen on the audio thread. 
+ 
+ @see DiskStreamer, DiskInUGenInternal */
+class DiskStream
+{
+public:
+	/** Create a stream. This reads the first frames into the ring on the calling thread. 
+	 @param source			The source, the stream takes ownership of this.
+	 @param bufferFrames	The size of the ring (rounded up to a power of 2).
+	 @param loop			Whether to loop back to loopStartFrame at the end of the source.
+	 @param loopStartFrame	The frame to loop back to.
+	 @param startFrame		The frame to start reading from. */
+	DiskStream(DiskStreamSource* source, 
+			   const int bufferFrames, 
+			   const bool loop, 
+			   const long loopStartFrame, 
+			   const long startFrame) throw();
+	~DiskStream();
+	
+	/// @name Reader
+	/// @{
+	
+	/** Copy frames at normal speed.
+	 @param outputs		An array of getNumChannels() pointers each with space for numFrames.
+	 @param numFrames	The number of frames to read.
+	 @return			The number of frames read, the remaining outputs are cleared. */
+	int read(float* const* outputs, const int numFrames) throw();
+	
+	/** Read frames at a varying rate using linear interpolation.
+	 @param outputs		An array of getNumChannels() pointers each with space for numFrames.
+	 @param numFrames	The number of frames to write to the outputs.
+	 @param rates		The playback rate for each output frame (negative rates are treated as 0).
+	 @param rateScale	A factor applied to the rates (e.g., to convert the source's sample rate).
+	 @return			The number of output frames written, the remaining outputs are cleared. */
+	int read(float* const* outputs, const int numFrames, const float* rates, const double rateScale) throw();
+	
+	/** Request a move to a new frame, this may be called from any thread. 
+	 The reader outputs silence until the I/O thread has refilled the ring from the new position. */
+	void setPosition(const long frame) throw();
+	
+	/** The source frame the reader will read next. */
+	inline long getPosition() const throw()				{ return readFrame;									}
+	
+	/** Whether the end of a non-looping source has been reached and all its frames read. */
+	bool isFinished() const throw();
+	
+	/** Give the stream to the I/O thread for deletion, the stream must not be used after this. */
+	void release() throw();
+	
+	/// @} <!-- end Reader -->
+	
+	/// @name Information and statistics
+	/// @{
+	
+	inline int getNumChannels() const throw()			{ return numChannels;								}
+	inline long getNumFrames() const throw()			{ return numFrames;									}
+	inline double getSampleRate() const throw()			{ return sampleRate;								}
+	inline int getBufferSize() const throw()			{ return capacity;									}
+	inline bool isMemoryMapped() const throw()			{ return source->isMemoryMapped();					}
+	
+	/** The number of frames in the ring ready to be read. */
+	inline int getNumAvailable() const throw()			{ return (int)(writeTotal - readTotal);				}
+	
+	/** The number of reads which couldn't be completed because the ring was empty. */
+	inline int getNumUnderruns() const throw()			{ return numUnderruns;								}
+	
+	/** The number of output frames cleared by underruns. */
+	inline int getNumUnderrunFrames() const throw()		{ return numUnderrunFrames;							}
+	
+	/** The I/O thread's estimate of the reader's consumption in frames per second. */
+	inline double getConsumptionRate() const throw()	{ return consumptionRate;							}
+	
+	/// @} <!-- end Information and statistics -->
+	
+	friend class DiskStreamer;
+	
+private:
+	bool synchronise() throw();
+	void clear(float* const* outputs, const int offset, const int numFrames) throw();
+	void underrun(const int numFrames) throw();
+	void advance(const unsigned int numFramesToAdvance) throw();
+	int fill(const int maxFrames) throw();
+	int service(const double now, const double readAheadTime, const bool urgentOnly) throw();
+	
+	DiskStreamSource* const source;
+	DiskStreamer* streamer;
+	DiskStream* next;
+	
+	const int numChannels;
+	const long numFrames;
+	const double sampleRate;
+	const int capacity;
+	const unsigned int mask;
+	const bool loop;
+	const long loopStartFrame;
+	
+	Buffer ring;
+	float** ringChannels;					// the start of each channel of the ring
+	float** channelPointers;				// the I/O thread's write positions
+	
+	volatile unsigned int writeTotal;		// frames written, advanced by the I/O thread only
+	volatile unsigned int readTotal;		// frames read, advanced by the reader only
+	volatile int ended;						// the I/O thread reached the end of a non-looping source
+	volatile int released;
+	
+	volatile int seekRequest;				// incremented by setPosition()
+	volatile int seekAcknowledged;			// the last request the I/O thread handled
+	volatile long seekFrame;
+	volatile long seekAcknowledgedFrame;
+	volatile unsigned int discardTotal;		// the reader skips to here when it sees a new acknowledgement
+	int readerSeek;							// the last acknowledgement the reader handled
+	
+	long filePosition;						// the next frame the I/O thread reads
+	volatile long readFrame;				// the next frame the reader reads
+	double phase;
+	
+	volatile int refillThreshold;			// the reader wakes the I/O thread when fewer frames are available
+	int target;								// the I/O thread's fill level
+	double consumptionRate;
+	double lastServiceTime;
+	unsigned int lastServiceReadTotal;
+	
+	int numUnderruns;
+	int numUnderrunFrames;
+	
+	DiskStream (const DiskStream&);
+    const DiskStream& operator= (const DiskStream&);
+};
+
+/** The shared disk streaming service.
+ 
+ One I/O thread fills the rings of all the DiskStream objects. This avoids a thread per file 
+ when playing many files and lets the reads be scheduled together: streams which are below 
+ their refill threshold are always serviced before those which are merely below their target. 
+ 
+ The read-ahead adapts to each stream's consumption: the I/O thread measures how fast each 
+ reader is consuming frames (which depends on its playback rate) and keeps getReadAheadTime() 
+ seconds of audio in the ring (limited by the ring size). Memory mapped sources are prefetched 
+ beyond the data read so the OS pages them in asynchronously. 
+ 
+ @code
+	DiskStreamer::getInstance().setReadAheadTime(1.0);
+	// ...
+	printf("underruns: %d\n", DiskStreamer::getInstance().getTotalUnderruns());
+ @endcode
+ 
+ @see DiskStream, DiskIn */
+class DiskStreamer : public UGenThread
+{
+public:
+	/** Get the shared streamer, creating and starting it if necessary. */
+	static DiskStreamer& getInstance() throw();
+	
+	/** Stop the I/O thread and delete the streamer and all its streams. 
+	 This should only be called after all the UGens using streams have been deleted. */
+	static void shutdown() throw();
+	
+	/** Add a stream, this is safe to call from any thread. */
+	void add(DiskStream* stream) throw();
+	
+	/** Wake the I/O thread, this is safe to call from the audio thread. */
+	void wake() throw();
+	
+	/** Set the amount of audio to keep in each ring. */
+	void setReadAheadTime(const double seconds) throw()			{ readAheadTime = seconds > 0.0 ? seconds : 0.0;	}
+	inline double getReadAheadTime() const throw()				{ return readAheadTime;								}
+	
+	/** The number of streams serviced by the I/O thread. */
+	inline int getNumStreams() const throw()					{ return numStreams;								}
+	
+	/** The total number of underruns of all streams (including those deleted). */
+	inline int getTotalUnderruns() const throw()				{ return totalUnderruns;							}
+	
+	/** The total number of frames read from the sources. */
+	inline double getTotalFramesRead() const throw()			{ return totalFramesRead;							}
+	
+	/** @internal */
+	void run();
+	
+	/** @internal */
+	void signalThreadShouldExit() throw();
+	
+	friend class DiskStream;
+	
+private:
+	DiskStreamer() throw();
+	~DiskStreamer();
+	
+	void adoptNewStreams() throw();
+	int serviceStreams(const bool urgentOnly) throw();
+	
+	static DiskStreamer* volatile instance;
+	
+	DiskStream* volatile incoming;	// pushed by any thread
+	DiskStream* streams;			// used by the I/O thread only
+	Semaphore wakeSemaphore;
+	volatile int wakePending;
+	double readAheadTime;
+	volatile int numStreams;
+	volatile int totalUnderruns;
+	double totalFramesRead;
+	
+	DiskStreamer (const DiskStreamer&);
+    const DiskStreamer& operator= (const DiskStreamer&);
+};
+
+
+/** Plays a DiskStream.
+ 
+ This is used by the DiskIn UGens on all platforms, each platform's DiskIn just provides 
+ a DiskStreamSource for files which can't be memory mapped. 
+ 
+ @see DiskIn
+ @ingroup UGenInternals */
+class DiskInUGenInternal :	public ProxyOwnerUGenInternal,
+							public DoneActionSender
+{
+public:
+	DiskInUGenInternal(DiskStreamSource* source,
+					   UGen const& rate,
+					   const bool loopFlag, 
+					   const double startTime, 
+					   const int bufferFrames,
+					   const UGen::DoneAction doneAction) throw();
+	~DiskInUGenInternal() throw();
+	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
+	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	
+	double getDuration() const throw();
+	double getPosition() const throw();
+	bool setPosition(const double newPosition) throw();
+	
+	/** The underlying stream, e.g., for its underrun counters. */
+	inline const DiskStream* getStream() const throw() { return stream; }
+	
+	enum Inputs { Rate, NumInputs };
+	
+protected:
+	DiskStream* stream;
+	float** outputPointers;
+	const bool loopFlag_;
+	const double rateScale;
+	const UGen::DoneAction doneAction_;
+	const bool shouldDeleteValue;	
+};
+
+#if !defined(UGEN_JUCE) && !defined(UGEN_IPHONE)
+
+/** Streams a soundfile from disk.
+ 
+ This version is for platforms without Juce or CoreAudio and supports uncompressed WAV 
+ and AIFF files (which are memory mapped). 
+ 
+ @param path		The path of the sound file.
+ @param loopFlag	Whether to loop back to @c startTime at the end of the file.
+ @param startTime	The time in seconds to start playing from.
+ @param numFrames	The size of the stream's ring buffer in frames.
+ @param doneAction	If looping is off and the done action is UGen::DeleteWhenDone then
+					this UGen will fire a delete action at the end of the file.
+ @param rate		The playback rate, 1 is normal speed and negative rates are
+					treated as 0. The read-ahead adapts to the rate.
+ 
+ @ingroup AllUGens SoundFileUGens
+ @see PlayBuf, DiskStreamer */
+class DiskIn : public UGen 
+{ 
+public: 
+	DiskIn () throw() : UGen() { } 
+	DiskIn (Text const& path, 
+			const bool loopFlag = false, 
+			const double startTime = 0.0, 
+			const int numFrames = 32768,
+			const UGen::DoneAction doneAction = UGen::DeleteWhenDone,
+			UGen const& rate = UGen::get1()) throw(); 
+	
+	static inline UGen AR (Text const& path, 
+						   const bool loopFlag = false, 
+						   const double startTime = 0.0,
+						   const int numFrames = 32768,
+						   const UGen::DoneAction doneAction = UGen::DeleteWhenDone,
+						   UGen const& rate = UGen::get1()) throw() 
+	{ 
+		return DiskIn (path, loopFlag, startTime, numFrames, doneAction, rate); 
+	} 	
+};
+
+#endif
+
+
+#endif // _UGEN_ugen_DiskStream_H_
@@ -0,0 +1,870 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#include "../core/ugen_StandardHeader.h"
+
+// the platform headers must be outside the UGen namespace
+#if defined (_WIN32) || defined (_WIN64)
+	#ifndef NOMINMAX
+		#define NOMINMAX 1
+	#endif
+	#include <windows.h>
+	#define UGEN_MAPPING_WIN32 1
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_MappedAudioFile.h"
+#include "../basics/ugen_InlineBinaryOps.h"
+
+static inline unsigned int littleEndian16(const char* bytes) throw()
+{
+	const unsigned char* b = (const unsigned char*)bytes;
+	return b[0] | (b[1] << 8);
+}
+
+static inline unsigned int littleEndian32(const char* bytes) throw()
+{
+	const unsigned char* b = (const unsigned char*)bytes;
+	return b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned int)b[3] << 24);
+}
+
+static inline unsigned int bigEndian16(const char* bytes) throw()
+{
+	const unsigned char* b = (const unsigned char*)bytes;
+	return (b[0] << 8) | b[1];
+}
+
+static inline unsigned int bigEndian32(const char* bytes) throw()
+{
+	const unsigned char* b = (const unsigned char*)bytes;
+	return ((unsigned int)b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+}
+
+static inline bool hasID(const char* bytes, const char* id) throw()
+{
+	return memcmp(bytes, id, 4) == 0;
+}
+
+static inline bool hostIsBigEndian() throw()
+{
+	const unsigned int one = 1;
+	return *(const unsigned char*)&one == 0;
+}
+
+static inline void putLittleEndian16(char* bytes, const unsigned int value) throw()
+{
+	bytes[0] = (char)(value & 0xFF);
+	bytes[1] = (char)((value >> 8) & 0xFF);
+}
+
+static inline void putLittleEndian32(char* bytes, const unsigned int value) throw()
+{
+	bytes[0] = (char)(value & 0xFF);
+	bytes[1] = (char)((value >> 8) & 0xFF);
+	bytes[2] = (char)((value >> 16) & 0xFF);
+	bytes[3] = (char)((value >> 24) & 0xFF);
+}
+
+static inline void putBigEndian16(char* bytes, const unsigned int value) throw()
+{
+	bytes[0] = (char)((value >> 8) & 0xFF);
+	bytes[1] = (char)(value & 0xFF);
+}
+
+static inline void putBigEndian32(char* bytes, const unsigned int value) throw()
+{
+	bytes[0] = (char)((value >> 24) & 0xFF);
+	bytes[1] = (char)((value >> 16) & 0xFF);
+	bytes[2] = (char)((value >> 8) & 0xFF);
+	bytes[3] = (char)(value & 0xFF);
+}
+
+static inline void putID(char* bytes, const char* id) throw()
+{
+	memcpy(bytes, id, 4);
+}
+
+/** Convert a double to an 80-bit IEEE extended float (for the AIFF sample rate). */
+static void doubleToExtended(const double value, char* bytes) throw()
+{
+	memset(bytes, 0, 10);
+	
+	if(value == 0.0) 
+		return;
+	
+	int exponent;
+	const double mantissa = frexp(value < 0.0 ? -value : value, &exponent); // 0.5 <= mantissa < 1
+	const double hiMantissa = ::floor(ldexp(mantissa, 32));
+	const double loMantissa = ::floor(ldexp(ldexp(mantissa, 32) - hiMantissa, 32));
+	const int biasedExponent = exponent + 16382;
+	
+	bytes[0] = (char)(((biasedExponent >> 8) & 0x7F) | (value < 0.0 ? 0x80 : 0));
+	bytes[1] = (char)(biasedExponent & 0xFF);
+	putBigEndian32(bytes + 2, (unsigned int)hiMantissa);
+	putBigEndian32(bytes + 6, (unsigned int)loMantissa);
+}
+
+/** Convert an 80-bit IEEE extended float (as used by AIFF for the sample rate). */
+static double extendedToDouble(const char* bytes) throw()
+{
+	const unsigned char* b = (const unsigned char*)bytes;
+	const int exponent = ((b[0] & 0x7F) << 8) | b[1];
+	const unsigned int hiMantissa = bigEndian32(bytes + 2);
+	const unsigned int loMantissa = bigEndian32(bytes + 6);
+	
+	if(exponent == 0 && hiMantissa == 0 && loMantissa == 0) 
+		return 0.0;
+	
+	const double value = ldexp((double)hiMantissa, exponent - 16383 - 31) 
+					   + ldexp((double)loMantissa, exponent - 16383 - 63);
+	
+	return (b[0] & 0x80) ? -value : value;
+}
+
+MappedAudioFile::MappedAudioFile(const char* path, const bool copyOnWriteMapping) throw()
+:	fileHandle(0),
+	mappingHandle(0),
+	mapping(0),
+	mappingSize(0),
+	data(0),
+	numChannels(0),
+	numFrames(0),
+	sampleRate(0.0),
+	sampleFormat(UnsupportedFormat),
+	bytesPerSample(0),
+	bytesPerFrame(0),
+	bigEndian(false),
+	copyOnWrite(copyOnWriteMapping)
+{
+	// Buffer channels which share the mapping may be released on different threads
+	makeRefCountAtomic();
+	
+	if(path == 0) return;
+	
+#ifdef UGEN_MAPPING_WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 
+							  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	if(file == INVALID_HANDLE_VALUE) return;
+	
+	fileHandle = file;
+	
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0 || (LONGLONG)(long)fileSize.QuadPart != fileSize.QuadPart) 
+	{
+		close();
+		return;
+	}
+	
+	HANDLE fileMapping = CreateFileMappingA(file, 0, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, 0);
+	if(fileMapping == 0) 
+	{
+		close();
+		return;
+	}
+	
+	mappingHandle = fileMapping;
+	mapping = (char*)MapViewOfFile(fileMapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+	mappingSize = (long)fileSize.QuadPart;
+#else
+	const int file = open(path, O_RDONLY);
+	if(file < 0) return;
+	
+	struct stat fileInfo;
+	if((fstat(file, &fileInfo) != 0) || (fileInfo.st_size == 0) || ((off_t)(long)fileInfo.st_size != fileInfo.st_size))
+	{
+		::close(file);
+		return;
+	}
+	
+	void* address = copyOnWrite ? mmap(0, fileInfo.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0)
+								: mmap(0, fileInfo.st_size, PROT_READ, MAP_SHARED, file, 0);
+	::close(file); // the mapping keeps its own reference to the file
+	
+	if(address == MAP_FAILED) return;
+	
+	mapping = (char*)address;
+	mappingSize = (long)fileInfo.st_size;
+	madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+#endif
+	
+	if(mapping == 0)
+	{
+		close();
+		return;
+	}
+	
+	if(mappingSize < 12 || !(parseWav(mapping, mappingSize) || parseAiff(mapping, mappingSize) || parseCaf(mapping, mappingSize)))
+	{
+		data = 0;
+		close();
+	}
+}
+
+MappedAudioFile::~MappedAudioFile()
+{
+	close();
+}
+
+void MappedAudioFile::close() throw()
+{
+#ifdef UGEN_MAPPING_WIN32
+	if(mapping != 0)		UnmapViewOfFile(mapping);
+	if(mappingHandle != 0)	CloseHandle((HANDLE)mappingHandle);
+	if(fileHandle != 0)		CloseHandle((HANDLE)fileHandle);
+#else
+	if(mapping != 0)		munmap(mapping, mappingSize);
+#endif
+	
+	fileHandle = 0;
+	mappingHandle = 0;
+	mapping = 0;
+	mappingSize = 0;
+	data = 0;
+}
+
+bool MappedAudioFile::parseWav(const char* bytes, const long size) throw()
+{
+	if(!hasID(bytes, "RIFF") || !hasID(bytes + 8, "WAVE")) 
+		return false;
+	
+	int formatTag = 0;
+	int bitsPerSample = 0;
+	const char* dataStart = 0;
+	long dataSize = 0;
+	long offset = 12;
+	
+	while(offset + 8 <= size)
+	{
+		const char* chunk = bytes + offset;
+		const long chunkSize = littleEndian32(chunk + 4);
+		const char* chunkData = chunk + 8;
+		
+		if(hasID(chunk, "fmt ") && chunkSize >= 16 && offset + 8 + 16 <= size)
+		{
+			formatTag = littleEndian16(chunkData);
+			numChannels = littleEndian16(chunkData + 2);
+			sampleRate = littleEndian32(chunkData + 4);
+			bytesPerFrame = littleEndian16(chunkData + 12);
+			bitsPerSample = littleEndian16(chunkData + 14);
+			
+			if(formatTag == 0xFFFE && chunkSize >= 40 && offset + 8 + 40 <= size) 
+				formatTag = littleEndian16(chunkData + 24); // the first two bytes of the sub format GUID
+		}
+		else if(hasID(chunk, "data"))
+		{
+			dataStart = chunkData;
+			dataSize = ugen::min(chunkSize, size - (offset + 8)); // the file may have been truncated
+		}
+		
+		offset += 8 + chunkSize + (chunkSize & 1);
+	}
+	
+	if(dataStart == 0 || numChannels <= 0 || bitsPerSample <= 0)
+		return false;
+	
+	bytesPerSample = (bitsPerSample + 7) / 8;
+	
+	if(formatTag == 1)
+	{
+		switch(bytesPerSample)
+		{
+			case 1: sampleFormat = Int8; break;
+			case 2: sampleFormat = Int16; break;
+			case 3: sampleFormat = Int24; break;
+			case 4: sampleFormat = Int32; break;
+			default: return false;
+		}
+	}
+	else if(formatTag == 3)
+	{
+		switch(bytesPerSample)
+		{
+			case 4: sampleFormat = Float32; break;
+			case 8: sampleFormat = Float64; break;
+			default: return false;
+		}
+	}
+	else return false;
+	
+	if(bytesPerFrame < numChannels * bytesPerSample)
+		bytesPerFrame = numChannels * bytesPerSample;
+	
+	bigEndian = false;
+	data = dataStart;
+	numFrames = dataSize / bytesPerFrame;
+	
+	return true;
+}
+
+bool MappedAudioFile::parseAiff(const char* bytes, const long size) throw()
+{
+	if(!hasID(bytes, "FORM") || !(hasID(bytes + 8, "AIFF") || hasID(bytes + 8, "AIFC"))) 
+		return false;
+	
+	const bool isAIFC = hasID(bytes + 8, "AIFC");
+	int bitsPerSample = 0;
+	long commFrames = 0;
+	const char* compression = "NONE";
+	const char* dataStart = 0;
+	long dataSize = 0;
+	long offset = 12;
+	
+	while(offset + 8 <= size)
+	{
+		const char* chunk = bytes + offset;
+		const long chunkSize = bigEndian32(chunk + 4);
+		const char* chunkData = chunk + 8;
+		
+		if(hasID(chunk, "COMM") && chunkSize >= 18 && offset + 8 + 18 <= size)
+		{
+			numChannels = bigEndian16(chunkData);
+			commFrames = bigEndian32(chunkData + 2);
+			bitsPerSample = bigEndian16(chunkData + 6);
+			sampleRate = extendedToDouble(chunkData + 8);
+			
+			if(isAIFC && chunkSize >= 22 && offset + 8 + 22 <= size)
+				compression = chunkData + 18;
+		}
+		else if(hasID(chunk, "SSND") && chunkSize >= 8 && offset + 16 <= size)
+		{
+			const long dataOffset = bigEndian32(chunkData);
+			dataStart = chunkData + 8 + dataOffset;
+			dataSize = ugen::min(chunkSize - 8 - dataOffset, size - (offset + 16 + dataOffset));
+		}
+		
+		offset += 8 + chunkSize + (chunkSize & 1);
+	}
+	
+	if(dataStart == 0 || dataSize <= 0 || numChannels <= 0 || bitsPerSample <= 0)
+		return false;
+	
+	bytesPerSample = (bitsPerSample + 7) / 8;
+	bigEndian = true;
+	
+	if(hasID(compression, "NONE") || hasID(compression, "twos") || hasID(compression, "sowt"))
+	{
+		bigEndian = !hasID(compression, "sowt");
+		
+		switch(bytesPerSample)
+		{
+			case 1: sampleFormat = Int8; break;
+			case 2: sampleFormat = Int16; break;
+			case 3: sampleFormat = Int24; break;
+			case 4: sampleFormat = Int32; break;
+			default: return false;
+		}
+	}
+	else if(hasID(compression, "fl32") || hasID(compression, "FL32"))
+	{
+		sampleFormat = Float32;
+		bytesPerSample = 4;
+	}
+	else if(hasID(compression, "fl64") || hasID(compression, "FL64"))
+	{
+		sampleFormat = Float64;
+		bytesPerSample = 8;
+	}
+	else return false;
+	
+	bytesPerFrame = numChannels * bytesPerSample;
+	data = dataStart;
+	numFrames = ugen::min(commFrames, dataSize / bytesPerFrame);
+	
+	return true;
+}
+
+bool MappedAudioFile::parseCaf(const char* bytes, const long size) throw()
+{
+	if(!hasID(bytes, "caff") || bigEndian16(bytes + 4) != 1) 
+		return false;
+	
+	bool isFloat = false;
+	bool isLittleEndian = false;
+	int bitsPerSample = 0;
+	const char* dataStart = 0;
+	long dataSize = 0;
+	long offset = 8;
+	
+	while(offset + 12 <= size)
+	{
+		const char* chunk = bytes + offset;
+		const unsigned int chunkSizeHi = bigEndian32(chunk + 4);
+		const unsigned int chunkSizeLo = bigEndian32(chunk + 8);
+		const char* chunkData = chunk + 12;
+		const long available = size - (offset + 12);
+		
+		// chunk sizes are 64-bit, -1 is only allowed for the data chunk and means "to the end of the file"
+		const bool toEnd = (chunkSizeHi == 0xFFFFFFFF) && (chunkSizeLo == 0xFFFFFFFF);
+		const long chunkSize = (toEnd || chunkSizeHi != 0 || (long)chunkSizeLo > available) ? available : (long)chunkSizeLo;
+		
+		if(hasID(chunk, "desc") && chunkSize >= 32)
+		{
+			const unsigned int rateHi = bigEndian32(chunkData);
+			const unsigned int rateLo = bigEndian32(chunkData + 4);
+			const unsigned long long rateBits = ((unsigned long long)rateHi << 32) | rateLo;
+			memcpy(&sampleRate, &rateBits, sizeof(double));
+			
+			if(!hasID(chunkData + 8, "lpcm"))
+				return false;
+			
+			const unsigned int formatFlags = bigEndian32(chunkData + 12);
+			isFloat = (formatFlags & 1) != 0;
+			isLittleEndian = (formatFlags & 2) != 0;
+			bytesPerFrame = bigEndian32(chunkData + 16);
+			numChannels = bigEndian32(chunkData + 24);
+			bitsPerSample = bigEndian32(chunkData + 28);
+		}
+		else if(hasID(chunk, "data") && chunkSize >= 4)
+		{
+			dataStart = chunkData + 4; // after the edit count
+			dataSize = chunkSize - 4;
+		}
+		
+		offset += 12 + chunkSize;
+	}
+	
+	if(dataStart == 0 || numChannels <= 0 || bitsPerSample <= 0)
+		return false;
+	
+	bytesPerSample = (bitsPerSample + 7) / 8;
+	bigEndian = !isLittleEndian;
+	
+	if(isFloat)
+	{
+		switch(bytesPerSample)
+		{
+			case 4: sampleFormat = Float32; break;
+			case 8: sampleFormat = Float64; break;
+			default: return false;
+		}
+	}
+	else
+	{
+		switch(bytesPerSample)
+		{
+			case 1: sampleFormat = Int8; bigEndian = true; break; // CAF 8-bit is signed, read() uses this to choose
+			case 2: sampleFormat = Int16; break;
+			case 3: sampleFormat = Int24; break;
+			case 4: sampleFormat = Int32; break;
+			default: return false;
+		}
+	}
+	
+	if(bytesPerFrame < numChannels * bytesPerSample)
+		bytesPerFrame = numChannels * bytesPerSample;
+	
+	data = dataStart;
+	numFrames = dataSize / bytesPerFrame;
+	
+	return true;
+}
+
+bool MappedAudioFile::isNativeFloat() const throw()
+{
+	return (sampleFormat == Float32) && (bigEndian == hostIsBigEndian());
+}
+
+float* MappedAudioFile::getMonoFloatData() const throw()
+{
+	if((data == 0) || (numChannels != 1) || !isNativeFloat() || (((size_t)data & (sizeof(float) - 1)) != 0))
+		return 0;
+	
+	return (float*)data;
+}
+
+int MappedAudioFile::read(float* const* destinations, const long startFrame, const int numFramesToRead) const throw()
+{
+	if(data == 0 || startFrame < 0 || startFrame >= numFrames || numFramesToRead <= 0) 
+		return 0;
+	
+	const int numFramesRead = (int)ugen::min((long)numFramesToRead, numFrames - startFrame);
+	const char* const frames = data + startFrame * bytesPerFrame;
+	
+	for(int channel = 0; channel < numChannels; channel++)
+	{
+		float* const outputSamples = destinations[channel];
+		const char* inputBytes = frames + channel * bytesPerSample;
+		
+		if(outputSamples == 0) continue;
+		
+		switch(sampleFormat)
+		{
+			case Int8: {
+				static const float factor = 1.f / 0x80;
+				// WAV 8-bit is unsigned, AIFF is signed
+				const int bias = bigEndian ? 0 : 0x80;
+				for(int i = 0; i < numFramesRead; i++, inputBytes += bytesPerFrame)
+				{
+					const int value = bigEndian ? (int)(signed char)*inputBytes : (int)(unsigned char)*inputBytes;
+					outputSamples[i] = (float)(value - bias) * factor;
+				}
+			} break;
+			case Int16: {
+				static const float factor = 1.f / 0x8000;
+				for(int i = 0; i < numFramesRead; i++, inputBytes += bytesPerFrame)
+				{
+					const short value = (short)(bigEndian ? bigEndian16(inputBytes) : littleEndian16(inputBytes));
+					outputSamples[i] = (float)value * factor;
+				}
+			} break;
+			case Int24: {
+				static const float factor = 1.f / 0x800000;
+				for(int i = 0; i < numFramesRead; i++, inputBytes += bytesPerFrame)
+				{
+					const unsigned char* b = (const unsigned char*)inputBytes;
+					const int value = bigEndian ? (int)((b[0] << 24) | (b[1] << 16) | (b[2] << 8)) >> 8
+												: (int)((b[2] << 24) | (b[1] << 16) | (b[0] << 8)) >> 8;
+					outputSamples[i] = (float)value * factor;
+				}
+			} break;
+			case Int32: {
+				static const float factor = 1.f / 2147483648.f;
+				for(int i = 0; i < numFramesRead; i++, inputBytes += bytesPerFrame)
+				{
+					const int value = (int)(bigEndian ? bigEndian32(inputBytes) : littleEndian32(inputBytes));
+					outputSamples[i] = (float)value * factor;
+				}
+			} break;
+			case Float32: {
+				if(isNativeFloat())
+				{
+					if(numChannels == 1)
+					{
+						memcpy(outputSamples, inputBytes, numFramesRead * sizeof(float));
+					}
+					else
+					{
+						for(int i = 0; i < numFramesRead; i++, inputBytes += bytesPerFrame)
+							memcpy(outputSamples + i, inputBytes, sizeof(float));
+					}
+				}
+				else
+				{
+					for(int i = 0; i < numFramesRead; i++, inputBytes += bytesPerFrame)
+					{
+						const unsigned int value = bigEndian ? bigEndian32(inputBytes) : littleEndian32(inputBytes);
+						memcpy(outputSamples + i, &value, sizeof(float));
+					}
+				}
+			} break;
+			case Float64: {
+				for(int i = 0; i < numFramesRead; i++, inputBytes += bytesPerFrame)
+				{
+					const unsigned int word0 = bigEndian ? bigEndian32(inputBytes) : littleEndian32(inputBytes + 4);
+					const unsigned int word1 = bigEndian ? bigEndian32(inputBytes + 4) : littleEndian32(inputBytes);
+					unsigned char valueBytes[8];
+					
+					// assemble the double in the host byte order
+					const unsigned int hi = word0, lo = word1;
+					if(hostIsBigEndian())
+					{
+						memcpy(valueBytes, &hi, 4);
+						memcpy(valueBytes + 4, &lo, 4);
+					}
+					else
+					{
+						memcpy(valueBytes, &lo, 4);
+						memcpy(valueBytes + 4, &hi, 4);
+					}
+					
+					double value;
+					memcpy(&value, valueBytes, sizeof(double));
+					outputSamples[i] = (float)value;
+				}
+			} break;
+			default: 
+				memset(outputSamples, 0, numFramesRead * sizeof(float));
+		}
+	}
+	
+	return numFramesRead;
+}
+
+void MappedAudioFile::prefetch(const long startFrame, const int numFramesToPrefetch) const throw()
+{
+	if(data == 0 || startFrame < 0 || startFrame >= numFrames || numFramesToPrefetch <= 0) 
+		return;
+	
+#ifdef UGEN_MAPPING_WIN32
+	// the reads on the I/O thread fault the pages in, there is no portable asynchronous hint
+	(void)startFrame;
+	(void)numFramesToPrefetch;
+#else
+	const long pageSize = sysconf(_SC_PAGESIZE);
+	const long numFramesToUse = ugen::min((long)numFramesToPrefetch, numFrames - startFrame);
+	const long start = (data - mapping) + startFrame * bytesPerFrame;
+	const long alignedStart = start / pageSize * pageSize;
+	const long end = ugen::min(start + numFramesToUse * bytesPerFrame, mappingSize);
+	
+	madvise(mapping + alignedStart, end - alignedStart, MADV_WILLNEED);
+#endif
+}
+
+static bool hasExtension(const char* path, const char* extension) throw()
+{
+	const char* dot = strrchr(path, '.');
+	if(dot == 0) return false;
+	
+	for(dot++; *dot != 0 && *extension != 0; dot++, extension++)
+	{
+		const char c = (*dot >= 'A' && *dot <= 'Z') ? (char)(*dot - 'A' + 'a') : *dot;
+		if(c != *extension) return false;
+	}
+	
+	return *dot == 0 && *extension == 0;
+}
+
+MappedAudioFile::FileType MappedAudioFile::getFileType(const char* path) throw()
+{
+	if(path == 0)							return UnknownType;
+	if(hasExtension(path, "wav"))			return WAV;
+	if(hasExtension(path, "aif") || 
+	   hasExtension(path, "aiff") || 
+	   hasExtension(path, "aifc"))			return AIFF;
+	if(hasExtension(path, "caf"))			return CAF;
+	
+	return UnknownType;
+}
+
+/** Convert a sample to a file sample in the given format. */
+static inline void putSample(char* bytes, const float sample, const int bytesPerSample, 
+							 const bool isFloat, const bool bigEndian, const bool unsigned8) throw()
+{
+	if(isFloat)
+	{
+		unsigned int value;
+		memcpy(&value, &sample, sizeof(float));
+		
+		if(bigEndian)	putBigEndian32(bytes, value);
+		else			putLittleEndian32(bytes, value);
+		
+		return;
+	}
+	
+	const double maximum = (double)((1 << (bytesPerSample * 8 - 1)) - 1);
+	const int value = (int)floor(ugen::clip((double)sample, -1.0, 1.0) * maximum + 0.5);
+	
+	switch(bytesPerSample)
+	{
+		case 1: 
+			bytes[0] = (char)(unsigned8 ? value + 0x80 : value); 
+			break;
+		case 2:
+			if(bigEndian)	putBigEndian16(bytes, (unsigned int)value);
+			else			putLittleEndian16(bytes, (unsigned int)value);
+			break;
+		case 3:
+			if(bigEndian)
+			{
+				bytes[0] = (char)((value >> 16) & 0xFF);
+				bytes[1] = (char)((value >> 8) & 0xFF);
+				bytes[2] = (char)(value & 0xFF);
+			}
+			else
+			{
+				bytes[0] = (char)(value & 0xFF);
+				bytes[1] = (char)((value >> 8) & 0xFF);
+				bytes[2] = (char)((value >> 16) & 0xFF);
+			}
+			break;
+	}
+}
+
+bool MappedAudioFile::write(const char* path, 
+							const float* const* channels, 
+							const int numChannels, 
+							const long numFrames, 
+							const double sampleRate,
+							const int bitDepth,
+							const bool overwriteExistingFile,
+							const FileType typeToUse) throw()
+{
+	if(path == 0 || channels == 0 || numChannels <= 0 || numFrames < 0 || sampleRate <= 0.0) 
+		return false;
+	
+	if(!overwriteExistingFile)
+	{
+		FILE* existingFile = fopen(path, "rb");
+		
+		if(existingFile != 0)
+		{
+			fclose(existingFile);
+			return false;
+		}
+	}
+	
+	const FileType type = typeToUse != UnknownType ? typeToUse : (getFileType(path) != UnknownType ? getFileType(path) : WAV);
+	const bool isFloat = bitDepth >= 32;
+	const int bytesPerSample = isFloat ? 4 : (bitDepth <= 8 ? 1 : (bitDepth <= 16 ? 2 : 3));
+	const int bitsPerSample = bytesPerSample * 8;
+	const int bytesPerFrame = numChannels * bytesPerSample;
+	const double dataSizeDouble = (double)numFrames * bytesPerFrame;
+	const long dataSize = numFrames * bytesPerFrame;
+	const bool bigEndianData = (type == AIFF);
+	const bool unsigned8 = (type == WAV);
+	const bool padByte = (type != CAF) && (dataSize & 1);
+	
+	// RIFF and IFF chunk sizes are 32-bit
+	if((type != CAF) && (dataSizeDouble > 4294967000.0))
+		return false;
+	
+	char header[128];
+	int headerSize = 0;
+	memset(header, 0, sizeof(header));
+	
+	if(type == WAV)
+	{
+		putID(header, "RIFF");
+		putLittleEndian32(header + 4, (unsigned int)(36 + dataSize + (padByte ? 1 : 0)));
+		putID(header + 8, "WAVE");
+		putID(header + 12, "fmt ");
+		putLittleEndian32(header + 16, 16);
+		putLittleEndian16(header + 20, isFloat ? 3 : 1);
+		putLittleEndian16(header + 22, numChannels);
+		putLittleEndian32(header + 24, (unsigned int)sampleRate);
+		putLittleEndian32(header + 28, (unsigned int)sampleRate * bytesPerFrame);
+		putLittleEndian16(header + 32, bytesPerFrame);
+		putLittleEndian16(header + 34, bitsPerSample);
+		putID(header + 36, "data");
+		putLittleEndian32(header + 40, (unsigned int)dataSize);
+		headerSize = 44;
+	}
+	else if(type == AIFF)
+	{
+		// float needs AIFC (which needs a version chunk)
+		int offset = 12;
+		putID(header, "FORM");
+		putID(header + 8, isFloat ? "AIFC" : "AIFF");
+		
+		if(isFloat)
+		{
+			putID(header + offset, "FVER");
+			putBigEndian32(header + offset + 4, 4);
+			putBigEndian32(header + offset + 8, 0xA2805140);
+			offset += 12;
+		}
+		
+		const int commSize = isFloat ? 24 : 18;
+		putID(header + offset, "COMM");
+		putBigEndian32(header + offset + 4, commSize);
+		putBigEndian16(header + offset + 8, numChannels);
+		putBigEndian32(header + offset + 10, (unsigned int)numFrames);
+		putBigEndian16(header + offset + 14, bitsPerSample);
+		doubleToExtended(sampleRate, header + offset + 16);
+		
+		if(isFloat)
+			putID(header + offset + 26, "fl32"); // followed by an empty, padded, name
+		
+		offset += 8 + commSize;
+		
+		putID(header + offset, "SSND");
+		putBigEndian32(header + offset + 4, (unsigned int)(8 + dataSize));
+		offset += 16; // the offset and block size are zero
+		
+		headerSize = offset;
+		putBigEndian32(header + 4, (unsigned int)(headerSize - 8 + dataSize + (padByte ? 1 : 0)));
+	}
+	else
+	{
+		putID(header, "caff");
+		putBigEndian16(header + 4, 1);
+		
+		putID(header + 8, "desc");
+		putBigEndian32(header + 16, 32);
+		
+		unsigned long long rateBits;
+		memcpy(&rateBits, &sampleRate, sizeof(double));
+		putBigEndian32(header + 20, (unsigned int)(rateBits >> 32));
+		putBigEndian32(header + 24, (unsigned int)(rateBits & 0xFFFFFFFF));
+		putID(header + 28, "lpcm");
+		putBigEndian32(header + 32, (isFloat ? 1 : 0) | 2); // float, little endian
+		putBigEndian32(header + 36, bytesPerFrame);
+		putBigEndian32(header + 40, 1);
+		putBigEndian32(header + 44, numChannels);
+		putBigEndian32(header + 48, bitsPerSample);
+		
+		putID(header + 52, "data");
+		const unsigned long long chunkSize = (unsigned long long)dataSize + 4;
+		putBigEndian32(header + 56, (unsigned int)(chunkSize >> 32));
+		putBigEndian32(header + 60, (unsigned int)(chunkSize & 0xFFFFFFFF));
+		headerSize = 68; // the edit count is zero
+	}
+	
+	FILE* file = fopen(path, "wb");
+	if(file == 0) 
+		return false;
+	
+	bool ok = fwrite(header, 1, headerSize, file) == (size_t)headerSize;
+	
+	const int blockFrames = 4096;
+	char* block = new char[blockFrames * bytesPerFrame];
+	
+	for(long startFrame = 0; ok && startFrame < numFrames; startFrame += blockFrames)
+	{
+		const int numBlockFrames = (int)ugen::min((long)blockFrames, numFrames - startFrame);
+		
+		for(int channel = 0; channel < numChannels; channel++)
+		{
+			const float* inputSamples = channels[channel] + startFrame;
+			char* outputBytes = block + channel * bytesPerSample;
+			
+			for(int i = 0; i < numBlockFrames; i++, outputBytes += bytesPerFrame)
+				putSample(outputBytes, inputSamples[i], bytesPerSample, isFloat, bigEndianData, unsigned8);
+		}
+		
+		const size_t numBytes = (size_t)numBlockFrames * bytesPerFrame;
+		ok = fwrite(block, 1, numBytes, file) == numBytes;
+	}
+	
+	delete [] block;
+	
+	if(ok && padByte)
+		ok = fputc(0, file) != EOF;
+	
+	if(fclose(file) != 0)
+		ok = false;
+	
+	return ok;
+}
+
+END_UGEN_NAMESPACE
@@ -0,0 +1,170 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#ifndef _UGEN_ugen_MappedAudioFile_H_
+#define _UGEN_ugen_MappedAudioFile_H_
+
+
+#include "../core/ugen_SmartPointer.h"
+
+/** A memory mapping of an uncompressed WAV, AIFF or CAF file.
+ 
+ The header is parsed natively (no CoreAudio or Juce) so this works on every platform. 
+ Reading frames converts directly from the mapped pages so there are no read() calls 
+ or intermediate buffers, the OS pages the file in (and shares the pages between 
+ processes mapping the same file). Use prefetch() ahead of reading so the pages are 
+ requested asynchronously rather than faulted in by read().
+ 
+ Supported formats are 8/16/24/32-bit integer and 32/64-bit float PCM in WAV 
+ (including WAVE_FORMAT_EXTENSIBLE), AIFF, AIFC ('NONE', 'sowt', 'fl32' and 'fl64')
+ and CAF ('lpcm'). write() writes the same formats without needing CoreAudio or Juce.
+ 
+ Mappings are reference counted so a Buffer can refer to the samples of a mono native
+ float file directly (see Buffer::Buffer(MappedAudioFile*)).
+ 
+ @see DiskStream */
+class MappedAudioFile : public SmartPointer
+{
+public:
+	enum SampleFormat 
+	{ 
+		UnsupportedFormat, 
+		Int8, 
+		Int16, 
+		Int24, 
+		Int32, 
+		Float32, 
+		Float64 
+	};
+	
+	enum FileType
+	{
+		UnknownType,
+		WAV,
+		AIFF,
+		CAF
+	};
+	
+	/** Open and map a file. Use isValid() to determine whether this succeeded. 
+	 @param path			The path to the file.
+	 @param copyOnWrite		If true the pages are mapped privately and may be written, 
+							only the pages written are copied and the file is not changed. 
+							Otherwise the mapping is read-only. */
+	MappedAudioFile(const char* path, const bool copyOnWrite = false) throw();
+	~MappedAudioFile();
+	
+	/** Write an uncompressed audio file.
+	 @param path			The path to the file.
+	 @param channels		An array of numChannels pointers each with numFrames samples.
+	 @param numChannels		The number of channels.
+	 @param numFrames		The number of frames.
+	 @param sampleRate		The sample rate to store in the header.
+	 @param bitDepth		8, 16 or 24 for integer PCM and 32 for float PCM.
+	 @param overwriteExistingFile	If false this fails if the file exists.
+	 @param type			The file type, UnknownType chooses from the path's extension (and WAV 
+							if the extension is not recognised).
+	 @return				True if the whole file was written. */
+	static bool write(const char* path, 
+					  const float* const* channels, 
+					  const int numChannels, 
+					  const long numFrames, 
+					  const double sampleRate,
+					  const int bitDepth = 24,
+					  const bool overwriteExistingFile = false,
+					  const FileType type = UnknownType) throw();
+	
+	/** Get the file type from the extension of a path (.wav, .aif, .aiff, .aifc or .caf). */
+	static FileType getFileType(const char* path) throw();
+	
+	/** Whether the file was opened, mapped and its format is supported. */
+	inline bool isValid() const throw()						{ return data != 0;					}
+	
+	inline int getNumChannels() const throw()				{ return numChannels;				}
+	inline long getNumFrames() const throw()				{ return numFrames;					}
+	inline double getSampleRate() const throw()				{ return sampleRate;				}
+	inline SampleFormat getSampleFormat() const throw()		{ return sampleFormat;				}
+	inline int getBitsPerSample() const throw()				{ return bytesPerSample * 8;		}
+	inline bool isBigEndian() const throw()					{ return bigEndian;					}
+	inline bool isCopyOnWrite() const throw()				{ return copyOnWrite;				}
+	
+	/** Whether the samples are 32-bit floats in the native byte order (so need no conversion). */
+	bool isNativeFloat() const throw();
+	
+	/** A pointer to the interleaved sample data in the mapping. */
+	inline const char* getSampleData() const throw()		{ return data;						}
+	
+	/** A pointer to the samples if they may be used directly as a Buffer channel (i.e., mono,
+	 native float and aligned), this is writable if the file was mapped copy-on-write. */
+	float* getMonoFloatData() const throw();
+	
+	/** Read and convert frames into separate channel arrays.
+	 @param destinations	An array of getNumChannels() pointers each with space for numFrames.
+	 @param startFrame		The first frame to read.
+	 @param numFrames		The number of frames to read.
+	 @return				The number of frames read, fewer than numFrames at the end of the file. */
+	int read(float* const* destinations, const long startFrame, const int numFrames) const throw();
+	
+	/** Ask the OS to page in a region of the file asynchronously. */
+	void prefetch(const long startFrame, const int numFrames) const throw();
+	
+private:
+	bool parseWav(const char* bytes, const long size) throw();
+	bool parseAiff(const char* bytes, const long size) throw();
+	bool parseCaf(const char* bytes, const long size) throw();
+	void close() throw();
+	
+	void* fileHandle;
+	void* mappingHandle;
+	char* mapping;
+	long mappingSize;
+	
+	const char* data;
+	int numChannels;
+	long numFrames;
+	double sampleRate;
+	SampleFormat sampleFormat;
+	int bytesPerSample;
+	int bytesPerFrame;
+	bool bigEndian;
+	const bool copyOnWrite;
+	
+	MappedAudioFile (const MappedAudioFile&);
+    const MappedAudioFile& operator= (const MappedAudioFile&);
+};
+
+
+#endif // _UGEN_ugen_MappedAudioFile_H_
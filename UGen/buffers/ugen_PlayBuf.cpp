@@ -126,8 +126,17 @@ void PlayBufUGenInternal::prepareForBlock(const int /*actualBlockSize*/, const u
 	if(isDone()) sendDoneInternal();
 }
 
+void PlayBufUGenInternal::handleBuffer(Buffer const& buffer, const double value1, const int value2)
+{
+	if(buffer.getNumChannels() < getNumChannels()) { ugen_assertfalse; return; }
+	
+	AtomicBufferReceiver::handleBuffer(buffer, value1, value2);
+}
+
 void PlayBufUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
 {	
+	acquireBuffer(buffer_);
+	
 	const int numCuesPoints = metaData.getNumCuePoints();
 
 	const int blockSize = uGenOutput.getBlockSize();
@@ -375,12 +384,21 @@ RecordBufUGenInternal::RecordBufUGenInternal(UGen const& input,
 	doneAction_(doneAction),
 	shouldDeleteValue(doneAction_ == UGen::DeleteWhenDone)
 {
+	// take a private copy now if the Buffer shares its data rather than on the first block
+	// and stop later copies of the Buffer sharing it (see Buffer::addWriter())
+	buffer_.addWriter();
+	
 	inputs[Input] = input;
 	inputs[RecLevel] = recLevel;
 	inputs[PreLevel] = preLevel;
 	inputs[Loop] = loop;
 }
 
+RecordBufUGenInternal::~RecordBufUGenInternal()
+{
+	buffer_.removeWriter();
+}
+
 UGenInternal* RecordBufUGenInternal::getChannel(const int channel) throw()
 {
 	return new RecordBufUGenInternal(inputs[Input].getChannel(channel),
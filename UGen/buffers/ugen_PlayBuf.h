@@ -88,7 +88,8 @@ public:
  @ingroup UGenInternals */
 class PlayBufUGenInternal :	public ProxyOwnerUGenInternal,
 							public DoneActionSender,
-							public MetaDataSender
+							public MetaDataSender,
+							public AtomicBufferReceiver
 {
 public:
 	PlayBufUGenInternal(Buffer const& buffer, 
@@ -103,6 +104,10 @@ public:
 	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
 	
+	/** Replace the Buffer being played, the playback position is kept. 
+	 Buffers with fewer channels than this PlayBuf are ignored. */
+	void handleBuffer(Buffer const& buffer, const double value1, const int value2);
+	
 	double getDuration() const throw();
 	double getPosition() const throw();
 	bool setPosition(const double newPosition) throw();	
@@ -186,6 +191,7 @@ public:
 						  UGen const& preLevel,
 						  UGen const& loop, 
 						  const UGen::DoneAction doneAction) throw();
+	~RecordBufUGenInternal();
 	UGenInternal* getChannel(const int channel) throw();
 	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
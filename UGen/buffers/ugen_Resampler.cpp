@@ -0,0 +1,491 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+
+#include "../core/ugen_StandardHeader.h"
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_Resampler.h"
+#include "../core/ugen_Atomics.h"
+#include "../basics/ugen_InlineUnaryOps.h"
+#include "../basics/ugen_InlineBinaryOps.h"
+#ifdef UGEN_SIMD
+#include "../vec/ugen_simd_Utilities.h"
+#endif
+
+
+/** The quality presets. The cutoff is the -6dB point as a proportion of the 
+ Nyquist frequency, this is chosen so the transition band of the Kaiser window
+ ends at the Nyquist frequency. */
+struct ResamplerPreset
+{
+	int numTaps;
+	int numPhases;
+	double beta;
+	double cutoff;
+};
+
+static const ResamplerPreset resamplerPresets[Resampler::NumQualities] = 
+{
+	{ 16, 128,  6.0, 0.77 },	// Low
+	{ 32, 256,  8.0, 0.84 },	// Medium
+	{ 64, 512, 10.0, 0.9  }		// High
+};
+
+ResamplerFilterBank::ResamplerFilterBank(const int numTapsToUse, const int numPhasesToUse, const double beta, const double cutoffToUse) throw()
+:	numTaps(ugen::max(2, (numTapsToUse + 1) & ~1)),
+	numPhases(ugen::max(1, numPhasesToUse)),
+	cutoff(ugen::clip(cutoffToUse, 0.001, 1.0)),
+	quality(-1),
+	coefficients(new float[(numPhases + 1) * numTaps])
+{
+	const int halfLength = numTaps / 2;
+	const double reciprocalI0Beta = 1.0 / besselI0(beta);
+	
+	for(int phase = 0; phase <= numPhases; phase++)
+	{
+		float* row = coefficients + phase * numTaps;
+		const double fraction = (double)phase / numPhases;
+		double sum = 0.0;
+		
+		for(int tap = 0; tap < numTaps; tap++)
+		{
+			const double x = tap - (halfLength - 1) - fraction;	// distance from the interpolated position
+			const double windowPosition = x / halfLength;
+			double value = 0.0;
+			
+			if(windowPosition > -1.0 && windowPosition < 1.0)
+			{
+				const double sincX = pi * cutoff * x;
+				const double sinc = (sincX == 0.0) ? 1.0 : sin(sincX) / sincX;
+				const double kaiser = besselI0(beta * sqrt(1.0 - windowPosition * windowPosition)) * reciprocalI0Beta;
+				value = sinc * kaiser;
+			}
+			
+			row[tap] = (float)value;
+			sum += value;
+		}
+		
+		// unity gain at DC for every phase
+		const float normalise = (float)(1.0 / sum);
+		for(int tap = 0; tap < numTaps; tap++)
+			row[tap] *= normalise;
+	}
+}
+
+ResamplerFilterBank::~ResamplerFilterBank()
+{
+	delete [] coefficients;
+}
+
+float ResamplerFilterBank::dotProduct(const float* window, const float* phaseCoefficients) const throw()
+{
+#if defined(UGEN_VDSP)
+	float result;
+	vDSP_dotpr(window, 1, phaseCoefficients, 1, &result, numTaps);
+	return result;
+#elif defined(UGEN_SIMD)
+	return SIMD::dotProduct(window, phaseCoefficients, numTaps);
+#else
+	float result = 0.f;
+	
+	for(int tap = 0; tap < numTaps; tap++)
+		result += window[tap] * phaseCoefficients[tap];
+	
+	return result;
+#endif
+}
+
+float ResamplerFilterBank::interpolate(const float* window, const double fraction) const throw()
+{
+	const double phasePosition = fraction * numPhases;
+	const int phase = ugen::min((int)phasePosition, numPhases - 1);
+	const float phaseFraction = (float)(phasePosition - phase);
+	
+	const float value0 = dotProduct(window, getPhase(phase));
+	
+	if(phaseFraction == 0.f)
+		return value0;
+	
+	const float value1 = dotProduct(window, getPhase(phase + 1));
+	
+	return value0 + (value1 - value0) * phaseFraction;
+}
+
+struct ResamplerCacheEntry
+{
+	ResamplerFilterBank* bank;
+	ResamplerCacheEntry* next;
+};
+
+static ResamplerCacheEntry* resamplerCache = 0;
+static volatile int resamplerCacheLock = 0;
+
+static void lockResamplerCache() throw()
+{
+	while(Atomics::compareAndSwap(resamplerCacheLock, 0, 1) == false)
+		Atomics::pause();
+}
+
+static void unlockResamplerCache() throw()
+{
+	Atomics::memoryBarrier();
+	resamplerCacheLock = 0;
+}
+
+static ResamplerFilterBank* findSharedResamplerFilterBank(const int quality, const double cutoff) throw()
+{
+	for(ResamplerCacheEntry* entry = resamplerCache; entry != 0; entry = entry->next)
+	{
+		ResamplerFilterBank * const bank = entry->bank;
+		
+		if((bank->getQuality() == quality) && (bank->getCutoff() == cutoff))
+		{
+			bank->incrementRefCount();
+			return bank;
+		}
+	}
+	
+	return 0;
+}
+
+ResamplerFilterBank* ResamplerFilterBank::getShared(const int qualityToUse, const double cutoffToUse) throw()
+{
+	const int quality = ugen::clip(qualityToUse, 0, Resampler::NumQualities - 1);
+	const ResamplerPreset& preset = resamplerPresets[quality];
+	const double cutoff = ugen::clip(cutoffToUse * preset.cutoff, 0.001, 1.0);
+	
+	lockResamplerCache();
+	ResamplerFilterBank* bank = findSharedResamplerFilterBank(quality, cutoff);
+	unlockResamplerCache();
+	
+	if(bank != 0)
+		return bank;
+	
+	// create outside the lock since the coefficients take some time to calculate
+	ResamplerFilterBank* newBank = new ResamplerFilterBank(preset.numTaps, preset.numPhases, preset.beta, cutoff);
+	newBank->quality = quality;
+	
+	lockResamplerCache();
+	bank = findSharedResamplerFilterBank(quality, cutoff);
+	
+	if(bank == 0)
+	{
+		// the cache keeps the original reference and the caller gets another
+		ResamplerCacheEntry* entry = new ResamplerCacheEntry;
+		entry->bank = newBank;
+		entry->next = resamplerCache;
+		resamplerCache = entry;
+		
+		bank = newBank;
+		bank->incrementRefCount();
+		newBank = 0;
+	}
+	
+	unlockResamplerCache();
+	
+	// another thread added the same bank while this one was being created
+	delete newBank;
+	
+	return bank;
+}
+
+void ResamplerFilterBank::clearSharedCache() throw()
+{
+	lockResamplerCache();
+	ResamplerCacheEntry* entry = resamplerCache;
+	resamplerCache = 0;
+	unlockResamplerCache();
+	
+	while(entry != 0)
+	{
+		ResamplerCacheEntry* next = entry->next;
+		entry->bank->decrementRefCount();
+		delete entry;
+		entry = next;
+	}
+}
+
+int ResamplerFilterBank::getNumShared() throw()
+{
+	int numShared = 0;
+	
+	lockResamplerCache();
+	for(ResamplerCacheEntry* entry = resamplerCache; entry != 0; entry = entry->next)
+		numShared++;
+	unlockResamplerCache();
+	
+	return numShared;
+}
+
+Resampler::Resampler(const Quality quality, const double cutoff) throw()
+:	SmartPointerContainer<ResamplerFilterBank>(ResamplerFilterBank::getShared(quality, cutoff))
+{
+}
+
+double Resampler::getPassband(const Quality quality) throw()
+{
+	return resamplerPresets[ugen::clip((int)quality, 0, NumQualities - 1)].cutoff;
+}
+
+Buffer Resampler::process(Buffer const& buffer, 
+						  const double oldSampleRate, 
+						  const double newSampleRate, 
+						  const Quality quality) throw()
+{
+	ugen_assert(oldSampleRate > 0.0);
+	ugen_assert(newSampleRate > 0.0);
+	
+	const int size = buffer.size();
+	
+	if((size == 0) || (oldSampleRate == newSampleRate) || (oldSampleRate <= 0.0) || (newSampleRate <= 0.0))
+		return buffer;
+	
+	const double ratio = newSampleRate / oldSampleRate;
+	const int newSize = ugen::max(1, (int)(size * ratio));
+	const int numChannels = buffer.getNumChannels();
+	
+	// lower the cutoff to the new Nyquist frequency when downsampling
+	const Resampler resampler(quality, ugen::min(1.0, ratio));
+	const ResamplerFilterBank* bank = resampler.getInternal();
+	const int numTaps = bank->getNumTaps();
+	const int halfLength = bank->getHalfLength();
+	const double increment = 1.0 / ratio;
+	
+	// the input is copied with zeros either side so the windows never need bounds checks
+	Buffer padded = Buffer::newClear(size + numTaps, 1, true);
+	float* paddedSamples = padded.getData();
+	Buffer newBuffer = Buffer::withSize(newSize, numChannels, false);
+	
+	for(int channel = 0; channel < numChannels; channel++)
+	{
+		memcpy(paddedSamples + halfLength - 1, buffer.getData(channel), size * sizeof(float));
+		float* outputSamples = newBuffer.getDataUnchecked(channel);
+		
+		for(int sample = 0; sample < newSize; sample++)
+		{
+			const double position = sample * increment;
+			const int index = (int)position;
+			
+			// paddedSamples + index is halfLength-1 samples before index in the original
+			outputSamples[sample] = bank->interpolate(paddedSamples + index, position - index);
+		}
+	}
+	
+	return newBuffer;
+}
+
+
+VarRateUGenInternal::VarRateUGenInternal(Buffer const& buffer, 
+										 UGen const& rate, 
+										 UGen const& loop, 
+										 const double sourceSampleRate,
+										 const UGen::DoneAction doneAction,
+										 const Resampler::Quality quality) throw()
+:	ProxyOwnerUGenInternal(NumInputs, buffer.getNumChannels() - 1),
+	buffer_(buffer),
+	sourceSampleRate_(sourceSampleRate),
+	bufferPos(0.0),
+	doneAction_(doneAction),
+	shouldDeleteValue(doneAction_ == UGen::DeleteWhenDone)
+{
+	inputs[Rate] = rate;
+	inputs[Loop] = loop;
+	
+	// build the banks up front so nothing is calculated on the audio thread
+	for(int i = 0; i < NumBanks; i++)
+		banks[i] = Resampler(quality, pow(2.0, -i * 0.25));
+	
+	ugen_assert(banks[0].getInternal()->getNumTaps() <= MaxTaps);
+}
+
+void VarRateUGenInternal::prepareForBlock(const int /*actualBlockSize*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
+{
+	senderUserData = userData;
+	if(isDone()) sendDoneInternal();
+}
+
+const float* VarRateUGenInternal::getWindow(const float* bufferSamples, const int start, const int numTaps, const bool loop) throw()
+{
+	const int bufferSize = buffer_.size();
+	
+	if((start >= 0) && (start + numTaps <= bufferSize))
+		return bufferSamples + start;
+	
+	// near the ends the window wraps when looping or is padded with zeros
+	for(int tap = 0; tap < numTaps; tap++)
+	{
+		int index = start + tap;
+		
+		if(loop)
+		{
+			index %= bufferSize;
+			if(index < 0) index += bufferSize;
+			window[tap] = bufferSamples[index];
+		}
+		else
+		{
+			window[tap] = ((index >= 0) && (index < bufferSize)) ? bufferSamples[index] : 0.f;
+		}
+	}
+	
+	return window;
+}
+
+void VarRateUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
+{
+	const int blockSize = uGenOutput.getBlockSize();
+	const int bufferSize = buffer_.size();
+	const int numChannels = getNumChannels();
+	const double rateScale = sourceSampleRate_ > 0.0 ? sourceSampleRate_ * UGen::getReciprocalSampleRate() : 1.0;
+	
+	const float* rateSamples = inputs[Rate].processBlock(shouldDelete, blockID, 0);
+	const float* loopSamples = inputs[Loop].processBlock(shouldDelete, blockID, 0);
+	
+	double positions[ChunkSize];
+	bool loops[ChunkSize];
+	
+	for(int offset = 0; offset < blockSize; offset += ChunkSize)
+	{
+		const int numSamples = ugen::min((int)ChunkSize, blockSize - offset);
+		double maxIncrement = 0.0;
+		
+		// the positions are the same for every channel
+		for(int i = 0; i < numSamples; i++)
+		{
+			const bool loop = loopSamples[offset + i] >= 0.5f;
+			const double increment = rateSamples[offset + i] * rateScale;
+			
+			positions[i] = bufferPos;
+			loops[i] = loop;
+			
+			bufferPos += increment;
+			maxIncrement = ugen::max(maxIncrement, fabs(increment));
+			
+			if(loop)
+			{
+				if(bufferPos >= bufferSize)
+					bufferPos -= bufferSize;
+				else if(bufferPos < 0.0)
+					bufferPos += bufferSize;
+			}
+		}
+		
+		// bank k has a cutoff of 2^(-k/4) so this is the first whose cutoff is at or below 1/maxIncrement 
+		const int bankIndex = maxIncrement <= 1.0 ? 0 : ugen::min((int)NumBanks - 1, (int)ceil(4.0 * ugen::log2(maxIncrement) - 1.0e-9));
+		const ResamplerFilterBank* bank = banks[bankIndex].getInternal();
+		const int numTaps = bank->getNumTaps();
+		const int startOffset = bank->getHalfLength() - 1;
+		
+		for(int channel = 0; channel < numChannels; channel++)
+		{
+			const float* bufferSamples = buffer_.getDataReadOnly(channel);
+			float* outputSamples = proxies[channel]->getSampleData() + offset;
+			
+			for(int i = 0; i < numSamples; i++)
+			{
+				const double position = positions[i];
+				
+				if(!loops[i] && ((position < 0.0) || (position >= bufferSize)))
+				{
+					outputSamples[i] = 0.f;
+				}
+				else
+				{
+					const double index = floor(position);
+					const float* samples = getWindow(bufferSamples, (int)index - startOffset, numTaps, loops[i]);
+					outputSamples[i] = bank->interpolate(samples, position - index);
+				}
+			}
+		}
+	}
+	
+	if((bufferPos >= bufferSize) || (bufferPos < 0.0))
+	{
+		shouldDelete = shouldDelete ? true : shouldDeleteValue;
+		setIsDone();
+	}
+}
+
+double VarRateUGenInternal::getDuration() const throw()
+{
+	const double sampleRate = sourceSampleRate_ > 0.0 ? sourceSampleRate_ : UGen::getSampleRate();
+	return buffer_.size() / sampleRate;
+}
+
+double VarRateUGenInternal::getPosition() const throw()
+{
+	const double sampleRate = sourceSampleRate_ > 0.0 ? sourceSampleRate_ : UGen::getSampleRate();
+	return bufferPos / sampleRate;
+}
+
+bool VarRateUGenInternal::setPosition(const double newPosition) throw()
+{
+	const double sampleRate = sourceSampleRate_ > 0.0 ? sourceSampleRate_ : UGen::getSampleRate();
+	bufferPos = ugen::max(0.0, newPosition) * sampleRate;
+	return true;
+}
+
+
+VarRate::VarRate(Buffer const& buffer, 
+				 UGen const& rate, 
+				 UGen const& loop, 
+				 const double sourceSampleRate,
+				 const UGen::DoneAction doneAction,
+				 const Resampler::Quality quality) throw()
+{	
+	const int numChannels = buffer.getNumChannels();
+	
+	if(numChannels > 0 && buffer.size() > 0)
+	{
+		initInternal(numChannels);
+		generateFromProxyOwner(new VarRateUGenInternal(buffer, 
+													   rate.mix(), 
+													   loop.mix(), 
+													   sourceSampleRate,
+													   doneAction, 
+													   quality));
+		
+		for(int i = 0; i < numChannels; i++)
+		{
+			internalUGens[i]->initValue(buffer.getSample(i, 0));
+		}
+	}
+}
+
+END_UGEN_NAMESPACE
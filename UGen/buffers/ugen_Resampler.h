@@ -0,0 +1,234 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+
+#ifndef _UGEN_ugen_Resampler_H_
+#define _UGEN_ugen_Resampler_H_
+
+
+#include "../core/ugen_UGen.h"
+#include "../core/ugen_SmartPointer.h"
+#include "ugen_Buffer.h"
+
+/** An immutable bank of Kaiser-windowed sinc filters for polyphase resampling.
+ 
+ Row p of the bank holds the numTaps coefficients for a fractional position of 
+ p/numPhases (there are numPhases+1 rows so that positions between two phases can
+ be interpolated linearly). Each row is normalised for unity gain at DC.
+ 
+ Banks are expensive to build (numPhases * numTaps Bessel function evaluations)
+ so they should normally be obtained from getShared() which caches them by quality
+ and cutoff. Once built a bank is never modified so it may be used from any thread.
+ 
+ @see Resampler, VarRate */
+class ResamplerFilterBank : public SmartPointer
+{
+public:
+	/** Build a filter bank.
+	 @param numTaps		The number of taps in each filter (rounded up to an even number).
+	 @param numPhases	The number of fractional positions between two samples.
+	 @param beta		The Kaiser window shape parameter.
+	 @param cutoff		The cutoff as a proportion of the Nyquist frequency (0-1). */
+	ResamplerFilterBank(const int numTaps, const int numPhases, const double beta, const double cutoff) throw();
+	~ResamplerFilterBank();
+	
+	/** Get a bank for one of the Resampler::Quality presets from the process-wide 
+	 cache creating it if necessary. The returned bank has had its reference count 
+	 incremented for the caller. */
+	static ResamplerFilterBank* getShared(const int quality, const double cutoff) throw();
+	
+	/** Release the cache's references to the shared banks. */
+	static void clearSharedCache() throw();
+	
+	/** The number of banks in the cache. */
+	static int getNumShared() throw();
+	
+	inline int getNumTaps() const throw()			{ return numTaps;			}
+	inline int getNumPhases() const throw()			{ return numPhases;			}
+	inline double getCutoff() const throw()			{ return cutoff;			}
+	inline int getQuality() const throw()			{ return quality;			}
+	
+	/** The number of samples needed before the interpolated position (the window
+	 passed to interpolate() starts at this many samples minus one before it). */
+	inline int getHalfLength() const throw()		{ return numTaps / 2;		}
+	
+	/** Get the coefficients for a given phase (0 to numPhases inclusive). */
+	inline const float* getPhase(const int phase) const throw() 
+	{ 
+		ugen_assert(phase >= 0 && phase <= numPhases);
+		return coefficients + phase * numTaps;
+	}
+	
+	/** Interpolate a value between two samples.
+	 @param window		Input samples from getHalfLength()-1 samples before the integer part 
+						of the position to getHalfLength() samples after it (getNumTaps() samples).
+	 @param fraction	The fractional part of the position (0-1). */
+	float interpolate(const float* window, const double fraction) const throw();
+	
+	/** The sum of window[i] * coefficients[i] for getNumTaps() samples. */
+	float dotProduct(const float* window, const float* coefficients) const throw();
+	
+private:
+	const int numTaps;
+	const int numPhases;
+	const double cutoff;
+	int quality;
+	float* coefficients;
+	
+	ResamplerFilterBank (const ResamplerFilterBank&);
+	const ResamplerFilterBank& operator= (const ResamplerFilterBank&);
+};
+
+/** High quality sample rate conversion using polyphase windowed sinc interpolation.
+ 
+ This is much more expensive than the linear interpolation used by Buffer::resample()
+ but it avoids the aliasing and high frequency loss of linear interpolation. It is 
+ used by Buffer::changeSampleRate(), Buffer::loadAtSampleRate() and the VarRate UGen.
+ The inner loops use vDSP or the portable SIMD kernels where available.
+ 
+ @see ResamplerFilterBank, VarRate */
+class Resampler : public SmartPointerContainer<ResamplerFilterBank>
+{
+public:
+	/** The resampling quality, higher qualities have longer filters with 
+	 a wider passband and more stopband attenuation. */
+	enum Quality
+	{
+		Low,		///< 16 taps, around 60dB stopband attenuation
+		Medium,		///< 32 taps, around 80dB stopband attenuation
+		High,		///< 64 taps, around 100dB stopband attenuation
+		NumQualities
+	};
+	
+	/** Get a resampler with the filter bank for a quality and cutoff from the shared cache. 
+	 @param quality		The quality preset.
+	 @param cutoff		The cutoff as a proportion of the Nyquist frequency, this is scaled by 
+						the passband of the quality preset (e.g., use 0.5 to downsample by 2). */
+	Resampler(const Quality quality = Medium, const double cutoff = 1.0) throw();
+	
+	/** The proportion of the Nyquist frequency passed unattenuated by a quality preset. */
+	static double getPassband(const Quality quality) throw();
+	
+	/** Interpolate a value between two samples, see ResamplerFilterBank::interpolate(). */
+	inline float interpolate(const float* window, const double fraction) const throw()
+	{
+		return getInternal()->interpolate(window, fraction);
+	}
+	
+	/** Resample the channels of a Buffer from one sample rate to another.
+	 @param buffer			The Buffer to resample.
+	 @param oldSampleRate	The sample rate of the Buffer.
+	 @param newSampleRate	The required sample rate.
+	 @param quality			The quality preset.
+	 @return				The resampled Buffer, this will be the original if the rates are equal. */
+	static Buffer process(Buffer const& buffer, 
+						  const double oldSampleRate, 
+						  const double newSampleRate, 
+						  const Quality quality = Medium) throw();
+};
+
+
+/** A UGenInternal which plays a Buffer at a variable rate using polyphase windowed sinc interpolation.
+ 
+ This is a ProxyOwnerUGenInternal so creates a number of proxy outputs
+ depending on the number of channels in the Buffer. 
+ 
+ @see VarRate
+ @ingroup UGenInternals */
+class VarRateUGenInternal :	public ProxyOwnerUGenInternal,
+							public DoneActionSender
+{
+public:
+	VarRateUGenInternal(Buffer const& buffer, 
+						UGen const& rate, 
+						UGen const& loop,
+						const double sourceSampleRate,
+						const UGen::DoneAction doneAction,
+						const Resampler::Quality quality) throw();
+	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
+	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	
+	double getDuration() const throw();
+	double getPosition() const throw();
+	bool setPosition(const double newPosition) throw();	
+	
+	enum Inputs { Rate, Loop, NumInputs };
+	
+	/** The number of filter banks, bank k has a cutoff of 2^(-k/4) for rates up to 2^(k/4). */
+	enum Constants { NumBanks = 9, ChunkSize = 64, MaxTaps = 64 };
+	
+protected:
+	const float* getWindow(const float* bufferSamples, const int start, const int numTaps, const bool loop) throw();
+	
+	Buffer buffer_;
+	const double sourceSampleRate_;
+	double bufferPos;
+	const UGen::DoneAction doneAction_;
+	const bool shouldDeleteValue;
+	Resampler banks[NumBanks];
+	float window[MaxTaps];
+};
+
+#define VarRate_Docs	@param buffer	The Buffer to play, this number of channels will determine the					\
+										the number of channels of this VarRate.											\
+						@param rate		The rate of playback where 1 is normal speed (this may be negative).			\
+						@param loop		A loop flag to indicate the Buffer should loop (1) or just play one-shot (0).	\
+						@param sourceSampleRate The sample rate of the data in the Buffer, 0 means the host sample rate.	\
+										The rate is scaled by this so a Buffer is played at its original pitch.			\
+						@param doneAction If looping is off and the done action is UGen::DeleteWhenDone then this		\
+										  UGen will fire a delete action when playback reaches the end of the Buffer.	\
+						@param quality	The interpolation quality (see Resampler::Quality).
+
+/** A UGen which plays back a Buffer at a variable rate with high quality interpolation.
+ 
+ This is similar to PlayBuf but uses polyphase windowed sinc interpolation rather than
+ linear interpolation. When the rate is above 1 the cutoff of the interpolation filter is 
+ lowered to avoid aliasing. This is more expensive than PlayBuf so use it for material which
+ is pitched up or down significantly or played back at a different sample rate.
+ 
+ @ingroup AllUGens SoundFileUGens
+ @see VarRateUGenInternal, Resampler, PlayBuf */
+UGenSublcassDeclaration(VarRate, (buffer, rate, loop, sourceSampleRate, doneAction, quality),
+						(Buffer const& buffer, 
+						 UGen const& rate = UGen::get1(), 
+						 UGen const& loop = UGen::get0(),
+						 const double sourceSampleRate = 0.0,
+						 const UGen::DoneAction doneAction = UGen::DeleteWhenDone,
+						 const Resampler::Quality quality = Resampler::Medium), COMMON_UGEN_DOCS VarRate_Docs);
+
+
+#endif // _UGEN_ugen_Resampler_H_
@@ -0,0 +1,420 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+
+#include "../core/ugen_StandardHeader.h"
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_Telemetry.h"
+#include "../core/ugen_UGen.h"
+#include "../core/ugen_Atomics.h"
+#include "../core/ugen_Bits.h"
+#include "../basics/ugen_InlineBinaryOps.h"
+
+//============================== TelemetryChannel ==============================
+
+TelemetryChannel::TelemetryChannel(TelemetrySender* ownerToUse, 
+								   const int numChannelsToUse, 
+								   const int maxFrameSizeToUse, 
+								   const int numSlotsToUse) throw()
+:	owner(ownerToUse),
+	service(0),
+	next(0),
+	nextRetiring(0),
+	retiree(0),
+	deliverOnRetire(false),
+	numChannels(ugen::max(1, numChannelsToUse)),
+	maxFrameSize(ugen::max(1, maxFrameSizeToUse)),
+	numSlots(Bits::nextPowerOf2(ugen::max(2, numSlotsToUse))),
+	mask(numSlots - 1),
+	slots(new Slot[numSlots]),
+	writeTotal(0),
+	readTotal(0),
+	numDropped(0),
+	released(0)
+{
+	for(int i = 0; i < numSlots; i++)
+	{
+		slots[i].frame = Buffer::newClear(maxFrameSize, numChannels, true);
+		slots[i].size = 0;
+		slots[i].value1 = 0.0;
+		slots[i].value2 = 0;
+	}
+}
+
+TelemetryChannel::~TelemetryChannel()
+{
+	delete [] slots;
+}
+
+bool TelemetryChannel::post(Buffer const& source, const int size, const double value1, const int value2) throw()
+{
+	if((int)(writeTotal - readTotal) >= numSlots)
+	{
+		numDropped++;
+		
+		if(service != 0)
+		{
+			Atomics::increment(service->totalDropped);
+			service->wake();
+		}
+		
+		return false;
+	}
+	
+	Slot& slot = slots[writeTotal & mask];
+	const int sizeToCopy = ugen::clip(size, 0, ugen::min(maxFrameSize, source.size()));
+	const int numSourceChannels = source.getNumChannels();
+	
+	for(int channel = 0; channel < numChannels; channel++)
+	{
+		float* const frameSamples = slot.frame.getData(channel);
+		
+		if(channel < numSourceChannels)
+			memcpy(frameSamples, source.getData(channel), sizeToCopy * sizeof(float));
+		else
+			memset(frameSamples, 0, sizeToCopy * sizeof(float));
+	}
+	
+	slot.size = sizeToCopy;
+	slot.value1 = value1;
+	slot.value2 = value2;
+	
+	// publish the frame only after it has been written
+	Atomics::memoryBarrier();
+	writeTotal = writeTotal + 1;
+	
+	if(service != 0)
+		service->wake();
+	
+	return true;
+}
+
+int TelemetryChannel::deliver() throw()
+{
+	int numFramesDelivered = 0;
+	unsigned int available = writeTotal - readTotal;
+	Atomics::memoryBarrier(); // read the frames only after reading the count
+	
+	while((available > 0) && (released == 0))
+	{
+		const Slot& slot = slots[readTotal & mask];
+		
+		// the receivers may keep the buffer so they get their own copy
+		Buffer frame = slot.size > 0 ? slot.frame.getRegion(0, slot.size - 1) : Buffer::newClear(0, numChannels);
+		const double value1 = slot.value1;
+		const int value2 = slot.value2;
+		
+		// finish reading the slot before handing it back to the producer
+		Atomics::memoryBarrier();
+		readTotal = readTotal + 1;
+		available--;
+		
+		owner->handleTelemetry(frame, value1, value2);
+		numFramesDelivered++;
+	}
+	
+	return numFramesDelivered;
+}
+
+void TelemetryChannel::release() throw()
+{
+	if(service == 0)
+	{
+		delete this; // never added to a service
+		return;
+	}
+	
+	TelemetryService* const serviceToWake = service;
+	Atomics::memoryBarrier();
+	released = 1;
+	serviceToWake->wake();
+}
+
+void TelemetryChannel::retire(SmartPointer* ownerInternal, const bool deliverPending) throw()
+{
+	if(service == 0)
+	{
+		// never added to a service
+		delete this;
+		UGen::getDeleter()->deleteInternal(ownerInternal);
+		return;
+	}
+	
+	retiree = ownerInternal;
+	deliverOnRetire = deliverPending;
+	
+	// the service thread may delete the channel as soon as it's pushed
+	TelemetryService* const serviceToWake = service;
+	TelemetryChannel* head;
+	
+	do
+	{
+		head = serviceToWake->retiring;
+		nextRetiring = head;
+	}
+	while(Atomics::compareAndSwapPointer(reinterpret_cast<void* volatile&> (serviceToWake->retiring), head, this) == false);
+	
+	serviceToWake->wake();
+}
+
+//============================== TelemetryService ==============================
+
+TelemetryService* volatile TelemetryService::instance = 0;
+
+TelemetryService::TelemetryService() throw()
+:	incoming(0),
+	retiring(0),
+	channels(0),
+	wakePending(0),
+	numChannels(0),
+	totalDropped(0),
+	totalDelivered(0.0)
+{
+}
+
+TelemetryService::~TelemetryService()
+{
+	stopThread();
+	adoptNewChannels();
+	retireChannels();
+	
+	while(channels != 0)
+	{
+		TelemetryChannel* const channel = channels;
+		channels = channel->next;
+		delete channel;
+	}
+}
+
+TelemetryService& TelemetryService::getInstance() throw()
+{
+	TelemetryService* service = instance;
+	
+	if(service == 0)
+	{
+		TelemetryService* newService = new TelemetryService();
+		
+		if(Atomics::compareAndSwapPointer(reinterpret_cast<void* volatile&> (instance), 0, newService))
+		{
+			if(newService->startThread() == false)
+				printf("TelemetryService: error: could not start the service thread\n");
+			
+			service = newService;
+		}
+		else
+		{
+			// another thread created it first
+			delete newService;
+			service = instance;
+		}
+	}
+	
+	return *service;
+}
+
+void TelemetryService::shutdown() throw()
+{
+	TelemetryService* service = (TelemetryService*)Atomics::exchangePointer(reinterpret_cast<void* volatile&> (instance), 0);
+	delete service;
+}
+
+void TelemetryService::add(TelemetryChannel* channel) throw()
+{
+	if(channel == 0) return;
+	
+	channel->service = this;
+	
+	TelemetryChannel* head;
+	
+	do
+	{
+		head = incoming;
+		channel->next = head;
+	}
+	while(Atomics::compareAndSwapPointer(reinterpret_cast<void* volatile&> (incoming), head, channel) == false);
+	
+	Atomics::increment(numChannels);
+	wake();
+}
+
+void TelemetryService::wake() throw()
+{
+	if(Atomics::compareAndSwap(wakePending, 0, 1))
+		wakeSemaphore.signal();
+}
+
+void TelemetryService::signalThreadShouldExit() throw()
+{
+	UGenThread::signalThreadShouldExit();
+	wakeSemaphore.signal();
+}
+
+void TelemetryService::adoptNewChannels() throw()
+{
+	TelemetryChannel* channel = (TelemetryChannel*)Atomics::exchangePointer(reinterpret_cast<void* volatile&> (incoming), 0);
+	
+	while(channel != 0)
+	{
+		TelemetryChannel* const nextChannel = channel->next;
+		channel->next = channels;
+		channels = channel;
+		channel = nextChannel;
+	}
+}
+
+int TelemetryService::retireChannels() throw()
+{
+	int numFramesDelivered = 0;
+	TelemetryChannel* channel = (TelemetryChannel*)Atomics::exchangePointer(reinterpret_cast<void* volatile&> (retiring), 0);
+	
+	while(channel != 0)
+	{
+		TelemetryChannel* const nextChannel = channel->nextRetiring;
+		
+		if(channel->deliverOnRetire)
+			numFramesDelivered += channel->deliver();
+		
+		// the owner has already let go of the channel, serviceChannels() deletes it
+		channel->released = 1;
+		UGen::getDeleter()->deleteInternal(channel->retiree);
+		
+		channel = nextChannel;
+	}
+	
+	totalDelivered += numFramesDelivered;
+	
+	return numFramesDelivered;
+}
+
+int TelemetryService::serviceChannels() throw()
+{
+	int numFramesDelivered = 0;
+	TelemetryChannel* previous = 0;
+	TelemetryChannel* channel = channels;
+	
+	while(channel != 0)
+	{
+		TelemetryChannel* const nextChannel = channel->next;
+		
+		if(channel->released)
+		{
+			if(previous == 0)
+				channels = nextChannel;
+			else
+				previous->next = nextChannel;
+			
+			Atomics::memoryBarrier();
+			delete channel;
+			Atomics::decrement(numChannels);
+		}
+		else
+		{
+			numFramesDelivered += channel->deliver();
+			previous = channel;
+		}
+		
+		channel = nextChannel;
+	}
+	
+	totalDelivered += numFramesDelivered;
+	
+	return numFramesDelivered;
+}
+
+void TelemetryService::run()
+{
+	while(threadShouldExit() == false)
+	{
+		wakePending = 0;
+		Atomics::memoryBarrier();
+		
+		adoptNewChannels();
+		
+		const int numRetiredFrames = retireChannels();
+		
+		if((serviceChannels() + numRetiredFrames) == 0)
+			wakeSemaphore.wait();
+	}
+}
+
+//============================== TelemetrySender ===============================
+
+TelemetrySender::TelemetrySender() throw()
+:	telemetry(0)
+{
+}
+
+TelemetrySender::~TelemetrySender()
+{
+	releaseTelemetry();
+}
+
+void TelemetrySender::handleTelemetry(Buffer const& frame, const double value1, const int value2) throw()
+{
+	sendBuffer(frame, value1, value2);
+}
+
+void TelemetrySender::initTelemetry(const int numChannels, const int maxFrameSize, const int numSlots) throw()
+{
+	releaseTelemetry();
+	
+	telemetry = new TelemetryChannel(this, numChannels, maxFrameSize, numSlots);
+	TelemetryService::getInstance().add(telemetry);
+}
+
+void TelemetrySender::releaseTelemetry() throw()
+{
+	if(telemetry == 0) return;
+	
+	telemetry->release();
+	telemetry = 0;
+}
+
+void TelemetrySender::retireTelemetry(SmartPointer* self, const bool deliverPending) throw()
+{
+	TelemetryChannel* const channel = telemetry;
+	telemetry = 0; // so the destructor doesn't release it again
+	
+	if(channel == 0)
+		UGen::getDeleter()->deleteInternal(self);
+	else
+		channel->retire(self, deliverPending);
+}
+
+END_UGEN_NAMESPACE
@@ -0,0 +1,286 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+
+#ifndef _UGEN_ugen_Telemetry_H_
+#define _UGEN_ugen_Telemetry_H_
+
+
+#include "../core/ugen_Threads.h"
+#include "ugen_Buffer.h"
+
+class TelemetrySender;
+class TelemetryService;
+
+/** A ring of preallocated frames carrying data from the audio thread to the TelemetryService.
+ 
+ Each slot holds a Buffer of getNumChannels() channels and getMaxFrameSize() samples plus the 
+ two values passed on to BufferReceiver::handleBuffer(). The ring has a single producer (the 
+ UGen on the audio thread) which only ever copies samples into a free slot, and is emptied by 
+ the service thread which copies each frame into a new Buffer and hands it to the owner's 
+ TelemetrySender::handleTelemetry(). If the ring is full the frame is dropped and counted 
+ rather than making the audio thread wait. 
+ 
+ The owner gives up the channel by calling release() or retire(), neither waits for the service 
+ thread and the service thread deletes the channel so no deallocation happens on the audio thread. 
+ 
+ @see TelemetrySender, TelemetryService */
+class TelemetryChannel
+{
+public:
+	TelemetryChannel(TelemetrySender* owner, 
+					 const int numChannels, 
+					 const int maxFrameSize, 
+					 const int numSlots) throw();
+	~TelemetryChannel();
+	
+	/// @name Producer
+	/// @{
+	
+	/** Copy a frame into the ring, this never allocates or blocks. 
+	 @param source	The data to copy, channels missing from this are cleared.
+	 @param size	The number of samples of each channel to copy (limited to getMaxFrameSize()).
+	 @param value1	Passed on with the frame.
+	 @param value2	Passed on with the frame.
+	 @return		false if the ring was full and the frame was dropped. */
+	bool post(Buffer const& source, const int size, const double value1, const int value2) throw();
+	
+	/** Give the channel to the service thread for deletion, the channel must not be used after this. 
+	 The owner's handleTelemetry() isn't called again once the service thread has seen this but a 
+	 call already in progress isn't waited for, so an owner which is about to be deleted should 
+	 use retire() instead. */
+	void release() throw();
+	
+	/** Give the channel and its owner to the service thread, the channel must not be used after this.
+	 The service thread delivers the frames still in the ring (if requested), deletes the owner 
+	 (using the current Deleter) and then the channel. This is how TelemetrySender UGenInternals 
+	 are deleted so the thread dropping the last reference never waits for a handler or does its
+	 final work (e.g., writing a file).
+	 @param ownerInternal	The owner, this must not be used by the caller after this.
+	 @param deliverPending	If true frames still in the ring are delivered before the owner is deleted. */
+	void retire(SmartPointer* ownerInternal, const bool deliverPending) throw();
+	
+	/// @} <!-- end Producer -->
+	
+	/// @name Information and statistics
+	/// @{
+	
+	inline int getNumChannels() const throw()		{ return numChannels;							}
+	inline int getMaxFrameSize() const throw()		{ return maxFrameSize;							}
+	inline int getNumSlots() const throw()			{ return numSlots;								}
+	
+	/** The number of frames waiting to be delivered. */
+	inline int getNumPending() const throw()		{ return (int)(writeTotal - readTotal);			}
+	
+	/** The number of frames posted successfully. */
+	inline unsigned int getNumPosted() const throw()	{ return writeTotal;							}
+	
+	/** The number of frames dropped because the ring was full. */
+	inline int getNumDropped() const throw()		{ return numDropped;							}
+	
+	/// @} <!-- end Information and statistics -->
+	
+	friend class TelemetryService;
+	
+private:
+	struct Slot
+	{
+		Buffer frame;
+		int size;
+		double value1;
+		int value2;
+	};
+	
+	int deliver() throw();
+	
+	TelemetrySender* const owner;
+	TelemetryService* service;
+	TelemetryChannel* next;
+	TelemetryChannel* nextRetiring;
+	SmartPointer* retiree;
+	bool deliverOnRetire;
+	
+	const int numChannels;
+	const int maxFrameSize;
+	const int numSlots;
+	const unsigned int mask;
+	Slot* slots;
+	
+	volatile unsigned int writeTotal;	// frames posted, advanced by the producer only
+	volatile unsigned int readTotal;	// frames delivered, advanced by the consumer only
+	volatile int numDropped;
+	volatile int released;				// the owner won't be called again, the service thread deletes the channel
+	
+	TelemetryChannel (const TelemetryChannel&);
+    const TelemetryChannel& operator= (const TelemetryChannel&);
+};
+
+/** The shared telemetry service.
+ 
+ One thread empties the rings of all the TelemetryChannel objects and calls their owners' 
+ handlers, so BufferReceiver objects (scopes, pollers, recorders etc) are called on this 
+ thread rather than the audio thread. The service runs at normal priority since receivers 
+ may do slow things like drawing or writing files.
+ 
+ @code
+	printf("telemetry frames dropped: %d\n", TelemetryService::getInstance().getTotalDropped());
+ @endcode
+ 
+ @see TelemetrySender */
+class TelemetryService : public UGenThread
+{
+public:
+	/** Get the shared service, creating and starting it if necessary. */
+	static TelemetryService& getInstance() throw();
+	
+	/** Stop the service thread and delete the service and all its channels. 
+	 This should only be called after all the UGens sending telemetry have been deleted. */
+	static void shutdown() throw();
+	
+	/** Add a channel, this is safe to call from any thread. */
+	void add(TelemetryChannel* channel) throw();
+	
+	/** Wake the service thread, this is safe to call from the audio thread. */
+	void wake() throw();
+	
+	/** The number of channels serviced. */
+	inline int getNumChannels() const throw()		{ return numChannels;							}
+	
+	/** The total number of frames dropped by all channels (including those deleted). */
+	inline int getTotalDropped() const throw()		{ return totalDropped;							}
+	
+	/** The total number of frames delivered. */
+	inline double getTotalDelivered() const throw()	{ return totalDelivered;						}
+	
+	/** @internal */
+	void run();
+	
+	/** @internal */
+	void signalThreadShouldExit() throw();
+	
+	friend class TelemetryChannel;
+	
+private:
+	TelemetryService() throw();
+	~TelemetryService();
+	
+	void adoptNewChannels() throw();
+	int retireChannels() throw();
+	int serviceChannels() throw();
+	
+	static TelemetryService* volatile instance;
+	
+	TelemetryChannel* volatile incoming;	// pushed by any thread
+	TelemetryChannel* volatile retiring;	// pushed by any thread
+	TelemetryChannel* channels;				// used by the service thread only
+	Semaphore wakeSemaphore;
+	volatile int wakePending;
+	volatile int numChannels;
+	volatile int totalDropped;
+	double totalDelivered;
+	
+	TelemetryService (const TelemetryService&);
+    const TelemetryService& operator= (const TelemetryService&);
+};
+
+/** A BufferSender whose buffers are sent from the TelemetryService thread.
+ 
+ UGenInternal subclasses which send data to BufferReceiver objects should derive from this 
+ rather than BufferSender. Call initTelemetry() (e.g., in the constructor) to allocate the 
+ ring then postTelemetry() on the audio thread, the receivers are then called on the service 
+ thread. Subclasses can override handleTelemetry() to do expensive processing of the frame
+ there too (e.g., the FFTSender cooks its spectra in this way).
+ 
+ UGenInternal subclasses must override SmartPointer::deleteUnreferenced() to call 
+ retireTelemetry(). They are then deleted on the service thread so handleTelemetry() can't be 
+ called on a partially destroyed object and the thread dropping the last reference (often 
+ the audio thread) never waits for the service thread.
+ 
+ @code
+	void PollUGenInternal::deleteUnreferenced() throw()
+	{
+		retireTelemetry(this);
+	}
+ @endcode
+ 
+ @see TelemetryChannel, TelemetryService, BufferSender */
+class TelemetrySender : public BufferSender
+{
+public:
+	TelemetrySender() throw();
+	~TelemetrySender();
+	
+	/** Called on the service thread with each frame posted.
+	 The default sends the frame to the receivers using BufferSender::sendBuffer(). */
+	virtual void handleTelemetry(Buffer const& frame, const double value1, const int value2) throw();
+	
+	/** The ring, this is 0 until initTelemetry() has been called. */
+	inline const TelemetryChannel* getTelemetryChannel() const throw()	{ return telemetry;		}
+	
+protected:
+	/** Allocate the ring, releasing any previous one.
+	 @param numChannels		The number of channels in each frame.
+	 @param maxFrameSize	The maximum number of samples in each channel of a frame.
+	 @param numSlots		The number of frames the ring can hold (rounded up to a power of 2). */
+	void initTelemetry(const int numChannels, const int maxFrameSize, const int numSlots = 8) throw();
+	
+	/** Copy a frame to the ring, this is safe to call from the audio thread. 
+	 @return false if the frame was dropped. */
+	inline bool postTelemetry(Buffer const& source, const int size, const double value1 = 0.0, const int value2 = 0) throw()
+	{
+		return (telemetry != 0) && telemetry->post(source, size, value1, value2);
+	}
+	
+	/** Release the ring without waiting, see TelemetryChannel::release(). 
+	 This is only safe while this object is alive so don't rely on it in the destructor, use 
+	 retireTelemetry() instead. */
+	void releaseTelemetry() throw();
+	
+	/** Hand the ring and this object to the service thread which deletes them.
+	 Call this from deleteUnreferenced(), see TelemetryChannel::retire().
+	 @param self			This object as a SmartPointer.
+	 @param deliverPending	If true frames still in the ring are handled (on the service thread) before
+							this object is deleted. */
+	void retireTelemetry(SmartPointer* self, const bool deliverPending = false) throw();
+	
+private:
+	TelemetryChannel* telemetry;
+};
+
+
+
+#endif // _UGEN_ugen_Telemetry_H_
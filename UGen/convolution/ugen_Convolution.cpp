@@ -38,7 +38,7 @@
 
 #if defined(UGEN_CONVOLUTION) && UGEN_CONVOLUTION
 
-#if !defined(WIN32) && !defined(UGEN_IPHONE) && !defined(UGEN_ANDROID)
+#if defined(__APPLE__) && !defined(UGEN_IPHONE) && !defined(UGEN_ANDROID)
 	#include <Accelerate/Accelerate.h>
 	#include <CoreServices/CoreServices.h>
 #endif
@@ -48,6 +48,10 @@
 BEGIN_UGEN_NAMESPACE
 #include "ugen_Convolution.h"
 #include "../fft/ugen_FFTEngineInternal.h"
+#include "../core/ugen_Atomics.h"
+#ifdef UGEN_SIMD
+#include "../vec/ugen_simd_Utilities.h"
+#endif
 
 
 PartBuffer::PartBuffer() throw()
@@ -210,7 +214,7 @@ PartConvolveUGenInternal::PartConvolveUGenInternal(UGen const& input,
 	fftSizeOver4(fftSize >> 2),
 	bufferSize(partImpulse.getBufferSize()),
 	resetAll(1),
-	fftEngine(partImpulse.getFFTEngine()),
+	fftEngine(partImpulse.getFFTEngine().createShared()),
 	scaleMultD(1.0 / (double) (fftSize)),// * 4)),	// trying without * 4 not sure the level output is right... yes without the *4 seems correct? not checked with fftw though (FFTReal and vDSP checked I think)
 	scaleMult(vecSplat((float) (scaleMultD))),
 	inputBuffer(BufferSpec((int)(bufferSize * 2), 1, UGEN_PARTCONVOLVE_CLEARBUFFERS)),
@@ -314,7 +318,7 @@ void PartConvolveUGenInternal::processBlock(bool& shouldDelete, const unsigned i
 		
 		tillNextFFT = randomStart;
 		rwPointer1 = (fftSizeHalved >> 2) - tillNextFFT;
-		rwPointer2 = rwPointer1 + tillNextFFT;
+		rwPointer2 = rwPointer1 + (fftSizeHalved >> 2); // one hop ahead, the buffers hold the same history rotated by a hop
 		fftOffset = 0;
 
 #ifdef UGEN_VDSP
@@ -590,7 +594,7 @@ void TimeConvolveUGenInternal::processBlock(bool& shouldDelete, const unsigned i
 	float *outputSamples = (float *)uGenOutput.getSampleData();
 	int numSamples = (int)uGenOutput.getBlockSize();
 	
-	float *filter = filters.getData(channel);
+	const float *filter = filters.getDataReadOnly(channel);
 	float *inputBufferSamples = ioBuffers.getData(TimeConvolveUGenInternal::InputBuffer);
 	long position = this->position;
 	long filterlength = filters.size();
@@ -631,6 +635,530 @@ TimeConvolve::TimeConvolve(UGen const& input,
 #endif // #if !defined(UGEN_FFTW) && !defined(UGEN_FFTREAL)
 
 
+/** output += left * right for spectra in the packed format used by FFTEngineInternal::fft()
+ i.e., with the (real) Nyquist value in place of the (zero) imaginary DC value. */
+static inline void complexMultiplyAccumulate(const float *leftReal, const float *leftImag, 
+											 const float *rightReal, const float *rightImag, 
+											 float *outputReal, float *outputImag, 
+											 const int numBins) throw()
+{
+	outputReal[0] += leftReal[0] * rightReal[0]; // DC
+	outputImag[0] += leftImag[0] * rightImag[0]; // Nyquist
+	
+#if defined(UGEN_VDSP)
+	DSPSplitComplex left, right, output;
+	left.realp = (float*)leftReal + 1;
+	left.imagp = (float*)leftImag + 1;
+	right.realp = (float*)rightReal + 1;
+	right.imagp = (float*)rightImag + 1;
+	output.realp = outputReal + 1;
+	output.imagp = outputImag + 1;
+	vDSP_zvma(&left, 1, &right, 1, &output, 1, &output, 1, numBins - 1);
+#elif defined(UGEN_SIMD)
+	SIMD::complexMultiplyAccumulate(leftReal + 1, leftImag + 1, 
+									rightReal + 1, rightImag + 1, 
+									outputReal + 1, outputImag + 1, 
+									numBins - 1);
+#else
+	for(int i = 1; i < numBins; i++)
+	{
+		outputReal[i] += leftReal[i] * rightReal[i] - leftImag[i] * rightImag[i];
+		outputImag[i] += leftReal[i] * rightImag[i] + leftImag[i] * rightReal[i];
+	}
+#endif
+}
+
+class ConvolveMatrixStage::Worker : public UGenThread
+{
+public:
+	Worker(ConvolveMatrixStage& stage) throw()
+	:	stage_(stage)
+	{
+	}
+	
+	~Worker()
+	{
+		stopThread();
+	}
+	
+	void signalThreadShouldExit() throw()
+	{
+		UGenThread::signalThreadShouldExit();
+		stage_.wakeWorker.signal();
+	}
+	
+	void run()
+	{
+		while(true)
+		{
+			stage_.wakeWorker.wait();
+			
+			if(threadShouldExit()) 
+				break;
+			
+			// the job fills the bank the audio thread is not reading
+			stage_.convolve(stage_.outputBank ^ 1);
+			
+			Atomics::memoryBarrier();
+			stage_.jobPending = 0;
+		}
+	}
+	
+private:
+	ConvolveMatrixStage& stage_;
+};
+
+ConvolveMatrixStage::ConvolveMatrixStage(Buffer const& impulses, 
+										 const int *pathInputsToUse, 
+										 const int *pathOutputsToUse, 
+										 const int numPathsToUse, 
+										 const int numInputsToUse, 
+										 const int numOutputsToUse,
+										 const int partitionSizeToUse, 
+										 const int endPoint,
+										 const bool shouldUseBackground) throw()
+:	numPaths(numPathsToUse),
+	numInputs(numInputsToUse),
+	numOutputs(numOutputsToUse),
+	partitionSize(partitionSizeToUse),
+	fftSize(partitionSizeToUse * 2),
+	startPoint(shouldUseBackground ? partitionSizeToUse * 2 : partitionSizeToUse),
+	numPartitions(ugen::max(1, quantiseUp(endPoint - startPoint, partitionSizeToUse) / partitionSizeToUse)),
+	background(shouldUseBackground),
+	position(0),
+	delayLineIndex(0),
+	outputBank(0),
+	jobPending(0),
+	numLateHops(0),
+	pathInputs(pathInputsToUse),
+	pathOutputs(pathOutputsToUse),
+	fftEngine(fftSize, FFTEngine::DefaultBackend, true),
+	impulseSpectra(BufferSpec(numPartitions * fftSize, numPaths, true)),
+	inputWindows(BufferSpec(fftSize, numInputs, true)),
+	jobWindows(BufferSpec(shouldUseBackground ? fftSize : 1, numInputs, true)),
+	delayLine(BufferSpec(numPartitions * fftSize, numInputs, true)),
+	outputBuffers(BufferSpec(partitionSize, numOutputs * 2, true)),
+	accumulator(BufferSpec(fftSize, 1, true)),
+	transform(BufferSpec(fftSize, 1, true)),
+	worker(0)
+{
+	ugen_assert(Bits::isPowerOf2(partitionSize));
+	
+	// apply the inverse FFT scaling to the impulse rather than to each output
+	const float scale = 1.f / fftSize;
+	const int impulseLength = ugen::min(impulses.size(), endPoint);
+	float * const partitionSamples = transform.getData();
+	
+	for(int path = 0; path < numPaths; path++)
+	{
+		const float * const impulseSamples = impulses.getData(path);
+		float * const spectra = impulseSpectra.getData(path);
+		
+		for(int partition = 0; partition < numPartitions; partition++)
+		{
+			const int partitionStart = startPoint + partitionSize * partition;
+			const int numSamples = ugen::max(0, ugen::min(partitionSize, impulseLength - partitionStart));
+			
+			for(int i = 0; i < numSamples; i++)
+				partitionSamples[i] = impulseSamples[partitionStart + i] * scale;
+			
+			memset(partitionSamples + numSamples, 0, (fftSize - numSamples) * sizeof(float));
+			
+			DSPSplitComplex spectrum;
+			spectrum.realp = spectra + partition * fftSize;
+			spectrum.imagp = spectrum.realp + partitionSize;
+			fftEngine.getInternal()->fft(spectrum, partitionSamples);
+		}
+	}
+	
+	if(background)
+	{
+		worker = new Worker(*this);
+		
+		if(worker->startThread())
+		{
+			worker->setRealtimePriority();
+		}
+		else
+		{
+			// the jobs will be done on the audio thread instead
+			delete worker;
+			worker = 0;
+		}
+	}
+}
+
+ConvolveMatrixStage::~ConvolveMatrixStage()
+{
+	delete worker; // waits for any job in progress
+}
+
+void ConvolveMatrixStage::process(const float * const *inputSamples, 
+								  float * const *outputSamples, 
+								  const int numSamples) throw()
+{
+	int offset = 0;
+	
+	while(offset < numSamples)
+	{
+		const int numSamplesThisTime = ugen::min(numSamples - offset, partitionSize - position);
+		
+		for(int output = 0; output < numOutputs; output++)
+		{
+			const float * const stageSamples = outputBuffers.getData(outputBank * numOutputs + output) + position;
+			float * const outputChannelSamples = outputSamples[output] + offset;
+			
+			for(int i = 0; i < numSamplesThisTime; i++)
+				outputChannelSamples[i] += stageSamples[i];
+		}
+		
+		for(int input = 0; input < numInputs; input++)
+		{
+			memcpy(inputWindows.getData(input) + partitionSize + position, 
+				   inputSamples[input] + offset, 
+				   numSamplesThisTime * sizeof(float));
+		}
+		
+		offset += numSamplesThisTime;
+		position += numSamplesThisTime;
+		
+		if(position == partitionSize)
+		{
+			hop();
+			position = 0;
+		}
+	}
+}
+
+void ConvolveMatrixStage::hop() throw()
+{
+	const int windowSizeBytes = fftSize * sizeof(float);
+	const int partitionSizeBytes = partitionSize * sizeof(float);
+	
+	if(background == false)
+	{
+		// the input windows are the previous and current partitions so the 
+		// second half of the inverse FFT is the overlap-save result
+		convolve(outputBank);
+	}
+	else 
+	{
+		// the job started at the previous hop is due now
+		if(jobPending)
+		{
+			numLateHops++;
+			
+			while(jobPending)
+				Atomics::pause();
+		}
+		
+		Atomics::memoryBarrier();
+		outputBank ^= 1;
+		
+		for(int input = 0; input < numInputs; input++)
+			memcpy(jobWindows.getData(input), inputWindows.getData(input), windowSizeBytes);
+		
+		if(worker != 0)
+		{
+			jobPending = 1;
+			Atomics::memoryBarrier();
+			wakeWorker.signal();
+		}
+		else
+		{
+			convolve(outputBank ^ 1);
+		}
+	}
+	
+	for(int input = 0; input < numInputs; input++)
+	{
+		float * const windowSamples = inputWindows.getData(input);
+		memcpy(windowSamples, windowSamples + partitionSize, partitionSizeBytes);
+	}
+}
+
+void ConvolveMatrixStage::convolve(const int bank) throw()
+{
+	FFTEngineInternal * const engine = fftEngine.getInternal();
+	Buffer& windows = background ? jobWindows : inputWindows;
+	
+	// one forward FFT per input into the delay line
+	if(++delayLineIndex >= numPartitions) 
+		delayLineIndex = 0;
+	
+	for(int input = 0; input < numInputs; input++)
+	{
+		DSPSplitComplex spectrum;
+		spectrum.realp = delayLine.getData(input) + delayLineIndex * fftSize;
+		spectrum.imagp = spectrum.realp + partitionSize;
+		engine->fft(spectrum, windows.getData(input));
+	}
+	
+	// accumulate every path to each output then one inverse FFT per output
+	DSPSplitComplex sum;
+	sum.realp = accumulator.getData();
+	sum.imagp = sum.realp + partitionSize;
+	
+	float * const transformSamples = transform.getData();
+	
+	for(int output = 0; output < numOutputs; output++)
+	{
+		bool hasPaths = false;
+		memset(sum.realp, 0, fftSize * sizeof(float));
+		
+		for(int path = 0; path < numPaths; path++)
+		{
+			if(pathOutputs[path] != output) continue;
+			
+			const float * const delayLineSamples = delayLine.getData(pathInputs[path]);
+			const float * const spectra = impulseSpectra.getData(path);
+			int index = delayLineIndex;
+			
+			for(int partition = 0; partition < numPartitions; partition++)
+			{
+				const float * const inputSpectrum = delayLineSamples + index * fftSize;
+				const float * const impulseSpectrum = spectra + partition * fftSize;
+				
+				complexMultiplyAccumulate(inputSpectrum, inputSpectrum + partitionSize,
+										  impulseSpectrum, impulseSpectrum + partitionSize,
+										  sum.realp, sum.imagp,
+										  partitionSize);
+				
+				if(--index < 0) 
+					index = numPartitions - 1;
+			}
+			
+			hasPaths = true;
+		}
+		
+		if(hasPaths)
+		{
+			engine->ifft(transformSamples, sum);
+			memcpy(outputBuffers.getData(bank * numOutputs + output), 
+				   transformSamples + partitionSize, 
+				   partitionSize * sizeof(float));
+		}
+	}
+}
+
+ConvolveMatrixUGenInternal::ConvolveMatrixUGenInternal(UGen const& input, 
+													   Buffer const& impulses, 
+													   const int numInputsToUse,
+													   const int numOutputsToUse, 
+													   const bool diagonal, 
+													   const int headSizeToUse, 
+													   const int maxPartitionSize,
+													   const int backgroundPartitionSize) throw()
+:	ProxyOwnerUGenInternal(NumInputs, numOutputsToUse - 1),
+	numInputs(numInputsToUse),
+	numOutputs(numOutputsToUse),
+	numPaths(diagonal ? numOutputsToUse : numInputsToUse * numOutputsToUse),
+	pathInputs(new int[numPaths]),
+	pathOutputs(new int[numPaths]),
+	headSize(ugen::max(8, (int)Bits::nextPowerOf2(headSizeToUse))),
+	headImpulses(BufferSpec(headSize, numPaths, true)),
+	headHistory(BufferSpec(headSize * 2, numInputs, true)),
+	stages(0),
+	numStages(0),
+	inputSamples(new const float*[numInputs]),
+	outputSamples(new float*[numOutputs])
+{
+	ugen_assert(numInputs > 0);
+	ugen_assert(numOutputs > 0);
+	
+	inputs[Input] = input;
+	
+	// gather the impulse for each path so each has its own channel
+	Buffer pathImpulses;
+	
+	for(int path = 0; path < numPaths; path++)
+	{
+		pathInputs[path] = diagonal ? path : path / numOutputs;
+		pathOutputs[path] = diagonal ? path : path % numOutputs;
+		pathImpulses <<= impulses.getChannel(path % impulses.getNumChannels());
+	}
+	
+	const int impulseLength = pathImpulses.size();
+	
+	for(int path = 0; path < numPaths; path++)
+	{
+		memcpy(headImpulses.getData(path), 
+			   pathImpulses.getData(path), 
+			   ugen::min(headSize, impulseLength) * sizeof(float));
+	}
+	
+	// partition sizes grow by 4 up to the maximum which then covers the remainder,
+	// a background stage starts at twice its partition size (never the first stage
+	// since the head only covers the first partition)
+	const int largestPartitionSize = ugen::max(headSize, (int)Bits::nextPowerOf2(maxPartitionSize));
+	
+	int partitionSizes[32];
+	bool backgrounds[32];
+	int startPoints[32];
+	
+	for(int partitionSize = headSize; numStages < numElementsInArray(partitionSizes); partitionSize *= 4)
+	{
+		const bool background = (numStages > 0) && 
+								(backgroundPartitionSize > 0) && 
+								(partitionSize >= backgroundPartitionSize);
+		const int startPoint = background ? partitionSize * 2 : partitionSize;
+		
+		if(startPoint >= impulseLength)
+			break;
+		
+		partitionSizes[numStages] = partitionSize;
+		backgrounds[numStages] = background;
+		startPoints[numStages] = startPoint;
+		numStages++;
+		
+		if((partitionSize * 4) > largestPartitionSize) 
+			break;
+	}
+	
+	if(numStages > 0)
+	{
+		stages = new ConvolveMatrixStage*[numStages];
+		
+		for(int stage = 0; stage < numStages; stage++)
+		{
+			const int endPoint = (stage == numStages - 1) ? impulseLength : startPoints[stage + 1];
+			
+			stages[stage] = new ConvolveMatrixStage(pathImpulses, pathInputs, pathOutputs, 
+													numPaths, numInputs, numOutputs, 
+													partitionSizes[stage], endPoint, 
+													backgrounds[stage]);
+		}
+	}
+}
+
+ConvolveMatrixUGenInternal::~ConvolveMatrixUGenInternal() throw()
+{
+	for(int stage = 0; stage < numStages; stage++)
+		delete stages[stage];
+	
+	delete [] stages;
+	delete [] pathInputs;
+	delete [] pathOutputs;
+	delete [] inputSamples;
+	delete [] outputSamples;
+}
+
+void ConvolveMatrixUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
+{
+	const int numSamples = uGenOutput.getBlockSize();
+	
+	for(int input = 0; input < numInputs; input++)
+	{
+		inputSamples[input] = inputs[Input].processBlock(shouldDelete, blockID, input);
+	}
+	
+	for(int output = 0; output < numOutputs; output++)
+	{
+		outputSamples[output] = proxies[output]->getSampleData();
+		memset(outputSamples[output], 0, numSamples * sizeof(float));
+	}
+	
+	processHead(numSamples);
+	
+	for(int stage = 0; stage < numStages; stage++)
+	{
+		stages[stage]->process(inputSamples, outputSamples, numSamples);
+	}
+}
+
+void ConvolveMatrixUGenInternal::processHead(const int numSamples) throw()
+{
+	// the history holds the previous headSize input samples followed by up to headSize new ones
+	int offset = 0;
+	
+	while(offset < numSamples)
+	{
+		const int numSamplesThisTime = ugen::min(numSamples - offset, headSize);
+		
+		for(int input = 0; input < numInputs; input++)
+		{
+			memcpy(headHistory.getData(input) + headSize, 
+				   inputSamples[input] + offset, 
+				   numSamplesThisTime * sizeof(float));
+		}
+		
+		for(int path = 0; path < numPaths; path++)
+		{
+			const float * const historySamples = headHistory.getData(pathInputs[path]) + headSize;
+			const float * const impulseSamples = headImpulses.getData(path);
+			float * const outputChannelSamples = outputSamples[pathOutputs[path]] + offset;
+			
+			for(int tap = 0; tap < headSize; tap++)
+			{
+				const float coefficient = impulseSamples[tap];
+				
+				if(coefficient == 0.f) continue;
+				
+				const float * const delayedSamples = historySamples - tap;
+				
+				for(int i = 0; i < numSamplesThisTime; i++)
+					outputChannelSamples[i] += coefficient * delayedSamples[i];
+			}
+		}
+		
+		for(int input = 0; input < numInputs; input++)
+		{
+			float * const historySamples = headHistory.getData(input);
+			memmove(historySamples, historySamples + numSamplesThisTime, headSize * sizeof(float));
+		}
+		
+		offset += numSamplesThisTime;
+	}
+}
+
+ConvolveMatrix::ConvolveMatrix(UGen const& input, 
+							   Buffer const& impulses, 
+							   const int numOutputs, 
+							   const int headSize, 
+							   const int maxPartitionSize,
+							   const int backgroundPartitionSize) throw()
+{
+	const int numInputs = input.getNumChannels();
+	
+	ConvolveMatrixUGenInternal *internal = new ConvolveMatrixUGenInternal(input, impulses, 
+																		  numInputs, numOutputs, false, 
+																		  headSize, maxPartitionSize, 
+																		  backgroundPartitionSize);
+	initInternal(numOutputs);
+	generateFromProxyOwner(internal);
+}
+
+ZeroLatencyConvolve::ZeroLatencyConvolve(UGen const& input, 
+										 Buffer const& impulse, 
+										 const int backgroundPartitionSize) throw()
+{
+	const int numChannels = ugen::max(input.getNumChannels(), impulse.getNumChannels());
+	
+	ConvolveMatrixUGenInternal *internal = new ConvolveMatrixUGenInternal(input.withNumChannels(numChannels), impulse, 
+																		  numChannels, numChannels, true, 
+																		  128, 8192, backgroundPartitionSize);
+	initInternal(numChannels);
+	generateFromProxyOwner(internal);
+}
+
+TrueStereoConvolve::TrueStereoConvolve(UGen const& input, 
+									   Buffer const& impulseLeft, 
+									   Buffer const& impulseRight, 
+									   const int backgroundPartitionSize) throw()
+{
+	// a 2x2 matrix: left to left, left to right, right to left, right to right
+	const Buffer impulses = impulseLeft.getChannel(0) 
+						 << impulseLeft.getChannel(1 % impulseLeft.getNumChannels())
+						 << impulseRight.getChannel(0)
+						 << impulseRight.getChannel(1 % impulseRight.getNumChannels());
+	
+	ConvolveMatrixUGenInternal *internal = new ConvolveMatrixUGenInternal(input.withNumChannels(2), impulses, 
+																		  2, 2, false, 
+																		  128, 8192, backgroundPartitionSize);
+	initInternal(2);
+	generateFromProxyOwner(internal);
+}
+
 END_UGEN_NAMESPACE
 
 #endif
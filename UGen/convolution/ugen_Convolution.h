@@ -45,6 +45,7 @@
 #include "../basics/ugen_MixUGen.h"
 #include "../fft/ugen_FFTEngineInternal.h"
 #include "../fft/ugen_FFTEngine.h"
+#include "../core/ugen_Threads.h"
 
 
 /** Stores a "partitioned" FFT buffer. */
@@ -201,16 +202,7 @@ public:
 };
 
 
-#if defined(UGEN_FFTW) || defined(UGEN_FFTREAL)
-DefineCustomUGen(ZeroLatencyConvolve,
-				 (Mix(UGenArray(PartConvolve(input, impulse, 8192, 0, 14)) <<
-					 UGenArray(PartConvolve(input, impulse, 2048, 8192, 12)) <<
-					 UGenArray(PartConvolve(input, impulse, 512, 2048, 10)) <<
-					 UGenArray(PartConvolve(input, impulse, 128, 512, 8)) <<
-					 UGenArray(PartConvolve(input, impulse, 0, 128, 6)))),			// No TimeConvolve yet on Windows
-				 (UGen const& input, Buffer const& impulse), COMMON_UGEN_DOCS);
-
-#else // assume we have the Mac vDSP interfaces
+#if !defined(UGEN_FFTW) && !defined(UGEN_FFTREAL) // assume we have the Mac vDSP interfaces
 
 /** A UGenInternal which performs time domain convolution.
  @ingroup UGenInternals */
@@ -248,25 +240,223 @@ UGenSublcassDeclaration(TimeConvolve, (input, impulse, startPoint, endPoint, dum
 						 long endPoint = 0, 
 						 long dummy = 0), COMMON_UGEN_DOCS);
 
+#endif // assumed we have the Mac vDSP interfaces
+
+
+/** One partition size of a ConvolveMatrixUGenInternal.
+ 
+ This is a uniformly partitioned overlap-save convolution with a partition size P 
+ (and FFT size 2P) of all the paths through the impulse matrix, over a region of 
+ the impulses starting at P. Starting at P means the result for the next P samples 
+ is available as soon as P new input samples have been received so the stage adds 
+ no latency. 
+ 
+ Each input channel is transformed only once per hop and its spectra are kept in a 
+ frequency-domain delay line (FDL) which is shared by all the paths from that input. 
+ The spectra of the paths to each output are then multiplied with the FDL and 
+ accumulated before a single inverse FFT per output.
+ 
+ A background stage starts at 2P instead so the result of each hop is not needed 
+ until the following hop. The work is then done on the stage's own worker thread 
+ with a deadline of one partition, this avoids the CPU spike in the audio callback 
+ each time a large FFT falls due. If the worker misses its deadline the audio thread
+ waits for it (see getNumLateHops()).
+ @see ConvolveMatrixUGenInternal */
+class ConvolveMatrixStage
+{
+public:
+	/** Partition the impulses.
+	 @param impulses			The impulse response for each path.
+	 @param pathInputs			The input channel of each path (this must outlive the stage).
+	 @param pathOutputs			The output channel of each path (this must outlive the stage).
+	 @param numPaths			The number of paths (and the size of the path arrays).
+	 @param numInputs			The number of input channels.
+	 @param numOutputs			The number of output channels.
+	 @param partitionSize		The partition size P, this must be a power of 2 of at least 8.
+	 @param endPoint			The sample offset (exclusive) in the impulses for the end of the 
+								stage's region, the region starts at @c partitionSize (or 
+								twice @c partitionSize for a background stage).
+	 @param background			Whether to process the partitions on a worker thread. */
+	ConvolveMatrixStage(Buffer const& impulses, 
+						const int *pathInputs, 
+						const int *pathOutputs, 
+						const int numPaths, 
+						const int numInputs, 
+						const int numOutputs,
+						const int partitionSize, 
+						const int endPoint,
+						const bool background = false) throw();
+	
+	~ConvolveMatrixStage();
+	
+	/** Add this stage's output to the output channels and consume the input channels.
+	 @param inputSamples	An array of numInputs pointers to the input samples.
+	 @param outputSamples	An array of numOutputs pointers to the output samples.
+	 @param numSamples		The number of samples to process. */
+	void process(const float * const *inputSamples, float * const *outputSamples, const int numSamples) throw();
+	
+	inline int getPartitionSize() const throw() { return partitionSize; }
+	inline int getNumPartitions() const throw() { return numPartitions; }
+	inline int getStartPoint() const throw()	{ return startPoint;	}
+	inline bool isBackground() const throw()	{ return background;	}
+	
+	/** The number of hops where the audio thread had to wait for the worker thread. */
+	inline int getNumLateHops() const throw()	{ return numLateHops;	}
+	
+private:
+	void hop() throw();
+	void convolve(const int outputBank) throw();
+	
+	class Worker;
+	friend class Worker;
+	
+	const int numPaths, numInputs, numOutputs;
+	const int partitionSize, fftSize, startPoint, numPartitions;
+	const bool background;
+	int position, delayLineIndex, outputBank;
+	volatile int jobPending;
+	int numLateHops;
+	
+	const int * const pathInputs;
+	const int * const pathOutputs;
+	FFTEngine fftEngine;
+	Buffer impulseSpectra;	// per path channel: numPartitions spectra of fftSize (real then imag)
+	Buffer inputWindows;	// per input channel: the previous and current partition of input
+	Buffer jobWindows;		// per input channel: the input windows for the worker thread
+	Buffer delayLine;		// per input channel: numPartitions spectra of fftSize
+	Buffer outputBuffers;	// per output channel and bank: the output for the next partitionSize samples
+	Buffer accumulator;		// spectrum of the sum of the paths to one output
+	Buffer transform;		// time domain result of the inverse FFT
+	
+	Semaphore wakeWorker;
+	Worker* worker;
+	
+	ConvolveMatrixStage (const ConvolveMatrixStage&);
+	const ConvolveMatrixStage& operator= (const ConvolveMatrixStage&);
+};
+
+/** A UGenInternal that performs real time, zero latency convolution through a matrix of impulses.
+ 
+ The first @c headSize samples of each impulse are convolved in the time domain (a 
+ direct form FIR) and the remainder by a series of ConvolveMatrixStage objects whose 
+ partition size starts at @c headSize and grows by a factor of 4 up to @c maxPartitionSize.
+ Each of these stages covers the region [P, 4P) of the impulses (i.e., three partitions)
+ except the last which covers the remainder of the impulse. Stages with a partition size 
+ of at least @c backgroundPartitionSize are background stages (see ConvolveMatrixStage) 
+ which cover [2P, 8P) so the stage before each of these extends to cover up to 2P.
+ 
+ This is a ProxyOwnerUGenInternal with a proxy for each output channel.
+ @ingroup UGenInternals
+ @see ConvolveMatrix, ZeroLatencyConvolve, TrueStereoConvolve */
+class ConvolveMatrixUGenInternal : public ProxyOwnerUGenInternal
+{
+public:
+	/** Construct a convolution matrix. 
+	 @param input				The input, this must have @c numInputs channels.
+	 @param impulses			The impulse responses.
+	 @param numInputs			The number of input channels.
+	 @param numOutputs			The number of output channels.
+	 @param diagonal			If true there is one path per output where output channel N
+								is the input channel N convolved with impulse channel N (wrapping
+								the impulse channels), as for ZeroLatencyConvolve. If false there 
+								is a path from every input to every output where the path from 
+								input I to output O uses impulse channel (I * numOutputs + O).
+	 @param headSize			The length of the direct form FIR at the start of each impulse.
+	 @param maxPartitionSize	The largest partition size. 
+	 @param backgroundPartitionSize	The smallest partition size to process on worker threads, 
+								0 processes all partitions on the audio thread. */
+	ConvolveMatrixUGenInternal(UGen const& input, 
+							   Buffer const& impulses, 
+							   const int numInputs,
+							   const int numOutputs, 
+							   const bool diagonal, 
+							   const int headSize, 
+							   const int maxPartitionSize,
+							   const int backgroundPartitionSize = 0) throw();
+	~ConvolveMatrixUGenInternal() throw();
+	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	
+	enum Inputs { Input, NumInputs };
+	
+protected:
+	void processHead(const int numSamples) throw();
+	
+	const int numInputs, numOutputs, numPaths;
+	int *pathInputs;
+	int *pathOutputs;
+	const int headSize;
+	Buffer headImpulses;	// per path channel: the first headSize samples of the impulse
+	Buffer headHistory;		// per input channel: the previous headSize samples then the current input
+	
+	ConvolveMatrixStage **stages;
+	int numStages;
+	
+	const float **inputSamples;
+	float **outputSamples;
+};
+
+#define ConvolveMatrix_Docs		@param input			The input signal to convolve, this determines the		\
+														number of inputs to the matrix.							\
+								@param impulses			The impulse responses. The path from input channel I	\
+														to output channel O uses impulse channel				\
+														(I * numOutputs + O), the impulse channels wrap if		\
+														there are fewer than this.								\
+								@param numOutputs		The number of output channels.							\
+								@param headSize			The length of the time domain convolution at the		\
+														start of each impulse. This is rounded up to a power	\
+														of 2 (128 is default).									\
+								@param maxPartitionSize	The largest FFT partition size (8192 is default).		\
+								@param backgroundPartitionSize	Partitions of at least this size are		\
+														processed on worker threads (with one partition of	\
+														latency which is hidden by the smaller partitions)	\
+														to avoid CPU spikes in the audio callback. The		\
+														default of 0 processes everything in the callback.
+
+/** Real time, zero latency convolution of N inputs with an N x M matrix of impulses.
+ This is suitable for true stereo (2 x 2) or ambisonic (e.g., 4 x 4 B-format) 
+ impulse responses. Each input channel is transformed only once per partition 
+ size regardless of the number of outputs.
+ @see ZeroLatencyConvolve, TrueStereoConvolve
+ @ingroup FFTUGens FilterUGens AllUGens */
+class ConvolveMatrix : public UGen
+{
+public:
+	PREDOC(ConvolveMatrix_Docs)
+	ConvolveMatrix(UGen const& input, Buffer const& impulses, const int numOutputs, 
+				   const int headSize = 128, const int maxPartitionSize = 8192, 
+				   const int backgroundPartitionSize = 0) throw();
+	
+	PREDOC(ConvolveMatrix_Docs)
+	static UGen AR(UGen const& input, Buffer const& impulses, const int numOutputs, 
+				   const int headSize = 128, const int maxPartitionSize = 8192, 
+				   const int backgroundPartitionSize = 0) throw()
+	{
+		return ConvolveMatrix(input, impulses, numOutputs, headSize, maxPartitionSize, backgroundPartitionSize);
+	}
+};
+
 /** Real time zero latency convolution. 
+ The number of channels will be determined by the larger of the number
+ of channels in the impulse Buffer and the input UGen, each channel of the 
+ input is convolved with the corresponding channel of the impulse.
+ Partitions of at least @c backgroundPartitionSize (if this is not 0) are 
+ processed on worker threads, see ConvolveMatrix.
+ @see ConvolveMatrix
  @ingroup FFTUGens */
-DefineCustomUGen(ZeroLatencyConvolve,
-				 (Mix(UGenArray(PartConvolve(input, impulse, 8192, 0, 14)) <<
-					 UGenArray(PartConvolve(input, impulse, 2048, 8192, 12)) <<
-					 UGenArray(PartConvolve(input, impulse, 512, 2048, 10)) <<
-					 UGenArray(PartConvolve(input, impulse, 128, 512, 8)) <<
-					 UGenArray(TimeConvolve(input, impulse, 0, 128)))),
-				 (UGen const& input, Buffer const& impulse),
-				 COMMON_UGEN_DOCS);
-
-#endif // assumed we have the Mac vDSP interfaces
+UGenSublcassDeclaration(ZeroLatencyConvolve, (input, impulse, backgroundPartitionSize), 
+						(UGen const& input, Buffer const& impulse, const int backgroundPartitionSize = 0), 
+						COMMON_UGEN_DOCS);
 
 /** True stereo, real time, zero latency convolution ! 
+ The @c impulseLeft is the (stereo) response to the left input channel and
+ the @c impulseRight is the response to the right input channel. 
+ The @c backgroundPartitionSize is as for ZeroLatencyConvolve.
+ @see ConvolveMatrix
  @ingroup FFTUGens */
-DefineCustomUGen(TrueStereoConvolve,
-				 (ZeroLatencyConvolve(input, impulseLeft)+ZeroLatencyConvolve(input, impulseRight)),
-				 (UGen const& input, Buffer const& impulseLeft, Buffer const& impulseRight),
-				 COMMON_UGEN_DOCS);
+UGenSublcassDeclaration(TrueStereoConvolve, (input, impulseLeft, impulseRight, backgroundPartitionSize), 
+						(UGen const& input, Buffer const& impulseLeft, Buffer const& impulseRight, 
+						 const int backgroundPartitionSize = 0), 
+						COMMON_UGEN_DOCS);
 
 
 
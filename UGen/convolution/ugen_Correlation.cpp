@@ -36,7 +36,7 @@
 
 //#if defined(UGEN_CONVOLUTION) && UGEN_CONVOLUTION
 //
-//#if !defined(WIN32) && !defined(UGEN_IPHONE) && !defined(UGEN_ANDROID)
+//#if defined(__APPLE__) && !defined(UGEN_IPHONE) && !defined(UGEN_ANDROID)
 //	#include <Accelerate/Accelerate.h>
 //	#include <CoreServices/CoreServices.h>
 //#endif
@@ -1972,11 +1972,9 @@ public:
 		
 		if(thisArray != 0)
 		{
-			const int size = this->size();
-			for(int i = 0; i < size; i++)
-			{
-				thisArray[i] = nullTerminatedSourceArray[i];
-			}			
+			const int length = this->length();
+			memcpy(thisArray, nullTerminatedSourceArray, length * sizeof(NumericalType));
+			thisArray[length] = 0;
 		}
 	}
 	
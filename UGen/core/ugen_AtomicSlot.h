@@ -0,0 +1,197 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#ifndef UGEN_ATOMICSLOT_H
+#define UGEN_ATOMICSLOT_H
+
+#include "ugen_Atomics.h"
+
+/** Hands objects from a publishing thread to a realtime thread without locks.
+ 
+ This is a read-copy-update scheme for things like the root graph of a host. The 
+ publisher (e.g., the message thread) builds a complete new object and publish()es it,
+ the realtime thread picks it up with acquire() at its next block boundary. The object 
+ it was using is retired rather than deleted: retired objects are deleted by the 
+ publisher the next time it calls publish() or reclaim(), so the realtime thread never 
+ waits, allocates or frees memory.
+ 
+ There may be only one thread calling acquire() and the publishing calls (publish(),
+ reclaim(), getLatest()) must be serialised by the caller (e.g., by only calling them
+ from the message thread or by holding a lock which the realtime thread never takes). 
+ 
+ @code
+	AtomicSlot<Graph> slot;
+ 
+	// message thread
+	Graph* graph = new Graph(*slot.getLatest());
+	graph->others.add(scope);
+	slot.publish(graph);
+	
+	// audio thread
+	Graph* graph = slot.acquire();
+	if(graph != 0) graph->output.prepareAndProcessBlock(blockSize, blockID, -1);
+ @endcode
+ 
+ @see DeferredDeleter */
+template<class ObjectType>
+class AtomicSlot
+{
+public:
+	AtomicSlot() throw()
+	:	pending(0),
+		current(0),
+		retired(0),
+		latest(0),
+		numSwaps(0)
+	{
+	}
+	
+	/** Deletes all of the objects. 
+	 The realtime thread must have stopped calling acquire() before this is destroyed. */
+	~AtomicSlot()
+	{
+		reclaim();
+		
+		Node* node = static_cast<Node*> (Atomics::exchangePointer(reinterpret_cast<void* volatile&> (pending), 0));
+		
+		if(node != 0)
+		{
+			delete node->object;
+			delete node;
+		}
+		
+		if(current != 0)
+		{
+			delete current->object;
+			delete current;
+		}
+	}
+	
+	/** Publish a new object, the slot takes ownership of it. 
+	 If the previous object published hasn't been acquired yet it is deleted straight away. */
+	void publish(ObjectType* object) throw()
+	{
+		reclaim();
+		
+		Node* node = new Node(object);
+		latest = object;
+		
+		Node* previous = static_cast<Node*> (Atomics::exchangePointer(reinterpret_cast<void* volatile&> (pending), node));
+		
+		if(previous != 0)
+		{
+			delete previous->object;
+			delete previous;
+		}
+	}
+	
+	/** Get the object most recently published, for building the next one from. 
+	 This is only safe to use on the publishing thread. */
+	inline ObjectType* getLatest() const throw()	{ return latest; }
+	
+	/** Delete the retired objects, returns the number deleted. */
+	int reclaim() throw()
+	{
+		Node* node = static_cast<Node*> (Atomics::exchangePointer(reinterpret_cast<void* volatile&> (retired), 0));
+		int numDeleted = 0;
+		
+		while(node != 0)
+		{
+			Node* next = node->next;
+			delete node->object;
+			delete node;
+			node = next;
+			numDeleted++;
+		}
+		
+		return numDeleted;
+	}
+	
+	/** Get the current object on the realtime thread, switching to a newly published object if there is one. 
+	 This doesn't block or allocate. 
+	 @return The current object, or 0 if nothing has been published. */
+	ObjectType* acquire() throw()
+	{
+		if(pending != 0)
+		{
+			Node* node = static_cast<Node*> (Atomics::exchangePointer(reinterpret_cast<void* volatile&> (pending), 0));
+			
+			if(node != 0)
+			{
+				if(current != 0) retire(current);
+				current = node;
+				numSwaps++;
+			}
+		}
+		
+		return current != 0 ? current->object : 0;
+	}
+	
+	/** The number of objects picked up by acquire(). */
+	inline int getNumSwaps() const throw()			{ return numSwaps; }
+	
+private:
+	struct Node
+	{
+		Node(ObjectType* object_) throw() : object(object_), next(0) { }
+		ObjectType* object;
+		Node* next;
+	};
+	
+	void retire(Node* node) throw()
+	{
+		Node* head;
+		
+		do 
+		{
+			head = retired;
+			node->next = head;
+		} 
+		while(Atomics::compareAndSwapPointer(reinterpret_cast<void* volatile&> (retired), head, node) == false);
+	}
+	
+	Node* volatile pending;		// published but not yet acquired
+	Node* current;				// used by the realtime thread only
+	Node* volatile retired;		// waiting for the publisher to delete them
+	ObjectType* latest;			// used by the publisher only
+	volatile int numSwaps;
+	
+	AtomicSlot (const AtomicSlot&);
+    const AtomicSlot& operator= (const AtomicSlot&);
+};
+
+#endif // UGEN_ATOMICSLOT_H
@@ -0,0 +1,143 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#ifndef UGEN_ATOMICS_H
+#define UGEN_ATOMICS_H
+
+/** Atomic operations on 32-bit integers and pointers.
+ 
+ These are used where the rendering engine shares data between threads without 
+ locks (e.g., the ParallelRenderer). All of the read-modify-write operations are
+ full memory barriers. 
+ 
+ This uses the compiler intrinsics for GCC/Clang (__sync) and MSVC (Interlocked). */
+class Atomics
+{
+public:
+	/** Atomically add one and return the new value. */
+	static inline int increment(volatile int& value) throw()
+	{
+#if defined(_MSC_VER)
+		return _InterlockedIncrement(reinterpret_cast<volatile long*> (&value));
+#else
+		return __sync_add_and_fetch(&value, 1);
+#endif
+	}
+	
+	/** Atomically subtract one and return the new value. */
+	static inline int decrement(volatile int& value) throw()
+	{
+#if defined(_MSC_VER)
+		return _InterlockedDecrement(reinterpret_cast<volatile long*> (&value));
+#else
+		return __sync_sub_and_fetch(&value, 1);
+#endif
+	}
+	
+	/** Atomically add an amount and return the new value. */
+	static inline int add(volatile int& value, const int amount) throw()
+	{
+#if defined(_MSC_VER)
+		return _InterlockedExchangeAdd(reinterpret_cast<volatile long*> (&value), amount) + amount;
+#else
+		return __sync_add_and_fetch(&value, amount);
+#endif
+	}
+	
+	/** Atomically set value to newValue if it is currently equal to oldValue. 
+	 Returns true if the swap was made. */
+	static inline bool compareAndSwap(volatile int& value, const int oldValue, const int newValue) throw()
+	{
+#if defined(_MSC_VER)
+		return _InterlockedCompareExchange(reinterpret_cast<volatile long*> (&value), newValue, oldValue) == oldValue;
+#else
+		return __sync_bool_compare_and_swap(&value, oldValue, newValue);
+#endif
+	}
+	
+	/** Atomically set value to newValue if it is currently equal to oldValue. 
+	 Returns true if the swap was made. */
+	static inline bool compareAndSwap(volatile unsigned int& value, const unsigned int oldValue, const unsigned int newValue) throw()
+	{
+		return compareAndSwap(reinterpret_cast<volatile int&> (value), (int)oldValue, (int)newValue);
+	}
+	
+	/** Atomically set a pointer to newValue if it is currently equal to oldValue. 
+	 Returns true if the swap was made. */
+	static inline bool compareAndSwapPointer(void* volatile& value, void* oldValue, void* newValue) throw()
+	{
+#if defined(_MSC_VER)
+		return _InterlockedCompareExchangePointer(&value, newValue, oldValue) == oldValue;
+#else
+		return __sync_bool_compare_and_swap(&value, oldValue, newValue);
+#endif
+	}
+	
+	/** Atomically set a pointer to newValue and return its previous value. */
+	static inline void* exchangePointer(void* volatile& value, void* newValue) throw()
+	{
+#if defined(_MSC_VER)
+		return _InterlockedExchangePointer(&value, newValue);
+#else
+		__sync_synchronize(); // __sync_lock_test_and_set is only an acquire barrier
+		return __sync_lock_test_and_set(&value, newValue);
+#endif
+	}
+	
+	/** A full memory barrier. */
+	static inline void memoryBarrier() throw()
+	{
+#if defined(_MSC_VER)
+		_ReadWriteBarrier();
+		_mm_mfence();
+#else
+		__sync_synchronize();
+#endif
+	}
+	
+	/** A hint to the processor that this is a spin-wait loop. */
+	static inline void pause() throw()
+	{
+#if defined(_MSC_VER)
+		_mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+		__builtin_ia32_pause();
+#endif
+	}
+};
+
+#endif // UGEN_ATOMICS_H
@@ -0,0 +1,198 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#include "../core/ugen_StandardHeader.h"
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_DeferredDeleter.h"
+#include "ugen_Atomics.h"
+
+/** The time in microseconds, wrapped to 32 bits and never 0 so it can mark an empty batch. */
+static int getMicrosecondStamp() throw()
+{
+	const double micros = fmod(UGenThread::getMillisecondCounterHiRes() * 1000.0, 4294967296.0);
+	return (int)((unsigned int)micros | 1U);
+}
+
+DeferredDeleter::DeferredDeleter(const int intervalMs) throw()
+:	intervalMs_(intervalMs < 1 ? 1 : intervalMs),
+	head(&stub),
+	tail(&stub),
+	consumerLock(0),
+	batchStart(0),
+	numPending(0),
+	maxPending(0),
+	numReclaimed(0),
+	lastLatency(0.0),
+	maxLatency(0.0)
+{
+	startThread();
+}
+
+DeferredDeleter::~DeferredDeleter() throw()
+{
+	stopThread();
+	flush();
+}
+
+void DeferredDeleter::push(SmartPointer* internal) throw()
+{
+	internal->nextToDelete = 0;
+	SmartPointer* previous = static_cast<SmartPointer*> (Atomics::exchangePointer(reinterpret_cast<void* volatile&> (head), internal));
+	previous->nextToDelete = internal;
+}
+
+SmartPointer* DeferredDeleter::pop() throw()
+{
+	SmartPointer* first = tail;
+	SmartPointer* next = first->nextToDelete;
+	
+	if(first == &stub)
+	{
+		if(next == 0) 
+			return 0;
+		
+		tail = next;
+		first = next;
+		next = next->nextToDelete;
+	}
+	
+	if(next != 0)
+	{
+		tail = next;
+		return first;
+	}
+	
+	if(first != head) 
+		return 0; // a push is half way through, it will be there next time
+	
+	// first is the last item, put the stub back behind it so it can be removed
+	push(&stub);
+	next = first->nextToDelete;
+	
+	if(next != 0)
+	{
+		tail = next;
+		return first;
+	}
+	
+	return 0;
+}
+
+void DeferredDeleter::deleteInternal(SmartPointer* internalToDelete) throw()
+{
+	if(internalToDelete == 0) return;
+	
+	if(batchStart == 0)
+		Atomics::compareAndSwap(batchStart, 0, getMicrosecondStamp());
+	
+	push(internalToDelete);
+	
+	const int pending = Atomics::increment(numPending);
+	
+	if(pending > maxPending) 
+		maxPending = pending; // only statistics so a lost update doesn't matter
+}
+
+int DeferredDeleter::reclaim() throw()
+{
+	while(Atomics::compareAndSwap(consumerLock, 0, 1) == false)
+		UGenThread::yield();
+	
+	// objects pushed from now on start a new batch
+	const int start = batchStart;
+	
+	if(start != 0)
+		Atomics::compareAndSwap(batchStart, start, 0);
+	
+	int numDeleted = 0;
+	SmartPointer* internal;
+	
+	while((internal = pop()) != 0)
+	{
+		delete internal;
+		numDeleted++;
+	}
+	
+	if(numDeleted > 0)
+	{
+		Atomics::add(numPending, -numDeleted);
+		numReclaimed += numDeleted;
+		
+		if(start != 0)
+		{
+			lastLatency = (double)((unsigned int)getMicrosecondStamp() - (unsigned int)start) * 0.001;
+			
+			if(lastLatency > maxLatency)
+				maxLatency = lastLatency;
+		}
+	}
+	
+	Atomics::memoryBarrier();
+	consumerLock = 0;
+	
+	return numDeleted;
+}
+
+void DeferredDeleter::flush() throw()
+{
+	while(numPending > 0)
+	{
+		if(reclaim() == 0)
+			UGenThread::yield();
+	}
+}
+
+void DeferredDeleter::resetStatistics() throw()
+{
+	maxPending = numPending;
+	numReclaimed = 0;
+	lastLatency = 0.0;
+	maxLatency = 0.0;
+}
+
+void DeferredDeleter::run()
+{
+	while(threadShouldExit() == false)
+	{
+		UGenThread::sleep(intervalMs_);
+		reclaim();
+	}
+}
+
+END_UGEN_NAMESPACE
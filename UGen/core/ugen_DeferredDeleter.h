@@ -0,0 +1,123 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#ifndef UGEN_DEFERREDDELETER_H
+#define UGEN_DEFERREDDELETER_H
+
+#include "ugen_Deleter.h"
+#include "ugen_SmartPointer.h"
+#include "ugen_Threads.h"
+
+/** Deletes SmartPointer objects on a background thread.
+ 
+ The default Deleter deletes objects on whichever thread drops the last reference, 
+ often the audio thread when a voice finishes. This queues them instead and a reclaimer
+ thread deletes them periodically. Unlike the JuceTimerDeleter this doesn't need Juce and
+ deleteInternal() is wait-free: the queue is an intrusive linked list (using a pointer in
+ each SmartPointer) which is pushed with a single atomic exchange and never allocates.
+ 
+ @code
+	DeferredDeleter deleter;
+	UGen::setDeleter(&deleter); 
+	// ...
+	UGen::shutdown(); // flushes the deleter and restores the default
+ @endcode
+ 
+ The queue depth and the reclaim latency (the age of the oldest object in each batch 
+ when it was deleted) are reported for monitoring. Objects deleted by the reclaimer 
+ (e.g., the inputs of a UGenInternal) are queued and deleted in the same pass.
+ 
+ @see UGen::setDeleter(), SmartPointer::setAtomicRefCounts() */
+class DeferredDeleter :	public Deleter,
+						public UGenThread
+{
+public:
+	/** Construct and start the reclaimer thread.
+	 @param intervalMs	How often the reclaimer thread deletes the queued objects. */
+	DeferredDeleter(const int intervalMs = 10) throw();
+	~DeferredDeleter() throw();
+	
+	/** Queue an object to be deleted, this is safe to call from any thread. */
+	void deleteInternal(SmartPointer* internalToDelete) throw();
+	
+	/** Delete all of the queued objects now on the calling thread. */
+	void flush() throw();
+	
+	/** The number of objects waiting to be deleted. */
+	inline int getNumPending() const throw()			{ return numPending;		}
+	
+	/** The largest number of objects waiting to be deleted at once. */
+	inline int getMaxPending() const throw()			{ return maxPending;		}
+	
+	/** The number of objects deleted. */
+	inline int getNumReclaimed() const throw()			{ return numReclaimed;		}
+	
+	/** The age in milliseconds of the oldest object in the last batch deleted. */
+	inline double getLastLatency() const throw()		{ return lastLatency;		}
+	
+	/** The largest latency in milliseconds so far. */
+	inline double getMaxLatency() const throw()			{ return maxLatency;		}
+	
+	void resetStatistics() throw();
+	
+	/** @internal */
+	void run();
+	
+private:
+	void push(SmartPointer* internal) throw();
+	SmartPointer* pop() throw();
+	int reclaim() throw();
+	
+	const int intervalMs_;
+	
+	SmartPointer stub;
+	SmartPointer* volatile head;		// pushed by any thread
+	SmartPointer* tail;					// popped by the reclaimer (or flush) only
+	volatile int consumerLock;
+	
+	volatile int batchStart;			// the time of the first push since the last reclaim in microseconds, 0 if none
+	volatile int numPending;
+	volatile int maxPending;
+	int numReclaimed;
+	double lastLatency;
+	double maxLatency;
+	
+	DeferredDeleter (const DeferredDeleter&);
+    const DeferredDeleter& operator= (const DeferredDeleter&);
+};
+
+#endif // UGEN_DEFERREDDELETER_H
@@ -90,6 +90,36 @@ const float* ExternalControlSource::getValuePtr() const throw()
 	return internal == 0 ? 0 : internal->getValuePtr(); 
 }
 
+void ExternalControlSource::setValue(const float newValue, const int rampSamples) throw()
+{
+	ugen_assert(internal != 0);
+	if(internal != 0) internal->setValue(newValue, rampSamples);
+}
+
+void ExternalControlSource::setNormalisedValue(const float value0_1, const int rampSamples) throw()
+{
+	ugen_assert(internal != 0);
+	if(internal != 0) internal->setNormalisedValue(value0_1, rampSamples);
+}
+
+bool ExternalControlSource::scheduleValue(const float newValue, const unsigned int sampleTime, const int rampSamples) throw()
+{
+	ugen_assert(internal != 0);
+	return internal == 0 ? false : internal->scheduleValue(newValue, sampleTime, rampSamples);
+}
+
+bool ExternalControlSource::scheduleNormalisedValue(const float value0_1, const unsigned int sampleTime, const int rampSamples) throw()
+{
+	ugen_assert(internal != 0);
+	return internal == 0 ? false : internal->scheduleNormalisedValue(value0_1, sampleTime, rampSamples);
+}
+
+unsigned int ExternalControlSource::getLastBlockTime() const throw()
+{
+	ugen_assert(internal != 0);
+	return internal == 0 ? 0 : internal->getQueue().getLastBlockTime();
+}
+
 UGen ExternalControlSource::kr(const double lagTime) throw()
 {
 	ugen_assert(lagTime >= 0.0);
@@ -110,11 +140,102 @@ UGen ExternalControlSource::krInternal(const double lagTime) throw()
 		return UGen(Lag(*this, lagTime)).kr();
 }
 
+ParameterControl::ParameterControl(const float initialValue, 
+								   const float minVal, const float maxVal, 
+								   const ExternalControlSource::Warp warp,
+								   const int queueSize) throw()
+{
+	internal = new ExternalControlSourceInternal(minVal, maxVal, warp, queueSize);
+	internal->setValue(initialValue);
+}
+
+void ExternalControlSourceInternal::renderBlock(float* outputSamples, const unsigned int blockID, const int numSamples) throw()
+{
+	const unsigned int previousClaimedBlockID = claimedBlockID;
+	
+	if((previousClaimedBlockID == blockID) || 
+	   (Atomics::compareAndSwap(claimedBlockID, previousClaimedBlockID, blockID) == false))
+	{
+		// another reader has rendered (or is rendering) this block
+		while(renderedBlockID != blockID)
+			Atomics::pause();
+		
+		Atomics::memoryBarrier();
+		
+		// reserve() publishes the samples before the size
+		const int numRendered = ugen::min(numSamples, (int)renderedSize);
+		Atomics::memoryBarrier();
+		memcpy(outputSamples, renderedSamples, numRendered * sizeof(float));
+		
+		for(int i = numRendered; i < numSamples; i++)
+			outputSamples[i] = value;
+		
+		return;
+	}
+	
+	const int size = renderedSize;
+	Atomics::memoryBarrier();
+	float* const samples = renderedSamples;
+	
+	if(numSamples <= size)
+	{
+		queue.render(samples, numSamples, blockID);
+		memcpy(outputSamples, samples, numSamples * sizeof(float));
+	}
+	else
+	{
+		queue.render(outputSamples, numSamples, blockID);
+		memcpy(samples, outputSamples, size * sizeof(float));
+	}
+	
+	value = queue.getCurrentValue();
+	
+	Atomics::memoryBarrier();
+	renderedBlockID = blockID;
+}
+
+void ExternalControlSourceInternal::reserve(const int numSamples) throw()
+{
+	if(numSamples <= renderedSize)
+		return;
+	
+	float* const newSamples = new float[numSamples];
+	
+	for(int i = 0; i < numSamples; i++)
+		newSamples[i] = value;
+	
+	delete [] retiredSamples;
+	retiredSamples = renderedSamples;
+	
+	Atomics::memoryBarrier();
+	renderedSamples = newSamples;
+	renderedSize = numSamples;
+}
+
 ExternalControlSourceUGenInternal::ExternalControlSourceUGenInternal
 (ExternalControlSource const& externalControlSource) throw()
-:	FloatPtrUGenInternal(externalControlSource.getValuePtr()),
+:	UGenInternal(0),
 	externalControlSource_(externalControlSource)
 { 
+	initValue(externalControlSource.getValue());
+	
+	if(externalControlSource.internal != 0)
+		externalControlSource.internal->reserve(uGenOutput.getBlockSize());
+}
+
+void ExternalControlSourceUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned int blockID, const int /*channel*/) throw()
+{
+	const int numSamplesToProcess = uGenOutput.getBlockSize();
+	float* const outputSamples = uGenOutput.getSampleData();
+	ExternalControlSourceInternal* const internal = externalControlSource_.internal;
+	
+	if(internal == 0)
+	{
+		memset(outputSamples, 0, numSamplesToProcess * sizeof(float));
+		return;
+	}
+	
+	internal->renderBlock(outputSamples, blockID, numSamplesToProcess);
 }
 
 
@@ -41,13 +41,19 @@
 #include "ugen_UGen.h"
 #include "../basics/ugen_ScalarUGens.h"
 #include "ugen_SmartPointer.h"
+#include "ugen_ParameterQueue.h"
 
 
 class ExternalControlSourceInternal;
 
 /** Used for mapping data from another source for control purposes.
  
- This is used for MIDI controllers for example. */
+ This is used for MIDI controllers for example. Changes of value are passed to the audio 
+ thread through a ParameterQueue so they may also be scheduled at a particular sample time 
+ and ramped, see scheduleValue(). All of the setting and scheduling functions must be called 
+ from a single thread. 
+ 
+ @see ParameterControl */
 class ExternalControlSource
 {
 public:
@@ -78,11 +84,58 @@ public:
 	const float* getValuePtr() const throw();
 	
 	/// @} <!-- Miscellaneous -->
+	
+	/// @name Setting and scheduling values
+	/// @{
+	
+	/** Change the value at the start of the next block, optionally ramping over rampSamples. */
+	void setValue(const float newValue, const int rampSamples = 0) throw();
+	
+	/** Change the value using a 0-1 value mapped through the range and warp, see setValue(). */
+	void setNormalisedValue(const float value0_1, const int rampSamples = 0) throw();
+	
+	/** Change the value at a particular sample time.
+	 @param newValue	The new value.
+	 @param sampleTime	The sample time (in the blockID clock, see UGen::getCurrentBlockID()).
+	 @param rampSamples	The number of samples to ramp to the new value over, 0 jumps immediately.
+	 @return			false if the queue was full and the change was dropped. */
+	bool scheduleValue(const float newValue, const unsigned int sampleTime, const int rampSamples = 0) throw();
+	
+	/** Change the value at a particular sample time using a 0-1 value, see scheduleValue(). */
+	bool scheduleNormalisedValue(const float value0_1, const unsigned int sampleTime, const int rampSamples = 0) throw();
+	
+	/** The sample time of the most recent block rendered by this source. */
+	unsigned int getLastBlockTime() const throw();
+	
+	/// @} <!-- end Setting and scheduling values -->
+	
+	friend class ExternalControlSourceUGenInternal;
 		
 protected:
 	ExternalControlSourceInternal* internal;
 };
 
+/** An ExternalControlSource for host or application parameters.
+ 
+ This is a general purpose source for automation lanes and user interface controls, the value 
+ may be set, or scheduled to change at sample accurate times, from another thread.
+ 
+ @code
+	ParameterControl cutoff(1000.f, 20.f, 20000.f, ExternalControlSource::Exponential);
+	UGen filter = LPF::AR(input, cutoff.kr(0.0));
+	 
+	// ...later on the automation thread, ramp to 500Hz over 10ms starting 64 samples into the next block
+	cutoff.scheduleValue(500.f, UGen::getCurrentBlockID() + blockSize + 64, 441);
+ @endcode */
+class ParameterControl : public ExternalControlSource
+{
+public:
+	ParameterControl(const float initialValue = 0.f, 
+					 const float minVal = 0.f, const float maxVal = 1.f, 
+					 const ExternalControlSource::Warp warp = ExternalControlSource::Linear,
+					 const int queueSize = 64) throw();
+};
+
 
 class ExternalControlSourceInternal : public SmartPointer
 {
@@ -92,8 +145,25 @@ public:
 	/// @{
 	
 	ExternalControlSourceInternal(const float minVal = 0.f, const float maxVal = 127.f, 
-								  const ExternalControlSource::Warp warp = ExternalControlSource::Linear) throw()
-	: value(minVal), minVal_(minVal), maxVal_(maxVal), warp_(warp) { }
+								  const ExternalControlSource::Warp warp = ExternalControlSource::Linear,
+								  const int queueSize = 64) throw()
+	:	value(minVal), minVal_(minVal), maxVal_(maxVal), warp_(warp), 
+		queue(minVal, queueSize), 
+		renderedSize(ugen::max(1, UGen::getEstimatedBlockSize())), 
+		renderedSamples(new float[renderedSize]), 
+		retiredSamples(0),
+		renderedBlockID((unsigned int)-1), 
+		claimedBlockID((unsigned int)-1)
+	{ 
+		for(int i = 0; i < renderedSize; i++)
+			renderedSamples[i] = minVal;
+	}
+	
+	~ExternalControlSourceInternal() 
+	{ 
+		delete [] renderedSamples; 
+		delete [] retiredSamples;
+	}
 	
 	/// @} <!-- end Construction and destruction ----------------------------------------- --> 
 	
@@ -102,22 +172,57 @@ public:
 	
 	inline float getValue() const throw()				{ return value;		}
 	inline const float* getValuePtr() const throw()		{ return &value;	}
-	inline void setValue(const float newValue) throw()	{ value = newValue; }
-	inline void setNormalisedValue(float value0_1) throw()
+	
+	inline void setValue(const float newValue, const int rampSamples = 0) throw()	
+	{ 
+		value = newValue; 
+		queue.set(newValue, rampSamples);
+	}
+	
+	inline void setNormalisedValue(float value0_1, const int rampSamples = 0) throw()
+	{
+		setValue(mapNormalisedValue(value0_1), rampSamples);
+	}
+	
+	inline bool scheduleValue(const float newValue, const unsigned int sampleTime, const int rampSamples = 0) throw()
+	{
+		return queue.schedule(newValue, sampleTime, rampSamples);
+	}
+	
+	inline bool scheduleNormalisedValue(float value0_1, const unsigned int sampleTime, const int rampSamples = 0) throw()
+	{
+		return queue.schedule(mapNormalisedValue(value0_1), sampleTime, rampSamples);
+	}
+	
+	inline float mapNormalisedValue(float value0_1) const throw()
 	{
 		switch(warp_)
 		{
 			case ExternalControlSource::Linear:
-				value = value0_1 * (maxVal_ - minVal_) + minVal_;
-				break;
+				return value0_1 * (maxVal_ - minVal_) + minVal_;
 			case ExternalControlSource::Exponential:
-				value = minVal_ * pow(maxVal_ / minVal_, value0_1);
-				break;
+				return minVal_ * pow(maxVal_ / minVal_, value0_1);
 		}
+		
+		return value0_1;
 	}
 	
+	inline ParameterQueue const& getQueue() const throw()	{ return queue;		}
+	
 	/// @} <!-- end Getting and setting value -->
 	
+	/** Render the values for a block into outputSamples.
+	 The block is only rendered once for each blockID so all the UGens reading this source 
+	 get the same values. As with UGenInternal::processBlockInternal() the first reader claims
+	 the block and any others (e.g., on other ParallelRenderer threads) wait for it. This doesn't 
+	 allocate: a block larger than reserve() allowed for is rendered for the first reader and 
+	 later readers get the values which fit followed by the final value. */
+	void renderBlock(float* outputSamples, const unsigned int blockID, const int numSamples) throw();
+	
+	/** Make sure blocks of numSamples can be shared without allocating in renderBlock().
+	 This allocates so it should be called from the thread building the graph. */
+	void reserve(const int numSamples) throw();
+	
 	friend class ExternalControlSourceUGenInternal;
 	
 protected:
@@ -125,15 +230,24 @@ protected:
 	float minVal_;
 	float maxVal_;
 	ExternalControlSource::Warp warp_;
+	
+private:
+	ParameterQueue queue;
+	volatile int renderedSize;
+	float* volatile renderedSamples;
+	float* retiredSamples;					// replaced by reserve() but kept in case a block is still reading it
+	volatile unsigned int renderedBlockID;
+	volatile unsigned int claimedBlockID;	// the last block a reader claimed for rendering
 };
 
 /**
  @ingroup UGenInternals
  */
-class ExternalControlSourceUGenInternal : public FloatPtrUGenInternal
+class ExternalControlSourceUGenInternal : public UGenInternal
 {
 public:
 	ExternalControlSourceUGenInternal(ExternalControlSource const& externalControlSource) throw();
+	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
 
 private:
 	ExternalControlSource externalControlSource_;
@@ -0,0 +1,265 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#include "ugen_StandardHeader.h"
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_HeadlessHost.h"
+#include "ugen_Threads.h"
+#include "../basics/ugen_RawInputUGens.h"
+#include "../basics/ugen_InlineBinaryOps.h"
+
+HeadlessHost::HeadlessHost(const int numInputs, 
+						   const int numOutputs, 
+						   const double sampleRate, 
+						   const int blockSize,
+						   const int controlRateBlockSize,
+						   const bool shouldInitialise) throw()
+:	numInputs_(numInputs < 0 ? 0 : numInputs),
+	numOutputs_(numOutputs < 0 ? 0 : numOutputs),
+	sampleRate_(sampleRate > 0.0 ? sampleRate : 44100.0),
+	blockSize_(blockSize < 1 ? 1 : blockSize),
+	ownsInitialisation(shouldInitialise),
+	isPrepared(false),
+	numSamplesProcessed(0.0),
+	numBlocksProcessed(0)
+{
+	ugen_assert(numInputs == numInputs_);
+	ugen_assert(numOutputs == numOutputs_);
+	ugen_assert(blockSize == blockSize_);
+	
+	if(ownsInitialisation)
+	{
+		UGen::initialise();
+		UGen::prepareToPlay(sampleRate_, blockSize_, controlRateBlockSize);
+	}
+	
+	const int numInputSamples = ugen::max(1, numInputs_) * blockSize_;
+	const int numOutputSamples = ugen::max(1, numOutputs_) * blockSize_;
+	
+	inputData = new float[numInputSamples];
+	outputData = new float[numOutputSamples];
+	inputPointers = new const float*[ugen::max(1, numInputs_)];
+	outputPointers = new float*[ugen::max(1, numOutputs_)];
+	
+	memset(inputData, 0, numInputSamples * sizeof(float));
+	memset(outputData, 0, numOutputSamples * sizeof(float));
+	
+	for(int i = 0; i < numInputs_; i++)
+		inputPointers[i] = inputData + i * blockSize_;
+	
+	for(int i = 0; i < numOutputs_; i++)
+		outputPointers[i] = outputData + i * blockSize_;
+	
+	if(numInputs_ > 0)
+		input = AudioIn::AR(numInputs_);
+	
+	resetStatistics();
+}
+
+HeadlessHost::~HeadlessHost()
+{
+	input = UGen();
+	output = UGen();
+	others.clear(false);
+	
+	if(ownsInitialisation)
+		UGen::shutdown();
+	
+	delete [] outputPointers;
+	delete [] inputPointers;
+	delete [] outputData;
+	delete [] inputData;
+}
+
+void HeadlessHost::setOutput(UGen const& ugen) throw()
+{
+	output = ugen;
+	isPrepared = true;
+}
+
+UGen HeadlessHost::addOther(UGen const& ugen) throw()
+{
+	others.add(ugen);
+	return ugen;
+}
+
+void HeadlessHost::removeOther(UGen const& ugen) throw()
+{
+	others.removeItem(ugen);
+}
+
+void HeadlessHost::clearOthers() throw()
+{
+	others.clear(false);
+}
+
+void HeadlessHost::prepareGraph() throw()
+{
+	isPrepared = true;
+	
+	UGen graph = constructGraph(input);
+	
+	if(graph.isNotNull())
+		output = graph;
+}
+
+double HeadlessHost::processBlock(const int actualBlockSize) throw()
+{
+	if(isPrepared == false) 
+		prepareGraph();
+	
+	const double startTime = UGenThread::getMillisecondCounterHiRes();
+	
+	const int blockID = UGen::getNextBlockID(actualBlockSize);
+	
+	preTick(actualBlockSize, blockID);
+	
+	if(numInputs_ > 0)
+		input.setInputs(inputPointers, actualBlockSize, numInputs_);
+	
+	for(int i = 0; i < others.size(); i++)
+	{
+		others[i].prepareAndProcessBlock(actualBlockSize, blockID, -1);
+	}
+	
+	const int numOutputChannels = output.isNull() ? 0 : ugen::min(numOutputs_, output.getNumChannels());
+	
+	if(numOutputChannels > 0)
+	{
+		output.setOutputs(outputPointers, actualBlockSize, numOutputChannels);
+		output.prepareAndProcessBlock(actualBlockSize, blockID, -1);
+	}
+	
+	for(int i = numOutputChannels; i < numOutputs_; i++)
+		memset(outputPointers[i], 0, actualBlockSize * sizeof(float));
+	
+	postTick(actualBlockSize, blockID);
+	
+	const double blockTime = UGenThread::getMillisecondCounterHiRes() - startTime;
+	const double blockLoad = blockTime * 0.001 * sampleRate_ / actualBlockSize;
+	
+	numSamplesProcessed += actualBlockSize;
+	numBlocksProcessed++;
+	statisticsSamples += actualBlockSize;
+	processTime += blockTime;
+	
+	if(blockTime > maxBlockTime) maxBlockTime = blockTime;
+	if(blockLoad > peakLoad) peakLoad = blockLoad;
+	
+	return blockTime;
+}
+
+double HeadlessHost::processBlocks(const int numBlocks) throw()
+{
+	double time = 0.0;
+	
+	for(int i = 0; i < numBlocks; i++)
+		time += processBlock(blockSize_);
+	
+	return time;
+}
+
+double HeadlessHost::processSamples(const int numSamples) throw()
+{
+	double time = 0.0;
+	int numSamplesRemaining = numSamples;
+	
+	while(numSamplesRemaining > 0)
+	{
+		const int actualBlockSize = ugen::min(numSamplesRemaining, blockSize_);
+		time += processBlock(actualBlockSize);
+		numSamplesRemaining -= actualBlockSize;
+	}
+	
+	return time;
+}
+
+double HeadlessHost::processSeconds(const double seconds) throw()
+{
+	return processSamples((int)(seconds * sampleRate_ + 0.5));
+}
+
+Buffer HeadlessHost::render(const double seconds) throw()
+{
+	const int numSamples = (int)(seconds * sampleRate_ + 0.5);
+	
+	if(numSamples <= 0 || numOutputs_ == 0) 
+		return Buffer();
+	
+	Buffer result(BufferSpec(numSamples, numOutputs_, false));
+	int offset = 0;
+	
+	while(offset < numSamples)
+	{
+		const int actualBlockSize = ugen::min(numSamples - offset, blockSize_);
+		processBlock(actualBlockSize);
+		
+		for(int channel = 0; channel < numOutputs_; channel++)
+			memcpy(result.getDataUnchecked(channel) + offset, outputPointers[channel], actualBlockSize * sizeof(float));
+		
+		offset += actualBlockSize;
+	}
+	
+	return result;
+}
+
+double HeadlessHost::getNanosecondsPerSample() const throw()
+{
+	return statisticsSamples > 0.0 ? processTime * 1.0e6 / statisticsSamples : 0.0;
+}
+
+double HeadlessHost::getLoad() const throw()
+{
+	return statisticsSamples > 0.0 ? processTime * 0.001 * sampleRate_ / statisticsSamples : 0.0;
+}
+
+double HeadlessHost::getPeakLoad() const throw()
+{
+	return peakLoad;
+}
+
+void HeadlessHost::resetStatistics() throw()
+{
+	statisticsSamples = 0.0;
+	processTime = 0.0;
+	maxBlockTime = 0.0;
+	peakLoad = 0.0;
+}
+
+END_UGEN_NAMESPACE
@@ -0,0 +1,197 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#ifndef UGEN_HEADLESSHOST_H
+#define UGEN_HEADLESSHOST_H
+
+#include "ugen_UGen.h"
+#include "ugen_UGenArray.h"
+#include "../buffers/ugen_Buffer.h"
+
+/** An audio host which renders without an audio device.
+ 
+ This drives UGen::prepareAndProcessBlock() the same way the device hosts do (others first, 
+ then the output) but from the calling thread and as fast as possible. Time is simulated: 
+ getTime() advances by the duration of each block rendered rather than following the wall 
+ clock, so rendering is reproducible. The wall clock time spent processing each block is 
+ measured which makes this suitable for tests, offline rendering and benchmarks.
+ 
+ @code
+	HeadlessHost host(0, 2, 44100.0, 256);
+	host.setOutput(SinOsc::AR(U(440, 441), 0, 0.1));
+	host.processSeconds(10.0);
+	printf("load %f%% max block %fms\n", host.getLoad() * 100.0, host.getMaxBlockTime());
+ @endcode
+ 
+ Subclasses may implement constructGraph() instead of calling setOutput(), this is called
+ before the first block is processed (as with the JuceIOHost).
+ 
+ @see JuceIOHost
+ @ingroup Hosts */
+class HeadlessHost
+{
+public:
+	/** Construct a host.
+	 @param numInputs				The number of input channels, the data is taken from getInputBuffer().
+	 @param numOutputs				The number of output channels, the data is written to getOutputBuffer().
+	 @param sampleRate				The simulated sample rate.
+	 @param blockSize				The size of each block processed.
+	 @param controlRateBlockSize	The control rate block size (see UGen::prepareToPlay()).
+	 @param shouldInitialise		If true this calls UGen::initialise() and UGen::prepareToPlay() 
+									and calls UGen::shutdown() in its destructor. If false these must 
+									be called elsewhere (e.g., when using several hosts in turn). */
+	HeadlessHost(const int numInputs = 0, 
+				 const int numOutputs = 2, 
+				 const double sampleRate = 44100.0, 
+				 const int blockSize = 512,
+				 const int controlRateBlockSize = 64,
+				 const bool shouldInitialise = true) throw();
+	virtual ~HeadlessHost();
+	
+	/// @name Graph
+	/// @{
+	
+	/** Construct the UGen graph to render.
+	 The default returns a null UGen in which case the output set by setOutput() is used. */
+	virtual UGen constructGraph(UGen const& input) { (void)input; return UGen(); }
+	
+	/** Called just before processing each block. */
+	virtual void preTick(const int actualBlockSize, const unsigned int blockID) throw()  { (void)actualBlockSize; (void)blockID; }
+	
+	/** Called just after processing each block. */
+	virtual void postTick(const int actualBlockSize, const unsigned int blockID) throw() { (void)actualBlockSize; (void)blockID; }
+	
+	inline UGen& getInput() throw()										{ return input;				}
+	inline UGen& getOutput() throw()									{ return output;			}
+	void setOutput(UGen const& ugen) throw();
+	
+	/** Add a UGen to process each block which isn't part of the output (e.g., a DiskOut). */
+	UGen addOther(UGen const& ugen) throw();
+	void removeOther(UGen const& ugen) throw();
+	void clearOthers() throw();
+	
+	/// @} <!-- end Graph -->
+	
+	/// @name Processing
+	/// @{
+	
+	/** Process a number of whole blocks. 
+	 @return The wall clock time in milliseconds spent processing. */
+	double processBlocks(const int numBlocks) throw();
+	
+	/** Process a number of samples, the last block is shorter if necessary. 
+	 @return The wall clock time in milliseconds spent processing. */
+	double processSamples(const int numSamples) throw();
+	
+	/** Process a duration of simulated time. 
+	 @return The wall clock time in milliseconds spent processing. */
+	double processSeconds(const double seconds) throw();
+	
+	/** Process a duration of simulated time and return the output. */
+	Buffer render(const double seconds) throw();
+	
+	/** The input data for the next block, fill this before processing if there are inputs. */
+	inline float* getInputBuffer(const int channel) throw()				{ return inputData + channel * blockSize_;	}
+	
+	/** The output data of the last block processed. */
+	inline const float* getOutputBuffer(const int channel) const throw(){ return outputData + channel * blockSize_;	}
+	
+	inline int getNumInputs() const throw()								{ return numInputs_;		}
+	inline int getNumOutputs() const throw()							{ return numOutputs_;		}
+	inline int getBlockSize() const throw()								{ return blockSize_;		}
+	inline double getSampleRate() const throw()							{ return sampleRate_;		}
+	
+	/// @} <!-- end Processing -->
+	
+	/// @name Simulated clock and statistics
+	/// @{
+	
+	/** The simulated time in seconds, i.e., the duration of the audio processed. */
+	inline double getTime() const throw()								{ return (double)numSamplesProcessed / sampleRate_;	}
+	inline double getNumSamplesProcessed() const throw()				{ return numSamplesProcessed;						}
+	inline int getNumBlocksProcessed() const throw()					{ return numBlocksProcessed;						}
+	
+	/** The wall clock time in milliseconds spent processing since the last resetStatistics(). */
+	inline double getProcessTime() const throw()						{ return processTime;		}
+	
+	/** The longest wall clock time in milliseconds spent processing a single block. */
+	inline double getMaxBlockTime() const throw()						{ return maxBlockTime;		}
+	
+	/** The average wall clock time in nanoseconds spent processing each sample. */
+	double getNanosecondsPerSample() const throw();
+	
+	/** The processing time as a proportion of the simulated time, above 1 wouldn't run in real time. */
+	double getLoad() const throw();
+	
+	/** The worst block's processing time as a proportion of its duration. */
+	double getPeakLoad() const throw();
+	
+	void resetStatistics() throw();
+	
+	/// @} <!-- end Simulated clock and statistics -->
+	
+private:
+	void prepareGraph() throw();
+	double processBlock(const int actualBlockSize) throw();
+	
+	const int numInputs_, numOutputs_;
+	const double sampleRate_;
+	const int blockSize_;
+	const bool ownsInitialisation;
+	bool isPrepared;
+	
+	UGen input;
+	UGen output;
+	UGenArray others;
+	
+	float* inputData;
+	float* outputData;
+	const float** inputPointers;
+	float** outputPointers;
+	
+	double numSamplesProcessed;
+	int numBlocksProcessed;
+	double statisticsSamples;
+	double processTime;
+	double maxBlockTime;
+	double peakLoad;
+	
+	HeadlessHost (const HeadlessHost&);
+    const HeadlessHost& operator= (const HeadlessHost&);
+};
+
+#endif // UGEN_HEADLESSHOST_H
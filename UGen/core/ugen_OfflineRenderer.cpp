@@ -0,0 +1,488 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#include "ugen_StandardHeader.h"
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_OfflineRenderer.h"
+#include "ugen_UGenInternal.h"
+#include "ugen_Atomics.h"
+#include "../basics/ugen_InlineBinaryOps.h"
+
+/** @internal */
+class OfflineRenderer::Worker : public UGenThread
+{
+public:
+	Worker(OfflineRenderer& renderer, Semaphore& wake, Semaphore& finished) throw()
+	:	renderer_(renderer),
+		wake_(wake),
+		finished_(finished)
+	{
+	}
+	
+	~Worker()
+	{
+		stopThread();
+	}
+	
+	void run()
+	{
+		while(true)
+		{
+			wake_.wait();
+			
+			if(threadShouldExit()) 
+				break;
+			
+			renderer_.work();
+			finished_.signal();
+		}
+	}
+	
+private:
+	OfflineRenderer& renderer_;
+	Semaphore& wake_;
+	Semaphore& finished_;
+};
+
+OfflineRenderer::OfflineRenderer(const int numThreads, const int blockSize) throw()
+:	workers(0),
+	numWorkers(0),
+	blockSize_(blockSize > 0 ? blockSize : 8192),
+	listener_(0),
+	jobs(0), numJobs(0), allocatedJobs(0),
+	units(0), numUnits(0), allocatedUnits(0),
+	unitChannels(0), numUnitChannels(0), allocatedUnitChannels(0),
+	groups(0), allocatedGroups(0),
+	currentGroup(0),
+	pass(0),
+	currentBlockID(0),
+	nextUnit(0),
+	shouldCancel(0),
+	numJobsFinished(0),
+	progress(0.0)
+{
+	const int numThreadsToUse = numThreads > 0 ? numThreads : UGenThread::getNumCPUs();
+	
+	numWorkers = numThreadsToUse - 1;
+	
+	if(numWorkers > 0)
+	{
+		workers = new Worker*[numWorkers];
+		
+		for(int i = 0; i < numWorkers; i++)
+		{
+			workers[i] = new Worker(*this, wakeWorkers, workersFinished);
+			workers[i]->startThread();
+		}
+	}
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+	for(int i = 0; i < numWorkers; i++)
+		workers[i]->signalThreadShouldExit();
+	
+	for(int i = 0; i < numWorkers; i++)
+		wakeWorkers.signal();
+	
+	for(int i = 0; i < numWorkers; i++)
+		delete workers[i];
+	
+	delete [] workers;
+	
+	clear();
+	
+	delete [] jobs;
+	delete [] units;
+	delete [] unitChannels;
+	delete [] groups;
+}
+
+template<class ElementType>
+void OfflineRenderer::ensureSize(ElementType*& array, int& allocatedSize, const int requiredSize) throw()
+{
+	if(requiredSize <= allocatedSize) return;
+	
+	int newSize = allocatedSize > 0 ? allocatedSize : 16;
+	while(newSize < requiredSize) newSize *= 2;
+	
+	ElementType* newArray = new ElementType[newSize];
+	
+	if(array != 0)
+	{
+		memcpy(newArray, array, allocatedSize * sizeof(ElementType));
+		delete [] array;
+	}
+	
+	array = newArray;
+	allocatedSize = newSize;
+}
+
+int OfflineRenderer::addJob(Job* job) throw()
+{
+	ensureSize(jobs, allocatedJobs, numJobs + 1);
+	jobs[numJobs] = job;
+	
+	// the share of the progress already rendered shrinks as jobs are added
+	double numSamplesRendered = 0.0, numSamplesTotal = 0.0;
+	
+	for(int i = 0; i <= numJobs; i++)
+	{
+		numSamplesRendered += jobs[i]->position;
+		numSamplesTotal += jobs[i]->numSamples;
+	}
+	
+	progress = numSamplesRendered / numSamplesTotal;
+	
+	return numJobs++;
+}
+
+int OfflineRenderer::addSynth(Buffer const& buffer, UGen const& graph, const int offset, const int numSamples) throw()
+{
+	ugen_assert(offset >= 0 && offset < buffer.size());
+	
+	Job* job = new Job;
+	job->buffer = buffer;
+	job->graph = graph;
+	job->offset = offset;
+	job->numSamples = (numSamples <= 0) ? buffer.size() - offset : ugen::min(numSamples, buffer.size() - offset);
+	job->numChannels = ugen::min(buffer.getNumChannels(), graph.getNumChannels());
+	job->position = 0;
+	job->isProcess = false;
+	
+	ugen_assert(job->numSamples > 0);
+	ugen_assert(job->numChannels > 0);
+	
+	return addJob(job);
+}
+
+int OfflineRenderer::addProcess(Buffer const& buffer, UGen const& input, UGen const& graph, const int offset, const int numSamples) throw()
+{
+	const int jobID = addSynth(buffer, graph, offset, numSamples);
+	
+	jobs[jobID]->input = input;
+	jobs[jobID]->isProcess = true;
+	
+	return jobID;
+}
+
+void OfflineRenderer::clear() throw()
+{
+	for(int i = 0; i < numJobs; i++)
+		delete jobs[i];
+	
+	numJobs = 0;
+	numUnits = 0;
+	numUnitChannels = 0;
+	numJobsFinished = 0;
+	progress = 0.0;
+}
+
+void OfflineRenderer::setListener(OfflineRendererListener* listener) throw()
+{
+	listener_ = listener;
+}
+
+void OfflineRenderer::setBlockSize(const int blockSize) throw()
+{
+	ugen_assert(blockSize > 0);
+	blockSize_ = blockSize > 0 ? blockSize : 8192;
+}
+
+void OfflineRenderer::finishJob(const int jobIndex) throw()
+{
+	Job& job = *jobs[jobIndex];
+	
+	// the graph may have finished early (e.g., a DoneAction), as in real time the rest is silent
+	if(job.position < job.numSamples)
+	{
+		for(int channel = 0; channel < job.numChannels; channel++)
+		{
+			memset(job.buffer.getDataUnchecked(channel) + job.offset + job.position, 
+				   0, 
+				   sizeof(float) * (job.numSamples - job.position));
+		}
+		
+		job.position = job.numSamples;
+	}
+	
+	for(int channel = job.numChannels; channel < job.buffer.getNumChannels(); channel++)
+	{
+		memcpy(job.buffer.getDataUnchecked(channel) + job.offset, 
+			   job.buffer.getDataUnchecked(channel % job.numChannels) + job.offset, 
+			   sizeof(float) * job.numSamples);
+	}
+	
+	Atomics::increment(numJobsFinished);
+	
+	if(listener_ != 0)
+		listener_->offlineRenderJobFinished(*this, jobIndex, job.buffer);
+}
+
+bool OfflineRenderer::render() throw()
+{
+	int i, channel;
+	
+	shouldCancel = 0;
+	
+	const bool wereAtomicRefCounts = SmartPointer::getAtomicRefCounts();
+	SmartPointer::setAtomicRefCounts(true);
+	Atomics::increment(UGenInternal::numParallelRenderers);
+	
+	double numSamplesRendered = 0.0, numSamplesTotal = 0.0;
+	
+	for(i = 0; i < numJobs; i++)
+	{
+		numSamplesRendered += jobs[i]->position;
+		numSamplesTotal += jobs[i]->numSamples;
+	}
+	
+	while(shouldCancel == 0)
+	{
+		// render the jobs which are furthest behind, jobs added later render on their own until
+		// they catch up so all the jobs processed together share the same block ID
+		int position = INT_MAX;
+		
+		for(i = 0; i < numJobs; i++)
+		{
+			if(jobs[i]->position < jobs[i]->numSamples)
+				position = ugen::min(position, jobs[i]->position);
+		}
+		
+		if(position == INT_MAX) 
+			break;
+		
+		// prepare every graph on this thread then share out the channels, each job uses the same 
+		// blocks as synthInPlace() so the last block of a job may be shorter than the others' blocks:
+		// these are prepared first so any UGenInternal objects shared with other jobs (e.g., constants) 
+		// are prepared for the full block size 
+		numUnits = 0;
+		numUnitChannels = 0;
+		
+		for(int fullBlocks = 0; fullBlocks < 2; fullBlocks++)
+		{
+			for(i = 0; i < numJobs; i++)
+			{
+				Job& job = *jobs[i];
+				
+				if(job.position != position || job.position == job.numSamples) 
+					continue;
+				
+				const int actualBlockSize = ugen::min(blockSize_, job.numSamples - position);
+				
+				if((actualBlockSize == blockSize_) != (fullBlocks == 1))
+					continue;
+				
+				if(job.graph.isNull() == false)
+				{
+					for(channel = 0; channel < job.numChannels; channel++)
+					{
+						float* data = job.buffer.getDataUnchecked(channel) + job.offset + position;
+						
+						if(job.isProcess)
+							job.input.setInput(data, actualBlockSize, channel);
+						
+						job.graph.setOutput(data, actualBlockSize, channel);
+					}
+					
+					job.graph.prepareForBlock(actualBlockSize, (unsigned int)position, -1);
+				}
+				
+				if(job.graph.isNull())
+				{
+					numSamplesRendered += job.numSamples - job.position;
+					finishJob(i);
+					continue;
+				}
+				
+				addUnits(job);
+			}
+		}
+		
+		if(numUnits > 0)
+		{
+			const int numWorkersToWake = ugen::min(numWorkers, numUnits - 1);
+			
+			currentBlockID = (unsigned int)position;
+			nextUnit = 0;
+			Atomics::memoryBarrier();
+			
+			for(i = 0; i < numWorkersToWake; i++)
+				wakeWorkers.signal();
+			
+			runUnits();
+			
+			for(i = 0; i < numWorkersToWake; i++)
+				workersFinished.wait();
+			
+			Atomics::memoryBarrier();
+		}
+		
+		for(i = 0; i < numJobs; i++)
+		{
+			Job& job = *jobs[i];
+			
+			if(job.position != position || job.position == job.numSamples) 
+				continue;
+			
+			const int actualBlockSize = ugen::min(blockSize_, job.numSamples - position);
+			job.position += actualBlockSize;
+			numSamplesRendered += actualBlockSize;
+			
+			if(job.position == job.numSamples)
+				finishJob(i);
+		}
+		
+		progress = numSamplesRendered / numSamplesTotal;
+		
+		if(listener_ != 0)
+			listener_->offlineRenderProgress(*this, progress);
+	}
+	
+	Atomics::decrement(UGenInternal::numParallelRenderers);
+	SmartPointer::setAtomicRefCounts(wereAtomicRefCounts);
+	
+	return numJobsFinished == numJobs;
+}
+
+void OfflineRenderer::work() throw()
+{
+	runUnits();
+}
+
+void OfflineRenderer::runUnits() throw()
+{
+	const unsigned int blockID = currentBlockID;
+	
+	while(true)
+	{
+		const int unitIndex = Atomics::increment(nextUnit) - 1;
+		
+		if(unitIndex >= numUnits) 
+			break;
+		
+		const Unit& unit = units[unitIndex];
+		
+		for(int i = 0; i < unit.numChannels; i++)
+		{
+			bool shouldDelete = false;
+			unit.job->graph.processBlock(shouldDelete, blockID, unitChannels[unit.firstChannel + i]);
+		}
+	}
+}
+
+void OfflineRenderer::addUnits(Job& job) throw()
+{
+	int channel, i;
+	
+	// channels which reach the same UGenInternal are merged into the group of the lowest channel
+	ensureSize(groups, allocatedGroups, job.numChannels);
+	pass = (unsigned int)Atomics::increment(UGenInternal::nextSchedulePass);
+	
+	const int numGraphChannels = job.graph.getNumChannels();
+	
+	for(channel = 0; channel < job.numChannels; channel++)
+	{
+		groups[channel] = channel;
+		currentGroup = channel;
+		
+		UGenInternal* internal = job.graph.getInternalUGen(channel % numGraphChannels);
+		add(internal, channel, true);
+		internal->decrementRefCount();
+	}
+	
+	// each group is a unit which processes its channels in order
+	ensureSize(unitChannels, allocatedUnitChannels, numUnitChannels + job.numChannels);
+	
+	for(channel = 0; channel < job.numChannels; channel++)
+	{
+		if(findGroup(channel) != channel) 
+			continue;
+		
+		ensureSize(units, allocatedUnits, numUnits + 1);
+		
+		Unit& unit = units[numUnits++];
+		unit.job = &job;
+		unit.firstChannel = numUnitChannels;
+		unit.numChannels = 0;
+		
+		for(i = channel; i < job.numChannels; i++)
+		{
+			if(findGroup(i) == channel)
+			{
+				unitChannels[numUnitChannels++] = i;
+				unit.numChannels++;
+			}
+		}
+	}
+}
+
+int OfflineRenderer::findGroup(int channel) throw()
+{
+	while(groups[channel] != channel)
+		channel = groups[channel];
+	
+	return channel;
+}
+
+void OfflineRenderer::add(UGenInternal* internal, const int channel, const bool /*passesDeletion*/) throw()
+{
+	// constants have no inputs and may be shared, only one thread will process each block
+	if(internal->isConst() || internal->isScalar() || internal->isNull())
+		return;
+	
+	if(internal->schedulePass == pass)
+	{
+		const int group = findGroup(internal->scheduleIndex);
+		const int current = findGroup(currentGroup);
+		
+		if(group < current)
+			groups[current] = group;
+		else
+			groups[group] = current;
+		
+		return;
+	}
+	
+	internal->schedulePass = pass;
+	internal->scheduleIndex = currentGroup;
+	internal->addDependencies(*this, channel);
+}
+
+END_UGEN_NAMESPACE
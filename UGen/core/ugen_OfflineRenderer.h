@@ -0,0 +1,235 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#ifndef UGEN_OFFLINERENDERER_H
+#define UGEN_OFFLINERENDERER_H
+
+#include "ugen_UGen.h"
+#include "ugen_UGenInternal.h"
+#include "ugen_Threads.h"
+#include "../buffers/ugen_Buffer.h"
+
+class OfflineRenderer;
+
+/** Receives progress and completion messages from an OfflineRenderer.
+ These are called on the thread which called OfflineRenderer::render(). */
+class OfflineRendererListener
+{
+public:
+	virtual ~OfflineRendererListener() {}
+	
+	/** Called after each block with the proportion (0-1) of all the jobs' samples rendered so far. */
+	virtual void offlineRenderProgress(OfflineRenderer& renderer, const double proportion) throw() 
+	{ 
+		(void)renderer; (void)proportion; 
+	}
+	
+	/** Called when a job has rendered all of its samples. */
+	virtual void offlineRenderJobFinished(OfflineRenderer& renderer, const int jobID, Buffer const& buffer) throw() 
+	{ 
+		(void)renderer; (void)jobID; (void)buffer; 
+	}
+};
+
+/** Renders UGen graphs into Buffer objects faster than real time using several threads.
+ 
+ This is the equivalent of Buffer::synthInPlace() and Buffer::processInPlace() for batches 
+ of offline work. Any number of jobs may be added, each renders a graph into a Buffer, then 
+ render() processes them all. The output channels of every job are units of work which are 
+ shared between a pool of worker threads and the calling thread. Blocks are much larger than 
+ those used in real time and the threads never yield.
+ 
+ @code
+	OfflineRenderer renderer;			// one thread per CPU, 8192 sample blocks
+	
+	Buffer stem1 = Buffer::withSize(44100 * 60, 2);
+	Buffer stem2 = Buffer::withSize(44100 * 60, 2);
+	renderer.addSynth(stem1, graph1);
+	renderer.addSynth(stem2, graph2);
+	
+	renderer.render();					// returns false if cancel() was called
+ @endcode
+ 
+ The jobs are rendered in lock step: each block the calling thread prepares every graph 
+ (so UGen objects are created and deleted by a single thread) then the units are processed in 
+ parallel. Each job is split into blocks exactly as synthInPlace() would (block IDs are the 
+ sample offsets from the start of the job) so the output is identical to rendering the job 
+ with synthInPlace() or processInPlace() using the same block size (see setBlockSize()). Jobs
+ added after a render() has started are rendered on their own until they catch up with the 
+ others. 
+ 
+ Each block the graphs are walked using UGenInternal::addDependencies(), channels which share 
+ any UGenInternal objects (e.g., the channels of a Pan2 or several channels reading the same 
+ filter) are processed together in channel order as one unit, only channels which are completely 
+ independent (or share only constants) are processed in parallel.
+ 
+ Progress is reported to an OfflineRendererListener and by getProgress(), either of which may
+ call cancel(). cancel() may be called from any thread, the jobs which haven't finished keep 
+ their state so calling render() again continues from where it stopped.
+ 
+ Notes:
+ - As with Buffer::synth() none of the UGens in the graphs should be used in real time.
+ - Reference counts are made atomic while rendering (see SmartPointer::setAtomicRefCounts()).
+ 
+ @see Buffer::synthInPlace(), Buffer::processInPlace(), ParallelRenderer */
+class OfflineRenderer : private UGenDependencies
+{
+public:
+	/** Construct a renderer.
+	 @param numThreads	The total number of threads to use including the calling thread, 
+						0 means one thread per CPU.
+	 @param blockSize	The number of samples to render in each block. */
+	OfflineRenderer(const int numThreads = 0, const int blockSize = 8192) throw();
+	~OfflineRenderer();
+	
+	/** Add a job which synthesises into an existing Buffer using a UGen graph.
+	 This is the equivalent of Buffer::synthInPlace().
+	 @param buffer		The Buffer to render into, the data is shared with the caller's Buffer.
+	 @param graph		The audio graph to process to synthesise the audio.
+	 @param offset		The start sample within the Buffer.
+	 @param numSamples	The number of samples to process, 0 means all remaining samples.
+	 @return			The job ID passed to the OfflineRendererListener. */
+	int addSynth(Buffer const& buffer, 
+				 UGen const& graph, 
+				 const int offset = 0, 
+				 const int numSamples = 0) throw();
+	
+	/** Add a job which processes a Buffer in-place through a UGen graph.
+	 This is the equivalent of Buffer::processInPlace().
+	 @param buffer		The Buffer to process, the data is shared with the caller's Buffer.
+	 @param input		An AudioIn UGen which is at the top of the graph.
+	 @param graph		The audio graph to process the audio with input at the top. 
+	 @param offset		The start sample within the Buffer.
+	 @param numSamples	The number of samples to process, 0 means all remaining samples.
+	 @return			The job ID passed to the OfflineRendererListener. */
+	int addProcess(Buffer const& buffer, 
+				   UGen const& input, 
+				   UGen const& graph, 
+				   const int offset = 0, 
+				   const int numSamples = 0) throw();
+	
+	/** Render all of the jobs which haven't finished.
+	 This blocks until they have finished or cancel() is called. 
+	 @return true if all the jobs finished, false if cancelled. */
+	bool render() throw();
+	
+	/** Stop render() at the end of the current block, this may be called from any thread. */
+	inline void cancel() throw()						{ shouldCancel = 1;					}
+	inline bool isCancelled() const throw()				{ return shouldCancel != 0;			}
+	
+	/** Remove all the jobs, this must not be called during render(). */
+	void clear() throw();
+	
+	/** The proportion (0-1) of all the jobs' samples rendered so far, this may be called from any thread. */
+	inline double getProgress() const throw()			{ return progress;					}
+	inline int getNumJobs() const throw()				{ return numJobs;					}
+	inline int getNumJobsFinished() const throw()		{ return numJobsFinished;			}
+	
+	void setListener(OfflineRendererListener* listener) throw();
+	
+	/** Set the number of samples to render in each block, this must not be called during render(). */
+	void setBlockSize(const int blockSize) throw();
+	inline int getBlockSize() const throw()				{ return blockSize_;				}
+	
+	inline int getNumThreads() const throw()			{ return numWorkers + 1;			}
+	
+	/** @internal */
+	void work() throw();
+	
+private:
+	struct Job
+	{
+		Buffer buffer;
+		UGen input;
+		UGen graph;
+		int offset;
+		int numSamples;
+		int numChannels;
+		int position;
+		bool isProcess;
+	};
+	
+	struct Unit
+	{
+		Job* job;
+		int firstChannel;
+		int numChannels;
+	};
+	
+	class Worker;
+	
+	void add(UGenInternal* internal, const int channel, const bool passesDeletion) throw();
+	int findGroup(int channel) throw();
+	void addUnits(Job& job) throw();
+	
+	template<class ElementType>
+	static void ensureSize(ElementType*& array, int& allocatedSize, const int requiredSize) throw();
+	
+	int addJob(Job* job) throw();
+	void finishJob(const int jobIndex) throw();
+	void runUnits() throw();
+	
+	Worker** workers;
+	int numWorkers;
+	Semaphore wakeWorkers;
+	Semaphore workersFinished;
+	
+	int blockSize_;
+	OfflineRendererListener* listener_;
+	
+	Job** jobs;
+	int numJobs, allocatedJobs;
+	Unit* units;
+	int numUnits, allocatedUnits;
+	int* unitChannels;
+	int numUnitChannels, allocatedUnitChannels;
+	int* groups;
+	int allocatedGroups;
+	int currentGroup;
+	unsigned int pass;
+	
+	unsigned int currentBlockID;
+	volatile int nextUnit;
+	volatile int shouldCancel;
+	volatile int numJobsFinished;
+	volatile double progress;
+	
+	OfflineRenderer (const OfflineRenderer&);
+    const OfflineRenderer& operator= (const OfflineRenderer&);
+};
+
+#endif // UGEN_OFFLINERENDERER_H
@@ -0,0 +1,579 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#include "ugen_StandardHeader.h"
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_ParallelRenderer.h"
+#include "ugen_Atomics.h"
+
+/** @internal */
+class ParallelRenderer::Worker : public UGenThread
+{
+public:
+	Worker(ParallelRenderer& renderer, Semaphore& wake, const int threadIndex) throw()
+	:	renderer_(renderer),
+		wake_(wake),
+		threadIndex_(threadIndex)
+	{
+	}
+	
+	~Worker()
+	{
+		stopThread();
+	}
+	
+	void run()
+	{
+		while(true)
+		{
+			wake_.wait();
+			
+			if(threadShouldExit()) 
+				break;
+			
+			renderer_.work(threadIndex_);
+		}
+	}
+	
+private:
+	ParallelRenderer& renderer_;
+	Semaphore& wake_;
+	const int threadIndex_;
+};
+
+ParallelRenderer::ParallelRenderer(const int numThreads) throw()
+:	workers(0),
+	numWorkers(0),
+	minimumTaskSize(8),
+	pass(0),
+	currentBlockID(0),
+	hasSchedule(false),
+	scheduledGeneration(0),
+	scheduledChannel(0),
+	numSchedules(0),
+	roots(0), numRoots(0), allocatedRoots(0),
+	nodes(0), numNodes(0), allocatedNodes(0),
+	edges(0), numEdges(0), allocatedEdges(0),
+	stack(0), numStacked(0), allocatedStack(0),
+	tasks(0), numTasks(0), allocatedTasks(0),
+	dependents(0), numDependents(0), allocatedDependents(0),
+	queues(0),
+	queueTasks(0),
+	allocatedQueueTasks(0),
+	numRemaining(0),
+	numBusy(0)
+{
+	const int numThreadsToUse = numThreads > 0 ? numThreads : UGenThread::getNumCPUs();
+	
+	numWorkers = numThreadsToUse - 1;
+	queues = new Queue[numThreadsToUse];
+	
+	for(int i = 0; i < numThreadsToUse; i++)
+	{
+		queues[i].tasks = 0;
+		queues[i].head = 0;
+		queues[i].tail = 0;
+	}
+	
+	if(numWorkers > 0)
+	{
+		workers = new Worker*[numWorkers];
+		
+		for(int i = 0; i < numWorkers; i++)
+		{
+			workers[i] = new Worker(*this, wakeWorkers, i + 1);
+			workers[i]->startThread();
+			workers[i]->setRealtimePriority();
+		}
+	}
+	
+	reserve(256);
+}
+
+ParallelRenderer::~ParallelRenderer()
+{
+	for(int i = 0; i < numWorkers; i++)
+		workers[i]->signalThreadShouldExit();
+	
+	for(int i = 0; i < numWorkers; i++)
+		wakeWorkers.signal();
+	
+	for(int i = 0; i < numWorkers; i++)
+		delete workers[i];
+	
+	delete [] workers;
+	delete [] queues;
+	delete [] queueTasks;
+	delete [] nodes;
+	delete [] edges;
+	delete [] stack;
+	delete [] tasks;
+	delete [] dependents;
+	delete [] roots;
+}
+
+template<class ElementType>
+void ParallelRenderer::ensureSize(ElementType*& array, int& allocatedSize, const int requiredSize) throw()
+{
+	if(requiredSize <= allocatedSize) return;
+	
+	int newSize = allocatedSize > 0 ? allocatedSize : 16;
+	while(newSize < requiredSize) newSize *= 2;
+	
+	ElementType* newArray = new ElementType[newSize];
+	
+	if(array != 0)
+	{
+		memcpy(newArray, array, allocatedSize * sizeof(ElementType));
+		delete [] array;
+	}
+	
+	array = newArray;
+	allocatedSize = newSize;
+}
+
+void ParallelRenderer::setMinimumTaskSize(const int numInternals) throw()
+{
+	minimumTaskSize = numInternals < 1 ? 1 : numInternals;
+	hasSchedule = false;
+}
+
+void ParallelRenderer::reserve(const int numInternals) throw()
+{
+	ensureSize(nodes, allocatedNodes, numInternals);
+	ensureSize(edges, allocatedEdges, numInternals * 2);
+	ensureSize(stack, allocatedStack, numInternals * 2);
+	ensureSize(tasks, allocatedTasks, numInternals);
+	ensureSize(dependents, allocatedDependents, numInternals * 2);
+	
+	// each queue needs to be able to hold every task
+	const int numThreads = numWorkers + 1;
+	
+	if(allocatedTasks * numThreads > allocatedQueueTasks)
+	{
+		delete [] queueTasks;
+		allocatedQueueTasks = allocatedTasks * numThreads;
+		queueTasks = new int[allocatedQueueTasks];
+		
+		for(int i = 0; i < numThreads; i++)
+			queues[i].tasks = queueTasks + i * allocatedTasks;
+	}
+}
+
+int ParallelRenderer::visit(UGenInternal* internal, const int channel) throw()
+{
+	if(internal->schedulePass == pass) 
+		return internal->scheduleIndex; // -1 if we're still visiting it i.e., a feedback loop
+	
+	internal->schedulePass = pass;
+	internal->scheduleIndex = -1;
+	
+	// dependencies are collected on the stack by add() then copied to the edges
+	const int stackStart = numStacked;
+	internal->addDependencies(*this, channel);
+	const int numNodeEdges = numStacked - stackStart;
+	
+	const int index = numNodes++;
+	ensureSize(nodes, allocatedNodes, numNodes);
+	ensureSize(edges, allocatedEdges, numEdges + numNodeEdges);
+	
+	Node& node = nodes[index];
+	node.internal = internal;
+	node.channel = channel;
+	node.firstEdge = numEdges;
+	node.numEdges = 0;
+	node.numConsumers = 0;
+	node.consumer = -1;
+	node.isRoot = false;
+	
+	for(int i = stackStart; i < numStacked; i++)
+	{
+		Node& dependency = nodes[stack[i].node];
+		
+		if(dependency.consumer == index) 
+			continue; // already added e.g., x * x
+		
+		dependency.numConsumers++;
+		dependency.consumer = index;
+		edges[numEdges++] = stack[i];
+		node.numEdges++;
+	}
+	
+	numStacked = stackStart;
+	internal->scheduleIndex = index;
+	
+	return index;
+}
+
+void ParallelRenderer::add(UGenInternal* internal, const int channel, const bool passesDeletion) throw()
+{
+	const int index = visit(internal, channel);
+	
+	if(index >= 0)
+	{
+		ensureSize(stack, allocatedStack, numStacked + 1);
+		stack[numStacked].node = index;
+		stack[numStacked].passesDeletion = passesDeletion;
+		numStacked++;
+	}
+}
+
+bool ParallelRenderer::needsSchedule(UGen& graph, const int channel) const throw()
+{
+	if((hasSchedule == false) || 
+	   (scheduledChannel != channel) || 
+	   (scheduledGeneration != UGenInternal::graphGeneration) ||
+	   (numRoots != graph.getNumChannels()))
+		return true;
+	
+	// the same UGenInternal objects can be rendered from a different UGen
+	bool changed = false;
+	
+	for(int i = 0; i < numRoots && changed == false; i++)
+	{
+		UGenInternal* internal = graph.getInternalUGen(i);
+		changed = internal != roots[i];
+		internal->decrementRefCount();
+	}
+	
+	return changed;
+}
+
+void ParallelRenderer::buildSchedule(UGen& graph, const int channel) throw()
+{
+	// read first so anything created or deleted while we walk the graph causes another schedule
+	scheduledGeneration = UGenInternal::graphGeneration;
+	Atomics::memoryBarrier();
+	
+	pass = (unsigned int)Atomics::increment(UGenInternal::nextSchedulePass);
+	numSchedules++;
+	numNodes = 0;
+	numEdges = 0;
+	numStacked = 0;
+	
+	const int numChannels = graph.getNumChannels();
+	const int firstChannel = channel < 0 ? 0 : channel;
+	const int lastChannel = channel < 0 ? numChannels - 1 : channel;
+	int i;
+	
+	ensureSize(roots, allocatedRoots, numChannels);
+	numRoots = numChannels;
+	
+	for(i = 0; i < numChannels; i++)
+	{
+		roots[i] = graph.getInternalUGen(i);
+		roots[i]->decrementRefCount();
+	}
+	
+	for(i = firstChannel; i <= lastChannel; i++)
+	{
+		const int index = visit(roots[i % numChannels], i);
+		
+		if(index >= 0) 
+			nodes[index].isRoot = true;
+	}
+	
+	scheduledChannel = channel;
+	hasSchedule = true;
+	
+	buildTasks();
+}
+
+void ParallelRenderer::buildTasks() throw()
+{
+	int i, j;
+	
+	// nodes are in dependency order so the dependencies' weights are known before their consumers'
+	// ..a consumer takes inputs into its own task while it has room, the rest become tasks (e.g., the voices of a Mix)
+	for(i = 0; i < numNodes; i++)
+	{
+		Node& node = nodes[i];
+		node.weight = node.internal->isScalar() ? 0 : 1; // constants cost almost nothing
+		node.task = 0;
+		
+		for(j = 0; j < node.numEdges; j++)
+		{
+			Node& dependency = nodes[edges[node.firstEdge + j].node];
+			
+			if((dependency.isRoot == false) && 
+			   ((dependency.weight == 0) ||
+				((dependency.numConsumers == 1) && (node.weight + dependency.weight < 2 * minimumTaskSize))))
+			{
+				dependency.task = -1;
+				node.weight += dependency.weight;
+			}
+		}
+	}
+	
+	// in reverse so the consumers' owners are known first
+	numTasks = 0;
+	
+	for(i = numNodes - 1; i >= 0; i--)
+	{
+		Node& node = nodes[i];
+		node.owner = (node.task < 0) ? nodes[node.consumer].owner : i;
+	}
+	
+	for(i = 0; i < numNodes; i++)
+	{
+		Node& node = nodes[i];
+		
+		if(node.task >= 0)
+		{
+			node.task = numTasks++;
+			ensureSize(tasks, allocatedTasks, numTasks);
+			
+			Task& task = tasks[node.task];
+			task.internal = node.internal;
+			task.channel = node.channel;
+			task.numDependents = 0;
+			task.numDependencies = 0;
+		}
+	}
+	
+	// count then fill in the dependents of each task
+	numDependents = 0;
+	
+	for(int fill = 0; fill < 2; fill++)
+	{
+		if(fill == 1)
+		{
+			ensureSize(dependents, allocatedDependents, numDependents);
+			
+			numDependents = 0;
+			for(i = 0; i < numTasks; i++)
+			{
+				tasks[i].firstDependent = numDependents;
+				numDependents += tasks[i].numDependents;
+				tasks[i].numDependents = 0;
+			}
+		}
+		
+		for(i = 0; i < numNodes; i++)
+		{
+			Node& node = nodes[i];
+			Task& consumer = tasks[nodes[node.owner].task];
+			
+			for(j = 0; j < node.numEdges; j++)
+			{
+				Edge& edge = edges[node.firstEdge + j];
+				Node& dependency = nodes[edge.node];
+				
+				if(dependency.task < 0) continue;
+				
+				Task& task = tasks[dependency.task];
+				
+				if(fill == 0)
+				{
+					numDependents++;
+					consumer.numDependencies++;
+				}
+				else
+				{
+					Edge& dependent = dependents[task.firstDependent + task.numDependents];
+					dependent.node = nodes[node.owner].task;
+					dependent.passesDeletion = edge.passesDeletion;
+				}
+				
+				task.numDependents++;
+			}
+		}
+	}
+	
+	reserve(numNodes);
+}
+
+float* ParallelRenderer::prepareAndProcessBlock(UGen& graph, const int actualBlockSize, const unsigned int blockID, const int channel) throw()
+{
+	if(numWorkers == 0)
+		return graph.prepareAndProcessBlock(actualBlockSize, blockID, channel);
+	
+	if(channel < 0)
+	{
+		graph.prepareForBlock(actualBlockSize, blockID, -1);
+	}
+	else
+	{
+		for(int i = 0; i < graph.getNumChannels(); i++)
+		{
+			graph.prepareForBlock(actualBlockSize, blockID, i);
+		}		
+	}
+	
+	if(needsSchedule(graph, channel))
+		buildSchedule(graph, channel);
+	
+	if(numTasks > 1)
+	{
+		const int numThreads = numWorkers + 1;
+		int i;
+		
+		for(i = 0; i < numThreads; i++)
+		{
+			queues[i].head = 0;
+			queues[i].tail = 0;
+		}
+		
+		int nextQueue = 0;
+		
+		for(i = 0; i < numTasks; i++)
+		{
+			Task& task = tasks[i];
+			task.pending = task.numDependencies;
+			task.shouldDelete = 0;
+			
+			if(task.numDependencies == 0)
+			{
+				Queue& queue = queues[nextQueue];
+				queue.tasks[queue.tail++] = i;
+				nextQueue = (nextQueue + 1) % numThreads;
+			}
+		}
+		
+		currentBlockID = blockID;
+		Atomics::increment(UGenInternal::numParallelRenderers);
+		Atomics::add(numRemaining, numTasks); // this is the last thing the workers check
+		
+		for(i = 0; i < numWorkers; i++)
+			wakeWorkers.signal();
+		
+		runTasks(0);
+		
+		// wait for any workers still leaving runTasks()
+		while(numBusy != 0)
+			Atomics::pause();
+		
+		Atomics::decrement(UGenInternal::numParallelRenderers);
+	}
+	
+	// anything left is processed normally, the scheduled UGenInternal objects return their cached output
+	bool shouldDelete = false;
+	return graph.processBlock(shouldDelete, blockID, channel);
+}
+
+void ParallelRenderer::work(const int threadIndex) throw()
+{
+	Atomics::increment(numBusy);
+	
+	if(numRemaining > 0) 
+		runTasks(threadIndex);
+	
+	Atomics::decrement(numBusy);
+}
+
+void ParallelRenderer::runTasks(const int threadIndex) throw()
+{
+	int next = -1;
+	
+	while(true)
+	{
+		const int taskIndex = (next >= 0) ? next : popTask(threadIndex);
+		next = -1;
+		
+		if(taskIndex < 0)
+		{
+			if(numRemaining == 0) 
+				break;
+			
+			Atomics::pause();
+			continue;
+		}
+		
+		Task& task = tasks[taskIndex];
+		
+		bool shouldDelete = task.shouldDelete != 0;
+		task.internal->processBlockInternal(shouldDelete, currentBlockID, task.channel);
+		
+		for(int i = 0; i < task.numDependents; i++)
+		{
+			Edge& dependent = dependents[task.firstDependent + i];
+			Task& consumer = tasks[dependent.node];
+			
+			if(shouldDelete && dependent.passesDeletion)
+				consumer.shouldDelete = 1;
+			
+			if(Atomics::decrement(consumer.pending) == 0)
+			{
+				// continue with the first ready consumer on this thread, share the others
+				if(next < 0)
+					next = dependent.node;
+				else
+					pushTask(threadIndex, dependent.node);
+			}
+		}
+		
+		Atomics::decrement(numRemaining);
+	}
+}
+
+int ParallelRenderer::popTask(const int threadIndex) throw()
+{
+	const int numThreads = numWorkers + 1;
+	
+	// our own queue first then steal from the others
+	for(int i = 0; i < numThreads; i++)
+	{
+		Queue& queue = queues[(threadIndex + i) % numThreads];
+		
+		while(true)
+		{
+			const int head = queue.head;
+			
+			if(head >= queue.tail) 
+				break;
+			
+			if(Atomics::compareAndSwap(queue.head, head, head + 1))
+				return queue.tasks[head];
+		}
+	}
+	
+	return -1;
+}
+
+void ParallelRenderer::pushTask(const int threadIndex, const int task) throw()
+{
+	// only this thread pushes to its own queue
+	Queue& queue = queues[threadIndex];
+	const int tail = queue.tail;
+	queue.tasks[tail] = task;
+	Atomics::memoryBarrier();
+	queue.tail = tail + 1;
+}
+
+END_UGEN_NAMESPACE
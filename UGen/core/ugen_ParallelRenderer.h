@@ -0,0 +1,207 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#ifndef UGEN_PARALLELRENDERER_H
+#define UGEN_PARALLELRENDERER_H
+
+#include "ugen_UGen.h"
+#include "ugen_UGenInternal.h"
+#include "ugen_Threads.h"
+
+/** Renders a UGen graph using several threads.
+ 
+ Normally a graph is rendered by UGen::prepareAndProcessBlock() which recursively pulls
+ each UGenInternal's inputs on a single thread. Instead, the ParallelRenderer flattens the 
+ graph into a schedule of UGenInternal objects in dependency order (using
+ UGenInternal::addDependencies()) and runs independent parts of the graph on a fixed pool 
+ of worker threads. Inputs which have only one consumer are grouped into their consumer's 
+ task (and processed by the normal recursive pull) while the task holds fewer than twice the 
+ minimum task size UGenInternal objects (constants aren't counted), any further inputs are 
+ scheduled as tasks of their own. So a chain or a small voice stays in one task while the 
+ voices of a Mix are split between tasks (except the first few which the Mix's own task takes)
+ and the scheduling overhead is only spent where there is useful parallelism.
+ 
+ The schedule is kept from block to block. It is only made again when the graph has changed
+ since (a Spawn adding an event, a UGen ending or a UGenInternal in the schedule being deleted,
+ see UGenInternal::graphChanged()), when a different graph or channel is rendered or when the 
+ minimum task size is changed. Building or deleting UGenInternal objects elsewhere (e.g., in a 
+ VoicePool or another graph) doesn't. Sources which aren't added as dependencies (e.g., those of
+ a Plug) are rendered by the normal recursive pull of their consumer.
+ 
+ @code
+	ParallelRenderer renderer; // one thread per CPU
+ 
+	// ...then in the audio callback instead of graph.prepareAndProcessBlock(...)
+	renderer.prepareAndProcessBlock(graph, blockSize, blockID, -1);
+ @endcode
+ 
+ The worker threads are woken using a Semaphore each block and the ready tasks are 
+ shared using lock-free queues (one per thread, idle threads steal from the others) so
+ the audio thread never takes a lock. The audio thread also renders tasks and waits
+ for the workers by spinning at the end of the block. No memory is allocated while
+ rendering once the schedule has grown to fit the graph (see reserve()).
+ 
+ Notes:
+ - UGenInternal objects shared between tasks are safe, only one thread will process
+   each block and any others will wait for its result.
+ - Reference counts are not atomic by default so UGen objects should not be created or 
+   destroyed by processBlock() functions running on different threads (e.g., a Spawn-type 
+   UGen is fine but two Spawn-type UGen instances sharing the same sources may not be) 
+   unless SmartPointer::setAtomicRefCounts() is used.
+ 
+ @see UGen::prepareAndProcessBlock(), UGenInternal::addDependencies() */
+class ParallelRenderer : private UGenDependencies
+{
+public:
+	/** Construct a renderer.
+	 @param numThreads	The total number of threads to use including the calling (audio) thread, 
+						0 means one thread per CPU. If this is 1 the graph is rendered normally. */
+	ParallelRenderer(const int numThreads = 0) throw();
+	~ParallelRenderer();
+	
+	/** Prepare and process a block of a graph, this is the equivalent of UGen::prepareAndProcessBlock(). */
+	float* prepareAndProcessBlock(UGen& graph, const int actualBlockSize, const unsigned int blockID, const int channel) throw();
+	
+	/** Inputs with only one consumer are processed by their consumer rather than being scheduled 
+	 separately while the consumer's task holds fewer than twice this number of UGenInternal 
+	 objects. The default is 8. */
+	void setMinimumTaskSize(const int numInternals) throw();
+	
+	/** Allocate enough space to schedule graphs with up to this many UGenInternal objects. */
+	void reserve(const int numInternals) throw();
+	
+	inline int getNumThreads() const throw()	{ return numWorkers + 1;	}
+	
+	/** The number of tasks in the most recent schedule. */
+	inline int getNumTasks() const throw()		{ return numTasks;			}
+	
+	/** The number of times the graph has been walked and the schedule made. */
+	inline int getNumSchedules() const throw()	{ return numSchedules;		}
+	
+	/** @internal */
+	void work(const int threadIndex) throw();
+	
+private:
+	struct Node
+	{
+		UGenInternal* internal;
+		int channel;
+		int firstEdge;
+		int numEdges;
+		int numConsumers;
+		int consumer;
+		int weight;
+		int owner;
+		int task;
+		bool isRoot;
+	};
+	
+	struct Edge
+	{
+		int node;
+		bool passesDeletion;
+	};
+	
+	struct Task
+	{
+		UGenInternal* internal;
+		int channel;
+		int firstDependent;
+		int numDependents;
+		int numDependencies;
+		volatile int pending;
+		volatile int shouldDelete;
+	};
+	
+	struct Queue
+	{
+		int* tasks;
+		volatile int head;
+		volatile int tail;
+	};
+	
+	class Worker;
+	
+	void add(UGenInternal* internal, const int channel, const bool passesDeletion) throw();
+	int visit(UGenInternal* internal, const int channel) throw();
+	bool needsSchedule(UGen& graph, const int channel) const throw();
+	void buildSchedule(UGen& graph, const int channel) throw();
+	void buildTasks() throw();
+	void runTasks(const int threadIndex) throw();
+	int popTask(const int threadIndex) throw();
+	void pushTask(const int threadIndex, const int task) throw();
+	
+	template<class ElementType>
+	static void ensureSize(ElementType*& array, int& allocatedSize, const int requiredSize) throw();
+	
+	Worker** workers;
+	int numWorkers;
+	Semaphore wakeWorkers;
+	
+	int minimumTaskSize;
+	unsigned int pass;
+	unsigned int currentBlockID;
+	
+	bool hasSchedule;
+	int scheduledGeneration;
+	int scheduledChannel;
+	int numSchedules;
+	UGenInternal** roots;
+	int numRoots, allocatedRoots;
+	
+	Node* nodes;
+	int numNodes, allocatedNodes;
+	Edge* edges;
+	int numEdges, allocatedEdges;
+	Edge* stack;
+	int numStacked, allocatedStack;
+	Task* tasks;
+	int numTasks, allocatedTasks;
+	Edge* dependents;
+	int numDependents, allocatedDependents;
+	Queue* queues;
+	int* queueTasks;
+	int allocatedQueueTasks;
+	
+	volatile int numRemaining;
+	volatile int numBusy;
+	
+	ParallelRenderer (const ParallelRenderer&);
+    const ParallelRenderer& operator= (const ParallelRenderer&);
+};
+
+#endif // UGEN_PARALLELRENDERER_H
@@ -0,0 +1,210 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#include "ugen_StandardHeader.h"
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_ParameterQueue.h"
+#include "ugen_Atomics.h"
+#include "ugen_Bits.h"
+#include "../basics/ugen_InlineBinaryOps.h"
+
+#ifdef UGEN_SIMD
+	#include "../vec/ugen_simd_Utilities.h"
+#endif
+
+ParameterQueue::ParameterQueue(const float initialValue, const int capacityToUse) throw()
+:	capacity(Bits::nextPowerOf2(ugen::max(2, capacityToUse))),
+	mask(capacity - 1),
+	events(new Event[capacity]),
+	writeTotal(0),
+	readTotal(0),
+	numDropped(0),
+	immediateValue(initialValue),
+	immediateRampSamples(0),
+	immediateSequence(0),
+	immediateSequenceApplied(0),
+	currentValue(initialValue),
+	targetValue(initialValue),
+	rampIncrement(0.f),
+	rampSamplesRemaining(0),
+	lastBlockTime(0)
+{
+}
+
+ParameterQueue::~ParameterQueue()
+{
+	delete [] events;
+}
+
+bool ParameterQueue::schedule(const float value, const unsigned int sampleTime, const int rampSamples) throw()
+{
+	if((int)(writeTotal - readTotal) >= capacity)
+	{
+		numDropped++;
+		return false;
+	}
+	
+	Event& event = events[writeTotal & mask];
+	event.time = sampleTime;
+	event.value = value;
+	event.rampSamples = ugen::max(0, rampSamples);
+	
+	// publish the event only after it has been written
+	Atomics::memoryBarrier();
+	writeTotal = writeTotal + 1;
+	
+	return true;
+}
+
+void ParameterQueue::set(const float value, const int rampSamples) throw()
+{
+	// a sequence lock, the consumer ignores the fields while the sequence is odd or changes under it
+	immediateSequence = immediateSequence + 1;
+	Atomics::memoryBarrier();
+	
+	immediateValue = value;
+	immediateRampSamples = ugen::max(0, rampSamples);
+	
+	Atomics::memoryBarrier();
+	immediateSequence = immediateSequence + 1;
+}
+
+void ParameterQueue::start(const float value, const int rampSamples) throw()
+{
+	targetValue = value;
+	
+	if(rampSamples > 0)
+	{
+		rampIncrement = (value - currentValue) / (float)rampSamples;
+		rampSamplesRemaining = rampSamples;
+	}
+	else
+	{
+		currentValue = value;
+		rampIncrement = 0.f;
+		rampSamplesRemaining = 0;
+	}
+}
+
+void ParameterQueue::renderSegment(float* outputSamples, int numSamples) throw()
+{
+	if(rampSamplesRemaining > 0 && numSamples > 0)
+	{
+		const int numRampSamples = ugen::min(numSamples, rampSamplesRemaining);
+		LOCAL_DECLARE(float, currentValue);
+		LOCAL_DECLARE(float, rampIncrement);
+		
+		for(int i = 0; i < numRampSamples; ++i)
+		{
+			currentValue += rampIncrement;
+			outputSamples[i] = currentValue;
+		}
+		
+		rampSamplesRemaining -= numRampSamples;
+		
+		if(rampSamplesRemaining == 0)
+			currentValue = outputSamples[numRampSamples - 1] = targetValue; // land exactly on the target
+		
+		LOCAL_COPY(currentValue);
+		outputSamples += numRampSamples;
+		numSamples -= numRampSamples;
+	}
+	
+	if(numSamples > 0)
+	{
+#if defined(UGEN_SIMD)
+		SIMD::splat(currentValue, outputSamples, numSamples);
+#else
+		const float value = currentValue;
+		for(int i = 0; i < numSamples; ++i)
+			outputSamples[i] = value;
+#endif
+	}
+}
+
+void ParameterQueue::render(float* outputSamples, const int numSamples, const unsigned int blockTime) throw()
+{
+	const unsigned int sequence = immediateSequence;
+	
+	if(sequence != immediateSequenceApplied && (sequence & 1) == 0)
+	{
+		Atomics::memoryBarrier();
+		const float value = immediateValue;
+		const int rampSamples = immediateRampSamples;
+		Atomics::memoryBarrier();
+		
+		if(immediateSequence == sequence) // otherwise set() was called again, try on the next block
+		{
+			immediateSequenceApplied = sequence;
+			start(value, rampSamples);
+		}
+	}
+	
+	unsigned int available = writeTotal - readTotal;
+	Atomics::memoryBarrier(); // read the events only after reading the count
+	
+	int offset = 0;
+	
+	while(available > 0)
+	{
+		const Event& event = events[readTotal & mask];
+		const int eventOffset = (int)(event.time - blockTime);
+		
+		if(eventOffset >= numSamples)
+			break;
+		
+		if(eventOffset > offset)
+		{
+			renderSegment(outputSamples + offset, eventOffset - offset);
+			offset = eventOffset;
+		}
+		
+		start(event.value, event.rampSamples);
+		
+		// free the slot only after it has been read
+		Atomics::memoryBarrier();
+		readTotal = readTotal + 1;
+		available--;
+	}
+	
+	renderSegment(outputSamples + offset, numSamples - offset);
+	lastBlockTime = blockTime;
+}
+
+END_UGEN_NAMESPACE
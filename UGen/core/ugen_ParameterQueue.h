@@ -0,0 +1,159 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#ifndef _UGEN_ugen_ParameterQueue_H_
+#define _UGEN_ugen_ParameterQueue_H_
+
+
+/** A lock-free queue of timestamped parameter changes rendered at sample accuracy.
+ 
+ Parameter changes come from a single producer thread (e.g., a GUI, MIDI or host automation 
+ thread) and are rendered by the audio thread into a block of samples. Events carry a time in 
+ the same sample clock as the blockID passed to UGenInternal::processBlock() (see 
+ UGen::getCurrentBlockID()) and are applied at that exact offset within the block. An optional 
+ ramp moves linearly from the current value to the new value over a number of samples so 
+ changes may be smoothed without adding a Lag. 
+ 
+ Events are stored in a preallocated ring so neither side allocates or blocks: schedule() 
+ returns false and counts a drop if the ring is full. Events are applied in the order they 
+ were scheduled so they should be scheduled in time order, events which are already late are 
+ applied at the start of the next block rendered.
+ 
+ set() bypasses the ring and changes the value at the start of the next block, only the most 
+ recent value set is used so this can be called at any rate without filling the ring.
+ 
+ @see ExternalControlSource */
+class ParameterQueue
+{
+public:
+	/// @name Construction and destruction
+	/// @{
+	
+	/** Create a queue.
+	 @param initialValue	The value rendered before any events are applied.
+	 @param capacity		The maximum number of pending events (rounded up to a power of 2). */
+	ParameterQueue(const float initialValue = 0.f, const int capacity = 64) throw();
+	~ParameterQueue();
+	
+	/// @} <!-- end Construction and destruction -->
+	
+	/// @name Producer
+	/// @{
+	
+	/** Schedule a change of value at a particular sample time.
+	 @param value		The new value.
+	 @param sampleTime	The sample time at which the change (or ramp) starts.
+	 @param rampSamples	The number of samples to ramp to the new value over, 0 jumps immediately.
+	 @return			false if the queue was full and the event was dropped. */
+	bool schedule(const float value, const unsigned int sampleTime, const int rampSamples = 0) throw();
+	
+	/** Change the value at the start of the next block rendered. 
+	 @param value		The new value.
+	 @param rampSamples	The number of samples to ramp to the new value over, 0 jumps immediately. */
+	void set(const float value, const int rampSamples = 0) throw();
+	
+	/// @} <!-- end Producer -->
+	
+	/// @name Consumer
+	/// @{
+	
+	/** Render a block of values applying any events which are due within it. 
+	 @param outputSamples	The destination for numSamples values.
+	 @param numSamples		The number of samples to render.
+	 @param blockTime		The sample time of the first sample in the block (i.e., the blockID). */
+	void render(float* outputSamples, const int numSamples, const unsigned int blockTime) throw();
+	
+	/// @} <!-- end Consumer -->
+	
+	/// @name Information and statistics
+	/// @{
+	
+	/** The most recent value rendered. */
+	inline float getCurrentValue() const throw()			{ return currentValue;						}
+	
+	/** The value the current ramp (if any) is heading for. */
+	inline float getTargetValue() const throw()				{ return targetValue;						}
+	
+	/** The sample time of the most recent block rendered. */
+	inline unsigned int getLastBlockTime() const throw()	{ return lastBlockTime;						}
+	
+	inline int getCapacity() const throw()					{ return capacity;							}
+	
+	/** The number of scheduled events not yet applied. */
+	inline int getNumPending() const throw()				{ return (int)(writeTotal - readTotal);		}
+	
+	/** The number of events dropped because the queue was full. */
+	inline int getNumDropped() const throw()				{ return numDropped;						}
+	
+	/// @} <!-- end Information and statistics -->
+	
+private:
+	struct Event
+	{
+		unsigned int time;
+		float value;
+		int rampSamples;
+	};
+	
+	void start(const float value, const int rampSamples) throw();
+	void renderSegment(float* outputSamples, int numSamples) throw();
+	
+	const int capacity;
+	const unsigned int mask;
+	Event* events;
+	
+	volatile unsigned int writeTotal;		// events scheduled, advanced by the producer only
+	volatile unsigned int readTotal;		// events applied, advanced by the consumer only
+	volatile int numDropped;
+	
+	volatile float immediateValue;			// written by set() under immediateSequence
+	volatile int immediateRampSamples;
+	volatile unsigned int immediateSequence;// odd while set() is writing
+	unsigned int immediateSequenceApplied;
+	
+	float currentValue;
+	float targetValue;
+	float rampIncrement;
+	int rampSamplesRemaining;
+	volatile unsigned int lastBlockTime;
+	
+	ParameterQueue (const ParameterQueue&);
+    const ParameterQueue& operator= (const ParameterQueue&);
+};
+
+
+#endif // _UGEN_ugen_ParameterQueue_H_
@@ -40,9 +40,138 @@
 BEGIN_UGEN_NAMESPACE
 
 #include "ugen_Random.h"
+#include "ugen_Atomics.h"
 
+#ifdef UGEN_SIMD
+	#include "../vec/ugen_simd_Utilities.h"
+#endif
 
+#ifndef UGEN_NOEXTGPL
 
+static volatile unsigned int instanceSeed = 0;
+static volatile int instanceCount = 0;
 
+/** Scrambles the bits of a seed (the MurmurHash3 finaliser) so nearby seeds give unrelated streams. */
+static inline unsigned int mixSeed(unsigned int seed) throw()
+{
+	seed ^= seed >> 16;
+	seed *= 0x85EBCA6BU;
+	seed ^= seed >> 13;
+	seed *= 0xC2B2AE35U;
+	seed ^= seed >> 16;
+	return seed;
+}
+
+unsigned int Ran088::getInstanceSeed() throw()
+{
+	const unsigned int seed = instanceSeed;
+	
+	if(seed == 0)
+		return (unsigned int)rand(0x7fffffff);
+	
+	const unsigned int count = (unsigned int)Atomics::increment(instanceCount);
+	const unsigned int instance = mixSeed(seed + count * 0x9E3779B9U);
+	return instance != 0 ? instance : 1U; // zero would mean a random seed
+}
+
+void Ran088::setInstanceSeed(const unsigned int seed) throw()
+{
+	instanceCount = 0;
+	Atomics::memoryBarrier();
+	instanceSeed = seed;
+}
+
+Ran088Block::Ran088Block(const unsigned int seed) throw()
+{
+	setSeed(seed);
+}
+
+void Ran088Block::setSeed(unsigned int seed) throw()
+{
+	if(seed == 0)
+		seed = Ran088::getInstanceSeed();
+	
+	for(int i = 0; i < NumGenerators; i++)
+	{
+		// as Ran088::setSeed() but with a different seed for each generator
+		const unsigned int generatorSeed = mixSeed(seed + i * 0x9E3779B9U);
+		unsigned int& s1 = state[i];
+		unsigned int& s2 = state[i + NumGenerators];
+		unsigned int& s3 = state[i + NumGenerators * 2];
+		s1 = 1243598713U ^ generatorSeed; if (s1 <  2) s1 = 1243598713U;
+		s2 = 3093459404U ^ generatorSeed; if (s2 <  8) s2 = 3093459404U;
+		s3 = 1821928721U ^ generatorSeed; if (s3 < 16) s3 = 1821928721U;
+	}
+}
+
+void Ran088Block::next(unsigned int* outputValues, const int numValues) throw()
+{
+	if(numValues <= 0) return;
+	
+#if defined(UGEN_SIMD)
+	SIMD::ran088(state, outputValues, numValues);
+#else
+	unsigned int lanes[NumGenerators];
+	
+	for(int i = 0; i < numValues; i += NumGenerators)
+	{
+		for(int j = 0; j < NumGenerators; j++)
+			lanes[j] = Ran088::next(state[j], state[j + NumGenerators], state[j + NumGenerators * 2]);
+		
+		const int numThisTime = min((int)NumGenerators, numValues - i);
+		
+		for(int j = 0; j < numThisTime; j++)
+			outputValues[i + j] = lanes[j];
+	}
+#endif
+}
+
+void Ran088Block::nextFloats(const unsigned int exponentBits, const float offset, float* outputSamples, const int numSamples) throw()
+{
+	if(numSamples <= 0) return;
+	
+#if defined(UGEN_SIMD)
+	SIMD::ran088Float(state, exponentBits, offset, outputSamples, numSamples);
+#else
+	unsigned int values[64];
+	
+	for(int i = 0; i < numSamples; i += 64)
+	{
+		const int numThisTime = min(64, numSamples - i);
+		next(values, numThisTime);
+		
+		for(int j = 0; j < numThisTime; j++)
+		{
+			union { unsigned int i; float f; } u;
+			u.i = exponentBits | (values[j] >> 9);
+			outputSamples[i + j] = u.f - offset;
+		}
+	}
+#endif
+}
+
+void Ran088Block::nextFloat(float* outputSamples, const int numSamples) throw()
+{
+	nextFloats(0x3F800000, 1.f, outputSamples, numSamples);
+}
+
+void Ran088Block::nextBiFloat(float* outputSamples, const int numSamples) throw()
+{
+	nextFloats(0x40000000, 3.f, outputSamples, numSamples);
+}
+
+void Ran088Block::nextFloat8(float* outputSamples, const int numSamples) throw()
+{
+	nextFloats(0x3E800000, 0.375f, outputSamples, numSamples);
+}
+
+float Ran088Block::nextBiFloat() throw()
+{
+	float value;
+	nextBiFloat(&value, 1);
+	return value;
+}
+
+#endif // gpl
 
 END_UGEN_NAMESPACE
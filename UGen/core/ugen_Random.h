@@ -57,6 +57,17 @@ public:
 		return r;
 	}
 	
+	/** A seed for a new UGen instance (e.g., a noise generator).
+	 By default this is a random value from the default generator, after a call
+	 to setInstanceSeed() with a non-zero seed the instance seeds follow a fixed 
+	 sequence so graphs built in the same order produce the same output (e.g., for
+	 reproducible offline renders). */
+	static unsigned int getInstanceSeed() throw();
+	
+	/** Make the instance seeds deterministic, starting a new sequence from this seed.
+	 Zero returns to random instance seeds. */
+	static void setInstanceSeed(const unsigned int seed) throw();
+	
 	/// @} <!-- end Construction and destruction ---------------- -->
 	
 	
@@ -137,6 +148,44 @@ private:
 	Ran088& operator= (Ran088 const& other);
 };
 
+/** Four interleaved Ran088 generators for filling blocks with random values.
+ 
+ The generators are run in parallel using the SIMD kernels when UGEN_SIMD is defined 
+ (value i of a block comes from generator i % 4). The output is the same for any 
+ instruction set, and for any sequence of block sizes which are multiples of four, so 
+ renders using the same seeds are reproducible. 
+ @see Ran088, SIMD::ran088 */
+class Ran088Block
+{
+public:
+	enum { NumGenerators = 4 };
+	
+	/** Seed the generators, a seed of zero uses Ran088::getInstanceSeed(). */
+	Ran088Block(const unsigned int seed = 0) throw();
+	
+	void setSeed(unsigned int seed) throw();
+	
+	/** Random 32-bit values. */
+	void next(unsigned int* outputValues, const int numValues) throw();
+	
+	/** Floats from 0.0 to 0.999... */
+	void nextFloat(float* outputSamples, const int numSamples) throw();
+	
+	/** Floats from -1.0 to +0.999... */
+	void nextBiFloat(float* outputSamples, const int numSamples) throw();
+	
+	/** Floats from -0.125 to +0.124999... */
+	void nextFloat8(float* outputSamples, const int numSamples) throw();
+	
+	/** A single float from -1.0 to +0.999... (this advances all the generators). */
+	float nextBiFloat() throw();
+	
+private:
+	void nextFloats(const unsigned int exponentBits, const float offset, float* outputSamples, const int numSamples) throw();
+	
+	unsigned int state[NumGenerators * 3];	// s1, s2 then s3 for each generator
+};
+
 inline double rand(double scale) throw()
 {
 	return Ran088::defaultGenerator().nextDouble(scale);
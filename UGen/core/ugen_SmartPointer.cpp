@@ -41,6 +41,7 @@ BEGIN_UGEN_NAMESPACE
 
 #include "ugen_UGen.h"
 #include "ugen_SmartPointer.h"
+#include "ugen_Atomics.h"
 
 #define DEBUG_SmartPointer 0
 
@@ -50,9 +51,13 @@ BEGIN_UGEN_NAMESPACE
 static int allocationCount = 0;
 #endif
 
+bool SmartPointer::atomicRefCounts = false;
+
 SmartPointer::SmartPointer() throw()
 :	refCount(1),
-	active(true)
+	active(true),
+	atomicRefCount(false),
+	nextToDelete(0)
 {		
 #if DEBUG_SmartPointer	
 	printf("+++++++, %p, %d\n", this, ++allocationCount);
@@ -87,22 +92,40 @@ SmartPointer::~SmartPointer()
 //#else
 void SmartPointer::incrementRefCount()  throw()
 {	
-	if(active) ++refCount; 
+	if(active) 
+	{
+		if(atomicRefCounts || atomicRefCount)
+			Atomics::increment(reinterpret_cast<volatile int&> (refCount));
+		else
+			++refCount; 
+	}
+}
+
+int SmartPointer::decrementCount() throw()
+{
+	if(atomicRefCounts || atomicRefCount)
+		return Atomics::decrement(reinterpret_cast<volatile int&> (refCount));
+	else
+		return --refCount;
 }
 
 void SmartPointer::decrementRefCount()  throw()
 { 
 	if(active)
 	{
-		--refCount; 
-		if(refCount == 0) 
+		if(decrementCount() == 0) 
 		{
 			active = false;
-			UGen::getDeleter()->deleteInternal(this);
+			deleteUnreferenced();
 		}
 	}
 }
 
+void SmartPointer::deleteUnreferenced() throw()
+{
+	UGen::getDeleter()->deleteInternal(this);
+}
+
 void SmartPointer::setRefCout(const int newCount) throw()
 {
 	if(!active)
@@ -59,17 +59,44 @@ public:
 	
 	int getRefCount() const throw()	{ return refCount; }
 	
+	/** Use atomic operations for all reference counts.
+	 This is needed if UGen objects sharing the same UGenInternal objects are copied or 
+	 destroyed on different threads at the same time (e.g., when rendering with the 
+	 ParallelRenderer). It should be set before any such graph is built. */
+	static void setAtomicRefCounts(const bool shouldBeAtomic) throw()	{ atomicRefCounts = shouldBeAtomic;	}
+	static bool getAtomicRefCounts() throw()							{ return atomicRefCounts;			}
+	
 	/// @} <!-- end Miscellaneous -->
 	
 	friend class NullUGenInternal;
+	friend class DeferredDeleter;
 	
 protected:
+	/** Decrement the reference count (atomically if needed) and return the new count. */
+	int decrementCount() throw();
+	
+	/** Always use atomic operations for this object's reference count.
+	 For objects which are routinely shared between threads whatever the global setting 
+	 (e.g., Buffer data which is loaded on one thread and played on another). 
+	 This should only be called from the constructor. */
+	void makeRefCountAtomic() throw()	{ atomicRefCount = true; }
+	
+	/** Delete this object now that the last reference has gone.
+	 The default passes it to the current Deleter (see UGen::setDeleter()). Subclasses can 
+	 override this to have the object deleted elsewhere (e.g., TelemetrySender UGenInternals 
+	 are deleted on the TelemetryService thread). */
+	virtual void deleteUnreferenced() throw();
+	
 	int refCount;
 	bool active : 1;
+	bool atomicRefCount : 1;
 	
 private:
 	void setRefCout(const int newCount) throw(); 
 	
+	static bool atomicRefCounts;
+	SmartPointer* volatile nextToDelete;	// used by the DeferredDeleter queue
+	
 	SmartPointer (const SmartPointer&);
     const SmartPointer& operator= (const SmartPointer&);
 };
@@ -194,6 +194,17 @@ END_UGEN_NAMESPACE
 	#include <iostream>
 #endif
 
+#if defined (LINUX) || defined (__linux__)
+	// some UGen++ headers include these inside the ugen namespace, 
+	// glibc/libstdc++ need to see them at global scope first
+	#include <math.h>
+	#include <stdlib.h>
+	#include <string.h>
+	#include <stdio.h>
+	#include <pthread.h>
+	#include <unistd.h>
+#endif
+
 #if (defined (_WIN32) || defined (_WIN64))
 	#define snprintf _snprintf
 	#pragma warning(disable : 4244) // loss of precision
@@ -201,6 +212,7 @@ END_UGEN_NAMESPACE
 	#pragma warning(disable : 4355) // use of 'this' in base member init
 	#pragma warning(disable : 4127) // conditional expression is constant - dumb MSVC wouldn't let me replace these with compile time ones!
 	#pragma warning(disable : 4800) // bool int nonsense
+	#include <intrin.h> // for the Interlocked functions used by Atomics
 #endif
 
 #ifdef UGEN_IPHONE
@@ -252,6 +264,11 @@ END_UGEN_NAMESPACE
 #include <Accelerate/Accelerate.h>
 #endif
 
+// portable SIMD (SSE/AVX/NEON) is for other platforms, the platform specific versions take priority
+#if defined(UGEN_SIMD) && (defined(UGEN_VDSP) || defined(UGEN_VFP) || defined(UGEN_NEON))
+	#undef UGEN_SIMD
+#endif
+
 #define UGEN_MAJOR_VERSION      0
 #define UGEN_MINOR_VERSION      1
 #define UGEN_BUILDNUMBER        7
@@ -350,9 +367,11 @@ inline int quantiseDown(const int a, const int q)
 	#define numElementsInArray(a)   ((int) (sizeof (a) / sizeof ((a)[0])))
 #endif
 
+#ifndef BYTE_ORDER
 #define LITTLE_ENDIAN 1234
 #define BIG_ENDIAN 4321
 #define BYTE_ORDER LITTLE_ENDIAN
+#endif
 // may need to add Big Endian support
 
 // define ALIGN to do nothing if it's not defined...
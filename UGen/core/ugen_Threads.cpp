@@ -0,0 +1,269 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#include "../core/ugen_StandardHeader.h"
+
+// the platform headers must be outside the UGen namespace
+#if defined (_WIN32) || defined (_WIN64)
+	#ifndef NOMINMAX
+		#define NOMINMAX 1
+	#endif
+	#include <windows.h>
+	#define UGEN_THREADS_WIN32 1
+#else
+	#include <pthread.h>
+	#include <sched.h>
+	#include <unistd.h>
+	#if defined(__APPLE__)
+		#include <dispatch/dispatch.h>
+		#include <mach/mach_time.h>
+	#else
+		#include <semaphore.h>
+		#include <errno.h>
+		#include <time.h>
+	#endif
+#endif
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_Threads.h"
+#include "ugen_Atomics.h"
+
+//=============================== Semaphore ====================================
+
+Semaphore::Semaphore(const int initialCount) throw()
+:	handle(0)
+{
+#if defined(UGEN_THREADS_WIN32)
+	handle = CreateSemaphore(0, initialCount, 0x7fffffff, 0);
+#elif defined(__APPLE__)
+	handle = dispatch_semaphore_create(initialCount);
+#else
+	sem_t* sem = new sem_t;
+	sem_init(sem, 0, initialCount);
+	handle = sem;
+#endif
+}
+
+Semaphore::~Semaphore()
+{
+#if defined(UGEN_THREADS_WIN32)
+	CloseHandle((HANDLE)handle);
+#elif defined(__APPLE__)
+	dispatch_release((dispatch_semaphore_t)handle);
+#else
+	sem_t* sem = (sem_t*)handle;
+	sem_destroy(sem);
+	delete sem;
+#endif
+}
+
+void Semaphore::signal() throw()
+{
+#if defined(UGEN_THREADS_WIN32)
+	ReleaseSemaphore((HANDLE)handle, 1, 0);
+#elif defined(__APPLE__)
+	dispatch_semaphore_signal((dispatch_semaphore_t)handle);
+#else
+	sem_post((sem_t*)handle);
+#endif
+}
+
+void Semaphore::wait() throw()
+{
+#if defined(UGEN_THREADS_WIN32)
+	WaitForSingleObject((HANDLE)handle, INFINITE);
+#elif defined(__APPLE__)
+	dispatch_semaphore_wait((dispatch_semaphore_t)handle, DISPATCH_TIME_FOREVER);
+#else
+	while(sem_wait((sem_t*)handle) != 0 && errno == EINTR) { }
+#endif
+}
+
+//=============================== UGenThread ===================================
+
+#if defined(UGEN_THREADS_WIN32)
+static DWORD WINAPI ugenThreadEntryPoint(LPVOID userData)
+{
+	static_cast<UGenThread*> (userData)->threadEntryPoint();
+	return 0;
+}
+#else
+static void* ugenThreadEntryPoint(void* userData)
+{
+	static_cast<UGenThread*> (userData)->threadEntryPoint();
+	return 0;
+}
+#endif
+
+UGenThread::UGenThread() throw()
+:	handle(0),
+	shouldExit(0)
+{
+}
+
+UGenThread::~UGenThread()
+{
+	// subclasses should have stopped the thread already
+	ugen_assert(handle == 0);
+	stopThread();
+}
+
+bool UGenThread::startThread() throw()
+{
+	if(handle != 0) return true;
+	
+	shouldExit = 0;
+	Atomics::memoryBarrier();
+	
+#if defined(UGEN_THREADS_WIN32)
+	handle = CreateThread(0, 0, ugenThreadEntryPoint, this, 0, 0);
+#else
+	pthread_t* thread = new pthread_t;
+	
+	if(pthread_create(thread, 0, ugenThreadEntryPoint, this) == 0)
+	{
+		handle = thread;
+	}
+	else
+	{
+		delete thread;
+		handle = 0;
+	}
+#endif
+	
+	return handle != 0;
+}
+
+void UGenThread::signalThreadShouldExit() throw()
+{
+	shouldExit = 1;
+	Atomics::memoryBarrier();
+}
+
+void UGenThread::stopThread() throw()
+{
+	if(handle == 0) return;
+	
+	signalThreadShouldExit();
+	
+#if defined(UGEN_THREADS_WIN32)
+	WaitForSingleObject((HANDLE)handle, INFINITE);
+	CloseHandle((HANDLE)handle);
+#else
+	pthread_t* thread = (pthread_t*)handle;
+	pthread_join(*thread, 0);
+	delete thread;
+#endif
+	
+	handle = 0;
+}
+
+bool UGenThread::setRealtimePriority() throw()
+{
+	if(handle == 0) return false;
+	
+#if defined(UGEN_THREADS_WIN32)
+	return SetThreadPriority((HANDLE)handle, THREAD_PRIORITY_TIME_CRITICAL) != 0;
+#else
+	struct sched_param param;
+	param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+	return pthread_setschedparam(*(pthread_t*)handle, SCHED_FIFO, &param) == 0;
+#endif
+}
+
+void UGenThread::threadEntryPoint() throw()
+{
+	run();
+}
+
+void UGenThread::yield() throw()
+{
+#if defined(UGEN_THREADS_WIN32)
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+void UGenThread::sleep(const int milliseconds) throw()
+{
+#if defined(UGEN_THREADS_WIN32)
+	Sleep(milliseconds);
+#else
+	usleep(milliseconds * 1000);
+#endif
+}
+
+int UGenThread::getNumCPUs() throw()
+{
+#if defined(UGEN_THREADS_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#else
+	const long numCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+	return numCPUs > 0 ? (int)numCPUs : 1;
+#endif
+}
+
+double UGenThread::getMillisecondCounterHiRes() throw()
+{
+#if defined(UGEN_THREADS_WIN32)
+	LARGE_INTEGER ticks, frequency;
+	QueryPerformanceCounter(&ticks);
+	QueryPerformanceFrequency(&frequency);
+	return (double)ticks.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#elif defined(__APPLE__)
+	static double millisecondsPerTick = 0.0;
+	
+	if(millisecondsPerTick == 0.0)
+	{
+		mach_timebase_info_data_t timebase;
+		mach_timebase_info(&timebase);
+		millisecondsPerTick = (double)timebase.numer / (double)timebase.denom * 1.0e-6;
+	}
+	
+	return (double)mach_absolute_time() * millisecondsPerTick;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec * 1.0e-6;
+#endif
+}
+
+END_UGEN_NAMESPACE
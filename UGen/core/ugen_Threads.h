@@ -0,0 +1,116 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#ifndef UGEN_THREADS_H
+#define UGEN_THREADS_H
+
+/** A counting semaphore.
+ 
+ signal() never blocks so it is safe to call from an audio callback, wait() blocks
+ until the count is above zero. */
+class Semaphore
+{
+public:
+	Semaphore(const int initialCount = 0) throw();
+	~Semaphore();
+	
+	/** Increment the count, waking a waiting thread if there is one. */
+	void signal() throw();
+	
+	/** Wait for the count to be above zero then decrement it. */
+	void wait() throw();
+	
+private:
+	void* handle;
+	
+	Semaphore (const Semaphore&);
+    const Semaphore& operator= (const Semaphore&);
+};
+
+/** A minimal platform independent thread.
+ 
+ Subclasses implement run() which should check threadShouldExit() regularly. 
+ Subclasses should call stopThread() in their destructors since run() must not be
+ called on a partially destroyed object. 
+ 
+ This uses pthreads on Mac, iOS, Linux and Android and the Win32 API on Windows. */
+class UGenThread
+{
+public:
+	UGenThread() throw();
+	virtual ~UGenThread();
+	
+	/** Start the thread, returns false if the thread could not be created. */
+	bool startThread() throw();
+	
+	/** Ask the thread to exit and wait for it to do so. 
+	 If the thread might be waiting for something (e.g., a Semaphore) override 
+	 signalThreadShouldExit() to wake it. */
+	void stopThread() throw();
+	
+	/** Sets the flag returned by threadShouldExit(). */
+	virtual void signalThreadShouldExit() throw();
+	
+	inline bool threadShouldExit() const throw()	{ return shouldExit != 0;	}
+	inline bool isThreadRunning() const throw()		{ return handle != 0;		}
+	
+	/** Attempt to give this thread real-time (or at least the highest available) priority.
+	 This may fail if the process doesn't have permission. */
+	bool setRealtimePriority() throw();
+	
+	/** The thread function. */
+	virtual void run() = 0;
+	
+	static void yield() throw();
+	static void sleep(const int milliseconds) throw();
+	static int getNumCPUs() throw();
+	
+	/** A high resolution monotonic time in milliseconds (with an arbitrary start time). */
+	static double getMillisecondCounterHiRes() throw();
+	
+	/** @internal */
+	void threadEntryPoint() throw();
+	
+private:
+	void* handle;
+	volatile int shouldExit;
+	
+	UGenThread (const UGenThread&);
+    const UGenThread& operator= (const UGenThread&);
+};
+
+#endif // UGEN_THREADS_H
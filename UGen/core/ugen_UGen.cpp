@@ -991,7 +991,8 @@ void UGen::prepareForBlock(const int actualBlockSize, const unsigned int blockID
 			
 			numInternalUGens = 1;
 			internalUGens[0] = getNullInternal();
-			internalUGens[0]->prepareForBlockInternal(actualBlockSize, blockID, 0);		
+			internalUGens[0]->prepareForBlockInternal(actualBlockSize, blockID, 0);
+			UGenInternal::graphChanged();
 		} 
 		else 
 		{
@@ -1002,9 +1003,11 @@ void UGen::prepareForBlock(const int actualBlockSize, const unsigned int blockID
 			}
 		}
 	}
-	else if((unsigned int)channel < numInternalUGens)
+	else
 	{
-		bool shouldDelete = internalUGens[channel]->shouldBeDeletedNow(blockID);
+		// wrap the channel as processBlock() does, otherwise a wrapped input isn't prepared
+		const unsigned int internalChannel = (unsigned int)channel % numInternalUGens;
+		bool shouldDelete = internalUGens[internalChannel]->shouldBeDeletedNow(blockID);
 		
 		if(shouldDelete) 
 		{
@@ -1016,12 +1019,13 @@ void UGen::prepareForBlock(const int actualBlockSize, const unsigned int blockID
 			
 			numInternalUGens = 1;
 			internalUGens[0] = getNullInternal();
-			internalUGens[0]->prepareForBlockInternal(actualBlockSize, blockID, 0);		
+			internalUGens[0]->prepareForBlockInternal(actualBlockSize, blockID, 0);
+			UGenInternal::graphChanged();
 		} 
 		else 
 		{
-			internalUGens[channel]->userData = userData;
-			internalUGens[channel]->prepareForBlockInternal(actualBlockSize, blockID, channel);
+			internalUGens[internalChannel]->userData = userData;
+			internalUGens[internalChannel]->prepareForBlockInternal(actualBlockSize, blockID, channel);
 		}		
 	}
 }
@@ -1251,6 +1255,30 @@ bool UGen::stopAllEvents() throw()
 	return result;
 }
 
+bool UGen::setVoicePoolSize(const int size) throw()
+{
+	bool result = false;
+	
+	for(unsigned int i = 0; i < numInternalUGens; i++)
+	{
+		result = internalUGens[i]->setVoicePoolSize(size) || result;
+	}
+	
+	return result;
+}
+
+VoicePool* UGen::getVoicePool() throw()
+{
+	for(unsigned int i = 0; i < numInternalUGens; i++)
+	{
+		VoicePool* pool = internalUGens[i]->getVoicePool();
+		
+		if(pool != 0) return pool;
+	}
+	
+	return 0;
+}
+
 UGen& UGen::addBufferReceiver(BufferReceiver* const receiver) throw()
 {
 #if !defined(UGEN_ANDROID) || defined(UGEN_JUCE)
@@ -1318,6 +1346,36 @@ void UGen::removeBufferReceiver(UGen const& receiverUGen) throw()
 #endif
 }
 
+UGen& UGen::addBufferSender(BufferSender* const sender) throw()
+{
+#if !defined(UGEN_ANDROID) || defined(UGEN_JUCE)
+	if(sender == 0) { ugen_assertfalse; return *this; }
+	
+	for(unsigned int i = 0; i < numInternalUGens; i++)
+	{
+		BufferReceiver* receiver = dynamic_cast<BufferReceiver*> (internalUGens[i]);
+		
+		if(receiver != 0) sender->addBufferReceiver(receiver);
+	}
+#endif
+	
+	return *this;
+}
+
+void UGen::removeBufferSender(BufferSender* const sender) throw()
+{
+#if !defined(UGEN_ANDROID) || defined(UGEN_JUCE)
+	if(sender == 0) { ugen_assertfalse; return; }
+	
+	for(unsigned int i = 0; i < numInternalUGens; i++)
+	{
+		BufferReceiver* receiver = dynamic_cast<BufferReceiver*> (internalUGens[i]);
+		
+		if(receiver != 0) sender->removeBufferReceiver(receiver);
+	}
+#endif
+}
+
 UGen& UGen::addDoneActionReceiver(DoneActionReceiver* const receiver) throw()
 {
 #if !defined(UGEN_ANDROID) || defined(UGEN_JUCE)
@@ -212,6 +212,7 @@ class MultiSlider;
 class Env;
 class RawInputUGenInternal;
 class MetaDataReceiver;
+class VoicePool;
 
 /**	The UGen class!
 
@@ -885,11 +886,32 @@ public:
 	 Useful for a panic e.g., "all notes off" type command. */
 	bool stopAllEvents() throw();
 	
+	/** Attempts to build the voices of a Spawn-type UGen on a background thread.
+	 
+	 This will only have an affect if the UGen contains a SpawnBaseUGenInternal. Voices are
+	 built ahead of time and kept in a VoicePool so the audio thread doesn't need to
+	 construct them. This should be called before the UGen is used on the audio thread.
+	 
+	 @param size	The number of voices to keep ready, 0 disables the pool.
+	 @see VoicePool, getVoicePool() */
+	bool setVoicePoolSize(const int size) throw();
+	
+	/** Get the VoicePool of a Spawn-type UGen (e.g., to query its statistics).
+	 @return The pool or 0 if this doesn't contain a SpawnBaseUGenInternal with a pool.
+	 @see setVoicePoolSize() */
+	VoicePool* getVoicePool() throw();
+	
 	UGen& addBufferReceiver(BufferReceiver* const receiver) throw();
 	void removeBufferReceiver(BufferReceiver* const receiver) throw();
 	UGen& addBufferReceiver(UGen const& receiver) throw();
 	void removeBufferReceiver(UGen const& receiver) throw();
 	
+	/** Connect a BufferSender to the internals of this UGen which receive Buffers.
+	 E.g., so a loader thread can send new Buffers to a PlayBuf or TableOsc which is playing.
+	 @see AtomicBufferReceiver */
+	UGen& addBufferSender(BufferSender* const sender) throw();
+	void removeBufferSender(BufferSender* const sender) throw();
+	
 	//#if defined(UGEN_IPHONE) || defined(DOXYGEN)
 	//	void addBufferReceiver(UIScopeView* receiver) throw();
 	//	void removeBufferReceiver(UIScopeView* receiver) throw();
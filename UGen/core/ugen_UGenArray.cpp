@@ -217,6 +217,23 @@ void UGenArray::Internal::reallocate() throw()
 	}
 }
 
+void UGenArray::Internal::reserve(const int numItems) throw()
+{
+	if(numItems > allocatedSize)
+	{
+		UGen *newArray = new UGen[numItems];
+		
+		for(int i = 0; i < size_; i++)
+		{
+			newArray[i] = array[i];
+		}
+		
+		delete [] array;
+		array = newArray;
+		allocatedSize = numItems;
+	}
+}
+
 void UGenArray::Internal::clear() throw()
 {
 	delete [] array;
@@ -438,6 +455,11 @@ void UGenArray::add(UGen const& other) throw()
 	internal->add(other);
 }
 
+void UGenArray::reserve(const int numItems) throw()
+{
+	internal->reserve(numItems);
+}
+
 void UGenArray::add(UGenArray const& other) throw()
 {
 	internal->add(other.size(), other.getArray());
@@ -102,6 +102,7 @@ public:
 		~Internal() throw();
 		
 		inline const int& size() const throw() { return size_; }
+		inline const int& getAllocatedSize() const throw() { return allocatedSize; }
 		inline const UGen* getArray() const throw() { return array; }
 		inline UGen* getArray() throw() { return array; }
 		
@@ -110,6 +111,7 @@ public:
 		void remove(const int index, const bool reallocate) throw();
 		void removeNulls(const bool reallocate = false) throw();
 		void reallocate() throw();
+		void reserve(const int numItems) throw();
 		void clear() throw();
 		void clearQuick() throw();
 				
@@ -157,6 +159,13 @@ public:
 	 @return The maximum number of channels. */
 	int findMaxNumChannels() const throw();
 	
+	/** The number of items the array can hold before add() needs to allocate more memory. */
+	inline int getAllocatedSize() const throw()		{ return internal->getAllocatedSize(); }
+	
+	/** Allocate space for at least this many items so that add() doesn't need to - in-place.
+	 This doesn't change the size of the array. */
+	void reserve(const int numItems) throw();
+	
 	/** Adds an item in-place. */
 	void add(UGen const& other) throw();
 	
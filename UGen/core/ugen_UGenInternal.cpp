@@ -43,6 +43,7 @@ BEGIN_UGEN_NAMESPACE
 #include "ugen_UGen.h"
 #include "ugen_UGenArray.h"
 #include "../basics/ugen_ScalarUGens.h"
+#include "ugen_Atomics.h"
 
 
 //=========================== UGenOutput ==================================
@@ -52,7 +53,13 @@ UGenOutput::UGenOutput() throw()
 	allocatedBlockSize(blockSize),
 	block(blockSize <= 0 ? 0 : new float[blockSize]),
 	usingExternalOutput(false),
-	externalOutput(0)
+	usingArenaBlock(false),
+	externalOutput(0),
+	privateBlock(0),
+	privateBlockSize(0),
+	currentArenaBlock(0),
+	inPlaceOutput(0),
+	arenaValue(0.f)
 {
 	ugen_assert(blockSize > 0);
 	initValue(0.f);
@@ -60,7 +67,9 @@ UGenOutput::UGenOutput() throw()
 
 UGenOutput::~UGenOutput()
 {
-	if(usingExternalOutput == false)
+	if(usingArenaBlock)
+		delete [] privateBlock;
+	else if(usingExternalOutput == false)
 		delete [] block;
 	
 	block = 0;
@@ -71,12 +80,17 @@ UGenOutput::~UGenOutput()
 
 void UGenOutput::initValue(const float value) throw()
 {
+	arenaValue = value;
+	
 	if(block)
 		block[blockSize-1] = value;
 }
 
 void UGenOutput::useExternalOutput(UGenOutput* externalOutputToUse)
 {
+	if(usingArenaBlock)
+		useArenaBlock(0, 0);
+	
 	if(externalOutputToUse == 0)
 	{
 		float value = 0.f;
@@ -116,6 +130,9 @@ void UGenOutput::useExternalOutput(float* externalOutputToUse, const int externa
 {
 	ugen_assert(externalBlockSize > 0);
 	
+	if(usingArenaBlock)
+		useArenaBlock(0, 0);
+	
 	if(externalOutputToUse == 0)
 	{
 		float value = 0.f;
@@ -154,6 +171,69 @@ void UGenOutput::useExternalOutput(float* externalOutputToUse, const int externa
 
 
 
+void UGenOutput::useArenaBlock(float* arenaBlock, const int arenaBlockSize) throw()
+{
+	ugen_assert(usingExternalOutput == false);
+	
+	inPlaceOutput = 0;
+	
+	if(arenaBlock != 0)
+	{
+		ugen_assert(arenaBlockSize >= blockSize);
+		
+		currentArenaBlock = arenaBlock;
+		
+		if(usingArenaBlock == false)
+		{
+			const float value = block ? block[blockSize-1] : 0.f;
+			
+			privateBlock = block;
+			privateBlockSize = allocatedBlockSize;
+			usingArenaBlock = true;
+			block = arenaBlock;
+			allocatedBlockSize = arenaBlockSize;
+			
+			initValue(value);
+		}
+		else
+		{
+			// moving between arena blocks, the contents will be replaced by the next processBlock()
+			block = arenaBlock;
+			allocatedBlockSize = arenaBlockSize;
+		}
+	}
+	else if(usingArenaBlock)
+	{
+		const float value = arenaValue; // the arena block may hold another UGenInternal's output now
+		
+		block = privateBlock;
+		allocatedBlockSize = privateBlockSize;
+		privateBlock = 0;
+		privateBlockSize = 0;
+		currentArenaBlock = 0;
+		usingArenaBlock = false;
+		
+		if(blockSize > allocatedBlockSize)
+		{
+			delete [] block;
+			allocatedBlockSize = blockSize;
+			block = new float[allocatedBlockSize];
+		}
+		
+		initValue(value);
+	}
+}
+
+void UGenOutput::useInPlaceOutput(UGenOutput* consumerOutput) throw()
+{
+	ugen_assert(usingArenaBlock || consumerOutput == 0);
+	
+	if(usingArenaBlock)
+		inPlaceOutput = consumerOutput;
+}
+
+
+
 //=========================== UGenInternal ==================================
 
 UGenInternal::UGenInternal(const int numInputs) throw()
@@ -164,7 +244,10 @@ UGenInternal::UGenInternal(const int numInputs) throw()
 	isScheduledForDeletion(false),
 	inputs(numInputs_ > 0 ? new UGen[numInputs_] : 0),
 	lastBlockID((unsigned int)-1), //FIXME
-	blockIDtoBeDeletedAfter(0xFFFFFFFF)
+	blockIDtoBeDeletedAfter(0xFFFFFFFF),
+	claimedBlockID((unsigned int)-1),
+	schedulePass(0),
+	scheduleIndex(-1)
 {
 	ugen_assert(numInputs >= 0);
 }
@@ -177,7 +260,10 @@ UGenInternal::UGenInternal(UGen *mixInputToUse) throw()
 	isScheduledForDeletion(false),
 	inputs(mixInputToUse),
 	lastBlockID((unsigned int)-1),
-	blockIDtoBeDeletedAfter(0xFFFFFFFF)
+	blockIDtoBeDeletedAfter(0xFFFFFFFF),
+	claimedBlockID((unsigned int)-1),
+	schedulePass(0),
+	scheduleIndex(-1)
 {
 }
 
@@ -185,6 +271,10 @@ UGenInternal::~UGenInternal() //throw()
 {
 	if(ownsInputsPointer) 
 		delete [] inputs;
+	
+	// only a UGenInternal which has been walked can be in a schedule or plan
+	if(schedulePass != 0)
+		Atomics::increment(graphGeneration);
 }
 
 UGenInternal* UGenInternal::getChannelInternal(const int channel) throw()
@@ -234,11 +324,39 @@ UGenInternal* UGenInternal::getKr() throw()
 }
 
 
+volatile int UGenInternal::numParallelRenderers = 0;
+volatile int UGenInternal::nextSchedulePass = 0;
+volatile int UGenInternal::graphGeneration = 0;
+
+void UGenInternal::graphChanged() throw()
+{
+	Atomics::increment(graphGeneration);
+}
+
 float* UGenInternal::processBlockInternal(bool& shouldDelete, const unsigned int blockID, const int channel) throw()
 {
 	if(blockID != lastBlockID)
 	{
+		const bool isParallel = numParallelRenderers > 0;
+		
+		if(isParallel)
+		{
+			// another thread may be processing this block already, if so wait for its result
+			const unsigned int previousClaimedBlockID = claimedBlockID;
+			
+			if((previousClaimedBlockID == blockID) || 
+			   (Atomics::compareAndSwap(claimedBlockID, previousClaimedBlockID, blockID) == false))
+			{
+				while(*(volatile unsigned int*)&lastBlockID != blockID)
+					Atomics::pause();
+				
+				Atomics::memoryBarrier();
+				return uGenOutput.getSampleData();
+			}
+		}
+		
 		processBlock(shouldDelete, blockID, channel);
+		uGenOutput.keepArenaValue();
 		
 		if(isScheduledForDeletion == false && shouldDelete == true)
 		{
@@ -246,12 +364,34 @@ float* UGenInternal::processBlockInternal(bool& shouldDelete, const unsigned int
 			blockIDtoBeDeletedAfter = blockID;
 		}
 		
+		if(isParallel) Atomics::memoryBarrier();
+		
 		lastBlockID = blockID;
 	}
 	
 	return uGenOutput.getSampleData();
 }
 
+void UGenInternal::addDependencies(UGenDependencies& dependencies, const int channel) throw()
+{
+	for(unsigned int i = 0; i < numInputs_; i++)
+	{
+		dependencies.add(inputs[i], channel);
+	}
+}
+
+void UGenDependencies::add(UGen const& input, const int channel, const bool passesDeletion) throw()
+{
+	const int numChannels = input.getNumChannels();
+	
+	if(numChannels > 0)
+	{
+		UGenInternal* internal = input.getInternalUGen(channel % numChannels);
+		add(internal, channel, passesDeletion);
+		internal->decrementRefCount();
+	}
+}
+
 const UGen& UGenInternal::getInput(const int index) throw()
 {
 	if(index < 0 || (unsigned int)index >= numInputs_) 
@@ -333,6 +473,9 @@ void UGenInternal::initValue(const float value) throw()
 
 float UGenInternal::getValue(const int /*channel*/) const throw()			
 { 
+	if(uGenOutput.isUsingArenaBlock())
+		return uGenOutput.getArenaValue();
+	
 	const int blockSize = uGenOutput.getBlockSize();
 	
 	if(blockSize > 0)
@@ -395,7 +538,7 @@ ProxyOwnerUGenInternal::~ProxyOwnerUGenInternal()// throw()
 //#else
 void ProxyOwnerUGenInternal::decrementRefCount()  throw()
 {
-	refCount--;
+	decrementCount();
 	deleteIfOnlyMutualReferencesRemain();
 }
 //#endif
@@ -415,7 +558,7 @@ void ProxyOwnerUGenInternal::deleteIfOnlyMutualReferencesRemain() throw()
 	}
 	
 	active = false;
-	UGen::getDeleter()->deleteInternal(this);
+	deleteUnreferenced();
 }
 
 UGenInternal* ProxyOwnerUGenInternal::getProxy(const int index) throw()
@@ -495,7 +638,7 @@ void ProxyUGenInternal::decrementRefCount() throw()
 {
 	ugen_assert(refCount > 0);
 	
-	refCount--;
+	decrementCount();
 	owner_->deleteIfOnlyMutualReferencesRemain();
 }
 //#endif
@@ -536,6 +679,11 @@ void ProxyUGenInternal::processBlock(bool& shouldDelete, const unsigned int bloc
 	}
 }
 
+void ProxyUGenInternal::addDependencies(UGenDependencies& dependencies, const int channel) throw()
+{
+	dependencies.add(owner_, channel);
+}
+
 bool ProxyUGenInternal::setInput(const float* block, const int channel) throw()
 {
 	return owner_->setInput(block, channel);
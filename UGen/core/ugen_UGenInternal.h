@@ -47,6 +47,7 @@
 
 class Value;
 class UGen;
+class VoicePool;
 
 /** @internal */
 class UGenOutput
@@ -69,11 +70,22 @@ public:
 		{
 			blockSize = actualBlockSize;
 			
-			if(actualBlockSize > allocatedBlockSize)
+			if(inPlaceOutput != 0)
+			{
+				// render directly into the consumer's block (which has been prepared already)
+				block = (inPlaceOutput->blockSize == actualBlockSize) ? inPlaceOutput->block : currentArenaBlock;
+			}
+			else if(actualBlockSize > allocatedBlockSize)
 			{		
-				delete [] block;
-				allocatedBlockSize = blockSize;
-				block = new float[allocatedBlockSize];
+				if(usingArenaBlock) 
+					useArenaBlock(0, 0);
+				
+				if(blockSize > allocatedBlockSize)
+				{
+					delete [] block;
+					allocatedBlockSize = blockSize;
+					block = new float[allocatedBlockSize];
+				}
 			}
 		}
 	}
@@ -86,16 +98,60 @@ public:
 	
 	void useExternalOutput(UGenOutput* externalOutputToUse);
 	void useExternalOutput(float* externalOutputToUse, const int externalBlockSize);
+	inline bool isUsingExternalOutput() const			{ return usingExternalOutput;	}
+	
+	/** Use a block owned by a UGenOutputArena instead of the private block.
+	 The private block is kept so that it can be used again without allocating,
+	 pass 0 to go back to it. */
+	void useArenaBlock(float* arenaBlock, const int arenaBlockSize) throw();
+	inline bool isUsingArenaBlock() const				{ return usingArenaBlock;		}
+	
+	/** While using an arena block keep the last sample of the block just processed, the block
+	 itself is reused by other UGenInternal objects once its consumer has read it. */
+	inline void keepArenaValue()						{ if(usingArenaBlock) arenaValue = block[blockSize-1];	}
+	inline float getArenaValue() const					{ return arenaValue;			}
+	
+	/** While using an arena block, render into the block of another UGenOutput instead.
+	 The other output must be prepared for each block before this one, if its block size 
+	 differs the arena block is used for that block. This is reset by useArenaBlock(). 
+	 @see UGenInternal::acceptsInPlaceInput() */
+	void useInPlaceOutput(UGenOutput* consumerOutput) throw();
+	inline bool isUsingInPlaceOutput() const			{ return inPlaceOutput != 0;	}
 	
 private:
 	int blockSize;
 	int allocatedBlockSize;
 	float *block;
 	bool usingExternalOutput:1;
+	bool usingArenaBlock:1;
 	UGenOutput* externalOutput;
+	float *privateBlock;			// while using an arena block
+	int privateBlockSize;
+	float *currentArenaBlock;		// while using an arena block
+	UGenOutput* inPlaceOutput;		// ...and rendering into a consumer's block
+	float arenaValue;				// ...the last sample processed (see keepArenaValue())
 };
 
 
+class UGenInternal;
+
+/** Collects the UGenInternal objects another UGenInternal will pull from in its processBlock().
+ This is used by the ParallelRenderer to build its schedule.
+ @see UGenInternal::addDependencies(), ParallelRenderer */
+class UGenDependencies
+{
+public:
+	virtual ~UGenDependencies() {}
+	
+	/** Add a dependency on a UGenInternal which will be processed with the given channel index. 
+	 @param passesDeletion	Whether a DoneAction in the dependency should also schedule
+							this UGenInternal for deletion (this is the normal behaviour). */
+	virtual void add(UGenInternal* internal, const int channel, const bool passesDeletion = true) throw() = 0;
+	
+	/** Add a dependency on the internal a UGen will use when it is processed for this channel. */
+	void add(UGen const& input, const int channel, const bool passesDeletion = true) throw();
+};
+
 /** Subclasses of this do almost all of the processing during audio rendering.
  
  An array of these is held by each UGen to represent its output channels of any processing.
@@ -143,10 +199,17 @@ public:
 	/// @{
 	
 	virtual inline bool isProxy() const throw()			{ return false;							}
+	virtual inline bool isProxyOwner() const throw()	{ return false;							}
 	virtual inline bool isScalar() const throw()		{ return false;							}
 	virtual inline bool isConst() const throw()			{ return false;							}
 	virtual inline bool isNull() const throw()			{ return false;							}
 	
+	/** Whether the first dependency added by addDependencies() may render directly into this 
+	 UGenInternal's output block. If this returns true processBlock() must cope with the first 
+	 input returning the output block itself (e.g., a Mix then skips copying it) and must not write 
+	 to its output block before processing that input. This is used by the UGenOutputArena. */
+	virtual inline bool acceptsInPlaceInput() const throw()	{ return false;						}
+	
 	/// @} <!-- end Tests -->
 	
 	/// @name Rate
@@ -256,6 +319,25 @@ public:
 	}
 	virtual bool trigger(void* extraArgs = 0) throw() { (void)extraArgs; return false; }
 	virtual bool stopAllEvents() throw() { return false; }
+	virtual bool setVoicePoolSize(const int size) throw() { (void)size; return false; }
+	virtual VoicePool* getVoicePool() throw() { return 0; }
+	
+	/** Get the number of operands if this is an operator that Fuse can combine with others.
+	 Returns 1 for unary and 2 for binary operators, otherwise 0 (the default). */
+	virtual int getNumFusibleOperands() const throw() { return 0; }
+	
+	/** Add the UGenInternal objects this one pulls from in processBlock() for a particular channel.
+	 The default adds each of the inputs. Subclasses with inputs which aren't in the inputs array
+	 (or which aren't always processed in the current block) should override this. Anything
+	 not added here is still processed safely, but on the same thread as this UGenInternal.
+	 @see ParallelRenderer */
+	virtual void addDependencies(UGenDependencies& dependencies, const int channel) throw();
+	
+	/** Tell the UGenOutputArena and ParallelRenderer that the structure of a graph has changed.
+	 This must be called when the UGenInternal objects added by addDependencies() change after
+	 a UGenInternal has been constructed (e.g., Spawn adding an event or Plug switching sources).
+	 Creating a UGenInternal doesn't change any graph until something connects it like this. */
+	static void graphChanged() throw();
 	
 	/** Get the maximum duration of the seekable.
 	 The units will be dependent on the UGenInternal in question. 
@@ -296,7 +378,28 @@ protected:
 	unsigned int blockIDtoBeDeletedAfter;
 	UGenOutput uGenOutput;
 	
+	friend class ParallelRenderer;
+	friend class UGenOutputArena;
+	friend class OfflineRenderer;
+	
+	/** The number of ParallelRenderer objects currently processing a block, if this is
+	 non-zero processBlockInternal() ensures only one thread processes each block. */
+	static volatile int numParallelRenderers;
+	
+	/** Incremented each time the graph is walked to mark the UGenInternal objects visited. */
+	static volatile int nextSchedulePass;
+	
+	/** Incremented by graphChanged() and when a UGenInternal which has been walked by a 
+	 UGenOutputArena or ParallelRenderer is deleted so they can tell when they need to walk 
+	 the graph again. UGenInternal objects built or deleted away from any rendered graph (e.g., 
+	 by a VoicePool or the DeferredDeleter) leave it unchanged. */
+	static volatile int graphGeneration;
+	
 private:
+	volatile unsigned int claimedBlockID;	// the last block a thread claimed for processing when rendering in parallel
+	unsigned int schedulePass;				// used by ParallelRenderer and UGenOutputArena when walking the graph
+	int scheduleIndex;						// ...
+	
 	UGenInternal (const UGenInternal&);
     const UGenInternal& operator= (const UGenInternal&);
 	
@@ -333,6 +436,7 @@ public:
 	/// @} <!-- end Construction and destruction -->
 	
 	
+	bool isProxyOwner() const throw()		{	return true;			}
 	int getNumProxies() const throw()		{	return numProxies_;		}
 	int getNumChannels() const throw()		{	return numProxies_+1;	}
 	UGenInternal* getProxy(const int index) throw();
@@ -369,6 +473,7 @@ public:
 	void prepareForBlockInternal(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
 	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	void addDependencies(UGenDependencies& dependencies, const int channel) throw();
 	
 	bool setInput(const float* block, const int channel) throw();
 	
@@ -0,0 +1,372 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#include "ugen_StandardHeader.h"
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_UGenOutputArena.h"
+#include "ugen_Atomics.h"
+
+UGenOutputArena::UGenOutputArena() throw()
+:	pass(0),
+	plannedGeneration(0),
+	numPlans(0),
+	hasPlanned(false),
+	nodes(0), numNodes(0), allocatedNodes(0),
+	stack(0), numStacked(0), allocatedStack(0),
+	shared(0), nextShared(0), numShared(0), allocatedShared(0), allocatedNextShared(0),
+	sharedRefCounts(0), allocatedSharedRefCounts(0),
+	memory(0), blocks(0), oldMemory(0), numBlocks(0), allocatedBlocks(0),
+	blockStride(0)
+{
+	reserve(256, UGen::getEstimatedBlockSize());
+}
+
+UGenOutputArena::~UGenOutputArena()
+{
+	clear();
+	
+	delete [] nodes;
+	delete [] stack;
+	delete [] shared;
+	delete [] nextShared;
+	delete [] sharedRefCounts;
+	delete [] memory;
+}
+
+template<class ElementType>
+void UGenOutputArena::ensureSize(ElementType*& array, int& allocatedSize, const int requiredSize) throw()
+{
+	if(requiredSize <= allocatedSize) return;
+	
+	int newSize = allocatedSize > 0 ? allocatedSize : 16;
+	while(newSize < requiredSize) newSize *= 2;
+	
+	ElementType* newArray = new ElementType[newSize];
+	
+	if(array != 0)
+	{
+		memcpy(newArray, array, allocatedSize * sizeof(ElementType));
+		delete [] array;
+	}
+	
+	array = newArray;
+	allocatedSize = newSize;
+}
+
+void UGenOutputArena::reserve(const int numInternals, const int maxBlockSize) throw()
+{
+	clear(); // the blocks may move
+	
+	ensureSize(nodes, allocatedNodes, numInternals);
+	ensureSize(stack, allocatedStack, numInternals * 2);
+	ensureSize(shared, allocatedShared, numInternals);
+	ensureSize(nextShared, allocatedNextShared, numInternals);
+	ensureSize(sharedRefCounts, allocatedSharedRefCounts, numInternals);
+	allocate(numInternals / 2, maxBlockSize);
+	
+	delete [] oldMemory;
+	oldMemory = 0;
+}
+
+void UGenOutputArena::clear() throw()
+{
+	for(int i = 0; i < numShared; i++)
+		release(shared[i]);
+	
+	numShared = 0;
+	numBlocks = 0;
+	hasPlanned = false;
+}
+
+void UGenOutputArena::release(UGenInternal* internal) throw()
+{
+	UGenOutput& output = internal->getOutputRef();
+	
+	if(output.isUsingArenaBlock())
+		output.useArenaBlock(0, 0);
+	
+	internal->decrementRefCount();
+}
+
+void UGenOutputArena::allocate(const int requiredBlocks, const int requiredBlockSize) throw()
+{
+	if((requiredBlocks <= allocatedBlocks) && (requiredBlockSize <= blockStride)) 
+		return;
+	
+	// blocks are a multiple of 64 bytes so each one is aligned for SIMD
+	const int newStride = quantiseUp(requiredBlockSize > blockStride ? requiredBlockSize : blockStride, 16);
+	int newBlocks = allocatedBlocks > 0 ? allocatedBlocks : 16;
+	while(newBlocks < requiredBlocks) newBlocks *= 2;
+	
+	// the old blocks are kept until the UGenInternal objects using them have moved
+	delete [] oldMemory;
+	oldMemory = memory;
+	
+	memory = new float[newBlocks * newStride + 16];
+	blocks = (float*)(((size_t)memory + 63) & ~(size_t)63);
+	allocatedBlocks = newBlocks;
+	blockStride = newStride;
+}
+
+int UGenOutputArena::visit(UGenInternal* internal, const int channel) throw()
+{
+	if(internal->schedulePass == pass) 
+		return internal->scheduleIndex; // -1 if we're still visiting it i.e., a feedback loop
+	
+	internal->schedulePass = pass;
+	internal->scheduleIndex = -1;
+	
+	// dependencies are collected on the stack by add()
+	const int stackStart = numStacked;
+	internal->addDependencies(*this, channel);
+	
+	const int index = numNodes++;
+	ensureSize(nodes, allocatedNodes, numNodes);
+	
+	Node& node = nodes[index];
+	node.internal = internal;
+	node.numReferences = 0;
+	node.numConsumers = 0;
+	node.consumer = -1;
+	node.numChildren = 0;
+	node.inPlaceInput = -1;
+	node.isRoot = false;
+	
+	if((numStacked > stackStart) && internal->acceptsInPlaceInput())
+		node.inPlaceInput = stack[stackStart];
+	
+	for(int i = stackStart; i < numStacked; i++)
+	{
+		Node& dependency = nodes[stack[i]];
+		dependency.numReferences++;
+		
+		if(dependency.consumer == index) 
+			continue; // already added e.g., x * x
+		
+		dependency.numConsumers++;
+		dependency.consumer = index;
+	}
+	
+	numStacked = stackStart;
+	internal->scheduleIndex = index;
+	
+	return index;
+}
+
+void UGenOutputArena::add(UGenInternal* internal, const int channel, const bool /*passesDeletion*/) throw()
+{
+	const int index = visit(internal, channel);
+	
+	if(index >= 0)
+	{
+		ensureSize(stack, allocatedStack, numStacked + 1);
+		stack[numStacked++] = index;
+	}
+}
+
+void UGenOutputArena::plan(UGen& graph, const int actualBlockSize) throw()
+{
+	int i;
+	
+	// read first so anything created or deleted while we walk the graph causes another plan
+	plannedGeneration = UGenInternal::graphGeneration;
+	Atomics::memoryBarrier();
+	
+	pass = (unsigned int)Atomics::increment(UGenInternal::nextSchedulePass);
+	numPlans++;
+	numNodes = 0;
+	numStacked = 0;
+	
+	// all channels are planned so the graph may also be rendered one channel at a time
+	const int numChannels = graph.getNumChannels();
+	
+	for(i = 0; i < numChannels; i++)
+	{
+		UGenInternal* internal = graph.getInternalUGen(i);
+		const int index = visit(internal, i);
+		internal->decrementRefCount();
+		
+		if(index >= 0) 
+			nodes[index].isRoot = true;
+	}
+	
+	// a UGenInternal can share if it is only read by its consumer, any other reference
+	// (e.g., a UGen held by the user or a BlockDelay) means its block must be kept. 
+	// Proxy owners and proxies are left alone as the owner writes to its proxies' blocks.
+	for(i = 0; i < numNodes; i++)
+	{
+		Node& node = nodes[i];
+		UGenOutput& output = node.internal->getOutputRef();
+		
+		node.wasShared = output.isUsingArenaBlock();
+		const int numHeld = node.internal->getRefCount() - (node.wasShared ? 1 : 0);
+		
+		node.isShared = (node.isRoot == false) && 
+						(node.internal->isProxyOwner() == false) &&
+						(node.internal->isProxy() == false) &&
+						(node.numConsumers == 1) && 
+						(numHeld == node.numReferences) &&
+						(output.isUsingExternalOutput() == false);
+		
+		if(node.isShared)
+			node.index = nodes[node.consumer].numChildren++;
+	}
+	
+	for(i = 0; i < numShared; i++)
+	{
+		UGenInternal* internal = shared[i];
+		
+		if((internal->schedulePass != pass) || (nodes[internal->scheduleIndex].isShared == false))
+			release(internal);
+	}
+	
+	// in reverse so consumers are laid out before their inputs: the inputs of a consumer
+	// follow the inputs of its own consumer so the blocks are only reused once they're dead
+	for(i = numNodes - 1; i >= 0; i--)
+	{
+		Node& node = nodes[i];
+		
+		if(node.isShared)
+		{
+			Node& consumer = nodes[node.consumer];
+			node.anchor = consumer.anchor;
+			node.index += consumer.top;
+			node.top = consumer.top + consumer.numChildren;
+			
+			Node& anchor = nodes[node.anchor];
+			const int end = node.top + node.numChildren;
+			
+			if(end > anchor.regionSize) 
+				anchor.regionSize = end;
+		}
+		else
+		{
+			node.anchor = i;
+			node.top = 0;
+			node.regionSize = node.numChildren;
+		}
+	}
+	
+	numBlocks = 0;
+	
+	for(i = 0; i < numNodes; i++)
+	{
+		Node& node = nodes[i];
+		
+		if(node.isShared == false)
+		{
+			node.regionStart = numBlocks;
+			numBlocks += node.regionSize;
+		}
+	}
+	
+	allocate(numBlocks, actualBlockSize);
+	ensureSize(nextShared, allocatedNextShared, numNodes);
+	
+	int numNextShared = 0;
+	
+	for(i = 0; i < numNodes; i++)
+	{
+		Node& node = nodes[i];
+		
+		if(node.isShared)
+		{
+			float* block = blocks + (nodes[node.anchor].regionStart + node.index) * blockStride;
+			
+			if(node.wasShared == false)
+				node.internal->incrementRefCount();
+			
+			UGenOutput& output = node.internal->getOutputRef();
+			output.useArenaBlock(block, blockStride);
+			
+			Node& consumer = nodes[node.consumer];
+			
+			if((consumer.inPlaceInput == i) && 
+			   (node.numReferences == 1) && 
+			   (consumer.internal->isProxyOwner() == false))
+				output.useInPlaceOutput(consumer.internal->getOutputPtr());
+			
+			nextShared[numNextShared++] = node.internal;
+		}
+	}
+	
+	UGenInternal** const previous = shared;
+	const int allocatedPrevious = allocatedShared;
+	shared = nextShared;
+	allocatedShared = allocatedNextShared;
+	nextShared = previous;
+	allocatedNextShared = allocatedPrevious;
+	numShared = numNextShared;
+	
+	ensureSize(sharedRefCounts, allocatedSharedRefCounts, numShared);
+	
+	for(i = 0; i < numShared; i++)
+		sharedRefCounts[i] = shared[i]->getRefCount();
+	
+	delete [] oldMemory;
+	oldMemory = 0;
+}
+
+bool UGenOutputArena::needsPlan(const int actualBlockSize) const throw()
+{
+	if((hasPlanned == false) || 
+	   (actualBlockSize > blockStride) || 
+	   (plannedGeneration != UGenInternal::graphGeneration))
+		return true;
+	
+	// any new reference to a shared UGenInternal might read its block outside its consumer
+	for(int i = 0; i < numShared; i++)
+		if(shared[i]->getRefCount() != sharedRefCounts[i])
+			return true;
+	
+	return false;
+}
+
+float* UGenOutputArena::prepareAndProcessBlock(UGen& graph, const int actualBlockSize, const unsigned int blockID, const int channel) throw()
+{
+	if(needsPlan(actualBlockSize))
+	{
+		plan(graph, actualBlockSize);
+		hasPlanned = true;
+	}
+	
+	return graph.prepareAndProcessBlock(actualBlockSize, blockID, channel);
+}
+
+END_UGEN_NAMESPACE
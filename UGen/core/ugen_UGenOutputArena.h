@@ -0,0 +1,176 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#ifndef UGEN_UGENOUTPUTARENA_H
+#define UGEN_UGENOUTPUTARENA_H
+
+#include "ugen_UGen.h"
+#include "ugen_UGenInternal.h"
+
+/** Renders a UGen graph with its intermediate output blocks taken from a shared arena.
+ 
+ Normally each UGenInternal owns a private output block so a graph of N UGenInternal 
+ objects touches N blocks of memory each block. The UGenOutputArena assigns blocks from 
+ one contiguous pool instead, reusing a block once the values it holds can no longer 
+ be read (rather like register allocation).
+ 
+ @code
+	UGenOutputArena arena;
+	arena.reserve(256, 512); // optional, otherwise the arena grows on the first blocks
+ 
+	// ...then in the audio callback instead of graph.prepareAndProcessBlock(...)
+	arena.prepareAndProcessBlock(graph, blockSize, blockID, -1);
+ @endcode
+ 
+ The graph is walked using UGenInternal::addDependencies() on the first block. A UGenInternal 
+ which is not a graph output, has only one consumer and is not referenced from anywhere else
+ (its reference count matches the references found in the graph) is only ever processed and 
+ read during its consumer's processBlock(). These are given arena blocks: the inputs of a
+ consumer use different blocks but the inputs of the next sibling of the consumer reuse the 
+ same ones. For a Mix of N similar voices this needs about N plus the depth of a voice 
+ blocks rather than N times the size of a voice. All other UGenInternal objects keep their 
+ private blocks.
+ 
+ The plan is kept from block to block. It is only made again when the graph has changed 
+ since (see UGenInternal::graphChanged()), when the reference count of one of 
+ the UGenInternal objects using an arena block has changed (e.g., the user or another UGen now holds 
+ it too) or when the block size outgrows the arena's blocks. So in a steady state the arena only 
+ checks the reference counts of the UGenInternal objects using it at the start of each block.
+ Planning may allocate, but only when the graph or block size grows beyond what the arena has 
+ seen before (see reserve()). The private blocks are kept while a UGenInternal is using the arena 
+ so it may leave it at any time without allocating unless the block size has grown.
+ 
+ If a consumer accepts in-place input (see UGenInternal::acceptsInPlaceInput(), e.g., Mix) and 
+ its first input would use an arena block and is only read once, that input renders straight into
+ the consumer's output block so the consumer doesn't need to copy it.
+ 
+ Notes:
+ - processBlock() functions must write their whole output block each time and must only read 
+   their inputs' output blocks during their own processBlock() (this is true of the UGen 
+   classes in the library).
+ - The output block of a UGenInternal using the arena is only valid during its consumer's
+   processBlock(), UGenInternal::getValue() still returns the last sample it processed
+   (see UGenOutput::keepArenaValue()).
+ - The arena holds a reference to each UGenInternal which is using one of its blocks
+   (ProxyOwnerUGenInternal objects always keep their private blocks since this would
+   change how their proxies behave).
+ - Only one UGenOutputArena should be used with a graph and it should not be combined
+   with the ParallelRenderer.
+ 
+ @see UGen::prepareAndProcessBlock(), UGenInternal::addDependencies(), UGenOutput::useArenaBlock() */
+class UGenOutputArena : private UGenDependencies
+{
+public:
+	UGenOutputArena() throw();
+	~UGenOutputArena();
+	
+	/** Prepare and process a block of a graph, this is the equivalent of UGen::prepareAndProcessBlock(). */
+	float* prepareAndProcessBlock(UGen& graph, const int actualBlockSize, const unsigned int blockID, const int channel) throw();
+	
+	/** Allocate enough space for graphs with up to this many UGenInternal objects and this block size. */
+	void reserve(const int numInternals, const int maxBlockSize) throw();
+	
+	/** Return all UGenInternal objects to their private blocks. */
+	void clear() throw();
+	
+	/** The number of UGenInternal objects in the graph when it was last walked. */
+	inline int getNumInternals() const throw()	{ return numNodes;		}
+	
+	/** The number of UGenInternal objects currently using arena blocks. */
+	inline int getNumShared() const throw()		{ return numShared;		}
+	
+	/** The number of arena blocks these are sharing. */
+	inline int getNumBlocks() const throw()		{ return numBlocks;		}
+	
+	/** The number of times the graph has been walked and the blocks assigned. */
+	inline int getNumPlans() const throw()		{ return numPlans;		}
+	
+private:
+	struct Node
+	{
+		UGenInternal* internal;
+		int numReferences;
+		int numConsumers;
+		int consumer;
+		int numChildren;
+		int anchor;
+		int index;
+		int top;
+		int regionStart;
+		int regionSize;
+		int inPlaceInput;
+		bool isRoot;
+		bool isShared;
+		bool wasShared;
+	};
+	
+	void add(UGenInternal* internal, const int channel, const bool passesDeletion) throw();
+	int visit(UGenInternal* internal, const int channel) throw();
+	bool needsPlan(const int actualBlockSize) const throw();
+	void plan(UGen& graph, const int actualBlockSize) throw();
+	void release(UGenInternal* internal) throw();
+	void allocate(const int requiredBlocks, const int requiredBlockSize) throw();
+	
+	template<class ElementType>
+	static void ensureSize(ElementType*& array, int& allocatedSize, const int requiredSize) throw();
+	
+	unsigned int pass;
+	int plannedGeneration;
+	int numPlans;
+	bool hasPlanned;
+	
+	Node* nodes;
+	int numNodes, allocatedNodes;
+	int* stack;
+	int numStacked, allocatedStack;
+	UGenInternal** shared;
+	UGenInternal** nextShared;
+	int numShared, allocatedShared, allocatedNextShared;
+	int* sharedRefCounts;			// the reference counts of the shared UGenInternal objects when planned
+	int allocatedSharedRefCounts;
+	
+	float* memory;
+	float* blocks;
+	float* oldMemory;
+	int numBlocks, allocatedBlocks;
+	int blockStride;
+	
+	UGenOutputArena (const UGenOutputArena&);
+    const UGenOutputArena& operator= (const UGenOutputArena&);
+};
+
+#endif // UGEN_UGENOUTPUTARENA_H
@@ -112,21 +112,27 @@ Value::Value(ValueBaseInternal *internalToUse) throw()
 
 Value::~Value()
 { 
-	internal->decrementRefCount(); 
+	if(internal != 0)
+		internal->decrementRefCount(); 
 }
 
 Value::Value(Value const& copy) throw()
+:	internal(copy.internal)
 {
-	internal = copy.internal;
-	internal->incrementRefCount();
+	if(internal != 0)
+		internal->incrementRefCount();
 }
 
 Value& Value::operator= (Value const& other) throw()
 {
 	if (this != &other)
     {		
-		other.internal->incrementRefCount();
-		internal->decrementRefCount();
+		if(other.internal != 0)
+			other.internal->incrementRefCount();
+		
+		if(internal != 0)
+			internal->decrementRefCount();
+		
 		internal = other.internal;
     }
 	
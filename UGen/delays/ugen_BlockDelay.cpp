@@ -87,6 +87,12 @@ void BlockDelayUGenInternal::processBlock(bool& shouldDelete, const unsigned int
 		memcpy(delayBufferSamples, inputSamples, numSamplesToProcess * sizeof(float));
 }
 
+void BlockDelayUGenInternal::addDependencies(UGenDependencies& /*dependencies*/, const int /*channel*/) throw()
+{
+	// the input is read from the previous block (and may contain this UGenInternal in 
+	// a feedback loop) so it must not be scheduled as a dependency
+}
+
 void BlockDelayUGenInternal::releaseInternal() throw()
 {
 	// break the potential infinte loop in a release action
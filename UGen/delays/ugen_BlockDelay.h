@@ -52,6 +52,7 @@ public:
 	//void prepareForBlock(const int actualBlockSize, const unsigned int blockID) throw();	// necessary if there are input ugens, these need preparing too
 	void prepareForBlockInternal(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	void addDependencies(UGenDependencies& dependencies, const int channel) throw();
 	
 	void releaseInternal() throw();
 	void stealInternal() throw();
@@ -45,6 +45,7 @@ BEGIN_UGEN_NAMESPACE
 #include "ugen_Delay.h"
 #include "../basics/ugen_Temporary.h"
 #include "../basics/ugen_InlineUnaryOps.h"
+#include "../core/ugen_Bits.h"
 
 
 DelayBaseUGenInternal::DelayBaseUGenInternal(const int numInputs,
@@ -53,8 +54,11 @@ DelayBaseUGenInternal::DelayBaseUGenInternal(const int numInputs,
 											 Buffer const& delayBuffer,
 											 const bool isMultiTap) throw()
 :	ProxyOwnerUGenInternal(numInputs, isMultiTap ? delayTime.getNumChannels()-1 : 0),
-	delayBuffer_(delayBuffer),
+	delayBuffer_((delayBuffer.size() > 0) && Bits::isPowerOf2(delayBuffer.size()) 
+				 ? delayBuffer 
+				 : Buffer(BufferSpec((int)Bits::nextPowerOf2(ugen::max(1, delayBuffer.size())), 1, true))),
 	delayBufferSize(delayBuffer_.size()),
+	bufferMask(delayBufferSize - 1),
 	bufferSamples(delayBuffer_.getData(0)),
 	bufferWritePos(0)
 {
@@ -62,54 +66,234 @@ DelayBaseUGenInternal::DelayBaseUGenInternal(const int numInputs,
 	inputs[DelayTime] = delayTime;
 }
 
-DelayNUGenInternal::DelayNUGenInternal(UGen const& input, UGen const& delayTime, Buffer const& delayBuffer) throw()
-:	DelayBaseUGenInternal(NumInputs, input, delayTime, delayBuffer, false)
-{ 
+Buffer DelayBaseUGenInternal::createDelayBuffer(const float maximumDelayTime, const int numChannels) throw()
+{
+	const int minimumSize = int(UGen::getSampleRate() * maximumDelayTime) + 1;
+	return Buffer(BufferSpec((int)Bits::nextPowerOf2(minimumSize), numChannels, true));
 }
 
-UGenInternal* DelayNUGenInternal::getChannel(const int channel) throw()
+bool DelayBaseUGenInternal::isConstantBlock(const float* samples, const int numSamples) throw()
 {
-	return new DelayNUGenInternal(inputs[Input].getChannel(channel), 
-								  inputs[DelayTime].getChannel(channel), 
-								  Buffer(BufferSpec(delayBuffer_.size(), 1, true)));
+	const float first = samples[0];
+	
+	for(int i = 1; i < numSamples; i++)
+	{
+		if(samples[i] != first)
+			return false;
+	}
+	
+	return true;
 }
 
-void DelayNUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw()
+void DelayBaseUGenInternal::writeBlock(const float* inputSamples, const int numSamples) throw()
+{
+	ugen_assert(numSamples <= delayBufferSize);
+	
+	const int numSamplesToEnd = ugen::min(numSamples, delayBufferSize - bufferWritePos);
+	memcpy(bufferSamples + bufferWritePos, inputSamples, numSamplesToEnd * sizeof(float));
+	memcpy(bufferSamples, inputSamples + numSamplesToEnd, (numSamples - numSamplesToEnd) * sizeof(float));
+}
+
+void DelayBaseUGenInternal::readBlock(const int position, float* outputSamples, const int numSamples) throw()
+{
+	ugen_assert(numSamples <= delayBufferSize);
+	
+	const int bufferReadPos = position & bufferMask;
+	const int numSamplesToEnd = ugen::min(numSamples, delayBufferSize - bufferReadPos);
+	memcpy(outputSamples, bufferSamples + bufferReadPos, numSamplesToEnd * sizeof(float));
+	memcpy(outputSamples + numSamplesToEnd, bufferSamples, (numSamples - numSamplesToEnd) * sizeof(float));
+}
+
+void DelayBaseUGenInternal::readBlockL(const int position, const float frac, float* outputSamples, const int numSamples) throw()
+{
+	int numSamplesToProcess = numSamples;
+	int bufferReadPos = position & bufferMask;
+	
+	while(numSamplesToProcess > 0)
+	{
+		if(bufferReadPos == 0)
+		{
+			// the sample behind is at the other end of the Buffer
+			const float value0 = bufferSamples[0];
+			*outputSamples++ = value0 + frac * (bufferSamples[bufferMask] - value0);
+			bufferReadPos = 1 & bufferMask;
+			numSamplesToProcess--;
+		}
+		else
+		{
+			const int numSamplesThisTime = ugen::min(numSamplesToProcess, delayBufferSize - bufferReadPos);
+			const float* currentSamples = bufferSamples + bufferReadPos;
+			const float* previousSamples = currentSamples - 1;
+			
+			for(int i = 0; i < numSamplesThisTime; i++)
+				outputSamples[i] = currentSamples[i] + frac * (previousSamples[i] - currentSamples[i]);
+			
+			outputSamples += numSamplesThisTime;
+			numSamplesToProcess -= numSamplesThisTime;
+			bufferReadPos = (bufferReadPos + numSamplesThisTime) & bufferMask;
+		}
+	}
+}
+
+void DelayBaseUGenInternal::processDelayN(const float* inputSamples, const float* delayTimeSamples, float* outputSamples, const int numSamples) throw()
 {
 	const float sampleRate = UGen::getSampleRate();
-	int numSamplesToProcess = uGenOutput.getBlockSize();
-	float* outputSamples = uGenOutput.getSampleData();
-	float* inputSamples = inputs[Input].processBlock(shouldDelete, blockID, channel);
-	float* delayTimeSamples = inputs[DelayTime].processBlock(shouldDelete, blockID, channel);
+	
+	if(isConstantBlock(delayTimeSamples, numSamples))
+	{
+		const int delay = ugen::max(0, (int)(*delayTimeSamples * sampleRate));
+		
+		// if the block fits no sample reads a position written later in the block
+		if(delay + numSamples <= delayBufferSize)
+		{
+			writeBlock(inputSamples, numSamples);
+			readBlock(bufferWritePos - delay, outputSamples, numSamples);
+			bufferWritePos = (bufferWritePos + numSamples) & bufferMask;
+			return;
+		}
+	}
+	
 	LOCAL_DECLARE(float * const, bufferSamples);
-	LOCAL_DECLARE(const double, delayBufferSize);
-	LOCAL_DECLARE(int, bufferWritePos);
+	LOCAL_DECLARE(const int, bufferMask);
+	int bufferWritePos = this->bufferWritePos;
 	
-	while(numSamplesToProcess > 0)
+	for(int i = 0; i < numSamples; i++)
 	{
-		int bufferSamplesRemaining = delayBufferSize - bufferWritePos;
+		bufferSamples[bufferWritePos] = inputSamples[i];
+		
+		const int bufferReadPos = bufferWritePos - ugen::max(0, (int)(delayTimeSamples[i] * sampleRate));
+		outputSamples[i] = bufferSamples[bufferReadPos & bufferMask];
 		
-		int numFramesThisTime = ugen::min(bufferSamplesRemaining, numSamplesToProcess);
-		numSamplesToProcess -= numFramesThisTime;
+		bufferWritePos = (bufferWritePos + 1) & bufferMask;
+	}
+	
+	this->bufferWritePos = bufferWritePos;
+}
+
+void DelayBaseUGenInternal::processDelayL(const float* inputSamples, const float* delayTimeSamples, float* outputSamples, const int numSamples) throw()
+{
+	const float sampleRate = UGen::getSampleRate();
+	
+	if(isConstantBlock(delayTimeSamples, numSamples))
+	{
+		const float delay = ugen::max(0.f, *delayTimeSamples * sampleRate);
+		const int iDelay = (int)delay;
 		
-		while(numFramesThisTime--)
+		if(iDelay + 1 + numSamples <= delayBufferSize)
 		{
-			bufferSamples[bufferWritePos] = *inputSamples++;
+			const float frac = delay - (float)iDelay;
 			
-			int bufferReadPos = bufferWritePos - ugen::max(0, (int)(*delayTimeSamples++ * sampleRate));
-			if(bufferReadPos < 0)
-				bufferReadPos += (int)delayBufferSize;
+			writeBlock(inputSamples, numSamples);
 			
-			*outputSamples++ = bufferSamples[bufferReadPos];
+			if(frac == 0.f)
+				readBlock(bufferWritePos - iDelay, outputSamples, numSamples);
+			else
+				readBlockL(bufferWritePos - iDelay, frac, outputSamples, numSamples);
 			
-			bufferWritePos++;
+			bufferWritePos = (bufferWritePos + numSamples) & bufferMask;
+			return;
 		}
+	}
+	
+	int bufferWritePos = this->bufferWritePos;
+	
+	for(int i = 0; i < numSamples; i++)
+	{
+		bufferSamples[bufferWritePos] = inputSamples[i];
+		outputSamples[i] = lookupDelayL(bufferWritePos, ugen::max(0.f, delayTimeSamples[i] * sampleRate));
+		bufferWritePos = (bufferWritePos + 1) & bufferMask;
+	}
+	
+	this->bufferWritePos = bufferWritePos;
+}
+
+void DelayBaseUGenInternal::processTapN(const float* inputSamples, const float* delayTimeSamples, float* outputSamples, const int numSamples) throw()
+{
+	const float sampleRate = UGen::getSampleRate();
+	
+	if(isConstantBlock(delayTimeSamples, numSamples))
+	{
+		const int delay = ugen::max(0, (int)(*delayTimeSamples * sampleRate));
 		
-		if(bufferWritePos >= delayBufferSize)
-			bufferWritePos = 0;
-	}	
+		if(delay < delayBufferSize)
+		{
+			// samples before the delay come from the Buffer, the rest from this block's input
+			const int numFromBuffer = ugen::min(delay, numSamples);
+			readBlock(bufferWritePos - delay, outputSamples, numFromBuffer);
+			memcpy(outputSamples + numFromBuffer, inputSamples, (numSamples - numFromBuffer) * sizeof(float));
+			return;
+		}
+	}
+	
+	for(int i = 0; i < numSamples; i++)
+		outputSamples[i] = lookupTap(inputSamples, i, ugen::max(0, (int)(delayTimeSamples[i] * sampleRate)), numSamples);
+}
+
+void DelayBaseUGenInternal::processTapL(const float* inputSamples, const float* delayTimeSamples, float* outputSamples, const int numSamples) throw()
+{
+	const float sampleRate = UGen::getSampleRate();
+	
+	if(isConstantBlock(delayTimeSamples, numSamples))
+	{
+		const float delay = ugen::max(0.f, *delayTimeSamples * sampleRate);
+		const int iDelay = (int)delay;
+		const float frac = delay - (float)iDelay;
+		
+		if(iDelay + 1 < delayBufferSize)
+		{
+			// both samples are in the Buffer before the delay, at the delay the sample behind 
+			// is the last one in the Buffer and after it both come from this block's input
+			const int numFromBuffer = ugen::min(iDelay, numSamples);
+			readBlockL(bufferWritePos - iDelay, frac, outputSamples, numFromBuffer);
+			
+			if(iDelay < numSamples)
+			{
+				const float value0 = inputSamples[0];
+				outputSamples[iDelay] = value0 + frac * (bufferSamples[(bufferWritePos - 1) & bufferMask] - value0);
+			}
+			
+			for(int i = iDelay + 1; i < numSamples; i++)
+			{
+				const float value0 = inputSamples[i - iDelay];
+				outputSamples[i] = value0 + frac * (inputSamples[i - iDelay - 1] - value0);
+			}
+			
+			return;
+		}
+	}
+	
+	for(int i = 0; i < numSamples; i++)
+	{
+		const float delaySamples = ugen::max(0.f, delayTimeSamples[i] * sampleRate);
+		const int iDelay = (int)delaySamples;
+		const float frac = delaySamples - (float)iDelay;
+		const float value0 = lookupTap(inputSamples, i, iDelay, numSamples);
+		const float value1 = lookupTap(inputSamples, i, iDelay + 1, numSamples);
+		
+		outputSamples[i] = value0 + frac * (value1 - value0);
+	}
+}
+
+DelayNUGenInternal::DelayNUGenInternal(UGen const& input, UGen const& delayTime, Buffer const& delayBuffer) throw()
+:	DelayBaseUGenInternal(NumInputs, input, delayTime, delayBuffer, false)
+{ 
+}
+
+UGenInternal* DelayNUGenInternal::getChannel(const int channel) throw()
+{
+	return new DelayNUGenInternal(inputs[Input].getChannel(channel), 
+								  inputs[DelayTime].getChannel(channel), 
+								  Buffer(BufferSpec(delayBuffer_.size(), 1, true)));
+}
+
+void DelayNUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw()
+{
+	const int numSamples = uGenOutput.getBlockSize();
+	float* outputSamples = uGenOutput.getSampleData();
+	float* inputSamples = inputs[Input].processBlock(shouldDelete, blockID, channel);
+	float* delayTimeSamples = inputs[DelayTime].processBlock(shouldDelete, blockID, channel);
 	
-	LOCAL_COPY(bufferWritePos);
+	processDelayN(inputSamples, delayTimeSamples, outputSamples, numSamples);
 }
 
 DelayNMultiUGenInternal::DelayNMultiUGenInternal(UGen const& input, UGen const& delayTime, Buffer const& delayBuffer) throw()
@@ -126,72 +310,22 @@ UGenInternal* DelayNMultiUGenInternal::getChannel(const int channel) throw()
 
 void DelayNMultiUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
 {
-	const float sampleRate = UGen::getSampleRate();
-	
-	int numSamplesToProcess = uGenOutput.getBlockSize();
+	const int numSamples = uGenOutput.getBlockSize();
 	float* outputSamples = uGenOutput.getSampleData();
 	float* inputSamples = inputs[Input].processBlock(shouldDelete, blockID, 0);
 	float* delayTimeSamples = inputs[DelayTime].processBlock(shouldDelete, blockID, 0);
-	LOCAL_DECLARE(float * const, bufferSamples);
-	LOCAL_DECLARE(const double, delayBufferSize);
-		
-	int bufferWritePos = this->bufferWritePos;
-	while(numSamplesToProcess > 0)
-	{
-		int bufferSamplesRemaining = delayBufferSize - bufferWritePos;
-		
-		int numFramesThisTime = ugen::min(bufferSamplesRemaining, numSamplesToProcess);
-		numSamplesToProcess -= numFramesThisTime;
-
-		while(numFramesThisTime--)
-		{
-			bufferSamples[bufferWritePos] = *inputSamples++;
-			
-			int bufferReadPos = bufferWritePos - ugen::max(0, (int)(*delayTimeSamples++ * sampleRate));
-			if(bufferReadPos < 0)
-				bufferReadPos += (int)delayBufferSize;
-			
-			*outputSamples++ = bufferSamples[bufferReadPos];
-			
-			bufferWritePos++;
-		}
-		
-		if(bufferWritePos >= delayBufferSize)
-			bufferWritePos = 0;
-	}	
 	
+	// the other taps are read before the block is written so long delays aren't overwritten
 	const int numChannels = getNumChannels();
 	for(int channel = 1; channel < numChannels; channel++)
 	{
-		int numSamplesToProcess = uGenOutput.getBlockSize();
-		float* outputSamples = proxies[channel]->getSampleData();
-		float* delayTimeSamples = inputs[DelayTime].processBlock(shouldDelete, blockID, channel);
-		int bufferWritePos = this->bufferWritePos; // fresh copy
+		float* tapSamples = proxies[channel]->getSampleData();
+		float* tapDelayTimeSamples = inputs[DelayTime].processBlock(shouldDelete, blockID, channel);
 		
-		while(numSamplesToProcess > 0)
-		{			
-			int bufferSamplesRemaining = delayBufferSize - bufferWritePos;
-			
-			int numFramesThisTime = ugen::min(bufferSamplesRemaining, numSamplesToProcess);
-			numSamplesToProcess -= numFramesThisTime;
-
-			while(numFramesThisTime--)
-			{
-				int bufferReadPos = bufferWritePos - ugen::max(0, (int)(*delayTimeSamples++ * sampleRate));
-				if(bufferReadPos < 0)
-					bufferReadPos += (int)delayBufferSize;
-				
-				*outputSamples++ = bufferSamples[bufferReadPos];
-				
-				bufferWritePos++;
-			}
-			
-			if(bufferWritePos >= delayBufferSize)
-				bufferWritePos = 0;
-		}			
+		processTapN(inputSamples, tapDelayTimeSamples, tapSamples, numSamples);
 	}
 	
-	this->bufferWritePos = bufferWritePos;
+	processDelayN(inputSamples, delayTimeSamples, outputSamples, numSamples);
 }
 
 
@@ -209,40 +343,12 @@ UGenInternal* DelayLUGenInternal::getChannel(const int channel) throw()
 
 void DelayLUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw()
 {
-	const float sampleRate = UGen::getSampleRate();
-	int numSamplesToProcess = uGenOutput.getBlockSize();
+	const int numSamples = uGenOutput.getBlockSize();
 	float* outputSamples = uGenOutput.getSampleData();
 	float* inputSamples = inputs[Input].processBlock(shouldDelete, blockID, channel);
 	float* delayTimeSamples = inputs[DelayTime].processBlock(shouldDelete, blockID, channel);
-	LOCAL_DECLARE(float * const, bufferSamples);
-	LOCAL_DECLARE(const double, delayBufferSize);
-	LOCAL_DECLARE(int, bufferWritePos);
-		
-	while(numSamplesToProcess > 0)
-	{
-		int bufferSamplesRemaining = delayBufferSize - bufferWritePos;
-		
-		int numFramesThisTime = ugen::min(bufferSamplesRemaining, numSamplesToProcess);
-		numSamplesToProcess -= numFramesThisTime;
-
-		while(numFramesThisTime--)
-		{
-			bufferSamples[bufferWritePos] = *inputSamples++;
-			
-			float bufferReadPos = (float)bufferWritePos - ugen::max(0.f, *delayTimeSamples++ * sampleRate);
-			if(bufferReadPos < 0.f)
-				bufferReadPos += (float)delayBufferSize;
-			
-			*outputSamples++ = lookupIndexL(bufferReadPos);
-			
-			bufferWritePos++;
-		}
-		
-		if(bufferWritePos >= delayBufferSize)
-			bufferWritePos = 0;
-	}
 	
-	LOCAL_COPY(bufferWritePos);
+	processDelayL(inputSamples, delayTimeSamples, outputSamples, numSamples);
 }
 
 DelayLMultiUGenInternal::DelayLMultiUGenInternal(UGen const& input, UGen const& delayTime, Buffer const& delayBuffer) throw()
@@ -259,72 +365,22 @@ UGenInternal* DelayLMultiUGenInternal::getChannel(const int channel) throw()
 
 void DelayLMultiUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
 {
-	const float sampleRate = UGen::getSampleRate();
-	
-	int numSamplesToProcess = uGenOutput.getBlockSize();
+	const int numSamples = uGenOutput.getBlockSize();
 	float* outputSamples = uGenOutput.getSampleData();
 	float* inputSamples = inputs[Input].processBlock(shouldDelete, blockID, 0);
 	float* delayTimeSamples = inputs[DelayTime].processBlock(shouldDelete, blockID, 0);
-	LOCAL_DECLARE(float * const, bufferSamples);
-	LOCAL_DECLARE(const double, delayBufferSize);
-		
-	int bufferWritePos = this->bufferWritePos;
-	while(numSamplesToProcess > 0)
-	{
-		int bufferSamplesRemaining = delayBufferSize - bufferWritePos;
-		
-		int numFramesThisTime = ugen::min(bufferSamplesRemaining, numSamplesToProcess);
-		numSamplesToProcess -= numFramesThisTime;
-
-		while(numFramesThisTime--)
-		{
-			bufferSamples[bufferWritePos] = *inputSamples++;
-			
-			float bufferReadPos = (float)bufferWritePos - ugen::max(0.f, *delayTimeSamples++ * sampleRate);
-			if(bufferReadPos < 0.f)
-				bufferReadPos += (float)delayBufferSize;
-			
-			*outputSamples++ = lookupIndexL(bufferReadPos);
-			
-			bufferWritePos++;
-		}
-
-		if(bufferWritePos >= delayBufferSize)
-			bufferWritePos = 0;
-	}
 	
+	// the other taps are read before the block is written so long delays aren't overwritten
 	const int numChannels = getNumChannels();
 	for(int channel = 1; channel < numChannels; channel++)
 	{
-		int numSamplesToProcess = uGenOutput.getBlockSize();
-		float* outputSamples = proxies[channel]->getSampleData();
-		float* delayTimeSamples = inputs[DelayTime].processBlock(shouldDelete, blockID, channel);
-		int bufferWritePos = this->bufferWritePos; // fresh copy
-				
-		while(numSamplesToProcess > 0)
-		{			
-			int bufferSamplesRemaining = delayBufferSize - bufferWritePos;
-			
-			int numFramesThisTime = ugen::min(bufferSamplesRemaining, numSamplesToProcess);
-			numSamplesToProcess -= numFramesThisTime;
-
-			while(numFramesThisTime--)
-			{
-				float bufferReadPos = (float)bufferWritePos - ugen::max(0.f, *delayTimeSamples++ * sampleRate);
-				if(bufferReadPos < 0.f)
-					bufferReadPos += (float)delayBufferSize;
-				
-				*outputSamples++ = lookupIndexL(bufferReadPos);
-				
-				bufferWritePos++;
-			}
-			
-			if(bufferWritePos >= delayBufferSize)
-				bufferWritePos = 0;
-		}
+		float* tapSamples = proxies[channel]->getSampleData();
+		float* tapDelayTimeSamples = inputs[DelayTime].processBlock(shouldDelete, blockID, channel);
+		
+		processTapL(inputSamples, tapDelayTimeSamples, tapSamples, numSamples);
 	}
 	
-	this->bufferWritePos = bufferWritePos;	
+	processDelayL(inputSamples, delayTimeSamples, outputSamples, numSamples);
 }
 
 RecircBaseUGenInternal::RecircBaseUGenInternal(UGen const& input, 
@@ -339,6 +395,32 @@ RecircBaseUGenInternal::RecircBaseUGenInternal(UGen const& input,
 	inputs[DecayTime] = decayTime;
 }
 
+void RecircBaseUGenInternal::recirculateBlock(const float* inputSamples, float* outputSamples, const int numSamples, const bool isAllpass) throw()
+{
+	LOCAL_DECLARE(const float, feedback);
+	int numSamplesToProcess = numSamples;
+	
+	while(numSamplesToProcess > 0)
+	{
+		const int numSamplesThisTime = ugen::min(numSamplesToProcess, delayBufferSize - bufferWritePos);
+		float* writeSamples = bufferSamples + bufferWritePos;
+		
+		for(int i = 0; i < numSamplesThisTime; i++)
+			writeSamples[i] = outputSamples[i] * feedback + inputSamples[i];
+		
+		if(isAllpass)
+		{
+			for(int i = 0; i < numSamplesThisTime; i++)
+				outputSamples[i] -= feedback * writeSamples[i];
+		}
+		
+		inputSamples += numSamplesThisTime;
+		outputSamples += numSamplesThisTime;
+		numSamplesToProcess -= numSamplesThisTime;
+		bufferWritePos = (bufferWritePos + numSamplesThisTime) & bufferMask;
+	}
+}
+
 CombNUGenInternal::CombNUGenInternal(UGen const& input, 
 									 UGen const& delayTime, 
 									 UGen const& decayTime, 
@@ -358,14 +440,11 @@ UGenInternal* CombNUGenInternal::getChannel(const int channel) throw()
 void CombNUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw()
 {
 	const float sampleRate = UGen::getSampleRate();
-	int numSamplesToProcess = uGenOutput.getBlockSize();
+	const int numSamples = uGenOutput.getBlockSize();
 	float* outputSamples = uGenOutput.getSampleData();
 	float* inputSamples = inputs[Input].processBlock(shouldDelete, blockID, channel);
 	float* delayTimeSamples = inputs[DelayTime].processBlock(shouldDelete, blockID, channel);
 	float* decayTimeSamples = inputs[DecayTime].processBlock(shouldDelete, blockID, channel);
-	LOCAL_DECLARE(float * const, bufferSamples);
-	LOCAL_DECLARE(const double, delayBufferSize);
-	LOCAL_DECLARE(int, bufferWritePos);
 	LOCAL_DECLARE(float, currentDecay);
 	LOCAL_DECLARE(float, feedback);
 		
@@ -377,36 +456,38 @@ void CombNUGenInternal::processBlock(bool& shouldDelete, const unsigned int bloc
 		LOCAL_COPY(feedback);
 	}
 	
-	while(numSamplesToProcess > 0)
+	if(isConstantBlock(delayTimeSamples, numSamples))
 	{
-		int bufferSamplesRemaining = delayBufferSize - bufferWritePos;
+		const int delay = ugen::max(1, (int)(*delayTimeSamples * sampleRate));
 		
-		int numFramesThisTime = ugen::min(bufferSamplesRemaining, numSamplesToProcess);
-		numSamplesToProcess -= numFramesThisTime;
-		
-		while(numFramesThisTime--)
+		// the whole block reads samples written before this block
+		if((delay >= numSamples) && (delay < delayBufferSize))
 		{
-			int bufferReadPos = bufferWritePos - ugen::max(1, (int)(*delayTimeSamples++ * sampleRate));
-			if(bufferReadPos < 0)
-				bufferReadPos += (int)delayBufferSize;
-			
-			float value = bufferSamples[bufferReadPos];
-			
-			bufferSamples[bufferWritePos] = value * feedback + *inputSamples++;
-			
-			*outputSamples++ = value;
-			
-			bufferWritePos++;
+			readBlock(bufferWritePos - delay, outputSamples, numSamples);
+			recirculateBlock(inputSamples, outputSamples, numSamples, false);
+			return;
 		}
+	}
+	
+	LOCAL_DECLARE(float * const, bufferSamples);
+	LOCAL_DECLARE(const int, bufferMask);
+	int bufferWritePos = this->bufferWritePos;
+	
+	for(int i = 0; i < numSamples; i++)
+	{
+		const int bufferReadPos = bufferWritePos - ugen::max(1, (int)(delayTimeSamples[i] * sampleRate));
+		const float value = bufferSamples[bufferReadPos & bufferMask];
 		
-		if(bufferWritePos >= delayBufferSize)
-			bufferWritePos = 0;
-	}	
+		bufferSamples[bufferWritePos] = value * feedback + inputSamples[i];
+		
+		outputSamples[i] = value;
+		
+		bufferWritePos = (bufferWritePos + 1) & bufferMask;
+	}
 	
-	LOCAL_COPY(bufferWritePos);
+	this->bufferWritePos = bufferWritePos;
 }
 
-
 CombLUGenInternal::CombLUGenInternal(UGen const& input, 
 									 UGen const& delayTime, 
 									 UGen const& decayTime, 
@@ -428,14 +509,11 @@ void CombLUGenInternal::processBlock(bool& shouldDelete, const unsigned int bloc
 	//static float denom = 1e-14; //15?
 	
 	const float sampleRate = UGen::getSampleRate();
-	int numSamplesToProcess = uGenOutput.getBlockSize();
+	const int numSamples = uGenOutput.getBlockSize();
 	float* outputSamples = uGenOutput.getSampleData();
 	float* inputSamples = inputs[Input].processBlock(shouldDelete, blockID, channel);
 	float* delayTimeSamples = inputs[DelayTime].processBlock(shouldDelete, blockID, channel);
 	float* decayTimeSamples = inputs[DecayTime].processBlock(shouldDelete, blockID, channel);
-	LOCAL_DECLARE(float * const, bufferSamples);
-	LOCAL_DECLARE(const double, delayBufferSize);
-	LOCAL_DECLARE(int, bufferWritePos);
 	LOCAL_DECLARE(float, currentDecay);
 	LOCAL_DECLARE(float, feedback);
 		
@@ -447,34 +525,34 @@ void CombLUGenInternal::processBlock(bool& shouldDelete, const unsigned int bloc
 		LOCAL_COPY(feedback);
 	}
 	
-	while(numSamplesToProcess > 0)
+	if(isConstantBlock(delayTimeSamples, numSamples))
 	{
-		int bufferSamplesRemaining = delayBufferSize - bufferWritePos;
-		int numSamplesThisTime = min(bufferSamplesRemaining, numSamplesToProcess);
-		
-		numSamplesToProcess -= numSamplesThisTime;
+		const float delay = ugen::max(1.f, *delayTimeSamples * sampleRate);
+		const int iDelay = (int)delay;
 		
-		while(numSamplesThisTime--)
+		if((iDelay >= numSamples) && (iDelay + 1 < delayBufferSize))
 		{
-			float bufferReadPos = (float)bufferWritePos - ugen::max(1.f, *delayTimeSamples++ * sampleRate);
-			if(bufferReadPos < 0.f)
-				bufferReadPos += (float)delayBufferSize;
-			
-			float value = lookupIndexL(bufferReadPos);
-			
-			bufferSamples[bufferWritePos] = value * feedback + *inputSamples++;// + denom;
-			//denom *= -1.f;
-			
-			*outputSamples++ = value;
-			
-			bufferWritePos++;
-		}	
+			readBlockL(bufferWritePos - iDelay, delay - (float)iDelay, outputSamples, numSamples);
+			recirculateBlock(inputSamples, outputSamples, numSamples, false);
+			return;
+		}
+	}
+	
+	int bufferWritePos = this->bufferWritePos;
+	
+	for(int i = 0; i < numSamples; i++)
+	{
+		const float value = lookupDelayL(bufferWritePos, ugen::max(1.f, delayTimeSamples[i] * sampleRate));
+		
+		bufferSamples[bufferWritePos] = value * feedback + inputSamples[i];// + denom;
+		//denom *= -1.f;
+		
+		outputSamples[i] = value;
 		
-		if(bufferWritePos >= delayBufferSize)
-			bufferWritePos = 0;
+		bufferWritePos = (bufferWritePos + 1) & bufferMask;
 	}
 	
-	LOCAL_COPY(bufferWritePos);
+	this->bufferWritePos = bufferWritePos;
 }
 
 AllpassNUGenInternal::AllpassNUGenInternal(UGen const& input, 
@@ -496,15 +574,12 @@ UGenInternal* AllpassNUGenInternal::getChannel(const int channel) throw()
 void AllpassNUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw()
 {
 	const float sampleRate = UGen::getSampleRate();
-	int numSamplesToProcess = uGenOutput.getBlockSize();
+	const int numSamples = uGenOutput.getBlockSize();
 	float* outputSamples = uGenOutput.getSampleData();
 	float* inputSamples = inputs[Input].processBlock(shouldDelete, blockID, channel);
 	float* delayTimeSamples = inputs[DelayTime].processBlock(shouldDelete, blockID, channel);
 	float* decayTimeSamples = inputs[DecayTime].processBlock(shouldDelete, blockID, channel);
 	bool doesNotNeedToCalculate = true;
-	LOCAL_DECLARE(float * const, bufferSamples);
-	LOCAL_DECLARE(const double, delayBufferSize);
-	LOCAL_DECLARE(int, bufferWritePos);
 	LOCAL_DECLARE(float, currentDelay);
 	LOCAL_DECLARE(float, currentDecay);
 	LOCAL_DECLARE(float, feedback);
@@ -532,36 +607,32 @@ void AllpassNUGenInternal::processBlock(bool& shouldDelete, const unsigned int b
 		LOCAL_COPY(feedback);
 	}
 	
-	float currentDelayMax1 = ugen::max(1.f, currentDelay);
+	const int delay = (int)ugen::max(1.f, currentDelay);
 	
-	while(numSamplesToProcess > 0)
+	if((delay >= numSamples) && (delay < delayBufferSize))
+	{
+		readBlock(bufferWritePos - delay, outputSamples, numSamples);
+		recirculateBlock(inputSamples, outputSamples, numSamples, true);
+		return;
+	}
+	
+	LOCAL_DECLARE(float * const, bufferSamples);
+	LOCAL_DECLARE(const int, bufferMask);
+	int bufferWritePos = this->bufferWritePos;
+	
+	for(int i = 0; i < numSamples; i++)
 	{
-		int bufferSamplesRemaining = delayBufferSize - bufferWritePos;
+		const float inValue = bufferSamples[(bufferWritePos - delay) & bufferMask];
+		const float outValue = inValue * feedback + inputSamples[i];
 		
-		int numFramesThisTime = ugen::min(bufferSamplesRemaining, numSamplesToProcess);
-		numSamplesToProcess -= numFramesThisTime;
-
-		while(numFramesThisTime--)
-		{
-			int bufferReadPos = bufferWritePos - (int)(currentDelayMax1);
-			if(bufferReadPos < 0)
-				bufferReadPos += (int)delayBufferSize;
-			
-			float inValue = bufferSamples[bufferReadPos];
-			float outValue = inValue * feedback + *inputSamples++;
-			
-			bufferSamples[bufferWritePos] = outValue;
-			
-			*outputSamples++ = inValue - feedback * outValue;
-			
-			bufferWritePos++;
-		}
+		bufferSamples[bufferWritePos] = outValue;
 		
-		if(bufferWritePos >= delayBufferSize)
-			bufferWritePos = 0;
-	}	
+		outputSamples[i] = inValue - feedback * outValue;
+		
+		bufferWritePos = (bufferWritePos + 1) & bufferMask;
+	}
 	
-	LOCAL_COPY(bufferWritePos);
+	this->bufferWritePos = bufferWritePos;
 }
 
 AllpassLUGenInternal::AllpassLUGenInternal(UGen const& input, 
@@ -585,15 +656,12 @@ void AllpassLUGenInternal::processBlock(bool& shouldDelete, const unsigned int b
 	//static float denom = 1e-14; //15?
 
 	const float sampleRate = UGen::getSampleRate();
-	int numSamplesToProcess = uGenOutput.getBlockSize();
+	const int numSamples = uGenOutput.getBlockSize();
 	float* outputSamples = uGenOutput.getSampleData();
 	float* inputSamples = inputs[Input].processBlock(shouldDelete, blockID, channel);
 	float* delayTimeSamples = inputs[DelayTime].processBlock(shouldDelete, blockID, channel);
 	float* decayTimeSamples = inputs[DecayTime].processBlock(shouldDelete, blockID, channel);
 	bool doesNotNeedToCalculate = true;
-	LOCAL_DECLARE(float * const, bufferSamples);
-	LOCAL_DECLARE(const double, delayBufferSize);
-	LOCAL_DECLARE(int, bufferWritePos);
 	LOCAL_DECLARE(float, currentDelay);
 	LOCAL_DECLARE(float, currentDecay);
 	LOCAL_DECLARE(float, feedback);
@@ -621,37 +689,32 @@ void AllpassLUGenInternal::processBlock(bool& shouldDelete, const unsigned int b
 		LOCAL_COPY(feedback);
 	}
 	
-	float currentDelayMax1 = ugen::max(1.f, currentDelay);
+	const float delay = ugen::max(1.f, currentDelay);
+	const int iDelay = (int)delay;
 	
-	while(numSamplesToProcess > 0)
+	if((iDelay >= numSamples) && (iDelay + 1 < delayBufferSize))
 	{
-		int bufferSamplesRemaining = delayBufferSize - bufferWritePos;
-		int numSamplesThisTime = min(bufferSamplesRemaining, numSamplesToProcess);
+		readBlockL(bufferWritePos - iDelay, delay - (float)iDelay, outputSamples, numSamples);
+		recirculateBlock(inputSamples, outputSamples, numSamples, true);
+		return;
+	}
+	
+	int bufferWritePos = this->bufferWritePos;
+	
+	for(int i = 0; i < numSamples; i++)
+	{
+		const float inValue = lookupDelayL(bufferWritePos, delay);
+		const float outValue = inValue * feedback + inputSamples[i];// + denom;
+		//denom *= -1.f;
 		
-		numSamplesToProcess -= numSamplesThisTime;
+		bufferSamples[bufferWritePos] = outValue;
 		
-		while(numSamplesThisTime--)
-		{
-			float bufferReadPos = bufferWritePos - currentDelayMax1;
-			if(bufferReadPos < 0.f)
-				bufferReadPos += (float)delayBufferSize;
-			
-			float inValue = lookupIndexL(bufferReadPos);
-			float outValue = inValue * feedback + *inputSamples++;// + denom;
-			//denom *= -1.f;
-			
-			bufferSamples[bufferWritePos]  = outValue;
-			
-			*outputSamples++ = inValue - feedback * outValue;
-			
-			bufferWritePos++;
-		}	
+		outputSamples[i] = inValue - feedback * outValue;
 		
-		if(bufferWritePos >= delayBufferSize)
-			bufferWritePos = 0;
+		bufferWritePos = (bufferWritePos + 1) & bufferMask;
 	}
 	
-	LOCAL_COPY(bufferWritePos);
+	this->bufferWritePos = bufferWritePos;
 }
 
 DelayN::DelayN(UGen const& input, const float maximumDelayTime, UGen const& delayTime) throw()
@@ -664,15 +727,13 @@ DelayN::DelayN(UGen const& input, const float maximumDelayTime, UGen const& dela
 	if(numInputChannels == 1 && numDelayTimeChannels > 1)
 	{
 		initInternal(numDelayTimeChannels);
-		Buffer delayBuffer(BufferSpec(int(UGen::getSampleRate() * maximumDelayTime) + 1, 1, true));
+		Buffer delayBuffer = DelayBaseUGenInternal::createDelayBuffer(maximumDelayTime);
 		generateFromProxyOwner(new DelayNMultiUGenInternal(input, delayTime, delayBuffer));
 	}
 	else if(numDelayTimeChannels > numInputChannels)
 	{
 		initInternal(numDelayTimeChannels);
-		Buffer delayBuffers(BufferSpec(int(UGen::getSampleRate() * maximumDelayTime) + 1, 
-									   numInputChannels, 
-									   true));
+		Buffer delayBuffers = DelayBaseUGenInternal::createDelayBuffer(maximumDelayTime, numInputChannels);
 		
 		int inputChannel = 0;
 		ProxyOwnerUGenInternal* proxyOwner = 0;
@@ -701,7 +762,7 @@ DelayN::DelayN(UGen const& input, const float maximumDelayTime, UGen const& dela
 		
 		for(unsigned int i = 0; i < numInternalUGens; i++)
 		{
-			Buffer delayBuffer(BufferSpec(int(UGen::getSampleRate() * maximumDelayTime) + 1, 1, true));
+			Buffer delayBuffer = DelayBaseUGenInternal::createDelayBuffer(maximumDelayTime);
 			internalUGens[i] = new DelayNUGenInternal(input, delayTime, delayBuffer);
 		}	
 	}
@@ -717,15 +778,13 @@ DelayL::DelayL(UGen const& input, const float maximumDelayTime, UGen const& dela
 	if(numInputChannels == 1 && numDelayTimeChannels > 1)
 	{
 		initInternal(numDelayTimeChannels);
-		Buffer delayBuffer(BufferSpec(int(UGen::getSampleRate() * maximumDelayTime) + 1, 1, true));
+		Buffer delayBuffer = DelayBaseUGenInternal::createDelayBuffer(maximumDelayTime);
 		generateFromProxyOwner(new DelayLMultiUGenInternal(input, delayTime, delayBuffer));
 	}
 	else if(numDelayTimeChannels > numInputChannels)
 	{
 		initInternal(numDelayTimeChannels);
-		Buffer delayBuffers(BufferSpec(int(UGen::getSampleRate() * maximumDelayTime) + 1, 
-									   numInputChannels, 
-									   true));
+		Buffer delayBuffers = DelayBaseUGenInternal::createDelayBuffer(maximumDelayTime, numInputChannels);
 		
 		int inputChannel = 0;
 		ProxyOwnerUGenInternal* proxyOwner = 0;
@@ -754,7 +813,7 @@ DelayL::DelayL(UGen const& input, const float maximumDelayTime, UGen const& dela
 		
 		for(unsigned int i = 0; i < numInternalUGens; i++)
 		{
-			Buffer delayBuffer(BufferSpec(int(UGen::getSampleRate() * maximumDelayTime) + 1, 1, true));
+			Buffer delayBuffer = DelayBaseUGenInternal::createDelayBuffer(maximumDelayTime);
 			internalUGens[i] = new DelayLUGenInternal(input, delayTime, delayBuffer);
 		}	
 	}
@@ -773,7 +832,7 @@ CombN::CombN(UGen const& input, const float maximumDelayTime, UGen const& delayT
 		internalUGens[i] = new CombNUGenInternal(input, 
 												 delayTime,//Clip(delayTime, 0.f, maximumDelayTime),
 												 decayTime,
-												 Buffer(BufferSpec(int(UGen::getSampleRate() * maximumDelayTime) + 1, 1, true)));
+												 DelayBaseUGenInternal::createDelayBuffer(maximumDelayTime));
 	}	
 }
 
@@ -790,7 +849,7 @@ CombL::CombL(UGen const& input, const float maximumDelayTime, UGen const& delayT
 		internalUGens[i] = new CombLUGenInternal(input, 
 												 delayTime,//Clip(delayTime, 0.f, maximumDelayTime),
 												 decayTime,
-												 Buffer(BufferSpec(int(UGen::getSampleRate() * maximumDelayTime) + 1, 1, true)));
+												 DelayBaseUGenInternal::createDelayBuffer(maximumDelayTime));
 	}	
 }
 
@@ -807,7 +866,7 @@ AllpassN::AllpassN(UGen const& input, const float maximumDelayTime, UGen const&
 		internalUGens[i] = new AllpassNUGenInternal(input, 
 													delayTime,//Clip(delayTime, 0.f, maximumDelayTime),
 													decayTime,
-													Buffer(BufferSpec(int(UGen::getSampleRate() * maximumDelayTime) + 1, 1, true)));
+													DelayBaseUGenInternal::createDelayBuffer(maximumDelayTime));
 	}	
 }
 
@@ -824,7 +883,7 @@ AllpassL::AllpassL(UGen const& input, const float maximumDelayTime, UGen const&
 		internalUGens[i] = new AllpassLUGenInternal(input, 
 													delayTime,//Clip(delayTime, 0.f, maximumDelayTime),
 													decayTime,
-													Buffer(BufferSpec(int(UGen::getSampleRate() * maximumDelayTime) + 1, 1, true)));
+													DelayBaseUGenInternal::createDelayBuffer(maximumDelayTime));
 	}	
 }
 
@@ -834,9 +893,15 @@ TapInUGenInternal::TapInUGenInternal(UGen const& input,
 :	ProxyOwnerUGenInternal(NumInputs, ugen::max(buffer.getNumChannels(), input.getNumChannels())-1),
 	buffer_(buffer)
 {
+	buffer_.addWriter();
 	inputs[Input] = input;
 }
 
+TapInUGenInternal::~TapInUGenInternal()
+{
+	buffer_.removeWriter();
+}
+
 UGenInternal* TapInUGenInternal::getChannel(const int channel) throw()
 {
 	return new TapInUGenInternal(inputs[Input].getChannel(channel), buffer_.getChannel(channel));	
@@ -938,7 +1003,7 @@ void TapOutNUGenInternal::processBlock(bool& shouldDelete, const unsigned int bl
 			int numSamplesToProcess = blockSize;
 			const int bufferSize = buffer_.size();
 			const float* delayTimeSamples = inputs[DelayTime].processBlock(shouldDelete, blockID, channel);
-			float* bufferSamples = buffer_.getData(channel);
+			const float* bufferSamples = buffer_.getDataReadOnly(channel);
 
 			while(numSamplesToProcess--) 
 			{							
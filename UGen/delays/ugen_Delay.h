@@ -43,7 +43,13 @@
 #include "../core/ugen_Value.h"
 #include "../basics/ugen_Chain.h"
 
-/** @ingroup UGenInternals */
+/** The base for the delay lines.
+ 
+ The delay Buffer is always a power of two in size (see createDelayBuffer(), other sizes are 
+ replaced in the constructor) so the read and write positions wrap with bufferMask rather 
+ than a comparison. When the delay time is constant for a block the line is read and written 
+ with (at most two) block copies rather than sample by sample.
+ @ingroup UGenInternals */
 class DelayBaseUGenInternal : public ProxyOwnerUGenInternal
 {
 public:
@@ -56,28 +62,38 @@ public:
 	
 	enum Inputs { Input, DelayTime, NumInputs };
 	
+	/** Create a Buffer for a delay line of up to maximumDelayTime seconds. 
+	 This is rounded up to the next power of two samples. */
+	static Buffer createDelayBuffer(const float maximumDelayTime, const int numChannels = 1) throw();
+	
 protected:
 
 	// perhaps move these lookups to Buffer?
 	inline float lookupIndexN(const int index)
 	{
-		return bufferSamples[index];
+		return bufferSamples[index & bufferMask];
 	}
 	
-	// must make this more efficient
 	inline float lookupIndexL(const float fIndex)
 	{
 		const int iIndex0 = (int)fIndex;
-		const int iIndex1 = iIndex0+1;
 		const float frac = fIndex - (float)iIndex0;
-		const float value0 = bufferSamples[iIndex0];
-		float value1;
+		const float value0 = bufferSamples[iIndex0 & bufferMask];
+		const float value1 = bufferSamples[(iIndex0 + 1) & bufferMask];
 		
-		if(iIndex1 == delayBuffer_.size()) {
-			value1 = bufferSamples[0];
-		} else {	
-			value1 = bufferSamples[iIndex1];
-		}
+		return value0 + frac * (value1 - value0);
+	}
+	
+	/** Interpolate the sample delaySamples (>= 0) behind position. 
+	 This keeps the integer and fractional parts of the delay apart so, unlike lookupIndexL(),
+	 the precision of the fraction doesn't depend on the position in a long Buffer. */
+	inline float lookupDelayL(const int position, const float delaySamples)
+	{
+		const int iDelay = (int)delaySamples;
+		const float frac = delaySamples - (float)iDelay;
+		const int iIndex = position - iDelay;
+		const float value0 = bufferSamples[iIndex & bufferMask];
+		const float value1 = bufferSamples[(iIndex - 1) & bufferMask];
 		
 		return value0 + frac * (value1 - value0);
 	}
@@ -87,13 +103,10 @@ protected:
 	inline float lookupIndexC(const float fIndex)
 	{
 		const int iIndex1 = (int)fIndex;
-		const int iIndex0 = iIndex1+1;
-		const int iIndex2 = iIndex1-1;
-		const int iIndex3 = iIndex1-2;
-		const float y0 = bufferSamples[iIndex0];
-		const float y1 = bufferSamples[iIndex1];
-		const float y2 = bufferSamples[iIndex2];
-		const float y3 = bufferSamples[iIndex3];
+		const float y0 = bufferSamples[(iIndex1 + 1) & bufferMask];
+		const float y1 = bufferSamples[iIndex1 & bufferMask];
+		const float y2 = bufferSamples[(iIndex1 - 1) & bufferMask];
+		const float y3 = bufferSamples[(iIndex1 - 2) & bufferMask];
 		
 		const float frac = fIndex - iIndex1;
 		
@@ -106,8 +119,48 @@ protected:
 		return ((c3 * frac + c2) * frac + c1) * frac + c0;
 	}
 	
+	/** Returns true if all the samples are the same as the first. */
+	static bool isConstantBlock(const float* samples, const int numSamples) throw();
+	
+	/** Copy numSamples into the Buffer at bufferWritePos, this doesn't move bufferWritePos. */
+	void writeBlock(const float* inputSamples, const int numSamples) throw();
+	
+	/** Copy numSamples from the Buffer starting at position (which may be negative). */
+	void readBlock(const int position, float* outputSamples, const int numSamples) throw();
+	
+	/** Read numSamples from the Buffer starting at position interpolated with the samples 
+	 one behind each, i.e., a constant delay with this fractional part. */
+	void readBlockL(const int position, const float frac, float* outputSamples, const int numSamples) throw();
+	
+	/** Write a block and read it with a non-interpolating delay, delayTimeSamples are in seconds. */
+	void processDelayN(const float* inputSamples, const float* delayTimeSamples, float* outputSamples, const int numSamples) throw();
+	
+	/** Write a block and read it with a linear interpolating delay, delayTimeSamples are in seconds. */
+	void processDelayL(const float* inputSamples, const float* delayTimeSamples, float* outputSamples, const int numSamples) throw();
+	
+	/** Get the sample delaySamples (>= 0) behind sample index of the block about to be written
+	 from bufferWritePos, i.e., what the Buffer will hold when that sample has been written. */
+	inline float lookupTap(const float* inputSamples, const int index, const int delaySamples, const int numSamples) const throw()
+	{
+		const int blockIndex = (index - delaySamples) & bufferMask;
+		
+		return ((blockIndex <= index) && (blockIndex < numSamples)) 
+			? inputSamples[blockIndex] 
+			: bufferSamples[(bufferWritePos + index - delaySamples) & bufferMask];
+	}
+	
+	/** Read a tap with a non-interpolating delay for the block about to be written.
+	 This must be called before the block is written (so a long delay still reads the samples the 
+	 block will overwrite), the samples the block writes come from inputSamples instead. */
+	void processTapN(const float* inputSamples, const float* delayTimeSamples, float* outputSamples, const int numSamples) throw();
+	
+	/** Read a tap with a linear interpolating delay for the block about to be written.
+	 @see processTapN() */
+	void processTapL(const float* inputSamples, const float* delayTimeSamples, float* outputSamples, const int numSamples) throw();
+	
 	Buffer delayBuffer_;
-	const double delayBufferSize;
+	const int delayBufferSize;
+	const int bufferMask;
 	float *bufferSamples;
 	int bufferWritePos;
 };
@@ -162,6 +215,11 @@ public:
 	enum Inputs { Input, DelayTime, DecayTime, NumInputs };
 	
 protected:
+	/** Feed back a block whose delayed samples have already been read into outputSamples.
+	 This writes the delayed samples times the feedback plus the input at bufferWritePos 
+	 (and moves it on) then, for an allpass, replaces the output with the allpass output. 
+	 The delay must be at least numSamples so the block doesn't read its own writes. */
+	void recirculateBlock(const float* inputSamples, float* outputSamples, const int numSamples, const bool isAllpass) throw();
 
 #ifndef UGEN_ANDROID
 	inline float calcFeedback(float delay, float decay)
@@ -374,6 +432,7 @@ class TapInUGenInternal :	public ProxyOwnerUGenInternal
 public:
 	TapInUGenInternal(UGen const& input,
 					  Buffer const& buffer) throw();
+	~TapInUGenInternal();
 	UGenInternal* getChannel(const int channel) throw();
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
 		
@@ -0,0 +1,337 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+
+#include "../core/ugen_StandardHeader.h"
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_FDNReverb.h"
+#include "../core/ugen_Constants.h"
+#include "../basics/ugen_InlineUnaryOps.h"
+#include "../basics/ugen_InlineBinaryOps.h"
+
+#ifdef UGEN_SIMD
+	#include "../vec/ugen_simd_Utilities.h"
+#endif
+
+static inline void addRows(const float *left, const float *right, float *output, const int numSamples) throw()
+{
+#if defined(UGEN_SIMD)
+	SIMD::add(left, right, output, numSamples);
+#else
+	for(int i = 0; i < numSamples; i++)
+		output[i] = left[i] + right[i];
+#endif
+}
+
+static inline void subtractRows(const float *left, const float *right, float *output, const int numSamples) throw()
+{
+#if defined(UGEN_SIMD)
+	SIMD::subtract(left, right, output, numSamples);
+#else
+	for(int i = 0; i < numSamples; i++)
+		output[i] = left[i] - right[i];
+#endif
+}
+
+static bool isPrime(const int value) throw()
+{
+	if(value < 2) return false;
+	
+	for(int divisor = 2; divisor * divisor <= value; divisor++)
+	{
+		if((value % divisor) == 0)
+			return false;
+	}
+	
+	return true;
+}
+
+int FDNReverbUGenInternal::getNumLines(const int numLines) throw()
+{
+	int checkedNumLines = MinLines;
+	
+	while((checkedNumLines < numLines) && (checkedNumLines < MaxLines))
+		checkedNumLines *= 2;
+	
+	return checkedNumLines;
+}
+
+FDNReverbUGenInternal::FDNReverbUGenInternal(UGen const& input, 
+											 UGen const& decayTime, 
+											 UGen const& damping, 
+											 const float size, 
+											 const int numLines, 
+											 const int numChannels) throw()
+:	ProxyOwnerUGenInternal(NumInputs, numChannels - 1),
+	numLines_(numLines),
+	numChannels_(numChannels),
+	lineSamples(0),
+	lineStarts(new int[numLines]),
+	lineLengths(new int[numLines]),
+	linePositions(new int[numLines]),
+	gains(new float[numLines]),
+	states(new float[numLines]),
+	rowSamples(new float[2 * numLines * MaxChunkSize]),
+	rowsA(new float*[numLines]),
+	rowsB(new float*[numLines]),
+	chunkSize(MaxChunkSize),
+	currentDecayTime(0.f),
+	currentDamping(0.f),
+	pole(0.f),
+	inputGain(1.f / (float)std::sqrt((double)numLines / numChannels))
+{
+	ugen_assert(numLines == getNumLines(numLines));
+	ugen_assert(numChannels <= numLines);
+	
+	inputs[Input] = input;
+	inputs[DecayTime] = decayTime;
+	inputs[Damping] = damping;
+	
+	// lengths spread exponentially from 20ms to 100ms (at size 1) rounded up to distinct primes
+	const double sampleRate = UGen::getSampleRate();
+	const double minimumTime = 0.02 * ugen::max(0.f, size);
+	const double ratio = 5.0;
+	int totalLength = 0;
+	
+	for(int line = 0; line < numLines_; line++)
+	{
+		const double time = minimumTime * std::pow(ratio, (double)line / (numLines_ - 1));
+		int length = ugen::max((int)MinLineLength, (int)(time * sampleRate + 0.5));
+		
+		if(line > 0) 
+			length = ugen::max(length, lineLengths[line-1] + 1);
+		
+		while(isPrime(length) == false) 
+			length++;
+		
+		lineStarts[line] = totalLength;
+		lineLengths[line] = length;
+		linePositions[line] = 0;
+		states[line] = 0.f;
+		totalLength += length;
+		
+		chunkSize = ugen::min(chunkSize, length);
+		rowsA[line] = rowSamples + line * MaxChunkSize;
+		rowsB[line] = rowSamples + (numLines_ + line) * MaxChunkSize;
+	}
+	
+	lines = Buffer(BufferSpec(totalLength, 1, true));
+	lineSamples = lines.getData(0);
+	
+	updateCoefficients(decayTime.getValue(0), damping.getValue(0));
+}
+
+FDNReverbUGenInternal::~FDNReverbUGenInternal()
+{
+	delete [] lineStarts;
+	delete [] lineLengths;
+	delete [] linePositions;
+	delete [] gains;
+	delete [] states;
+	delete [] rowSamples;
+	delete [] rowsA;
+	delete [] rowsB;
+}
+
+void FDNReverbUGenInternal::updateCoefficients(const float decayTime, const float damping) throw()
+{
+	currentDecayTime = decayTime;
+	currentDamping = damping;
+	pole = ugen::clip(damping, 0.f, 0.99f);
+	
+	// the Hadamard matrix is normalised by the damping gains rather than in the matrix
+	const float sampleRate = (float)UGen::getSampleRate();
+	const float scale = (1.f - pole) / (float)std::sqrt((double)numLines_);
+	
+	for(int line = 0; line < numLines_; line++)
+	{
+		const float delayTime = lineLengths[line] / sampleRate;
+		const float decayGain = decayTime > 0.f ? (float)std::exp(log001 * delayTime / decayTime) : 0.f;
+		gains[line] = decayGain * scale;
+	}
+}
+
+void FDNReverbUGenInternal::prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int /*channel*/) throw()
+{
+	// all channels of the inputs are needed by the owner
+	for(unsigned int i = 0; i < numInputs_; i++)
+		inputs[i].prepareForBlock(actualBlockSize, blockID, -1);
+}
+
+void FDNReverbUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
+{
+	const int numSamplesToProcess = uGenOutput.getBlockSize();
+	const float decayTime = *inputs[DecayTime].processBlock(shouldDelete, blockID, 0);
+	const float damping = *inputs[Damping].processBlock(shouldDelete, blockID, 0);
+	const float* inputSamples[MaxLines];
+	float* outputSamples[MaxLines];
+	
+	if((decayTime != currentDecayTime) || (damping != currentDamping))
+		updateCoefficients(decayTime, damping);
+	
+	for(int channel = 0; channel < numChannels_; channel++)
+	{
+		inputSamples[channel] = inputs[Input].processBlock(shouldDelete, blockID, channel);
+		outputSamples[channel] = proxies[channel]->getSampleData();
+	}
+	
+	for(int offset = 0; offset < numSamplesToProcess; offset += chunkSize)
+	{
+		processChunk(inputSamples, outputSamples, ugen::min(chunkSize, numSamplesToProcess - offset));
+		
+		for(int channel = 0; channel < numChannels_; channel++)
+		{
+			inputSamples[channel] += chunkSize;
+			outputSamples[channel] += chunkSize;
+		}
+	}
+}
+
+void FDNReverbUGenInternal::processChunk(const float * const *inputSamples, float * const *outputSamples, const int numSamples) throw()
+{
+	// read the oldest numSamples of each line, these are the outputs of the lines
+	for(int line = 0; line < numLines_; line++)
+	{
+		const float* lineStart = lineSamples + lineStarts[line];
+		const int position = linePositions[line];
+		const int numBeforeEnd = ugen::min(numSamples, lineLengths[line] - position);
+		
+		memcpy(rowsA[line], lineStart + position, numBeforeEnd * sizeof(float));
+		memcpy(rowsA[line] + numBeforeEnd, lineStart, (numSamples - numBeforeEnd) * sizeof(float));
+		
+		const int channel = line % numChannels_;
+		float* outputSamplesPtr = outputSamples[channel];
+		
+		if(line < numChannels_)
+			memcpy(outputSamplesPtr, rowsA[line], numSamples * sizeof(float));
+		else if(((line / numChannels_) & 1) != 0)
+			subtractRows(outputSamplesPtr, rowsA[line], outputSamplesPtr, numSamples);
+		else
+			addRows(outputSamplesPtr, rowsA[line], outputSamplesPtr, numSamples);
+	}
+	
+	// damping with the decay gain, four lines at a time (there are at least four and always a multiple of four)
+	const float b1 = pole;
+	for(int line = 0; line < numLines_; line += 4)
+	{
+		const float *x0 = rowsA[line], *x1 = rowsA[line+1], *x2 = rowsA[line+2], *x3 = rowsA[line+3];
+		float *y0 = rowsB[line], *y1 = rowsB[line+1], *y2 = rowsB[line+2], *y3 = rowsB[line+3];
+		const float a0 = gains[line], a1 = gains[line+1], a2 = gains[line+2], a3 = gains[line+3];
+		float s0 = states[line], s1 = states[line+1], s2 = states[line+2], s3 = states[line+3];
+		
+		for(int i = 0; i < numSamples; i++)
+		{
+			s0 = a0 * x0[i] + b1 * s0;
+			s1 = a1 * x1[i] + b1 * s1;
+			s2 = a2 * x2[i] + b1 * s2;
+			s3 = a3 * x3[i] + b1 * s3;
+			y0[i] = s0;
+			y1[i] = s1;
+			y2[i] = s2;
+			y3[i] = s3;
+		}
+		
+		states[line] = zap(s0);
+		states[line+1] = zap(s1);
+		states[line+2] = zap(s2);
+		states[line+3] = zap(s3);
+	}
+	
+	// fast Walsh-Hadamard transform of the rows
+	float** in = rowsB;
+	float** out = rowsA;
+	
+	for(int half = 1; half < numLines_; half *= 2)
+	{
+		for(int first = 0; first < numLines_; first += 2 * half)
+		{
+			for(int line = first; line < first + half; line++)
+			{
+				addRows(in[line], in[line + half], out[line], numSamples);
+				subtractRows(in[line], in[line + half], out[line + half], numSamples);
+			}
+		}
+		
+		float** const temp = in;
+		in = out;
+		out = temp;
+	}
+	
+	// add the input and write back to the lines
+	for(int line = 0; line < numLines_; line++)
+	{
+		float* row = in[line];
+		const float* inputSamplesPtr = inputSamples[line % numChannels_];
+		const float gain = inputGain;
+		
+		for(int i = 0; i < numSamples; i++)
+			row[i] += inputSamplesPtr[i] * gain;
+		
+		float* lineStart = lineSamples + lineStarts[line];
+		const int position = linePositions[line];
+		const int numBeforeEnd = ugen::min(numSamples, lineLengths[line] - position);
+		
+		memcpy(lineStart + position, row, numBeforeEnd * sizeof(float));
+		memcpy(lineStart, row + numBeforeEnd, (numSamples - numBeforeEnd) * sizeof(float));
+		
+		const int nextPosition = position + numSamples;
+		linePositions[line] = nextPosition >= lineLengths[line] ? nextPosition - lineLengths[line] : nextPosition;
+	}
+}
+
+void FDNReverbUGenInternal::addDependencies(UGenDependencies& dependencies, const int /*channel*/) throw()
+{
+	for(int channel = 0; channel < numChannels_; channel++)
+		dependencies.add(inputs[Input], channel);
+	
+	dependencies.add(inputs[DecayTime], 0);
+	dependencies.add(inputs[Damping], 0);
+}
+
+FDNReverb::FDNReverb(UGen const& input, UGen const& decayTime, UGen const& damping, const float size, const int numLines) throw()
+{
+	const int checkedNumLines = FDNReverbUGenInternal::getNumLines(numLines);
+	const int numChannels = ugen::min(input.getNumChannels(), checkedNumLines);
+	
+	initInternal(numChannels);
+	generateFromProxyOwner(new FDNReverbUGenInternal(input, decayTime.mix(), damping.mix(), size, checkedNumLines, numChannels));
+}
+
+
+END_UGEN_NAMESPACE
@@ -0,0 +1,130 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+
+#ifndef _UGEN_ugen_FDNReverb_H_
+#define _UGEN_ugen_FDNReverb_H_
+
+#include "../core/ugen_UGen.h"
+#include "../buffers/ugen_Buffer.h"
+
+/** A feedback delay network reverb.
+ 
+ The delay lines are stored end to end in a single Buffer. Each line is exactly as long as 
+ its delay so the samples read from a line are replaced by the new samples in the same place. 
+ Blocks are processed in chunks no longer than the shortest line with each line's chunk as a 
+ row of samples: the rows are read, damped (a one-pole lowpass with the line's decay gain 
+ applied as its DC gain), mixed by a fast Walsh-Hadamard transform (log2(numLines) stages 
+ of sums and differences of whole rows using SIMD::add() and SIMD::subtract()), the input 
+ is added and the rows are written back.
+ 
+ Input channel n feeds lines n, n + numChannels, n + 2 * numChannels etc and output channel 
+ n is the sum of the same lines (with alternating signs) so the number of output channels 
+ is the same as the input. 
+ @ingroup UGenInternals */
+class FDNReverbUGenInternal : public ProxyOwnerUGenInternal
+{
+public:
+	FDNReverbUGenInternal(UGen const& input, 
+						  UGen const& decayTime, 
+						  UGen const& damping, 
+						  const float size, 
+						  const int numLines, 
+						  const int numChannels) throw();
+	~FDNReverbUGenInternal();
+	
+	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
+	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	void addDependencies(UGenDependencies& dependencies, const int channel) throw(); // all channels are processed together
+	
+	enum Inputs { Input, DecayTime, Damping, NumInputs };
+	enum Limits { MinLines = 4, MaxLines = 64, MaxChunkSize = 256, MinLineLength = 16 };
+	
+	/** Returns a valid number of lines, a power of two from MinLines to MaxLines. */
+	static int getNumLines(const int numLines) throw();
+	
+private:
+	void updateCoefficients(const float decayTime, const float damping) throw();
+	void processChunk(const float * const *inputSamples, float * const *outputSamples, const int numSamples) throw();
+	
+	const int numLines_;
+	const int numChannels_;
+	Buffer lines;
+	float* lineSamples;
+	int* const lineStarts;
+	int* const lineLengths;
+	int* const linePositions;
+	float* const gains;
+	float* const states;
+	float* const rowSamples;
+	float** const rowsA;
+	float** const rowsB;
+	int chunkSize;
+	float currentDecayTime;
+	float currentDamping;
+	float pole;
+	float inputGain;
+};
+
+#define FDNReverb_Docs	@param input		The input, each channel feeds numLines / numChannels of the lines		\
+											and there is one output channel per input channel.						\
+						@param decayTime	The time in seconds for the reverb to decay by 60dB (at low				\
+											frequencies), this is read once per block.								\
+						@param damping		The high frequency damping from 0 (none) to 1, this is the				\
+											pole of the lowpass filter in each line, read once per block.			\
+						@param size			Scales the delay line lengths which are spread from 20 to 100ms			\
+											(rounded to prime numbers of samples) when size is 1.					\
+						@param numLines		The number of delay lines, this is rounded up to a power of two			\
+											from 4 to 64. 16 is dense enough for most purposes.
+
+/** A feedback delay network reverb in a single UGen.
+ This replaces reverbs built from long chains of CombN and AllpassN (e.g., RecircBaseChain) 
+ where each link has its own buffer and processing overhead. The feedback matrix is a 
+ normalised Hadamard matrix so the network is lossless apart from each line's decay gain 
+ and damping.
+ @code
+	UGen reverb = FDNReverb::AR(input, 3.0, 0.4); // 16 lines
+ @endcode
+ @ingroup AllUGens DelayUGens
+ @see FDNReverbUGenInternal, CombN, AllpassN, RecircBaseChain */
+UGenSublcassDeclaration(FDNReverb, (input, decayTime, damping, size, numLines),
+					    (UGen const& input, UGen const& decayTime = 2.f, UGen const& damping = 0.3f, 
+						 const float size = 1.f, const int numLines = 16), 
+						COMMON_UGEN_DOCS FDNReverb_Docs);
+
+
+#endif // _UGEN_ugen_FDNReverb_H_
@@ -35,7 +35,7 @@
  ==============================================================================
  */
 
-#if !defined(WIN32) && !defined(UGEN_IPHONE) && !defined(UGEN_ANDROID)
+#if defined(__APPLE__) && !defined(UGEN_IPHONE) && !defined(UGEN_ANDROID)
 	#include <Accelerate/Accelerate.h>
 	#include <CoreServices/CoreServices.h>
 #endif
@@ -47,24 +47,37 @@ BEGIN_UGEN_NAMESPACE
 #include "ugen_FFTEngine.h"
 #include "ugen_FFTEngineInternal.h"
 #include "../core/ugen_Arrays.h"
+#include "../core/ugen_Threads.h"
 
-FFTEngine::FFTEngine(const int fftSize) throw()
+#if defined(UGEN_FFTW)
+static FFTEngine::Backend defaultFFTBackend = FFTEngine::FFTWBackend;
+#elif defined(UGEN_VDSP)
+static FFTEngine::Backend defaultFFTBackend = FFTEngine::VDSPBackend;
+#else
+static FFTEngine::Backend defaultFFTBackend = FFTEngine::FFTRealBackend;
+#endif
+
+FFTEngine::FFTEngine(const int fftSize, const Backend backend, const bool shouldShare) throw()
 {
+	int actualSize;
+	
 	if(fftSize <= 0)
 	{
 		// deault to 4096
-		internal = new FFTEngineInternal(4096);
+		actualSize = 4096;
 	}
 	else if(fftSize < 16)
 	{
 		// less than 16 the fftSize is specified as a power of 2
-		internal = new FFTEngineInternal(1 << fftSize);
+		actualSize = 1 << fftSize;
 	}
 	else
 	{
 		// use fftSize directly, the internal rounds it up to a power of 2 if necessary
-		internal = new FFTEngineInternal(fftSize);
+		actualSize = fftSize;
 	}
+	
+	internal = new FFTEngineInternal(actualSize, backend, shouldShare);
 }
 
 FFTEngine::FFTEngine(FFTEngine const& copy) throw()
@@ -85,11 +98,20 @@ FFTEngine& FFTEngine::operator= (FFTEngine const& other) throw()
     return *this;
 }
 
-int FFTEngine::size() const throw()							{ return internal->size();			}
-Buffer& FFTEngine::getFFTWindow() throw()					{ return internal->getFFTWindow();	}
-Buffer& FFTEngine::getIFFTWindow() throw()					{ return internal->getIFFTWindow(); }
-void FFTEngine::setFFTWindow(Buffer const& window) throw()	{ internal->setFFTWindow(window);	}
-void FFTEngine::setIFFTWindow(Buffer const& window) throw() { internal->setIFFTWindow(window);	}
+int FFTEngine::size() const throw()							{ return internal->size();						}
+FFTEngine::Backend FFTEngine::getBackend() const throw()	{ return (Backend)internal->getBackend();		}
+Buffer& FFTEngine::getFFTWindow() throw()					{ return internal->getFFTWindow();				}
+Buffer& FFTEngine::getIFFTWindow() throw()					{ return internal->getIFFTWindow();				}
+
+void FFTEngine::setFFTWindow(Buffer const& window) throw()	{ internal->setFFTWindow(window);				}
+void FFTEngine::setIFFTWindow(Buffer const& window) throw() { internal->setIFFTWindow(window);				}
+
+FFTEngine FFTEngine::createShared() const throw()
+{
+	FFTEngine engine(internal->size(), (Backend)internal->getBackend(), true);
+	engine.internal->copyWindows(*internal);
+	return engine;
+}
 
 void FFTEngine::fft(Buffer const& outputBuffer, 
 					Buffer const& inputBuffer, 
@@ -133,6 +155,82 @@ void FFTEngine::ifft(Buffer const& outputBuffer,
 	internal->ifft(outputBuffer, inputBuffer, applyWindow, applyScaling, outputChannel, inputChannel, outputOffset, inputOffset);
 }
 
+void FFTEngine::fftChannels(Buffer const& outputBuffer, Buffer const& inputBuffer) throw()
+{
+	const int fftSize = internal->size();
+	
+	if((outputBuffer.size() < fftSize) || (inputBuffer.size() < fftSize) || 
+	   (outputBuffer.getNumChannels() < inputBuffer.getNumChannels()))
+	{
+		ugen_assertfalse; // buffer(s) too small
+		return;
+	}
+	
+	// in groups so no allocation is needed for the pointer arrays
+	const int maxChannelsPerPass = 32;
+	DSPSplitComplex outputs[maxChannelsPerPass];
+	const float* inputs[maxChannelsPerPass];
+	Buffer output(outputBuffer);
+	
+	for(int firstChannel = 0; firstChannel < inputBuffer.getNumChannels(); firstChannel += maxChannelsPerPass)
+	{
+		const int numChannels = ugen::min(maxChannelsPerPass, inputBuffer.getNumChannels() - firstChannel);
+		
+		for(int i = 0; i < numChannels; i++)
+		{
+			outputs[i].realp = output.getData(firstChannel + i);
+			outputs[i].imagp = outputs[i].realp + (fftSize >> 1);
+			inputs[i] = inputBuffer.getData(firstChannel + i);
+		}
+		
+		internal->fft(outputs, inputs, numChannels);
+	}
+}
+
+void FFTEngine::ifftChannels(Buffer const& outputBuffer, Buffer const& inputBuffer, const bool applyScaling) throw()
+{
+	const int fftSize = internal->size();
+	
+	if((outputBuffer.size() < fftSize) || (inputBuffer.size() < fftSize) || 
+	   (outputBuffer.getNumChannels() < inputBuffer.getNumChannels()))
+	{
+		ugen_assertfalse; // buffer(s) too small
+		return;
+	}
+	
+	const int maxChannelsPerPass = 32;
+	float* outputs[maxChannelsPerPass];
+	DSPSplitComplex inputs[maxChannelsPerPass];
+	Buffer output(outputBuffer);
+	
+	for(int firstChannel = 0; firstChannel < inputBuffer.getNumChannels(); firstChannel += maxChannelsPerPass)
+	{
+		const int numChannels = ugen::min(maxChannelsPerPass, inputBuffer.getNumChannels() - firstChannel);
+		
+		for(int i = 0; i < numChannels; i++)
+		{
+			outputs[i] = output.getData(firstChannel + i);
+			inputs[i].realp = (float*)inputBuffer.getData(firstChannel + i);
+			inputs[i].imagp = inputs[i].realp + (fftSize >> 1);
+		}
+		
+		internal->ifft(outputs, inputs, numChannels);
+		
+		if(applyScaling)
+		{
+			const float scale = 1.f / fftSize;
+			
+			for(int i = 0; i < numChannels; i++)
+			{
+				float * const outputSamples = outputs[i];
+				
+				for(int j = 0; j < fftSize; j++)
+					outputSamples[j] *= scale;
+			}
+		}
+	}
+}
+
 Buffer FFTEngine::rawToRealImagRawSplit(Buffer const& raw) throw()
 {
 	return internal->rawToRealImagRawSplit(raw);
@@ -225,4 +323,128 @@ Buffer FFTEngine::generatePhaseShiftResponse(FloatArray const& phases) throw()
 
 
 
+bool FFTEngine::isBackendAvailable(const int backend) throw()
+{
+	switch(backend)
+	{
+#ifdef UGEN_FFTREAL_AVAILABLE
+		case FFTRealBackend: return true;
+#endif
+#ifdef UGEN_FFTW
+		case FFTWBackend: return true;
+#endif
+#ifdef UGEN_VDSP
+		case VDSPBackend: return true;
+#endif
+		default: return false;
+	}
+}
+
+const char* FFTEngine::getBackendName(const int backend) throw()
+{
+	switch(backend)
+	{
+		case DefaultBackend:	return getBackendName(defaultFFTBackend);
+		case FFTRealBackend:	return "FFTReal";
+		case FFTWBackend:		return "FFTW";
+		case VDSPBackend:		return "vDSP";
+		default:				return "unknown";
+	}
+}
+
+void FFTEngine::setDefaultBackend(const Backend backend) throw()
+{
+	if(backend == DefaultBackend) 
+		return;
+	
+	if(isBackendAvailable(backend))
+		defaultFFTBackend = backend;
+	else
+		ugen_assertfalse; // backend not compiled in
+}
+
+FFTEngine::Backend FFTEngine::getDefaultBackend() throw()
+{
+	return defaultFFTBackend;
+}
+
+void FFTEngine::clearPlanCache() throw()
+{
+	FFTPlan::clearSharedCache();
+}
+
+int FFTEngine::getNumCachedPlans() throw()
+{
+	return FFTPlan::getNumShared();
+}
+
+double FFTEngine::benchmark(const Backend requestedBackend, const int fftSize, const int numIterations) throw()
+{
+	const Backend backend = requestedBackend == DefaultBackend ? getDefaultBackend() : requestedBackend;
+	
+	if(isBackendAvailable(backend) == false || numIterations <= 0)
+		return -1.0;
+	
+	FFTEngine engine(fftSize, backend, false);
+	const int size = engine.size();
+	
+	Buffer signal(BufferSpec(size, 1, false));
+	Buffer spectrum(BufferSpec(size, 1, false));
+	float * const signalSamples = signal.getData();
+	
+	for(int i = 0; i < size; i++)
+		signalSamples[i] = (float)sin(i * 0.1) + (float)(i % 7) * 0.01f;
+	
+	DSPSplitComplex split;
+	split.realp = spectrum.getData();
+	split.imagp = split.realp + (size >> 1);
+	
+	FFTEngineInternal * const internal = engine.getInternal();
+	
+	// warm up caches and any lazily built tables
+	internal->fft(split, signalSamples);
+	internal->ifft(signalSamples, split);
+	
+	const double start = UGenThread::getMillisecondCounterHiRes();
+	
+	for(int i = 0; i < numIterations; i++)
+	{
+		internal->fft(split, signalSamples);
+		internal->ifft(signalSamples, split);
+	}
+	
+	const double end = UGenThread::getMillisecondCounterHiRes();
+	
+	internal->decrementRefCount(); // FFTEngine doesn't release its internal
+	
+	return (end - start) * 1000.0 / numIterations;
+}
+
+void FFTEngine::printBenchmarks(const int minSize, const int maxSize, const int numIterations) throw()
+{
+	printf("FFTEngine benchmark (microseconds per FFT/IFFT pair, default: %s)\n", getBackendName(DefaultBackend));
+	printf("%10s", "size");
+	
+	for(int backend = 0; backend < NumBackends; backend++)
+	{
+		if(isBackendAvailable(backend))
+			printf("%12s", getBackendName(backend));
+	}
+	
+	printf("\n");
+	
+	for(int size = Bits::nextPowerOf2(ugen::max(16, minSize)); size <= maxSize; size <<= 1)
+	{
+		printf("%10d", size);
+		
+		for(int backend = 0; backend < NumBackends; backend++)
+		{
+			if(isBackendAvailable(backend))
+				printf("%12.2f", benchmark((Backend)backend, size, numIterations));
+		}
+		
+		printf("\n");
+	}
+}
+
 END_UGEN_NAMESPACE
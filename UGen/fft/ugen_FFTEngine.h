@@ -43,28 +43,62 @@
 class FFTEngineInternal;
 
 /** FFT processing helper class.
- This relies on a choice of underlying FFT library.  */
+ This relies on a choice of underlying FFT library. Those compiled in (see FFTEngineInternal)
+ can be selected at runtime for each engine or globally using setDefaultBackend(). 
+ 
+ Each FFTEngine (and its copies) has its own FFTEngineInternal with its own work buffers and 
+ windows. Pass true for shouldShare to take the plans from a cache so all the shared engines 
+ with the same size and backend use the same plans (which are only read by the transforms), 
+ otherwise the engine builds its own. Copies of an FFTEngine share its work buffers so they
+ shouldn't transform on different threads at once, use createShared() for that instead (the 
+ FFT UGens do this for each instance). */
 class FFTEngine
 {
 public:
+	/** The FFT libraries which may be available. */
+	enum Backend
+	{
+		DefaultBackend = -1,	///< Use the default backend (see setDefaultBackend())
+		FFTRealBackend,			///< FFTReal, this is in the source tree and available unless UGEN_NOEXTGPL is defined
+		FFTWBackend,			///< FFTW, available if UGEN_FFTW is defined
+		VDSPBackend,			///< vDSP on the Mac and iOS, available if UGEN_VDSP is defined
+		NumBackends
+	};
+	
 	/** Construct an FFTEngine with a given FFT size.
 	 If this is 0 or less then a size of 4096 is used.
 	 If this is 16 or greater then this size is used directly for the FFT 
 	 (and rounded up to the next power of 2 if necessary). 
 	 power of 2 if not. If this is less tan 16 this value is taken to the 
-	 power of 2 before being used. */
-	FFTEngine(const int fftSize = 0) throw();
+	 power of 2 before being used. 
+	 @param fftSize		The FFT size as above.
+	 @param backend		The FFT library to use, if this is not available the default is used.
+	 @param shouldShare	If false new plans are built for this FFTEngine (and its copies),
+						if true the plans come from the shared cache (see above). */
+	FFTEngine(const int fftSize = 0, const Backend backend = DefaultBackend, const bool shouldShare = false) throw();
 	FFTEngine(FFTEngine const& copy) throw();
 	FFTEngine& operator= (FFTEngine const& other) throw();
 		
 	/** Get the FFT size. */
 	int size() const throw();
+	
+	/** Get the FFT library used by this engine. */
+	Backend getBackend() const throw();
+	
 	FFTEngineInternal* getInternal() throw() { return internal; }
 	Buffer& getFFTWindow() throw();
 	Buffer& getIFFTWindow() throw();
+	
+	/** Set the FFT window (of this engine and its copies). */
 	void setFFTWindow(Buffer const& window) throw();
+	
+	/** Set the IFFT window (of this engine and its copies). */
 	void setIFFTWindow(Buffer const& window) throw();
 	
+	/** Create an engine with the same size, backend and windows which shares the cached plans
+	 but has its own work buffers, so it can transform at the same time as this one. */
+	FFTEngine createShared() const throw();
+	
 	/** Perform an FFT. */
 	void fft(Buffer const& outputBuffer, 
 			 Buffer const& inputBuffer, 
@@ -100,6 +134,16 @@ public:
 			  const int outputOffset,
 			  const int inputOffset) throw();
 
+	/** Perform an FFT of each channel of a Buffer.
+	 All the channels are transformed in one pass. 
+	 The output Buffer should have at least as many channels as the input. */
+	void fftChannels(Buffer const& outputBuffer, Buffer const& inputBuffer) throw();
+	
+	/** Perform an inverse FFT of each channel of a Buffer.
+	 All the channels are transformed in one pass. 
+	 The output Buffer should have at least as many channels as the input. */
+	void ifftChannels(Buffer const& outputBuffer, Buffer const& inputBuffer, const bool applyScaling = false) throw();
+
 	Buffer rawToRealImagRawSplit(Buffer const& raw) throw();	
 	Buffer rawToRealImagUnpacked(Buffer const& raw) throw();
 	Buffer rawToRealImagUnpacked(Buffer const& raw, const int firstBin, const int numBins) throw();
@@ -140,6 +184,33 @@ public:
 	/** Generate impulse responses for creating filters for specific phase shifts. */
 	Buffer generatePhaseShiftResponse(FloatArray const& phases) throw();
 	
+	/** Determine whether a backend was compiled in. */
+	static bool isBackendAvailable(const int backend) throw();
+	
+	/** Get the name of a backend (e.g., for logging). */
+	static const char* getBackendName(const int backend) throw();
+	
+	/** Set the backend used by engines created with DefaultBackend.
+	 This is ignored if the backend is not available. Engines already created are not changed. */
+	static void setDefaultBackend(const Backend backend) throw();
+	
+	/** Get the backend used by engines created with DefaultBackend. */
+	static Backend getDefaultBackend() throw();
+	
+	/** Release the cache's references to the shared plans. 
+	 Plans still in use by FFTEngine objects remain valid but later plans will be created afresh. */
+	static void clearPlanCache() throw();
+	
+	/** Get the number of plans in the shared cache. */
+	static int getNumCachedPlans() throw();
+	
+	/** Time a forward and inverse FFT pair using a particular backend.
+	 @return The mean time of each pair in microseconds (or -1 if the backend is not available). */
+	static double benchmark(const Backend backend, const int fftSize, const int numIterations = 1000) throw();
+	
+	/** Print the benchmark() times of all the available backends for a range of FFT sizes. */
+	static void printBenchmarks(const int minSize = 64, const int maxSize = 65536, const int numIterations = 1000) throw();
+	
 private:
 	FFTEngineInternal* internal;
 };
@@ -35,7 +35,7 @@
  ==============================================================================
  */
 
-#if !defined(WIN32) && !defined(UGEN_IPHONE) && !defined(UGEN_ANDROID)
+#if defined(__APPLE__) && !defined(UGEN_IPHONE) && !defined(UGEN_ANDROID)
 	#include <Accelerate/Accelerate.h>
 	#include <CoreServices/CoreServices.h>
 #endif
@@ -46,17 +46,168 @@ BEGIN_UGEN_NAMESPACE
 
 #include "ugen_FFTEngineInternal.h"
 
-FFTEngineInternal::FFTEngineInternal(const int fftSizeToUse) throw()
-:	fftSize(Bits::isPowerOf2(fftSizeToUse) ? fftSizeToUse : Bits::nextPowerOf2(fftSizeToUse)),
+FFTPlan::FFTPlan(const int fftSizeToUse, const int backendToUse) throw()
+:	backend(backendToUse),
+	fftSize(fftSizeToUse)
+{
+	ugen_assert(Bits::isPowerOf2(fftSize));
+	ugen_assert(FFTEngine::isBackendAvailable(backend));
+	
+	makeRefCountAtomic(); // engines on different threads hold references
+	
+	switch(backend)
+	{
+#ifdef UGEN_FFTW
+		case FFTEngine::FFTWBackend: {
+			// unaligned so the plans can be executed on any engine's buffer
+			Buffer planningBuffer(BufferSpec(fftSize + 2, 1, false));
+			float * const planningSamples = planningBuffer.getData();
+			fftwPlan = fftwf_plan_dft_r2c_1d(fftSize, planningSamples, (fftwf_complex*) planningSamples, FFTW_ESTIMATE | FFTW_UNALIGNED);
+			ifftwPlan = fftwf_plan_dft_c2r_1d(fftSize, (fftwf_complex*) planningSamples, planningSamples, FFTW_ESTIMATE | FFTW_UNALIGNED);
+		} break;
+#endif
+#ifdef UGEN_VDSP
+		case FFTEngine::VDSPBackend:
+			fftSizeLog2 = 4;
+			while((1 << fftSizeLog2) < fftSize)
+				fftSizeLog2++;
+			fftvDSP = vDSP_create_fftsetup (fftSizeLog2, 0);
+			break;
+#endif
+		default: break; // FFTReal has no plan
+	}
+}
+
+FFTPlan::~FFTPlan()
+{
+	switch(backend)
+	{
+#ifdef UGEN_FFTW
+		case FFTEngine::FFTWBackend:
+			fftwf_destroy_plan(fftwPlan);
+			fftwf_destroy_plan(ifftwPlan);
+			break;
+#endif
+#ifdef UGEN_VDSP
+		case FFTEngine::VDSPBackend:
+			vDSP_destroy_fftsetup(fftvDSP);
+			break;
+#endif
+		default: break;
+	}
+}
+
+/** An entry in the shared plan cache. */
+struct FFTPlanCacheEntry
+{
+	FFTPlan* plan;
+	FFTPlanCacheEntry* next;
+};
+
+static FFTPlanCacheEntry* fftPlanCache = 0;
+static volatile int fftPlanCacheLock = 0;
+
+static void lockFFTPlanCache() throw()
+{
+	while(Atomics::compareAndSwap(fftPlanCacheLock, 0, 1) == false)
+		Atomics::pause();
+}
+
+static void unlockFFTPlanCache() throw()
+{
+	Atomics::memoryBarrier();
+	fftPlanCacheLock = 0;
+}
+
+static FFTPlan* findSharedFFTPlan(const int fftSize, const int backend) throw()
+{
+	for(FFTPlanCacheEntry* entry = fftPlanCache; entry != 0; entry = entry->next)
+	{
+		FFTPlan * const plan = entry->plan;
+		
+		if((plan->size() == fftSize) && (plan->getBackend() == backend))
+		{
+			plan->incrementRefCount();
+			return plan;
+		}
+	}
+	
+	return 0;
+}
+
+FFTPlan* FFTPlan::getShared(const int fftSize, const int backend) throw()
+{
+	lockFFTPlanCache();
+	FFTPlan* plan = findSharedFFTPlan(fftSize, backend);
+	unlockFFTPlanCache();
+	
+	if(plan != 0) 
+		return plan;
+	
+	// create outside the lock since planning may take some time
+	FFTPlan* newPlan = new FFTPlan(fftSize, backend);
+	
+	lockFFTPlanCache();
+	plan = findSharedFFTPlan(fftSize, backend);
+	
+	if(plan == 0)
+	{
+		// the cache keeps the original reference and the caller gets another
+		FFTPlanCacheEntry* entry = new FFTPlanCacheEntry;
+		entry->plan = newPlan;
+		entry->next = fftPlanCache;
+		fftPlanCache = entry;
+		
+		plan = newPlan;
+		plan->incrementRefCount();
+		newPlan = 0;
+	}
+	
+	unlockFFTPlanCache();
+	
+	// another thread added the same plan while this one was being created
+	delete newPlan;
+	
+	return plan;
+}
+
+void FFTPlan::clearSharedCache() throw()
+{
+	lockFFTPlanCache();
+	FFTPlanCacheEntry* entry = fftPlanCache;
+	fftPlanCache = 0;
+	unlockFFTPlanCache();
+	
+	while(entry != 0)
+	{
+		FFTPlanCacheEntry* next = entry->next;
+		entry->plan->decrementRefCount();
+		delete entry;
+		entry = next;
+	}
+}
+
+int FFTPlan::getNumShared() throw()
+{
+	int numShared = 0;
+	
+	lockFFTPlanCache();
+	for(FFTPlanCacheEntry* entry = fftPlanCache; entry != 0; entry = entry->next)
+		numShared++;
+	unlockFFTPlanCache();
+	
+	return numShared;
+}
+
+FFTEngineInternal::FFTEngineInternal(const int fftSizeToUse, const int backendToUse, const bool shouldBeShared) throw()
+:	backend(FFTEngine::isBackendAvailable(backendToUse) ? backendToUse : FFTEngine::getDefaultBackend()),
+	shared(shouldBeShared),
+	fftSize(Bits::isPowerOf2(fftSizeToUse) ? fftSizeToUse : Bits::nextPowerOf2(fftSizeToUse)),
 	fftSizeHalved(fftSize>>1),
 	fftSizeBytes(fftSize * sizeof(float)),
 	fftSizeHalvedBytes(fftSizeHalved * sizeof(float)),
 	ifftScaling(1.f/(float)fftSize),
-#ifdef UGEN_FFTW
-	transformBuffer(BufferSpec(fftSize + 2, 1, false)),
-#else
-	transformBuffer(BufferSpec(fftSize, 1, false)),
-#endif
+	transformBuffer(BufferSpec((backend == FFTEngine::FFTWBackend) ? fftSize + 2 : fftSize, 1, false)),
 	transformBufferSamples(transformBuffer.getData()),
 	fftWindow(Buffer::hannWindow(fftSize)),
 	ifftWindow(fftWindow),
@@ -69,23 +220,17 @@ FFTEngineInternal::FFTEngineInternal(const int fftSizeToUse) throw()
 	static int announced = 0;
 	
 	ugen_assert(fftSizeToUse == fftSize); // fftSizeToUse should be a power of 2
+	ugen_assert(backendToUse == backend || backendToUse == FFTEngine::DefaultBackend); // requested backend not compiled in
 	
 	transformBufferSplit.realp = transformBufferSamples;
 	transformBufferSplit.imagp = transformBufferSamples + fftSizeHalved;
 	
-#ifdef UGEN_FFTW
-	if(!announced) printf("FFTEngine using FFTW\n"); announced = 1;
-	fftwPlan = fftwf_plan_dft_r2c_1d(fftSize, transformBufferSamples, (fftwf_complex*) transformBufferSamples, FFTW_ESTIMATE);
-	ifftwPlan = fftwf_plan_dft_c2r_1d(fftSize, (fftwf_complex*) transformBufferSamples, transformBufferSamples, FFTW_ESTIMATE);
-#elif defined(UGEN_FFTREAL)
-	if(!announced) printf("FFTEngine using FFTReal\n"); announced = 1;
-	fftReal = new FFTReal<float>(fftSize);
-#else
-	if(!announced) printf("FFTEngine using vDSP\n"); announced = 1;
-	fftSizeLog2 = 4;
-	while((1 << fftSizeLog2) < fftSize)
-		fftSizeLog2++;
-	fftvDSP = vDSP_create_fftsetup (fftSizeLog2, 0);
+	if(!announced) { printf("FFTEngine using %s\n", FFTEngine::getBackendName(backend)); announced = 1; }
+	
+	plan = shared ? FFTPlan::getShared(fftSize, backend) : new FFTPlan(fftSize, backend);
+	
+#ifdef UGEN_FFTREAL_AVAILABLE
+	fftReal = (backend == FFTEngine::FFTRealBackend) ? new FFTReal<float>(fftSize) : 0;
 #endif
 	
 	//printf("fftsize=%d\n", fftSize);
@@ -93,14 +238,22 @@ FFTEngineInternal::FFTEngineInternal(const int fftSizeToUse) throw()
 
 FFTEngineInternal::~FFTEngineInternal()
 {
-#ifdef UGEN_FFTW
-	fftwf_destroy_plan(fftwPlan);
-	fftwf_destroy_plan(ifftwPlan);
-#elif defined(UGEN_FFTREAL)
+	plan->decrementRefCount();
+	
+#ifdef UGEN_FFTREAL_AVAILABLE
 	delete fftReal;
-#else
-	vDSP_destroy_fftsetup(fftvDSP);
-#endif		
+#endif
+}
+
+void FFTEngineInternal::copyWindows(FFTEngineInternal const& other) throw()
+{
+	ugen_assert(other.fftSize == fftSize);
+	
+	fftWindow = other.fftWindow;
+	ifftWindow = other.ifftWindow;
+	fftWindowSamples = fftWindow.getData();
+	ifftWindowSamples = ifftWindow.getData();
+	fftWindowFactor = other.fftWindowFactor;
 }
 
 void FFTEngineInternal::dispose()
@@ -154,13 +307,29 @@ void FFTEngineInternal::fft(DSPSplitComplex& outputBuffer, const float* const in
 		{
 			*tempSamples++ = *inputSamples++ * *windowSamples++;
 		}
-		fft(outputBuffer, windowingBufferSamples);
+		transform(outputBuffer, windowingBufferSamples);
 	}
 	else
 		fft(outputBuffer, inputBuffer);
 	
 }
 
+void FFTEngineInternal::fft(DSPSplitComplex* const outputBuffers, const float* const* inputBuffers, const int numTransforms) throw()
+{
+	ugen_assert(numTransforms >= 0);
+	
+	for(int i = 0; i < numTransforms; i++)
+		transform(outputBuffers[i], inputBuffers[i]);
+}
+
+void FFTEngineInternal::ifft(float* const* outputBuffers, DSPSplitComplex const* inputBuffers, const int numTransforms) throw()
+{
+	ugen_assert(numTransforms >= 0);
+	
+	for(int i = 0; i < numTransforms; i++)
+		inverseTransform(outputBuffers[i], inputBuffers[i]);
+}
+
 void FFTEngineInternal::ifft(Buffer const& outputBuffer, 
 							 Buffer const& inputBuffer, 
 							 const bool applyWindow, 
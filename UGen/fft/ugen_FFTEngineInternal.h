@@ -43,6 +43,8 @@
 #include "../basics/ugen_InlineUnaryOps.h"
 #include "../basics/ugen_BinaryOpUGens.h"
 #include "../core/ugen_Bits.h"
+#include "../core/ugen_Atomics.h"
+#include "ugen_FFTEngine.h"
 
 
 //#warning REMOVE THESE DEFINES AFTER TESTING!!!!!
@@ -50,7 +52,7 @@
 //#define UGEN_FFTW 1		// best for windows
 							// otherwise use vDSP on the Mac (fastest of all)
 
-#if (defined (_WIN32) || defined (_WIN64) || defined(UGEN_IPHONE) || defined(UGEN_ANDROID)) // make this so it is "not mac" rather than "is windows"...
+#if !defined(__APPLE__) || defined(UGEN_IPHONE) || defined(UGEN_ANDROID) // not the Mac (vDSP types come from Accelerate there)
 	#ifndef UGEN_NEON
 		typedef struct _vFloat {
 			float f[4];
@@ -166,6 +168,12 @@
 	BEGIN_UGEN_NAMESPACE
 #elif !defined(UGEN_VDSP)
 	#define UGEN_FFTREAL 1
+#endif
+
+// FFTReal is in the source tree so it is always available as a backend (see FFTEngine::Backend)
+// unless UGEN_NOEXTGPL is defined and it is not the default
+#if defined(UGEN_FFTREAL) || !defined(UGEN_NOEXTGPL)
+	#define UGEN_FFTREAL_AVAILABLE 1
 	END_UGEN_NAMESPACE
 		#include "../fftreal/FFTReal.h"
 	BEGIN_UGEN_NAMESPACE
@@ -191,6 +199,47 @@
 #endif
 
 
+/** The plans (or setup) for one FFT size and backend.
+ The transforms only read these so one FFTPlan may be used by any number of FFTEngineInternal 
+ objects on different threads at once: FFTW executes a plan on the engine's own arrays (using 
+ the new-array execute functions) and a vDSP setup is read-only. FFTReal has nothing to share 
+ as its tables object holds work buffers so each FFTEngineInternal has its own FFTReal. */
+class FFTPlan : public SmartPointer
+{
+public:
+	FFTPlan(const int fftSize, const int backend) throw();
+	~FFTPlan();
+	
+	/** Get a plan from the process-wide cache creating it if necessary.
+	 The returned plan has had its reference count incremented for the caller. 
+	 @param fftSize		The FFT size (a power of 2).
+	 @param backend		The backend (this should be available). */
+	static FFTPlan* getShared(const int fftSize, const int backend) throw();
+	
+	/** Release the cache's references to the shared plans. */
+	static void clearSharedCache() throw();
+	
+	/** The number of plans in the cache. */
+	static int getNumShared() throw();
+	
+	inline int size() const throw() { return fftSize; }
+	inline int getBackend() const throw() { return backend; }
+	
+private:
+	const int backend;
+	const int fftSize;
+	
+#ifdef UGEN_FFTW
+	fftwf_plan fftwPlan, ifftwPlan;
+#endif
+#ifdef UGEN_VDSP
+	FFTSetup fftvDSP;
+	int fftSizeLog2;
+#endif
+	
+	friend class FFTEngineInternal;
+};
+
 /**
  Provides real to complex FFT and complex to real IFFT processes using a selection of underlying libraries.
  
@@ -199,13 +248,25 @@
  installed and define UGEN_FFTW equal to 1 before this file (e.g., doing this in preprocessor macros should ensure this).
  
  FFTReal is the slowest but at least it's available. FFTW on Windows compares well with vDSP on the Mac.
+ 
+ The library is chosen per engine at runtime from those compiled in (see FFTEngine::Backend). 
+ The plans are held by an FFTPlan which a shared engine gets from a cache so they are only built 
+ once for each size and backend. Each engine has its own work buffers, windows and (for FFTReal,
+ whose tables object also holds its work buffers) FFTReal object so engines sharing a plan can 
+ transform on different threads at once without locking.
  */
 class FFTEngineInternal : public SmartPointer
 {
 public:
-	FFTEngineInternal(const int fftSize) throw();
+	FFTEngineInternal(const int fftSize, const int backend = FFTEngine::DefaultBackend, const bool shared = false) throw();
 	~FFTEngineInternal();
 	
+	inline int getBackend() const throw() { return backend; }
+	inline bool isShared() const throw() { return shared; }
+	
+	/** Use the same windows as another engine (the window data is shared, not copied). */
+	void copyWindows(FFTEngineInternal const& other) throw();
+	
 	void dispose();
 	
 	inline int size() const throw() { return fftSize; }
@@ -242,34 +303,13 @@ public:
 	{
 		ugen_assert(inputBuffer != 0);
 		
-#ifdef UGEN_FFTW
-		memcpy(transformBufferSamples, inputBuffer, fftSizeBytes);
-		fftwf_execute(fftwPlan);
-
-		float nyquist = transformBufferSamples[fftSize]; // remember nyquist val
-		float *interleavedSamples = transformBufferSamples;
-		// deinteleave
-		for(int j = 0; j < fftSizeHalved; j++)
-		{
-			outputBuffer.realp[j] = *interleavedSamples++;
-			outputBuffer.imagp[j] = *interleavedSamples++;
-		}
-		outputBuffer.imagp[0] = nyquist; // pack nyquist in
-		
-#elif defined(UGEN_FFTREAL)
-		fftReal->do_fft(transformBufferSamples, inputBuffer);
-		memcpy(outputBuffer.realp, transformBufferSplit.realp, fftSizeHalvedBytes);
-		memcpy(outputBuffer.imagp, transformBufferSplit.imagp, fftSizeHalvedBytes);
-		
-#else
-		static float scale = 0.5f;
-		vDSP_vsmul(inputBuffer, 1, &scale, transformBufferSamples, 1, fftSize);
-		vDSP_ctoz ((COMPLEX *) transformBufferSamples, 2, &outputBuffer, 1, fftSizeHalved);
-		vDSP_fft_zrip (fftvDSP, &outputBuffer, 1, fftSizeLog2, FFT_FORWARD);
-		
-#endif
+		transform(outputBuffer, inputBuffer);
 	}
 	
+	/** Perform several FFTs in one pass (e.g., the channels of a multichannel signal or
+	 a series of frames). */
+	void fft(DSPSplitComplex* const outputBuffers, const float* const* inputBuffers, const int numTransforms) throw();
+	
 	void fft(DSPSplitComplex& outputBuffer, const float* const inputBuffer, const bool applyWindow) throw();
 	
 	void ifft(Buffer const& outputBuffer, 
@@ -292,42 +332,12 @@ public:
 	{
 		ugen_assert(outputBuffer != 0);
 		
-#ifdef UGEN_FFTW	
-		LOCAL_DECLARE(const int, fftSize);
-		LOCAL_DECLARE(const int, fftSizeHalved);
-		LOCAL_DECLARE(const int, fftSizeBytes);
-		LOCAL_DECLARE(const int, fftSizeHalvedBytes);
-		
-		LOCAL_DECLARE(float * const, transformBufferSamples);
-		LOCAL_DECLARE(DSPSplitComplex&, transformBufferSplit);
-
-		float *interleavedSamples = transformBufferSamples;
-		for(int j = 0; j < fftSizeHalved; j++)
-		{
-			*interleavedSamples++ = inputBuffer.realp[j];
-			*interleavedSamples++ = inputBuffer.imagp[j];
-		}
-		transformBufferSamples[fftSize  ] = transformBufferSamples[1]; // nyquist
-		transformBufferSamples[fftSize+1] = 0.f; // nyquist imag always zero
-		transformBufferSamples[1        ] = 0.f; // DC imag always zero
-		
-		fftwf_execute(ifftwPlan);
-		memcpy(outputBuffer, transformBufferSamples, fftSizeBytes);
-#elif defined(UGEN_FFTREAL)
-		memcpy(transformBufferSplit.realp, inputBuffer.realp, fftSizeBytes);
-		fftReal->do_ifft(transformBufferSamples, outputBuffer);
-#else
-//	#ifdef UGEN_IPHONE
-//		cblas_ccopy(fftSize, inputBuffer.realp, 1, transformBufferSplit.realp, 1);
-//	#else
-//		vScopy(fftSize, (const vFloat*)inputBuffer.realp, (vFloat*)transformBufferSplit.realp);
-//	#endif			
-		memcpy(transformBufferSplit.realp, inputBuffer.realp, fftSizeBytes);
-		vDSP_fft_zrip (fftvDSP, &transformBufferSplit, 1, fftSizeLog2, FFT_INVERSE);
-		vDSP_ztoc (&transformBufferSplit, 1, (COMPLEX *) outputBuffer, 2, fftSizeHalved);
-#endif		
+		inverseTransform(outputBuffer, inputBuffer);
 	}
 	
+	/** Perform several inverse FFTs in one pass. */
+	void ifft(float* const* outputBuffers, DSPSplitComplex const* inputBuffers, const int numTransforms) throw();
+	
 	void ifft(float* const outputBuffer, DSPSplitComplex const& inputBuffer, const bool applyWindow, const bool applyScaling) throw();
 	
 	Buffer rawToRealImagRawSplit(Buffer const& raw) throw();
@@ -349,14 +359,89 @@ public:
 	Buffer rawToPhase(Buffer const& raw, const int firstBin, const int numBins) throw();
 	
 private:
+	inline void transform(DSPSplitComplex& outputBuffer, const float* const inputBuffer) throw()
+	{
+		switch(backend)
+		{
 #ifdef UGEN_FFTW
-	fftwf_plan fftwPlan, ifftwPlan;
-#elif defined(UGEN_FFTREAL)
+			case FFTEngine::FFTWBackend: {
+				memcpy(transformBufferSamples, inputBuffer, fftSizeBytes);
+				fftwf_execute_dft_r2c(plan->fftwPlan, transformBufferSamples, (fftwf_complex*) transformBufferSamples);
+				
+				float nyquist = transformBufferSamples[fftSize]; // remember nyquist val
+				float *interleavedSamples = transformBufferSamples;
+				// deinteleave
+				for(int j = 0; j < fftSizeHalved; j++)
+				{
+					outputBuffer.realp[j] = *interleavedSamples++;
+					outputBuffer.imagp[j] = *interleavedSamples++;
+				}
+				outputBuffer.imagp[0] = nyquist; // pack nyquist in
+			} break;
+#endif
+#ifdef UGEN_VDSP
+			case FFTEngine::VDSPBackend: {
+				static float scale = 0.5f;
+				vDSP_vsmul(inputBuffer, 1, &scale, transformBufferSamples, 1, fftSize);
+				vDSP_ctoz ((COMPLEX *) transformBufferSamples, 2, &outputBuffer, 1, fftSizeHalved);
+				vDSP_fft_zrip (plan->fftvDSP, &outputBuffer, 1, plan->fftSizeLog2, FFT_FORWARD);
+			} break;
+#endif
+#ifdef UGEN_FFTREAL_AVAILABLE
+			case FFTEngine::FFTRealBackend: {
+				fftReal->do_fft(transformBufferSamples, inputBuffer);
+				memcpy(outputBuffer.realp, transformBufferSplit.realp, fftSizeHalvedBytes);
+				memcpy(outputBuffer.imagp, transformBufferSplit.imagp, fftSizeHalvedBytes);
+			} break;
+#endif
+			default: ugen_assertfalse;
+		}
+	}
+	
+	inline void inverseTransform(float* const outputBuffer, DSPSplitComplex const& inputBuffer) throw()
+	{
+		switch(backend)
+		{
+#ifdef UGEN_FFTW
+			case FFTEngine::FFTWBackend: {
+				float *interleavedSamples = transformBufferSamples;
+				for(int j = 0; j < fftSizeHalved; j++)
+				{
+					*interleavedSamples++ = inputBuffer.realp[j];
+					*interleavedSamples++ = inputBuffer.imagp[j];
+				}
+				transformBufferSamples[fftSize  ] = transformBufferSamples[1]; // nyquist
+				transformBufferSamples[fftSize+1] = 0.f; // nyquist imag always zero
+				transformBufferSamples[1        ] = 0.f; // DC imag always zero
+				
+				fftwf_execute_dft_c2r(plan->ifftwPlan, (fftwf_complex*) transformBufferSamples, transformBufferSamples);
+				memcpy(outputBuffer, transformBufferSamples, fftSizeBytes);
+			} break;
+#endif
+#ifdef UGEN_VDSP
+			case FFTEngine::VDSPBackend: {
+				memcpy(transformBufferSplit.realp, inputBuffer.realp, fftSizeBytes);
+				vDSP_fft_zrip (plan->fftvDSP, &transformBufferSplit, 1, plan->fftSizeLog2, FFT_INVERSE);
+				vDSP_ztoc (&transformBufferSplit, 1, (COMPLEX *) outputBuffer, 2, fftSizeHalved);
+			} break;
+#endif
+#ifdef UGEN_FFTREAL_AVAILABLE
+			case FFTEngine::FFTRealBackend: {
+				memcpy(transformBufferSplit.realp, inputBuffer.realp, fftSizeBytes);
+				fftReal->do_ifft(transformBufferSamples, outputBuffer);
+			} break;
+#endif
+			default: ugen_assertfalse;
+		}
+	}
+	
+	const int backend;
+	const bool shared;
+	
+	FFTPlan* plan;
+#ifdef UGEN_FFTREAL_AVAILABLE
 	FFTReal<float> *fftReal;
-#else
-    FFTSetup fftvDSP;
-	int fftSizeLog2;
-#endif	
+#endif
 	
 	const int fftSize;
 	const int fftSizeHalved;
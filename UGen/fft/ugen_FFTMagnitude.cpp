@@ -35,7 +35,7 @@
  ==============================================================================
  */
 
-#if !defined(WIN32) && !defined(UGEN_IPHONE) && !defined(UGEN_ANDROID)
+#if defined(__APPLE__) && !defined(UGEN_IPHONE) && !defined(UGEN_ANDROID)
 	#include <Accelerate/Accelerate.h>
 	#include <CoreServices/CoreServices.h>
 #endif
@@ -53,7 +53,7 @@ FFTMagnitudeUGenInternal::FFTMagnitudeUGenInternal(UGen const& input,
 												   const int firstBin, 
 												   const int numBins) throw()
 :	ProxyOwnerUGenInternal(NumInputs, numBins-1),
-	fftEngine(fft),
+	fftEngine(fft.createShared()),
 	fftSize(fftEngine.size()),
 	fftSizeHalved(fftSize / 2),	
 	overlap_(overlap < 1 ? 1 : overlap),
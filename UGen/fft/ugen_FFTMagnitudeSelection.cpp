@@ -35,7 +35,7 @@
  ==============================================================================
  */
 
-#if !defined(WIN32) && !defined(UGEN_IPHONE) && !defined(UGEN_ANDROID)
+#if defined(__APPLE__) && !defined(UGEN_IPHONE) && !defined(UGEN_ANDROID)
 	#include <Accelerate/Accelerate.h>
 	#include <CoreServices/CoreServices.h>
 #endif
@@ -52,7 +52,7 @@ FFTMagnitudeSelectionUGenInternal::FFTMagnitudeSelectionUGenInternal(UGen const&
 																	 const int overlap, 
 																	 IntArray const& _bins) throw()
 :	ProxyOwnerUGenInternal(NumInputs, _bins.length()-1),
-	fftEngine(fft),
+	fftEngine(fft.createShared()),
 	fftSize(fftEngine.size()),
 	fftSizeHalved(fftSize / 2),	
 	overlap_(overlap < 1 ? 1 : overlap),
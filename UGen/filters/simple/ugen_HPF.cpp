@@ -119,6 +119,51 @@ void HPFUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockI
 
 
 
+HPFBankUGenInternal::HPFBankUGenInternal(UGen const& input, UGen const& freq, const int numChannels) throw()
+:	SOSBankBaseUGenInternal(NumInputs, numChannels, 1),
+	currentFreqs(new float[numChannels])
+{
+	inputs[Input] = input;
+	inputs[Freq] = freq;
+	
+	// the coefficients start at 0 and ramp to the first freq as HPFUGenInternal
+	for(int channel = 0; channel < numChannels; channel++)
+		currentFreqs[channel] = 0.f;
+}
+
+HPFBankUGenInternal::~HPFBankUGenInternal()
+{
+	delete [] currentFreqs;
+}
+
+int HPFBankUGenInternal::updateCoefficients(bool& shouldDelete, const unsigned int blockID, const int channel, const int numSamples) throw()
+{
+	// as HPFUGenInternal except that the output is a0 * y0 + a1 * y1 + a2 * y2 as SOS
+	double piOverSampleRate = UGen::getReciprocalSampleRate() * pi;
+	float* freqSamples = inputs[Freq].processBlock(shouldDelete, blockID, channel);
+	float newFreq = *freqSamples;
+	
+	if(newFreq != currentFreqs[channel])
+	{
+		float pfreq = (float)(max(0.01f, newFreq) * piOverSampleRate);
+		
+		float C = tan(pfreq);
+		float C2 = C * C;
+		float sqrt2C = (float)(C * sqrt2);
+		
+		float next_a0 = 1.f / (1.f + sqrt2C + C2);
+		float next_b1 = 2.f * (1.f - C2) * next_a0 ;
+		float next_b2 = -(1.f - sqrt2C + C2) * next_a0;
+		
+		rampCoefficients(channel, 0, numSamples, next_a0, -2.f * next_a0, next_a0, next_b1, next_b2);
+		
+		currentFreqs[channel] = newFreq;
+		return Ramp;
+	}
+	
+	return Constant;
+}
+
 HPF::HPF(UGen const& input, UGen const& freq) throw()
 {
 	int numChannels = 1;
@@ -127,9 +172,16 @@ HPF::HPF(UGen const& input, UGen const& freq) throw()
 	
 	initInternal(numChannels);
 	
-	for(unsigned int i = 0; i < numInternalUGens; i++)
+	if(SOSBankBaseUGenInternal::shouldUseBank(numChannels))
+	{
+		generateFromProxyOwner(new HPFBankUGenInternal(input, freq, numChannels));
+	}
+	else
 	{
-		internalUGens[i] = new HPFUGenInternal(input, freq);
+		for(unsigned int i = 0; i < numInternalUGens; i++)
+		{
+			internalUGens[i] = new HPFUGenInternal(input, freq);
+		}
 	}
 }
 
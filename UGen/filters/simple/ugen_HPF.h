@@ -41,6 +41,7 @@
 
 #include "../../core/ugen_UGen.h"
 #include "../../basics/ugen_MulAdd.h"
+#include "../ugen_SOSBank.h"
 
 
 /** @ingroup UGenInternals */
@@ -57,6 +58,23 @@ protected:
 	float y1, y2, a0, b1, b2, currentFreq;
 };
 
+/** Filters many channels as HPF in a single pass, @see SOSBankBaseUGenInternal. 
+ @ingroup UGenInternals */
+class HPFBankUGenInternal : public SOSBankBaseUGenInternal
+{
+public:
+	HPFBankUGenInternal(UGen const& input, UGen const& freq, const int numChannels) throw();
+	~HPFBankUGenInternal();
+	
+	enum Inputs { Input, Freq, NumInputs };
+	
+protected:
+	int updateCoefficients(bool& shouldDelete, const unsigned int blockID, const int channel, const int numSamples) throw();
+	
+private:
+	float* const currentFreqs;
+};
+
 #define HPF_Docs	@param input	The input source to filter.								\
 					@param freq		The cut-off frequency.
 
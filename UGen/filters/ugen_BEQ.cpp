@@ -170,6 +170,101 @@ void BEQBaseUGenInternal::initValue(const float value) throw()
 	y1 = y2 = checkedValue;
 }
 
+BEQBankUGenInternal::BEQBankUGenInternal(UGen const& input, UGenInternal** filters, const int numChannels, const int numSections) throw()
+:	SOSBankBaseUGenInternal(NumInputs, numChannels, numSections),
+	filters_(new BEQBaseUGenInternal*[numChannels]),
+	currentParams(new float[numChannels * 3]),
+	isRamping(new bool[numChannels])
+{
+	ugen_assert(numChannels > 0);
+	
+	inputs[Input] = input;
+	
+	for(int i = Freq; i < NumInputs; i++)
+	{
+		inputs[i] = filters[0]->getInput(i);
+	}
+	
+	for(int channel = 0; channel < numChannels; channel++)
+	{
+		filters_[channel] = static_cast<BEQBaseUGenInternal*> (filters[channel]);
+		
+		float coeffs[5];
+		filters_[channel]->getCoeffs(coeffs);
+		
+		for(int section = 0; section < numSections; section++)
+			setCoefficients(channel, section, coeffs[0], coeffs[1], coeffs[2], coeffs[3], coeffs[4]);
+		
+		float* params = currentParams + channel * 3;
+		params[0] = inputs[Freq].getValue(channel);
+		params[1] = inputs[Control].getValue(channel);
+		params[2] = inputs[Gain].getValue(channel);
+		isRamping[channel] = false;
+		
+		initChannelValue(channel, input.getValue(channel));
+	}
+}
+
+BEQBankUGenInternal::~BEQBankUGenInternal()
+{
+	for(int channel = 0; channel < numChannels_; channel++)
+	{
+		filters_[channel]->decrementRefCount();
+	}
+	
+	delete [] filters_;
+	delete [] currentParams;
+	delete [] isRamping;
+}
+
+int BEQBankUGenInternal::updateCoefficients(bool& shouldDelete, const unsigned int blockID, const int channel, const int numSamples) throw()
+{
+	const float* freqSamples = inputs[Freq].processBlock(shouldDelete, blockID, channel);
+	const float* controlSamples = inputs[Control].processBlock(shouldDelete, blockID, channel);
+	const float* gainSamples = inputs[Gain].processBlock(shouldDelete, blockID, channel);
+	float* params = currentParams + channel * 3;
+	BEQBaseUGenInternal* filter = filters_[channel];
+	float coeffs[5];
+	
+	// the same test as BEQBaseUGenInternal::processBlock()
+	if((params[0] == freqSamples[0]) && (params[1] == controlSamples[0]) && (params[2] == gainSamples[0]))
+	{
+		if(isRamping[channel])
+		{
+			// land exactly on the coefficients for the last sample of the ramp
+			filter->getCoeffs(coeffs);
+			
+			for(int section = 0; section < numSections_; section++)
+				setCoefficients(channel, section, coeffs[0], coeffs[1], coeffs[2], coeffs[3], coeffs[4]);
+			
+			isRamping[channel] = false;
+		}
+		
+		return Constant;
+	}
+	
+	// start with the coefficients for the first sample and ramp to those for the last
+	filter->calculateCoeffs(freqSamples[0], controlSamples[0], gainSamples[0]);
+	filter->getCoeffs(coeffs);
+	
+	for(int section = 0; section < numSections_; section++)
+		setCoefficients(channel, section, coeffs[0], coeffs[1], coeffs[2], coeffs[3], coeffs[4]);
+	
+	const int last = numSamples - 1;
+	params[0] = freqSamples[last];
+	params[1] = controlSamples[last];
+	params[2] = gainSamples[last];
+	
+	filter->calculateCoeffs(params[0], params[1], params[2]);
+	filter->getCoeffs(coeffs);
+	
+	for(int section = 0; section < numSections_; section++)
+		rampCoefficients(channel, section, max(1, last), coeffs[0], coeffs[1], coeffs[2], coeffs[3], coeffs[4]);
+	
+	isRamping[channel] = true;
+	return Ramp;
+}
+
 BLowPassUGenInternal::BLowPassUGenInternal(UGen const& input, UGen const& freq, UGen const& rq) throw()
 :	BEQBaseUGenInternal(input, freq, rq, UGen::get0())
 {	
@@ -263,6 +358,9 @@ BLowPass::BLowPass(UGen const& input, UGen const& freq, UGen const& rq) throw()
 		filter->initValue(input.getValue(i));
 		internalUGens[i] = filter;
 	}
+	
+	if(SOSBankBaseUGenInternal::shouldUseBank(numInputChannels))
+		generateFromProxyOwner(new BEQBankUGenInternal(input, internalUGens, numInputChannels));
 }
 
 BLowPass4::BLowPass4(UGen const& input, UGen const& freq, UGen const& rq) throw()
@@ -271,15 +369,21 @@ BLowPass4::BLowPass4(UGen const& input, UGen const& freq, UGen const& rq) throw(
 	const int numInputChannels = findMaxInputChannels(numElementsInArray(inputs), inputs);
 	initInternal(numInputChannels);
 	
+	// the bank runs the two sections itself rather than each channel filtering another BEQ
+	const bool useBank = SOSBankBaseUGenInternal::shouldUseBank(numInputChannels);
+	
 	for(unsigned int i = 0; i < numInternalUGens; i++)
 	{
-		BEQBaseUGenInternal* filter = new BLowPassUGenInternal(BLowPass::AR(input, freq, rq), 
+		BEQBaseUGenInternal* filter = new BLowPassUGenInternal(useBank ? input : BLowPass::AR(input, freq, rq), 
 															   freq, 
 															   rq);
 		filter->calculateCoeffs(freq.getValue(i), rq.getValue(i), 1.f);
 		filter->initValue(input.getValue(i));
 		internalUGens[i] = filter;
 	}
+	
+	if(useBank)
+		generateFromProxyOwner(new BEQBankUGenInternal(input, internalUGens, numInputChannels, 2));
 }
 
 BHiPassUGenInternal::BHiPassUGenInternal(UGen const& input, UGen const& freq, UGen const& rq) throw()
@@ -323,6 +427,9 @@ BHiPass::BHiPass(UGen const& input, UGen const& freq, UGen const& rq) throw()
 		filter->initValue(input.getValue(i));
 		internalUGens[i] = filter;
 	}
+	
+	if(SOSBankBaseUGenInternal::shouldUseBank(numInputChannels))
+		generateFromProxyOwner(new BEQBankUGenInternal(input, internalUGens, numInputChannels));
 }
 
 BHiPass4::BHiPass4(UGen const& input, UGen const& freq, UGen const& rq) throw()
@@ -331,15 +438,21 @@ BHiPass4::BHiPass4(UGen const& input, UGen const& freq, UGen const& rq) throw()
 	const int numInputChannels = findMaxInputChannels(numElementsInArray(inputs), inputs);
 	initInternal(numInputChannels);
 	
+	// the bank runs the two sections itself rather than each channel filtering another BEQ
+	const bool useBank = SOSBankBaseUGenInternal::shouldUseBank(numInputChannels);
+	
 	for(unsigned int i = 0; i < numInternalUGens; i++)
 	{
-		BEQBaseUGenInternal* filter = new BHiPassUGenInternal(BHiPass::AR(input, freq, rq), 
+		BEQBaseUGenInternal* filter = new BHiPassUGenInternal(useBank ? input : BHiPass::AR(input, freq, rq), 
 												   freq, 
 												   rq);
 		filter->calculateCoeffs(freq.getValue(i), rq.getValue(i), 1.f);
 		filter->initValue(input.getValue(i));
 		internalUGens[i] = filter;
 	}
+	
+	if(useBank)
+		generateFromProxyOwner(new BEQBankUGenInternal(input, internalUGens, numInputChannels, 2));
 }
 
 BBandPassUGenInternal::BBandPassUGenInternal(UGen const& input, UGen const& freq, UGen const& bw) throw()
@@ -382,6 +495,9 @@ BBandPass::BBandPass(UGen const& input, UGen const& freq, UGen const& bw) throw(
 		filter->initValue(input.getValue(i));
 		internalUGens[i] = filter;
 	}
+	
+	if(SOSBankBaseUGenInternal::shouldUseBank(numInputChannels))
+		generateFromProxyOwner(new BEQBankUGenInternal(input, internalUGens, numInputChannels));
 }
 
 BBandStopUGenInternal::BBandStopUGenInternal(UGen const& input, UGen const& freq, UGen const& bw) throw()
@@ -424,6 +540,9 @@ BBandStop::BBandStop(UGen const& input, UGen const& freq, UGen const& bw) throw(
 		filter->initValue(input.getValue(i));
 		internalUGens[i] = filter;
 	}
+	
+	if(SOSBankBaseUGenInternal::shouldUseBank(numInputChannels))
+		generateFromProxyOwner(new BEQBankUGenInternal(input, internalUGens, numInputChannels));
 }
 
 BPeakEQUGenInternal::BPeakEQUGenInternal(UGen const& input, UGen const& freq, UGen const& rq, UGen const& gain) throw()
@@ -467,6 +586,9 @@ BPeakEQ::BPeakEQ(UGen const& input, UGen const& freq, UGen const& rq, UGen const
 		filter->initValue(input.getValue(i) * gain.getValue(i));
 		internalUGens[i] = filter;
 	}
+	
+	if(SOSBankBaseUGenInternal::shouldUseBank(numInputChannels))
+		generateFromProxyOwner(new BEQBankUGenInternal(input, internalUGens, numInputChannels));
 }
 
 BLowShelfUGenInternal::BLowShelfUGenInternal(UGen const& input, UGen const& freq, UGen const& rs, UGen const& gain) throw()
@@ -517,6 +639,9 @@ BLowShelf::BLowShelf(UGen const& input, UGen const& freq, UGen const& rs, UGen c
 		filter->initValue(input.getValue(i) * gain.getValue(i));
 		internalUGens[i] = filter;
 	}
+	
+	if(SOSBankBaseUGenInternal::shouldUseBank(numInputChannels))
+		generateFromProxyOwner(new BEQBankUGenInternal(input, internalUGens, numInputChannels));
 }
 
 BHiShelfUGenInternal::BHiShelfUGenInternal(UGen const& input, UGen const& freq, UGen const& rs, UGen const& gain) throw()
@@ -567,6 +692,9 @@ BHiShelf::BHiShelf(UGen const& input, UGen const& freq, UGen const& rs, UGen con
 		filter->initValue(input.getValue(i) * gain.getValue(i));
 		internalUGens[i] = filter;
 	}
+	
+	if(SOSBankBaseUGenInternal::shouldUseBank(numInputChannels))
+		generateFromProxyOwner(new BEQBankUGenInternal(input, internalUGens, numInputChannels));
 }
 
 BAllPassUGenInternal::BAllPassUGenInternal(UGen const& input, UGen const& freq, UGen const& rq) throw()
@@ -608,6 +736,9 @@ BAllPass::BAllPass(UGen const& input, UGen const& freq, UGen const& rq) throw()
 		filter->initValue(input.getValue(i));
 		internalUGens[i] = filter;
 	}
+	
+	if(SOSBankBaseUGenInternal::shouldUseBank(numInputChannels))
+		generateFromProxyOwner(new BEQBankUGenInternal(input, internalUGens, numInputChannels));
 }
 
 
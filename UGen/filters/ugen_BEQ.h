@@ -41,6 +41,7 @@
 
 #include "../core/ugen_UGen.h"
 #include "../basics/ugen_MulAdd.h"
+#include "ugen_SOSBank.h"
 
 #define BEQ_COEFF_TYPE float
 #define BEQ_CALC_TYPE float
@@ -63,11 +64,42 @@ public:
 		
 	void initValue(const float value) throw();
 	
+	/** Get the coefficients from the last calculateCoeffs() as a0, a1, a2, b1, b2. */
+	void getCoeffs(float* coeffs) const throw()
+	{
+		coeffs[0] = (float)a0; coeffs[1] = (float)a1; coeffs[2] = (float)a2; coeffs[3] = (float)b1; coeffs[4] = (float)b2;
+	}
+	
 protected:
 	BEQ_COEFF_TYPE y1, y2, a0, a1, a2, b1, b2;
 	float currentFreq, currentControl, currentGain;	
 };
 
+/**
+ Filters many channels with one of the BEQ designs in a single pass, @see SOSBankBaseUGenInternal.
+ 
+ The coefficients are calculated by the per-channel BEQ internals which would otherwise have 
+ been used (the bank takes ownership of these). When a channel's parameters change the coefficients
+ are calculated for the first and last samples of the block and ramped linearly between these 
+ rather than calculated for every sample. All sections use the same coefficients (e.g., 2 for BLowPass4). 
+ @ingroup UGenInternals */
+class BEQBankUGenInternal : public SOSBankBaseUGenInternal
+{
+public:
+	BEQBankUGenInternal(UGen const& input, UGenInternal** filters, const int numChannels, const int numSections = 1) throw();
+	~BEQBankUGenInternal();
+	
+	enum Inputs { Input, Freq, Control, Gain, NumInputs };
+	
+protected:
+	int updateCoefficients(bool& shouldDelete, const unsigned int blockID, const int channel, const int numSamples) throw();
+	
+private:
+	BEQBaseUGenInternal** const filters_;
+	float* const currentParams; // freq, control and gain for each channel
+	bool* const isRamping;
+};
+
 /**
  Low pass filter internal. @ingroup UGenInternals
  */
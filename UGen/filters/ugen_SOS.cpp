@@ -42,6 +42,7 @@
 BEGIN_UGEN_NAMESPACE
 
 #include "ugen_SOS.h"
+#include "ugen_SOSBank.h"
 #include "../core/ugen_Constants.h"
 #include "../basics/ugen_InlineUnaryOps.h"
 #include "../basics/ugen_InlineBinaryOps.h"
@@ -106,10 +107,22 @@ SOS::SOS(SOS_InputsWithTypesOnly) throw()
 	const int numInputChannels = findMaxInputChannels(numElementsInArray(inputs), inputs);		
 	initInternal(numInputChannels);
 	
-	for(unsigned int i = 0; i < numInternalUGens; i++)
+	if(SOSBankBaseUGenInternal::shouldUseBank(numInputChannels))
 	{
-		internalUGens[i] = new SOSUGenInternal(SOS_InputsNoTypes);
-		internalUGens[i]->initValue(input.getValue(i) * a0.getValue(i)); // a0 is gain
+		SOSBankUGenInternal* bank = new SOSBankUGenInternal(SOS_InputsNoTypes, numInputChannels);
+		
+		for(int i = 0; i < numInputChannels; i++)
+			bank->initChannelValue(i, input.getValue(i) * a0.getValue(i)); // a0 is gain
+		
+		generateFromProxyOwner(bank);
+	}
+	else
+	{
+		for(unsigned int i = 0; i < numInternalUGens; i++)
+		{
+			internalUGens[i] = new SOSUGenInternal(SOS_InputsNoTypes);
+			internalUGens[i]->initValue(input.getValue(i) * a0.getValue(i)); // a0 is gain
+		}
 	}
 }
 
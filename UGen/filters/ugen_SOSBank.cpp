@@ -0,0 +1,473 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+
+#ifndef UGEN_NOEXTGPL
+
+#include "../core/ugen_StandardHeader.h"
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_SOSBank.h"
+#include "../basics/ugen_InlineUnaryOps.h"
+#include "../basics/ugen_InlineBinaryOps.h"
+
+#ifdef UGEN_SIMD
+	#include "../vec/ugen_simd_Utilities.h"
+#endif
+
+/** Run second order sections over interleaved lanes in place, @see SIMD::biquadLanes() */
+static void sosBankProcessLanes(float *samples, const int numFrames, const int numLanes, 
+								float *coeffs, const float *slopes, const int coeffFrameStride, 
+								float *state) throw()
+{
+#if defined(UGEN_SIMD)
+	SIMD::biquadLanes(samples, numFrames, numLanes, coeffs, slopes, coeffFrameStride, state);
+#else
+	for(int lane = 0; lane < numLanes; lane++)
+	{
+		float *frame = samples + lane;
+		float *laneCoeffs = coeffs + lane;
+		float y1 = state[lane];
+		float y2 = state[numLanes + lane];
+		float a0 = laneCoeffs[0];
+		float a1 = laneCoeffs[numLanes];
+		float a2 = laneCoeffs[numLanes * 2];
+		float b1 = laneCoeffs[numLanes * 3];
+		float b2 = laneCoeffs[numLanes * 4];
+		
+		for(int i = 0; i < numFrames; i++)
+		{
+			if(coeffFrameStride != 0)
+			{
+				a0 = laneCoeffs[0];
+				a1 = laneCoeffs[numLanes];
+				a2 = laneCoeffs[numLanes * 2];
+				b1 = laneCoeffs[numLanes * 3];
+				b2 = laneCoeffs[numLanes * 4];
+				laneCoeffs += coeffFrameStride;
+			}
+			
+			const float y0 = *frame + b1 * y1 + b2 * y2;
+			*frame = a0 * y0 + a1 * y1 + a2 * y2;
+			y2 = y1;
+			y1 = y0;
+			frame += numLanes;
+			
+			if(coeffFrameStride == 0 && slopes != 0)
+			{
+				a0 += slopes[lane];
+				a1 += slopes[numLanes + lane];
+				a2 += slopes[numLanes * 2 + lane];
+				b1 += slopes[numLanes * 3 + lane];
+				b2 += slopes[numLanes * 4 + lane];
+			}
+		}
+		
+		if(coeffFrameStride == 0 && slopes != 0)
+		{
+			laneCoeffs[0] = a0;
+			laneCoeffs[numLanes] = a1;
+			laneCoeffs[numLanes * 2] = a2;
+			laneCoeffs[numLanes * 3] = b1;
+			laneCoeffs[numLanes * 4] = b2;
+		}
+		
+		state[lane] = y1;
+		state[numLanes + lane] = y2;
+	}
+#endif
+}
+
+SOSBankBaseUGenInternal::SOSBankBaseUGenInternal(const int numInputs, 
+												 const int numChannels, 
+												 const int numSections, 
+												 const bool usesCoefficientSamples) throw()
+:	ProxyOwnerUGenInternal(numInputs, numChannels - 1),
+	numChannels_(numChannels),
+	numSections_(numSections),
+	numLanes(quantiseUp(numChannels, LaneMultiple)),
+	usesCoefficientSamples_(usesCoefficientSamples),
+	coeffs(new float[numSections * numLanes * 5]),
+	slopes(new float[numSections * numLanes * 5]),
+	state(new float[numSections * numLanes * 2]),
+	coefficientSamples(new const float*[numChannels * 5]),
+	laneSamples(0),
+	laneCoefficients(0),
+	laneBlockSize(0)
+{
+	ugen_assert(numChannels > 0);
+	ugen_assert(numSections > 0);
+	ugen_assert(usesCoefficientSamples == false || numSections == 1);
+	
+	// the padding lanes stay at zero
+	memset(coeffs, 0, numSections * numLanes * 5 * sizeof(float));
+	memset(slopes, 0, numSections * numLanes * 5 * sizeof(float));
+	memset(state, 0, numSections * numLanes * 2 * sizeof(float));
+	memset(coefficientSamples, 0, numChannels * 5 * sizeof(const float*));
+}
+
+SOSBankBaseUGenInternal::~SOSBankBaseUGenInternal()
+{
+	delete [] coeffs;
+	delete [] slopes;
+	delete [] state;
+	delete [] coefficientSamples;
+	delete [] laneSamples;
+	delete [] laneCoefficients;
+}
+
+bool SOSBankBaseUGenInternal::shouldUseBank(const int numChannels) throw()
+{
+#if defined(UGEN_SIMD)
+	return numChannels >= MinimumChannels;
+#else
+	(void)numChannels;
+	return false;
+#endif
+}
+
+int SOSBankBaseUGenInternal::getIndex(const int channel, const int section, const int value, const int numValues) const throw()
+{
+	// within a section each tile's values are together so they can be passed straight to sosBankProcessLanes()
+	const int firstLane = channel / TileLanes * TileLanes;
+	const int numTileLanes = min((int)TileLanes, numLanes - firstLane);
+	return (section * numLanes + firstLane) * numValues + value * numTileLanes + channel - firstLane;
+}
+
+void SOSBankBaseUGenInternal::initChannelValue(const int channel, const float value) throw()
+{
+	const float checkedValue = zap(value);
+	proxies[channel]->initValue(checkedValue);
+	
+	for(int section = 0; section < numSections_; section++)
+	{
+		state[getIndex(channel, section, 0, 2)] = checkedValue;
+		state[getIndex(channel, section, 1, 2)] = checkedValue;
+	}
+}
+
+void SOSBankBaseUGenInternal::setCoefficients(const int channel, const int section, 
+											  const float a0, const float a1, const float a2, const float b1, const float b2) throw()
+{
+	const float values[] = { a0, a1, a2, b1, b2 };
+	
+	for(int i = 0; i < 5; i++)
+	{
+		const int index = getIndex(channel, section, i, 5);
+		coeffs[index] = values[i];
+		slopes[index] = 0.f;
+	}
+}
+
+void SOSBankBaseUGenInternal::rampCoefficients(const int channel, const int section, const int numSamples, 
+											   const float a0, const float a1, const float a2, const float b1, const float b2) throw()
+{
+	const float values[] = { a0, a1, a2, b1, b2 };
+	const float slope = 1.f / numSamples;
+	
+	for(int i = 0; i < 5; i++)
+	{
+		const int index = getIndex(channel, section, i, 5);
+		slopes[index] = (values[i] - coeffs[index]) * slope;
+	}
+}
+
+void SOSBankBaseUGenInternal::setCoefficientSamples(const int channel, 
+													const float* a0Samples, const float* a1Samples, const float* a2Samples, 
+													const float* b1Samples, const float* b2Samples) throw()
+{
+	ugen_assert(usesCoefficientSamples_);
+	
+	const float** channelSamples = coefficientSamples + channel * 5;
+	channelSamples[0] = a0Samples;
+	channelSamples[1] = a1Samples;
+	channelSamples[2] = a2Samples;
+	channelSamples[3] = b1Samples;
+	channelSamples[4] = b2Samples;
+}
+
+void SOSBankBaseUGenInternal::prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int /*channel*/) throw()
+{
+	// all channels of the inputs are needed by the owner
+	for(unsigned int i = 0; i < numInputs_; i++)
+		inputs[i].prepareForBlock(actualBlockSize, blockID, -1);
+	
+	const int blockSize = uGenOutput.getBlockSize();
+	
+	if(blockSize > laneBlockSize)
+	{
+		delete [] laneSamples;
+		delete [] laneCoefficients;
+		laneBlockSize = blockSize;
+		laneSamples = new float[laneBlockSize * TileLanes];
+		laneCoefficients = usesCoefficientSamples_ ? new float[laneBlockSize * TileLanes * 5] : 0;
+	}
+}
+
+void SOSBankBaseUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
+{
+	const int numSamplesToProcess = uGenOutput.getBlockSize();
+	const float* tileInputs[TileLanes];
+	float* tileOutputs[TileLanes];
+	
+	for(int firstLane = 0; firstLane < numChannels_; firstLane += TileLanes)
+	{
+		const int numTileLanes = min((int)TileLanes, numLanes - firstLane);
+		const int numTileChannels = min((int)TileLanes, numChannels_ - firstLane);
+		int mode = Constant;
+		
+		for(int lane = 0; lane < numTileChannels; lane++)
+		{
+			const int channel = firstLane + lane;
+			tileInputs[lane] = inputs[Input].processBlock(shouldDelete, blockID, channel);
+			mode = max(mode, updateCoefficients(shouldDelete, blockID, channel, numSamplesToProcess));
+		}
+		
+		// interleave a frame at a time so the writes are sequential
+		for(int i = 0; i < numSamplesToProcess; i++)
+		{
+			float* frame = laneSamples + i * numTileLanes;
+			int lane = 0;
+			
+			for(; lane < numTileChannels; lane++)
+				frame[lane] = tileInputs[lane][i];
+			
+			for(; lane < numTileLanes; lane++)
+				frame[lane] = 0.f;
+		}
+		
+		if(mode == PerSample)
+		{
+			// gather every coefficient of every frame, constant channels are repeated
+			const int frameStride = numTileLanes * 5;
+			
+			for(int lane = 0; lane < numTileLanes; lane++)
+			{
+				const int channel = firstLane + lane;
+				
+				for(int value = 0; value < 5; value++)
+				{
+					const float* samples = (lane < numTileChannels) ? coefficientSamples[channel * 5 + value] : 0;
+					float* frame = laneCoefficients + value * numTileLanes + lane;
+					
+					if(samples != 0)
+					{
+						for(int i = 0; i < numSamplesToProcess; i++, frame += frameStride)
+							*frame = samples[i];
+					}
+					else
+					{
+						const float coeff = coeffs[(firstLane * 5) + value * numTileLanes + lane];
+						
+						for(int i = 0; i < numSamplesToProcess; i++, frame += frameStride)
+							*frame = coeff;
+					}
+				}
+			}
+			
+			sosBankProcessLanes(laneSamples, numSamplesToProcess, numTileLanes, 
+								laneCoefficients, 0, frameStride, 
+								state + firstLane * 2);
+			
+			memset(coefficientSamples + firstLane * 5, 0, numTileChannels * 5 * sizeof(const float*));
+		}
+		else
+		{
+			for(int section = 0; section < numSections_; section++)
+			{
+				const int coeffOffset = (section * numLanes + firstLane) * 5;
+				
+				sosBankProcessLanes(laneSamples, numSamplesToProcess, numTileLanes, 
+									coeffs + coeffOffset, (mode == Ramp) ? slopes + coeffOffset : 0, 0,
+									state + (section * numLanes + firstLane) * 2);
+				
+				if(mode == Ramp)
+					memset(slopes + coeffOffset, 0, numTileLanes * 5 * sizeof(float));
+			}
+		}
+		
+		for(int lane = 0; lane < numTileChannels; lane++)
+			tileOutputs[lane] = proxies[firstLane + lane]->getSampleData();
+		
+		for(int i = 0; i < numSamplesToProcess; i++)
+		{
+			const float* frame = laneSamples + i * numTileLanes;
+			
+			for(int lane = 0; lane < numTileChannels; lane++)
+				tileOutputs[lane][i] = frame[lane];
+		}
+		
+		for(int section = 0; section < numSections_; section++)
+		{
+			float* tileState = state + (section * numLanes + firstLane) * 2;
+			
+			for(int i = 0; i < numTileLanes * 2; i++)
+				tileState[i] = zap(tileState[i]);
+		}
+	}
+}
+
+void SOSBankBaseUGenInternal::addDependencies(UGenDependencies& dependencies, const int /*channel*/) throw()
+{
+	for(unsigned int i = 0; i < numInputs_; i++)
+	{
+		for(int channel = 0; channel < numChannels_; channel++)
+			dependencies.add(inputs[i], channel);
+	}
+}
+
+SOSBankUGenInternal::SOSBankUGenInternal(SOS_InputsWithTypesOnly, const int numChannels) throw()
+:	SOSBankBaseUGenInternal(NumInputs, numChannels, 1, true),
+	scalarCoefficients(new bool[numChannels])
+{
+	UGen inputArgs[] = { SOS_InputsNoTypes };
+	
+	for(int i = 0; i < NumInputs; i++)
+	{
+		inputs[i] = inputArgs[i];
+	}
+	
+	for(int channel = 0; channel < numChannels; channel++)
+	{
+		bool isScalar = true;
+		
+		for(int i = A0; i <= B2; i++)
+			isScalar = isScalar && inputs[i].isScalar(channel % inputs[i].getNumChannels());
+		
+		scalarCoefficients[channel] = isScalar;
+	}
+}
+
+SOSBankUGenInternal::~SOSBankUGenInternal()
+{
+	delete [] scalarCoefficients;
+}
+
+int SOSBankUGenInternal::updateCoefficients(bool& shouldDelete, const unsigned int blockID, const int channel, const int numSamples) throw()
+{
+	const float* coeffSamples[5];
+	bool isConstant = true;
+	
+	for(int i = 0; i < 5; i++)
+	{
+		const float* samples = inputs[A0 + i].processBlock(shouldDelete, blockID, channel);
+		coeffSamples[i] = samples;
+		
+		if(isConstant && !scalarCoefficients[channel])
+		{
+			const float first = samples[0];
+			
+			for(int j = 1; j < numSamples; j++)
+			{
+				if(samples[j] != first)
+				{
+					isConstant = false;
+					break;
+				}
+			}
+		}
+	}
+	
+	if(isConstant)
+	{
+		setCoefficients(channel, 0, coeffSamples[0][0], coeffSamples[1][0], coeffSamples[2][0], coeffSamples[3][0], coeffSamples[4][0]);
+		return Constant;
+	}
+	
+	setCoefficientSamples(channel, coeffSamples[0], coeffSamples[1], coeffSamples[2], coeffSamples[3], coeffSamples[4]);
+	return PerSample;
+}
+
+SOSCascadeUGenInternal::SOSCascadeUGenInternal(UGen const& input, Buffer const& coefficients, const int numChannels) throw()
+:	SOSBankBaseUGenInternal(NumInputs, numChannels, max(1, coefficients.size() / 5)),
+	coefficients_(coefficients),
+	isRamping(false)
+{
+	inputs[Input] = input;
+	
+	for(int channel = 0; channel < numChannels_; channel++)
+	{
+		const float* channelCoeffs = coefficients_.getDataReadOnly(channel);
+		
+		for(int section = 0; section < numSections_ && (section * 5 + 5) <= coefficients_.size(); section++)
+		{
+			const float* sectionCoeffs = channelCoeffs + section * 5;
+			setCoefficients(channel, section, sectionCoeffs[0], sectionCoeffs[1], sectionCoeffs[2], sectionCoeffs[3], sectionCoeffs[4]);
+		}
+	}
+}
+
+void SOSCascadeUGenInternal::handleBuffer(Buffer const& buffer, const double value1, const int value2)
+{
+	if(buffer.size() == numSections_ * 5 && buffer.getNumChannels() > 0)
+		AtomicBufferReceiver::handleBuffer(buffer, value1, value2);
+}
+
+void SOSCascadeUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw()
+{
+	isRamping = acquireBuffer(coefficients_);
+	SOSBankBaseUGenInternal::processBlock(shouldDelete, blockID, channel);
+	isRamping = false;
+}
+
+int SOSCascadeUGenInternal::updateCoefficients(bool& /*shouldDelete*/, const unsigned int /*blockID*/, const int channel, const int numSamples) throw()
+{
+	if(isRamping == false)
+		return Constant;
+	
+	const float* channelCoeffs = coefficients_.getDataReadOnly(channel);
+	
+	for(int section = 0; section < numSections_; section++)
+	{
+		const float* sectionCoeffs = channelCoeffs + section * 5;
+		rampCoefficients(channel, section, numSamples, sectionCoeffs[0], sectionCoeffs[1], sectionCoeffs[2], sectionCoeffs[3], sectionCoeffs[4]);
+	}
+	
+	return Ramp;
+}
+
+SOSCascade::SOSCascade(UGen const& input, Buffer const& coefficients) throw()
+{
+	const int numChannels = ugen::max(input.getNumChannels(), coefficients.getNumChannels());
+	initInternal(numChannels);
+	generateFromProxyOwner(new SOSCascadeUGenInternal(input, coefficients, numChannels));
+}
+
+END_UGEN_NAMESPACE
+
+#endif // gpl
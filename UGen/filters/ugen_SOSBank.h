@@ -0,0 +1,191 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+
+#ifndef _UGEN_ugen_SOSBank_H_
+#define _UGEN_ugen_SOSBank_H_
+
+
+#include "../core/ugen_UGen.h"
+#include "../basics/ugen_MulAdd.h"
+#include "../buffers/ugen_Buffer.h"
+#include "ugen_SOS.h"
+
+
+/** Filters many channels through one or more cascaded second order sections in a single pass.
+ 
+ Multichannel filters (SOS, the BEQ family, LPF and HPF) use one of these rather than one 
+ internal per channel when they have enough channels (see shouldUseBank()). The channels are 
+ processed in tiles of up to 16 where each channel is a lane of the vectors: the tile's input 
+ is interleaved, run through each section in turn (see SIMD::biquadLanes()) then de-interleaved 
+ to the outputs. 
+ 
+ Subclasses supply each channel's coefficients for the block in updateCoefficients() using 
+ setCoefficients() (constant), rampCoefficients() (moved linearly over the block as LPF does) 
+ or setCoefficientSamples() (per-sample, single section banks only). The whole tile uses the 
+ most general of these but constant channels are unaffected by the ramp (their slopes are 0).
+ 
+ The input to filter must be the subclass's first input. 
+ @ingroup UGenInternals */
+class SOSBankBaseUGenInternal : public ProxyOwnerUGenInternal
+{
+public:
+	SOSBankBaseUGenInternal(const int numInputs, 
+							const int numChannels, 
+							const int numSections, 
+							const bool usesCoefficientSamples = false) throw();
+	~SOSBankBaseUGenInternal();
+	
+	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
+	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	void addDependencies(UGenDependencies& dependencies, const int channel) throw(); // all channels are processed together
+	
+	/** Set the initial output of a channel and the y1 and y2 of each of its sections, as SOSUGenInternal::initValue(). */
+	void initChannelValue(const int channel, const float value) throw();
+	
+	enum Inputs { Input };
+	enum CoefficientModes { Constant, Ramp, PerSample };
+	enum Lanes { TileLanes = 16, LaneMultiple = 8, MinimumChannels = 4 };
+	
+	/** Returns true if a filter with this many channels should use a bank rather than an internal per channel.
+	 This is only the case when UGEN_SIMD is defined. */
+	static bool shouldUseBank(const int numChannels) throw();
+	
+protected:
+	/** Update the coefficients of a channel for this block, pulling any inputs other than Input.
+	 @return Constant if the coefficients are unchanged or were set using setCoefficients(), 
+			 Ramp if rampCoefficients() was used or PerSample if setCoefficientSamples() was used. */
+	virtual int updateCoefficients(bool& shouldDelete, const unsigned int blockID, const int channel, const int numSamples) throw() = 0;
+	
+	/** Set the coefficients of a section, as SOS. */
+	void setCoefficients(const int channel, const int section, 
+						 const float a0, const float a1, const float a2, const float b1, const float b2) throw();
+	
+	/** Move the coefficients of a section linearly to these values over the next numSamples samples. */
+	void rampCoefficients(const int channel, const int section, const int numSamples, 
+						  const float a0, const float a1, const float a2, const float b1, const float b2) throw();
+	
+	/** Use per-sample coefficients for this block, these must remain valid until the block is processed.
+	 The constructor's usesCoefficientSamples argument must have been true. */
+	void setCoefficientSamples(const int channel, 
+							   const float* a0Samples, const float* a1Samples, const float* a2Samples, 
+							   const float* b1Samples, const float* b2Samples) throw();
+	
+	const int numChannels_;
+	const int numSections_;
+	
+private:
+	int getIndex(const int channel, const int section, const int value, const int numValues) const throw();
+	
+	const int numLanes;
+	const bool usesCoefficientSamples_;
+	float* const coeffs;
+	float* const slopes;
+	float* const state;
+	const float** const coefficientSamples;
+	float* laneSamples;
+	float* laneCoefficients;
+	int laneBlockSize;
+};
+
+/** A bank of single SOS sections with coefficient inputs, @see SOS.
+ Coefficients are constant for a block if their inputs are scalar or don't change over the block,
+ otherwise they are applied per sample exactly as SOSUGenInternal does.
+ @ingroup UGenInternals */
+class SOSBankUGenInternal : public SOSBankBaseUGenInternal
+{
+public:
+	SOSBankUGenInternal(SOS_InputsWithTypesAndDefaults, const int numChannels) throw();
+	~SOSBankUGenInternal();
+	
+	enum Inputs { SOS_InputsEnum, NumInputs };
+	
+protected:
+	int updateCoefficients(bool& shouldDelete, const unsigned int blockID, const int channel, const int numSamples) throw();
+	
+private:
+	bool* const scalarCoefficients;
+};
+
+/** A bank of cascaded SOS sections with coefficients from a Buffer, @see SOSCascade.
+ A new coefficient Buffer may be sent using handleBuffer() (e.g., from a BufferSender on another 
+ thread), the coefficients move to their new values over the next block.
+ @ingroup UGenInternals */
+class SOSCascadeUGenInternal :	public SOSBankBaseUGenInternal,
+								public AtomicBufferReceiver
+{
+public:
+	SOSCascadeUGenInternal(UGen const& input, Buffer const& coefficients, const int numChannels) throw();
+	
+	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	
+	/** Publish new coefficients, Buffers of a different size (i.e., number of sections) are ignored. */
+	void handleBuffer(Buffer const& buffer, const double value1, const int value2);
+	
+	enum Inputs { Input, NumInputs };
+	
+protected:
+	int updateCoefficients(bool& shouldDelete, const unsigned int blockID, const int channel, const int numSamples) throw();
+	
+private:
+	Buffer coefficients_;
+	bool isRamping;
+};
+
+#define SOSCascade_Docs	@param input		The input source to filter.											\
+						@param coefficients	The coefficients of each section in turn (a0, a1, a2, b1, b2 as SOS)	\
+											so the size is five times the number of sections. Output channel	\
+											n uses the coefficients in channel n of the Buffer (wrapping		\
+											around if there are fewer channels in the Buffer).
+
+/** A chain of second order filter sections in a single UGen.
+ 
+ This runs long EQ chains (e.g., designed offline) on many channels in a single pass, the 
+ channels are processed together using SIMD when UGEN_SIMD is defined. Send new coefficients 
+ using a BufferSender (see UGen::addBufferReceiver()), they are ramped over one block.
+ 
+ @ingroup AllUGens FilterUGens
+ @see SOS, SOSBankBaseUGenInternal
+ */
+DirectMulAddUGenDeclaration(SOSCascade,	(input, coefficients), 
+										(input, coefficients, MulAdd_ArgsCall), 
+										(UGen const& input, Buffer const& coefficients), 
+										(UGen const& input, Buffer const& coefficients, MulAdd_ArgsDeclare), 
+							COMMON_UGEN_DOCS SOSCascade_Docs MulAddArgs_Docs);
+
+
+#endif // _UGEN_ugen_SOSBank_H_
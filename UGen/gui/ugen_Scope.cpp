@@ -35,7 +35,7 @@
  ==============================================================================
  */
 
-#if !defined(WIN32) && !defined(UGEN_IPHONE) && !defined(UGEN_ANDROID)
+#if defined(__APPLE__) && !defined(UGEN_IPHONE) && !defined(UGEN_ANDROID)
 	#include <Accelerate/Accelerate.h>
 	#include <CoreServices/CoreServices.h>
 #endif
@@ -584,8 +584,22 @@ BufferSenderUGenInternal::BufferSenderUGenInternal(UGen const& input, UGen const
 	inputs[Duration] = duration;
 	
 	audioBufferSizeUsed = max(1, (int)(duration.getValue() * UGen::getSampleRate() + 0.5));
+	
+	if(audioBufferSizeUsed > audioBuffer.size())
+		audioBuffer = Buffer::withSize(audioBufferSizeUsed, input.getNumChannels(), true);
+	
+	initTelemetry(audioBuffer.getNumChannels(), audioBuffer.size());
 }
 
+BufferSenderUGenInternal::~BufferSenderUGenInternal()
+{
+	releaseTelemetry();
+}
+
+void BufferSenderUGenInternal::deleteUnreferenced() throw()
+{
+	retireTelemetry(this);
+}
 
 void BufferSenderUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
 {
@@ -595,9 +609,12 @@ void BufferSenderUGenInternal::processBlock(bool& shouldDelete, const unsigned i
 	
 	if(audioBufferSizeRequired > audioBufferAllocatedSize)
 	{
+		// the frames won't fit the ring's slots any more
+		initTelemetry(audioBuffer.getNumChannels(), audioBufferSizeRequired);
+		
 		if((audioBufferAllocatedSize > 1) && (bufferIndex >= audioBufferAllocatedSize))
 		{
-			sendBuffer(audioBuffer.getRegion(0, audioBufferAllocatedSize-1), samplesProcessed);
+			postTelemetry(audioBuffer, audioBufferAllocatedSize, samplesProcessed);
 		}
 		
 		audioBufferAllocatedSize = audioBufferSizeRequired;
@@ -607,24 +624,19 @@ void BufferSenderUGenInternal::processBlock(bool& shouldDelete, const unsigned i
 	}
 	else if(audioBufferSizeRequired < audioBufferAllocatedSize)
 	{
+		// the frames are copied to the ring so just use the start of the buffer
 		audioBufferSizeUsed = audioBufferSizeRequired;
 		
 		if(bufferIndex >= audioBufferSizeUsed)
 		{
-			if(audioBufferSizeUsed == audioBuffer.size())
-			{
-				sendBuffer(audioBuffer, samplesProcessed);
-			}
-			else
-			{
-				sendBuffer(audioBuffer.getRegion(0, audioBufferSizeUsed-1), samplesProcessed);
-				audioBufferAllocatedSize = audioBufferSizeRequired;
-				audioBuffer = Buffer::withSize(audioBufferAllocatedSize, inputs[Input].getNumChannels(), false);
-			}
-			
+			postTelemetry(audioBuffer, audioBufferSizeUsed, samplesProcessed);
 			bufferIndex = 0;
 		}
 	}
+	else
+	{
+		audioBufferSizeUsed = audioBufferSizeRequired;
+	}
 	
 	int numSamplesRemaining = uGenOutput.getBlockSize();
 	int offset = 0;
@@ -651,17 +663,7 @@ void BufferSenderUGenInternal::processBlock(bool& shouldDelete, const unsigned i
 		
 		if(bufferIndex >= audioBufferSizeUsed)
 		{
-			if(audioBufferSizeUsed == audioBuffer.size())
-			{
-				sendBuffer(audioBuffer, samplesProcessed);
-			}
-			else
-			{
-				sendBuffer(audioBuffer.getRegion(0, audioBufferSizeUsed-1), samplesProcessed);
-				audioBufferAllocatedSize = audioBufferSizeRequired;
-				audioBuffer = Buffer::withSize(audioBufferAllocatedSize, inputs[Input].getNumChannels(), false);
-			}			
-			
+			postTelemetry(audioBuffer, audioBufferSizeUsed, samplesProcessed);
 			bufferIndex = 0;
 		}	
 	}	
@@ -849,6 +851,18 @@ FFTSenderUGenInternal::FFTSenderUGenInternal(UGen const& input,
 //	ugen_assert(numBins == numBins_);	// should be in range	
 	
 	inputs[Input] = input;	
+	
+	initTelemetry(outputBuffer.getNumChannels(), fftSize);
+}
+
+FFTSenderUGenInternal::~FFTSenderUGenInternal()
+{
+	releaseTelemetry();
+}
+
+void FFTSenderUGenInternal::deleteUnreferenced() throw()
+{
+	retireTelemetry(this);
 }
 
 void FFTSenderUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
@@ -890,43 +904,8 @@ void FFTSenderUGenInternal::processBlock(bool& shouldDelete, const unsigned int
 			fftEngine.fft(outputBuffer, inputBuffer, true, channel, channel);
 		}
 		
-		switch(mode_)
-		{
-			case FFTEngine::RealImagRaw:
-				sendBuffer(outputBuffer, 0, fftSize);
-				break;
-			case FFTEngine::RealImagRawSplit:
-				sendBuffer(fftEngine.rawToRealImagRawSplit(outputBuffer),
-						   0, fftSize);
-				break;
-			case FFTEngine::RealImagUnpacked:
-				sendBuffer(fftEngine.rawToRealImagUnpacked(outputBuffer, firstBin_, numBins_),
-						   firstBin_, fftSize);
-				break;
-			case FFTEngine::RealImagUnpackedSplit:
-				sendBuffer(fftEngine.rawToRealImagUnpackedSplit(outputBuffer, firstBin_, numBins_),
-						   firstBin_, fftSize);
-				break;
-			case FFTEngine::MagnitudePhase:
-				sendBuffer(fftEngine.rawToMagnitudePhase(outputBuffer, firstBin_, numBins_),
-						   firstBin_, fftSize);
-				break;
-			case FFTEngine::MagnitudePhaseSplit:
-				sendBuffer(fftEngine.rawToMagnitudePhaseSplit(outputBuffer, firstBin_, numBins_),
-						   firstBin_, fftSize);
-				break;					
-			case FFTEngine::Magnitude: 
-				sendBuffer(fftEngine.rawToMagnitude(outputBuffer, firstBin_, numBins_),
-						   firstBin_, fftSize);
-				break;
-			case FFTEngine::Phase: 
-				sendBuffer(fftEngine.rawToPhase(outputBuffer, firstBin_, numBins_),
-						   firstBin_, fftSize);
-				break;
-			default:
-				sendBuffer(fftEngine.rawToMagnitude(outputBuffer, firstBin_, numBins_),
-						   firstBin_, fftSize);
-		}
+		// the spectrum is cooked and sent on the telemetry thread
+		postTelemetry(outputBuffer, fftSize);
 		
 		// keep overlapping samples for next FFT
 		if((overlap_ > 1) && (uGenOutput.getBlockSize() < fftSize))
@@ -945,6 +924,47 @@ void FFTSenderUGenInternal::processBlock(bool& shouldDelete, const unsigned int
 	}
 }
 
+void FFTSenderUGenInternal::handleTelemetry(Buffer const& frame, const double /*value1*/, const int /*value2*/) throw()
+{
+	switch(mode_)
+	{
+		case FFTEngine::RealImagRaw:
+			sendBuffer(frame, 0, fftSize);
+			break;
+		case FFTEngine::RealImagRawSplit:
+			sendBuffer(fftEngine.rawToRealImagRawSplit(frame),
+					   0, fftSize);
+			break;
+		case FFTEngine::RealImagUnpacked:
+			sendBuffer(fftEngine.rawToRealImagUnpacked(frame, firstBin_, numBins_),
+					   firstBin_, fftSize);
+			break;
+		case FFTEngine::RealImagUnpackedSplit:
+			sendBuffer(fftEngine.rawToRealImagUnpackedSplit(frame, firstBin_, numBins_),
+					   firstBin_, fftSize);
+			break;
+		case FFTEngine::MagnitudePhase:
+			sendBuffer(fftEngine.rawToMagnitudePhase(frame, firstBin_, numBins_),
+					   firstBin_, fftSize);
+			break;
+		case FFTEngine::MagnitudePhaseSplit:
+			sendBuffer(fftEngine.rawToMagnitudePhaseSplit(frame, firstBin_, numBins_),
+					   firstBin_, fftSize);
+			break;					
+		case FFTEngine::Magnitude: 
+			sendBuffer(fftEngine.rawToMagnitude(frame, firstBin_, numBins_),
+					   firstBin_, fftSize);
+			break;
+		case FFTEngine::Phase: 
+			sendBuffer(fftEngine.rawToPhase(frame, firstBin_, numBins_),
+					   firstBin_, fftSize);
+			break;
+		default:
+			sendBuffer(fftEngine.rawToMagnitude(frame, firstBin_, numBins_),
+					   firstBin_, fftSize);
+	}
+}
+
 FFTSender::FFTSender(UGen const& input, 
 					 FFTEngine::FFTModes mode,
 					 FFTEngine const& fft, 
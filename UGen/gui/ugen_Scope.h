@@ -42,6 +42,7 @@
 #include "../basics/ugen_InlineBinaryOps.h"
 #include "../fft/ugen_FFTEngine.h"
 #include "../core/ugen_Text.h"
+#include "../buffers/ugen_Telemetry.h"
 #include "ugen_GUI.h"
 	
 /** This is a wrapper/controller for a platform dependent GUI object.
@@ -266,10 +267,12 @@ protected:
 
 
 class BufferSenderUGenInternal :	public UGenInternal,
-									public BufferSender
+									public TelemetrySender
 {
 public:
 	BufferSenderUGenInternal(UGen const& input, UGen const& duration) throw();	
+	~BufferSenderUGenInternal();
+	void deleteUnreferenced() throw();
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
 	
 	enum Inputs { Input, Duration, NumInputs };
@@ -283,7 +286,8 @@ private:
 
 /** Collects samples and sends them as a Buffer to one or more receivers.
  This can be used to send data to a oscilloscope (e.g., ScopeComponent) or
- for other purposes (e.g., analysis). 
+ for other purposes (e.g., analysis). The audio thread only copies the samples,
+ the receivers are called on the TelemetryService thread.
  @see FFTSender */
 UGenSublcassDeclarationNoDefault(Sender, 
 								 (input, duration), 
@@ -326,8 +330,8 @@ UGenSublcassDeclarationNoDefault(Sender,
 //								  const int numBins = 0), COMMON_UGEN_DOCS);
 
 
-class FFTSenderUGenInternal :	public UGenInternal, // this SHOULDN'T be a ProxyOwner so that
-								public BufferSender	 // the number channels can be dynamic!
+class FFTSenderUGenInternal :	public UGenInternal,	// this SHOULDN'T be a ProxyOwner so that
+								public TelemetrySender	// the number channels can be dynamic!
 {
 public:
 	FFTSenderUGenInternal(UGen const& input, 
@@ -336,7 +340,10 @@ public:
 						  const int overlap,
 						  const int firstBin,
 						  const int numBins) throw();	
+	~FFTSenderUGenInternal();
+	void deleteUnreferenced() throw();
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	void handleTelemetry(Buffer const& frame, const double value1, const int value2) throw();
 	
 	enum Inputs { Input, NumInputs };
 	
@@ -351,9 +358,9 @@ private:
 /** Collects samples and performs and FFT before sending to one or more receivers.
  @param input	The audio input to apply the FFT to.
  @param mode	The data can be cooked in various ways using one of the FFTModes before it's sent. 
-				E.g., FFTEngine::Magnitude will just calculate the bin magnitudes. Using mode 
-				FFTEngine::RealImagRaw will use less allocation on the audio thread so you could
-				do the transformation.
+				E.g., FFTEngine::Magnitude will just calculate the bin magnitudes. The audio thread
+				only performs the FFT, the cooking happens on the TelemetryService thread before
+				the receivers are called.
  @param fft		The FFT size.
  @param overlap	The overlap factor for successive FFT frames.
  @param firstBin	The first bin reported in the cooked data sent (not used for modes
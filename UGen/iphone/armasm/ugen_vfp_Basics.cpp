@@ -102,6 +102,12 @@ void BoolPtrUGenInternal::processBlock(bool& shouldDelete, const unsigned int /*
 
 void MixUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
 {
+	if(shouldCompensate_)
+	{
+		processBlockCompensated(shouldDelete, blockID);
+		return;
+	}
+	
 	int channel = 0;
 	
 	bool shouldDeleteLocal = false;
@@ -110,7 +116,8 @@ void MixUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockI
 	float* const outputSamples = uGenOutput.getSampleData();
 	float* const channelSamples = inputs->processBlock(shouldDeleteToPass, blockID, channel);
 	
-	memcpy(outputSamples, channelSamples, numSamplesToProcess * sizeof(float));
+	if(channelSamples != outputSamples) // otherwise it was rendered in place
+		memcpy(outputSamples, channelSamples, numSamplesToProcess * sizeof(float));
 	
 	channel++;
 	
@@ -128,6 +135,12 @@ void MixUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockI
 
 void MixArrayUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
 {	
+	if(shouldCompensate_)
+	{
+		processBlockCompensated(shouldDelete, blockID);
+		return;
+	}
+	
 	bool shouldDeleteLocal;
 	bool& shouldDeleteToPass = shouldAllowAutoDelete_ ? shouldDelete : shouldDeleteLocal;	
 	const int numOutputChannels = getNumChannels();
@@ -366,6 +366,11 @@ public:
 		return event.spawnEvent(*this, eventCount, midiChannel, midiNote, velocity);
 	}
 	
+	~VoicerEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	VoicerEventType event;
 };
@@ -405,6 +410,11 @@ public:
 		return event.spawnEvent(*this, eventCount, midiChannel, midiNote, velocity);
 	}
 	
+	~VoicerEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	VoicerEventType event;
 };
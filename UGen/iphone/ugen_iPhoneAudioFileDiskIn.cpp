@@ -43,54 +43,25 @@ BEGIN_UGEN_NAMESPACE
 
 #include "ugen_iPhoneAudioFileDiskIn.h"
 #include "ugen_NSUtilities.h"
+#include "../basics/ugen_InlineBinaryOps.h"
 
-DiskInUGenInternal::DiskInUGenInternal(AudioFileID audioFile, 
-									   AudioStreamBasicDescription const& format, 
-									   const bool loopFlag, 
-									   const double startTime,
-									   const UGen::DoneAction doneAction) throw()
-:	ProxyOwnerUGenInternal(0, format.mChannelsPerFrame - 1),
-	audioFile_(audioFile),
-	numChannels_(format.mChannelsPerFrame),
-	loopFlag_(loopFlag),
-	startTime_(startTime),
-	packetCount(0),
-	currentPacket(0),
-	allocatedBlockSize(0),
-	audioData(0),
-	numPackets(0),
+static const int audioFileDiskStreamSourceChunkSize = 4096;
+
+AudioFileDiskStreamSource::AudioFileDiskStreamSource(AudioFileID audioFile, 
+													 AudioStreamBasicDescription const& format,
+													 const SInt64 packetCount_) throw()
+:	audioFile_(audioFile),
+	numChannels(format.mChannelsPerFrame),
+	packetCount(packetCount_),
 	bytesPerFrame(format.mBytesPerFrame),
 	fileSampleRate(format.mSampleRate),
-	reciprocalSampleRate(1.0/fileSampleRate),
-	doneAction_(doneAction),
-	shouldDeleteValue(doneAction_ == UGen::DeleteWhenDone)
+	conversion(getConversion(format)),
+	audioData(malloc(format.mBytesPerFrame * audioFileDiskStreamSourceChunkSize))
 {
-	OSStatus result;
-	UInt32 dataSize;
-	
-	if(audioFile_)
-	{
-		dataSize = sizeof(packetCount);
-		result = AudioFileGetProperty(audioFile, kAudioFilePropertyAudioDataPacketCount, &dataSize, &packetCount);
-		if (result != noErr) 
-		{
-			printf("DiskIn: error: Could not get packet count: ID=%p err=%d\n", audioFile_, (int)result);
-			AudioFileClose(audioFile_);
-			audioFile_ = 0;
-		}	
-		else
-		{
-			currentPacket = ugen::max(0.0, startTime) * fileSampleRate;
-			if(currentPacket >= packetCount)
-				currentPacket = 0;
-			
-			allocatedBlockSize = UGen::getEstimatedBlockSize();
-			audioData = malloc(bytesPerFrame * allocatedBlockSize);
-		}
-	}
+	ugen_assert(isFormatSupported(format));
 }
 
-DiskInUGenInternal::~DiskInUGenInternal() throw()
+AudioFileDiskStreamSource::~AudioFileDiskStreamSource()
 {
 	if(audioFile_)
 		AudioFileClose(audioFile_);
@@ -98,367 +69,162 @@ DiskInUGenInternal::~DiskInUGenInternal() throw()
 	free(audioData);
 }
 
-OSStatus DiskInUGenInternal::clearOutputsAndReadData(bool& shouldDelete) throw()
+bool AudioFileDiskStreamSource::isFormatSupported(AudioStreamBasicDescription const& format) throw()
 {
-	const int outputBlockSize = uGenOutput.getBlockSize();
-	const double sampeRateRatio = 1.0;//fileSampleRate * UGen::getReciprocalSampleRate();
+	if(format.mFormatID != kAudioFormatLinearPCM) 
+		return false;
 	
-	const int inputBlockSize = outputBlockSize * sampeRateRatio;
+	if((format.mFormatFlags & kAudioFormatFlagIsFloat) != 0)
+		return format.mBitsPerChannel == 32;
 	
-	if(inputBlockSize > allocatedBlockSize)
-	{
-		allocatedBlockSize = inputBlockSize;
-		audioData = realloc(audioData, bytesPerFrame * allocatedBlockSize);
-		if(!audioData)
-		{
-			printf("DiskIn: error: could not allocated memory for the new buffer size\n\n");
-			AudioFileClose(audioFile_);
-			audioFile_ = 0;
-		}
-	}
-	
-	for(int channel = 0; channel < numChannels_; channel++)
-	{
-		float *outputSamples = proxies[channel]->getSampleData();
-		memset(outputSamples, 0, outputBlockSize * sizeof(float));
-	}	
+	return (format.mBitsPerChannel == 16) || (format.mBitsPerChannel == 24) || (format.mBitsPerChannel == 32);
+}
+
+AudioFileDiskStreamSource::Conversion AudioFileDiskStreamSource::getConversion(AudioStreamBasicDescription const& format) throw()
+{
+	const bool isBigEndian = (format.mFormatFlags & kAudioFormatFlagIsBigEndian) != 0;
 	
-	if(!audioFile_)
-	{
-		numPackets = 0;
-		return -1;
-	}
+	if((format.mFormatFlags & kAudioFormatFlagIsFloat) != 0)
+		return isBigEndian ? FloatBigEndian : FloatLittleEndian;
+	else if(format.mBitsPerChannel == 16)
+		return isBigEndian ? Aiff16 : Wav16;
+	else if(format.mBitsPerChannel == 24)
+		return isBigEndian ? Aiff24 : Wav24;
 	else
+		return isBigEndian ? Aiff32 : Wav32;
+}
+
+int AudioFileDiskStreamSource::read(float* const* destinations, const long startFrame, const int numFrames) throw()
+{
+	if(!audioFile_ || !audioData || startFrame < 0 || startFrame >= packetCount) 
+		return 0;
+	
+	int numFramesDone = 0;
+	
+	while(numFramesDone < numFrames)
 	{
-		numPackets = inputBlockSize;
+		UInt32 numPackets = ugen::min(audioFileDiskStreamSourceChunkSize, numFrames - numFramesDone);
 		UInt32 numBytesRead = -1;
 		OSStatus result = AudioFileReadPackets(audioFile_, false,
 											   &numBytesRead, NULL, 
-											   currentPacket, &numPackets, audioData); 
+											   startFrame + numFramesDone, &numPackets, audioData); 
+		
+		if(result != noErr || numPackets == 0)
+			break;
 		
-		if(result == noErr)
-		{  
-			currentPacket += numPackets;
+		for(int channel = 0; channel < numChannels; channel++)
+		{
+			float *outputSamples = destinations[channel] + numFramesDone;
+			int numSamplesToProcess = numPackets;
 			
-			if(numPackets < inputBlockSize)
+			switch(conversion)
 			{
-				if(loopFlag_)
-				{
-					// we hit the end of the file and looping is on, we need to pull 
-					// a few samples from the start of the file
+				case Wav16: {
+					static const float factor = 1.0 / 0x7FFF;
+					SInt16* audioFileSamples = (SInt16*)audioData + channel;
+					
+					while(numSamplesToProcess--)
+					{
+						*outputSamples++ = (float)(*audioFileSamples) * factor;
+						audioFileSamples += numChannels;
+					}
+				} break;
+				case Aiff16: {
+					static const float factor = 1.0 / 0x7FFF;
+					SInt16* audioFileSamples = (SInt16*)audioData + channel;
 					
-					const int remainingPackets = inputBlockSize - numPackets;
+					while(numSamplesToProcess--)
+					{
+						*outputSamples++ = (float)bigEndian16Bit((const char*)audioFileSamples) * factor;
+						audioFileSamples += numChannels;
+					}
+				} break;
+				case Wav24: {
+					static const float factor = 1.0 / 0x7FFFFF;
+					const int intInc = numChannels * 3;
+					char* audioFileSamples = (char*)audioData + (channel * 3);
 					
-					unsigned char *remainingAudioData = (unsigned char*)audioData;
-					remainingAudioData += remainingPackets * bytesPerFrame;
+					while(numSamplesToProcess--)
+					{
+						*outputSamples++ = (float)littleEndian24Bit(audioFileSamples) * factor;
+						audioFileSamples += intInc;
+					}
+				} break;
+				case Aiff24: {
+					static const float factor = 1.0 / 0x7FFFFF;
+					const int intInc = numChannels * 3;
+					char* audioFileSamples = (char*)audioData + (channel * 3);
 					
-					numPackets = remainingPackets;
-					result = AudioFileReadPackets(audioFile_, false, 
-												  &numBytesRead, NULL, 
-												  0, &numPackets, audioData);
+					while(numSamplesToProcess--)
+					{
+						*outputSamples++ = (float)bigEndian24Bit(audioFileSamples) * factor;
+						audioFileSamples += intInc;
+					}
+				} break;
+				case Wav32: {
+					static const float factor = 1.0 / 0x7FFFFFFF;
+					SInt32* audioFileSamples = (SInt32*)audioData + channel;
 					
-					if(result == noErr)
-					{ 
-						currentPacket = remainingPackets;
+					while(numSamplesToProcess--)
+					{
+						*outputSamples++ = (float)(*audioFileSamples) * factor;
+						audioFileSamples += numChannels;
 					}
-				}
-				else
-				{
-					if(shouldDeleteValue)
-						setIsDone();
+				} break;
+				case Aiff32: {
+					static const float factor = 1.0 / 0x7FFFFFFF;
+					SInt32* audioFileSamples = (SInt32*)audioData + channel;
 					
-					shouldDelete = shouldDelete ? true : shouldDeleteValue;
-				}
+					while(numSamplesToProcess--)
+					{
+						*outputSamples++ = (float)bigEndian32Bit((const char*)audioFileSamples) * factor;
+						audioFileSamples += numChannels;
+					}
+				} break;
+				case FloatBigEndian: {
+					float* audioFileSamples = (float*)audioData + channel;
+					
+					while(numSamplesToProcess--)
+					{
+						*outputSamples++ = bigEndianFloat((const char*)audioFileSamples);
+						audioFileSamples += numChannels;
+					}
+				} break;
+				case FloatLittleEndian: {
+					float* audioFileSamples = (float*)audioData + channel;
+					
+					while(numSamplesToProcess--)
+					{
+						*outputSamples++ = *audioFileSamples;
+						audioFileSamples += numChannels;
+					}
+				} break;
 			}
 		}
 		
-		return result;
+		numFramesDone += numPackets;
 	}
 	
+	return numFramesDone;
 }
 
-void DiskInUGenInternal::prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw()
-{
-	senderUserData = userData;
-	if(isDone()) sendDoneInternal();
-}
-
-double DiskInUGenInternal::getDuration() const throw()
-{
-	return packetCount * reciprocalSampleRate;
-}
-
-double DiskInUGenInternal::getPosition() const throw()
-{
-	return currentPacket * reciprocalSampleRate;
-}
-
-bool DiskInUGenInternal::setPosition(const double newPosition) throw()
-{
-	currentPacket = ugen::max(0.0, newPosition) * fileSampleRate;
-	return true;
-}
-
-DiskInUGenInternalWav16::DiskInUGenInternalWav16(AudioFileID audioFile, 
-												 AudioStreamBasicDescription const& format, 
-												 const bool loopFlag, 
-												 const double startTime,
-												 const UGen::DoneAction doneAction) throw()
-:	DiskInUGenInternal(audioFile, format, loopFlag, startTime, doneAction)
-{
-}
-
-void DiskInUGenInternalWav16::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
-{
-	static const float factor = 1.0 / 0x7FFF;
-	
-	if(clearOutputsAndReadData(shouldDelete) == noErr)
-	{		
-		for(int channel = 0; channel < numChannels_; channel++)
-		{
-			float *outputSamples = proxies[channel]->getSampleData();
-			SInt16* audioFileSamples = (SInt16*)audioData + channel;
-			int numSamplesToProcess = numPackets;
-			
-			while(numSamplesToProcess--)
-			{
-				*outputSamples = (float)(*audioFileSamples) * factor;
-				outputSamples++;
-				audioFileSamples += numChannels_;
-			}
-		}
-	}	
-}
-
-DiskInUGenInternalAiff16::DiskInUGenInternalAiff16(AudioFileID audioFile, 
-												   AudioStreamBasicDescription const& format, 
-												   const bool loopFlag, 
-												   const double startTime,
-												   const UGen::DoneAction doneAction) throw()
-:	DiskInUGenInternal(audioFile, format, loopFlag, startTime, doneAction)
-{
-}
-
-void DiskInUGenInternalAiff16::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
-{
-	static const float factor = 1.0 / 0x7FFF;
-	
-	if(clearOutputsAndReadData(shouldDelete) == noErr)
-	{		
-		for(int channel = 0; channel < numChannels_; channel++)
-		{
-			float *outputSamples = proxies[channel]->getSampleData();
-			SInt16* audioFileSamples = (SInt16*)audioData + channel;
-			int numSamplesToProcess = numPackets;
-			
-			while(numSamplesToProcess--)
-			{
-				*outputSamples = (float)bigEndian16Bit((const char*)audioFileSamples) * factor;
-				outputSamples++;
-				audioFileSamples += numChannels_;
-			}
-		}
-	}	
-}
-
-DiskInUGenInternalWav24::DiskInUGenInternalWav24(AudioFileID audioFile, 
-												 AudioStreamBasicDescription const& format, 
-												 const bool loopFlag, 
-												 const double startTime,
-												 const UGen::DoneAction doneAction) throw()
-:	DiskInUGenInternal(audioFile, format, loopFlag, startTime, doneAction)
-{
-}
-
-void DiskInUGenInternalWav24::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
-{
-	static const float factor = 1.0 / 0x7FFFFF;
-	const int intInc = numChannels_ * 3;
-	
-	if(clearOutputsAndReadData(shouldDelete) == noErr)
-	{		
-		for(int channel = 0; channel < numChannels_; channel++)
-		{
-			float *outputSamples = proxies[channel]->getSampleData();
-			char* audioFileSamples = (char*)audioData + (channel * 3);
-			int numSamplesToProcess = numPackets;
-			
-			while(numSamplesToProcess--)
-			{
-				*outputSamples = (float)littleEndian24Bit(audioFileSamples) * factor;
-				outputSamples++;
-				audioFileSamples += intInc;
-			}
-		}
-	}	
-}
-
-DiskInUGenInternalAiff24::DiskInUGenInternalAiff24(AudioFileID audioFile, 
-												   AudioStreamBasicDescription const& format, 
-												   const bool loopFlag, 
-												   const double startTime,
-												   const UGen::DoneAction doneAction) throw()
-:	DiskInUGenInternal(audioFile, format, loopFlag, startTime, doneAction)
-{
-}
-
-void DiskInUGenInternalAiff24::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
-{
-	static const float factor = 1.0 / 0x7FFFFF;
-	const int intInc = numChannels_ * 3;
-	
-	if(clearOutputsAndReadData(shouldDelete) == noErr)
-	{		
-		for(int channel = 0; channel < numChannels_; channel++)
-		{
-			float *outputSamples = proxies[channel]->getSampleData();
-			char* audioFileSamples = (char*)audioData + (channel * 3);
-			int numSamplesToProcess = numPackets;
-			
-			while(numSamplesToProcess--)
-			{
-				*outputSamples = (float)bigEndian24Bit(audioFileSamples) * factor;
-				outputSamples++;
-				audioFileSamples += intInc;
-			}
-		}
-	}	
-}
-
-DiskInUGenInternalWav32::DiskInUGenInternalWav32(AudioFileID audioFile, 
-												 AudioStreamBasicDescription const& format, 
-												 const bool loopFlag, 
-												 const double startTime,
-												 const UGen::DoneAction doneAction) throw()
-:	DiskInUGenInternal(audioFile, format, loopFlag, startTime, doneAction)
-{
-}
-
-void DiskInUGenInternalWav32::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
-{
-	static const float factor = 1.0 / 0x7FFFFFFF;
-	
-	if(clearOutputsAndReadData(shouldDelete) == noErr)
-	{		
-		for(int channel = 0; channel < numChannels_; channel++)
-		{
-			float *outputSamples = proxies[channel]->getSampleData();
-			SInt32* audioFileSamples = (SInt32*)audioData + channel;
-			int numSamplesToProcess = numPackets;
-			
-			while(numSamplesToProcess--)
-			{
-				*outputSamples = (float)(*audioFileSamples) * factor;
-				outputSamples++;
-				audioFileSamples += numChannels_;
-			}
-		}
-	}	
-}
-
-DiskInUGenInternalAiff32::DiskInUGenInternalAiff32(AudioFileID audioFile, 
-												   AudioStreamBasicDescription const& format, 
-												   const bool loopFlag, 
-												   const double startTime,
-												   const UGen::DoneAction doneAction) throw()
-:	DiskInUGenInternal(audioFile, format, loopFlag, startTime, doneAction)
-{
-}
-
-void DiskInUGenInternalAiff32::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
-{
-	static const float factor = 1.0 / 0x7FFFFFFF;
-	
-	if(clearOutputsAndReadData(shouldDelete) == noErr)
-	{		
-		for(int channel = 0; channel < numChannels_; channel++)
-		{
-			float *outputSamples = proxies[channel]->getSampleData();
-			SInt32* audioFileSamples = (SInt32*)audioData + channel;
-			int numSamplesToProcess = numPackets;
-			
-			while(numSamplesToProcess--)
-			{
-				*outputSamples = (float)bigEndian32Bit((const char*)audioFileSamples) * factor;
-				outputSamples++;
-				audioFileSamples += numChannels_;
-			}
-		}
-	}	
-}
-
-DiskInUGenInternalFloatBigEndian::DiskInUGenInternalFloatBigEndian(AudioFileID audioFile, 
-																   AudioStreamBasicDescription const& format, 
-																   const bool loopFlag, 
-																   const double startTime,
-																   const UGen::DoneAction doneAction) throw()
-:	DiskInUGenInternal(audioFile, format, loopFlag, startTime, doneAction)
-{
-}
-
-void DiskInUGenInternalFloatBigEndian::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
-{
-	if(clearOutputsAndReadData(shouldDelete) == noErr)
-	{		
-		for(int channel = 0; channel < numChannels_; channel++)
-		{
-			float *outputSamples = proxies[channel]->getSampleData();
-			float* audioFileSamples = (float*)audioData + channel;
-			int numSamplesToProcess = numPackets;
-			
-			while(numSamplesToProcess--)
-			{
-				*outputSamples = bigEndianFloat((const char*)audioFileSamples);
-				outputSamples++;
-				audioFileSamples += numChannels_;
-			}
-		}
-	}	
-}
-
-DiskInUGenInternalFloatLittleEndian::DiskInUGenInternalFloatLittleEndian(AudioFileID audioFile, 
-																		 AudioStreamBasicDescription const& format, 
-																		 const bool loopFlag, 
-																		 const double startTime,
-																		 const UGen::DoneAction doneAction) throw()
-:	DiskInUGenInternal(audioFile, format, loopFlag, startTime, doneAction)
-{
-}
-
-void DiskInUGenInternalFloatLittleEndian::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
-{
-	if(clearOutputsAndReadData(shouldDelete) == noErr)
-	{		
-		for(int channel = 0; channel < numChannels_; channel++)
-		{
-			float *outputSamples = proxies[channel]->getSampleData();
-			float* audioFileSamples = (float*)audioData + channel;
-			int numSamplesToProcess = numPackets;
-			
-			while(numSamplesToProcess--)
-			{
-				*outputSamples = *audioFileSamples;
-				outputSamples++;
-				audioFileSamples += numChannels_;
-			}
-		}
-	}	
-}
-
-
 
 DiskIn::DiskIn(Text const& path, 
 			   const bool loopFlag, 
 			   const double startTime,
-			   const UGen::DoneAction doneAction) throw()
+			   const UGen::DoneAction doneAction,
+			   UGen const& rate,
+			   const int numFrames) throw()
 {	
-	initWithAudioFile(path.getArray(), loopFlag, startTime, doneAction);
+	initWithAudioFile(path.getArray(), loopFlag, startTime, doneAction, rate, numFrames);
 }
 
 void DiskIn::initWithAudioFile(const char* audioFilePath, 
 							   const bool loopFlag, 
 							   const double startTime,
-							   const UGen::DoneAction doneAction) throw()
+							   const UGen::DoneAction doneAction,
+							   UGen const& rate,
+							   const int numFrames) throw()
 {
 	Text path; // this needs to be here so it doesn't get garbage collected too early
 	
@@ -468,26 +234,28 @@ void DiskIn::initWithAudioFile(const char* audioFilePath,
 		audioFilePath = path.getArray();
 	}
 	
-	OSStatus result;
-	UInt32 dataSize;
-	
-	CFURLRef audioFileURL;
-	audioFileURL = CFURLCreateFromFileSystemRepresentation(NULL,
-														   (const UInt8*)audioFilePath, 
-														   strlen(audioFilePath), 
-														   false);
+	DiskStreamSource* source = MappedAudioFileSource::open(audioFilePath);
 	
-	AudioFileID	audioFile = 0;
-	result = AudioFileOpenURL (audioFileURL, kAudioFileReadPermission, 0, &audioFile);
-	CFRelease(audioFileURL);
-	if (result != noErr) 
-	{
-		printf("DiskIn: error: Could not open file: %s err=%d\n", audioFilePath, (int)result);
-		audioFile = 0;
-	}
-	
-	if(audioFile)
+	if(source == 0)
 	{
+		OSStatus result;
+		UInt32 dataSize;
+		
+		CFURLRef audioFileURL;
+		audioFileURL = CFURLCreateFromFileSystemRepresentation(NULL,
+															   (const UInt8*)audioFilePath, 
+															   strlen(audioFilePath), 
+															   false);
+		
+		AudioFileID	audioFile = 0;
+		result = AudioFileOpenURL (audioFileURL, kAudioFileReadPermission, 0, &audioFile);
+		CFRelease(audioFileURL);
+		if (result != noErr) 
+		{
+			printf("DiskIn: error: Could not open file: %s err=%d\n", audioFilePath, (int)result);
+			return;
+		}
+		
 		AudioStreamBasicDescription format;
 		dataSize = sizeof(format);
 		result = AudioFileGetProperty(audioFile, kAudioFilePropertyDataFormat, &dataSize, &format);
@@ -495,129 +263,44 @@ void DiskIn::initWithAudioFile(const char* audioFilePath,
 		{
 			printf("DiskIn: error: Could not get data format: %s err=%d\n", audioFilePath, (int)result);
 			AudioFileClose(audioFile);
-			audioFile = 0;
+			return;
 		}
 		else if(format.mFormatID != kAudioFormatLinearPCM)
 		{
-			printf("DiskIn: error: Only PCM formats supported\\n");
+			printf("DiskIn: error: Only PCM formats supported\n");
 			AudioFileClose(audioFile);
-			audioFile = 0;
+			return;
 		}
-		else
+		else if(!AudioFileDiskStreamSource::isFormatSupported(format))
 		{
-			if(format.mSampleRate != UGen::getSampleRate())
-			{
-				printf("DiskIn: warning: Sample rate mismatch - resampling is not yet implemented\\n");
-			}
-			
-			if((format.mFormatFlags & kAudioFormatFlagIsFloat) != 0)
-			{
-				initInternal(format.mChannelsPerFrame);
-				
-				if((format.mFormatFlags & kAudioFormatFlagIsBigEndian) != 0)
-				{
-					generateFromProxyOwner(new DiskInUGenInternalFloatBigEndian(audioFile, 
-																				format, 
-																				loopFlag, 
-																				startTime, 
-																				doneAction));
-					return;
-				}
-				else
-				{
-					generateFromProxyOwner(new DiskInUGenInternalFloatLittleEndian(audioFile, 
-																				   format, 
-																				   loopFlag, 
-																				   startTime, 
-																				   doneAction));
-					return;
-				}
-			}
-			else if((format.mFormatFlags & kAudioFormatFlagIsBigEndian) != 0)
-			{
-				// aif and other big edian?
-				if(format.mBitsPerChannel == 16)
-				{
-					initInternal(format.mChannelsPerFrame);
-					generateFromProxyOwner(new DiskInUGenInternalAiff16(audioFile, 
-																		format, 
-																		loopFlag, 
-																		startTime, 
-																		doneAction));
-					return;
-				}
-				else if(format.mBitsPerChannel == 32)
-				{
-					initInternal(format.mChannelsPerFrame);
-					generateFromProxyOwner(new DiskInUGenInternalAiff32(audioFile, 
-																		format, 
-																		loopFlag, 
-																		startTime, 
-																		doneAction));			
-					return;
-				}
-				else if(format.mBitsPerChannel == 24)
-				{
-					initInternal(format.mChannelsPerFrame);
-					generateFromProxyOwner(new DiskInUGenInternalAiff24(audioFile, 
-																		format, 
-																		loopFlag, 
-																		startTime, 
-																		doneAction));	
-					return;
-				}
-				else
-				{
-					printf("DiskIn: error: Sound file format not yet supported.");
-					AudioFileClose(audioFile);
-					audioFile = 0;
-				}
-			}
-			else
-			{
-				// wav and other little edian?
-				if(format.mBitsPerChannel == 16)
-				{
-					initInternal(format.mChannelsPerFrame);
-					generateFromProxyOwner(new DiskInUGenInternalWav16(audioFile, 
-																	   format, 
-																	   loopFlag, 
-																	   startTime, 
-																	   doneAction));
-					return;					
-				}
-				else if(format.mBitsPerChannel == 32)
-				{
-					initInternal(format.mChannelsPerFrame);
-					generateFromProxyOwner(new DiskInUGenInternalWav32(audioFile, 
-																	   format, 
-																	   loopFlag, 
-																	   startTime, 
-																	   doneAction));
-					return;					
-				}
-				else if(format.mBitsPerChannel == 24)
-				{
-					initInternal(format.mChannelsPerFrame);
-					generateFromProxyOwner(new DiskInUGenInternalWav24(audioFile, 
-																	   format, 
-																	   loopFlag, 
-																	   startTime, 
-																	   doneAction));
-					return;					
-				}
-				else
-				{
-					printf("DiskIn: error: Sound file format not yet supported.");
-					AudioFileClose(audioFile);
-					audioFile = 0;
-				}
-			}
+			printf("DiskIn: error: Sound file format not yet supported.\n");
+			AudioFileClose(audioFile);
+			return;
 		}
+		
+		SInt64 packetCount = 0;
+		dataSize = sizeof(packetCount);
+		result = AudioFileGetProperty(audioFile, kAudioFilePropertyAudioDataPacketCount, &dataSize, &packetCount);
+		if (result != noErr) 
+		{
+			printf("DiskIn: error: Could not get packet count: %s err=%d\n", audioFilePath, (int)result);
+			AudioFileClose(audioFile);
+			return;
+		}
+		
+		source = new AudioFileDiskStreamSource(audioFile, format, packetCount);
 	}
+	
+	initInternal(source->getNumChannels());
+	generateFromProxyOwner(new DiskInUGenInternal(source, 
+												  rate.mix(),
+												  loopFlag, 
+												  startTime, 
+												  numFrames, 
+												  doneAction));
 }
 
 
 END_UGEN_NAMESPACE
 
-#endif // UGEN_IPHONE
\ No newline at end of file
+#endif
@@ -40,135 +40,53 @@
 
 
 #include "../core/ugen_UGen.h"
+#include "../buffers/ugen_DiskStream.h"
 
-/** @ingroup UGenInternals */
-class DiskInUGenInternal :	public ProxyOwnerUGenInternal,
-							public DoneActionSender
+/** A DiskStreamSource reading PCM data through an AudioFileID. 
+ This is used for the files which can't be memory mapped (e.g., CAF files). */
+class AudioFileDiskStreamSource : public DiskStreamSource
 {
 public:
-	DiskInUGenInternal(AudioFileID audioFile, 
-					   AudioStreamBasicDescription const& format, 
-					   const bool loopFlag = false, 
-					   const double startTime = 0.0,
-					   const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw();
-	~DiskInUGenInternal() throw();
-	OSStatus clearOutputsAndReadData(bool& shouldDelete) throw();
-	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
-		
-	double getDuration() const throw();
-	double getPosition() const throw();
-	bool setPosition(const double newPosition) throw();	
+	/** Takes ownership of the audio file. */
+	AudioFileDiskStreamSource(AudioFileID audioFile, 
+							  AudioStreamBasicDescription const& format,
+							  const SInt64 packetCount) throw();
+	~AudioFileDiskStreamSource();
+	
+	int getNumChannels() const throw()		{ return numChannels;		}
+	long getNumFrames() const throw()		{ return (long)packetCount;	}
+	double getSampleRate() const throw()	{ return fileSampleRate;	}
+	
+	int read(float* const* destinations, const long startFrame, const int numFrames) throw();
+	
+	/** Whether the format can be converted by read(). */
+	static bool isFormatSupported(AudioStreamBasicDescription const& format) throw();
+	
+private:
+	enum Conversion
+	{
+		Wav16, Aiff16, Wav24, Aiff24, Wav32, Aiff32, FloatBigEndian, FloatLittleEndian
+	};
+	
+	static Conversion getConversion(AudioStreamBasicDescription const& format) throw();
 	
-protected:
 	AudioFileID	audioFile_;
-	const int numChannels_;
-	const bool loopFlag_;
-	const double startTime_;
-	SInt64 packetCount;
-	SInt64 currentPacket;
-	int allocatedBlockSize;
+	const int numChannels;
+	const SInt64 packetCount;
+	const UInt32 bytesPerFrame;
+	const double fileSampleRate;
+	const Conversion conversion;
 	void *audioData;
-	UInt32 numPackets;
-	UInt32 bytesPerFrame;
-	double fileSampleRate;
-	double reciprocalSampleRate;
-	const UGen::DoneAction doneAction_;
-	const bool shouldDeleteValue;	
-};
-
-class DiskInUGenInternalWav16 : public DiskInUGenInternal
-{
-public: 
-	DiskInUGenInternalWav16(AudioFileID audioFile, 
-							AudioStreamBasicDescription const& format, 
-							const bool loopFlag = false, 
-							const double startTime = 0.0,
-							const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw();
-	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
-};
-
-class DiskInUGenInternalAiff16 : public DiskInUGenInternal
-{
-public: 
-	DiskInUGenInternalAiff16(AudioFileID audioFile, 
-							 AudioStreamBasicDescription const& format, 
-							 const bool loopFlag = false, 
-							 const double startTime = 0.0,
-							 const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw();
-	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
-};
-
-class DiskInUGenInternalWav24 : public DiskInUGenInternal
-{
-public: 
-	DiskInUGenInternalWav24(AudioFileID audioFile, 
-							AudioStreamBasicDescription const& format, 
-							const bool loopFlag = false, 
-							const double startTime = 0.0,
-							const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw();
-	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
-};
-
-class DiskInUGenInternalAiff24 : public DiskInUGenInternal
-{
-public: 
-	DiskInUGenInternalAiff24(AudioFileID audioFile, 
-							 AudioStreamBasicDescription const& format, 
-							 const bool loopFlag = false, 
-							 const double startTime = 0.0,
-							 const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw();
-	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
-};
-
-class DiskInUGenInternalWav32 : public DiskInUGenInternal
-{
-public: 
-	DiskInUGenInternalWav32(AudioFileID audioFile, 
-							AudioStreamBasicDescription const& format, 
-							const bool loopFlag = false, 
-							const double startTime = 0.0,
-							const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw();
-	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
-};
-
-class DiskInUGenInternalAiff32 : public DiskInUGenInternal
-{
-public: 
-	DiskInUGenInternalAiff32(AudioFileID audioFile, 
-							 AudioStreamBasicDescription const& format, 
-							 const bool loopFlag = false, 
-							 const double startTime = 0.0,
-							 const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw();
-	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
-};
-
-class DiskInUGenInternalFloatBigEndian : public DiskInUGenInternal
-{
-public: 
-	DiskInUGenInternalFloatBigEndian(AudioFileID audioFile, 
-									 AudioStreamBasicDescription const& format, 
-									 const bool loopFlag = false, 
-									 const double startTime = 0.0,
-									 const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw();
-	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
-};
-
-class DiskInUGenInternalFloatLittleEndian : public DiskInUGenInternal
-{
-public: 
-	DiskInUGenInternalFloatLittleEndian(AudioFileID audioFile, 
-										AudioStreamBasicDescription const& format, 
-										const bool loopFlag = false, 
-										const double startTime = 0.0,
-										const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw();
-	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
 };
 
 
-
 /** Streams a soundfile from disk.
+ 
+ Uncompressed WAV and AIFF files are memory mapped, other PCM files are read using the 
+ AudioFile API. Either way the reads happen on the DiskStreamer's I/O thread.
+ 
  @ingroup AllUGens SoundFileUGens
- @see PlayBuf, DiskOut */
+ @see PlayBuf, DiskOut, DiskStreamer */
 class DiskIn : public UGen 
 { 
 public: 
@@ -176,21 +94,27 @@ public:
 	DiskIn (Text const& path, 
 			const bool loopFlag = false, 
 			const double startTime = 0.0, 
-			const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw(); 
+			const UGen::DoneAction doneAction = UGen::DeleteWhenDone,
+			UGen const& rate = UGen::get1(),
+			const int numFrames = 32768) throw(); 
 		
 	static inline UGen AR (Text const& path, 
 						   const bool loopFlag = false, 
 						   const double startTime = 0.0,
-						   const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw() 
+						   const UGen::DoneAction doneAction = UGen::DeleteWhenDone,
+						   UGen const& rate = UGen::get1(),
+						   const int numFrames = 32768) throw() 
 	{ 
-		return DiskIn (path, loopFlag, startTime, doneAction); 
+		return DiskIn (path, loopFlag, startTime, doneAction, rate, numFrames); 
 	} 	
 					
 private:
 	void initWithAudioFile(const char* audioFilePath, 
-						   const bool loopFlag = false, 
-						   const double startTime = 0.0,
-						   const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw();
+						   const bool loopFlag,
+						   const double startTime,
+						   const UGen::DoneAction doneAction,
+						   UGen const& rate,
+						   const int numFrames) throw();
 };
 
 
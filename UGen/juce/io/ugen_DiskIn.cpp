@@ -42,112 +42,73 @@
 BEGIN_UGEN_NAMESPACE
 
 #include "ugen_DiskIn.h"
+#include "../../basics/ugen_InlineBinaryOps.h"
 
+static const int juceAudioFormatSourceChunkSize = 4096;
 
-DiskInUGenInternal::DiskInUGenInternal(File const& file, 
-									   const int numChannels, 
-									   bool loopFlag, 
-									   const double startTime, 
-									   const int numFrames,
-									   const UGen::DoneAction doneAction) throw()
-:	ProxyOwnerUGenInternal(0, numChannels - 1),
-	file_(file),
-	loopFlag_(loopFlag),
-	startTime_(startTime < 0.0 ? 0.0 : startTime),
-	doneAction_(doneAction),
-	shouldDeleteValue(doneAction_ == UGen::DeleteWhenDone)
-{	
-	ugen_assert(numChannels > 0);
-	ugen_assert(startTime == startTime_);
-	ugen_assert(numFrames > 0);
-	
-	bufferData = new float*[numChannels];
+JuceAudioFormatSource::JuceAudioFormatSource(AudioFormatReader* reader_) throw()
+:	reader(reader_)
+{
+	ugen_assert(reader != 0);
 	
-	filePlayer.addChangeListener(this);
-	filePlayer.setFile(file, numFrames);
-	filePlayer.prepareToPlay(UGen::getEstimatedBlockSize(), UGen::getSampleRate());
+	const int numChannels = getNumChannels();
+	scratch = new int[numChannels * juceAudioFormatSourceChunkSize];
+	scratchChannels = new int*[numChannels + 1];
 	
-	filePlayer.setPosition(startTime);
-	filePlayer.start();
-}
-
-DiskInUGenInternal::~DiskInUGenInternal() throw()
-{
-	filePlayer.releaseResources();
-	filePlayer.removeChangeListener(this);
+	for(int channel = 0; channel < numChannels; channel++)
+		scratchChannels[channel] = scratch + channel * juceAudioFormatSourceChunkSize;
 	
-	delete [] bufferData;
+	scratchChannels[numChannels] = 0;
 }
 
-void DiskInUGenInternal::prepareForBlock(const int /*actualBlockSize*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
+JuceAudioFormatSource::~JuceAudioFormatSource()
 {
-	senderUserData = userData;
-	if(isDone()) sendDoneInternal();
+	delete [] scratchChannels;
+	delete [] scratch;
+	delete reader;
 }
 
-void DiskInUGenInternal::processBlock(bool& shouldDelete, const unsigned int /*blockID*/, const int /*channel*/) throw()
+int JuceAudioFormatSource::read(float* const* destinations, const long startFrame, const int numFrames) throw()
 {
-	int numChannels = getNumChannels();
-	int blockSize = uGenOutput.getBlockSize();
-	for(int i = 0; i < numChannels; i++)
-	{
-		bufferData[i] = proxies[i]->getSampleData();
-	}
+	const int numChannels = getNumChannels();
+	const long numFramesInSource = getNumFrames();
 	
-	AudioSampleBuffer audioSampleBuffer(bufferData, numChannels, blockSize);
+	if(startFrame < 0 || startFrame >= numFramesInSource) return 0;
 	
-	AudioSourceChannelInfo info;
-	info.buffer			= &audioSampleBuffer;
-	info.numSamples		= blockSize;
-	info.startSample	= 0;
+	const int numFramesToRead = (int)ugen::min((long)numFrames, numFramesInSource - startFrame);
 	
-	if(filePlayer.isPlaying())
-		filePlayer.getNextAudioBlock(info);
-	else
-		info.clearActiveBufferRegion();
+	// the reader writes ints, with float formats these contain the float bits
+	const bool isFloat = reader->usesFloatingPointData;
+	const float intScale = 1.f / 2147483648.f;
+	int numFramesDone = 0;
 	
-	if(isDone())
-	{
-		shouldDelete = shouldDelete ? true : shouldDeleteValue;
-	}
-}
-
-void DiskInUGenInternal::changeListenerCallback (ChangeBroadcaster*)
-{
-	if(filePlayer.isPlaying() == false)
+	while(numFramesDone < numFramesToRead)
 	{
-		if(loopFlag_ == true)
-		{
-			filePlayer.setPosition(startTime_);
-			filePlayer.start();
-		}
-		else
+		const int chunkSize = ugen::min(juceAudioFormatSourceChunkSize, numFramesToRead - numFramesDone);
+		
+		reader->read(scratchChannels, numChannels, startFrame + numFramesDone, chunkSize, false);
+		
+		for(int channel = 0; channel < numChannels; channel++)
 		{
-			if(shouldDeleteValue)
-				setIsDone();
+			float* destination = destinations[channel] + numFramesDone;
+			
+			if(isFloat)
+			{
+				memcpy(destination, scratchChannels[channel], chunkSize * sizeof(float));
+			}
+			else
+			{
+				const int* source = scratchChannels[channel];
+				
+				for(int i = 0; i < chunkSize; i++)
+					destination[i] = (float)source[i] * intScale;
+			}
 		}
+		
+		numFramesDone += chunkSize;
 	}
 	
-}
-
-double DiskInUGenInternal::getDuration() const throw()
-{
-	return (double)filePlayer.getTotalLength() * filePlayer.getReciprocalSampleRate();
-}
-
-double DiskInUGenInternal::getPosition() const throw()
-{
-	return filePlayer.getCurrentPosition();
-}
-
-bool DiskInUGenInternal::setPosition(const double newPosition) throw()
-{	
-	filePlayer.setPosition(newPosition);
-	
-	if(filePlayer.isPlaying() == false)
-		filePlayer.start();
-	
-	return true;
+	return numFramesDone;
 }
 
 
@@ -155,37 +116,51 @@ DiskIn::DiskIn(File const& file,
 			   bool loopFlag, 
 			   const double startTime, 
 			   const int numFrames,
-			   const UGen::DoneAction doneAction) throw()
+			   const UGen::DoneAction doneAction,
+			   UGen const& rate) throw()
 {	
-	initWithJuceFile(file, loopFlag, startTime, numFrames, doneAction);
+	initWithJuceFile(file, loopFlag, startTime, numFrames, doneAction, rate);
 }
 
 DiskIn::DiskIn(String const& path, 
 			   bool loopFlag, 
 			   const double startTime, 
 			   const int numFrames,
-			   const UGen::DoneAction doneAction) throw()
+			   const UGen::DoneAction doneAction,
+			   UGen const& rate) throw()
 {
 	File file(path);
-	initWithJuceFile(file, loopFlag, startTime, numFrames, doneAction);
+	initWithJuceFile(file, loopFlag, startTime, numFrames, doneAction, rate);
 }
 
 void DiskIn::initWithJuceFile(File const& file, 
 							  bool loopFlag, 
 							  const double startTime, 
 							  const int numFrames,
-							  const UGen::DoneAction doneAction) throw()
+							  const UGen::DoneAction doneAction,
+							  UGen const& rate) throw()
 {
-	AudioFormatManager formatManager;
-	formatManager.registerBasicFormats();
+	DiskStreamSource* source = MappedAudioFileSource::open((const char*)file.getFullPathName().toUTF8());
 	
-	AudioFormatReader* reader = formatManager.createReaderFor (file);
-	int numChannels = reader->numChannels;
-	delete reader;
+	if(source == 0)
+	{
+		AudioFormatManager formatManager;
+		formatManager.registerBasicFormats();
+		
+		AudioFormatReader* reader = formatManager.createReaderFor (file);
+		
+		if(reader == 0) 
+		{
+			printf("DiskIn: could not open file '%s'\n", (const char*)file.getFullPathName().toUTF8());
+			return;
+		}
+		
+		source = new JuceAudioFormatSource(reader);
+	}
 	
-	initInternal(numChannels);
-	generateFromProxyOwner(new DiskInUGenInternal(file, 
-												  numChannels, 
+	initInternal(source->getNumChannels());
+	generateFromProxyOwner(new DiskInUGenInternal(source, 
+												  rate.mix(),
 												  loopFlag, 
 												  startTime, 
 												  numFrames, 
@@ -195,4 +170,4 @@ void DiskIn::initWithJuceFile(File const& file,
 
 END_UGEN_NAMESPACE
 
-#endif
\ No newline at end of file
+#endif
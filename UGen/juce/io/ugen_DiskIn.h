@@ -40,46 +40,37 @@
 
 
 #include "../../core/ugen_UGen.h"
-#include "ugen_AudioFilePlayer.h"
+#include "../../buffers/ugen_DiskStream.h"
 
-/** @ingroup UGenInternals */
-class DiskInUGenInternal :	public ProxyOwnerUGenInternal,
-							public ChangeListener,
-							public DoneActionSender
+/** A DiskStreamSource reading through a Juce AudioFormatReader.
+ This is used for the formats which can't be memory mapped (e.g., compressed files). */
+class JuceAudioFormatSource : public DiskStreamSource
 {
 public:
-	DiskInUGenInternal(File const& file, 
-					   const int numChannels, 
-					   bool loopFlag, 
-					   const double startTime, 
-					   const int numFrames,
-					   const UGen::DoneAction doneAction) throw();
-	~DiskInUGenInternal() throw();
-	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
-	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	/** Takes ownership of the reader. */
+	JuceAudioFormatSource(AudioFormatReader* reader) throw();
+	~JuceAudioFormatSource();
 	
-	void changeListenerCallback (ChangeBroadcaster*);
+	int getNumChannels() const throw()		{ return (int)reader->numChannels;		}
+	long getNumFrames() const throw()		{ return (long)reader->lengthInSamples;	}
+	double getSampleRate() const throw()	{ return reader->sampleRate;			}
 	
-	double getDuration() const throw();
-	double getPosition() const throw();
-	bool setPosition(const double newPosition) throw();
+	int read(float* const* destinations, const long startFrame, const int numFrames) throw();
 	
-	
-protected:
-	
-	File file_;
-	bool loopFlag_;
-	double startTime_;
-	AudioFilePlayer filePlayer;
-	float** bufferData;
-	const UGen::DoneAction doneAction_;
-	const bool shouldDeleteValue;	
+private:
+	AudioFormatReader* reader;
+	int* scratch;
+	int** scratchChannels;
 };
 
 
 /** Streams a soundfile from disk.
+ 
+ Uncompressed WAV and AIFF files are memory mapped, other formats are read through Juce.
+ Either way the reads happen on the DiskStreamer's I/O thread.
+ 
  @ingroup AllUGens SoundFileUGens
- @see PlayBuf, DiskOut */
+ @see PlayBuf, DiskOut, DiskStreamer */
 class DiskIn : public UGen 
 { 
 public: 
@@ -88,37 +79,42 @@ public:
 			bool loopFlag = false, 
 			const double startTime = 0.0, 
 			const int numFrames = 32768, 
-			const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw(); 
+			const UGen::DoneAction doneAction = UGen::DeleteWhenDone,
+			UGen const& rate = UGen::get1()) throw(); 
 	DiskIn (String const& path, 
 			bool loopFlag = false, 
 			const double startTime = 0.0, 
 			const int numFrames = 32768,
-			const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw(); 
+			const UGen::DoneAction doneAction = UGen::DeleteWhenDone,
+			UGen const& rate = UGen::get1()) throw(); 
 		
 	static inline UGen AR (File const& file, 
 						   bool loopFlag = false, 
 						   const double startTime = 0.0, 
 						   const int numFrames = 32768,
-						   const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw() 
+						   const UGen::DoneAction doneAction = UGen::DeleteWhenDone,
+						   UGen const& rate = UGen::get1()) throw() 
 	{ 
-		return DiskIn (file, loopFlag, startTime, numFrames, doneAction); 
+		return DiskIn (file, loopFlag, startTime, numFrames, doneAction, rate); 
 	} 	
 		
 	static inline UGen AR (String const& file, 
 						   bool loopFlag = false, 
 						   const double startTime = 0.0, 
 						   const int numFrames = 32768,
-						   const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw() 
+						   const UGen::DoneAction doneAction = UGen::DeleteWhenDone,
+						   UGen const& rate = UGen::get1()) throw() 
 	{ 
-		return DiskIn (file, loopFlag, startTime, numFrames, doneAction); 
+		return DiskIn (file, loopFlag, startTime, numFrames, doneAction, rate); 
 	} 		
 		
 private:
 	void initWithJuceFile(File const& file, 
-						  bool loopFlag = false, 
-						  const double startTime = 0.0, 
-						  const int numFrames = 32768,
-						  const UGen::DoneAction doneAction = UGen::DeleteWhenDone) throw();
+						  bool loopFlag, 
+						  const double startTime, 
+						  const int numFrames,
+						  const UGen::DoneAction doneAction,
+						  UGen const& rate) throw();
 };
 
 
@@ -37,6 +37,31 @@
 
 class JuceIOHost;
 
+/** The UGen graph of a JuceIOHost.
+ The host changes its own copy of the graph and publishes a new copy to the audio thread (using 
+ an AtomicSlot) after each change. The audio thread processes UGen objects which aren't used on 
+ any other thread (only the UGenInternal objects are shared). */
+struct JuceIOHostGraph
+{
+	JuceIOHostGraph() throw() { }
+	
+	/** Copy the UGen references and the others array (so it can be changed without affecting the copied graph). */
+	JuceIOHostGraph(JuceIOHostGraph const& copy) throw()
+	:	input(copy.input),
+		output(copy.output)
+	{
+		if(copy.others.size() > 0)
+			others.add(copy.others);
+	}
+	
+	UGen input;
+	UGen output;
+	UGenArray others;
+	
+private:
+	const JuceIOHostGraph& operator= (const JuceIOHostGraph&);
+};
+
 class JuceIOHostInternal :	public AudioIODeviceCallback,
 							private Timer
 {
@@ -72,20 +97,32 @@ public:
 	friend class JuceIOHost;
 	
 protected:
-	CriticalSection lock;
+	CriticalSection lock;			// serialises changes to the graph, never taken by the audio thread
 	AudioDeviceManager audioDeviceManager;
 	
 private:
+	JuceIOHostGraph& beginChange() throw();
+	void endChange() throw();
+	
 	JuceIOHost *owner_;
 	const int numInputs_, numOutputs_;
 	int bufferSize;
-	UGen input_;
-	UGen output_;
-	UGenArray others;
+	JuceIOHostGraph editGraph;				// changed with the lock held
+	AtomicSlot<JuceIOHostGraph> graph;		// the copies published to the audio thread
 	JuceTimerDeleter* juceDeleter;
 };
 
 /** An audio IO host for Juce projects.
+ 
+ The audio callback never takes a lock. Changes to the graph (setInput(), setOutput(), 
+ addOther() etc) are made to a copy of the graph which is then published to the audio thread 
+ and picked up at the start of the next block. The previous graph is deleted on the thread 
+ making the next change (rather than on the audio thread). Replugging a Plug is also queued
+ in the same way so a slow graph rebuild on the message thread can't stall the audio thread.
+ 
+ Since UGen objects are then shared between threads this enables atomic reference counts
+ (see SmartPointer::setAtomicRefCounts()).
+ 
  @see UIKitAUIOHost AudioQueueIOHostController 
  @ingroup Hosts */
 class JuceIOHost
@@ -196,14 +233,13 @@ public:
 		internal->clearOthers();
 	}
 	
-	/** A conveniece function that replug a plug while lockin the audio thread. 
-	 The 'lock' CriticalSection is locked while the replug takes place.
+	/** A conveniece function that replugs a plug. 
+	 The change is queued and picked up at the start of the next audio block.
 	 @param plug		The Plug to replug (must be a Plug UGen)
 	 @param source		The UGen to replug into the Plug.
 	 @param fadeTime	The fade time (deafult 0s). */
 	void replug(UGen& plug, UGen const& source, const float fadeTime = 0.f)
 	{
-		const ScopedLock sl(lock);
 		plug.fadeSourceAndRelease(source, fadeTime);
 	}
 	
@@ -260,6 +296,8 @@ inline JuceIOHostInternal::JuceIOHostInternal(JuceIOHost *owner,
 	
 	const ScopedLock sl(lock);
 	UGen::initialise();
+	SmartPointer::setAtomicRefCounts(true);
+	
 	if(useTimerDeleter) 
 	{
 		juceDeleter = new JuceTimerDeleter();
@@ -271,7 +309,8 @@ inline JuceIOHostInternal::JuceIOHostInternal(JuceIOHost *owner,
 #endif
 	startTimer(50);
 	
-	output_ = Plug::AR(UGen::emptyChannels(numOutputs_), false);
+	editGraph.output = Plug::AR(UGen::emptyChannels(numOutputs_), false);
+	graph.publish(new JuceIOHostGraph(editGraph));
 }
 
 inline JuceIOHostInternal::~JuceIOHostInternal()
@@ -320,10 +359,9 @@ inline void JuceIOHostInternal::timerCallback()
 		return;
 	}
 	
-	const ScopedLock sl(lock);
-	
 	if(numInputs_ > 0)
-		input_ = AudioIn::AR(numInputs_);
+		setInput(AudioIn::AR(numInputs_));
+	
 	audioDeviceManager.addAudioCallback (this);	
 }
 
@@ -334,26 +372,38 @@ inline void JuceIOHostInternal::audioDeviceIOCallback (const float** inputChanne
 													   int numSamples)
 {
 	// may need to be a bit cleverer with the channels in here..
-	const ScopedLock sl(lock);
+	JuceIOHostGraph* const current = graph.acquire();
+	
+	if(current == 0)
+	{
+		for(int i = 0; i < numOutputChannels; i++)
+		{
+			if(outputChannelData[i] != 0)
+				memset(outputChannelData[i], 0, numSamples * sizeof(float));
+		}
+		
+		return;
+	}
+	
+	UGenArray& others = current->others;
 	
 	int blockID = UGen::getNextBlockID(numSamples);
 	
 	owner_->preTick(numSamples, blockID);
 	
-	if(numInputs_ > 0)
-		input_.setInputs(inputChannelData, numSamples, numInputChannels);
+	if(numInputs_ > 0 && current->input.isNotNull())
+		current->input.setInputs(inputChannelData, numSamples, numInputChannels);
 	
 	if(numOutputs_ > 0)
 	{
-		output_.setOutputs(outputChannelData, numSamples, numOutputChannels);
-//		output_.prepareAndProcessBlock(numSamples, blockID, -1);
+		current->output.setOutputs(outputChannelData, numSamples, numOutputChannels);
 
 		for(int i = 0; i < others.size(); i++)
 		{
 			others[i].prepareAndProcessBlock(numSamples, blockID, -1);
 		}
 		
-		output_.prepareAndProcessBlock(numSamples, blockID, -1);
+		current->output.prepareAndProcessBlock(numSamples, blockID, -1);
 	}
 	else
 	{
@@ -368,9 +418,11 @@ inline void JuceIOHostInternal::audioDeviceIOCallback (const float** inputChanne
 
 inline void JuceIOHostInternal::audioDeviceAboutToStart (AudioIODevice* device)
 {
-	//const ScopedLock sl(lock);	
 	UGen::prepareToPlay(device->getCurrentSampleRate(), device->getCurrentBufferSizeSamples());
-	output_.setSource(owner_->constructGraph(input_), true, 0.005f);
+	
+	// the audio thread doesn't take the lock, this just stops the graph changing while building the new one
+	const ScopedLock sl(lock);
+	editGraph.output.setSource(owner_->constructGraph(editGraph.input), true, 0.005f);
 }
 
 inline void JuceIOHostInternal::audioDeviceStopped() 
@@ -381,37 +433,51 @@ inline void JuceIOHostInternal::audioDeviceStopped()
 inline AudioDeviceManager& JuceIOHostInternal::getAudioDeviceManager() throw()	{ return audioDeviceManager;	}
 inline int JuceIOHostInternal::getNumInputs() const throw()						{ return numInputs_;			}
 inline int JuceIOHostInternal::getNumOutputs() const throw()					{ return numOutputs_;			}
-inline UGen& JuceIOHostInternal::getInput() throw()								{ return input_;				}
-inline UGen& JuceIOHostInternal::getOutput() throw()							{ return output_;				}
+inline UGen& JuceIOHostInternal::getInput() throw()								{ return editGraph.input;		}
+inline UGen& JuceIOHostInternal::getOutput() throw()							{ return editGraph.output;		}
+
+/** Get the graph to change, the lock is held until endChange(). */
+inline JuceIOHostGraph& JuceIOHostInternal::beginChange() throw()
+{
+	lock.enter();
+	return editGraph;
+}
+
+/** Publish a copy of the changed graph to the audio thread. */
+inline void JuceIOHostInternal::endChange() throw()
+{
+	graph.publish(new JuceIOHostGraph(editGraph));
+	lock.exit();
+}
 
 inline void JuceIOHostInternal::setInput(UGen const& ugen) throw() 
 { 
-	const ScopedLock sl(lock);
-	input_ = ugen;
+	beginChange().input = ugen;
+	endChange();
 }
 
 inline void JuceIOHostInternal::setOutput(UGen const& ugen) throw() 
 { 
-	const ScopedLock sl(lock);
-	output_ = ugen;
+	beginChange().output = ugen;
+	endChange();
 }
 
 inline void JuceIOHostInternal::addOther(UGen const& ugen) throw()
 {
-	const ScopedLock sl(lock);
-	others.add(ugen);
+	beginChange().others.add(ugen);
+	endChange();
 }
 
 inline void JuceIOHostInternal::removeOther(UGen const& ugen) throw()
 {
-	const ScopedLock sl(lock);
-	others.removeItem(ugen);
+	beginChange().others.removeItem(ugen);
+	endChange();
 }
 
 inline void JuceIOHostInternal::clearOthers() throw()
 {
-	const ScopedLock sl(lock);
-	others.clear(false);
+	beginChange().others.clear(false);
+	endChange();
 }
 
 
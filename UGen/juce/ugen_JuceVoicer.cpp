@@ -223,9 +223,16 @@ void VoicerUGenInternal::processBlock(bool& shouldDelete, const unsigned int blo
 						// stop double notes, AU lab was sending two ons but one off - seems fixed in Au Lab 2.2
 						//stealNote(midiChannel, midiNote, false, true); 
 						
-						UGen newEvent = spawnEvent(*this, currentEventIndex++, midiChannel, midiNote, velocity);
-						newEvent.userData = createUserData(midiChannel, midiNote);
-						events.add(newEvent);
+						VoicePool::Voice voice(currentEventIndex++, midiChannel, midiNote, velocity);
+						nextEvent(voice);
+						
+						UGen& newEvent = voice.ugen;
+						
+						if(newEvent.isNotNull())
+						{
+							newEvent.userData = createUserData(midiChannel, midiNote);
+							addEvent(newEvent);
+						}
 					}
 					else
 					{
@@ -145,6 +145,11 @@ public:
 		return event.spawnEvent(*this, eventCount, midiChannel, midiNote, velocity);
 	}
 	
+	~VoicerEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	VoicerEventType event;
 };
@@ -185,6 +190,11 @@ public:
 		return event.spawnEvent(*this, eventCount, midiChannel, midiNote, velocity);
 	}
 	
+	~VoicerEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	VoicerEventType event;
 };
@@ -41,90 +41,257 @@ BEGIN_UGEN_NAMESPACE
 
 #include "ugen_NeuralLayer.h"
 
+#ifdef UGEN_SIMD
+	#include "../vec/ugen_simd_Utilities.h"
+#endif
+
+static const double randomFactor = 1.0 / RAND_MAX;
+
+static inline float activation(const float act) throw()
+{
+	return 1.f / (1.f + (float)std::exp(-act));
+}
+
+/** outputSamples[k][s] = sum over j of inputSamples[j][s] * gains[k * numInputs + j]. */
+static inline void multiplyMatrix(const float * const *inputSamples, const int numInputs, 
+								  float * const *outputSamples, const int numOutputs, 
+								  const float *gains, const int numSamples) throw()
+{
+#if defined(UGEN_SIMD)
+	SIMD::matrixMix(inputSamples, numInputs, outputSamples, numOutputs, gains, 0, numSamples, false);
+#else
+	for(int output = 0; output < numOutputs; output++)
+	{
+		float *outputSamplesPtr = outputSamples[output];
+		const float *gainsPtr = gains + output * numInputs;
+		memset(outputSamplesPtr, 0, numSamples * sizeof(float));
+		
+		for(int input = 0; input < numInputs; input++)
+		{
+			const float *inputSamplesPtr = inputSamples[input];
+			const float gain = gainsPtr[input];
+			
+			for(int sample = 0; sample < numSamples; sample++)
+				outputSamplesPtr[sample] += inputSamplesPtr[sample] * gain;
+		}
+	}
+#endif
+}
+
+static inline float dotProduct(const float *left, const float *right, const int size) throw()
+{
+#if defined(UGEN_SIMD)
+	return SIMD::dotProduct(left, right, size);
+#else
+	float sum = 0.f;
+	
+	for(int i = 0; i < size; i++)
+		sum += left[i] * right[i];
+	
+	return sum;
+#endif
+}
 
 NeuralLayerSimpleInternal::NeuralLayerSimpleInternal(const int numNodes, const int numNodesOnPreviousLayer) throw()
-:	nodes(numNodes < 1 ? 1 : numNodes),
-	outputVector(NumericalArray<float>::newClear(nodes.size())),
+:	weights(NumericalArray<float>::newClear((numNodes < 1 ? 1 : numNodes) * (numNodesOnPreviousLayer < 1 ? 1 : numNodesOnPreviousLayer))),
+	transposedWeights(NumericalArray<float>::newClear(weights.size())),
+	thresholds(NumericalArray<float>::newClear(numNodes < 1 ? 1 : numNodes)),
+	outputVector(NumericalArray<float>::newClear(thresholds.size())),
 	inputVector(NumericalArray<float>::newClear(numNodesOnPreviousLayer < 1 ? 1 : numNodesOnPreviousLayer)),
 	adjustVector(NumericalArray<float>::newClear(inputVector.size()))
 {	
-	const int numWeights = inputVector.size();
-	const int size = nodes.size();
-	for(int i = 0; i < size; i++)
-	{
-		nodes[i] = NeuralNode(numWeights);
-	}
+	init(NeuralNodeSimpleInternal::defaultWeight);
 }
 
 void NeuralLayerSimpleInternal::init(const float weightMaximum) throw()
 {
-	const int size = nodes.size();
-	for(int i = 0; i < size; i++)
+	// same order as the nodes used so the same seed gives the same network
+	const int numNodes = getNumNodes();
+	const int numWeights = getNumInputs();
+	for(int node = 0; node < numNodes; node++)
 	{
-		nodes[i].init(weightMaximum);
+		thresholds[node] = std::rand() * randomFactor * 2 * weightMaximum - weightMaximum;
+		
+		float *weightsPtr = weights.getArray() + node * numWeights;
+		for(int i = 0; i < numWeights; i++)
+		{
+			weightsPtr[i] = std::rand() * randomFactor * 2 * weightMaximum - weightMaximum;
+		}
 	}
 }
 
 void NeuralLayerSimpleInternal::randomise(const float amount) throw()
 {
-	const int size = nodes.size();
-	for(int i = 0; i < size; i++)
-	{
-		nodes[i].init(amount);
-	}
+	init(amount);
 }
 
 void NeuralLayerSimpleInternal::set(const int node, NumericalArray<float> const& weightVector, const float threshold) throw()
 {
-	nodes[node].set(weightVector, threshold);
+	const int numWeights = getNumInputs();
+	
+	if(weightVector.size() == numWeights)
+	{
+		memcpy(weights.getArray() + node * numWeights, weightVector.getArray(), numWeights * sizeof(float));
+		thresholds[node] = threshold;
+	}
 }
 
 void NeuralLayerSimpleInternal::setThreshold(const int node, const float threshold) throw()
 {
-	nodes[node].setThreshold(threshold);
+	thresholds[node] = threshold;
 }
 
 void NeuralLayerSimpleInternal::setWeight(const int node, const int weightIndex, const float weight) throw()
 {
-	nodes[node].setWeight(weightIndex, weight);
+	weights[node * getNumInputs() + weightIndex] = weight;
 }
 
 void NeuralLayerSimpleInternal::get(const int node, NumericalArray<float> *weightVector, float& threshold) const throw()
 {
-	nodes[node].get(weightVector, threshold); ////xxx
+	const int numWeights = getNumInputs();
+	*weightVector = NumericalArray<float>::withArray(numWeights, weights.getArray() + node * numWeights);
+	threshold = thresholds[node];
 }
 
 NumericalArray<float>& NeuralLayerSimpleInternal::propogate(NumericalArray<float> const& _inputVector) throw()
 {
-	memcpy(inputVector.getArray(), _inputVector.getArray(), inputVector.size() * sizeof(float));
+	propogate(_inputVector.getArray());
+	return outputVector;
+}
+
+const float* NeuralLayerSimpleInternal::propogate(const float* inputValues) throw()
+{
+	const int numWeights = getNumInputs();
+	float* inputVectorPtr = inputVector.getArray();
+	memcpy(inputVectorPtr, inputValues, numWeights * sizeof(float));
 	
 	float* outputVectorPtr = outputVector.getArray();
+	const float* weightsPtr = weights.getArray();
+	const float* thresholdsPtr = thresholds.getArray();
 	
-	NeuralNode *nodesPtr = nodes.getArray();
-	const int size = nodes.size();
-	for(int i = 0; i < size; i++)
+	const int numNodes = getNumNodes();
+	for(int node = 0; node < numNodes; node++)
 	{
-		outputVectorPtr[i] = nodesPtr[i].propogate(inputVector);
+		const float act = dotProduct(weightsPtr + node * numWeights, inputVectorPtr, numWeights) + thresholdsPtr[node];
+		outputVectorPtr[node] = activation(act);
 	}	
 	
-	return outputVector;
+	return outputVectorPtr;
 }
 
 NumericalArray<float>& NeuralLayerSimpleInternal::backProp(NumericalArray<float>& errorVector, const float actFuncOffset, const float learnRate) throw()
 {
-	memset(adjustVector.getArray(), 0, adjustVector.size() * sizeof(float));
+	float* adjustVectorPtr = adjustVector.getArray();
+	const float* inputVectorPtr = inputVector.getArray();
+	const float* outputVectorPtr = outputVector.getArray();
+	const float* errorVectorPtr = errorVector.getArray();
+	float* thresholdsPtr = thresholds.getArray();
 	
-	float* errorVectorPtr = errorVector.getArray();
+	const int numWeights = getNumInputs();
+	memset(adjustVectorPtr, 0, numWeights * sizeof(float));
 	
-	NeuralNode *nodesPtr = nodes.getArray();
-	const int size = nodes.size();
-	for(int i = 0; i < size; i++)
+	const int numNodes = getNumNodes();
+	for(int node = 0; node < numNodes; node++)
 	{
-		nodesPtr[i].backProp(inputVector, errorVectorPtr[i], actFuncOffset, learnRate, adjustVector);
+		const float output = outputVectorPtr[node];
+		const float adjust = errorVectorPtr[node] * (actFuncOffset + (output * (1.f - output)));
+		const float learn = adjust * learnRate;
+		
+		float* weightsPtr = weights.getArray() + node * numWeights;
+		for(int i = 0; i < numWeights; i++)
+		{
+			weightsPtr[i] += inputVectorPtr[i] * learn;
+			adjustVectorPtr[i] += weightsPtr[i] * adjust;
+		}
+		
+		thresholdsPtr[node] += learn;
 	}
 	
 	return adjustVector;
 }
 
+void NeuralLayerSimpleInternal::propogateBlock(const float * const *inputSamples, float * const *outputSamples, const int numSamples) const throw()
+{
+	const int numNodes = getNumNodes();
+	multiplyMatrix(inputSamples, getNumInputs(), outputSamples, numNodes, weights.getArray(), numSamples);
+	
+	const float* thresholdsPtr = thresholds.getArray();
+	for(int node = 0; node < numNodes; node++)
+	{
+		float* outputSamplesPtr = outputSamples[node];
+		const float threshold = thresholdsPtr[node];
+		
+		for(int sample = 0; sample < numSamples; sample++)
+			outputSamplesPtr[sample] = activation(outputSamplesPtr[sample] + threshold);
+	}
+}
+
+void NeuralLayerSimpleInternal::backPropBlock(const float * const *inputSamples, const float * const *outputSamples, 
+											  float * const *errorSamples, float * const *inputErrorSamples, const int numSamples, 
+											  const float actFuncOffset, float *weightGradients, float *thresholdGradients) const throw()
+{
+	const int numNodes = getNumNodes();
+	const int numWeights = getNumInputs();
+	
+	for(int node = 0; node < numNodes; node++)
+	{
+		const float* outputSamplesPtr = outputSamples[node];
+		float* errorSamplesPtr = errorSamples[node];
+		float thresholdGradient = 0.f;
+		
+		for(int sample = 0; sample < numSamples; sample++)
+		{
+			const float output = outputSamplesPtr[sample];
+			const float adjust = errorSamplesPtr[sample] * (actFuncOffset + (output * (1.f - output)));
+			errorSamplesPtr[sample] = adjust;
+			thresholdGradient += adjust;
+		}
+		
+		thresholdGradients[node] += thresholdGradient;
+		
+		float* weightGradientsPtr = weightGradients + node * numWeights;
+		for(int i = 0; i < numWeights; i++)
+		{
+			weightGradientsPtr[i] += dotProduct(errorSamplesPtr, inputSamples[i], numSamples);
+		}
+	}
+	
+	if(inputErrorSamples != 0)
+		multiplyMatrix(errorSamples, numNodes, inputErrorSamples, numWeights, transposedWeights.getArray(), numSamples);
+}
+
+void NeuralLayerSimpleInternal::updateTransposedWeights() throw()
+{
+	const int numNodes = getNumNodes();
+	const int numWeights = getNumInputs();
+	const float* weightsPtr = weights.getArray();
+	float* transposedWeightsPtr = transposedWeights.getArray();
+	
+	for(int node = 0; node < numNodes; node++)
+	{
+		for(int i = 0; i < numWeights; i++)
+		{
+			transposedWeightsPtr[i * numNodes + node] = weightsPtr[node * numWeights + i];
+		}
+	}
+}
+
+void NeuralLayerSimpleInternal::applyGradients(const float *weightGradients, const float *thresholdGradients, const float scale) throw()
+{
+	float* weightsPtr = weights.getArray();
+	const int numWeights = weights.size();
+	for(int i = 0; i < numWeights; i++)
+	{
+		weightsPtr[i] += weightGradients[i] * scale;
+	}
+	
+	float* thresholdsPtr = thresholds.getArray();
+	const int numNodes = getNumNodes();
+	for(int node = 0; node < numNodes; node++)
+	{
+		thresholdsPtr[node] += thresholdGradients[node] * scale;
+	}
+}
+
 
 END_UGEN_NAMESPACE
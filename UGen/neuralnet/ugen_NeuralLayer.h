@@ -60,15 +60,33 @@ public:
 //	virtual void write(TextFileWriter const& file) const = 0;
 	
 	virtual NumericalArray<float>& propogate(NumericalArray<float> const& inputVector) = 0;
+	virtual const float* propogate(const float* inputValues) = 0;
 	virtual NumericalArray<float>& backProp(NumericalArray<float>& errorVector, const float actFuncOffset, const float learnRate) = 0;
+	
+	virtual void propogateBlock(const float * const *inputSamples, float * const *outputSamples, const int numSamples) const = 0;
+	virtual void backPropBlock(const float * const *inputSamples, const float * const *outputSamples, 
+							   float * const *errorSamples, float * const *inputErrorSamples, const int numSamples, 
+							   const float actFuncOffset, float *weightGradients, float *thresholdGradients) const = 0;
+	virtual void updateTransposedWeights() = 0;
+	virtual void applyGradients(const float *weightGradients, const float *thresholdGradients, const float scale) = 0;
 };
 
+/** A layer of nodes with their weights stored as a single matrix.
+ 
+ Each row of the matrix holds one node's weights (i.e., weight i of node n is 
+ weights[n * getNumInputs() + i]) so propogating an input vector is a matrix-vector 
+ product and propogating a block of input vectors is a matrix-matrix product (see
+ SIMD::dotProduct() and SIMD::matrixMix()). Nothing is allocated after construction. 
+ 
+ The activation function and the learning rule are those of NeuralNodeSimpleInternal. 
+ The block methods process many vectors stored as rows of samples (e.g., inputSamples[i][s] 
+ is input i of vector s) and are const so threads may use them at the same time. */
 class NeuralLayerSimpleInternal : public NeuralLayerBaseInternal
 {
 public:
 	NeuralLayerSimpleInternal(const int numNodes, const int numNodesOnPreviousLayer) throw();
 	
-	inline int getNumNodes() const throw() { return nodes.size(); }
+	inline int getNumNodes() const throw() { return outputVector.size(); }
 	inline int getNumInputs() const throw() { return inputVector.size(); }
 	inline int getNumOutputs() const throw() { return outputVector.size(); }
 	
@@ -82,10 +100,34 @@ public:
 //	void write(TextFileWriter const& file) const throw();
 	
 	NumericalArray<float>& propogate(NumericalArray<float> const& inputVector) throw();
+	
+	/** Propogate getNumInputs() values, the returned getNumNodes() outputs are valid until the next call. */
+	const float* propogate(const float* inputValues) throw();
+	
+	/** Adjust the weights for the error of the last propogate(), returning the error for the previous layer. */
 	NumericalArray<float>& backProp(NumericalArray<float>& errorVector, const float actFuncOffset, const float learnRate) throw();
 	
+	/** Propogate numSamples input vectors, outputSamples must not be the same as inputSamples. */
+	void propogateBlock(const float * const *inputSamples, float * const *outputSamples, const int numSamples) const throw();
+	
+	/** Accumulate the gradients for numSamples vectors that were propogated with propogateBlock().
+	 The errorSamples (target minus output) are replaced with the node adjustments and if 
+	 inputErrorSamples is not 0 the error for the previous layer is written there. Requires 
+	 the weights transposed with updateTransposedWeights() after they were last changed. 
+	 The gradients are laid out as the weights and thresholds. */
+	void backPropBlock(const float * const *inputSamples, const float * const *outputSamples, 
+					   float * const *errorSamples, float * const *inputErrorSamples, const int numSamples, 
+					   const float actFuncOffset, float *weightGradients, float *thresholdGradients) const throw();
+	
+	void updateTransposedWeights() throw();
+	
+	/** Add scale times the gradients to the weights and thresholds. */
+	void applyGradients(const float *weightGradients, const float *thresholdGradients, const float scale) throw();
+	
 private:
-	NeuralNodeArray nodes;
+	NumericalArray<float> weights;
+	NumericalArray<float> transposedWeights;
+	NumericalArray<float> thresholds;
 	NumericalArray<float> outputVector;
 	NumericalArray<float> inputVector;
 	NumericalArray<float> adjustVector;
@@ -196,6 +238,15 @@ public:
 		else return NumericalArraySpec(0, false);
 	}
 	
+	inline const float* propogate(const float* inputValues) throw()
+	{
+		if(getInternal() != 0)
+		{
+			return getInternal()->propogate(inputValues);
+		}
+		else return 0;
+	}
+	
 	inline NumericalArray<float> backProp(NumericalArray<float>& errorVector, const float actFuncOffset, const float learnRate) throw()
 	{
 		if(getInternal() != 0)
@@ -205,6 +256,41 @@ public:
 		else return NumericalArraySpec(0, false);
 	}
 	
+	inline void propogateBlock(const float * const *inputSamples, float * const *outputSamples, const int numSamples) const throw()
+	{
+		if(getInternal() != 0)
+		{
+			getInternal()->propogateBlock(inputSamples, outputSamples, numSamples);
+		}
+	}
+	
+	inline void backPropBlock(const float * const *inputSamples, const float * const *outputSamples, 
+							  float * const *errorSamples, float * const *inputErrorSamples, const int numSamples, 
+							  const float actFuncOffset, float *weightGradients, float *thresholdGradients) const throw()
+	{
+		if(getInternal() != 0)
+		{
+			getInternal()->backPropBlock(inputSamples, outputSamples, errorSamples, inputErrorSamples, numSamples, 
+										 actFuncOffset, weightGradients, thresholdGradients);
+		}
+	}
+	
+	inline void updateTransposedWeights() throw()
+	{
+		if(getInternal() != 0)
+		{
+			getInternal()->updateTransposedWeights();
+		}
+	}
+	
+	inline void applyGradients(const float *weightGradients, const float *thresholdGradients, const float scale) throw()
+	{
+		if(getInternal() != 0)
+		{
+			getInternal()->applyGradients(weightGradients, thresholdGradients, scale);
+		}
+	}
+	
 };
 
 class NeuralLayerArray : public ObjectArray<NeuralLayer>
@@ -40,6 +40,186 @@
 BEGIN_UGEN_NAMESPACE
 
 #include "ugen_NeuralNetwork.h"
+#include "../core/ugen_Threads.h"
+#include "../basics/ugen_InlineBinaryOps.h"
+
+NeuralNetworkWorkspace::NeuralNetworkWorkspace(IntArray const& structure, const int maximumSamples, const bool forTraining) throw()
+:	structure_(structure.copy()),
+	forTraining_(forTraining),
+	maximumSamples_(ugen::max(1, maximumSamples)),
+	numOutputs_(structure_[structure_.size()-1]),
+	layerOffsets(new int[structure_.size()]),
+	weightOffsets(new int[structure_.size()]),
+	thresholdOffsets(new int[structure_.size()]),
+	numRows(0),
+	numGradients(0),
+	samples(0), errors(0),
+	layerSamples(0), errorSamples(0),
+	gradients(0), errorSums(0)
+{
+	const int numLayers = structure_.size();
+	for(int layer = 0; layer < numLayers; layer++)
+	{
+		layerOffsets[layer] = numRows;
+		numRows += structure_[layer];
+		
+		if(layer < numLayers-1)
+		{
+			const int numWeights = structure_[layer] * structure_[layer+1];
+			weightOffsets[layer] = numGradients;
+			thresholdOffsets[layer] = numGradients + numWeights;
+			numGradients += numWeights + structure_[layer+1];
+		}
+		else
+		{
+			weightOffsets[layer] = thresholdOffsets[layer] = numGradients;
+		}
+	}
+	
+	allocate();
+}
+
+NeuralNetworkWorkspace::~NeuralNetworkWorkspace()
+{
+	free();
+	delete [] gradients;
+	delete [] errorSums;
+	delete [] layerOffsets;
+	delete [] weightOffsets;
+	delete [] thresholdOffsets;
+}
+
+void NeuralNetworkWorkspace::allocate() throw()
+{
+	samples = new float[numRows * maximumSamples_];
+	layerSamples = new float*[numRows];
+	
+	for(int row = 0; row < numRows; row++)
+		layerSamples[row] = samples + row * maximumSamples_;
+	
+	memset(samples, 0, numRows * maximumSamples_ * sizeof(float));
+	
+	if(forTraining_)
+	{
+		errors = new float[numRows * maximumSamples_];
+		errorSamples = new float*[numRows];
+		
+		for(int row = 0; row < numRows; row++)
+			errorSamples[row] = errors + row * maximumSamples_;
+		
+		if(gradients == 0)
+		{
+			gradients = new float[numGradients];
+			errorSums = new float[numOutputs_];
+			clearGradients();
+		}
+	}
+}
+
+void NeuralNetworkWorkspace::free() throw()
+{
+	delete [] samples;
+	delete [] layerSamples;
+	delete [] errors;
+	delete [] errorSamples;
+	samples = errors = 0;
+	layerSamples = errorSamples = 0;
+}
+
+void NeuralNetworkWorkspace::ensureSize(const int maximumSamples) throw()
+{
+	if(maximumSamples > maximumSamples_)
+	{
+		free();
+		maximumSamples_ = maximumSamples;
+		allocate();
+	}
+}
+
+void NeuralNetworkWorkspace::clearGradients() throw()
+{
+	if(gradients != 0)
+	{
+		memset(gradients, 0, numGradients * sizeof(float));
+		memset(errorSums, 0, numOutputs_ * sizeof(float));
+	}
+}
+
+void NeuralNetworkWorkspace::addGradients(NeuralNetworkWorkspace const& other) throw()
+{
+	ugen_assert(other.numGradients == numGradients);
+	
+	if((gradients != 0) && (other.gradients != 0))
+	{
+		for(int i = 0; i < numGradients; i++)
+			gradients[i] += other.gradients[i];
+		
+		const int numOutputs = numOutputs_;
+		for(int i = 0; i < numOutputs; i++)
+			errorSums[i] += other.errorSums[i];
+	}
+}
+
+/** Trains part of each batch for NeuralNetworkSimpleInternal::train(). @internal */
+class NeuralNetworkSimpleInternal::TrainingThread : public UGenThread
+{
+public:
+	TrainingThread(NeuralNetworkSimpleInternal const& network, const int maximumSamples, Semaphore& finished) throw()
+	:	network_(network),
+		workspace(network.getStructure(), maximumSamples, true),
+		finished_(finished),
+		patterns_(0),
+		indices_(0),
+		numPatterns_(0)
+	{
+	}
+	
+	~TrainingThread()
+	{
+		stopThread();
+	}
+	
+	void signalThreadShouldExit() throw()
+	{
+		UGenThread::signalThreadShouldExit();
+		wake.signal();
+	}
+	
+	/** Start training these patterns, finished is signalled when the gradients are ready. */
+	void startBatch(const NeuralPattern* patterns, const int* indices, const int numPatterns) throw()
+	{
+		patterns_ = patterns;
+		indices_ = indices;
+		numPatterns_ = numPatterns;
+		wake.signal();
+	}
+	
+	inline NeuralNetworkWorkspace const& getWorkspace() const throw() { return workspace; }
+	
+	void run()
+	{
+		while(true)
+		{
+			wake.wait();
+			
+			if(threadShouldExit()) 
+				break;
+			
+			workspace.clearGradients();
+			network_.trainBatch(workspace, patterns_, indices_, numPatterns_);
+			finished_.signal();
+		}
+	}
+	
+private:
+	NeuralNetworkSimpleInternal const& network_;
+	NeuralNetworkWorkspace workspace;
+	Semaphore wake;
+	Semaphore& finished_;
+	const NeuralPattern* patterns_;
+	const int* indices_;
+	int numPatterns_;
+};
 
 const float NeuralNetworkSimpleInternal::defaultLearnRate = 0.25f;
 const float NeuralNetworkSimpleInternal::defaultActFuncOffset = 0.01f;
@@ -225,6 +405,33 @@ NumericalArray<float> NeuralNetworkSimpleInternal::propogate(NumericalArray<floa
 	return vector;
 }
 
+void NeuralNetworkSimpleInternal::propogate(const float* inputValues, float* outputValues) throw()
+{
+	const float* values = inputValues;
+	
+	NeuralLayer *layersPtr = layers.getArray();
+	const int size = getNumLayersExcludingInput();
+	for(int i = 0; i < size; i++)
+	{
+		values = layersPtr[i].propogate(values);
+	}
+	
+	memcpy(outputValues, values, numOutputs * sizeof(float));
+}
+
+void NeuralNetworkSimpleInternal::propogateBlock(NeuralNetworkWorkspace& workspace, const int numSamples) const throw()
+{
+	ugen_assert(workspace.getNumLayersIncludingInput() == getNumLayersIncludingInput());
+	ugen_assert(numSamples <= workspace.getMaximumSamples());
+	
+	const NeuralLayer *layersPtr = layers.getArray();
+	const int size = getNumLayersExcludingInput();
+	for(int i = 0; i < size; i++)
+	{
+		layersPtr[i].propogateBlock(workspace.getLayerSamples(i), workspace.getLayerSamples(i+1), numSamples);
+	}	
+}
+
 void NeuralNetworkSimpleInternal::backProp(NumericalArray<float> const& inputVector, NumericalArray<float> const& targetVector) throw()
 {
 	NumericalArray<float> outputVector = propogate(inputVector);	
@@ -248,9 +455,12 @@ void NeuralNetworkSimpleInternal::backProp(NumericalArray<float> const& inputVec
 	}
 }
 
-void NeuralNetworkSimpleInternal::train(NeuralPatternArray const& patterns, const int count) throw()
+double NeuralNetworkSimpleInternal::train(NeuralPatternArray const& patterns, const int count) throw()
 {
 	const NeuralPattern *patternPtr = patterns.getArray();
+	int numTrained = 0;
+	
+	const double startTime = UGenThread::getMillisecondCounterHiRes();
 	
 	if(patternPtr != 0)
 	{
@@ -262,10 +472,190 @@ void NeuralNetworkSimpleInternal::train(NeuralPatternArray const& patterns, cons
 				const NeuralPattern& pattern = patternPtr[patternIndex];
 				
 				if(pattern.getInternal() != 0)
+				{
 					backProp(pattern.getInputVector(), pattern.getOutputVector());
+					numTrained++;
+				}
 			}
 		}
 	}
+	
+	const double seconds = (UGenThread::getMillisecondCounterHiRes() - startTime) * 0.001;
+	return seconds > 0.0 ? numTrained / seconds : 0.0;
+}
+
+void NeuralNetworkSimpleInternal::trainBatch(NeuralNetworkWorkspace& workspace, 
+											 const NeuralPattern* patterns, 
+											 const int* indices, 
+											 const int numPatterns) const throw()
+{
+	const int numLayers = getNumLayersExcludingInput();
+	float* const* inputSamples = workspace.getLayerSamples(0);
+	float* const* outputSamples = workspace.getLayerSamples(numLayers);
+	float* const* outputErrorSamples = workspace.getErrorSamples(numLayers);
+	
+	// use the pattern internals directly to avoid reference counting on several threads
+	for(int sample = 0; sample < numPatterns; sample++)
+	{
+		const NeuralPatternBaseInternal* pattern = patterns[indices[sample]].getInternal();
+		const float* inputVectorPtr = pattern->getInputVector().getArray();
+		const float* targetVectorPtr = pattern->getOutputVector().getArray();
+		
+		for(int input = 0; input < numInputs; input++)
+			inputSamples[input][sample] = inputVectorPtr[input];
+		
+		for(int output = 0; output < numOutputs; output++)
+			outputErrorSamples[output][sample] = targetVectorPtr[output];
+	}
+	
+	propogateBlock(workspace, numPatterns);
+	
+	float* errorSums = workspace.getErrorSums();
+	for(int output = 0; output < numOutputs; output++)
+	{
+		const float* outputSamplesPtr = outputSamples[output];
+		float* errorSamplesPtr = outputErrorSamples[output];
+		float errorSum = 0.f;
+		
+		for(int sample = 0; sample < numPatterns; sample++)
+		{
+			const float error = errorSamplesPtr[sample] - outputSamplesPtr[sample];
+			errorSamplesPtr[sample] = error;
+			errorSum += error;
+		}
+		
+		errorSums[output] += errorSum;
+	}
+	
+	const NeuralLayer *layersPtr = layers.getArray();
+	for(int i = numLayers-1; i >= 0; i--)
+	{
+		layersPtr[i].backPropBlock(workspace.getLayerSamples(i), workspace.getLayerSamples(i+1), 
+								   workspace.getErrorSamples(i+1), i > 0 ? workspace.getErrorSamples(i) : 0, 
+								   numPatterns, actFuncOffset, 
+								   workspace.getWeightGradients(i), workspace.getThresholdGradients(i));
+	}
+}
+
+double NeuralNetworkSimpleInternal::train(NeuralPatternArray const& patterns, 
+										  const int count, 
+										  const int batchSize, 
+										  const int numThreads) throw()
+{
+	const NeuralPattern *patternPtr = patterns.getArray();
+	
+	if((patternPtr == 0) || (count < 1))
+		return 0.0;
+	
+	int numValid = 0;
+	int* indices = new int[patterns.size()];
+	
+	for(int patternIndex = 0; patternIndex < patterns.size(); patternIndex++)
+	{
+		const NeuralPattern& pattern = patternPtr[patternIndex];
+		
+		if((pattern.getNumInputs() == numInputs) && (pattern.getNumOutputs() == numOutputs))
+			indices[numValid++] = patternIndex;
+	}
+	
+	if(numValid == 0)
+	{
+		delete [] indices;
+		return 0.0;
+	}
+	
+	const int numPerBatch = ugen::clip(batchSize, 1, numValid);
+	const int numThreadsToUse = ugen::clip(numThreads > 0 ? numThreads : UGenThread::getNumCPUs(), 1, numPerBatch);
+	
+	if(numPerBatch == 1)
+	{
+		// the online rule (which back propogates each layer's error through its updated weights)
+		// rather than a batch of one which would use the weights from before the update
+		const double startTime = UGenThread::getMillisecondCounterHiRes();
+		
+		for(int iteration = 0; iteration < count; iteration++)
+		{
+			for(int i = 0; i < numValid; i++)
+			{
+				const NeuralPattern& pattern = patternPtr[indices[i]];
+				backProp(pattern.getInputVector(), pattern.getOutputVector());
+			}
+		}
+		
+		const double seconds = (UGenThread::getMillisecondCounterHiRes() - startTime) * 0.001;
+		delete [] indices;
+		return seconds > 0.0 ? (double)numValid * count / seconds : 0.0;
+	}
+	
+	const int numPerThread = (numPerBatch + numThreadsToUse - 1) / numThreadsToUse;
+	const int numWorkers = numThreadsToUse - 1;
+	
+	NeuralNetworkWorkspace workspace(getStructure(), numPerThread, true);
+	Semaphore workersFinished;
+	TrainingThread** workers = numWorkers > 0 ? new TrainingThread*[numWorkers] : 0;
+	
+	for(int i = 0; i < numWorkers; i++)
+	{
+		workers[i] = new TrainingThread(*this, numPerThread, workersFinished);
+		workers[i]->startThread();
+	}
+	
+	NeuralLayer *layersPtr = layers.getArray();
+	const int numLayers = getNumLayersExcludingInput();
+	float* errorVectorPtr = errorVector.getArray();
+	
+	const double startTime = UGenThread::getMillisecondCounterHiRes();
+	
+	for(int iteration = 0; iteration < count; iteration++)
+	{
+		for(int first = 0; first < numValid; first += numPerBatch)
+		{
+			const int numInBatch = ugen::min(numPerBatch, numValid - first);
+			
+			for(int i = 0; i < numLayers; i++)
+				layersPtr[i].updateTransposedWeights();
+			
+			// the calling thread trains the first part of the batch, the workers the rest
+			const int numOnThisThread = ugen::min(numPerThread, numInBatch);
+			int next = first + numOnThisThread;
+			int numWorkersStarted = 0;
+			
+			while((numWorkersStarted < numWorkers) && (next < first + numInBatch))
+			{
+				const int numOnWorker = ugen::min(numPerThread, first + numInBatch - next);
+				workers[numWorkersStarted++]->startBatch(patternPtr, indices + next, numOnWorker);
+				next += numOnWorker;
+			}
+			
+			workspace.clearGradients();
+			trainBatch(workspace, patternPtr, indices + first, numOnThisThread);
+			
+			for(int i = 0; i < numWorkersStarted; i++)
+				workersFinished.wait();
+			
+			for(int i = 0; i < numWorkersStarted; i++)
+				workspace.addGradients(workers[i]->getWorkspace());
+			
+			const float scale = learnRate / numInBatch;
+			
+			for(int i = 0; i < numLayers; i++)
+				layersPtr[i].applyGradients(workspace.getWeightGradients(i), workspace.getThresholdGradients(i), scale);
+			
+			const float* errorSums = workspace.getErrorSums();
+			for(int output = 0; output < numOutputs; output++)
+				errorVectorPtr[output] = errorSums[output] / numInBatch;
+		}
+	}
+	
+	const double seconds = (UGenThread::getMillisecondCounterHiRes() - startTime) * 0.001;
+	
+	for(int i = 0; i < numWorkers; i++)
+		delete workers[i];
+	
+	delete [] workers;
+	delete [] indices;
+	
+	return seconds > 0.0 ? (double)numValid * count / seconds : 0.0;
 }
 
 void NeuralNetwork::read(TextFileReader const& _file) throw()
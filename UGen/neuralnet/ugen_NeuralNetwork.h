@@ -45,6 +45,55 @@
 #include "ugen_NeuralNode.h"
 #include "ugen_NeuralPattern.h"
 
+/** Buffers for propogating (and training) a network on many vectors at once without allocating.
+ 
+ Each layer's values are stored as rows of samples, for example getLayerSamples(0)[i][s] 
+ is input i of vector s and getLayerSamples(getNumLayersIncludingInput()-1)[k][s] is 
+ output k. A NeuralNetworkUGen or training thread should have its own workspace.
+ @see NeuralNetwork::propogateBlock() */
+class NeuralNetworkWorkspace
+{
+public:
+	/** Create buffers for up to maximumSamples vectors of a network with this structure.
+	 If forTraining is true there are also error and gradient buffers for NeuralNetworkSimpleInternal::train(). */
+	NeuralNetworkWorkspace(IntArray const& structure, const int maximumSamples, const bool forTraining = false) throw();
+	~NeuralNetworkWorkspace();
+	
+	/** Reallocate the buffers if more than getMaximumSamples() are needed (i.e., this may allocate). */
+	void ensureSize(const int maximumSamples) throw();
+	
+	inline int getMaximumSamples() const throw()							{ return maximumSamples_;											}
+	inline int getNumLayersIncludingInput() const throw()					{ return structure_.size();											}
+	inline float* const* getLayerSamples(const int layer) const throw()		{ return layerSamples + layerOffsets[layer];							}
+	inline float* const* getErrorSamples(const int layer) const throw()		{ return errorSamples != 0 ? errorSamples + layerOffsets[layer] : 0;	}
+	inline float* getWeightGradients(const int layer) const throw()			{ return gradients + weightOffsets[layer];							}
+	inline float* getThresholdGradients(const int layer) const throw()		{ return gradients + thresholdOffsets[layer];						}
+	inline float* getErrorSums() const throw()								{ return errorSums;													}
+	
+	/** Clear the gradients and error sums. */
+	void clearGradients() throw();
+	
+	/** Add another workspace's gradients and error sums to this one's. */
+	void addGradients(NeuralNetworkWorkspace const& other) throw();
+	
+private:
+	void allocate() throw();
+	void free() throw();
+	
+	const IntArray structure_;
+	const bool forTraining_;
+	int maximumSamples_;
+	const int numOutputs_;
+	int *layerOffsets, *weightOffsets, *thresholdOffsets;
+	int numRows, numGradients;
+	float *samples, *errors;
+	float **layerSamples, **errorSamples;
+	float *gradients, *errorSums;
+	
+	NeuralNetworkWorkspace (const NeuralNetworkWorkspace&);
+    const NeuralNetworkWorkspace& operator= (const NeuralNetworkWorkspace&);
+};
+
 class NeuralNetworkBaseInternal : public SmartPointer
 {
 public:
@@ -72,9 +121,12 @@ public:
 	virtual void write(TextFileWriter const& file) const = 0;
 	
 	virtual NumericalArray<float> propogate(NumericalArray<float> const& inputVector) = 0;
+	virtual void propogate(const float* inputValues, float* outputValues) = 0;
+	virtual void propogateBlock(NeuralNetworkWorkspace& workspace, const int numSamples) const = 0;
 	virtual void backProp(NumericalArray<float> const& inputVector, NumericalArray<float> const& targetVector) = 0;
 
-	virtual void train(NeuralPatternArray const& patterns, const int count) = 0;
+	virtual double train(NeuralPatternArray const& patterns, const int count) = 0;
+	virtual double train(NeuralPatternArray const& patterns, const int count, const int batchSize, const int numThreads) = 0;
 };
 
 class NeuralNetworkSimpleInternal : public NeuralNetworkBaseInternal
@@ -114,11 +166,34 @@ public:
 	void write(TextFileWriter const& file) const throw();
 	
 	NumericalArray<float> propogate(NumericalArray<float> const& inputVector) throw();
+	
+	/** Propogate getNumInputs() values to getNumOutputs() values without allocating. */
+	void propogate(const float* inputValues, float* outputValues) throw();
+	
+	/** Propogate the first numSamples vectors in the workspace's input layer to its output layer.
+	 This doesn't change the network so many threads may use it with their own workspaces. */
+	void propogateBlock(NeuralNetworkWorkspace& workspace, const int numSamples) const throw();
+	
 	void backProp(NumericalArray<float> const& inputVector, NumericalArray<float> const& targetVector) throw();
 	
-	void train(NeuralPatternArray const& patterns, const int count) throw();
+	/** Train by back propogating each pattern in turn count times.
+	 @return The number of patterns trained per second. */
+	double train(NeuralPatternArray const& patterns, const int count) throw();
+	
+	/** Train in mini-batches count times over the patterns.
+	 The gradients of batchSize patterns at a time are averaged and applied once per batch. Each 
+	 batch is split between numThreads threads including the calling thread (or one thread 
+	 per CPU if numThreads is less than 1). getErrorVector() is the mean error of the last batch.
+	 A batchSize of 1 is the same as train(patterns, count) (on the calling thread) except that
+	 patterns with the wrong number of inputs or outputs are skipped.
+	 @return The number of patterns trained per second. */
+	double train(NeuralPatternArray const& patterns, const int count, const int batchSize, const int numThreads) throw();
 	
 private:
+	class TrainingThread;
+	
+	void trainBatch(NeuralNetworkWorkspace& workspace, const NeuralPattern* patterns, const int* indices, const int numPatterns) const throw();
+	
 	float learnRate, actFuncOffset;
 	NeuralLayerArray layers;
 	int numInputs;
@@ -335,6 +410,25 @@ public:
 		else return NumericalArraySpec(0, false);		
 	}
 		
+	/** Propogate getNumInputs() values to getNumOutputs() values without allocating. */
+	inline void propogate(const float* inputValues, float* outputValues) throw()
+	{
+		if(getInternal() != 0)
+		{
+			getInternal()->propogate(inputValues, outputValues); 
+		} 
+	}
+	
+	/** Propogate numSamples vectors at once (e.g., per sample inference at audio rate). 
+	 @see NeuralNetworkWorkspace */
+	inline void propogateBlock(NeuralNetworkWorkspace& workspace, const int numSamples) const throw()
+	{
+		if(getInternal() != 0)
+		{
+			getInternal()->propogateBlock(workspace, numSamples); 
+		} 
+	}
+		
 	inline void backProp(NumericalArray<float> const& inputVector, NumericalArray<float> const& targetVector) throw()
 	{
 		if(getInternal() != 0)
@@ -343,12 +437,25 @@ public:
 		} 
 	}
 	
-	inline void train(NeuralPatternArray const& patterns, const int count = 1) throw()
+	/** @return The number of patterns trained per second. */
+	inline double train(NeuralPatternArray const& patterns, const int count = 1) throw()
+	{
+		if(getInternal() != 0)
+		{
+			return getInternal()->train(patterns, count); 
+		} 
+		else return 0.0;
+	}
+	
+	/** Mini-batch training on multiple threads, @see NeuralNetworkSimpleInternal::train()
+	 @return The number of patterns trained per second. */
+	inline double train(NeuralPatternArray const& patterns, const int count, const int batchSize, const int numThreads = 0) throw()
 	{
 		if(getInternal() != 0)
 		{
-			getInternal()->train(patterns, count); 
+			return getInternal()->train(patterns, count, batchSize, numThreads); 
 		} 
+		else return 0.0;
 	}
 	
 };
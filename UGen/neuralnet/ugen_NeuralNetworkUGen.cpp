@@ -52,7 +52,7 @@ NeuralNetworkUGenUGenInternal::NeuralNetworkUGenUGenInternal(UGen const& input,
 	network(_network),
 	patterns(_patterns),
 	inputVector(NumericalArray<float>::newClear(network.getNumInputs())),
-	outputVector(network.propogate(inputVector)),
+	outputVector(NumericalArray<float>::newClear(network.getNumOutputs())),
 	targetVector(NumericalArray<float>::newClear(network.getNumOutputs())),
 	lastTrig(0.f),
 	lastPatternTrig(0.f),
@@ -64,6 +64,8 @@ NeuralNetworkUGenUGenInternal::NeuralNetworkUGenUGenInternal(UGen const& input,
 	inputs[Trig] = trig;
 	inputs[Target] = target;
 	inputs[PatternTrig] = patternTrig;
+	
+	network.propogate(inputVector.getArray(), outputVector.getArray());
 }
 
 NeuralNetworkUGenUGenInternal::~NeuralNetworkUGenUGenInternal()
@@ -105,7 +107,7 @@ void NeuralNetworkUGenUGenInternal::processBlock(bool& shouldDelete, const unsig
 				inputVector[input] = inputValue;
 			}
 			
-			outputVector = network.propogate(inputVector);
+			network.propogate(inputVector.getArray(), outputVector.getArray());
 		}
 		
 		if(thisPatternTrig > 0.f && lastPatternTrig <= 0.f)
@@ -127,9 +129,10 @@ void NeuralNetworkUGenUGenInternal::processBlock(bool& shouldDelete, const unsig
 		lastTrig = thisTrig;
 		lastPatternTrig = thisPatternTrig;
 		
+		const float* outputVectorPtr = outputVector.getArray();
 		for(int channel = 0; channel < getNumChannels(); channel++)
 		{
-			outputSampleData[channel][sample] = outputVector[channel];
+			outputSampleData[channel][sample] = outputVectorPtr[channel];
 		}
 	}
 }
@@ -156,5 +159,58 @@ NeuralNetworkUGen::NeuralNetworkUGen(UGen const& input,
 }
 
 
+NeuralNetworkMapUGenInternal::NeuralNetworkMapUGenInternal(UGen const& input, NeuralNetwork const& _network) throw()
+:	ProxyOwnerUGenInternal(NumInputs, _network.getNumOutputs()-1),
+	network(_network),
+	workspace(network.getStructure(), UGen::getEstimatedBlockSize()),
+	numNetworkInputs(network.getNumInputs()),
+	numNetworkOutputs(network.getNumOutputs())
+{
+	inputs[Input] = input;
+}
+
+void NeuralNetworkMapUGenInternal::prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int /*channel*/) throw()
+{
+	inputs[Input].prepareForBlock(actualBlockSize, blockID, -1);
+}
+
+void NeuralNetworkMapUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
+{
+	const int blockSize = uGenOutput.getBlockSize();
+	
+	workspace.ensureSize(blockSize);
+	
+	float* const* inputSamples = workspace.getLayerSamples(0);
+	for(int input = 0; input < numNetworkInputs; input++)
+	{
+		memcpy(inputSamples[input], inputs[Input].processBlock(shouldDelete, blockID, input), blockSize * sizeof(float));
+	}
+	
+	network.propogateBlock(workspace, blockSize);
+	
+	float* const* outputSamples = workspace.getLayerSamples(workspace.getNumLayersIncludingInput()-1);
+	for(int output = 0; output < numNetworkOutputs; output++)
+	{
+		memcpy(proxies[output]->getSampleData(), outputSamples[output], blockSize * sizeof(float));
+	}
+}
+
+void NeuralNetworkMapUGenInternal::addDependencies(UGenDependencies& dependencies, const int /*channel*/) throw()
+{
+	for(int input = 0; input < numNetworkInputs; input++)
+		dependencies.add(inputs[Input], input);
+}
+
+NeuralNetworkMap::NeuralNetworkMap(UGen const& input, NeuralNetwork const& network) throw()
+{
+	const int numNetworkOutputs = network.getNumOutputs();
+	
+	NeuralNetworkMapUGenInternal *internal = 
+		new NeuralNetworkMapUGenInternal(input.withNumChannels(network.getNumInputs(), true), network);
+	
+	initInternal(numNetworkOutputs);
+	generateFromProxyOwner(internal);
+}
+
 
 END_UGEN_NAMESPACE
@@ -41,6 +41,9 @@
 #include "../core/ugen_UGen.h"
 #include "ugen_NeuralNetwork.h"
 
+/** Propogates the input through a network when triggered and records training patterns.
+ Propogating doesn't allocate, recording a pattern does since it adds to the pattern array.
+ @ingroup UGenInternals */
 class NeuralNetworkUGenUGenInternal : public ProxyOwnerUGenInternal
 {
 public:
@@ -78,6 +81,43 @@ UGenSublcassDeclarationNoDefault(NeuralNetworkUGen,
 								  NeuralPatternArray const& patterns),
 								 COMMON_UGEN_DOCS);
 
+/** Propogates every sample frame of the input through a network.
+ Each block is propogated as a matrix of inputs (one row per input channel) so this doesn't 
+ allocate unless the block size grows beyond that when it was created.
+ @ingroup UGenInternals */
+class NeuralNetworkMapUGenInternal : public ProxyOwnerUGenInternal
+{
+public:
+	NeuralNetworkMapUGenInternal(UGen const& input, NeuralNetwork const& network) throw();
+	
+	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
+	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	void addDependencies(UGenDependencies& dependencies, const int channel) throw(); // all channels are processed together
+	
+	enum Inputs { Input, NumInputs };
+	
+protected:
+	NeuralNetwork network;
+	NeuralNetworkWorkspace workspace;
+	const int numNetworkInputs;
+	const int numNetworkOutputs;
+};
+
+#define NeuralNetworkMap_Docs	@param input	The input vector, one channel per network input (wrapping round	\
+												if there are fewer channels).									\
+								@param network	The network, this has one output channel per network output.
+
+/** Maps the input through a neural network at audio rate.
+ Unlike NeuralNetworkUGen which propogates when triggered, this propogates every sample 
+ (e.g., for a network trained as a waveshaper or timbre mapping). Training the network 
+ on another thread while this is running will give glitches, train a copy instead.
+ @ingroup AllUGens
+ @see NeuralNetworkUGen, NeuralNetwork::propogateBlock() */
+UGenSublcassDeclarationNoDefault(NeuralNetworkMap, 
+								 (input, network), 
+								 (UGen const& input, NeuralNetwork const& network),
+								 COMMON_UGEN_DOCS NeuralNetworkMap_Docs);
+
 
 
 #endif // _UGEN_ugen_NeuralNetworkUGen_H_
@@ -46,7 +46,7 @@ BEGIN_UGEN_NAMESPACE
 BrownNoiseUGenInternal::BrownNoiseUGenInternal() throw()
 :	UGenInternal(NoInputs),
 	//random((unsigned int)this * 123463463UL + 423815L + rand(455563)),
-	random(rand(0x7fffffff)),
+	random(Ran088::getInstanceSeed()),
 	currentValue(random.nextBiFloat())
 {
 	initValue(currentValue);
@@ -57,12 +57,11 @@ void BrownNoiseUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned
 	int numSamplesToProcess = uGenOutput.getBlockSize();
 	float* outputSamples = uGenOutput.getSampleData();
 	
-	unsigned int s1, s2, s3;
-	random.get(s1, s2, s3);
+	random.nextFloat8(outputSamples, numSamplesToProcess);
 	
 	while(numSamplesToProcess--)
 	{
-		currentValue += Ran088::nextFloat8(s1, s2, s3);
+		currentValue += *outputSamples;
 		if (currentValue > 1.f) 
 			currentValue = 2.f - currentValue; 
 		else if (currentValue < -1.f) 
@@ -70,8 +69,6 @@ void BrownNoiseUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned
 		
 		*outputSamples++ = currentValue;
 	}
-	
-	random.set(s1, s2, s3);
 }
 
 BrownNoise::BrownNoise() throw()
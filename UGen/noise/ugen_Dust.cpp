@@ -46,7 +46,7 @@ BEGIN_UGEN_NAMESPACE
 DustUGenInternal::DustUGenInternal(Dust_InputsWithTypesOnly) throw()
 :	UGenInternal(NumInputs),
 	//random((unsigned int)this * 823487UL + 18493UL + rand(1296)),
-	random(rand(0x7fffffff)),
+	random(Ran088::getInstanceSeed()),
 	prevDensity(0.f),
 	threshold(0.f),
 	scale(0.f)
@@ -65,17 +65,16 @@ void DustUGenInternal::processBlock(bool& shouldDelete, const unsigned int block
 	float* outputSamples = uGenOutput.getSampleData();
 	float currentDensity = *(inputs[Density].processBlock(shouldDelete, blockID, channel));
 	
-	unsigned int s1, s2, s3;
-	random.get(s1, s2, s3);
-	
 	if (currentDensity != prevDensity) {
 		threshold = currentDensity * UGen::getReciprocalSampleRate();
 		scale  = threshold > 0.f ? 1.f / threshold : 0.f;
 	}
 	
+	random.nextFloat(outputSamples, numSamplesToProcess);
+	
 	while(numSamplesToProcess--)
 	{
-		float value = Ran088::nextFloat(s1, s2, s3);
+		float value = *outputSamples;
 		if(value < threshold)
 			*outputSamples++ = value * scale;
 		else
@@ -83,7 +82,6 @@ void DustUGenInternal::processBlock(bool& shouldDelete, const unsigned int block
 	}
 	
 	prevDensity = currentDensity;
-	random.set(s1, s2, s3);
 }
 
 Dust2UGenInternal::Dust2UGenInternal(Dust_InputsWithTypesOnly) throw()
@@ -102,17 +100,16 @@ void Dust2UGenInternal::processBlock(bool& shouldDelete, const unsigned int bloc
 	float* outputSamples = uGenOutput.getSampleData();
 	float currentDensity = *(inputs[Density].processBlock(shouldDelete, blockID, channel));
 	
-	unsigned int s1, s2, s3;
-	random.get(s1, s2, s3);
-	
 	if (currentDensity != prevDensity) {
 		threshold = currentDensity * UGen::getReciprocalSampleRate();
 		scale  = threshold > 0.f ? 2.f / threshold : 0.f;
 	}
 	
+	random.nextFloat(outputSamples, numSamplesToProcess);
+	
 	while(numSamplesToProcess--)
 	{
-		float value = Ran088::nextFloat(s1, s2, s3);
+		float value = *outputSamples;
 		if(value < threshold)
 			*outputSamples++ = value * scale - 1.f;
 		else
@@ -120,7 +117,6 @@ void Dust2UGenInternal::processBlock(bool& shouldDelete, const unsigned int bloc
 	}
 	
 	prevDensity = currentDensity;
-	random.set(s1, s2, s3);	
 }
 
 Dust::Dust(Dust_InputsWithTypesOnly) throw()
@@ -57,7 +57,7 @@ public:
 	enum Inputs { Density, NumInputs };
 	
 protected:
-	Ran088 random;
+	Ran088Block random;
 	float prevDensity, threshold, scale;
 };
 
@@ -47,7 +47,7 @@ BEGIN_UGEN_NAMESPACE
 LFNoise0UGenInternal::LFNoise0UGenInternal(UGen const& freq) throw()
 :	UGenInternal(NumInputs),
 	//random((unsigned int)this * 123463463UL + 423815L + rand(92557)),
-	random(rand(0x7fffffff)),
+	random(Ran088::getInstanceSeed()),
 	currentValue(random.nextBiFloat()),
 	counter(0)
 {
@@ -93,7 +93,7 @@ void LFNoise0UGenInternal::processBlock(bool& shouldDelete, const unsigned int b
 LFNoise1UGenInternal::LFNoise1UGenInternal(UGen const& freq) throw()
 :	UGenInternal(NumInputs),
 	//random((unsigned int)this * 123463463UL + 423815L + rand(54288)),
-	random(rand(0x7fffffff)),
+	random(Ran088::getInstanceSeed()),
 	currentValue(random.nextBiFloat()),
 	slope(0.f),
 	counter(0)
@@ -142,7 +142,7 @@ void LFNoise1UGenInternal::processBlock(bool& shouldDelete, const unsigned int b
 LFNoise2UGenInternal::LFNoise2UGenInternal(UGen const& freq) throw()
 :	UGenInternal(NumInputs),
 	//random((unsigned int)this * 123463463UL + 423815L + rand(8277)),
-	random(rand(0x7fffffff)),
+	random(Ran088::getInstanceSeed()),
 	currentValue(random.nextBiFloat()),
 	nextValue(random.nextBiFloat()),
 	nextMidPoint(nextValue * 0.5f),
@@ -47,46 +47,50 @@ BEGIN_UGEN_NAMESPACE
 PinkNoiseUGenInternal::PinkNoiseUGenInternal() throw()
 :	UGenInternal(NoInputs),
 	//random((unsigned int)this * 123463463UL + 423815L + rand(19469146))
-	random(rand(0x7fffffff))
+	random(Ran088::getInstanceSeed()),
+	total(0)
 {	
-	unsigned int s1, s2, s3;
-	random.get(s1, s2, s3);
+	random.next(values, 16);
 	
 	for (int i = 0; i < 16; ++i) 
 	{
-		unsigned int r = Ran088::next(s1, s2, s3) >> 13;
+		unsigned int r = values[i] >> 13;
 		total += r;
 		dice[i] = r;
 	}	
 	
-	random.set(s1, s2, s3);
-	
 	initValue(random.nextBiFloat());
 }
 
 void PinkNoiseUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
 {
-	int numSamplesToProcess = uGenOutput.getBlockSize();
+	int numSamplesRemaining = uGenOutput.getBlockSize();
 	float* outputSamples = uGenOutput.getSampleData();
 	
-	unsigned int s1, s2, s3;
-	random.get(s1, s2, s3);
-	
-	while(numSamplesToProcess--)
+	while(numSamplesRemaining > 0)
 	{
-		unsigned int counter = Ran088::next(s1, s2, s3);
-		unsigned int newrand = counter >> 13;
-		int k = Bits::countTrailingZeros(counter) & 15; 
-		unsigned int prevrand = dice[k]; 
-		dice[k] = newrand; 
-		total += (newrand - prevrand); 
-		newrand = Ran088::next(s1,s2,s3) >> 13;
-		Element val;
-		val.u = (total + newrand) | 0x40000000;
-		*outputSamples++ = (val.f - 3.f);
+		// two random values per sample
+		const int numSamplesThisTime = min(numSamplesRemaining, numElementsInArray(values) / 2);
+		random.next(values, numSamplesThisTime * 2);
+		
+		const unsigned int* randomValues = values;
+		
+		for(int i = 0; i < numSamplesThisTime; i++)
+		{
+			unsigned int counter = *randomValues++;
+			unsigned int newrand = counter >> 13;
+			int k = Bits::countTrailingZeros(counter) & 15; 
+			unsigned int prevrand = dice[k]; 
+			dice[k] = newrand; 
+			total += (newrand - prevrand); 
+			newrand = *randomValues++ >> 13;
+			Element val;
+			val.u = (total + newrand) | 0x40000000;
+			*outputSamples++ = (val.f - 3.f);
+		}
+		
+		numSamplesRemaining -= numSamplesThisTime;
 	}
-	
-	random.set(s1, s2, s3);
 }
 
 PinkNoise::PinkNoise() throw()
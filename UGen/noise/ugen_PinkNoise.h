@@ -52,9 +52,10 @@ public:
 	enum Inputs { NoInputs };
 	
 protected:
-	Ran088 random;
+	Ran088Block random;
 	unsigned long dice[16];
 	long total;
+	unsigned int values[128];
 };
 
 /** Pink noise generator.
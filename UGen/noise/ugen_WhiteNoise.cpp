@@ -46,25 +46,14 @@ BEGIN_UGEN_NAMESPACE
 WhiteNoiseUGenInternal::WhiteNoiseUGenInternal() throw()
 :	UGenInternal(NoInputs),
 	//random((unsigned int)this * 123463463UL + 423815L + rand(34958743))
-	random(rand(0x7fffffff))
+	random(Ran088::getInstanceSeed())
 {
 	initValue(random.nextBiFloat());
 }
 
 void WhiteNoiseUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
 {
-	int numSamplesToProcess = uGenOutput.getBlockSize();
-	float* outputSamples = uGenOutput.getSampleData();
-	
-	unsigned int s1, s2, s3;
-	random.get(s1, s2, s3);
-		
-	while(numSamplesToProcess--)
-	{
-		*outputSamples++ = Ran088::nextBiFloat(s1, s2, s3);
-	}
-	
-	random.set(s1, s2, s3);
+	random.nextBiFloat(uGenOutput.getSampleData(), uGenOutput.getBlockSize());
 }
 
 WhiteNoise::WhiteNoise() throw()
@@ -52,7 +52,7 @@ public:
 	enum Inputs { NoInputs };
 	
 protected:
-	Ran088 random;
+	Ran088Block random;
 };
 
 /** White noise generator.
@@ -49,7 +49,7 @@ TableOscUGenInternal::TableOscUGenInternal(UGen const& freq,
 :	UGenInternal(NumInputs),
 	table_(table),
 	wavetableSize(table_.size()),
-	wavetable(table_.getData(0)),
+	wavetable(table_.getDataReadOnly(0)),
 	currentPhase((initialPhase < 0.f) || (initialPhase >= 1.f) ? 0.f : initialPhase * wavetableSize)
 {
 	ugen_assert(initialPhase >= 0.f && initialPhase <= 1.f);
@@ -70,8 +70,17 @@ UGenInternal* TableOscUGenInternal::getKr() throw()
 	return new TableOscUGenInternalK(inputs[Freq].kr(), currentPhase, table_); 
 }
 
+void TableOscUGenInternal::handleBuffer(Buffer const& table, const double value1, const int value2)
+{
+	if(table.size() < 2) { ugen_assertfalse; return; }
+	
+	AtomicBufferReceiver::handleBuffer(table, value1, value2);
+}
+
 void TableOscUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw()
 {	
+	acquireTable();
+	
 	float tableSizeOverSampleRate = UGen::getReciprocalSampleRate() * wavetableSize;
 	int numSamplesToProcess = uGenOutput.getBlockSize();
 	float* outputSamples = uGenOutput.getSampleData();
@@ -118,6 +127,8 @@ TableOscUGenInternalK::TableOscUGenInternalK(UGen const& freq,
 
 void TableOscUGenInternalK::processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw()
 {	
+	acquireTable();
+	
 	const int krBlockSize = UGen::getControlRateBlockSize();
 	unsigned int blockPosition = blockID % krBlockSize;
 	double krBlockSizeOverSampleRate = UGen::getReciprocalSampleRate() * krBlockSize;
@@ -42,7 +42,8 @@
 #include "../../basics/ugen_MulAdd.h"
 
 /** @ingroup UGenInternals */
-class TableOscUGenInternal :	public UGenInternal
+class TableOscUGenInternal :	public UGenInternal,
+								public AtomicBufferReceiver
 {
 public:
 	TableOscUGenInternal(UGen const& freq, const float initialPhase, Buffer const& table) throw();
@@ -50,6 +51,9 @@ public:
 	UGenInternal* getKr() throw();															
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
 	
+	/** Replace the wavetable, the phase is scaled if the new table is a different size. */
+	void handleBuffer(Buffer const& table, const double value1, const int value2);
+	
 	double getDuration() const throw();
 	double getPosition() const throw();
 	bool setPosition(const double newPosition) throw();	
@@ -79,6 +83,19 @@ protected:
 //		return value0 + frac * (value1 - value0);
 //	}
 	
+	/** Swap in a wavetable sent to handleBuffer(), this is called at the start of each block. */
+	inline void acquireTable() throw()
+	{
+		if(acquireBuffer(table_))
+		{
+			const float newSize = (float)table_.size();
+			currentPhase *= newSize / wavetableSize;
+			if(currentPhase >= newSize) currentPhase = 0.f;
+			wavetableSize = newSize;
+			wavetable = table_.getDataReadOnly(0);
+		}
+	}
+	
 	inline 
 	float lookupIndex(const float fIndex) throw()
 	{
@@ -89,8 +106,8 @@ protected:
 	}
 	
 	Buffer table_;
-	const float wavetableSize;
-	float *wavetable;
+	float wavetableSize;
+	const float *wavetable;
 	float currentPhase;
 };
 
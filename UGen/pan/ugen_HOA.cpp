@@ -0,0 +1,681 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+
+#include "../core/ugen_StandardHeader.h"
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_HOA.h"
+#include "../basics/ugen_InlineUnaryOps.h"
+#include "../basics/ugen_InlineBinaryOps.h"
+
+#ifdef UGEN_SIMD
+	#include "../vec/ugen_simd_Utilities.h"
+#endif
+
+int HOAUtilities::getOrderForChannels(const int numChannels) throw()
+{
+	int order = 1;
+	
+	while((order < MaxOrder) && (getNumHarmonics(order) < numChannels))
+		order++;
+	
+	return order;
+}
+
+int HOAUtilities::getRotationSize(const int order) throw()
+{
+	int size = 0;
+	
+	for(int l = 0; l <= order; l++)
+		size += (2 * l + 1) * (2 * l + 1);
+	
+	return size;
+}
+
+void HOAUtilities::calculateHarmonics(const int order, const int numDirections, 
+									  const float* azimuths, const float* elevations, 
+									  float* harmonics) throw()
+{
+	ugen_assert(order > 0 && order <= MaxOrder);
+	
+	// SN3D normalisation of each degree l and order m >= 0
+	float normalisation[MaxOrder + 1][MaxOrder + 1];
+	
+	for(int l = 0; l <= order; l++)
+	{
+		for(int m = 0; m <= l; m++)
+		{
+			double ratio = 1.0; // (l-m)! / (l+m)!
+			
+			for(int i = l - m + 1; i <= l + m; i++)
+				ratio /= i;
+			
+			normalisation[l][m] = (float)sqrt((m == 0 ? 1.0 : 2.0) * ratio);
+		}
+	}
+	
+	float cosElevation[BatchSize], sinElevation[BatchSize];
+	float cosAzimuth[MaxOrder + 1][BatchSize], sinAzimuth[MaxOrder + 1][BatchSize];
+	float legendre[MaxOrder + 1][MaxOrder + 1][BatchSize]; // [l][m], without the Condon-Shortley phase
+	
+	for(int first = 0; first < numDirections; first += BatchSize)
+	{
+		const int count = ugen::min((int)BatchSize, numDirections - first);
+		int n;
+		
+		for(n = 0; n < count; n++)
+		{
+			// anticlockwise azimuths for the harmonics
+			cosAzimuth[0][n] = 1.f;
+			sinAzimuth[0][n] = 0.f;
+			cosAzimuth[1][n] = cos(-azimuths[first + n]);
+			sinAzimuth[1][n] = sin(-azimuths[first + n]);
+			cosElevation[n] = cos(elevations[first + n]);
+			sinElevation[n] = sin(elevations[first + n]);
+			legendre[0][0][n] = 1.f;
+		}
+		
+		// cos(m a) and sin(m a) from the Chebyshev recurrence
+		for(int m = 2; m <= order; m++)
+		{
+			for(n = 0; n < count; n++)
+			{
+				cosAzimuth[m][n] = 2.f * cosAzimuth[1][n] * cosAzimuth[m - 1][n] - cosAzimuth[m - 2][n];
+				sinAzimuth[m][n] = 2.f * cosAzimuth[1][n] * sinAzimuth[m - 1][n] - sinAzimuth[m - 2][n];
+			}
+		}
+		
+		for(int m = 1; m <= order; m++)
+		{
+			const float factor = (float)(2 * m - 1);
+			
+			for(n = 0; n < count; n++)
+				legendre[m][m][n] = factor * cosElevation[n] * legendre[m - 1][m - 1][n];
+		}
+		
+		for(int m = 0; m < order; m++)
+		{
+			const float factor = (float)(2 * m + 1);
+			
+			for(n = 0; n < count; n++)
+				legendre[m + 1][m][n] = factor * sinElevation[n] * legendre[m][m][n];
+			
+			for(int l = m + 2; l <= order; l++)
+			{
+				const float factor1 = (float)(2 * l - 1) / (float)(l - m);
+				const float factor2 = (float)(l + m - 1) / (float)(l - m);
+				
+				for(n = 0; n < count; n++)
+					legendre[l][m][n] = factor1 * sinElevation[n] * legendre[l - 1][m][n] - factor2 * legendre[l - 2][m][n];
+			}
+		}
+		
+		for(int l = 0; l <= order; l++)
+		{
+			for(int m = -l; m <= l; m++)
+			{
+				const int absM = m < 0 ? -m : m;
+				const float norm = normalisation[l][absM];
+				const float* const legendreLM = legendre[l][absM];
+				const float* const azimuthM = m < 0 ? sinAzimuth[absM] : cosAzimuth[absM];
+				float* const harmonic = harmonics + (l * l + l + m) * numDirections + first;
+				
+				for(n = 0; n < count; n++)
+					harmonic[n] = norm * legendreLM[n] * azimuthM[n];
+			}
+		}
+	}
+}
+
+// the band matrices used for the rotation recurrence, element (i, j) of band l is [l][i + l][j + l]
+typedef double HOABandMatrix[2 * HOAUtilities::MaxOrder + 1][2 * HOAUtilities::MaxOrder + 1];
+
+static inline double hoaBandElement(const HOABandMatrix* bands, const int l, const int i, const int j) throw()
+{
+	return bands[l][i + l][j + l];
+}
+
+static double hoaRotationP(const HOABandMatrix* bands, const int i, const int a, const int b, const int l) throw()
+{
+	if(b == l)
+		return hoaBandElement(bands, 1, i, 1) * hoaBandElement(bands, l - 1, a, l - 1) 
+			 - hoaBandElement(bands, 1, i, -1) * hoaBandElement(bands, l - 1, a, -l + 1);
+	else if(b == -l)
+		return hoaBandElement(bands, 1, i, 1) * hoaBandElement(bands, l - 1, a, -l + 1) 
+			 + hoaBandElement(bands, 1, i, -1) * hoaBandElement(bands, l - 1, a, l - 1);
+	else
+		return hoaBandElement(bands, 1, i, 0) * hoaBandElement(bands, l - 1, a, b);
+}
+
+static double hoaRotationElement(const HOABandMatrix* bands, const int l, const int m, const int n) throw()
+{
+	// Ivanic and Ruedenberg (1996, 1998 errata) for real spherical harmonics
+	const int absM = m < 0 ? -m : m;
+	const int absN = n < 0 ? -n : n;
+	const double d = (m == 0) ? 1.0 : 0.0;
+	const double denominator = (absN == l) ? (2.0 * l * (2.0 * l - 1.0)) : (double)((l + n) * (l - n));
+	
+	const double u = sqrt((l + m) * (l - m) / denominator);
+	const double v = 0.5 * sqrt((1.0 + d) * (l + absM - 1.0) * (l + absM) / denominator) * (1.0 - 2.0 * d);
+	const double w = -0.5 * sqrt((l - absM - 1.0) * (l - absM) / denominator) * (1.0 - d);
+	
+	double result = 0.0;
+	
+	if(u != 0.0)
+		result += u * hoaRotationP(bands, 0, m, n, l);
+	
+	if(v != 0.0)
+	{
+		if(m == 0)
+			result += v * (hoaRotationP(bands, 1, 1, n, l) + hoaRotationP(bands, -1, -1, n, l));
+		else if(m > 0)
+			result += v * (hoaRotationP(bands, 1, m - 1, n, l) * (m == 1 ? sqrt2 : 1.0)
+						   - hoaRotationP(bands, -1, -m + 1, n, l) * (m == 1 ? 0.0 : 1.0));
+		else
+			result += v * (hoaRotationP(bands, 1, m + 1, n, l) * (m == -1 ? 0.0 : 1.0) 
+						   + hoaRotationP(bands, -1, -m - 1, n, l) * (m == -1 ? sqrt2 : 1.0));
+	}
+	
+	if(w != 0.0)
+	{
+		if(m > 0)
+			result += w * (hoaRotationP(bands, 1, m + 1, n, l) + hoaRotationP(bands, -1, -m - 1, n, l));
+		else
+			result += w * (hoaRotationP(bands, 1, m - 1, n, l) - hoaRotationP(bands, -1, -m + 1, n, l));
+	}
+	
+	return result;
+}
+
+void HOAUtilities::calculateRotation(const int order, const float rotate, const float tilt, const float tumble, 
+									 float* matrix) throw()
+{
+	ugen_assert(order > 0 && order <= MaxOrder);
+	
+	// rotation of the (x, y, z) direction as RotateB, TiltB and TumbleB
+	const double cosR = cos(rotate), sinR = sin(rotate);
+	const double cosT = cos(tilt), sinT = sin(tilt);
+	const double cosU = cos(tumble), sinU = sin(tumble);
+	
+	const double rotateMatrix[3][3] = { { cosR, sinR, 0.0 }, { -sinR, cosR, 0.0 }, { 0.0, 0.0, 1.0 } };
+	const double tiltMatrix[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, cosT, sinT }, { 0.0, -sinT, cosT } };
+	const double tumbleMatrix[3][3] = { { cosU, 0.0, sinU }, { 0.0, 1.0, 0.0 }, { -sinU, 0.0, cosU } };
+	
+	double tiltRotate[3][3], direction[3][3];
+	int i, j, k;
+	
+	for(i = 0; i < 3; i++)
+	{
+		for(j = 0; j < 3; j++)
+		{
+			tiltRotate[i][j] = 0.0;
+			
+			for(k = 0; k < 3; k++)
+				tiltRotate[i][j] += tiltMatrix[i][k] * rotateMatrix[k][j];
+		}
+	}
+	
+	for(i = 0; i < 3; i++)
+	{
+		for(j = 0; j < 3; j++)
+		{
+			direction[i][j] = 0.0;
+			
+			for(k = 0; k < 3; k++)
+				direction[i][j] += tumbleMatrix[i][k] * tiltRotate[k][j];
+		}
+	}
+	
+	HOABandMatrix bands[MaxOrder + 1];
+	bands[0][0][0] = 1.0;
+	
+	// the first degree harmonics are in Y, Z, X order
+	static const int axes[3] = { 1, 2, 0 };
+	
+	for(i = 0; i < 3; i++)
+		for(j = 0; j < 3; j++)
+			bands[1][i][j] = direction[axes[i]][axes[j]];
+	
+	for(int l = 2; l <= order; l++)
+		for(int m = -l; m <= l; m++)
+			for(int n = -l; n <= l; n++)
+				bands[l][m + l][n + l] = hoaRotationElement(bands, l, m, n);
+	
+	// the bands are the same for N3D and SN3D as these only differ by a scale per degree
+	for(int l = 0; l <= order; l++)
+	{
+		const int size = 2 * l + 1;
+		
+		for(i = 0; i < size; i++)
+			for(j = 0; j < size; j++)
+				*matrix++ = (float)bands[l][i][j];
+	}
+}
+
+void HOAUtilities::calculateDecoder(const int order, const int numSpeakers, 
+									const float* azimuths, const float* elevations, 
+									const Weighting weighting, 
+									float* matrix) throw()
+{
+	ugen_assert(order > 0 && order <= MaxOrder);
+	
+	const int numHarmonics = getNumHarmonics(order);
+	double weights[MaxOrder + 1];
+	int l;
+	
+	if(weighting == MaxRE)
+	{
+		// Legendre polynomials at the cosine of the max rE spread angle
+		const double x = cos(2.406809 / (order + 1.51));
+		weights[0] = 1.0;
+		weights[1] = x;
+		
+		for(l = 2; l <= order; l++)
+			weights[l] = ((2 * l - 1) * x * weights[l - 1] - (l - 1) * weights[l - 2]) / l;
+	}
+	else if(weighting == InPhase)
+	{
+		// N!(N+1)! / ((N+l+1)!(N-l)!)
+		for(l = 0; l <= order; l++)
+		{
+			double weight = 1.0;
+			
+			for(int i = order - l + 1; i <= order; i++)
+				weight *= i;
+			
+			for(int i = order + 2; i <= order + l + 1; i++)
+				weight /= i;
+			
+			weights[l] = weight;
+		}
+	}
+	else
+	{
+		for(l = 0; l <= order; l++)
+			weights[l] = 1.0;
+	}
+	
+	float* harmonics = new float[numHarmonics * numSpeakers];
+	calculateHarmonics(order, numSpeakers, azimuths, elevations, harmonics);
+	
+	// sampling decoder: the SN3D addition theorem gives the sum over each degree l as P_l(cos angle)
+	const double scale = 1.0 / numSpeakers;
+	
+	for(int speaker = 0; speaker < numSpeakers; speaker++)
+	{
+		for(l = 0; l <= order; l++)
+		{
+			const float gain = (float)(scale * (2 * l + 1) * weights[l]);
+			
+			for(int k = l * l; k < (l + 1) * (l + 1); k++)
+				matrix[speaker * numHarmonics + k] = gain * harmonics[k * numSpeakers + speaker];
+		}
+	}
+	
+	delete [] harmonics;
+}
+
+void HOAUtilities::matrixMix(const float * const *inputSamples, const int numInputs, 
+							 float * const *outputSamples, const int numOutputs, 
+							 const float* gains, const float* slopes, 
+							 const int numSamples, const bool shouldAccumulate) throw()
+{
+#if defined(UGEN_SIMD)
+	SIMD::matrixMix(inputSamples, numInputs, outputSamples, numOutputs, gains, slopes, numSamples, shouldAccumulate);
+#else
+	for(int output = 0; output < numOutputs; output++)
+	{
+		float* const outputs = outputSamples[output];
+		const float* const outputGains = gains + output * numInputs;
+		const float* const outputSlopes = (slopes == 0) ? 0 : slopes + output * numInputs;
+		
+		for(int i = 0; i < numSamples; i++)
+		{
+			const float step = (float)(i + 1);
+			float sum = shouldAccumulate ? outputs[i] : 0.f;
+			
+			for(int input = 0; input < numInputs; input++)
+			{
+				const float gain = (outputSlopes == 0) ? outputGains[input] : outputGains[input] + outputSlopes[input] * step;
+				sum += inputSamples[input][i] * gain;
+			}
+			
+			outputs[i] = sum;
+		}
+	}
+#endif
+}
+
+HOAEncodeUGenInternal::HOAEncodeUGenInternal(UGen const& input, UGen const& azimuth, UGen const& elevation, 
+											 const int order, const int numSources) throw()
+:	ProxyOwnerUGenInternal(NumInputs, HOAUtilities::getNumHarmonics(order) - 1),
+	order_(order),
+	numHarmonics(HOAUtilities::getNumHarmonics(order)),
+	numSources_(numSources),
+	gains(new float[numSources * HOAUtilities::getNumHarmonics(order)]),
+	currentAzimuths(new float[numSources]),
+	currentElevations(new float[numSources])
+{
+	inputs[Input] = input;
+	inputs[Azimuth] = azimuth;
+	inputs[Elevation] = elevation;
+	
+	for(int source = 0; source < numSources_; source++)
+	{
+		currentAzimuths[source] = azimuth.getValue(source);
+		currentElevations[source] = elevation.getValue(source);
+	}
+	
+	// each batch's gains are together in the layout matrixMix() uses: [harmonic][source in the batch]
+	for(int first = 0; first < numSources_; first += HOAUtilities::BatchSize)
+	{
+		const int count = ugen::min((int)HOAUtilities::BatchSize, numSources_ - first);
+		HOAUtilities::calculateHarmonics(order_, count, currentAzimuths + first, currentElevations + first, 
+										 gains + first * numHarmonics);
+	}
+}
+
+HOAEncodeUGenInternal::~HOAEncodeUGenInternal()
+{
+	delete [] gains;
+	delete [] currentAzimuths;
+	delete [] currentElevations;
+}
+
+void HOAEncodeUGenInternal::prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int /*channel*/) throw()
+{
+	// all channels of the inputs are needed by the owner
+	for(unsigned int i = 0; i < numInputs_; i++)
+		inputs[i].prepareForBlock(actualBlockSize, blockID, -1);
+}
+
+void HOAEncodeUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
+{
+	const int numSamplesToProcess = uGenOutput.getBlockSize();
+	const float slopeFactor = 1.f / (float)numSamplesToProcess;
+	float* outputSamples[HOAUtilities::MaxHarmonics];
+	const float* batchInputs[HOAUtilities::BatchSize];
+	float azimuths[HOAUtilities::BatchSize];
+	float elevations[HOAUtilities::BatchSize];
+	
+	for(int harmonic = 0; harmonic < numHarmonics; harmonic++)
+		outputSamples[harmonic] = proxies[harmonic]->getSampleData();
+	
+	for(int first = 0; first < numSources_; first += HOAUtilities::BatchSize)
+	{
+		const int count = ugen::min((int)HOAUtilities::BatchSize, numSources_ - first);
+		const int numGains = count * numHarmonics;
+		float* const batchGains = gains + first * numHarmonics;
+		bool changed = false;
+		
+		for(int i = 0; i < count; i++)
+		{
+			const int source = first + i;
+			batchInputs[i] = inputs[Input].processBlock(shouldDelete, blockID, source);
+			azimuths[i] = *(inputs[Azimuth].processBlock(shouldDelete, blockID, source));
+			elevations[i] = *(inputs[Elevation].processBlock(shouldDelete, blockID, source));
+			
+			if((azimuths[i] != currentAzimuths[source]) || (elevations[i] != currentElevations[source]))
+				changed = true;
+		}
+		
+		if(changed)
+		{
+			HOAUtilities::calculateHarmonics(order_, count, azimuths, elevations, newGains);
+			
+			for(int i = 0; i < numGains; i++)
+				slopes[i] = (newGains[i] - batchGains[i]) * slopeFactor;
+		}
+		
+		HOAUtilities::matrixMix(batchInputs, count, outputSamples, numHarmonics, 
+								batchGains, changed ? slopes : 0, 
+								numSamplesToProcess, first > 0);
+		
+		if(changed)
+		{
+			memcpy(batchGains, newGains, numGains * sizeof(float));
+			memcpy(currentAzimuths + first, azimuths, count * sizeof(float));
+			memcpy(currentElevations + first, elevations, count * sizeof(float));
+		}
+	}
+}
+
+void HOAEncodeUGenInternal::addDependencies(UGenDependencies& dependencies, const int /*channel*/) throw()
+{
+	for(unsigned int i = 0; i < numInputs_; i++)
+	{
+		for(int source = 0; source < numSources_; source++)
+			dependencies.add(inputs[i], source);
+	}
+}
+
+HOAEncode::HOAEncode(UGen const& input, UGen const& azimuth, UGen const& elevation, const int order) throw()
+{
+	const int checkedOrder = ugen::clip(order, 1, (int)HOAUtilities::MaxOrder);
+	const int numSources = ugen::max(ugen::max(input.getNumChannels(), azimuth.getNumChannels()), 
+									 elevation.getNumChannels());
+	
+	initInternal(HOAUtilities::getNumHarmonics(checkedOrder));
+	generateFromProxyOwner(new HOAEncodeUGenInternal(input, azimuth, elevation, checkedOrder, numSources));
+}
+
+HOARotateUGenInternal::HOARotateUGenInternal(UGen const& hoa, UGen const& rotate, UGen const& tilt, UGen const& tumble, 
+											 const int order) throw()
+:	ProxyOwnerUGenInternal(NumInputs, HOAUtilities::getNumHarmonics(order) - 1),
+	order_(order),
+	numHarmonics(HOAUtilities::getNumHarmonics(order)),
+	rotationSize(HOAUtilities::getRotationSize(order)),
+	matrix(new float[HOAUtilities::getRotationSize(order)]),
+	newMatrix(new float[HOAUtilities::getRotationSize(order)]),
+	slopes(new float[HOAUtilities::getRotationSize(order)]),
+	currentRotate(rotate.getValue(0)),
+	currentTilt(tilt.getValue(0)),
+	currentTumble(tumble.getValue(0))
+{
+	inputs[HOA] = hoa; // checked to have numHarmonics channels
+	inputs[Rotate] = rotate;
+	inputs[Tilt] = tilt;
+	inputs[Tumble] = tumble;
+	
+	HOAUtilities::calculateRotation(order_, currentRotate, currentTilt, currentTumble, matrix);
+}
+
+HOARotateUGenInternal::~HOARotateUGenInternal()
+{
+	delete [] matrix;
+	delete [] newMatrix;
+	delete [] slopes;
+}
+
+void HOARotateUGenInternal::prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int /*channel*/) throw()
+{
+	for(unsigned int i = 0; i < numInputs_; i++)
+		inputs[i].prepareForBlock(actualBlockSize, blockID, -1);
+}
+
+void HOARotateUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
+{
+	const int numSamplesToProcess = uGenOutput.getBlockSize();
+	const float* inputSamples[HOAUtilities::MaxHarmonics];
+	float* outputSamples[HOAUtilities::MaxHarmonics];
+	
+	for(int harmonic = 0; harmonic < numHarmonics; harmonic++)
+	{
+		inputSamples[harmonic] = inputs[HOA].processBlock(shouldDelete, blockID, harmonic);
+		outputSamples[harmonic] = proxies[harmonic]->getSampleData();
+	}
+	
+	const float rotate = *(inputs[Rotate].processBlock(shouldDelete, blockID, 0));
+	const float tilt = *(inputs[Tilt].processBlock(shouldDelete, blockID, 0));
+	const float tumble = *(inputs[Tumble].processBlock(shouldDelete, blockID, 0));
+	const bool changed = (rotate != currentRotate) || (tilt != currentTilt) || (tumble != currentTumble);
+	
+	if(changed)
+	{
+		HOAUtilities::calculateRotation(order_, rotate, tilt, tumble, newMatrix);
+		
+		const float slopeFactor = 1.f / (float)numSamplesToProcess;
+		
+		for(int i = 0; i < rotationSize; i++)
+			slopes[i] = (newMatrix[i] - matrix[i]) * slopeFactor;
+	}
+	
+	// each degree only mixes with itself
+	int offset = 0;
+	
+	for(int l = 0; l <= order_; l++)
+	{
+		const int first = l * l;
+		const int size = 2 * l + 1;
+		
+		HOAUtilities::matrixMix(inputSamples + first, size, outputSamples + first, size, 
+								matrix + offset, changed ? slopes + offset : 0, 
+								numSamplesToProcess, false);
+		
+		offset += size * size;
+	}
+	
+	if(changed)
+	{
+		memcpy(matrix, newMatrix, rotationSize * sizeof(float));
+		currentRotate = rotate;
+		currentTilt = tilt;
+		currentTumble = tumble;
+	}
+}
+
+void HOARotateUGenInternal::addDependencies(UGenDependencies& dependencies, const int /*channel*/) throw()
+{
+	for(int harmonic = 0; harmonic < numHarmonics; harmonic++)
+		dependencies.add(inputs[HOA], harmonic);
+	
+	for(unsigned int i = Rotate; i < numInputs_; i++)
+		dependencies.add(inputs[i], 0);
+}
+
+/** Pad a HOA signal with silent channels to a whole number of orders. */
+static UGen hoaChecked(UGen const& hoa, const int order) throw()
+{
+	UGen hoaChecked = hoa;
+	
+	while(hoaChecked.getNumChannels() < HOAUtilities::getNumHarmonics(order))
+	{
+		hoaChecked = UGen(hoaChecked, UGen::getNull());
+	}
+	
+	return hoaChecked;
+}
+
+HOARotate::HOARotate(UGen const& hoa, UGen const& rotate, UGen const& tilt, UGen const& tumble) throw()
+{
+	const int order = HOAUtilities::getOrderForChannels(hoa.getNumChannels());
+	
+	initInternal(HOAUtilities::getNumHarmonics(order));
+	generateFromProxyOwner(new HOARotateUGenInternal(hoaChecked(hoa, order), rotate.mix(), tilt.mix(), tumble.mix(), order));
+}
+
+HOADecodeUGenInternal::HOADecodeUGenInternal(UGen const& hoa, const int order, 
+											 FloatArray const& azimuths, FloatArray const& elevations, 
+											 const int numSpeakers, const HOAUtilities::Weighting weighting) throw()
+:	ProxyOwnerUGenInternal(NumInputs, numSpeakers - 1),
+	numHarmonics(HOAUtilities::getNumHarmonics(order)),
+	numSpeakers_(numSpeakers),
+	matrix(new float[numSpeakers * HOAUtilities::getNumHarmonics(order)]),
+	outputs(new float*[numSpeakers])
+{
+	inputs[HOA] = hoa; // checked to have numHarmonics channels
+	
+	float* speakerAzimuths = new float[numSpeakers_];
+	float* speakerElevations = new float[numSpeakers_];
+	
+	for(int speaker = 0; speaker < numSpeakers_; speaker++)
+	{
+		speakerAzimuths[speaker] = azimuths.wrapAt(speaker);
+		speakerElevations[speaker] = elevations.wrapAt(speaker);
+	}
+	
+	HOAUtilities::calculateDecoder(order, numSpeakers_, speakerAzimuths, speakerElevations, weighting, matrix);
+	
+	delete [] speakerAzimuths;
+	delete [] speakerElevations;
+}
+
+HOADecodeUGenInternal::~HOADecodeUGenInternal()
+{
+	delete [] matrix;
+	delete [] outputs;
+}
+
+void HOADecodeUGenInternal::prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int /*channel*/) throw()
+{
+	inputs[HOA].prepareForBlock(actualBlockSize, blockID, -1);
+}
+
+void HOADecodeUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
+{
+	const int numSamplesToProcess = uGenOutput.getBlockSize();
+	const float* inputSamples[HOAUtilities::MaxHarmonics];
+	
+	for(int harmonic = 0; harmonic < numHarmonics; harmonic++)
+		inputSamples[harmonic] = inputs[HOA].processBlock(shouldDelete, blockID, harmonic);
+	
+	for(int speaker = 0; speaker < numSpeakers_; speaker++)
+		outputs[speaker] = proxies[speaker]->getSampleData();
+	
+	HOAUtilities::matrixMix(inputSamples, numHarmonics, outputs, numSpeakers_, 
+							matrix, 0, numSamplesToProcess, false);
+}
+
+void HOADecodeUGenInternal::addDependencies(UGenDependencies& dependencies, const int /*channel*/) throw()
+{
+	for(int harmonic = 0; harmonic < numHarmonics; harmonic++)
+		dependencies.add(inputs[HOA], harmonic);
+}
+
+HOADecode::HOADecode(UGen const& hoa, FloatArray const& azimuths, FloatArray const& elevations, 
+					 const HOAUtilities::Weighting weighting) throw()
+{
+	const int order = HOAUtilities::getOrderForChannels(hoa.getNumChannels());
+	const int numSpeakers = ugen::max(azimuths.length(), elevations.length());
+	
+	initInternal(numSpeakers);
+	generateFromProxyOwner(new HOADecodeUGenInternal(hoaChecked(hoa, order), order, azimuths, elevations, numSpeakers, weighting));
+}
+
+END_UGEN_NAMESPACE
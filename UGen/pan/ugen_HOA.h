@@ -0,0 +1,246 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+
+#ifndef _UGEN_ugen_HOA_H_
+#define _UGEN_ugen_HOA_H_
+
+#include "../core/ugen_UGen.h"
+
+/** Higher order ambisonic (HOA) utilities.
+ 
+ HOA signals use ACN channel ordering and SN3D normalisation (as the AmbiX format) so channel 
+ l*l + l + m is the spherical harmonic of degree l and order m (-l <= m <= l) and there are 
+ (order+1)*(order+1) channels. The first order channels are W, Y, Z, X with W at unity gain
+ rather than the 0.707 of the B-format used by PanB and DecodeB. Azimuths and elevations use the 
+ same convention as PanB (0 is front, +ve azimuth is clockwise viewed from above, +ve elevation 
+ is up).
+ 
+ Harmonics are calculated using recurrences (for the associated Legendre functions and cos/sin 
+ of multiples of the azimuth) over batches of directions with the directions in the inner loops. 
+ Encoding, rotation and decoding are all a matrix of gains applied using matrixMix().
+ @ingroup UGenInternals */
+class HOAUtilities
+{
+public:
+	enum Limits { MaxOrder = 5, MaxHarmonics = 36, BatchSize = 16 };
+	
+	/** Decoder weightings, applied per degree. */
+	enum Weighting 
+	{ 
+		Basic,		///< Unweighted (sampling) decoder, the sharpest image but with the most out of phase signal.
+		MaxRE,		///< Weights which maximise the energy vector, the usual choice for speaker arrays.
+		InPhase		///< Weights so no speaker is out of phase, for large audiences.
+	};
+	
+	/** Returns the number of channels in a HOA signal of this order. */
+	static int getNumHarmonics(const int order) throw()		{ return (order + 1) * (order + 1); }
+	
+	/** Returns the lowest order which has at least this many channels (from 1 to MaxOrder). */
+	static int getOrderForChannels(const int numChannels) throw();
+	
+	/** Returns the number of gains in the block diagonal rotation matrix of this order. */
+	static int getRotationSize(const int order) throw();
+	
+	/** Calculate the harmonics (i.e., encoding gains) for some directions.
+	 Harmonic k of direction n is stored in harmonics[k * numDirections + n]. */
+	static void calculateHarmonics(const int order, const int numDirections, 
+								   const float* azimuths, const float* elevations, 
+								   float* harmonics) throw();
+	
+	/** Calculate the rotation of a soundfield, as RotateB then TiltB then TumbleB.
+	 There is a square matrix for each degree l of size 2l+1 (in row order) stored one 
+	 after the other in matrix which should have space for getRotationSize(order) values. 
+	 These are calculated using the Ivanic and Ruedenberg recurrence from the first order matrix. */
+	static void calculateRotation(const int order, const float rotate, const float tilt, const float tumble, 
+								  float* matrix) throw();
+	
+	/** Calculate a decoding matrix for a set of loudspeakers.
+	 The gain from harmonic k to speaker s is stored in matrix[s * getNumHarmonics(order) + k]. 
+	 Speaker gains sum to approximately 1 for a source when the speakers are evenly spread. */
+	static void calculateDecoder(const int order, const int numSpeakers, 
+								 const float* azimuths, const float* elevations, 
+								 const Weighting weighting, 
+								 float* matrix) throw();
+	
+	/** Apply a matrix of gains (optionally ramped) as SIMD::matrixMix(). */
+	static void matrixMix(const float * const *inputSamples, const int numInputs, 
+						  float * const *outputSamples, const int numOutputs, 
+						  const float* gains, const float* slopes, 
+						  const int numSamples, const bool shouldAccumulate) throw();
+};
+
+/** Encodes many sources into a single HOA bus.
+ All the sources are accumulated into the outputs in batches of up to HOAUtilities::BatchSize
+ so each output is read and written once per batch rather than once per source.
+ @ingroup UGenInternals */
+class HOAEncodeUGenInternal : public ProxyOwnerUGenInternal
+{
+public:
+	HOAEncodeUGenInternal(UGen const& input, UGen const& azimuth, UGen const& elevation, 
+						  const int order, const int numSources) throw();
+	~HOAEncodeUGenInternal();
+	
+	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
+	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	void addDependencies(UGenDependencies& dependencies, const int channel) throw(); // all channels are processed together
+	
+	enum Inputs { Input, Azimuth, Elevation, NumInputs };
+	
+protected:
+	const int order_;
+	const int numHarmonics;
+	const int numSources_;
+	float* const gains;
+	float* const currentAzimuths;
+	float* const currentElevations;
+	float newGains[HOAUtilities::MaxHarmonics * HOAUtilities::BatchSize];
+	float slopes[HOAUtilities::MaxHarmonics * HOAUtilities::BatchSize];
+};
+
+#define HOAEncode_Doc	@param input		The sources to encode, one per channel.								\
+						@param azimuth		The angle of each source in the horizontal plane in radians.		\
+											0 is front, +ve is clockwise viewed from above.						\
+											DOC_SINGLE															\
+						@param elevation	The angle of each source in the vertical plane in radians.			\
+											0 is ear-level, @f$\frac{\pi}{2}@f$ is directly above the head		\
+											and @f$-\frac{\pi}{2}@f$ is directly below the head.				\
+											DOC_SINGLE															\
+						@param order		The ambisonic order from 1 to 5.
+
+/** Higher order ambisonic encoder.
+ Encodes one or more mono sources into a single HOA signal with (order+1)*(order+1) channels
+ (ACN ordering and SN3D normalisation, see HOAUtilities). Each channel of input is a separate 
+ source, the azimuth and elevation channels are used for the corresponding source (wrapping 
+ around if there are fewer) so many sources can be encoded by one UGen, e.g.,
+ @code
+	UGen sources = ...; // 200 channels
+	UGen hoa = HOAEncode::AR(sources, azimuths, elevations, 3); // 16 channels
+ @endcode
+ This is much more efficient than summing many separate encoders with Mix. The directions
+ are read once per block and the gains move to their new values over the block.
+ @ingroup AllUGens ControlUGens
+ @see HOARotate, HOADecode, PanB */
+UGenSublcassDeclaration(HOAEncode, (input, azimuth, elevation, order),
+					    (UGen const& input, UGen const& azimuth, UGen const& elevation = 0.f, const int order = 3), 
+						COMMON_UGEN_DOCS HOAEncode_Doc);
+
+/** @ingroup UGenInternals */
+class HOARotateUGenInternal : public ProxyOwnerUGenInternal
+{
+public:
+	HOARotateUGenInternal(UGen const& hoa, UGen const& rotate, UGen const& tilt, UGen const& tumble, const int order) throw();
+	~HOARotateUGenInternal();
+	
+	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
+	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	void addDependencies(UGenDependencies& dependencies, const int channel) throw(); // all channels are processed together
+	
+	enum Inputs { HOA, Rotate, Tilt, Tumble, NumInputs };
+	
+protected:
+	const int order_;
+	const int numHarmonics;
+	const int rotationSize;
+	float* const matrix;
+	float* const newMatrix;
+	float* const slopes;
+	float currentRotate, currentTilt, currentTumble;
+};
+
+#define HOA_Doc				The HOA signal input source with ACN ordering and SN3D normalisation.	\
+							The order is the lowest order with at least this number of channels		\
+							(silent channels are added to make up the number of channels).
+
+#define HOARotate_Doc	@param hoa			HOA_Doc															\
+						@param rotate		The rotation angle (on the horizontal plane) in radians, as RotateB. DOC_SINGLE	\
+						@param tilt			The tilt angle in radians, as TiltB. DOC_SINGLE					\
+						@param tumble		The tumble angle in radians, as TumbleB. DOC_SINGLE
+
+/** Rotate a higher order ambisonic soundfield.
+ Rotates, then tilts, then tumbles a HOA signal using a rotation matrix for each degree. 
+ The matrix moves to its new values over a block when the angles change.
+ @ingroup AllUGens ControlUGens
+ @see HOAEncode, HOADecode, RotateB, TiltB, TumbleB */
+UGenSublcassDeclaration(HOARotate, (hoa, rotate, tilt, tumble),
+					    (UGen const& hoa, UGen const& rotate, UGen const& tilt = 0.f, UGen const& tumble = 0.f), 
+						COMMON_UGEN_DOCS HOARotate_Doc);
+
+/** @ingroup UGenInternals */
+class HOADecodeUGenInternal : public ProxyOwnerUGenInternal
+{
+public:
+	HOADecodeUGenInternal(UGen const& hoa, const int order, 
+						  FloatArray const& azimuths, FloatArray const& elevations, 
+						  const int numSpeakers, const HOAUtilities::Weighting weighting) throw();
+	~HOADecodeUGenInternal();
+	
+	void prepareForBlock(const int actualBlockSize, const unsigned int blockID, const int channel) throw();
+	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
+	void addDependencies(UGenDependencies& dependencies, const int channel) throw(); // all channels are processed together
+	
+	enum Inputs { HOA, NumInputs };
+	
+protected:
+	const int numHarmonics;
+	const int numSpeakers_;
+	float* const matrix;
+	float** const outputs;
+};
+
+#define HOADecode_Doc	@param hoa			HOA_Doc															\
+						@param azimuths		The angle of each speaker in the horizontal plane in radians.	\
+											0 is front, +ve is clockwise viewed from above.					\
+						@param elevations	The angle of each speaker in the vertical plane in radians.		\
+											0 is ear-level, @f$\frac{\pi}{2}@f$ is directly above the head	\
+											and @f$-\frac{\pi}{2}@f$ is directly below the head.			\
+						@param weighting	The decoder weighting (see HOAUtilities::Weighting).
+
+/** Higher order ambisonic decoder.
+ Decodes a HOA signal to a set of loudspeakers using a matrix calculated when the UGen is 
+ created. As DecodeB, where the azimuth and elevation arrays are of different lengths the 
+ smaller array is wrapped (and the number of loudspeaker channels is the length of the larger array).
+ The speakers should be spread reasonably evenly around the listener for the order used.
+ @ingroup AllUGens ControlUGens
+ @see HOAEncode, HOARotate, DecodeB */
+UGenSublcassDeclaration(HOADecode, (hoa, azimuths, elevations, weighting),
+					    (UGen const& hoa, FloatArray const& azimuths, FloatArray const& elevations = 0.f, 
+						 const HOAUtilities::Weighting weighting = HOAUtilities::MaxRE), 
+						COMMON_UGEN_DOCS HOADecode_Doc);
+
+
+#endif // _UGEN_ugen_HOA_H_
@@ -50,6 +50,7 @@ SpawnBaseUGenInternal::SpawnBaseUGenInternal(const int numInputs, const int _num
 	currentEventIndex(0),
 	maxRepeats_(maxRepeats),
 	bufferData(new float*[numChannels]),
+	voicePool(0),
 	stopEvents(false)
 {
 	ugen_assert(numChannels > 0);
@@ -60,6 +61,7 @@ SpawnBaseUGenInternal::SpawnBaseUGenInternal(const int numInputs, const int _num
 
 SpawnBaseUGenInternal::~SpawnBaseUGenInternal()// throw()
 {
+	stopVoicePool();
 	delete [] bufferData;
 }
 
@@ -97,6 +99,7 @@ void SpawnBaseUGenInternal::initEvents() throw()
 {
 	events.clear();
 	stopEvents = false;
+	UGenInternal::graphChanged();
 }
 
 bool SpawnBaseUGenInternal::stopAllEvents() throw()
@@ -105,6 +108,41 @@ bool SpawnBaseUGenInternal::stopAllEvents() throw()
 	return true;
 }
 
+bool SpawnBaseUGenInternal::setVoicePoolSize(const int size) throw()
+{
+	stopVoicePool();
+	
+	if(size > 0)
+	{
+		// enough space for the pool's worth of voices to be added without allocating
+		events.reserve(events.size() + size);
+		voicePool = new VoicePool(*this, size, getVoicePoolMode(), maxRepeats_);
+	}
+	
+	return true;
+}
+
+void SpawnBaseUGenInternal::stopVoicePool() throw()
+{
+	delete voicePool;
+	voicePool = 0;
+}
+
+void SpawnBaseUGenInternal::addEvent(UGen const& event) throw()
+{
+	if(events.size() >= events.getAllocatedSize())
+	{
+		// finished events are null
+		events.removeNulls();
+		
+		if(events.size() >= events.getAllocatedSize())
+			events.reserve(events.size() < 4 ? 8 : events.size() * 2);
+	}
+	
+	events.add(event);
+	UGenInternal::graphChanged();
+}
+
 SpawnUGenInternal::SpawnUGenInternal(const int numChannels, const double nextTime_, const int maxRepeats) throw()
 :	SpawnBaseUGenInternal(0, numChannels, maxRepeats),
 	nextTime(nextTime_),
@@ -113,6 +151,12 @@ SpawnUGenInternal::SpawnUGenInternal(const int numChannels, const double nextTim
 	ugen_assert(nextTime >= 0.0)
 }
 
+void SpawnUGenInternal::buildEvent(VoicePool::Voice& voice) throw()
+{
+	voice.ugen = spawnEvent(*this, voice.eventCount);
+	voice.nextTime = nextTime;
+}
+
 void SpawnUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
 {
 	// render the current voices
@@ -142,21 +186,31 @@ void SpawnUGenInternal::processBlock(bool& shouldDelete, const unsigned int bloc
 		
 		do
 		{
-			UGen newVoice = spawnEvent(*this, currentEventIndex++);
-			newVoice.prepareForBlock(blockSize, blockID, -1); // prepare for full size (allocates the output buffers)			
-			newVoice.prepareForBlock(numSamplesToProcess, nextTimeSamples, -1); // prepare for sub block
+			VoicePool::Voice voice(currentEventIndex++);
+			nextEvent(voice);
+			
+			UGen& newVoice = voice.ugen;
+			unsigned int nextTimeSamplesDelta = (unsigned int)(voice.nextTime * UGen::getSampleRate());
 			
-			unsigned int nextTimeSamplesDelta = (unsigned int)(nextTime * UGen::getSampleRate());
+			if(newVoice.isNotNull())
+			{
+				newVoice.prepareForBlock(blockSize, blockID, -1); // prepare for full size (allocates the output buffers)			
+				newVoice.prepareForBlock(numSamplesToProcess, nextTimeSamples, -1); // prepare for sub block
+				
+				for(int channel = 0; channel < numChannels; channel++)
+				{
+					bool shouleDeleteLocal = false;
+					float *voiceSamples = newVoice.processBlock(shouleDeleteLocal, nextTimeSamples, channel);
+					accumulateSamples(bufferData[channel], voiceSamples, numSamplesToProcess);
+				}
+				
+				addEvent(newVoice);
+			}
 			
 			for(int channel = 0; channel < numChannels; channel++)
 			{
-				bool shouleDeleteLocal = false;
-				float *voiceSamples = newVoice.processBlock(shouleDeleteLocal, nextTimeSamples, channel);
-				accumulateSamples(bufferData[channel], voiceSamples, numSamplesToProcess);
 				bufferData[channel] += nextTimeSamplesDelta;
 			}
-			
-			events.add(newVoice);
 
 			numSamplesToProcess -= nextTimeSamplesDelta;
 			nextTimeSamples += nextTimeSamplesDelta;
@@ -40,6 +40,7 @@
 
 #include "../core/ugen_UGen.h"
 #include "../core/ugen_UGenArray.h"
+#include "ugen_VoicePool.h"
 
 #define _FILEID_ _UGEN_ugen_Spawn_H_
 
@@ -57,6 +58,18 @@ public:
 	bool shouldStopAllEvents() { return stopEvents; }
 	
 	inline UGenArray& getEvents() { return events; }
+	
+	/** Build a voice by calling spawnEvent() with the arguments in @c voice.
+	 This may be called on the VoicePool thread. */
+	virtual void buildEvent(VoicePool::Voice& voice) throw() = 0;
+	
+	bool setVoicePoolSize(const int size) throw();
+	VoicePool* getVoicePool() throw() { return voicePool; }
+	
+	/** Delete the VoicePool (if there is one).
+	 The most derived class must call this in its destructor as the pool's thread 
+	 may be calling its spawnEvent() function. */
+	void stopVoicePool() throw();
 		
 protected:	
 	const int numChannels;
@@ -65,6 +78,21 @@ protected:
 	int currentEventIndex;
 	const int maxRepeats_;
 	float** const bufferData;
+	VoicePool* voicePool;
+	
+	/** Get a voice from the pool, or build it now if there is no pool (see VoicePool::take()). */
+	inline void nextEvent(VoicePool::Voice& voice) throw()
+	{
+		if(voicePool != 0)
+			voicePool->take(voice);
+		else
+			buildEvent(voice);
+	}
+	
+	/** Add a voice to the events, reusing the space of finished ones where possible. */
+	void addEvent(UGen const& event) throw();
+	
+	virtual VoicePool::Mode getVoicePoolMode() const throw() { return VoicePool::Sequential; }
 	
 	inline void accumulateSamples(float *outputSamples, const float *inputSamples, int numSamplesToProcess) throw()
 	{
@@ -92,6 +120,7 @@ public:
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
 	
 	virtual UGen spawnEvent(SpawnUGenInternal& spawn, const int eventCount) = 0;
+	void buildEvent(VoicePool::Voice& voice) throw();
 	
 	double nextTime;
 	
@@ -141,6 +170,11 @@ public:
 		return event_.spawnEvent(spawn, eventCount);
 	}
 
+	~SpawnEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	SpawnEventType event_;
 };
@@ -160,6 +194,11 @@ public:
 		return event_.spawnEvent(spawn, eventCount);
 	}
 	
+	~SpawnEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	SpawnEventType event_;
 };
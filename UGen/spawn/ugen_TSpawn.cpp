@@ -94,8 +94,11 @@ void TSpawnUGenInternal::processBlock(bool& shouldDelete, const unsigned int blo
 				numSamples = 1;
 				
 				// add the new voice
-				UGen newVoice = spawnEvent(*this, currentEventIndex++);
-				events.add(newVoice);
+				VoicePool::Voice voice(currentEventIndex++);
+				nextEvent(voice);
+				
+				if(voice.ugen.isNotNull())
+					addEvent(voice.ugen);
 			}
 			else
 			{
@@ -118,13 +121,21 @@ void TSpawnUGenInternal::processBlock(bool& shouldDelete, const unsigned int blo
 }
 
 
+void TSpawnUGenInternal::buildEvent(VoicePool::Voice& voice) throw()
+{
+	voice.ugen = spawnEvent(*this, voice.eventCount, voice.extraArgs);
+}
+
 bool TSpawnUGenInternal::trigger(void* extraArgs) throw()
 {	
 	if(reachedMaxRepeats() == false)
 	{
 		currentTrig = 1.f;
-		UGen newVoice = spawnEvent(*this, currentEventIndex++, extraArgs);
-		events.add(newVoice);
+		VoicePool::Voice voice(currentEventIndex++, 0, 0, 0, extraArgs);
+		nextEvent(voice);
+		
+		if(voice.ugen.isNotNull())
+			addEvent(voice.ugen);
 	}
 	
 	return true;
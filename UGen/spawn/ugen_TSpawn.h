@@ -50,6 +50,7 @@ public:
 	void processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw();
 	
 	virtual UGen spawnEvent(TSpawnUGenInternal& spawn, const int eventCount, void* extraArgs = 0) = 0;
+	void buildEvent(VoicePool::Voice& voice) throw();
 	bool trigger(void* extraArgs = 0) throw();
 	
 	inline UGen& getTrigger() throw() { return inputs[Trig]; }
@@ -101,6 +102,11 @@ public:
 		return event_.spawnEvent(spawn, eventCount, extraArgs);
 	}
 
+	~TSpawnEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	TSpawnEventType event_;
 };
@@ -120,6 +126,11 @@ public:
 		return event_.spawnEvent(spawn, eventCount, extraArgs);
 	}
 	
+	~TSpawnEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	TSpawnEventType event_;
 };
@@ -129,6 +129,11 @@ public:
 		return event * EnvGen::KR(env, UGen::DeleteWhenDone);
 	}
 
+	~XFadeTextureEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	XFadeTextureEventType event_;
 };
@@ -167,6 +172,11 @@ public:
 		return event * EnvGen::KR(env, UGen::DeleteWhenDone);
 	}
 
+	~XFadeTextureEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	XFadeTextureEventType event_;
 };
@@ -323,6 +333,11 @@ public:
 		return event * EnvGen::KR(env, UGen::DeleteWhenDone); 
 	}
 
+	~OverlapTextureEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	OverlapTextureEventType event_;
 };
@@ -363,6 +378,11 @@ public:
 		return event * EnvGen::KR(env, UGen::DeleteWhenDone); 
 	}
 	
+	~OverlapTextureEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	OverlapTextureEventType event_;
 };
@@ -510,6 +530,11 @@ public:
 		return event * EnvGen::KR(env, UGen::DeleteWhenDone);
 	}
 	
+	~TrigXFadeEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	TrigXFadeEventType event_;
 };
@@ -548,6 +573,11 @@ public:
 		return event * EnvGen::KR(env, UGen::DeleteWhenDone);
 	}
 	
+	~TrigXFadeEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	TrigXFadeEventType event_;
 };
@@ -0,0 +1,445 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#include "../core/ugen_StandardHeader.h"
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_VoicePool.h"
+#include "ugen_Spawn.h"
+#include "../core/ugen_Atomics.h"
+
+/** The gain a Keyed voice is multiplied by, this is set when the voice is taken to apply 
+ the velocity of the note it is taken for. 
+ @internal */
+class VoicePool::GainUGenInternal : public UGenInternal
+{
+public:
+	GainUGenInternal() throw()
+	:	UGenInternal(0),
+		gain(1.f)
+	{
+		initValue(gain);
+	}
+	
+	inline void setGain(const float newGain) throw()	{ gain = newGain; }
+	
+	void processBlock(bool& /*shouldDelete*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
+	{
+		int numSamplesToProcess = uGenOutput.getBlockSize();
+		float* outputSamples = uGenOutput.getSampleData();
+		
+		while(numSamplesToProcess--)
+			*outputSamples++ = gain;
+	}
+	
+private:
+	float gain;
+};
+
+VoicePool::Voice::Voice(const int eventCount_, 
+						const int midiChannel_, 
+						const int midiNote_, 
+						const int velocity_, 
+						void* extraArgs_) throw()
+:	eventCount(eventCount_),
+	midiChannel(midiChannel_),
+	midiNote(midiNote_),
+	velocity(velocity_),
+	extraArgs(extraArgs_),
+	nextTime(0.0)
+{
+}
+
+VoicePool::VoicePool(SpawnBaseUGenInternal& owner, const int size, const Mode mode, const int maxEvents) throw()
+:	owner_(owner),
+	size_(size < 1 ? 1 : size),
+	mode_(mode),
+	maxEvents_(maxEvents),
+	slots(new Slot[size_]),
+	requests(new Request[64]),
+	requestMask(63),
+	requestHead(0),
+	requestTail(0),
+	buildLock(0),
+	consumedEventCount(0),
+	numReady(0),
+	lowWaterMark(size_ / 2),
+	nextEventCount(0),
+	nextVictim(0),
+	numHits(0),
+	numMisses(0),
+	numBuilt(0)
+{
+	ugen_assert(size > 0);
+	ugen_assert(maxEvents >= 0);
+	
+	for(int i = 0; i < size_; i++)
+	{
+		slots[i].state = Empty;
+		slots[i].hasKey = false;
+		slots[i].gain = 0;
+	}
+	
+	for(int i = 0; i <= requestMask; i++)
+	{
+		requests[i].sequence = i;
+		requests[i].key = 0;
+	}
+	
+	startThread();
+}
+
+VoicePool::~VoicePool()
+{
+	stopThread();
+	
+	delete [] slots;
+	delete [] requests;
+}
+
+void VoicePool::signalThreadShouldExit() throw()
+{
+	UGenThread::signalThreadShouldExit();
+	semaphore.signal();
+}
+
+void VoicePool::run()
+{
+	while(threadShouldExit() == false)
+	{
+		refill();
+		semaphore.wait();
+	}
+}
+
+bool VoicePool::take(Voice& voice) throw()
+{
+	// let the builder skip any voices we've gone past
+	if(voice.eventCount >= consumedEventCount)
+	{
+		Atomics::memoryBarrier();
+		consumedEventCount = voice.eventCount + 1;
+	}
+	
+	if(voice.extraArgs != 0)
+	{
+		// these can't be built in advance, see the class notes
+		ScopedBuildLock lock(*this);
+		owner_.buildEvent(voice);
+		return true;
+	}
+	
+	if(takeReady(voice) == false)
+	{
+		ScopedBuildLock lock(*this);
+		
+		// it may have been built while we were waiting
+		if(takeReady(voice) == false)
+		{
+			// build it here as the owner would without a pool rather than miss the event
+			owner_.buildEvent(voice);
+			numMisses++;
+			
+			if(mode_ == Keyed)
+				prepareNote(voice.midiChannel, voice.midiNote, voice.velocity); // signals too
+			else
+				semaphore.signal();
+			
+			return false;
+		}
+	}
+	
+	// a Keyed slot is rebuilt straight away for the next time the note is played
+	if((mode_ == Keyed) || (numReady <= lowWaterMark))
+		semaphore.signal();
+	
+	return true;
+}
+
+void VoicePool::setLowWaterMark(const int numVoices) throw()
+{
+	lowWaterMark = ugen::clip(numVoices, 0, size_ - 1);
+}
+
+void VoicePool::markNotReady(Slot& slot, const int newState) throw()
+{
+	if(Atomics::compareAndSwap(slot.state, Ready, newState))
+		Atomics::decrement(numReady);
+}
+
+bool VoicePool::takeReady(Voice& voice) throw()
+{
+	for(int i = 0; i < size_; i++)
+	{
+		Slot& slot = slots[i];
+		
+		if(slot.state != Ready) continue;
+		
+		Atomics::memoryBarrier();
+		
+		if(mode_ == Sequential && slot.voice.eventCount < voice.eventCount)
+		{
+			// too late for this one, the background thread will delete it
+			markNotReady(slot, Stale);
+		}
+		else if(matches(slot.voice, voice) && Atomics::compareAndSwap(slot.state, Ready, Taken))
+		{
+			// check again in case the slot was replaced before the swap
+			if(matches(slot.voice, voice) == false)
+			{
+				slot.state = Ready;
+				continue;
+			}
+			
+			Atomics::decrement(numReady);
+			
+			if(slot.gain != 0)
+			{
+				if(voice.velocity != slot.voice.velocity)
+					slot.gain->setGain((float)voice.velocity / (float)slot.voice.velocity);
+				
+				slot.gain = 0;
+				slot.voice.velocity = voice.velocity; // rebuilt with the latest velocity
+			}
+			
+			voice.ugen = slot.voice.ugen;
+			voice.nextTime = slot.voice.nextTime;
+			slot.voice.ugen = UGen::getNull();
+			Atomics::memoryBarrier();
+			slot.state = Empty;
+			numHits++;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+bool VoicePool::matches(Voice const& slotVoice, Voice const& voice) const throw()
+{
+	if(mode_ == Sequential)
+		return slotVoice.eventCount == voice.eventCount;
+	else
+		return (slotVoice.midiChannel == voice.midiChannel) 
+			&& (slotVoice.midiNote == voice.midiNote); // the velocity is applied by take()
+}
+
+bool VoicePool::prepareNote(const int midiChannel, const int midiNote, const int velocity) throw()
+{
+	if(mode_ != Keyed) return false;
+	
+	const int key = createKey(midiChannel, midiNote, velocity);
+	int position = requestTail;
+	
+	for(;;)
+	{
+		Request& request = requests[position & requestMask];
+		const int difference = request.sequence - position;
+		
+		if(difference == 0)
+		{
+			if(Atomics::compareAndSwap(requestTail, position, position + 1))
+			{
+				request.key = key;
+				Atomics::memoryBarrier();
+				request.sequence = position + 1;
+				semaphore.signal();
+				return true;
+			}
+		}
+		else if(difference < 0)
+		{
+			return false; // full
+		}
+		
+		position = requestTail;
+	}
+}
+
+bool VoicePool::popRequest(int& key) throw()
+{
+	Request& request = requests[requestHead & requestMask];
+	
+	if(request.sequence != requestHead + 1) 
+		return false;
+	
+	Atomics::memoryBarrier();
+	key = request.key;
+	Atomics::memoryBarrier();
+	request.sequence = requestHead + requestMask + 1;
+	requestHead++;
+	return true;
+}
+
+void VoicePool::resetStatistics() throw()
+{
+	numHits = 0;
+	numMisses = 0;
+	numBuilt = 0;
+}
+
+void VoicePool::refill() throw()
+{
+	for(int i = 0; i < size_; i++)
+	{
+		Slot& slot = slots[i];
+		
+		if(slot.state == Stale)
+		{
+			slot.gain = 0;
+			slot.voice.ugen = UGen::getNull();
+			Atomics::memoryBarrier();
+			slot.state = Empty;
+		}
+	}
+	
+	if(nextEventCount < consumedEventCount)
+		nextEventCount = consumedEventCount;
+	
+	if(mode_ == Keyed)
+	{
+		int key;
+		while((threadShouldExit() == false) && popRequest(key))
+			buildForKey(key);
+	}
+	
+	for(int i = 0; (i < size_) && (threadShouldExit() == false); i++)
+	{
+		Slot& slot = slots[i];
+		
+		if(mode_ == Sequential)
+		{
+			if((maxEvents_ > 0) && (nextEventCount >= maxEvents_)) 
+				break;
+			
+			if(Atomics::compareAndSwap(slot.state, Empty, Building))
+			{
+				slot.voice.eventCount = nextEventCount++;
+				build(slot);
+			}
+		}
+		else if(slot.hasKey && Atomics::compareAndSwap(slot.state, Empty, Building))
+		{
+			slot.voice.eventCount = consumedEventCount;
+			build(slot);
+		}
+	}
+}
+
+void VoicePool::buildForKey(const int key) throw()
+{
+	Voice voice(0, key & 0xFF, (key >> 8) & 0xFF, (key >> 16) & 0xFF);
+	
+	for(int i = 0; i < size_; i++)
+	{
+		if(slots[i].hasKey && matches(slots[i].voice, voice))
+			return; // already have one (or it's taken and about to be rebuilt)
+	}
+	
+	// replace the slots in turn so the oldest requests are replaced first
+	for(int attempt = 0; attempt < size_ * 2; attempt++)
+	{
+		Slot& slot = slots[nextVictim];
+		nextVictim = (nextVictim + 1) % size_;
+		
+		bool wasReady = false;
+		
+		if(Atomics::compareAndSwap(slot.state, Empty, Building) ||
+		   (wasReady = Atomics::compareAndSwap(slot.state, Ready, Building)))
+		{
+			if(wasReady)
+				Atomics::decrement(numReady);
+			
+			slot.gain = 0;
+			slot.voice.ugen = UGen::getNull();
+			slot.voice.midiChannel = voice.midiChannel;
+			slot.voice.midiNote = voice.midiNote;
+			slot.voice.velocity = voice.velocity;
+			slot.voice.eventCount = consumedEventCount;
+			slot.hasKey = true;
+			build(slot);
+			return;
+		}
+	}
+}
+
+void VoicePool::build(Slot& slot) throw()
+{
+	ugen_assert(slot.state == Building);
+	
+	slot.voice.ugen = UGen::getNull();
+	slot.gain = 0;
+	
+	{
+		ScopedBuildLock lock(*this);
+		owner_.buildEvent(slot.voice);
+	}
+	
+	if((mode_ == Keyed) && slot.voice.ugen.isNotNull())
+	{
+		slot.gain = new GainUGenInternal();
+		slot.voice.ugen = slot.voice.ugen * UGen(slot.gain);
+	}
+	
+	numBuilt++;
+	Atomics::increment(numReady);
+	Atomics::memoryBarrier();
+	slot.state = Ready;
+}
+
+int VoicePool::createKey(const int midiChannel, const int midiNote, const int velocity) throw()
+{
+	return (midiChannel & 0xFF) | ((midiNote & 0xFF) << 8) | ((velocity & 0xFF) << 16);
+}
+
+VoicePool::ScopedBuildLock::ScopedBuildLock(VoicePool& pool) throw()
+:	pool_(pool)
+{
+	while(Atomics::compareAndSwap(pool_.buildLock, 0, 1) == false)
+		Atomics::pause();
+	
+	Atomics::memoryBarrier();
+}
+
+VoicePool::ScopedBuildLock::~ScopedBuildLock()
+{
+	Atomics::memoryBarrier();
+	pool_.buildLock = 0;
+}
+
+END_UGEN_NAMESPACE
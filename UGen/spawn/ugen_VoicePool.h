@@ -0,0 +1,233 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#ifndef _UGEN_ugen_VoicePool_H_
+#define _UGEN_ugen_VoicePool_H_
+
+#include "../core/ugen_UGen.h"
+#include "../core/ugen_Threads.h"
+
+class SpawnBaseUGenInternal;
+
+/** Builds the voices for a Spawn-type UGen ahead of time on a background thread.
+ 
+ Normally a Spawn-type UGen calls its spawnEvent() function in the audio callback which 
+ allocates a complete new UGen graph each time. With a VoicePool the voices are built by 
+ a (non real-time) thread and stored in a fixed number of slots, when the Spawn needs a
+ voice it takes a ready one from the pool and the slot is refilled in the background.
+ Voices are handed between the threads with atomic operations on the slot states so the
+ audio thread doesn't wait or build a voice itself while the pool has the voice it needs. 
+ In a Sequential pool the background thread is only woken when the number of ready voices 
+ drops to the low water mark (half the pool by default), in a Keyed pool it is woken after
+ every take() so the note just played is ready again.
+ 
+ There are two modes:
+ - Sequential is used by Spawn, TSpawn and the texture UGens, the voice for each eventCount is
+   built in advance (up to the size of the pool). 
+ - Keyed is used by VoicerBase (and Voicer), voices are built for particular MIDI channel and
+   note combinations. Once a note has been played (or prepared with prepareNote()) the pool 
+   keeps a voice for it ready, the least recently requested notes are replaced when the pool 
+   is full. Each voice is built with the velocity the note was last played (or prepared) with
+   and multiplied by a gain which is set when the voice is taken, so a note played with a 
+   different velocity is scaled by the ratio of the two velocities. This is exact when 
+   spawnEvent() only uses the velocity for the amplitude of the voice, otherwise the other
+   effects of the velocity follow the previous note.
+ 
+ If no suitable voice is ready this is counted as a miss: take() builds the voice on the 
+ calling thread (waiting for the background thread to finish any voice it is building) just 
+ as the Spawn would without a pool and wakes the background thread. A larger pool (or 
+ prepareNote() in a Keyed pool) avoids misses.
+ 
+ Notes:
+ - The spawnEvent() function is called on the background thread (or on the audio thread, with
+   the background thread locked out, for a miss) so it must not modify anything used by the 
+   audio thread. Spawn's nextTime is handed to the audio thread with each voice.
+ - spawnEvent() is called earlier than it would be otherwise, any values read from the owner
+   (e.g., a slider or the eventCount in a Voicer) are those at the time the voice was built.
+ - Voices are built using their own UGen graphs, since reference counts are not atomic they 
+   should not share UGen objects with the rest of the graph (e.g., a Plug or a Value).
+ - TSpawn::trigger() calls with extraArgs are always built on the calling thread (waiting for the 
+   background thread to finish any voice it is building) so these should not be made on the
+   audio thread while there is a pool.
+ 
+ @see UGen::setVoicePoolSize(), UGen::getVoicePool() */
+class VoicePool : public UGenThread
+{
+public:
+	/** The arguments and result for building a voice. */
+	class Voice
+	{
+	public:
+		Voice(const int eventCount = 0, 
+			  const int midiChannel = 0, 
+			  const int midiNote = 0, 
+			  const int velocity = 0, 
+			  void* extraArgs = 0) throw();
+		
+		int eventCount;
+		int midiChannel;
+		int midiNote;
+		int velocity;
+		void* extraArgs;
+		
+		/** Spawn's nextTime after the voice was built. */
+		double nextTime;
+		UGen ugen;
+	};
+	
+	enum Mode { Sequential, Keyed };
+	
+	/** Create a pool and start its thread.
+	 @param owner		The SpawnBaseUGenInternal whose voices are built, this must outlive the pool.
+	 @param size		The number of voices to keep ready.
+	 @param mode		Sequential or Keyed (see above).
+	 @param maxEvents	No voices are built for eventCount values at or above this (0 means no limit). */
+	VoicePool(SpawnBaseUGenInternal& owner, const int size, const Mode mode, const int maxEvents = 0) throw();
+	~VoicePool();
+	
+	/** Get a voice built with the arguments in @c voice. 
+	 This sets voice.ugen and voice.nextTime from a ready voice in the pool. If there isn't 
+	 one the voice is built now (see above) and the background thread is woken to build more 
+	 voices. This should only be called by the owner on the audio thread (or with extraArgs on 
+	 another thread, see above). 
+	 @return true if a voice was taken from the pool (or built with extraArgs), false if 
+			 it had to be built because the pool missed. */
+	bool take(Voice& voice) throw();
+	
+	/** Wake the background thread when this many voices or fewer are ready after a take() 
+	 from a Sequential pool. */
+	void setLowWaterMark(const int numVoices) throw();
+	inline int getLowWaterMark() const throw()	{ return lowWaterMark;	}
+	
+	/** Ask for a voice to be kept ready for a particular note in a Keyed pool.
+	 This doesn't block, it returns false if too many requests are already waiting. */
+	bool prepareNote(const int midiChannel, const int midiNote, const int velocity) throw();
+	
+	inline int getSize() const throw()			{ return size_;			}
+	inline Mode getMode() const throw()			{ return mode_;			}
+	
+	/** The number of voices currently ready to be taken. */
+	inline int getNumReady() const throw()		{ return numReady;		}
+	
+	/** The number of voices taken from the pool. */
+	inline int getNumHits() const throw()		{ return numHits;		}
+	
+	/** The number of voices which weren't ready when they were needed (and so were built by take()). */
+	inline int getNumMisses() const throw()		{ return numMisses;		}
+	
+	/** The number of voices built by the background thread (some may have been discarded). */
+	inline int getNumBuilt() const throw()		{ return numBuilt;		}
+	
+	void resetStatistics() throw();
+	
+	/** Locks out voice building for its lifetime. */
+	class ScopedBuildLock
+	{
+	public:
+		ScopedBuildLock(VoicePool& pool) throw();
+		~ScopedBuildLock();
+		
+	private:
+		VoicePool& pool_;
+		
+		ScopedBuildLock (const ScopedBuildLock&);
+		const ScopedBuildLock& operator= (const ScopedBuildLock&);
+	};
+	
+	/** @internal */
+	void run();
+	/** @internal */
+	void signalThreadShouldExit() throw();
+	
+private:
+	enum SlotState { Empty, Building, Ready, Taken, Stale };
+	
+	class GainUGenInternal;
+	
+	struct Slot
+	{
+		volatile int state;
+		bool hasKey;
+		Voice voice;
+		GainUGenInternal* gain;	// owned by the voice, set when a Keyed voice is taken
+	};
+	
+	struct Request
+	{
+		volatile int sequence;
+		int key;
+	};
+	
+	SpawnBaseUGenInternal& owner_;
+	const int size_;
+	const Mode mode_;
+	const int maxEvents_;
+	Slot* const slots;
+	
+	Request* const requests;
+	const int requestMask;
+	volatile int requestHead;
+	volatile int requestTail;
+	
+	Semaphore semaphore;
+	volatile int buildLock;
+	volatile int consumedEventCount;	// only written by the audio thread
+	volatile int numReady;				// changed with atomic operations by both threads
+	int lowWaterMark;
+	int nextEventCount;
+	int nextVictim;
+	
+	volatile int numHits;
+	volatile int numMisses;
+	volatile int numBuilt;
+	
+	bool takeReady(Voice& voice) throw();
+	void markNotReady(Slot& slot, const int newState) throw();
+	bool matches(Voice const& slotVoice, Voice const& voice) const throw();
+	void refill() throw();
+	void build(Slot& slot) throw();
+	void buildForKey(const int key) throw();
+	bool popRequest(int& key) throw();
+	
+	static int createKey(const int midiChannel, const int midiNote, const int velocity) throw();
+	
+	VoicePool (const VoicePool&);
+	const VoicePool& operator= (const VoicePool&);
+};
+
+
+#endif // _UGEN_ugen_VoicePool_H_
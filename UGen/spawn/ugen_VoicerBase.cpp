@@ -86,12 +86,15 @@ bool VoicerBaseUGenInternal::sendMidiNote(const int midiChannel,
 		// stop double notes, AU lab was sending two ons but only one off 
 		// stealNote(midiChannel, midiNote, false, true);  // let's only do this in the Juce version..
 		
-		UGen newEvent = spawnEvent(*this, currentEventIndex++, midiChannel, midiNote, velocity);
+		VoicePool::Voice voice(currentEventIndex++, midiChannel, midiNote, velocity);
+		nextEvent(voice);
+		
+		UGen& newEvent = voice.ugen;
         
         if(newEvent.isNotNull())
         {
             newEvent.userData = userData;
-            events.add(newEvent);
+            addEvent(newEvent);
         }        
 	}
 	else
@@ -108,6 +111,11 @@ bool VoicerBaseUGenInternal::sendMidiNote(const int midiChannel,
 	return true;
 }
 
+void VoicerBaseUGenInternal::buildEvent(VoicePool::Voice& voice) throw()
+{
+	voice.ugen = spawnEvent(*this, voice.eventCount, voice.midiChannel, voice.midiNote, voice.velocity);
+}
+
 bool VoicerBaseUGenInternal::stealNote(const int midiChannel, 
 									   const int midiNote, 
 									   const bool forcedSteal,
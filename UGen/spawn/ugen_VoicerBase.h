@@ -79,6 +79,8 @@ public:
 							const int midiNote,
 							const int velocity) = 0;
 	
+	void buildEvent(VoicePool::Voice& voice) throw();
+	
 	/** Steal one or more notes with a particular MIDI note and/or MIDI channel.
 	 
 	 @param midiChannel		The MIDI channel on which the MIDI note should be to be stolen.
@@ -117,6 +119,8 @@ protected:
 	
 	static const int stealingUserData;
 	
+	VoicePool::Mode getVoicePoolMode() const throw() { return VoicePool::Keyed; }
+	
 	int countNonstealingVoices() const throw();
 	const UGen& chooseStealee() throw();
 	const UGen& chooseReleasee(const int midiChannel, const int midiNote) throw();
@@ -196,6 +200,11 @@ public:
 	}
 
 
+	~VoicerBaseEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	VoicerEventType event_;
 };
@@ -232,6 +241,11 @@ public:
 	}
 
 
+	~VoicerBaseEventUGenInternal()
+	{
+		stopVoicePool();
+	}
+
 protected:
 	VoicerEventType event_;
 };
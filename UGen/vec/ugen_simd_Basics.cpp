@@ -0,0 +1,220 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#include "../core/ugen_StandardHeader.h"
+
+#ifdef UGEN_SIMD
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_simd_Utilities.h"
+#include "../basics/ugen_ScalarUGens.h"
+#include "../basics/ugen_MixUGen.h"
+#include "../basics/ugen_MulAdd.h"
+
+
+// SIMD versions of some of the UGen processing functions...
+
+
+
+void ScalarUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
+{		
+	const int numSamplesToProcess = uGenOutput.getBlockSize();
+	float* const outputSamples = uGenOutput.getSampleData();	
+	SIMD::splat(value_, outputSamples, numSamplesToProcess);
+}
+
+void FloatPtrUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
+{
+	const int numSamplesToProcess = uGenOutput.getBlockSize(); 
+	float* const outputSamples = uGenOutput.getSampleData(); 
+	float nextValue = (float)*ptr; 
+
+	value_ = nextValue;
+	SIMD::splat(nextValue, outputSamples, numSamplesToProcess);
+}
+
+void DoublePtrUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
+{
+	const int numSamplesToProcess = uGenOutput.getBlockSize(); 
+	float* const outputSamples = uGenOutput.getSampleData(); 
+	float nextValue = (float)*ptr; 
+	
+	value_ = nextValue;
+	SIMD::splat(nextValue, outputSamples, numSamplesToProcess);
+}
+
+void IntPtrUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
+{
+	const int numSamplesToProcess = uGenOutput.getBlockSize(); 
+	float* const outputSamples = uGenOutput.getSampleData(); 
+	float nextValue = (float)*ptr; 
+	
+	value_ = nextValue;
+	SIMD::splat(nextValue, outputSamples, numSamplesToProcess);
+}
+
+void BoolPtrUGenInternal::processBlock(bool& /*shouldDelete*/, const unsigned int /*blockID*/, const int /*channel*/) throw()
+{
+	const int numSamplesToProcess = uGenOutput.getBlockSize(); 
+	float* const outputSamples = uGenOutput.getSampleData(); 
+	float nextValue = (float)(*ptr != 0);
+	
+	value_ = nextValue;
+	SIMD::splat(nextValue, outputSamples, numSamplesToProcess);
+}
+
+void MixUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
+{
+	if(shouldCompensate_)
+	{
+		processBlockCompensated(shouldDelete, blockID);
+		return;
+	}
+	
+	bool shouldDeleteLocal = false;
+	bool& shouldDeleteToPass = shouldAllowAutoDelete_ ? shouldDelete : shouldDeleteLocal;	
+	const int numSamplesToProcess = uGenOutput.getBlockSize();
+	float* const outputSamples = uGenOutput.getSampleData();
+	const int numChannels = inputs->getNumChannels();
+	
+	// channels are summed in groups so the output is read and written once per group, the first 
+	// channel may have been rendered straight into the output (see UGenOutputArena)
+	const float* group[MaxGroupSize];
+	int groupSize = 0;
+	bool hasOutput = false;
+	
+	for(int channel = 0; channel < numChannels; channel++)
+	{
+		shouldDeleteLocal = false;
+		const float* const channelSamples = inputs->processBlock(shouldDeleteToPass, blockID, channel);
+		
+		if((channel == 0) && (channelSamples == outputSamples))
+		{
+			hasOutput = true;
+			continue;
+		}
+		
+		group[groupSize++] = channelSamples;
+		
+		if(groupSize == MaxGroupSize)
+		{
+			if(hasOutput)
+				SIMD::mixAccumulate(group, groupSize, outputSamples, numSamplesToProcess);
+			else
+				SIMD::mix(group, groupSize, outputSamples, numSamplesToProcess);
+			
+			hasOutput = true;
+			groupSize = 0;
+		}
+	}	
+	
+	if(hasOutput)
+		SIMD::mixAccumulate(group, groupSize, outputSamples, numSamplesToProcess);
+	else
+		SIMD::mix(group, groupSize, outputSamples, numSamplesToProcess);
+}
+
+
+void MixArrayUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int /*channel*/) throw()
+{	    
+	if(shouldCompensate_)
+	{
+		processBlockCompensated(shouldDelete, blockID);
+		return;
+	}
+	
+	bool shouldDeleteLocal;
+	bool& shouldDeleteToPass = shouldAllowAutoDelete_ ? shouldDelete : shouldDeleteLocal;	
+	const int numOutputChannels = getNumChannels();
+	const int arraySize = array_.size();
+	const int numSamplesToProcess = uGenOutput.getBlockSize();
+	const float* group[MixUGenInternal::MaxGroupSize];
+	
+	for(int channel = 0; channel < numOutputChannels; channel++)
+	{
+		float* const outputSamples = proxies[channel]->getSampleData();		
+		int groupSize = 0;
+		bool hasOutput = false;
+		
+		for(int arrayIndex = 0; arrayIndex < arraySize; arrayIndex++)
+		{
+			UGen& ugen = array_[arrayIndex];
+			
+			if(ugen.isNull(channel)) continue;
+			
+			if(shouldWrapChannels_ || (channel < ugen.getNumChannels()))
+			{
+				shouldDeleteLocal = false;
+				group[groupSize++] = ugen.processBlock(shouldDeleteToPass, blockID, channel);
+				
+				if(groupSize == MixUGenInternal::MaxGroupSize)
+				{
+					if(hasOutput)
+						SIMD::mixAccumulate(group, groupSize, outputSamples, numSamplesToProcess);
+					else
+						SIMD::mix(group, groupSize, outputSamples, numSamplesToProcess);
+					
+					hasOutput = true;
+					groupSize = 0;
+				}
+			}
+		}
+		
+		// an empty group clears the output if nothing has been mixed yet
+		if(hasOutput)
+			SIMD::mixAccumulate(group, groupSize, outputSamples, numSamplesToProcess);
+		else
+			SIMD::mix(group, groupSize, outputSamples, numSamplesToProcess);
+	}
+}
+
+
+void MulAddUGenInternal::processBlock(bool& shouldDelete, const unsigned int blockID, const int channel) throw()
+{
+	const int numSamplesToProcess = uGenOutput.getBlockSize();
+	float* const outputSamples = uGenOutput.getSampleData();
+	const float* const inputSamples = inputs[Input].processBlock(shouldDelete, blockID, channel);
+	const float* const mulSamples = inputs[Mul].processBlock(shouldDelete, blockID, channel);
+	const float* const addSamples = inputs[Add].processBlock(shouldDelete, blockID, channel);	
+	SIMD::multiplyAdd(inputSamples, mulSamples, addSamples, outputSamples, numSamplesToProcess);
+}
+
+
+END_UGEN_NAMESPACE
+
+#endif
@@ -0,0 +1,654 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+/* This file is intentionally included more than once by vec/ugen_simd_Utilities.cpp 
+ to generate the kernels for each instruction set (avoiding large multi-line macros 
+ which are difficult to debug). Before including it define:
+ 
+	SIMD_NAME(name)			to generate a unique function name for this instruction set
+	SIMD_TARGET				any function attributes required (e.g., to enable AVX)
+	SIMD_WIDTH				the number of floats in each vector
+	SIMD_VEC				the vector type
+	SIMD_LOAD(ptr)			unaligned load
+	SIMD_STORE(ptr, v)		unaligned store
+	SIMD_SET1(value)		broadcast a float to all elements
+	SIMD_ADD(a, b), SIMD_SUB(a, b), SIMD_MUL(a, b), SIMD_DIV(a, b)
+	SIMD_SQRT(a), SIMD_ABS(a), SIMD_NEG(a)
+	SIMD_EXIT				optional, called before each kernel returns (e.g., to clear the upper 
+							halves of the AVX registers so following SSE code is not penalised)
+ 
+ ..and for the four 32-bit unsigned integer lanes used by the random number kernels:
+ 
+	SIMD_U4					the vector type
+	SIMD_U4_LOAD(ptr)		unaligned load
+	SIMD_U4_STORE(ptr, v)	unaligned store
+	SIMD_U4_SET1(value)		broadcast an unsigned int to all lanes
+	SIMD_U4_AND(a, b), SIMD_U4_XOR(a, b)
+	SIMD_U4_SHL(a, n), SIMD_U4_SHR(a, n)	logical shifts by a constant
+	SIMD_U4_STORE_FLOAT(ptr, bits, offset)	store the bits as four floats minus offset
+ 
+ ..these are all undefined again at the end of this file. */
+
+#ifndef SIMD_NAME
+	#error SIMD_NAME must be defined before including ugen_simd_Kernels.h
+#endif
+
+#ifndef SIMD_EXIT
+	#define SIMD_EXIT
+#endif
+
+#define SIMD_UNARY_KERNEL(NAME, VECEXPR, SCALAREXPR)												\
+	static SIMD_TARGET void SIMD_NAME(NAME)(const float *inputSamples,								\
+											float *outputSamples,									\
+											unsigned int numSamples)								\
+	{																								\
+		unsigned int numVectors = numSamples / SIMD_WIDTH;											\
+		unsigned int numScalars = numSamples % SIMD_WIDTH;											\
+		while(numVectors--)	{																		\
+			SIMD_VEC a = SIMD_LOAD(inputSamples);													\
+			SIMD_STORE(outputSamples, VECEXPR);														\
+			inputSamples += SIMD_WIDTH;																\
+			outputSamples += SIMD_WIDTH;															\
+		}																							\
+		while(numScalars--)	{																		\
+			const float a = *inputSamples++;														\
+			*outputSamples++ = SCALAREXPR;															\
+		}																							\
+		SIMD_EXIT;																					\
+	}
+
+#define SIMD_BINARY_KERNEL(NAME, VECEXPR, SCALAREXPR)												\
+	static SIMD_TARGET void SIMD_NAME(NAME)(const float *leftSamples,								\
+											const float *rightSamples,								\
+											float *outputSamples,									\
+											unsigned int numSamples)								\
+	{																								\
+		unsigned int numVectors = numSamples / SIMD_WIDTH;											\
+		unsigned int numScalars = numSamples % SIMD_WIDTH;											\
+		while(numVectors--)	{																		\
+			SIMD_VEC a = SIMD_LOAD(leftSamples);													\
+			SIMD_VEC b = SIMD_LOAD(rightSamples);													\
+			SIMD_STORE(outputSamples, VECEXPR);														\
+			leftSamples += SIMD_WIDTH;																\
+			rightSamples += SIMD_WIDTH;																\
+			outputSamples += SIMD_WIDTH;															\
+		}																							\
+		while(numScalars--)	{																		\
+			const float a = *leftSamples++;															\
+			const float b = *rightSamples++;														\
+			*outputSamples++ = SCALAREXPR;															\
+		}																							\
+		SIMD_EXIT;																					\
+	}
+
+static SIMD_TARGET void SIMD_NAME(splat)(const float value, float *outputSamples, unsigned int numSamples)
+{
+	unsigned int numVectors = numSamples / SIMD_WIDTH;
+	unsigned int numScalars = numSamples % SIMD_WIDTH;
+	const SIMD_VEC valueVec = SIMD_SET1(value);
+	
+	while(numVectors--)
+	{
+		SIMD_STORE(outputSamples, valueVec);
+		outputSamples += SIMD_WIDTH;
+	}
+	
+	while(numScalars--)
+		*outputSamples++ = value;
+	
+	SIMD_EXIT;
+}
+
+static SIMD_TARGET void SIMD_NAME(clear)(float *outputSamples, unsigned int numSamples)
+{
+	SIMD_NAME(splat)(0.f, outputSamples, numSamples);
+}
+
+SIMD_UNARY_KERNEL(copy,			a,										a)
+SIMD_UNARY_KERNEL(neg,			SIMD_NEG(a),							-a)
+SIMD_UNARY_KERNEL(abs,			SIMD_ABS(a),							(float)fabs(a))
+SIMD_UNARY_KERNEL(reciprocal,	SIMD_DIV(SIMD_SET1(1.f), a),			1.f / a)
+SIMD_UNARY_KERNEL(squared,		SIMD_MUL(a, a),							a * a)
+SIMD_UNARY_KERNEL(cubed,		SIMD_MUL(SIMD_MUL(a, a), a),			a * a * a)
+SIMD_UNARY_KERNEL(sqrt,			SIMD_SQRT(a),							(float)::sqrt(a))
+
+SIMD_BINARY_KERNEL(add,			SIMD_ADD(a, b),							a + b)
+SIMD_BINARY_KERNEL(subtract,	SIMD_SUB(a, b),							a - b)
+SIMD_BINARY_KERNEL(multiply,	SIMD_MUL(a, b),							a * b)
+SIMD_BINARY_KERNEL(divide,		SIMD_DIV(a, b),							a / b)
+
+static SIMD_TARGET void SIMD_NAME(accumulate)(const float *inputSamples, float *outputSamples, unsigned int numSamples)
+{
+	SIMD_NAME(add)(outputSamples, inputSamples, outputSamples, numSamples);
+}
+
+static SIMD_TARGET void SIMD_NAME(mix)(const float * const *inputSamples, 
+									   unsigned int numInputs, 
+									   float *outputSamples, 
+									   unsigned int numSamples, 
+									   int shouldAccumulate)
+{
+	if(numInputs == 0)
+	{
+		if(!shouldAccumulate) SIMD_NAME(clear)(outputSamples, numSamples);
+		return;
+	}
+	
+	// the inputs are added in order to the running sum so the results match accumulate()
+	const unsigned int firstInput = shouldAccumulate ? 0 : 1;
+	const float * const startSamples = shouldAccumulate ? outputSamples : inputSamples[0];
+	unsigned int numVectors = numSamples / SIMD_WIDTH;
+	unsigned int numScalars = numSamples % SIMD_WIDTH;
+	unsigned int offset = 0;
+	
+	while(numVectors--)
+	{
+		SIMD_VEC sum = SIMD_LOAD(startSamples + offset);
+		
+		for(unsigned int input = firstInput; input < numInputs; input++)
+			sum = SIMD_ADD(sum, SIMD_LOAD(inputSamples[input] + offset));
+		
+		SIMD_STORE(outputSamples + offset, sum);
+		offset += SIMD_WIDTH;
+	}
+	
+	while(numScalars--)
+	{
+		float sum = startSamples[offset];
+		
+		for(unsigned int input = firstInput; input < numInputs; input++)
+			sum += inputSamples[input][offset];
+		
+		outputSamples[offset++] = sum;
+	}
+	
+	SIMD_EXIT;
+}
+
+static SIMD_TARGET void SIMD_NAME(accumulateCompensated)(const float *inputSamples, 
+														 float *sumSamples, 
+														 float *compensationSamples, 
+														 unsigned int numSamples)
+{
+	unsigned int numVectors = numSamples / SIMD_WIDTH;
+	unsigned int numScalars = numSamples % SIMD_WIDTH;
+	
+	// Kahan summation: the compensation holds the low order bits lost from the sum so far
+	while(numVectors--)
+	{
+		const SIMD_VEC sum = SIMD_LOAD(sumSamples);
+		const SIMD_VEC y = SIMD_SUB(SIMD_LOAD(inputSamples), SIMD_LOAD(compensationSamples));
+		const SIMD_VEC t = SIMD_ADD(sum, y);
+		SIMD_STORE(compensationSamples, SIMD_SUB(SIMD_SUB(t, sum), y));
+		SIMD_STORE(sumSamples, t);
+		inputSamples += SIMD_WIDTH;
+		sumSamples += SIMD_WIDTH;
+		compensationSamples += SIMD_WIDTH;
+	}
+	
+	while(numScalars--)
+	{
+		const float sum = *sumSamples;
+		const float y = *inputSamples++ - *compensationSamples;
+		const float t = sum + y;
+		*compensationSamples++ = (t - sum) - y;
+		*sumSamples++ = t;
+	}
+	
+	SIMD_EXIT;
+}
+
+static SIMD_TARGET void SIMD_NAME(multiplyAdd)(const float *inputSamples, 
+											   const float *mulSamples, 
+											   const float *addSamples, 
+											   float *outputSamples, 
+											   unsigned int numSamples)
+{
+	unsigned int numVectors = numSamples / SIMD_WIDTH;
+	unsigned int numScalars = numSamples % SIMD_WIDTH;
+	
+	while(numVectors--)
+	{
+		// separate multiply and add (rather than FMA) so the results match the scalar version
+		const SIMD_VEC product = SIMD_MUL(SIMD_LOAD(inputSamples), SIMD_LOAD(mulSamples));
+		SIMD_STORE(outputSamples, SIMD_ADD(product, SIMD_LOAD(addSamples)));
+		inputSamples += SIMD_WIDTH;
+		mulSamples += SIMD_WIDTH;
+		addSamples += SIMD_WIDTH;
+		outputSamples += SIMD_WIDTH;
+	}
+	
+	while(numScalars--)
+		*outputSamples++ = *inputSamples++ * *mulSamples++ + *addSamples++;
+	
+	SIMD_EXIT;
+}
+
+static SIMD_TARGET void SIMD_NAME(complexMultiplyAccumulate)(const float *leftReal, 
+															 const float *leftImag, 
+															 const float *rightReal, 
+															 const float *rightImag, 
+															 float *outputReal, 
+															 float *outputImag, 
+															 unsigned int numSamples)
+{
+	unsigned int numVectors = numSamples / SIMD_WIDTH;
+	unsigned int numScalars = numSamples % SIMD_WIDTH;
+	
+	while(numVectors--)
+	{
+		const SIMD_VEC lr = SIMD_LOAD(leftReal);
+		const SIMD_VEC li = SIMD_LOAD(leftImag);
+		const SIMD_VEC rr = SIMD_LOAD(rightReal);
+		const SIMD_VEC ri = SIMD_LOAD(rightImag);
+		const SIMD_VEC real = SIMD_SUB(SIMD_MUL(lr, rr), SIMD_MUL(li, ri));
+		const SIMD_VEC imag = SIMD_ADD(SIMD_MUL(lr, ri), SIMD_MUL(li, rr));
+		SIMD_STORE(outputReal, SIMD_ADD(SIMD_LOAD(outputReal), real));
+		SIMD_STORE(outputImag, SIMD_ADD(SIMD_LOAD(outputImag), imag));
+		leftReal += SIMD_WIDTH;
+		leftImag += SIMD_WIDTH;
+		rightReal += SIMD_WIDTH;
+		rightImag += SIMD_WIDTH;
+		outputReal += SIMD_WIDTH;
+		outputImag += SIMD_WIDTH;
+	}
+	
+	while(numScalars--)
+	{
+		const float lr = *leftReal++;
+		const float li = *leftImag++;
+		const float rr = *rightReal++;
+		const float ri = *rightImag++;
+		*outputReal++ += lr * rr - li * ri;
+		*outputImag++ += lr * ri + li * rr;
+	}
+	
+	SIMD_EXIT;
+}
+
+static SIMD_TARGET float SIMD_NAME(dotProduct)(const float *leftSamples, const float *rightSamples, unsigned int numSamples)
+{
+	unsigned int numVectors = numSamples / SIMD_WIDTH;
+	unsigned int numScalars = numSamples % SIMD_WIDTH;
+	SIMD_VEC sumVec = SIMD_SET1(0.f);
+	
+	while(numVectors--)
+	{
+		sumVec = SIMD_ADD(sumVec, SIMD_MUL(SIMD_LOAD(leftSamples), SIMD_LOAD(rightSamples)));
+		leftSamples += SIMD_WIDTH;
+		rightSamples += SIMD_WIDTH;
+	}
+	
+	float lanes[SIMD_WIDTH];
+	SIMD_STORE(lanes, sumVec);
+	
+	float sum = 0.f;
+	
+	for(int i = 0; i < SIMD_WIDTH; i++)
+		sum += lanes[i];
+	
+	while(numScalars--)
+		sum += *leftSamples++ * *rightSamples++;
+	
+	SIMD_EXIT;
+	return sum;
+}
+
+// four interleaved Ran088 (Tausworthe) generators, the state is s1, s2 and s3 for each lane
+#define SIMD_RAN088_NEXT(result)																	\
+	s1 = SIMD_U4_XOR(SIMD_U4_SHL(SIMD_U4_AND(s1, mask1), 12), SIMD_U4_SHR(SIMD_U4_XOR(SIMD_U4_SHL(s1, 13), s1), 19));	\
+	s2 = SIMD_U4_XOR(SIMD_U4_SHL(SIMD_U4_AND(s2, mask2),  4), SIMD_U4_SHR(SIMD_U4_XOR(SIMD_U4_SHL(s2,  2), s2), 25));	\
+	s3 = SIMD_U4_XOR(SIMD_U4_SHL(SIMD_U4_AND(s3, mask3), 17), SIMD_U4_SHR(SIMD_U4_XOR(SIMD_U4_SHL(s3,  3), s3), 11));	\
+	result = SIMD_U4_XOR(SIMD_U4_XOR(s1, s2), s3)
+
+#define SIMD_RAN088_BEGIN																			\
+	SIMD_U4 s1 = SIMD_U4_LOAD(state);																\
+	SIMD_U4 s2 = SIMD_U4_LOAD(state + 4);															\
+	SIMD_U4 s3 = SIMD_U4_LOAD(state + 8);															\
+	const SIMD_U4 mask1 = SIMD_U4_SET1(0xFFFFFFFEU);												\
+	const SIMD_U4 mask2 = SIMD_U4_SET1(0xFFFFFFF8U);												\
+	const SIMD_U4 mask3 = SIMD_U4_SET1(0xFFFFFFF0U);												\
+	SIMD_U4 values;																					\
+	unsigned int numVectors = numValues / 4;														\
+	unsigned int numScalars = numValues % 4
+
+#define SIMD_RAN088_END																				\
+	SIMD_U4_STORE(state, s1);																		\
+	SIMD_U4_STORE(state + 4, s2);																	\
+	SIMD_U4_STORE(state + 8, s3)
+
+static SIMD_TARGET void SIMD_NAME(ran088)(unsigned int *state, unsigned int *outputValues, unsigned int numValues)
+{
+	SIMD_RAN088_BEGIN;
+	
+	while(numVectors--)
+	{
+		SIMD_RAN088_NEXT(values);
+		SIMD_U4_STORE(outputValues, values);
+		outputValues += 4;
+	}
+	
+	if(numScalars)
+	{
+		// all the lanes advance so the scalar and vector versions match
+		unsigned int lanes[4];
+		SIMD_RAN088_NEXT(values);
+		SIMD_U4_STORE(lanes, values);
+		
+		for(unsigned int i = 0; i < numScalars; i++)
+			outputValues[i] = lanes[i];
+	}
+	
+	SIMD_RAN088_END;
+}
+
+static SIMD_TARGET void SIMD_NAME(ran088Float)(unsigned int *state, 
+											   const unsigned int exponentBits, 
+											   const float offset, 
+											   float *outputSamples, 
+											   unsigned int numValues)
+{
+	SIMD_RAN088_BEGIN;
+	const SIMD_U4 exponent = SIMD_U4_SET1(exponentBits);
+	
+	while(numVectors--)
+	{
+		SIMD_RAN088_NEXT(values);
+		SIMD_U4_STORE_FLOAT(outputSamples, SIMD_U4_XOR(SIMD_U4_SHR(values, 9), exponent), offset);
+		outputSamples += 4;
+	}
+	
+	if(numScalars)
+	{
+		float lanes[4];
+		SIMD_RAN088_NEXT(values);
+		SIMD_U4_STORE_FLOAT(lanes, SIMD_U4_XOR(SIMD_U4_SHR(values, 9), exponent), offset);
+		
+		for(unsigned int i = 0; i < numScalars; i++)
+			outputSamples[i] = lanes[i];
+	}
+	
+	SIMD_RAN088_END;
+}
+
+// numLanes interleaved biquads (e.g., one for each channel of a filter bank), sample i of lane j 
+// is samples[i * numLanes + j], coefficient k (a0, a1, a2, b1, b2) of lane j is coeffs[k * numLanes + j]
+// and its y1 and y2 are state[j] and state[numLanes + j], numLanes must be a multiple of SIMD_WIDTH
+#define SIMD_BIQUAD_STEP																			\
+	const SIMD_VEC y0 = SIMD_ADD(SIMD_ADD(SIMD_LOAD(frame), SIMD_MUL(b1, y1)), SIMD_MUL(b2, y2));	\
+	SIMD_STORE(frame, SIMD_ADD(SIMD_ADD(SIMD_MUL(a0, y0), SIMD_MUL(a1, y1)), SIMD_MUL(a2, y2)));	\
+	y2 = y1;																						\
+	y1 = y0;																						\
+	frame += numLanes
+
+static SIMD_TARGET void SIMD_NAME(biquadLanes)(float *samples, 
+											   unsigned int numFrames, 
+											   unsigned int numLanes, 
+											   float *coeffs, 
+											   const float *slopes, 
+											   unsigned int coeffFrameStride, 
+											   float *state)
+{
+	for(unsigned int lane = 0; lane < numLanes; lane += SIMD_WIDTH)
+	{
+		float *frame = samples + lane;
+		float *laneCoeffs = coeffs + lane;
+		SIMD_VEC y1 = SIMD_LOAD(state + lane);
+		SIMD_VEC y2 = SIMD_LOAD(state + numLanes + lane);
+		SIMD_VEC a0 = SIMD_LOAD(laneCoeffs);
+		SIMD_VEC a1 = SIMD_LOAD(laneCoeffs + numLanes);
+		SIMD_VEC a2 = SIMD_LOAD(laneCoeffs + numLanes * 2);
+		SIMD_VEC b1 = SIMD_LOAD(laneCoeffs + numLanes * 3);
+		SIMD_VEC b2 = SIMD_LOAD(laneCoeffs + numLanes * 4);
+		unsigned int numFramesLeft = numFrames;
+		
+		if(coeffFrameStride != 0)
+		{
+			// a new set of coefficients for each frame
+			while(numFramesLeft--)
+			{
+				a0 = SIMD_LOAD(laneCoeffs);
+				a1 = SIMD_LOAD(laneCoeffs + numLanes);
+				a2 = SIMD_LOAD(laneCoeffs + numLanes * 2);
+				b1 = SIMD_LOAD(laneCoeffs + numLanes * 3);
+				b2 = SIMD_LOAD(laneCoeffs + numLanes * 4);
+				laneCoeffs += coeffFrameStride;
+				SIMD_BIQUAD_STEP;
+			}
+		}
+		else if(slopes != 0)
+		{
+			// the coefficients move by their slope after each frame and are stored for the next call
+			const float *laneSlopes = slopes + lane;
+			const SIMD_VEC a0Slope = SIMD_LOAD(laneSlopes);
+			const SIMD_VEC a1Slope = SIMD_LOAD(laneSlopes + numLanes);
+			const SIMD_VEC a2Slope = SIMD_LOAD(laneSlopes + numLanes * 2);
+			const SIMD_VEC b1Slope = SIMD_LOAD(laneSlopes + numLanes * 3);
+			const SIMD_VEC b2Slope = SIMD_LOAD(laneSlopes + numLanes * 4);
+			
+			while(numFramesLeft--)
+			{
+				SIMD_BIQUAD_STEP;
+				a0 = SIMD_ADD(a0, a0Slope);
+				a1 = SIMD_ADD(a1, a1Slope);
+				a2 = SIMD_ADD(a2, a2Slope);
+				b1 = SIMD_ADD(b1, b1Slope);
+				b2 = SIMD_ADD(b2, b2Slope);
+			}
+			
+			SIMD_STORE(laneCoeffs, a0);
+			SIMD_STORE(laneCoeffs + numLanes, a1);
+			SIMD_STORE(laneCoeffs + numLanes * 2, a2);
+			SIMD_STORE(laneCoeffs + numLanes * 3, b1);
+			SIMD_STORE(laneCoeffs + numLanes * 4, b2);
+		}
+		else
+		{
+			while(numFramesLeft--)
+			{
+				SIMD_BIQUAD_STEP;
+			}
+		}
+		
+		SIMD_STORE(state + lane, y1);
+		SIMD_STORE(state + numLanes + lane, y2);
+	}
+	
+	SIMD_EXIT;
+}
+
+// the gain of input j for output k is gains[k * numInputs + j] (plus slopes[k * numInputs + j] * (i + 1) for 
+// sample i when ramping), each output sums its inputs in order so the results match for every instruction set
+static SIMD_TARGET void SIMD_NAME(matrixMix)(const float * const *inputSamples, 
+											 unsigned int numInputs, 
+											 float * const *outputSamples, 
+											 unsigned int numOutputs, 
+											 const float *gains, 
+											 const float *slopes, 
+											 unsigned int numSamples, 
+											 int shouldAccumulate)
+{
+	float firstSteps[SIMD_WIDTH];
+	
+	for(unsigned int i = 0; i < SIMD_WIDTH; i++)
+		firstSteps[i] = (float)(i + 1);
+	
+	const SIMD_VEC firstStep = SIMD_LOAD(firstSteps);
+	const SIMD_VEC zero = SIMD_SET1(0.f);
+	
+	for(unsigned int output = 0; output < numOutputs; output++)
+	{
+		float *outputs = outputSamples[output];
+		const float *outputGains = gains + output * numInputs;
+		const float *outputSlopes = slopes == 0 ? 0 : slopes + output * numInputs;
+		unsigned int offset = 0;
+		
+		// four vectors at a time so each gain is used for four independent sums
+		for(; offset + SIMD_WIDTH * 4 <= numSamples; offset += SIMD_WIDTH * 4)
+		{
+			const SIMD_VEC step0 = SIMD_ADD(firstStep, SIMD_SET1((float)offset));
+			const SIMD_VEC step1 = SIMD_ADD(firstStep, SIMD_SET1((float)(offset + SIMD_WIDTH)));
+			const SIMD_VEC step2 = SIMD_ADD(firstStep, SIMD_SET1((float)(offset + SIMD_WIDTH * 2)));
+			const SIMD_VEC step3 = SIMD_ADD(firstStep, SIMD_SET1((float)(offset + SIMD_WIDTH * 3)));
+			SIMD_VEC sum0 = shouldAccumulate ? SIMD_LOAD(outputs + offset) : zero;
+			SIMD_VEC sum1 = shouldAccumulate ? SIMD_LOAD(outputs + offset + SIMD_WIDTH) : zero;
+			SIMD_VEC sum2 = shouldAccumulate ? SIMD_LOAD(outputs + offset + SIMD_WIDTH * 2) : zero;
+			SIMD_VEC sum3 = shouldAccumulate ? SIMD_LOAD(outputs + offset + SIMD_WIDTH * 3) : zero;
+			
+			if(outputSlopes == 0)
+			{
+				for(unsigned int input = 0; input < numInputs; input++)
+				{
+					const float *inputs = inputSamples[input] + offset;
+					const SIMD_VEC gain = SIMD_SET1(outputGains[input]);
+					sum0 = SIMD_ADD(sum0, SIMD_MUL(SIMD_LOAD(inputs), gain));
+					sum1 = SIMD_ADD(sum1, SIMD_MUL(SIMD_LOAD(inputs + SIMD_WIDTH), gain));
+					sum2 = SIMD_ADD(sum2, SIMD_MUL(SIMD_LOAD(inputs + SIMD_WIDTH * 2), gain));
+					sum3 = SIMD_ADD(sum3, SIMD_MUL(SIMD_LOAD(inputs + SIMD_WIDTH * 3), gain));
+				}
+			}
+			else
+			{
+				for(unsigned int input = 0; input < numInputs; input++)
+				{
+					const float *inputs = inputSamples[input] + offset;
+					const SIMD_VEC gain = SIMD_SET1(outputGains[input]);
+					const SIMD_VEC slope = SIMD_SET1(outputSlopes[input]);
+					sum0 = SIMD_ADD(sum0, SIMD_MUL(SIMD_LOAD(inputs), SIMD_ADD(gain, SIMD_MUL(slope, step0))));
+					sum1 = SIMD_ADD(sum1, SIMD_MUL(SIMD_LOAD(inputs + SIMD_WIDTH), SIMD_ADD(gain, SIMD_MUL(slope, step1))));
+					sum2 = SIMD_ADD(sum2, SIMD_MUL(SIMD_LOAD(inputs + SIMD_WIDTH * 2), SIMD_ADD(gain, SIMD_MUL(slope, step2))));
+					sum3 = SIMD_ADD(sum3, SIMD_MUL(SIMD_LOAD(inputs + SIMD_WIDTH * 3), SIMD_ADD(gain, SIMD_MUL(slope, step3))));
+				}
+			}
+			
+			SIMD_STORE(outputs + offset, sum0);
+			SIMD_STORE(outputs + offset + SIMD_WIDTH, sum1);
+			SIMD_STORE(outputs + offset + SIMD_WIDTH * 2, sum2);
+			SIMD_STORE(outputs + offset + SIMD_WIDTH * 3, sum3);
+		}
+		
+		for(; offset + SIMD_WIDTH <= numSamples; offset += SIMD_WIDTH)
+		{
+			const SIMD_VEC step = SIMD_ADD(firstStep, SIMD_SET1((float)offset));
+			SIMD_VEC sum = shouldAccumulate ? SIMD_LOAD(outputs + offset) : zero;
+			
+			for(unsigned int input = 0; input < numInputs; input++)
+			{
+				const SIMD_VEC gain = outputSlopes == 0 ? SIMD_SET1(outputGains[input]) 
+														: SIMD_ADD(SIMD_SET1(outputGains[input]), SIMD_MUL(SIMD_SET1(outputSlopes[input]), step));
+				sum = SIMD_ADD(sum, SIMD_MUL(SIMD_LOAD(inputSamples[input] + offset), gain));
+			}
+			
+			SIMD_STORE(outputs + offset, sum);
+		}
+		
+		for(; offset < numSamples; offset++)
+		{
+			const float step = (float)(offset + 1);
+			float sum = shouldAccumulate ? outputs[offset] : 0.f;
+			
+			for(unsigned int input = 0; input < numInputs; input++)
+			{
+				const float gain = outputSlopes == 0 ? outputGains[input] : outputGains[input] + outputSlopes[input] * step;
+				sum += inputSamples[input][offset] * gain;
+			}
+			
+			outputs[offset] = sum;
+		}
+	}
+	
+	SIMD_EXIT;
+}
+
+static const SIMD::Kernels SIMD_NAME(kernels) = 
+{
+	SIMD_NAME(clear),
+	SIMD_NAME(splat),
+	SIMD_NAME(copy),
+	SIMD_NAME(neg),
+	SIMD_NAME(abs),
+	SIMD_NAME(reciprocal),
+	SIMD_NAME(squared),
+	SIMD_NAME(cubed),
+	SIMD_NAME(sqrt),
+	SIMD_NAME(add),
+	SIMD_NAME(subtract),
+	SIMD_NAME(multiply),
+	SIMD_NAME(divide),
+	SIMD_NAME(accumulate),
+	SIMD_NAME(mix),
+	SIMD_NAME(accumulateCompensated),
+	SIMD_NAME(multiplyAdd),
+	SIMD_NAME(complexMultiplyAccumulate),
+	SIMD_NAME(dotProduct),
+	SIMD_NAME(ran088),
+	SIMD_NAME(ran088Float),
+	SIMD_NAME(biquadLanes),
+	SIMD_NAME(matrixMix)
+};
+
+#undef SIMD_UNARY_KERNEL
+#undef SIMD_BINARY_KERNEL
+#undef SIMD_RAN088_NEXT
+#undef SIMD_RAN088_BEGIN
+#undef SIMD_RAN088_END
+#undef SIMD_BIQUAD_STEP
+
+#undef SIMD_NAME
+#undef SIMD_TARGET
+#undef SIMD_EXIT
+#undef SIMD_WIDTH
+#undef SIMD_VEC
+#undef SIMD_LOAD
+#undef SIMD_STORE
+#undef SIMD_SET1
+#undef SIMD_ADD
+#undef SIMD_SUB
+#undef SIMD_MUL
+#undef SIMD_DIV
+#undef SIMD_SQRT
+#undef SIMD_ABS
+#undef SIMD_NEG
+#undef SIMD_U4
+#undef SIMD_U4_LOAD
+#undef SIMD_U4_STORE
+#undef SIMD_U4_SET1
+#undef SIMD_U4_AND
+#undef SIMD_U4_XOR
+#undef SIMD_U4_SHL
+#undef SIMD_U4_SHR
+#undef SIMD_U4_STORE_FLOAT
@@ -0,0 +1,334 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#include "../core/ugen_StandardHeader.h"
+
+#ifdef UGEN_SIMD
+
+// the intrinsics headers must be outside the UGen namespace
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define UGEN_SIMD_X86 1
+	#include <immintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+		#define UGEN_SIMD_SSE_TARGET
+		#define UGEN_SIMD_AVX_TARGET
+	#else
+		#define UGEN_SIMD_SSE_TARGET __attribute__ ((target ("sse2")))
+		#define UGEN_SIMD_AVX_TARGET __attribute__ ((target ("avx")))
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define UGEN_SIMD_ARM64 1
+	#include <arm_neon.h>
+#endif
+
+BEGIN_UGEN_NAMESPACE
+
+#include "ugen_simd_Utilities.h"
+
+// generate the kernels for each instruction set, see ugen_simd_Kernels.h
+
+// four unsigned int lanes for the scalar random number kernels
+struct ScalarU4 { unsigned int lane[4]; };
+
+static inline ScalarU4 scalarU4Load(const unsigned int *ptr) 
+{ 
+	ScalarU4 r; 
+	for(int i = 0; i < 4; i++) r.lane[i] = ptr[i]; 
+	return r; 
+}
+
+static inline void scalarU4Store(unsigned int *ptr, ScalarU4 const& a) 
+{ 
+	for(int i = 0; i < 4; i++) ptr[i] = a.lane[i]; 
+}
+
+static inline ScalarU4 scalarU4Set1(const unsigned int value) 
+{ 
+	ScalarU4 r; 
+	for(int i = 0; i < 4; i++) r.lane[i] = value; 
+	return r; 
+}
+
+static inline ScalarU4 scalarU4And(ScalarU4 const& a, ScalarU4 const& b) 
+{ 
+	ScalarU4 r; 
+	for(int i = 0; i < 4; i++) r.lane[i] = a.lane[i] & b.lane[i]; 
+	return r; 
+}
+
+static inline ScalarU4 scalarU4Xor(ScalarU4 const& a, ScalarU4 const& b) 
+{ 
+	ScalarU4 r; 
+	for(int i = 0; i < 4; i++) r.lane[i] = a.lane[i] ^ b.lane[i]; 
+	return r; 
+}
+
+static inline ScalarU4 scalarU4Shl(ScalarU4 const& a, const int n) 
+{ 
+	ScalarU4 r; 
+	for(int i = 0; i < 4; i++) r.lane[i] = a.lane[i] << n; 
+	return r; 
+}
+
+static inline ScalarU4 scalarU4Shr(ScalarU4 const& a, const int n) 
+{ 
+	ScalarU4 r; 
+	for(int i = 0; i < 4; i++) r.lane[i] = a.lane[i] >> n; 
+	return r; 
+}
+
+static inline void scalarU4StoreFloat(float *ptr, ScalarU4 const& bits, const float offset) 
+{ 
+	for(int i = 0; i < 4; i++)
+	{
+		union { unsigned int i; float f; } u;
+		u.i = bits.lane[i];
+		ptr[i] = u.f - offset;
+	}
+}
+
+#define SIMD_NAME(name)		scalar_##name
+#define SIMD_TARGET
+#define SIMD_WIDTH			1
+#define SIMD_VEC			float
+#define SIMD_LOAD(ptr)		(*(ptr))
+#define SIMD_STORE(ptr, v)	(*(ptr) = (v))
+#define SIMD_SET1(value)	(value)
+#define SIMD_ADD(a, b)		((a) + (b))
+#define SIMD_SUB(a, b)		((a) - (b))
+#define SIMD_MUL(a, b)		((a) * (b))
+#define SIMD_DIV(a, b)		((a) / (b))
+#define SIMD_SQRT(a)		((float)::sqrt(a))
+#define SIMD_ABS(a)			((float)fabs(a))
+#define SIMD_NEG(a)			(-(a))
+#define SIMD_U4							ScalarU4
+#define SIMD_U4_LOAD(ptr)				scalarU4Load(ptr)
+#define SIMD_U4_STORE(ptr, v)			scalarU4Store((ptr), (v))
+#define SIMD_U4_SET1(value)				scalarU4Set1(value)
+#define SIMD_U4_AND(a, b)				scalarU4And((a), (b))
+#define SIMD_U4_XOR(a, b)				scalarU4Xor((a), (b))
+#define SIMD_U4_SHL(a, n)				scalarU4Shl((a), (n))
+#define SIMD_U4_SHR(a, n)				scalarU4Shr((a), (n))
+#define SIMD_U4_STORE_FLOAT(ptr, v, o)	scalarU4StoreFloat((ptr), (v), (o))
+#include "ugen_simd_Kernels.h"
+
+#if defined(UGEN_SIMD_X86)
+
+#define SIMD_NAME(name)		sse_##name
+#define SIMD_TARGET			UGEN_SIMD_SSE_TARGET
+#define SIMD_WIDTH			4
+#define SIMD_VEC			__m128
+#define SIMD_LOAD(ptr)		_mm_loadu_ps(ptr)
+#define SIMD_STORE(ptr, v)	_mm_storeu_ps((ptr), (v))
+#define SIMD_SET1(value)	_mm_set1_ps(value)
+#define SIMD_ADD(a, b)		_mm_add_ps((a), (b))
+#define SIMD_SUB(a, b)		_mm_sub_ps((a), (b))
+#define SIMD_MUL(a, b)		_mm_mul_ps((a), (b))
+#define SIMD_DIV(a, b)		_mm_div_ps((a), (b))
+#define SIMD_SQRT(a)		_mm_sqrt_ps(a)
+#define SIMD_ABS(a)			_mm_andnot_ps(_mm_set1_ps(-0.f), (a))
+#define SIMD_NEG(a)			_mm_xor_ps(_mm_set1_ps(-0.f), (a))
+#define SIMD_U4							__m128i
+#define SIMD_U4_LOAD(ptr)				_mm_loadu_si128((const __m128i*)(ptr))
+#define SIMD_U4_STORE(ptr, v)			_mm_storeu_si128((__m128i*)(ptr), (v))
+#define SIMD_U4_SET1(value)				_mm_set1_epi32((int)(value))
+#define SIMD_U4_AND(a, b)				_mm_and_si128((a), (b))
+#define SIMD_U4_XOR(a, b)				_mm_xor_si128((a), (b))
+#define SIMD_U4_SHL(a, n)				_mm_slli_epi32((a), (n))
+#define SIMD_U4_SHR(a, n)				_mm_srli_epi32((a), (n))
+#define SIMD_U4_STORE_FLOAT(ptr, v, o)	_mm_storeu_ps((ptr), _mm_sub_ps(_mm_castsi128_ps(v), _mm_set1_ps(o)))
+#include "ugen_simd_Kernels.h"
+
+#define SIMD_NAME(name)		avx_##name
+#define SIMD_TARGET			UGEN_SIMD_AVX_TARGET
+#define SIMD_EXIT			_mm256_zeroupper() // don't rely on the compiler's vzeroupper insertion (e.g., at -O1)
+#define SIMD_WIDTH			8
+#define SIMD_VEC			__m256
+#define SIMD_LOAD(ptr)		_mm256_loadu_ps(ptr)
+#define SIMD_STORE(ptr, v)	_mm256_storeu_ps((ptr), (v))
+#define SIMD_SET1(value)	_mm256_set1_ps(value)
+#define SIMD_ADD(a, b)		_mm256_add_ps((a), (b))
+#define SIMD_SUB(a, b)		_mm256_sub_ps((a), (b))
+#define SIMD_MUL(a, b)		_mm256_mul_ps((a), (b))
+#define SIMD_DIV(a, b)		_mm256_div_ps((a), (b))
+#define SIMD_SQRT(a)		_mm256_sqrt_ps(a)
+#define SIMD_ABS(a)			_mm256_andnot_ps(_mm256_set1_ps(-0.f), (a))
+#define SIMD_NEG(a)			_mm256_xor_ps(_mm256_set1_ps(-0.f), (a))
+// AVX (unlike AVX2) has no 256-bit integer operations so these are the SSE2 ones
+#define SIMD_U4							__m128i
+#define SIMD_U4_LOAD(ptr)				_mm_loadu_si128((const __m128i*)(ptr))
+#define SIMD_U4_STORE(ptr, v)			_mm_storeu_si128((__m128i*)(ptr), (v))
+#define SIMD_U4_SET1(value)				_mm_set1_epi32((int)(value))
+#define SIMD_U4_AND(a, b)				_mm_and_si128((a), (b))
+#define SIMD_U4_XOR(a, b)				_mm_xor_si128((a), (b))
+#define SIMD_U4_SHL(a, n)				_mm_slli_epi32((a), (n))
+#define SIMD_U4_SHR(a, n)				_mm_srli_epi32((a), (n))
+#define SIMD_U4_STORE_FLOAT(ptr, v, o)	_mm_storeu_ps((ptr), _mm_sub_ps(_mm_castsi128_ps(v), _mm_set1_ps(o)))
+#include "ugen_simd_Kernels.h"
+
+static bool cpuHasSSE() throw()
+{
+#if defined(_M_X64) || defined(__x86_64__)
+	return true; // part of the x86-64 baseline
+#elif defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2") != 0;
+#endif
+}
+
+static bool cpuHasAVX() throw()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 1);
+	
+	const bool osUsesXSAVE = (info[2] & (1 << 27)) != 0;
+	const bool cpuAVXSupport = (info[2] & (1 << 28)) != 0;
+	
+	if(osUsesXSAVE && cpuAVXSupport)
+		return (_xgetbv(0) & 0x6) == 0x6; // OS saves the YMM registers
+	
+	return false;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx") != 0;
+#endif
+}
+
+#elif defined(UGEN_SIMD_ARM64)
+
+#define SIMD_NAME(name)		neon_##name
+#define SIMD_TARGET
+#define SIMD_WIDTH			4
+#define SIMD_VEC			float32x4_t
+#define SIMD_LOAD(ptr)		vld1q_f32(ptr)
+#define SIMD_STORE(ptr, v)	vst1q_f32((ptr), (v))
+#define SIMD_SET1(value)	vdupq_n_f32(value)
+#define SIMD_ADD(a, b)		vaddq_f32((a), (b))
+#define SIMD_SUB(a, b)		vsubq_f32((a), (b))
+#define SIMD_MUL(a, b)		vmulq_f32((a), (b))
+#define SIMD_DIV(a, b)		vdivq_f32((a), (b))
+#define SIMD_SQRT(a)		vsqrtq_f32(a)
+#define SIMD_ABS(a)			vabsq_f32(a)
+#define SIMD_NEG(a)			vnegq_f32(a)
+#define SIMD_U4							uint32x4_t
+#define SIMD_U4_LOAD(ptr)				vld1q_u32(ptr)
+#define SIMD_U4_STORE(ptr, v)			vst1q_u32((ptr), (v))
+#define SIMD_U4_SET1(value)				vdupq_n_u32(value)
+#define SIMD_U4_AND(a, b)				vandq_u32((a), (b))
+#define SIMD_U4_XOR(a, b)				veorq_u32((a), (b))
+#define SIMD_U4_SHL(a, n)				vshlq_n_u32((a), (n))
+#define SIMD_U4_SHR(a, n)				vshrq_n_u32((a), (n))
+#define SIMD_U4_STORE_FLOAT(ptr, v, o)	vst1q_f32((ptr), vsubq_f32(vreinterpretq_f32_u32(v), vdupq_n_f32(o)))
+#include "ugen_simd_Kernels.h"
+
+#endif
+
+
+const SIMD::Kernels* SIMD::kernels = SIMD::getKernels(SIMD::getBestInstructionSet());
+SIMD::InstructionSet SIMD::current = SIMD::getBestInstructionSet();
+
+const SIMD::Kernels* SIMD::getKernels(const InstructionSet instructionSet) throw()
+{
+	switch(instructionSet)
+	{
+#if defined(UGEN_SIMD_X86)
+		case SSE:	return &sse_kernels;
+		case AVX:	return &avx_kernels;
+#elif defined(UGEN_SIMD_ARM64)
+		case NEON:	return &neon_kernels;
+#endif
+		default:	return &scalar_kernels;
+	}
+}
+
+bool SIMD::isSupported(const InstructionSet instructionSet) throw()
+{
+	switch(instructionSet)
+	{
+		case Scalar:	return true;
+#if defined(UGEN_SIMD_X86)
+		case SSE:		return cpuHasSSE();
+		case AVX:		return cpuHasSSE() && cpuHasAVX();
+#elif defined(UGEN_SIMD_ARM64)
+		case NEON:		return true;
+#endif
+		default:		return false;
+	}
+}
+
+SIMD::InstructionSet SIMD::getBestInstructionSet() throw()
+{
+	if(isSupported(AVX))	return AVX;
+	if(isSupported(SSE))	return SSE;
+	if(isSupported(NEON))	return NEON;
+	return Scalar;
+}
+
+SIMD::InstructionSet SIMD::getInstructionSet() throw()
+{
+	return current;
+}
+
+bool SIMD::setInstructionSet(const InstructionSet instructionSet) throw()
+{
+	if(isSupported(instructionSet) == false)
+		return false;
+	
+	current = instructionSet;
+	kernels = getKernels(instructionSet);
+	return true;
+}
+
+const char* SIMD::getInstructionSetName(const InstructionSet instructionSet) throw()
+{
+	static const char* names[NumInstructionSets] = { "Scalar", "SSE", "AVX", "NEON" };
+	
+	if(instructionSet < 0 || instructionSet >= NumInstructionSets)
+		return "Unknown";
+	
+	return names[instructionSet];
+}
+
+END_UGEN_NAMESPACE
+
+#endif // UGEN_SIMD
@@ -0,0 +1,292 @@
+// $Id$
+// $HeadURL$
+
+/*
+ ==============================================================================
+ 
+ This file is part of the UGEN++ library
+ Copyright 2008-11 The University of the West of England.
+ by Martin Robinson
+ 
+ ------------------------------------------------------------------------------
+ 
+ UGEN++ can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ UGEN++ is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with UGEN++; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ 
+ The idea for this project and code in the UGen implementations is
+ derived from SuperCollider which is also released under the 
+ GNU General Public License:
+ 
+ SuperCollider real time audio synthesis system
+ Copyright (c) 2002 James McCartney. All rights reserved.
+ http://www.audiosynth.com
+ 
+ ==============================================================================
+ */
+
+#ifndef _UGEN_ugen_simd_Utilities_H_
+#define _UGEN_ugen_simd_Utilities_H_
+
+/** Portable vectorised kernels for the core UGen processing functions.
+ 
+ This is the equivalent of the vDSP (Mac/iOS) and Neon (iPhone) support for other
+ platforms (e.g., Linux and Windows on x86-64 or ARM64). Define UGEN_SIMD=1 in the 
+ project's preprocessor macros to replace the scalar processBlock() functions of
+ the basic UGens (scalars, binary/unary ops, MulAdd and Mix) with versions that 
+ use these kernels (see vec/ugen_simd_Basics.cpp, vec/ugen_simd_BinaryOpUGens.cpp
+ and vec/ugen_simd_UnaryOpUGens.cpp).
+ 
+ The instruction set is chosen at runtime based on the features of the CPU (AVX then 
+ SSE on x86, NEON on ARM64) but may be changed using setInstructionSet(), for example
+ selecting Scalar to compare the vectorised output against the plain C++ version.
+ 
+ All functions operate on unaligned data and may operate in-place (i.e., the output 
+ may be the same array as any of the inputs). */
+class SIMD
+{
+public:
+	enum InstructionSet
+	{
+		Scalar,
+		SSE,
+		AVX,
+		NEON,
+		NumInstructionSets
+	};
+	
+	/** Returns the instruction set currently in use. */
+	static InstructionSet getInstructionSet() throw();
+	
+	/** Returns the best instruction set supported by this CPU and build. */
+	static InstructionSet getBestInstructionSet() throw();
+	
+	/** Returns true if the instruction set is supported by this CPU and build. */
+	static bool isSupported(const InstructionSet instructionSet) throw();
+	
+	/** Choose the instruction set to use.
+	 This should not be called while audio is being processed. 
+	 @return true if successful, false if the instruction set is not supported. */
+	static bool setInstructionSet(const InstructionSet instructionSet) throw();
+	
+	/** Returns a name for the instruction set (e.g., for logging). */
+	static const char* getInstructionSetName(const InstructionSet instructionSet) throw();
+	
+	/** A table of kernel functions for one instruction set. @internal */
+	struct Kernels
+	{
+		void (*clear)(float *outputSamples, unsigned int numSamples);
+		void (*splat)(const float value, float *outputSamples, unsigned int numSamples);
+		void (*copy)(const float *inputSamples, float *outputSamples, unsigned int numSamples);
+		
+		void (*neg)(const float *inputSamples, float *outputSamples, unsigned int numSamples);
+		void (*abs)(const float *inputSamples, float *outputSamples, unsigned int numSamples);
+		void (*reciprocal)(const float *inputSamples, float *outputSamples, unsigned int numSamples);
+		void (*squared)(const float *inputSamples, float *outputSamples, unsigned int numSamples);
+		void (*cubed)(const float *inputSamples, float *outputSamples, unsigned int numSamples);
+		void (*sqrt)(const float *inputSamples, float *outputSamples, unsigned int numSamples);
+		
+		void (*add)(const float *leftSamples, const float *rightSamples, float *outputSamples, unsigned int numSamples);
+		void (*subtract)(const float *leftSamples, const float *rightSamples, float *outputSamples, unsigned int numSamples);
+		void (*multiply)(const float *leftSamples, const float *rightSamples, float *outputSamples, unsigned int numSamples);
+		void (*divide)(const float *leftSamples, const float *rightSamples, float *outputSamples, unsigned int numSamples);
+		
+		void (*accumulate)(const float *inputSamples, float *outputSamples, unsigned int numSamples);
+		void (*mix)(const float * const *inputSamples, unsigned int numInputs, float *outputSamples, unsigned int numSamples, int shouldAccumulate);
+		void (*accumulateCompensated)(const float *inputSamples, float *sumSamples, float *compensationSamples, unsigned int numSamples);
+		void (*multiplyAdd)(const float *inputSamples, const float *mulSamples, const float *addSamples, float *outputSamples, unsigned int numSamples);
+		void (*complexMultiplyAccumulate)(const float *leftReal, const float *leftImag, const float *rightReal, const float *rightImag, float *outputReal, float *outputImag, unsigned int numSamples);
+		float (*dotProduct)(const float *leftSamples, const float *rightSamples, unsigned int numSamples);
+		void (*ran088)(unsigned int *state, unsigned int *outputValues, unsigned int numValues);
+		void (*ran088Float)(unsigned int *state, const unsigned int exponentBits, const float offset, float *outputSamples, unsigned int numValues);
+		void (*biquadLanes)(float *samples, unsigned int numFrames, unsigned int numLanes, float *coeffs, const float *slopes, unsigned int coeffFrameStride, float *state);
+		void (*matrixMix)(const float * const *inputSamples, unsigned int numInputs, float * const *outputSamples, unsigned int numOutputs, const float *gains, const float *slopes, unsigned int numSamples, int shouldAccumulate);
+	};
+	
+	// unary ops
+	
+	static inline void clear(float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->clear(outputSamples, numSamples);
+	}
+	
+	static inline void splat(const float value, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->splat(value, outputSamples, numSamples);
+	}
+	
+	static inline void copy(const float *inputSamples, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->copy(inputSamples, outputSamples, numSamples);
+	}
+	
+	static inline void neg(const float *inputSamples, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->neg(inputSamples, outputSamples, numSamples);
+	}
+	
+	static inline void abs(const float *inputSamples, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->abs(inputSamples, outputSamples, numSamples);
+	}
+	
+	static inline void reciprocal(const float *inputSamples, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->reciprocal(inputSamples, outputSamples, numSamples);
+	}
+	
+	static inline void squared(const float *inputSamples, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->squared(inputSamples, outputSamples, numSamples);
+	}
+	
+	static inline void cubed(const float *inputSamples, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->cubed(inputSamples, outputSamples, numSamples);
+	}
+	
+	static inline void sqrt(const float *inputSamples, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->sqrt(inputSamples, outputSamples, numSamples);
+	}
+	
+	// binary ops
+	
+	static inline void add(const float *leftSamples, const float *rightSamples, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->add(leftSamples, rightSamples, outputSamples, numSamples);
+	}
+	
+	static inline void subtract(const float *leftSamples, const float *rightSamples, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->subtract(leftSamples, rightSamples, outputSamples, numSamples);
+	}
+	
+	static inline void multiply(const float *leftSamples, const float *rightSamples, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->multiply(leftSamples, rightSamples, outputSamples, numSamples);
+	}
+	
+	static inline void divide(const float *leftSamples, const float *rightSamples, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->divide(leftSamples, rightSamples, outputSamples, numSamples);
+	}
+	
+	// others
+	
+	/** outputSamples[i] += inputSamples[i] */
+	static inline void accumulate(const float *inputSamples, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->accumulate(inputSamples, outputSamples, numSamples);
+	}
+	
+	/** outputSamples[i] = inputSamples[0][i] + inputSamples[1][i] + ... 
+	 The output may be the same as inputSamples[0] but not any of the other inputs. */
+	static inline void mix(const float * const *inputSamples, unsigned int numInputs, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->mix(inputSamples, numInputs, outputSamples, numSamples, 0);
+	}
+	
+	/** outputSamples[i] += inputSamples[0][i] + inputSamples[1][i] + ... 
+	 This reads and writes the output once for all the inputs, the results are the same as
+	 calling accumulate() for each input in turn. */
+	static inline void mixAccumulate(const float * const *inputSamples, unsigned int numInputs, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->mix(inputSamples, numInputs, outputSamples, numSamples, 1);
+	}
+	
+	/** sumSamples[i] += inputSamples[i] using Kahan summation.
+	 compensationSamples[i] carries the rounding error between calls and should be cleared
+	 when a new sum is started. */
+	static inline void accumulateCompensated(const float *inputSamples, float *sumSamples, float *compensationSamples, unsigned int numSamples) throw()
+	{
+		kernels->accumulateCompensated(inputSamples, sumSamples, compensationSamples, numSamples);
+	}
+	
+	/** outputSamples[i] = inputSamples[i] * mulSamples[i] + addSamples[i] */
+	static inline void multiplyAdd(const float *inputSamples, const float *mulSamples, const float *addSamples, float *outputSamples, unsigned int numSamples) throw()
+	{
+		kernels->multiplyAdd(inputSamples, mulSamples, addSamples, outputSamples, numSamples);
+	}
+	
+	/** output[i] += left[i] * right[i] for split complex arrays (e.g., to accumulate spectra for FFT convolution) */
+	static inline void complexMultiplyAccumulate(const float *leftReal, const float *leftImag, 
+												 const float *rightReal, const float *rightImag, 
+												 float *outputReal, float *outputImag, 
+												 unsigned int numSamples) throw()
+	{
+		kernels->complexMultiplyAccumulate(leftReal, leftImag, rightReal, rightImag, outputReal, outputImag, numSamples);
+	}
+	
+	/** Returns the sum of left[i] * right[i] (e.g., for FIR filters and resampling). */
+	static inline float dotProduct(const float *leftSamples, const float *rightSamples, unsigned int numSamples) throw()
+	{
+		return kernels->dotProduct(leftSamples, rightSamples, numSamples);
+	}
+	
+	/** Generate random 32-bit values from four interleaved Ran088 generators.
+	 The state is the s1, s2 and s3 values of each of the four generators (i.e., 12 values:
+	 s1 for each generator then s2 then s3), value i comes from generator i % 4. All four 
+	 generators advance for a partial group of four so the results are the same for any 
+	 instruction set. @see Ran088Block */
+	static inline void ran088(unsigned int *state, unsigned int *outputValues, unsigned int numValues) throw()
+	{
+		kernels->ran088(state, outputValues, numValues);
+	}
+	
+	/** Generate random floats from four interleaved Ran088 generators as ran088().
+	 The top 23 bits of each value become the mantissa of a float with the given 
+	 exponent bits then offset is subtracted (e.g., 0x40000000 and 3 for -1 to +1). */
+	static inline void ran088Float(unsigned int *state, const unsigned int exponentBits, const float offset, float *outputSamples, unsigned int numValues) throw()
+	{
+		kernels->ran088Float(state, exponentBits, offset, outputSamples, numValues);
+	}
+	
+	/** Run numLanes second order sections in parallel over interleaved samples, in place.
+	 Sample i of lane j is samples[i * numLanes + j]. Coefficient k (a0, a1, a2, b1, b2 as SOS) 
+	 of lane j is coeffs[k * numLanes + j], y1 and y2 of lane j are state[j] and state[numLanes + j] 
+	 and are updated. If coeffFrameStride is non-zero coeffs is advanced by this many floats after 
+	 each frame (i.e., per-sample coefficients), otherwise if slopes is non-zero (laid out as coeffs) 
+	 each coefficient has its slope added after each frame and the final coefficients are stored.
+	 numLanes must be a multiple of 8 so each lane is in a vector for every instruction set. 
+	 @see SOSBankBaseUGenInternal */
+	static inline void biquadLanes(float *samples, unsigned int numFrames, unsigned int numLanes, float *coeffs, const float *slopes, unsigned int coeffFrameStride, float *state) throw()
+	{
+		kernels->biquadLanes(samples, numFrames, numLanes, coeffs, slopes, coeffFrameStride, state);
+	}
+	
+	/** outputSamples[k][i] (+)= inputSamples[0][i] * gain[k][0] + inputSamples[1][i] * gain[k][1] + ...
+	 The gains are a numOutputs x numInputs matrix in row order (gain[k][j] is gains[k * numInputs + j]).
+	 If slopes is non-zero (laid out as gains) the gains ramp linearly, for sample i the gain is
+	 gains[n] + slopes[n] * (i + 1) as the panners' ramps. The outputs are cleared first unless 
+	 shouldAccumulate is true. The outputs must not be the same arrays as any of the inputs.
+	 @see HOAEncodeUGenInternal, HOADecodeUGenInternal */
+	static inline void matrixMix(const float * const *inputSamples, unsigned int numInputs, 
+								 float * const *outputSamples, unsigned int numOutputs, 
+								 const float *gains, const float *slopes, 
+								 unsigned int numSamples, const bool shouldAccumulate) throw()
+	{
+		kernels->matrixMix(inputSamples, numInputs, outputSamples, numOutputs, gains, slopes, numSamples, shouldAccumulate ? 1 : 0);
+	}
+	
+	/** The kernels for an instruction set without making it current (e.g., to compare two 
+	 instruction sets). Unsupported instruction sets return the scalar kernels. @internal */
+	static const Kernels* getKernels(const InstructionSet instructionSet) throw();
+	
+private:
+	static const Kernels* kernels;
+	static InstructionSet current;
+};
+
+
+#endif // _UGEN_ugen_simd_Utilities_H_